@@ -27,6 +27,8 @@
 #include "task.h"
 #include "FreeRTOS_IP.h"
 
+#include "crash.h"
+
 /* USER CODE END Includes */
 
 /* Private typedef -----------------------------------------------------------*/
@@ -620,9 +622,7 @@ void Error_Handler(void)
   /* USER CODE BEGIN Error_Handler_Debug */
   /* User can add his own implementation to report the HAL error return state */
   __disable_irq();
-  while (1)
-  {
-  }
+  vCrashStop( eCrashError, NULL, 0U );
   /* USER CODE END Error_Handler_Debug */
 }
 
@@ -102,6 +102,9 @@ void HAL_RNG_MspInit(RNG_HandleTypeDef* hrng)
     /* Peripheral clock enable */
     __HAL_RCC_RNG_CLK_ENABLE();
   /* USER CODE BEGIN RNG_MspInit 1 */
+    /* Used by entropy_pool.c, which calls FreeRTOS from the callbacks. */
+    HAL_NVIC_SetPriority(RNG_IRQn, 6, 0);
+    HAL_NVIC_EnableIRQ(RNG_IRQn);
 
   /* USER CODE END RNG_MspInit 1 */
   }
@@ -124,6 +127,7 @@ void HAL_RNG_MspDeInit(RNG_HandleTypeDef* hrng)
     /* Peripheral clock disable */
     __HAL_RCC_RNG_CLK_DISABLE();
   /* USER CODE BEGIN RNG_MspDeInit 1 */
+    HAL_NVIC_DisableIRQ(RNG_IRQn);
 
   /* USER CODE END RNG_MspDeInit 1 */
   }
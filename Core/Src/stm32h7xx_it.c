@@ -22,6 +22,10 @@
 #include "stm32h7xx_it.h"
 /* Private includes ----------------------------------------------------------*/
 /* USER CODE BEGIN Includes */
+/* The log messages of this file, see log_levels.h. */
+#define logMODULE    eLogModuleApp
+
+#include "tickless.h"
 /* USER CODE END Includes */
 
 /* Private typedef -----------------------------------------------------------*/
@@ -31,6 +35,9 @@
 
 /* Private define ------------------------------------------------------------*/
 /* USER CODE BEGIN PD */
+/* A HAL tick interrupt held off for longer than this, in microseconds, is
+   logged. */
+#define TIM6_LATE_US    500U
 
 /* USER CODE END PD */
 
@@ -58,6 +65,7 @@
 extern TIM_HandleTypeDef htim6;
 
 /* USER CODE BEGIN EV */
+extern RNG_HandleTypeDef hrng;
 
 /* USER CODE END EV */
 
@@ -79,66 +87,6 @@ void NMI_Handler(void)
   /* USER CODE END NonMaskableInt_IRQn 1 */
 }
 
-/**
-  * @brief This function handles Hard fault interrupt.
-  */
-void HardFault_Handler(void)
-{
-  /* USER CODE BEGIN HardFault_IRQn 0 */
-
-  /* USER CODE END HardFault_IRQn 0 */
-  while (1)
-  {
-    /* USER CODE BEGIN W1_HardFault_IRQn 0 */
-    /* USER CODE END W1_HardFault_IRQn 0 */
-  }
-}
-
-/**
-  * @brief This function handles Memory management fault.
-  */
-void MemManage_Handler(void)
-{
-  /* USER CODE BEGIN MemoryManagement_IRQn 0 */
-
-  /* USER CODE END MemoryManagement_IRQn 0 */
-  while (1)
-  {
-    /* USER CODE BEGIN W1_MemoryManagement_IRQn 0 */
-    /* USER CODE END W1_MemoryManagement_IRQn 0 */
-  }
-}
-
-/**
-  * @brief This function handles Pre-fetch fault, memory access fault.
-  */
-void BusFault_Handler(void)
-{
-  /* USER CODE BEGIN BusFault_IRQn 0 */
-
-  /* USER CODE END BusFault_IRQn 0 */
-  while (1)
-  {
-    /* USER CODE BEGIN W1_BusFault_IRQn 0 */
-    /* USER CODE END W1_BusFault_IRQn 0 */
-  }
-}
-
-/**
-  * @brief This function handles Undefined instruction or illegal state.
-  */
-void UsageFault_Handler(void)
-{
-  /* USER CODE BEGIN UsageFault_IRQn 0 */
-
-  /* USER CODE END UsageFault_IRQn 0 */
-  while (1)
-  {
-    /* USER CODE BEGIN W1_UsageFault_IRQn 0 */
-    /* USER CODE END W1_UsageFault_IRQn 0 */
-  }
-}
-
 /**
   * @brief This function handles Debug monitor.
   */
@@ -165,7 +113,19 @@ void DebugMon_Handler(void)
 void TIM6_DAC_IRQHandler(void)
 {
   /* USER CODE BEGIN TIM6_DAC_IRQn 0 */
+  static uint32_t ulSleeps = 0U;
+  uint32_t ulLateUs = TIM6->CNT;
+
+  /* TIM6 counts microseconds from the update that raised this interrupt, so
+     its count is how long the interrupt was held off, modulo one tick.  The
+     first update after a tickless sleep waited for the sleep to end. */
+  if (((TIM6->SR & TIM_SR_UIF) != 0U) && (ulLateUs >= TIM6_LATE_US) &&
+      (ulTicklessSleepCount() == ulSleeps))
+  {
+    LogWarnFromISR(("TIM6: HAL tick %u held off %u us\n", (unsigned) uwTick, (unsigned) ulLateUs));
+  }
 
+  ulSleeps = ulTicklessSleepCount();
   /* USER CODE END TIM6_DAC_IRQn 0 */
   HAL_TIM_IRQHandler(&htim6);
   /* USER CODE BEGIN TIM6_DAC_IRQn 1 */
@@ -175,4 +135,29 @@ void TIM6_DAC_IRQHandler(void)
 
 /* USER CODE BEGIN 1 */
 
+/**
+  * @brief This function handles the RNG interrupt, which fills the entropy pool.
+  */
+void RNG_IRQHandler(void)
+{
+  HAL_RNG_IRQHandler(&hrng);
+}
+
+/**
+  * @brief This function handles the LPTIM1 interrupt, which ends a tickless idle period.
+  */
+void LPTIM1_IRQHandler(void)
+{
+  vTicklessLPTIMInterrupt();
+}
+
+/**
+  * @brief This function handles the Ethernet wake-up interrupt through EXTI line 86.
+  */
+void ETH_WKUP_IRQHandler(void)
+{
+  vTicklessEthernetWakeup();
+  LogInfoFromISR(("ETH: wake-up event\n"));
+}
+
 /* USER CODE END 1 */
@@ -45,6 +45,8 @@
 
 /* USER CODE BEGIN Includes */
 /* Section where include file can be added */
+#include "trace_events.h"
+#include "log_levels.h"
 /* USER CODE END Includes */
 
 /* Ensure definitions are only used by the compiler, and not by the assembler. */
@@ -149,7 +151,9 @@ See http://www.FreeRTOS.org/RTOS-Cortex-M3-M4.html. */
 /* Normal assert() semantics without relying on the provision of an assert.h
 header file. */
 /* USER CODE BEGIN 1 */
-#define configASSERT( x ) if ((x) == 0)             { taskDISABLE_INTERRUPTS(); for( ;; ); }
+/* A failed assert leaves a crash dump and resets, see crash.h. */
+extern void vCrashAssert( const char * pcFile, uint32_t ulLine ) __attribute__( ( noreturn ) );
+#define configASSERT( x ) if ((x) == 0)             { taskDISABLE_INTERRUPTS(); vCrashAssert( __FILE__, __LINE__ ); }
 /* USER CODE END 1 */
 
 /* Definitions that map the FreeRTOS port interrupt handlers to their CMSIS
@@ -161,6 +165,32 @@ standard names. */
 
 /* USER CODE BEGIN Defines */
 /* Section where parameter definitions can be added (for instance, to override default ones in FreeRTOS.h) */
+
+/* Tickless idle with the port of tickless.c, which wakes from LPTIM1. */
+#define configUSE_TICKLESS_IDLE                   2
+#define configEXPECTED_IDLE_TIME_BEFORE_SLEEP     2
+
+/* Crash capture, see crash.h.  It keeps its own list of the tasks through
+the create and delete hooks. */
+#define configCHECK_FOR_STACK_OVERFLOW            2
+extern void vCrashTaskCreated( void * pvTask );
+extern void vCrashTaskDeleted( void * pvTask );
+
+/* Event tracing, see trace.h.  With configUSE_EVENT_TRACE 0 only the crash
+capture hooks remain. */
+#if ( configUSE_EVENT_TRACE == 1 )
+#define traceTASK_CREATE( pxNewTCB )              do { vCrashTaskCreated( pxNewTCB ); vTraceRecord( traceEVENT_TASK_CREATE, ( uint32_t ) ( pxNewTCB ), ( pxNewTCB )->uxPriority ); } while( 0 )
+#define traceTASK_DELETE( pxTCB )                 do { vCrashTaskDeleted( pxTCB ); vTraceRecord( traceEVENT_TASK_DELETE, ( uint32_t ) ( pxTCB ), 0U ); } while( 0 )
+#define traceTASK_SWITCHED_IN()                   vTraceRecord( traceEVENT_TASK_SWITCHED_IN, ( uint32_t ) pxCurrentTCB, 0U )
+#define traceBLOCKING_ON_QUEUE_RECEIVE( pxQueue ) vTraceRecord( traceEVENT_QUEUE_RECEIVE_BLOCK, ( uint32_t ) ( pxQueue ), 0U )
+#define traceBLOCKING_ON_QUEUE_SEND( pxQueue )    vTraceRecord( traceEVENT_QUEUE_SEND_BLOCK, ( uint32_t ) ( pxQueue ), 0U )
+#define traceEVENT_GROUP_WAIT_BITS_BLOCK( xEventGroup, uxBitsToWaitFor )                     vTraceRecord( traceEVENT_EVENT_GROUP_WAIT, ( uint32_t ) ( xEventGroup ), ( uint32_t ) ( uxBitsToWaitFor ) )
+#define traceEVENT_GROUP_WAIT_BITS_END( xEventGroup, uxBitsToWaitFor, xTimeoutOccurred )     vTraceRecord( traceEVENT_EVENT_GROUP_WAIT_END, ( uint32_t ) ( xEventGroup ), ( uint32_t ) ( xTimeoutOccurred ) )
+#define traceTASK_DELAY()                         vTraceRecord( traceEVENT_TASK_DELAY, ( uint32_t ) xTicksToDelay, 0U )
+#else
+#define traceTASK_CREATE( pxNewTCB )              vCrashTaskCreated( pxNewTCB )
+#define traceTASK_DELETE( pxTCB )                 vCrashTaskDeleted( pxTCB )
+#endif
 /* USER CODE END Defines */
 
 
@@ -215,13 +245,28 @@ http://www.freertos.org/FreeRTOS-Plus/FreeRTOS_Plus_TCP/examples_FreeRTOS_simula
 #define configECHO_SERVER_ADDR2                 2
 #define configECHO_SERVER_ADDR3                 3
 
+/* The collector of the event trace, see trace.h. */
+#define configTRACE_COLLECTOR_ADDR0             192
+#define configTRACE_COLLECTOR_ADDR1             168
+#define configTRACE_COLLECTOR_ADDR2             2
+#define configTRACE_COLLECTOR_ADDR3             3
+#define configTRACE_COLLECTOR_PORT              5555
+
+/* The syslog collector of the log, see log_udp.h. */
+#define configLOG_COLLECTOR_ADDR0               192
+#define configLOG_COLLECTOR_ADDR1               168
+#define configLOG_COLLECTOR_ADDR2               2
+#define configLOG_COLLECTOR_ADDR3               3
+#define configLOG_COLLECTOR_PORT                514
+
 /* Logging related configuration. */
 extern void vLoggingPrintf( const char * pcFormat, ... );
 extern void vPrintStringToUart( const char *str );
 
-#define configPRINTF( x )                       vLoggingPrintf x
+#define configPRINTF( x )                       LogInfo( x )
 #define configPRINT_STRING( x )                 vPrintStringToUart( x )
 #define configLOGGING_MAX_MESSAGE_LENGTH        512
+#define configLOGGING_MESSAGE_BUFFERS           48
 
 /* Pcap capture configuration. */
 #define configPCAP_CAPTURE_BUFFER_LENGTH        ( 10 * 1024 )
@@ -148,6 +148,20 @@ re-transmission time interval reaches ipconfigMAXIMUM_DISCOVER_TX_PERIOD without
 a DHCP reply being received. */
 #define ipconfigMAXIMUM_DISCOVER_TX_PERIOD          ( pdMS_TO_TICKS( 30000 ) )
 
+/* An IPv6 end-point with bWantRA set sends a Router Solicitation when the
+link comes up, and repeats it ipconfigRA_SEARCH_COUNT times, every
+ipconfigRA_SEARCH_TIME_OUT_MSEC, before it gives up and uses its default
+configuration.  The default configuration is the prefix and gateway learned
+before the last reset (see dhcp_lease.h), so there is no reason to wait the
+default 3 x 10 seconds for a router.  The address is then tested for
+duplicates with ipconfigRA_IP_TEST_COUNT Neighbour Solicitations.  One probe
+with a 1 second timeout is the RFC 4862 default (DupAddrDetectTransmits and
+RetransTimer). */
+#define ipconfigRA_SEARCH_COUNT                     ( 3 )
+#define ipconfigRA_SEARCH_TIME_OUT_MSEC             ( 1000 )
+#define ipconfigRA_IP_TEST_COUNT                    ( 1 )
+#define ipconfigRA_IP_TEST_TIME_OUT_MSEC            ( 1000 )
+
 /* The ARP cache is a table that maps IP addresses to MAC addresses.  The IP
 stack can only send a UDP message to a remove IP address if it knowns the MAC
 address associated with the IP address, or the MAC address of the router used to
@@ -191,14 +205,32 @@ to a pre-determinable value. */
 #define ETH_TX_BUF_SIZE                             1536U
 #define ETH_RX_BUF_SIZE                             1536U
 
-#define iptraceFAILED_TO_OBTAIN_NETWORK_BUFFER()    configASSERT( 1 == 0 )
+/* Running out of network buffers is not fatal: the stack drops the packet, or
+the socket call returns an error, and TCP will retransmit.  Count it so that the
+network statistics can recommend a larger pool.  See net_stats.h. */
+extern void vNetStatsBufferFailure( void );
+
+/* The event trace of trace.h, on the timeline next to the context switches. */
+#if ( configUSE_EVENT_TRACE == 1 )
+#define iptraceFAILED_TO_OBTAIN_NETWORK_BUFFER()    do { vNetStatsBufferFailure(); vTraceRecord( traceEVENT_NET_BUFFER_FAILURE, 0U, 0U ); } while( 0 )
+#define iptraceNETWORK_INTERFACE_RECEIVE()          vTraceRecord( traceEVENT_NET_RX, 0U, 0U )
+#define iptraceNETWORK_INTERFACE_OUTPUT( xDataLength, pucEthernetBuffer )    vTraceRecord( traceEVENT_NET_TX, ( uint32_t ) ( xDataLength ), 0U )
+#define iptraceETHERNET_RX_EVENT_LOST()             vTraceRecord( traceEVENT_NET_RX_EVENT_LOST, 0U, 0U )
+#define iptraceSTACK_TX_EVENT_LOST( xEvent )        vTraceRecord( traceEVENT_NET_TX_EVENT_LOST, ( uint32_t ) ( xEvent ), 0U )
+#else
+#define iptraceFAILED_TO_OBTAIN_NETWORK_BUFFER()    vNetStatsBufferFailure()
+#endif
 
-#define ipconfigNUM_NETWORK_BUFFER_DESCRIPTORS      ( 64 )
+/* The payloads come from the size classes in net_buffers.c, which hold 104
+blocks in less RAM than 64 full-size buffers took from the heap.  Small packets
+no longer pin a full-size buffer, so more descriptors can be in flight. */
+#define ipconfigNUM_NETWORK_BUFFER_DESCRIPTORS      ( 96 )
 
 /* A FreeRTOS queue is used to send events from application tasks to the IP
 stack.  ipconfigEVENT_QUEUE_LENGTH sets the maximum number of events that can
 be queued for processing at any one time.  The event queue must be a minimum of
-5 greater than the total number of network buffers. */
+5 greater than the total number of network buffers.  The depth actually reached
+is logged by the net_stats module of the application. */
 #define ipconfigEVENT_QUEUE_LENGTH                  ( ipconfigNUM_NETWORK_BUFFER_DESCRIPTORS + 5 )
 
 /* The address of a socket is the combination of its IP address and its port
@@ -222,7 +254,11 @@ aborted. */
 /* USE_TCP: Use TCP and all its features */
 #define ipconfigUSE_TCP                                 ( 1 )
 
-/* USE_WIN: Let TCP use windowing mechanism. */
+/* USE_WIN: Let TCP use windowing mechanism.  This also negotiates the SACK
+option, retransmits only the segments that the peer reports as missing, and
+does a fast retransmit after 3 duplicate ACKs.  Fast retransmit can only kick
+in when at least 4 segments are outstanding: a socket with a smaller TX window
+will always recover from a loss through a retransmission time-out. */
 #define ipconfigUSE_TCP_WIN                             ( 1 )
 
 /* The MTU is the maximum number of bytes the payload of a network frame can
@@ -242,8 +278,9 @@ generate replies to incoming ICMP echo (ping) requests. */
 #define ipconfigREPLY_TO_INCOMING_PINGS                 1
 
 /* If ipconfigSUPPORT_OUTGOING_PINGS is set to 1 then the
-FreeRTOS_SendPingRequest() API function is available. */
-#define ipconfigSUPPORT_OUTGOING_PINGS                  0
+FreeRTOS_SendPingRequest() API function is available.  ping.c uses it to
+measure the reachability and round trip time of the gateway and servers. */
+#define ipconfigSUPPORT_OUTGOING_PINGS                  1
 
 /* If ipconfigSUPPORT_SELECT_FUNCTION is set to 1 then the FreeRTOS_select()
 (and associated) API function is available. */
@@ -300,7 +337,9 @@ disconnecting stage will timeout after a period of non-activity. */
 #define ipconfigTCP_KEEP_ALIVE                          ( 1 )
 #define ipconfigTCP_KEEP_ALIVE_INTERVAL                 ( 20 ) /* in seconds */
 
-#define ipconfigUSE_DHCP_HOOK                           ( 0 )
+/* The DHCP hook in app_main.c asks the DHCP server for the address of the
+lease that was stored in flash before the last reset, see dhcp_lease.h. */
+#define ipconfigUSE_DHCP_HOOK                           ( 1 )
 
 /* UDP Logging related constants follow.  The standard UDP logging facility
 writes formatted strings to a buffer, and creates a task that removes messages
@@ -313,13 +352,19 @@ extern void vLoggingPrintf( const char * pcFormat, ... );
 
 /* Set to 1 to print out debug messages.  If ipconfigHAS_DEBUG_PRINTF is set to
 1 then FreeRTOS_debug_printf should be defined to the function used to print
-out the debugging messages. */
+out the debugging messages.  They are compiled in along with the debug level of
+log_levels.h, and shown once the threshold of their module is raised to
+logLEVEL_DEBUG. */
 #ifndef ipconfigHAS_DEBUG_PRINTF
-    #define ipconfigHAS_DEBUG_PRINTF                    0
+    #if ( configLOG_LEVEL_COMPILED >= logLEVEL_DEBUG )
+        #define ipconfigHAS_DEBUG_PRINTF                1
+    #else
+        #define ipconfigHAS_DEBUG_PRINTF                0
+    #endif
 #endif
 
 #if( ipconfigHAS_DEBUG_PRINTF == 1 )
-    #define FreeRTOS_debug_printf(X)                    vLoggingPrintf X
+    #define FreeRTOS_debug_printf(X)                    LogDebug( X )
 #endif
 
 /* Set to 1 to print out non debugging messages, for example the output of the
@@ -331,7 +376,7 @@ messages. */
 #endif
 
 #if( ipconfigHAS_PRINTF == 1 )
-    #define FreeRTOS_printf(X)                          vLoggingPrintf X
+    #define FreeRTOS_printf(X)                          LogInfo( X )
 #endif
 
 #define ipconfigFTP_ZERO_COPY_ALIGNED_WRITES            0
@@ -374,6 +419,10 @@ messages. */
 
 #define ipconfigSOCKET_HAS_USER_SEMAPHORE               1
 
+/* A socket may have a callback that the IP-task calls on every event, see
+tcp_rx_batch.h. */
+#define ipconfigSOCKET_HAS_USER_WAKE_CALLBACK           1
+
 #define ipconfigTCP_MEM_STATS_MAX_ALLOCATION            64
 
 #ifdef __cplusplus
@@ -34,6 +34,9 @@
   * https://www.FreeRTOS.org/FreeRTOS-Plus/FreeRTOS_Plus_TCP/examples_FreeRTOS_simulator.html
   */
 
+/* The log messages of this file, see log_levels.h. */
+#define logMODULE    eLogModuleEcho
+
   /* Standard includes. */
 #include <stdint.h>
 #include <stdio.h>
@@ -49,6 +52,9 @@
 #include "FreeRTOS_Sockets.h"
 #include "FreeRTOS_IP_Private.h"
 
+#include "net_services.h"
+#include "net_stats.h"
+
 
 #define USE_ZERO_COPY               ( 0 )
 
@@ -72,6 +78,11 @@ static const TickType_t xReceiveTimeOut = pdMS_TO_TICKS(4000);
 static const TickType_t xSendTimeOut = pdMS_TO_TICKS(4000);
 static BaseType_t xHasStarted = pdFALSE;
 
+/* Set while the network that the echo server is on is down.  The tasks then
+close their socket and wait for a notification from a resume. */
+static volatile BaseType_t xPaused = pdFALSE;
+static TaskHandle_t xEchoTasks[echoNUM_ECHO_CLIENTS];
+
 /*
 * UDP echo client task
 */
@@ -96,7 +107,7 @@ void vStartUDPEchoClientTasks_SingleTasks(uint16_t usTaskStackSize, UBaseType_t
                 usTaskStackSize,	/* The stack size is defined in FreeRTOSIPConfig.h. */
                 (void*)x,		/* The task parameter, not used in this case. */
                 uxTaskPriority,		/* The priority assigned to the task is defined in FreeRTOSConfig.h. */
-                NULL);				/* The task handle is not used. */
+                &(xEchoTasks[x]));	/* Needed to resume the task. */
             if (rc == pdPASS)
             {
                 xCount++;
@@ -106,11 +117,28 @@ void vStartUDPEchoClientTasks_SingleTasks(uint16_t usTaskStackSize, UBaseType_t
     }
     else
     {
-        FreeRTOS_printf(("vStartUDPEchoClientTasks_SingleTasks: already started\n"));
+        BaseType_t x;
+
+        /* Started before, so this is a resume. */
+        xPaused = pdFALSE;
+
+        for (x = 0; x < echoNUM_ECHO_CLIENTS; x++)
+        {
+            if (xEchoTasks[x] != NULL)
+            {
+                xTaskNotifyGive(xEchoTasks[x]);
+            }
+        }
     }
 }
 /*-----------------------------------------------------------*/
 
+void vPauseUDPEchoClientTasks_SingleTasks(void)
+{
+    xPaused = pdTRUE;
+}
+/*-----------------------------------------------------------*/
+
 static void prvUDPEchoClientTask(void* pvParameters)
 {
     Socket_t xSocket;
@@ -162,6 +190,12 @@ static void prvUDPEchoClientTask(void* pvParameters)
 
     for (;; )
     {
+        /* Do not send while paused, requests would only be lost. */
+        while (xPaused != pdFALSE)
+        {
+            (void)ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        }
+
         /* Create a socket. */
         xSocket = FreeRTOS_socket(xFamily, FREERTOS_SOCK_DGRAM, FREERTOS_IPPROTO_UDP);
         configASSERT(xSocket != FREERTOS_INVALID_SOCKET);
@@ -171,10 +205,18 @@ static void prvUDPEchoClientTask(void* pvParameters)
         FreeRTOS_setsockopt(xSocket, 0, FREERTOS_SO_RCVTIMEO, &xReceiveTimeOut, sizeof(xReceiveTimeOut));
 
         /* Send a number of echo requests. */
-        for (lLoopCount = 0; lLoopCount < lMaxLoopCount; lLoopCount++)
+        for (lLoopCount = 0; (lLoopCount < lMaxLoopCount) && (xPaused == pdFALSE); lLoopCount++)
         {
             /* Create the string that is sent to the echo server. */
-            sprintf((char*)cTxString, "Message number %u\r\n", ulTxCount);
+            snprintf((char*)cTxString, sizeof(cTxString), "Message number %u\r\n", ulTxCount);
+
+            /* Back off while the stack is short of network buffers, so that
+            the echo requests do not take the buffers needed for reception.
+            Skip this request when no buffer was released in time. */
+            if (xNetStatsWaitBuffersAvailable(1, xSendTimeOut) == pdFALSE)
+            {
+                continue;
+            }
 
 #if USE_ZERO_COPY
 
@@ -274,6 +316,7 @@ static void prvUDPEchoClientTask(void* pvParameters)
                 {
                     /* The echo reply was received without error. */
                     ulRxCount++;
+                    vNetServicesFirstPacket("UDP echo");
                     FreeRTOS_debug_printf(("[Echo Client] Data was received correctly.\r\n"));
                 }
                 else
@@ -33,4 +33,10 @@
   */
 void vStartUDPEchoClientTasks_SingleTasks(uint16_t usTaskStackSize, UBaseType_t uxTaskPriority);
 
+/*
+ * Stop sending echo requests until vStartUDPEchoClientTasks_SingleTasks() is
+ * called again.
+ */
+void vPauseUDPEchoClientTasks_SingleTasks(void);
+
 #endif /* SINGLE_TASK_UDP_ECHO_CLIENTS_H */
@@ -1,3 +1,6 @@
+/* The log messages of this file, see log_levels.h. */
+#define logMODULE    eLogModuleApp
+
 /* Standard includes. */
 #include <stdio.h>
 #include <stdlib.h>
@@ -16,6 +19,50 @@
 
 /* Logging includes. */
 #include "logging.h"
+#include "log_udp.h"
+
+/* Network statistics includes. */
+#include "net_stats.h"
+
+/* Route cache includes. */
+#include "route_cache.h"
+
+/* Network services. */
+#include "net_services.h"
+
+/* DHCP lease cache. */
+#include "dhcp_lease.h"
+
+/* TCP initial sequence numbers. */
+#include "tcp_isn.h"
+
+/* Random numbers. */
+#include "entropy_pool.h"
+
+/* Throughput tests. */
+#include "iperf3.h"
+
+/* Reachability and round trip times. */
+#include "ping.h"
+
+/* Time of day. */
+#include "wall_clock.h"
+#include "sntp.h"
+
+/* Low-power idle. */
+#include "tickless.h"
+
+/* Post-mortem dumps. */
+#include "crash.h"
+
+/* Event tracing. */
+#include "trace.h"
+
+/* TCP buffer autotuning. */
+#include "tcp_autotune.h"
+
+/* TCP congestion control, for its loss counters. */
+#include "tcp_congestion.h"
 
 /* Demo definitions. */
 #define mainCLI_TASK_STACK_SIZE             512
@@ -32,15 +79,6 @@
  */
 #define USE_IPv6_END_POINTS                 1
 
-#if ( ipconfigUSE_IPv6 != 0 && USE_IPv6_END_POINTS != 0 && ipconfigUSE_IPv4 != 0 )
-    #define TOTAL_ENDPOINTS                 3
-#elif ( ipconfigUSE_IPv4 == 0 && ipconfigUSE_IPv6 != 0 )
-    #define TOTAL_ENDPOINTS                 2
-#else
-    #define TOTAL_ENDPOINTS                 1
-#endif /* ( ipconfigUSE_IPv6 != 0 && USE_IPv6_END_POINTS != 0 ) */
-
-
 
 /* Set the following constants to 1 or 0 to define which tasks to include and
  * exclude:
@@ -59,28 +97,314 @@
 #define mainCREATE_TCP_ECHO_TASKS_SINGLE              1 /* 1 */
 #define mainCREATE_UDP_ECHO_TASKS_SINGLE              1
 
+/* Set mainSTREAM_TRACE to 1 to send the event trace continuously to
+ * configTRACE_COLLECTOR_ADDR0-3, port configTRACE_COLLECTOR_PORT, where
+ * tools/trace_to_perfetto.py receives it.
+ */
+#define mainSTREAM_TRACE                              0
+
+/* Set mainLOG_TO_NETWORK to 1 to send the log to the syslog collector at
+ * configLOG_COLLECTOR_ADDR0-3, port configLOG_COLLECTOR_PORT, while the network
+ * is up.  The log goes to the UART while the network is down.
+ */
+#define mainLOG_TO_NETWORK                            0
+
 /*-----------------------------------------------------------*/
 /*-----------------------------------------------------------*/
 /*-----------------------------------------------------------*/
 
 #define SYS_LOG_PRINT_BUFFER_SIZE           256
 
-/* Logging module configuration. */
-#define mainLOGGING_TASK_STACK_SIZE         256
+/* Logging module configuration.  The stack leaves room for the network sink. */
+#define mainLOGGING_TASK_STACK_SIZE         512
 #define mainLOGGING_TASK_PRIORITY           (tskIDLE_PRIORITY + 1)
 #define mainLOGGING_QUEUE_LENGTH            100
 
 #define mainMAX_UDP_RESPONSE_SIZE           1024
 
+/* Network statistics module configuration.  The task also logs the periodic
+reports of the other modules, see vApplicationNetStatsReportHook(). */
+#define mainNET_STATS_TASK_STACK_SIZE       512
+#define mainNET_STATS_TASK_PRIORITY         (tskIDLE_PRIORITY + 1)
+
+/* Ping module configuration.  The task logs, resolves routes and sends
+through the stack, so it needs as much stack as the other network tasks. */
+#define mainPING_TASK_STACK_SIZE            512
+#define mainPING_TASK_PRIORITY              (tskIDLE_PRIORITY + 1)
+#define mainPING_PERIOD_MS                  5000U
+
+/* SNTP client configuration. */
+#define mainSNTP_TASK_STACK_SIZE            512
+#define mainSNTP_TASK_PRIORITY              (tskIDLE_PRIORITY + 1)
+
+/* Trace streaming configuration. */
+#define mainTRACE_TASK_STACK_SIZE           512
+#define mainTRACE_TASK_PRIORITY             (tskIDLE_PRIORITY + 1)
+
 /*-----------------------------------------------------------*/
 
 uint32_t ulTim7Tick = 0;
 
 BaseType_t xEndPointCount = 0;
-BaseType_t xUpEndPointCount = 0;
 
-static BaseType_t xTasksAlreadyCreated = pdFALSE;
+/* Calls of pvPortMalloc() that returned NULL, see
+vApplicationMallocFailedHook(). */
+static volatile uint32_t ulMallocFailures = 0U;
+
+/*-----------------------------------------------------------*/
+
+/* The tasks that use the IP stack are started by net_services.c as soon as
+ * the end-points that they need are up, see prvRegisterServices(). */
+#if ( ipconfigUSE_IPv4 != 0 ) && ( mainCREATE_TCP_ECHO_TASKS_SINGLE == 1 )
+
+    static void prvStartTCPEcho( NetService_t * pxService )
+    {
+        void vStartTCPEchoClientTasks_SingleTasks( uint16_t usTaskStackSize, UBaseType_t uxTaskPriority );
+
+        ( void ) pxService;
+
+        /* The echo tasks survive a network down/up, they are created by the
+         * first call and resumed by the later ones. */
+        vStartTCPEchoClientTasks_SingleTasks( mainCLI_TASK_STACK_SIZE, mainCLI_TASK_PRIORITY );
+    }
+
+    static void prvPauseTCPEcho( NetService_t * pxService )
+    {
+        void vPauseTCPEchoClientTasks_SingleTasks( void );
+
+        ( void ) pxService;
+
+        vPauseTCPEchoClientTasks_SingleTasks();
+    }
+
+    static NetService_t xTCPEchoService =
+    {
+        .pcName  = "TCP echo",
+        .uxNeeds = netsvcNEEDS_IPv4,
+        .fnStart = prvStartTCPEcho,
+        .fnPause = prvPauseTCPEcho
+    };
+
+#endif /* ( ipconfigUSE_IPv4 != 0 ) && ( mainCREATE_TCP_ECHO_TASKS_SINGLE == 1 ) */
+
+#if ( mainCREATE_UDP_ECHO_TASKS_SINGLE == 1 )
+
+    static void prvStartUDPEcho( NetService_t * pxService )
+    {
+        void vStartUDPEchoClientTasks_SingleTasks( uint16_t usTaskStackSize, UBaseType_t uxTaskPriority );
+
+        ( void ) pxService;
+
+        /* Created by the first call, resumed by the later ones. */
+        vStartUDPEchoClientTasks_SingleTasks( mainCLI_TASK_STACK_SIZE, mainCLI_TASK_PRIORITY );
+    }
+
+    static void prvPauseUDPEcho( NetService_t * pxService )
+    {
+        void vPauseUDPEchoClientTasks_SingleTasks( void );
+
+        ( void ) pxService;
+
+        vPauseUDPEchoClientTasks_SingleTasks();
+    }
+
+    static NetService_t xUDPEchoService =
+    {
+        .pcName  = "UDP echo",
+        /* Use netsvcNEEDS_IPv6_GLOBAL when configECHO_SERVER_ADDR_STRING is an
+         * IPv6 address. */
+        .uxNeeds = netsvcNEEDS_IPv4,
+        .fnStart = prvStartUDPEcho,
+        .fnPause = prvPauseUDPEcho
+    };
+
+#endif /* ( mainCREATE_UDP_ECHO_TASKS_SINGLE == 1 ) */
+
+#if ( ipconfigUSE_IPv4 != 0 ) && ( USE_IPERF == 1 )
+
+    static void prvStartIperf3( NetService_t * pxService )
+    {
+        ( void ) pxService;
+
+        /* The server task keeps listening across a network down/up. */
+        ( void ) xIperf3StartServer();
+    }
+
+    static NetService_t xIperf3Service =
+    {
+        .pcName  = "iperf3",
+        .uxNeeds = netsvcNEEDS_IPv4,
+        .fnStart = prvStartIperf3
+    };
+
+#endif /* ( ipconfigUSE_IPv4 != 0 ) && ( USE_IPERF == 1 ) */
+
+#if ( ipconfigUSE_IPv4 != 0 )
+
+    static void prvStartPing( NetService_t * pxService )
+    {
+        static BaseType_t xStarted = pdFALSE;
+        static char cGateway[ 16 ];
+        char cEchoServer[ 16 ];
+        NetworkEndPoint_t * pxEndPoint;
+        uint32_t ulIPAddress, ulNetMask, ulGatewayAddress, ulDNSServerAddress;
+
+        ( void ) pxService;
+
+        /* The targets keep being pinged while the network is down, that is
+         * what the health signal is for. */
+        if( xStarted == pdFALSE )
+        {
+            xStarted = pdTRUE;
+
+            for( pxEndPoint = FreeRTOS_FirstEndPoint( NULL ); pxEndPoint != NULL; pxEndPoint = FreeRTOS_NextEndPoint( NULL, pxEndPoint ) )
+            {
+                if( ( pxEndPoint->bits.bIPv6 == pdFALSE_UNSIGNED ) && ( pxEndPoint->bits.bEndPointUp != pdFALSE_UNSIGNED ) )
+                {
+                    FreeRTOS_GetEndPointConfiguration( &ulIPAddress, &ulNetMask, &ulGatewayAddress, &ulDNSServerAddress, pxEndPoint );
+
+                    if( ulGatewayAddress != 0U )
+                    {
+                        FreeRTOS_inet_ntoa( ulGatewayAddress, cGateway );
+                        ( void ) xPingAddTarget( "gateway", cGateway, mainPING_PERIOD_MS );
+                        break;
+                    }
+                }
+            }
+
+            FreeRTOS_inet_ntoa( FreeRTOS_inet_addr_quick( configECHO_SERVER_ADDR0, configECHO_SERVER_ADDR1, configECHO_SERVER_ADDR2, configECHO_SERVER_ADDR3 ), cEchoServer );
+            ( void ) xPingAddTarget( "echo", cEchoServer, mainPING_PERIOD_MS );
+        }
+    }
+
+    static NetService_t xPingService =
+    {
+        .pcName  = "ping",
+        .uxNeeds = netsvcNEEDS_IPv4,
+        .fnStart = prvStartPing
+    };
+
+#endif /* ( ipconfigUSE_IPv4 != 0 ) */
+
+#if ( ipconfigUSE_IPv4 != 0 )
+
+    static void prvStartSNTP( NetService_t * pxService )
+    {
+        ( void ) pxService;
+
+        /* The task keeps polling across a network down/up. */
+        ( void ) xSNTPStart( mainSNTP_TASK_STACK_SIZE, mainSNTP_TASK_PRIORITY );
+    }
+
+    static NetService_t xSNTPService =
+    {
+        .pcName  = "SNTP",
+        .uxNeeds = netsvcNEEDS_IPv4,
+        .fnStart = prvStartSNTP
+    };
+
+#endif /* ( ipconfigUSE_IPv4 != 0 ) */
+
+#if ( ipconfigUSE_IPv4 != 0 ) && ( mainSTREAM_TRACE == 1 ) && ( configUSE_EVENT_TRACE == 1 )
+
+    static void prvStartTrace( NetService_t * pxService )
+    {
+        struct freertos_sockaddr xCollector;
+
+        ( void ) pxService;
+
+        memset( &xCollector, 0, sizeof( xCollector ) );
+        xCollector.sin_family = FREERTOS_AF_INET;
+        xCollector.sin_port = FreeRTOS_htons( configTRACE_COLLECTOR_PORT );
+        xCollector.sin_address.ulIP_IPv4 = FreeRTOS_inet_addr_quick( configTRACE_COLLECTOR_ADDR0, configTRACE_COLLECTOR_ADDR1,
+                                                                     configTRACE_COLLECTOR_ADDR2, configTRACE_COLLECTOR_ADDR3 );
+
+        /* Does nothing when the stream still runs from before a pause. */
+        ( void ) xTraceStreamStart( &xCollector, pdTRUE, mainTRACE_TASK_STACK_SIZE, mainTRACE_TASK_PRIORITY );
+    }
+
+    static NetService_t xTraceService =
+    {
+        .pcName  = "trace",
+        .uxNeeds = netsvcNEEDS_IPv4,
+        .fnStart = prvStartTrace
+    };
+
+#endif /* ( ipconfigUSE_IPv4 != 0 ) && ( mainSTREAM_TRACE == 1 ) */
+
+#if ( ipconfigUSE_IPv4 != 0 ) && ( mainLOG_TO_NETWORK == 1 )
+
+    static void prvStartLog( NetService_t * pxService )
+    {
+        struct freertos_sockaddr xCollector;
+
+        ( void ) pxService;
+
+        memset( &xCollector, 0, sizeof( xCollector ) );
+        xCollector.sin_family = FREERTOS_AF_INET;
+        xCollector.sin_port = FreeRTOS_htons( configLOG_COLLECTOR_PORT );
+        xCollector.sin_address.ulIP_IPv4 = FreeRTOS_inet_addr_quick( configLOG_COLLECTOR_ADDR0, configLOG_COLLECTOR_ADDR1,
+                                                                     configLOG_COLLECTOR_ADDR2, configLOG_COLLECTOR_ADDR3 );
+
+        vLogUDPStart( &xCollector );
+    }
+
+    static void prvPauseLog( NetService_t * pxService )
+    {
+        ( void ) pxService;
+
+        vLogUDPStop();
+    }
+
+    static NetService_t xLogService =
+    {
+        .pcName  = "log",
+        .uxNeeds = netsvcNEEDS_IPv4,
+        .fnStart = prvStartLog,
+        .fnPause = prvPauseLog
+    };
+
+#endif /* ( ipconfigUSE_IPv4 != 0 ) && ( mainLOG_TO_NETWORK == 1 ) */
+
+static void prvRegisterServices( void )
+{
+    BaseType_t xRet;
+
+    #if ( ipconfigUSE_IPv4 != 0 ) && ( mainCREATE_TCP_ECHO_TASKS_SINGLE == 1 )
+        xRet = xNetServicesRegister( &xTCPEchoService );
+        configASSERT( xRet == pdPASS );
+    #endif
+
+    #if ( mainCREATE_UDP_ECHO_TASKS_SINGLE == 1 )
+        xRet = xNetServicesRegister( &xUDPEchoService );
+        configASSERT( xRet == pdPASS );
+    #endif
 
+    #if ( ipconfigUSE_IPv4 != 0 )
+        xRet = xNetServicesRegister( &xPingService );
+        configASSERT( xRet == pdPASS );
+
+        xRet = xNetServicesRegister( &xSNTPService );
+        configASSERT( xRet == pdPASS );
+    #endif
+
+    #if ( ipconfigUSE_IPv4 != 0 ) && ( USE_IPERF == 1 )
+        xRet = xNetServicesRegister( &xIperf3Service );
+        configASSERT( xRet == pdPASS );
+    #endif
+
+    #if ( ipconfigUSE_IPv4 != 0 ) && ( mainSTREAM_TRACE == 1 ) && ( configUSE_EVENT_TRACE == 1 )
+        xRet = xNetServicesRegister( &xTraceService );
+        configASSERT( xRet == pdPASS );
+    #endif
+
+    #if ( ipconfigUSE_IPv4 != 0 ) && ( mainLOG_TO_NETWORK == 1 )
+        xRet = xNetServicesRegister( &xLogService );
+        configASSERT( xRet == pdPASS );
+    #endif
+
+    ( void ) xRet;
+}
 /*-----------------------------------------------------------*/
 
 void app_main( void )
@@ -92,11 +416,43 @@ void app_main( void )
     const uint8_t ucDNSServerAddress[ 4 ] = { configDNS_SERVER_ADDR0, configDNS_SERVER_ADDR1, configDNS_SERVER_ADDR2, configDNS_SERVER_ADDR3 };
     const uint8_t ucMACAddress[ 6 ] = { configMAC_ADDR0, configMAC_ADDR1, configMAC_ADDR2, configMAC_ADDR3, configMAC_ADDR4, configMAC_ADDR5 };
 
+    #if ( configUSE_EVENT_TRACE == 1 )
+        vTraceInitialise();
+    #endif
+
+    vCrashInitialise();
+
     xRet = xLoggingTaskInitialize( mainLOGGING_TASK_STACK_SIZE,
                                    mainLOGGING_TASK_PRIORITY,
                                    mainLOGGING_QUEUE_LENGTH );
     configASSERT( xRet == pdPASS );
 
+    /* The logging task prints it once the scheduler runs. */
+    ( void ) xCrashReport();
+
+    xRet = xNetStatsInitialize( mainNET_STATS_TASK_STACK_SIZE,
+                                mainNET_STATS_TASK_PRIORITY );
+    configASSERT( xRet == pdPASS );
+
+    /* Before the end-points, which start from the stored leases. */
+    xRet = xDHCPLeaseInitialise();
+    configASSERT( xRet == pdPASS );
+
+    xRet = xEntropyPoolInitialise();
+    configASSERT( xRet == pdPASS );
+
+    xRet = xTCPISNInitialise();
+    configASSERT( xRet == pdPASS );
+
+    xRet = xTicklessInitialise();
+    configASSERT( xRet == pdPASS );
+
+    xRet = xPingInitialise( mainPING_TASK_STACK_SIZE,
+                            mainPING_TASK_PRIORITY );
+    configASSERT( xRet == pdPASS );
+
+    prvRegisterServices();
+
     configPRINTF( ( "Calling FreeRTOS_IPInit...\n" ) );
 
 
@@ -111,6 +467,9 @@ void app_main( void )
                                                          NetworkInterface_t * pxInterface );
         pxSTM32H_FillInterfaceDescriptor(0, &(xInterfaces[0]));
 
+        /* Let congestion control see the retransmissions of the stack. */
+        vTCPCongestionWatchInterface( &( xInterfaces[ 0 ] ) );
+
         /* === End-point 0 === */
         #if ( ipconfigUSE_IPv4 != 0 )
             {
@@ -119,6 +478,9 @@ void app_main( void )
                 {
                     /* End-point 0 wants to use DHCPv4. */
                     xEndPoints[xEndPointCount].bits.bWantDHCP = pdTRUE; // pdFALSE; // pdTRUE;
+
+                    /* Start from the lease that was used before the reset. */
+                    ( void ) xDHCPLeaseApply( &( xEndPoints[ xEndPointCount ] ) );
                 }
                 #endif /* ( ipconfigUSE_DHCP != 0 ) */
 
@@ -160,6 +522,10 @@ void app_main( void )
                     {
                         /* End-point 1 wants to use Router Advertisement */
                         xEndPoints[ xEndPointCount ].bits.bWantRA = pdTRUE;
+
+                        /* Start from the prefix and gateway that were learned
+                         * before the reset. */
+                        ( void ) xRALeaseApply( &( xEndPoints[ xEndPointCount ] ) );
                     }
                 #endif /* #if( ipconfigUSE_RA != 0 ) */
                 #if ( ipconfigUSE_DHCPv6 != 0 )
@@ -225,48 +591,36 @@ void app_main( void )
 	void vApplicationIPNetworkEventHook( eIPCallbackEvent_t eNetworkEvent)
 #endif /* defined(ipconfigIPv4_BACKWARD_COMPATIBLE) && ( ipconfigIPv4_BACKWARD_COMPATIBLE == 0 ) */
 {
+    /* Addresses, prefixes or gateways may have changed: cached routes are no
+     * longer valid. */
+    vRouteCacheInvalidate();
+
+    /* Start (or pause) the services whose end-points changed state, without
+     * waiting for the other end-points. */
+    #if defined(ipconfigIPv4_BACKWARD_COMPATIBLE) && ( ipconfigIPv4_BACKWARD_COMPATIBLE == 0 )
+        vNetServicesNetworkEvent( eNetworkEvent, pxEndPoint );
+    #else
+        vNetServicesNetworkEvent( eNetworkEvent, NULL );
+    #endif
+
     /* If the network has just come up...*/
     if( eNetworkEvent == eNetworkUp )
     {
-
-
-        xUpEndPointCount += 1;
-
-        if( xUpEndPointCount >= TOTAL_ENDPOINTS )
-        {
-
-            /* Create the tasks that use the IP stack if they have not already been
-            * created. */
-            if( xTasksAlreadyCreated == pdFALSE )
-            {
-                xTasksAlreadyCreated = pdTRUE;
-
-                #if ( ipconfigUSE_IPv4 != 0 )
-
-                    #if mainCREATE_TCP_ECHO_TASKS_SINGLE
-
-                        void vStartTCPEchoClientTasks_SingleTasks( uint16_t usTaskStackSize, UBaseType_t uxTaskPriority );
-                        vStartTCPEchoClientTasks_SingleTasks(mainCLI_TASK_STACK_SIZE, mainCLI_TASK_PRIORITY);
-
-                    #endif
-
-                #endif
-
-                #if ( mainCREATE_UDP_ECHO_TASKS_SINGLE == 1 )
-                    {
-                        void vStartUDPEchoClientTasks_SingleTasks(uint16_t usTaskStackSize, UBaseType_t uxTaskPriority);
-                        vStartUDPEchoClientTasks_SingleTasks( mainCLI_TASK_STACK_SIZE, mainCLI_TASK_PRIORITY );
-                    }
-                #endif
-
-            }
-
-        }
+        /* The Ethernet DMA has work again. */
+        vTicklessAllowStop( pdFALSE );
 
         #if defined(ipconfigIPv4_BACKWARD_COMPATIBLE) && ( ipconfigIPv4_BACKWARD_COMPATIBLE == 0 )
 
         	extern void showEndPoint( NetworkEndPoint_t * pxEndPoint );
             showEndPoint( pxEndPoint );
+
+            #if ( ipconfigUSE_DHCP != 0 )
+                vDHCPLeaseEndPointUp( pxEndPoint );
+            #endif
+
+            #if ( ipconfigUSE_IPv6 != 0 ) && ( ipconfigUSE_RA != 0 )
+                vRALeaseEndPointUp( pxEndPoint );
+            #endif
         
         #else
 
@@ -298,7 +652,9 @@ void app_main( void )
     }
     else if( eNetworkEvent == eNetworkDown )
     {
-
+        /* Nothing is received while the link is down, so the idle periods
+         * may use Stop mode, see tickless.h. */
+        vTicklessAllowStop( pdTRUE );
     }
 }
 /*-----------------------------------------------------------*/
@@ -327,6 +683,45 @@ void app_main( void )
 
 /*-----------------------------------------------------------*/
 
+#if ( ipconfigUSE_DHCP != 0 ) && ( ipconfigUSE_DHCP_HOOK != 0 )
+
+#if defined(ipconfigIPv4_BACKWARD_COMPATIBLE) && ( ipconfigIPv4_BACKWARD_COMPATIBLE == 0 )
+	eDHCPCallbackAnswer_t xApplicationDHCPHook_Multi( eDHCPCallbackPhase_t eDHCPPhase,
+                                                      struct xNetworkEndPoint * pxEndPoint,
+                                                      IP_Address_t * pxIPAddress )
+	{
+        DHCPLease_t xLease;
+
+        ( void ) pxIPAddress;
+
+        /* Ask for the address of the stored lease in the DISCOVER, a server
+         * that still has the lease will offer it again at once. */
+        if( ( eDHCPPhase == eDHCPPhasePreDiscover ) &&
+            ( pxEndPoint->bits.bIPv6 == pdFALSE_UNSIGNED ) &&
+            ( xDHCPLeaseLoad( &xLease ) == pdPASS ) )
+        {
+            pxEndPoint->xDHCPData.ulPreferredIPAddress = xLease.ulIPAddress;
+        }
+
+        return eDHCPContinue;
+	}
+#else
+	eDHCPCallbackAnswer_t xApplicationDHCPHook( eDHCPCallbackPhase_t eDHCPPhase,
+                                                uint32_t ulIPAddress )
+	{
+        /* The single end-point API gives no access to the DHCP data of the
+         * end-point, so the stored lease is not used. */
+        ( void ) eDHCPPhase;
+        ( void ) ulIPAddress;
+
+        return eDHCPContinue;
+	}
+#endif /* defined(ipconfigIPv4_BACKWARD_COMPATIBLE) && ( ipconfigIPv4_BACKWARD_COMPATIBLE == 0 ) */
+
+#endif /* ( ipconfigUSE_DHCP != 0 ) && ( ipconfigUSE_DHCP_HOOK != 0 ) */
+
+/*-----------------------------------------------------------*/
+
 const char *pcApplicationHostnameHook( void )
 {
     /* Assign the name "STM32Hxx" to this network node.  This function will be
@@ -338,18 +733,8 @@ const char *pcApplicationHostnameHook( void )
 
 BaseType_t xApplicationGetRandomNumber( uint32_t *pulValue )
 {
-BaseType_t xReturn;
-	extern RNG_HandleTypeDef hrng;
-    if( HAL_RNG_GenerateRandomNumber( &hrng, pulValue ) == HAL_OK )
-    {
-        xReturn = pdPASS;
-    }
-    else
-    {
-        xReturn = pdFAIL;
-    }
-
-    return xReturn;
+    /* From the DRBG, which the RNG reseeds in the background. */
+    return xEntropyPoolRandom( pulValue, sizeof( *pulValue ) );
 }
 
 uint32_t ulApplicationGetNextSequenceNumber( uint32_t ulSourceAddress,
@@ -357,19 +742,35 @@ uint32_t ulApplicationGetNextSequenceNumber( uint32_t ulSourceAddress,
                                              uint32_t ulDestinationAddress,
                                              uint16_t usDestinationPort )
 {
-    uint32_t ulReturn;
+    /* RFC 6528: a keyed hash of the 4-tuple plus a microsecond clock, this
+     * never waits for the RNG. */
+    return ulTCPISNGenerate( ulSourceAddress, usSourcePort, ulDestinationAddress, usDestinationPort );
+}
 
-    ( void ) ulSourceAddress;
-    ( void ) usSourcePort;
-    ( void ) ulDestinationAddress;
-    ( void ) usDestinationPort;
 
-    xApplicationGetRandomNumber( &ulReturn );
+/*-----------------------------------------------------------*/
 
-    return ulReturn;
+void vApplicationPingReplyHook( ePingReplyStatus_t eStatus,
+                                uint16_t usIdentifier )
+{
+    vPingReplyReceived( eStatus, usIdentifier );
 }
+/*-----------------------------------------------------------*/
 
-
+void vApplicationNetStatsReportHook( void )
+{
+    /* The periodic report of the modules that keep statistics. */
+    vTCPAutotuneReport();
+    vTCPCongestionReport();
+    vRouteCacheReport();
+    vNetServicesReport();
+    vTicklessReport();
+    vLoggingReport();
+    FreeRTOS_printf( ( "Heap: %u bytes free, at least %u, %u allocations failed\n",
+                       ( unsigned ) xPortGetFreeHeapSize(),
+                       ( unsigned ) xPortGetMinimumEverFreeHeapSize(),
+                       ( unsigned ) ulMallocFailures ) );
+}
 /*-----------------------------------------------------------*/
 
 void vIncrementTim7Tick( void )
@@ -389,8 +790,7 @@ void vApplicationStackOverflowHook( TaskHandle_t pxTask, char *pcTaskName )
     /* If configCHECK_FOR_STACK_OVERFLOW is set to either 1 or 2 then this
      * function will automatically get called if a task overflows its stack. */
     ( void ) pxTask;
-    ( void ) pcTaskName;
-    for( ;; );
+    vCrashStop( eCrashStackOverflow, pcTaskName, 0U );
 }
 /*-----------------------------------------------------------*/
 
@@ -398,18 +798,34 @@ void vApplicationMallocFailedHook( void )
 {
     /* If configUSE_MALLOC_FAILED_HOOK is set to 1 then this function will
      * be called automatically if a call to pvPortMalloc() fails.  pvPortMalloc()
-     * is called automatically when a task, queue or semaphore is created. */
-    for( ;; );
+     * is called automatically when a task, queue or semaphore is created.
+     *
+     * The caller gets NULL and copes with it: FreeRTOS+TCP drops the packet
+     * or fails the socket call, and the creation of a task or queue returns
+     * an error.  So the failure is only counted, and shown by the periodic
+     * report of vApplicationNetStatsReportHook().  Nothing is logged here,
+     * the hook may run before the logging task exists. */
+    ulMallocFailures++;
 }
 /*-----------------------------------------------------------*/
 
 time_t get_time( time_t * puxTime )
 {
-    time_t val = 0;
-    return val;
+    time_t xTime = ( time_t ) ( ullWallClockMicroseconds() / 1000000U );
+
+    if( puxTime != NULL )
+    {
+        *puxTime = xTime;
+    }
+
+    return xTime;
 }
+/*-----------------------------------------------------------*/
 
 int set_time( const time_t * t )
 {
+    /* Stepped, also backward, see wall_clock.h. */
+    vWallClockCorrect( ( ( int64_t ) *t * 1000000 ) - ( int64_t ) ullWallClockMicroseconds(), pdFALSE );
+
     return 0;
 }
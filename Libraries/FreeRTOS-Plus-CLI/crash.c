@@ -0,0 +1,463 @@
+/* The log messages of this file, see log_levels.h. */
+#define logMODULE    eLogModuleApp
+
+/* Standard includes. */
+#include <string.h>
+#include <stddef.h>
+
+/* FreeRTOS includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+
+/* ST includes. */
+#include "stm32h7xx_hal.h"
+
+#include "crash.h"
+#include "trace.h"
+
+/* The fault handlers are generated here instead of in stm32h7xx_it.c: they
+ * must not touch the stack before it is read.  Pass the stack that holds the
+ * exception frame and EXC_RETURN to prvFault(). */
+#define crashFAULT_ENTRY()                 \
+    __asm volatile                         \
+    (                                      \
+        "   tst lr, #4              \n"    \
+        "   ite eq                  \n"    \
+        "   mrseq r0, msp           \n"    \
+        "   mrsne r0, psp           \n"    \
+        "   mov r1, lr              \n"    \
+        "   b prvFault              \n"    \
+    )
+
+/* VECTACTIVE of the fault exceptions. */
+#define crashVECTOR_HARD_FAULT       3U
+#define crashVECTOR_USAGE_FAULT      6U
+
+/* Bytes of the dump per "crash-dump" log line. */
+#define crashBYTES_PER_LINE          32U
+
+#define crashRESET_POWER_ON          ( RCC_RSR_PORRSTF | RCC_RSR_BORRSTF )
+
+/*
+ * The C part of the fault handlers.
+ */
+static void prvFault( uint32_t * pulFrame,
+                      uint32_t ulExcReturn ) __attribute__( ( used, noreturn ) );
+
+/*
+ * Fill in the dump, from the exception frame if there is one.  Otherwise
+ * ulCaller, the address that called vCrashStop() or vCrashAssert(), is
+ * stored as the PC.
+ */
+static void prvCapture( CrashReason_t eReason,
+                        const uint32_t * pulFrame,
+                        uint32_t ulExcReturn,
+                        uint32_t ulCaller,
+                        const char * pcText,
+                        uint32_t ulLine ) __attribute__( ( noreturn ) );
+
+/*
+ * Seal the dump with its CRC and reset.
+ */
+static void prvFinish( void ) __attribute__( ( noreturn ) );
+
+/*
+ * Whether xDump holds a complete dump.
+ */
+static BaseType_t prvDumpIsValid( void );
+
+/*
+ * Whether the ulLength bytes at ulAddress are RAM, so that reading them
+ * cannot fault again.
+ */
+static BaseType_t prvIsRAM( uint32_t ulAddress,
+                            uint32_t ulLength );
+
+/*
+ * The CRC-32 of zlib, bit by bit: there is no room for a table in a fault
+ * handler, and it runs once.
+ */
+static uint32_t prvCRC32( const uint8_t * pucData,
+                          size_t uxLength );
+
+static void prvCopyText( char * pcDestination,
+                         const char * pcSource,
+                         size_t uxSize );
+
+/*-----------------------------------------------------------*/
+
+/* Survive a reset: start-up does not clear .noinit, which is placed in
+ * RAM_D3 by the linker scripts. */
+static CrashDump_t xDump __attribute__( ( section( ".noinit" ) ) );
+static uint32_t ulReportedCRC __attribute__( ( section( ".noinit" ) ) );
+
+/* The tasks, registered by the trace hooks. */
+static void * pvTasks[ configCRASH_MAX_TASKS ];
+
+static volatile BaseType_t xCapturing = pdFALSE;
+static uint32_t ulResetFlags = 0U;
+
+static const char * const pcReasons[] =
+{
+    "none",
+    "hard fault",
+    "memory management fault",
+    "bus fault",
+    "usage fault",
+    "stack overflow",
+    "malloc failed",
+    "assert",
+    "Error_Handler"
+};
+
+/*-----------------------------------------------------------*/
+
+void HardFault_Handler( void ) __attribute__( ( naked ) );
+void MemManage_Handler( void ) __attribute__( ( naked ) );
+void BusFault_Handler( void ) __attribute__( ( naked ) );
+void UsageFault_Handler( void ) __attribute__( ( naked ) );
+
+void HardFault_Handler( void )
+{
+    crashFAULT_ENTRY();
+}
+/*-----------------------------------------------------------*/
+
+void MemManage_Handler( void )
+{
+    crashFAULT_ENTRY();
+}
+/*-----------------------------------------------------------*/
+
+void BusFault_Handler( void )
+{
+    crashFAULT_ENTRY();
+}
+/*-----------------------------------------------------------*/
+
+void UsageFault_Handler( void )
+{
+    crashFAULT_ENTRY();
+}
+/*-----------------------------------------------------------*/
+
+static void prvFault( uint32_t * pulFrame,
+                      uint32_t ulExcReturn )
+{
+    uint32_t ulVector = SCB->ICSR & SCB_ICSR_VECTACTIVE_Msk;
+    CrashReason_t eReason = eCrashHardFault;
+
+    if( ( ulVector > crashVECTOR_HARD_FAULT ) && ( ulVector <= crashVECTOR_USAGE_FAULT ) )
+    {
+        /* eCrashMemManage, eCrashBusFault or eCrashUsageFault. */
+        eReason = ( CrashReason_t ) ( eCrashHardFault + ( ulVector - crashVECTOR_HARD_FAULT ) );
+    }
+
+    prvCapture( eReason, pulFrame, ulExcReturn, 0U, NULL, 0U );
+}
+/*-----------------------------------------------------------*/
+
+static void prvCapture( CrashReason_t eReason,
+                        const uint32_t * pulFrame,
+                        uint32_t ulExcReturn,
+                        uint32_t ulCaller,
+                        const char * pcText,
+                        uint32_t ulLine )
+{
+    uint32_t ulCount;
+    UBaseType_t x;
+    TaskHandle_t xTask;
+
+    __disable_irq();
+
+    if( xCapturing != pdFALSE )
+    {
+        /* The capture itself faulted, keep what is there. */
+        xDump.ulFlags |= crashFLAG_NESTED;
+        prvFinish();
+    }
+
+    xCapturing = pdTRUE;
+
+    ulCount = ( prvDumpIsValid() != pdFALSE ) ? ( xDump.ulCount + 1U ) : 1U;
+    memset( &xDump, 0, sizeof( xDump ) );
+
+    xDump.ulMagic = crashMAGIC;
+    xDump.usVersion = crashVERSION;
+    xDump.usSize = ( uint16_t ) sizeof( xDump );
+    xDump.ulReason = ( uint32_t ) eReason;
+    xDump.ulCount = ulCount;
+    xDump.ulTick = ( uint32_t ) xTaskGetTickCountFromISR();
+    xDump.ulExcReturn = ulExcReturn;
+    xDump.ulMSP = __get_MSP();
+    xDump.ulPSP = __get_PSP();
+    xDump.ulCFSR = SCB->CFSR;
+    xDump.ulHFSR = SCB->HFSR;
+    xDump.ulMMFAR = SCB->MMFAR;
+    xDump.ulBFAR = SCB->BFAR;
+    xDump.ulAFSR = SCB->AFSR;
+    xDump.ulLine = ulLine;
+    prvCopyText( xDump.cText, pcText, sizeof( xDump.cText ) );
+
+    if( ( pulFrame != NULL ) && ( prvIsRAM( ( uint32_t ) pulFrame, sizeof( xDump.ulFrame ) ) != pdFALSE ) )
+    {
+        memcpy( xDump.ulFrame, pulFrame, sizeof( xDump.ulFrame ) );
+        xDump.ulFlags |= crashFLAG_FRAME;
+    }
+    else
+    {
+        xDump.ulFrame[ 6 ] = ulCaller;
+    }
+
+    xTask = xTaskGetCurrentTaskHandle();
+    xDump.ulCurrentTask = ( uint32_t ) xTask;
+
+    if( xTask != NULL )
+    {
+        prvCopyText( xDump.cCurrentTask, pcTaskGetName( xTask ), sizeof( xDump.cCurrentTask ) );
+    }
+
+    xDump.usMaxTasks = ( uint16_t ) configCRASH_MAX_TASKS;
+
+    for( x = 0; x < configCRASH_MAX_TASKS; x++ )
+    {
+        if( pvTasks[ x ] != NULL )
+        {
+            CrashTask_t * pxTask = &( xDump.xTasks[ xDump.usTasks ] );
+
+            pxTask->ulHandle = ( uint32_t ) pvTasks[ x ];
+            prvCopyText( pxTask->cName, pcTaskGetName( ( TaskHandle_t ) pvTasks[ x ] ), sizeof( pxTask->cName ) );
+            pxTask->ulStackFree = ( uint32_t ) uxTaskGetStackHighWaterMark( ( TaskHandle_t ) pvTasks[ x ] );
+            xDump.usTasks++;
+        }
+    }
+
+    xDump.usMaxEvents = ( uint16_t ) configCRASH_TRACE_EVENTS;
+    xDump.ulCpuHz = SystemCoreClock;
+
+    #if ( configUSE_EVENT_TRACE == 1 )
+        xDump.usEvents = ( uint16_t ) uxTraceCopyLast( xDump.xEvents, configCRASH_TRACE_EVENTS );
+    #endif
+
+    prvFinish();
+}
+/*-----------------------------------------------------------*/
+
+static void prvFinish( void )
+{
+    xDump.ulCRC = prvCRC32( ( const uint8_t * ) &xDump, offsetof( CrashDump_t, ulCRC ) );
+    __DSB();
+
+    if( ( CoreDebug->DHCSR & CoreDebug_DHCSR_C_DEBUGEN_Msk ) != 0U )
+    {
+        /* Let the debugger look at it first. */
+        __BKPT( 0 );
+    }
+
+    NVIC_SystemReset();
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvDumpIsValid( void )
+{
+    BaseType_t xValid = pdFALSE;
+
+    if( ( xDump.ulMagic == crashMAGIC ) &&
+        ( xDump.usVersion == crashVERSION ) &&
+        ( xDump.usSize == sizeof( xDump ) ) &&
+        ( xDump.ulCRC == prvCRC32( ( const uint8_t * ) &xDump, offsetof( CrashDump_t, ulCRC ) ) ) )
+    {
+        xValid = pdTRUE;
+    }
+
+    return xValid;
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvIsRAM( uint32_t ulAddress,
+                            uint32_t ulLength )
+{
+    static const uint32_t ulRanges[][ 2 ] =
+    {
+        { D1_DTCMRAM_BASE, D1_DTCMRAM_BASE + 0x20000U },
+        { D1_AXISRAM_BASE, D1_AXISRAM_BASE + 0x50000U },
+        { D2_AHBSRAM_BASE, D2_AHBSRAM_BASE + 0x8000U  },
+        { D3_SRAM_BASE,    D3_SRAM_BASE + 0x4000U     }
+    };
+    BaseType_t xReturn = pdFALSE;
+    size_t x;
+
+    if( ( ulAddress & 3U ) == 0U )
+    {
+        for( x = 0; x < sizeof( ulRanges ) / sizeof( ulRanges[ 0 ] ); x++ )
+        {
+            if( ( ulAddress >= ulRanges[ x ][ 0 ] ) && ( ulAddress + ulLength <= ulRanges[ x ][ 1 ] ) )
+            {
+                xReturn = pdTRUE;
+                break;
+            }
+        }
+    }
+
+    return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+static uint32_t prvCRC32( const uint8_t * pucData,
+                          size_t uxLength )
+{
+    uint32_t ulCRC = 0xFFFFFFFFUL;
+    size_t x;
+    int iBit;
+
+    for( x = 0; x < uxLength; x++ )
+    {
+        ulCRC ^= pucData[ x ];
+
+        for( iBit = 0; iBit < 8; iBit++ )
+        {
+            ulCRC = ( ulCRC >> 1 ) ^ ( 0xEDB88320UL & ( 0UL - ( ulCRC & 1UL ) ) );
+        }
+    }
+
+    return ~ulCRC;
+}
+/*-----------------------------------------------------------*/
+
+static void prvCopyText( char * pcDestination,
+                         const char * pcSource,
+                         size_t uxSize )
+{
+    const char * pcSlash;
+    size_t x;
+
+    if( pcSource != NULL )
+    {
+        /* Only the file name of __FILE__. */
+        pcSlash = strrchr( pcSource, '/' );
+
+        if( pcSlash != NULL )
+        {
+            pcSource = pcSlash + 1;
+        }
+
+        for( x = 0; ( x < ( uxSize - 1U ) ) && ( pcSource[ x ] != '\0' ); x++ )
+        {
+            pcDestination[ x ] = pcSource[ x ];
+        }
+
+        pcDestination[ x ] = '\0';
+    }
+}
+/*-----------------------------------------------------------*/
+
+void vCrashInitialise( void )
+{
+    ulResetFlags = RCC->RSR;
+    RCC->RSR |= RCC_RSR_RMVF;
+
+    if( ( ulResetFlags & crashRESET_POWER_ON ) != 0U )
+    {
+        /* RAM_D3 holds noise after a power-on.  Write it before it is read,
+         * which also initialises its ECC. */
+        memset( &xDump, 0, sizeof( xDump ) );
+        ulReportedCRC = 0U;
+    }
+
+    /* Report the faults as what they are instead of as hard faults. */
+    SCB->SHCSR |= SCB_SHCSR_MEMFAULTENA_Msk | SCB_SHCSR_BUSFAULTENA_Msk | SCB_SHCSR_USGFAULTENA_Msk;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xCrashReport( void )
+{
+    static const char cHex[] = "0123456789abcdef";
+    char cLine[ ( crashBYTES_PER_LINE * 2U ) + 1U ];
+    const uint8_t * pucDump = ( const uint8_t * ) &xDump;
+    size_t uxOffset;
+    size_t x;
+    const char * pcReason;
+
+    LogInfo( ( "crash: reset flags 0x%08x\n", ( unsigned ) ulResetFlags ) );
+
+    if( ( prvDumpIsValid() == pdFALSE ) || ( xDump.ulCRC == ulReportedCRC ) )
+    {
+        return pdFALSE;
+    }
+
+    pcReason = ( xDump.ulReason < ( sizeof( pcReasons ) / sizeof( pcReasons[ 0 ] ) ) ) ? pcReasons[ xDump.ulReason ] : "?";
+
+    LogError( ( "crash: %s in task \"%s\" at tick %u, crash %u since power-on\n",
+                pcReason, xDump.cCurrentTask, ( unsigned ) xDump.ulTick, ( unsigned ) xDump.ulCount ) );
+    LogError( ( "crash: pc 0x%08x lr 0x%08x psr 0x%08x cfsr 0x%08x hfsr 0x%08x mmfar 0x%08x bfar 0x%08x\n",
+                ( unsigned ) xDump.ulFrame[ 6 ], ( unsigned ) xDump.ulFrame[ 5 ], ( unsigned ) xDump.ulFrame[ 7 ],
+                ( unsigned ) xDump.ulCFSR, ( unsigned ) xDump.ulHFSR, ( unsigned ) xDump.ulMMFAR, ( unsigned ) xDump.ulBFAR ) );
+
+    if( xDump.cText[ 0 ] != '\0' )
+    {
+        LogError( ( "crash: %s:%u\n", xDump.cText, ( unsigned ) xDump.ulLine ) );
+    }
+
+    /* The raw dump, for tools/crash_dump.py. */
+    for( uxOffset = 0; uxOffset < sizeof( xDump ); uxOffset += crashBYTES_PER_LINE )
+    {
+        for( x = 0; ( x < crashBYTES_PER_LINE ) && ( ( uxOffset + x ) < sizeof( xDump ) ); x++ )
+        {
+            cLine[ 2U * x ] = cHex[ pucDump[ uxOffset + x ] >> 4 ];
+            cLine[ ( 2U * x ) + 1U ] = cHex[ pucDump[ uxOffset + x ] & 0x0FU ];
+        }
+
+        cLine[ 2U * x ] = '\0';
+        LogError( ( "crash-dump %04x %s\n", ( unsigned ) uxOffset, cLine ) );
+    }
+
+    ulReportedCRC = xDump.ulCRC;
+
+    return pdTRUE;
+}
+/*-----------------------------------------------------------*/
+
+void vCrashStop( CrashReason_t eReason,
+                 const char * pcText,
+                 uint32_t ulLine )
+{
+    prvCapture( eReason, NULL, 0U, ( uint32_t ) __builtin_return_address( 0 ), pcText, ulLine );
+}
+/*-----------------------------------------------------------*/
+
+void vCrashAssert( const char * pcFile,
+                   uint32_t ulLine )
+{
+    prvCapture( eCrashAssert, NULL, 0U, ( uint32_t ) __builtin_return_address( 0 ), pcFile, ulLine );
+}
+/*-----------------------------------------------------------*/
+
+void vCrashTaskCreated( void * pvTask )
+{
+    UBaseType_t x;
+
+    for( x = 0; x < configCRASH_MAX_TASKS; x++ )
+    {
+        if( pvTasks[ x ] == NULL )
+        {
+            pvTasks[ x ] = pvTask;
+            break;
+        }
+    }
+}
+/*-----------------------------------------------------------*/
+
+void vCrashTaskDeleted( void * pvTask )
+{
+    UBaseType_t x;
+
+    for( x = 0; x < configCRASH_MAX_TASKS; x++ )
+    {
+        if( pvTasks[ x ] == pvTask )
+        {
+            pvTasks[ x ] = NULL;
+            break;
+        }
+    }
+}
+/*-----------------------------------------------------------*/
@@ -0,0 +1,145 @@
+#ifndef CRASH_H
+#define CRASH_H
+
+/* FreeRTOS includes. */
+#include "FreeRTOS.h"
+
+#include "trace_events.h"
+
+/*
+ * Post-mortem capture.  A fault, a failed configASSERT(), a stack overflow,
+ * a failed allocation or Error_Handler() does not spin forever any more.
+ * Instead it writes a CrashDump_t into the .noinit section in RAM_D3, which
+ * start-up does not clear, and resets the MCU.  With a debugger attached, it
+ * first stops at a breakpoint.
+ *
+ * The dump holds:
+ * - the exception frame and the fault status registers;
+ * - the task that was running;
+ * - the free stack of every task;
+ * - the last configCRASH_TRACE_EVENTS events of trace.h.
+ *
+ * xCrashReport() logs a summary of the dump after the next boot.  It also
+ * logs the raw dump as "crash-dump" hex lines.  The dump is then marked as
+ * reported, but it stays in RAM_D3 until the next crash or power-on.
+ *
+ * tools/crash_dump.py decodes the dump, from a saved log or from a binary
+ * image of RAM_D3.  The layout below is that file format: all fields are
+ * little-endian and 32-bit aligned, and the dump ends with a CRC-32 of all
+ * bytes before it.  Change crashVERSION together with the parser.
+ *
+ * The task list is kept by the traceTASK_CREATE() and traceTASK_DELETE()
+ * hooks, set in FreeRTOSConfig.h.  The capture takes no locks and calls no
+ * kernel function that could block or assert.
+ */
+
+#ifndef configCRASH_MAX_TASKS
+    #define configCRASH_MAX_TASKS        20U
+#endif
+
+#ifndef configCRASH_TRACE_EVENTS
+    #define configCRASH_TRACE_EVENTS     32U
+#endif
+
+#define crashMAGIC                       0x48535243UL /* "CRSH" */
+#define crashVERSION                     3U
+#define crashNAME_LENGTH                 16U
+#define crashTEXT_LENGTH                 48U
+
+/* Bits of CrashDump_t.ulFlags. */
+#define crashFLAG_FRAME                  0x01UL /* ulFrame[] holds an exception frame. */
+#define crashFLAG_NESTED                 0x02UL /* Faulted again during the capture. */
+
+typedef enum eCRASH_REASON
+{
+    eCrashNone = 0,
+    eCrashHardFault,
+    eCrashMemManage,
+    eCrashBusFault,
+    eCrashUsageFault,
+    eCrashStackOverflow,
+    eCrashMallocFailed,
+    eCrashAssert,
+    eCrashError          /* Error_Handler(). */
+} CrashReason_t;
+
+typedef struct xCRASH_TASK
+{
+    uint32_t ulHandle;
+    uint32_t ulStackFree;   /* The high-water mark, in words. */
+    char cName[ crashNAME_LENGTH ];
+} CrashTask_t;
+
+typedef struct xCRASH_DUMP
+{
+    uint32_t ulMagic;
+    uint16_t usVersion;
+    uint16_t usSize;        /* sizeof( CrashDump_t ). */
+    uint32_t ulReason;      /* A CrashReason_t. */
+    uint32_t ulFlags;
+    uint32_t ulCount;       /* Crashes since power-on, this one included. */
+    uint32_t ulTick;
+    uint32_t ulFrame[ 8 ];  /* R0-R3, R12, LR, PC and xPSR of the faulting code. */
+    uint32_t ulExcReturn;
+    uint32_t ulMSP;
+    uint32_t ulPSP;
+    uint32_t ulCFSR;
+    uint32_t ulHFSR;
+    uint32_t ulMMFAR;
+    uint32_t ulBFAR;
+    uint32_t ulAFSR;
+    uint32_t ulCurrentTask;
+    char cCurrentTask[ crashNAME_LENGTH ];
+    char cText[ crashTEXT_LENGTH ];  /* File of an assert, or the task that overflowed. */
+    uint32_t ulLine;
+    uint16_t usMaxTasks;
+    uint16_t usTasks;
+    uint16_t usMaxEvents;
+    uint16_t usEvents;      /* Oldest first. */
+    uint32_t ulCpuHz;       /* Rate of the ulCycles of xEvents, SystemCoreClock. */
+    CrashTask_t xTasks[ configCRASH_MAX_TASKS ];
+    TraceEvent_t xEvents[ configCRASH_TRACE_EVENTS ];
+    uint32_t ulCRC;
+} CrashDump_t;
+
+/**
+ * @brief Check the dump left by the previous boot and enable the separate
+ * MemManage, BusFault and UsageFault exceptions.  Call early, before any
+ * task is created.
+ */
+void vCrashInitialise( void );
+
+/**
+ * @brief Log the dump of the previous boot, if there is one that was not
+ * reported yet.  Call once the logging task runs.
+ *
+ * @return pdTRUE if a dump was logged.
+ */
+BaseType_t xCrashReport( void );
+
+/**
+ * @brief Capture a dump and reset.  For configASSERT(), Error_Handler() and
+ * the application hooks.
+ *
+ * @param eReason Why.
+ * @param pcText A file or task name, or NULL.
+ * @param ulLine A line number, or 0.
+ */
+void vCrashStop( CrashReason_t eReason,
+                 const char * pcText,
+                 uint32_t ulLine ) __attribute__( ( noreturn ) );
+
+/**
+ * @brief configASSERT() failed at ulLine of pcFile.  Declared again in
+ * FreeRTOSConfig.h, which cannot include this file.
+ */
+void vCrashAssert( const char * pcFile,
+                   uint32_t ulLine ) __attribute__( ( noreturn ) );
+
+/**
+ * @brief The kernel trace hooks, see FreeRTOSConfig.h.
+ */
+void vCrashTaskCreated( void * pvTask );
+void vCrashTaskDeleted( void * pvTask );
+
+#endif /* #ifndef CRASH_H */
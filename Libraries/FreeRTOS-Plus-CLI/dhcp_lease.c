@@ -0,0 +1,536 @@
+/* The log messages of this file, see log_levels.h. */
+#define logMODULE    eLogModuleNet
+
+/* Standard includes. */
+#include <stddef.h>
+#include <string.h>
+
+/* FreeRTOS includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+
+/* FreeRTOS+TCP includes. */
+#include "FreeRTOS_IP.h"
+#include "FreeRTOS_Routing.h"
+#include "FreeRTOS_DHCP.h"
+
+#include "dhcp_lease.h"
+#include "dhcp_lease_flash.h"
+
+/* The kinds of record, each has its own magic number. */
+#define dhcpleaseKIND_DHCP        0
+#define dhcpleaseKIND_RA          1
+#define dhcpleaseKIND_COUNT       2
+
+typedef struct xDHCP_LEASE_RECORD
+{
+    uint32_t ulMagic;
+    uint32_t ulSequence;  /* The newest record has the highest number. */
+    union
+    {
+        DHCPLease_t xDHCP;
+        RALease_t xRA;
+    } u;
+    uint32_t ulCRC;       /* CRC-32 of the fields above. */
+} DHCPLeaseRecord_t;
+
+/*
+ * Find the newest valid record of each kind and the first free slot.
+ */
+static void prvScan( void );
+
+/*
+ * The task that writes the records handed over by prvQueue().
+ */
+static void prvLeaseTask( void * pvParameters );
+
+/*
+ * One round of the lease task: wait for records and write them, or erase the
+ * sector when it is full and nothing was handed over for a while.
+ */
+static void prvWriteRecords( void );
+
+/*
+ * Hand a record over to the lease task.
+ */
+static BaseType_t prvQueue( BaseType_t xKind,
+                            const void * pvContents,
+                            size_t uxLength );
+
+/*
+ * Get or store the newest record of a kind.
+ */
+static BaseType_t prvLoad( BaseType_t xKind,
+                           void * pvContents,
+                           size_t uxLength );
+static BaseType_t prvSave( BaseType_t xKind,
+                           const void * pvContents,
+                           size_t uxLength );
+
+/*
+ * Calculate the CRC-32 of a record, without its CRC field.
+ */
+static uint32_t prvRecordCRC( const DHCPLeaseRecord_t * pxRecord );
+
+/*
+ * Return pdTRUE when a slot was never programmed since the last erase.
+ */
+static BaseType_t prvSlotIsErased( const DHCPLeaseRecord_t * pxSlot );
+
+/*
+ * Erase the full sector and write back the newest record of each kind.
+ */
+static void prvCompact( void );
+
+/*-----------------------------------------------------------*/
+
+static const uint32_t ulMagics[ dhcpleaseKIND_COUNT ] =
+{
+    0x4C454153UL, /* "LEAS" */
+    0x52414C53UL  /* "RALS" */
+};
+
+static const size_t uxLengths[ dhcpleaseKIND_COUNT ] =
+{
+    sizeof( DHCPLease_t ),
+    sizeof( RALease_t )
+};
+
+/* The newest record of each kind, a copy in RAM.  Written by the lease task
+ * in a critical section, so that prvLoad() can be called from any task. */
+static DHCPLeaseRecord_t xNewest[ dhcpleaseKIND_COUNT ];
+static BaseType_t xHaveNewest[ dhcpleaseKIND_COUNT ];
+
+/* The records waiting for the lease task, only u is used. */
+static DHCPLeaseRecord_t xPending[ dhcpleaseKIND_COUNT ];
+static BaseType_t xHavePending[ dhcpleaseKIND_COUNT ];
+
+static TaskHandle_t xLeaseTask = NULL;
+
+/* The highest sequence number of all kinds. */
+static uint32_t ulLastSequence = 0U;
+
+/* The slot to write the next record to, configDHCP_LEASE_RECORD_COUNT when
+ * the sector is full. */
+static size_t uxNextSlot = 0U;
+
+/* Set when a record could not be written because the sector is full, it
+ * only lives in xNewest until prvCompact() runs. */
+static BaseType_t xEraseNeeded = pdFALSE;
+
+/*-----------------------------------------------------------*/
+
+static uint32_t prvRecordCRC( const DHCPLeaseRecord_t * pxRecord )
+{
+    const uint8_t * pucData = ( const uint8_t * ) pxRecord;
+    size_t uxLength = offsetof( DHCPLeaseRecord_t, ulCRC );
+    uint32_t ulCRC = 0xFFFFFFFFUL;
+    size_t x;
+    BaseType_t xBit;
+
+    for( x = 0; x < uxLength; x++ )
+    {
+        ulCRC ^= pucData[ x ];
+
+        for( xBit = 0; xBit < 8; xBit++ )
+        {
+            ulCRC = ( ulCRC >> 1 ) ^ ( 0xEDB88320UL & ( 0U - ( ulCRC & 1U ) ) );
+        }
+    }
+
+    return ~ulCRC;
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvSlotIsErased( const DHCPLeaseRecord_t * pxSlot )
+{
+    const uint32_t * pulWords = ( const uint32_t * ) pxSlot;
+    BaseType_t xReturn = pdTRUE;
+    size_t x;
+
+    for( x = 0; x < ( dhcpleaseFLASH_WORD_SIZE / sizeof( uint32_t ) ); x++ )
+    {
+        if( pulWords[ x ] != 0xFFFFFFFFUL )
+        {
+            xReturn = pdFALSE;
+            break;
+        }
+    }
+
+    return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+static void prvScan( void )
+{
+    DHCPLeaseRecord_t xSlot;
+    const DHCPLeaseRecord_t * pxSlot = &xSlot;
+    BaseType_t xKind;
+    size_t x;
+    size_t uxTorn = 0U;
+
+    memset( xHaveNewest, 0, sizeof( xHaveNewest ) );
+    uxNextSlot = configDHCP_LEASE_RECORD_COUNT;
+
+    for( x = 0; x < configDHCP_LEASE_RECORD_COUNT; x++ )
+    {
+        if( xDHCPLeaseFlashRead( x, &xSlot ) != pdPASS )
+        {
+            /* A write that was interrupted by a reset. */
+            uxTorn++;
+            continue;
+        }
+
+        if( prvSlotIsErased( pxSlot ) != pdFALSE )
+        {
+            /* The records are written in order, so the first free slot is the
+             * end of the log. */
+            uxNextSlot = x;
+            break;
+        }
+
+        if( pxSlot->ulCRC != prvRecordCRC( pxSlot ) )
+        {
+            uxTorn++;
+            continue;
+        }
+
+        for( xKind = 0; xKind < dhcpleaseKIND_COUNT; xKind++ )
+        {
+            if( ( pxSlot->ulMagic == ulMagics[ xKind ] ) &&
+                ( ( xHaveNewest[ xKind ] == pdFALSE ) || ( pxSlot->ulSequence > xNewest[ xKind ].ulSequence ) ) )
+            {
+                memcpy( &( xNewest[ xKind ] ), pxSlot, sizeof( xNewest[ xKind ] ) );
+                xHaveNewest[ xKind ] = pdTRUE;
+
+                if( pxSlot->ulSequence > ulLastSequence )
+                {
+                    ulLastSequence = pxSlot->ulSequence;
+                }
+            }
+        }
+    }
+
+    if( uxTorn != 0U )
+    {
+        LogWarn( ( "DHCP lease: skipped %u torn records\n", ( unsigned ) uxTorn ) );
+    }
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvLoad( BaseType_t xKind,
+                           void * pvContents,
+                           size_t uxLength )
+{
+    BaseType_t xReturn;
+
+    taskENTER_CRITICAL();
+    {
+        xReturn = ( xHaveNewest[ xKind ] != pdFALSE ) ? pdPASS : pdFAIL;
+
+        if( xReturn == pdPASS )
+        {
+            memcpy( pvContents, &( xNewest[ xKind ].u ), uxLength );
+        }
+    }
+    taskEXIT_CRITICAL();
+
+    return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvSave( BaseType_t xKind,
+                           const void * pvContents,
+                           size_t uxLength )
+{
+    DHCPLeaseRecord_t xRecord;
+    BaseType_t xReturn = pdPASS;
+
+    /* Only the lease task writes xNewest, so it can read it without a
+     * critical section. */
+    if( ( xHaveNewest[ xKind ] == pdFALSE ) || ( memcmp( &( xNewest[ xKind ].u ), pvContents, uxLength ) != 0 ) )
+    {
+        memset( &xRecord, 0, sizeof( xRecord ) );
+        xRecord.ulMagic = ulMagics[ xKind ];
+        xRecord.ulSequence = ++ulLastSequence;
+        memcpy( &( xRecord.u ), pvContents, uxLength );
+        xRecord.ulCRC = prvRecordCRC( &xRecord );
+
+        if( uxNextSlot < configDHCP_LEASE_RECORD_COUNT )
+        {
+            xReturn = xDHCPLeaseFlashProgram( uxNextSlot, &xRecord );
+
+            /* Never write the same slot twice, also not after a failure. */
+            uxNextSlot++;
+        }
+        else if( xEraseNeeded == pdFALSE )
+        {
+            /* The records are saved when the network comes up, and an erase
+             * would stall the board for seconds right then.  Keep the record
+             * in RAM, prvWriteRecords() erases the sector later. */
+            LogInfo( ( "DHCP lease: the flash sector is full, erasing it in %u ms\n", ( unsigned ) configDHCP_LEASE_ERASE_DELAY_MS ) );
+            xEraseNeeded = pdTRUE;
+        }
+
+        if( xReturn == pdPASS )
+        {
+            taskENTER_CRITICAL();
+            {
+                memcpy( &( xNewest[ xKind ] ), &xRecord, sizeof( xNewest[ xKind ] ) );
+                xHaveNewest[ xKind ] = pdTRUE;
+            }
+            taskEXIT_CRITICAL();
+        }
+        else
+        {
+            LogError( ( "DHCP lease: writing the flash failed\n" ) );
+        }
+    }
+
+    return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+static void prvCompact( void )
+{
+    BaseType_t xKind;
+    BaseType_t xReturn;
+
+    FreeRTOS_printf( ( "DHCP lease: erasing the flash sector\n" ) );
+    xEraseNeeded = pdFALSE;
+    xReturn = xDHCPLeaseFlashErase();
+
+    if( xReturn == pdPASS )
+    {
+        uxNextSlot = 0U;
+
+        for( xKind = 0; ( xKind < dhcpleaseKIND_COUNT ) && ( xReturn == pdPASS ); xKind++ )
+        {
+            if( xHaveNewest[ xKind ] != pdFALSE )
+            {
+                xReturn = xDHCPLeaseFlashProgram( uxNextSlot, &( xNewest[ xKind ] ) );
+                uxNextSlot++;
+            }
+        }
+    }
+
+    /* After a failed erase the sector stays full, the next save tries
+     * again. */
+    if( xReturn != pdPASS )
+    {
+        LogError( ( "DHCP lease: erasing the flash failed\n" ) );
+    }
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvQueue( BaseType_t xKind,
+                            const void * pvContents,
+                            size_t uxLength )
+{
+    BaseType_t xReturn = pdFAIL;
+
+    if( xLeaseTask != NULL )
+    {
+        taskENTER_CRITICAL();
+        {
+            memcpy( &( xPending[ xKind ].u ), pvContents, uxLength );
+            xHavePending[ xKind ] = pdTRUE;
+        }
+        taskEXIT_CRITICAL();
+
+        xTaskNotifyGive( xLeaseTask );
+        xReturn = pdPASS;
+    }
+
+    return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+static void prvWriteRecords( void )
+{
+    DHCPLeaseRecord_t xRecord;
+    TickType_t xWait = portMAX_DELAY;
+    BaseType_t xHave;
+    BaseType_t xKind;
+
+    if( xEraseNeeded != pdFALSE )
+    {
+        xWait = pdMS_TO_TICKS( configDHCP_LEASE_ERASE_DELAY_MS );
+    }
+
+    if( ulTaskNotifyTake( pdTRUE, xWait ) == 0U )
+    {
+        /* Nothing was saved for configDHCP_LEASE_ERASE_DELAY_MS, so the
+         * network is settled. */
+        prvCompact();
+    }
+    else
+    {
+        for( xKind = 0; xKind < dhcpleaseKIND_COUNT; xKind++ )
+        {
+            taskENTER_CRITICAL();
+            {
+                xHave = xHavePending[ xKind ];
+                memcpy( &xRecord, &( xPending[ xKind ] ), sizeof( xRecord ) );
+                xHavePending[ xKind ] = pdFALSE;
+            }
+            taskEXIT_CRITICAL();
+
+            if( xHave != pdFALSE )
+            {
+                ( void ) prvSave( xKind, &( xRecord.u ), uxLengths[ xKind ] );
+            }
+        }
+    }
+}
+/*-----------------------------------------------------------*/
+
+static void prvLeaseTask( void * pvParameters )
+{
+    /* Disable unused parameter warning. */
+    ( void ) pvParameters;
+
+    for( ; ; )
+    {
+        prvWriteRecords();
+    }
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xDHCPLeaseInitialise( void )
+{
+    configASSERT( sizeof( DHCPLeaseRecord_t ) == dhcpleaseFLASH_WORD_SIZE );
+
+    prvScan();
+
+    return xTaskCreate( prvLeaseTask, "Lease", configDHCP_LEASE_TASK_STACK_SIZE, NULL, configDHCP_LEASE_TASK_PRIORITY, &xLeaseTask );
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xDHCPLeaseLoad( DHCPLease_t * pxLease )
+{
+    return prvLoad( dhcpleaseKIND_DHCP, pxLease, sizeof( *pxLease ) );
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xDHCPLeaseSave( const DHCPLease_t * pxLease )
+{
+    return prvQueue( dhcpleaseKIND_DHCP, pxLease, sizeof( *pxLease ) );
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xDHCPLeaseApply( NetworkEndPoint_t * pxEndPoint )
+{
+    DHCPLease_t xLease;
+    BaseType_t xReturn;
+
+    xReturn = xDHCPLeaseLoad( &xLease );
+
+    if( xReturn == pdPASS )
+    {
+        pxEndPoint->ipv4_defaults.ulIPAddress = xLease.ulIPAddress;
+        pxEndPoint->ipv4_defaults.ulNetMask = xLease.ulNetMask;
+        pxEndPoint->ipv4_defaults.ulGatewayAddress = xLease.ulGatewayAddress;
+        pxEndPoint->ipv4_defaults.ulDNSServerAddresses[ 0 ] = xLease.ulDNSServerAddress;
+        pxEndPoint->ipv4_defaults.ulBroadcastAddress = xLease.ulIPAddress | ~xLease.ulNetMask;
+        memcpy( &( pxEndPoint->ipv4_settings ), &( pxEndPoint->ipv4_defaults ), sizeof( pxEndPoint->ipv4_settings ) );
+
+        FreeRTOS_printf( ( "DHCP lease: reusing %xip\n", ( unsigned ) FreeRTOS_ntohl( xLease.ulIPAddress ) ) );
+    }
+
+    return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+void vDHCPLeaseEndPointUp( NetworkEndPoint_t * pxEndPoint )
+{
+    DHCPLease_t xLease;
+
+    /* Only store addresses that a server handed out, not the defaults that
+     * are used after DHCP failed. */
+    if( ( pxEndPoint->bits.bIPv6 == pdFALSE_UNSIGNED ) &&
+        ( pxEndPoint->bits.bWantDHCP != pdFALSE_UNSIGNED ) &&
+        ( pxEndPoint->xDHCPData.eDHCPState == eLeasedAddress ) )
+    {
+        memset( &xLease, 0, sizeof( xLease ) );
+        xLease.ulIPAddress = pxEndPoint->ipv4_settings.ulIPAddress;
+        xLease.ulNetMask = pxEndPoint->ipv4_settings.ulNetMask;
+        xLease.ulGatewayAddress = pxEndPoint->ipv4_settings.ulGatewayAddress;
+        xLease.ulDNSServerAddress = pxEndPoint->ipv4_settings.ulDNSServerAddresses[ 0 ];
+        xLease.ulLeaseSeconds = pxEndPoint->xDHCPData.ulLeaseTime / configTICK_RATE_HZ;
+
+        ( void ) xDHCPLeaseSave( &xLease );
+    }
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xRALeaseLoad( RALease_t * pxLease )
+{
+    return prvLoad( dhcpleaseKIND_RA, pxLease, sizeof( *pxLease ) );
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xRALeaseSave( const RALease_t * pxLease )
+{
+    return prvQueue( dhcpleaseKIND_RA, pxLease, sizeof( *pxLease ) );
+}
+/*-----------------------------------------------------------*/
+
+#if ( ipconfigUSE_IPv6 != 0 )
+
+    BaseType_t xRALeaseApply( NetworkEndPoint_t * pxEndPoint )
+    {
+        RALease_t xLease;
+        IPV6Parameters_t * pxDefaults = &( pxEndPoint->ipv6_defaults );
+        BaseType_t xReturn;
+
+        xReturn = xRALeaseLoad( &xLease );
+
+        if( xReturn == pdPASS )
+        {
+            memset( pxDefaults->xPrefix.ucBytes, 0, sizeof( pxDefaults->xPrefix.ucBytes ) );
+            memcpy( pxDefaults->xPrefix.ucBytes, xLease.ucPrefix, sizeof( xLease.ucPrefix ) );
+            pxDefaults->uxPrefixLength = ( size_t ) xLease.ulPrefixLength;
+
+            /* Keep the interface identifier, replace the prefix. */
+            memcpy( pxDefaults->xIPAddress.ucBytes, xLease.ucPrefix, sizeof( xLease.ucPrefix ) );
+
+            memset( pxDefaults->xGatewayAddress.ucBytes, 0, sizeof( pxDefaults->xGatewayAddress.ucBytes ) );
+            pxDefaults->xGatewayAddress.ucBytes[ 0 ] = 0xFEU;
+            pxDefaults->xGatewayAddress.ucBytes[ 1 ] = 0x80U;
+            memcpy( &( pxDefaults->xGatewayAddress.ucBytes[ 8 ] ), xLease.ucGatewayIID, sizeof( xLease.ucGatewayIID ) );
+
+            memcpy( &( pxEndPoint->ipv6_settings ), pxDefaults, sizeof( pxEndPoint->ipv6_settings ) );
+
+            FreeRTOS_printf( ( "RA lease: reusing %pip\n", pxDefaults->xIPAddress.ucBytes ) );
+        }
+
+        return xReturn;
+    }
+    /*-----------------------------------------------------------*/
+
+    void vRALeaseEndPointUp( NetworkEndPoint_t * pxEndPoint )
+    {
+        static const uint8_t ucLinkLocal[ 8 ] = { 0xFEU, 0x80U, 0U, 0U, 0U, 0U, 0U, 0U };
+        const IPV6Parameters_t * pxSettings = &( pxEndPoint->ipv6_settings );
+        RALease_t xLease;
+
+        /* A router advertises from its link-local address, and SLAAC only
+         * works with prefixes of at most 64 bits. */
+        if( ( pxEndPoint->bits.bIPv6 != pdFALSE_UNSIGNED ) &&
+            ( pxEndPoint->bits.bWantRA != pdFALSE_UNSIGNED ) &&
+            ( pxSettings->uxPrefixLength > 0U ) &&
+            ( pxSettings->uxPrefixLength <= 64U ) &&
+            ( memcmp( pxSettings->xGatewayAddress.ucBytes, ucLinkLocal, sizeof( ucLinkLocal ) ) == 0 ) )
+        {
+            memset( &xLease, 0, sizeof( xLease ) );
+            memcpy( xLease.ucPrefix, pxSettings->xPrefix.ucBytes, sizeof( xLease.ucPrefix ) );
+            memcpy( xLease.ucGatewayIID, &( pxSettings->xGatewayAddress.ucBytes[ 8 ] ), sizeof( xLease.ucGatewayIID ) );
+            xLease.ulPrefixLength = ( uint32_t ) pxSettings->uxPrefixLength;
+
+            ( void ) xRALeaseSave( &xLease );
+        }
+    }
+    /*-----------------------------------------------------------*/
+
+#endif /* ( ipconfigUSE_IPv6 != 0 ) */
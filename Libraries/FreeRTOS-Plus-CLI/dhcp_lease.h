@@ -0,0 +1,160 @@
+#ifndef DHCP_LEASE_H
+#define DHCP_LEASE_H
+
+/* FreeRTOS+TCP includes. */
+#include "FreeRTOS_IP.h"
+#include "FreeRTOS_Routing.h"
+
+/*
+ * Keep the last DHCP lease, and the last prefix and gateway learned from a
+ * Router Advertisement, in flash, so that a reset does not have to start from
+ * scratch.
+ *
+ * At boot the cached lease becomes the default configuration of the DHCP
+ * end-point, and the DHCP hook asks the server for the same address again
+ * (the "requested IP address" option), which most servers ACK at once.  When
+ * no server answers, the stack falls back to the defaults, i.e. to the cached
+ * lease instead of the hard-coded address.  The same goes for the IPv6
+ * end-point that waits for a Router Advertisement.
+ *
+ * The last flash sector is reserved for the records (see the linker script).
+ * Each record is one 256-bit flash word, and new records are appended after
+ * the previous one.  A record is only written when its contents changed, so
+ * the flash endurance is not a concern.  The flash itself is accessed through
+ * dhcp_lease_flash.h.
+ *
+ * The flash is written by a task of its own, at a low priority: the save
+ * functions, and so the network event hook in the IP-task, only hand the
+ * record over.  Note that a write still stalls every read of the same bank,
+ * including instruction fetches, for up to 100 us.
+ *
+ * Erasing the 128 KB sector stalls them for about 2 seconds, and the H723 has
+ * one bank only, so the interrupts of ETH and TIM6 wait as well.  The records
+ * are saved while the network comes up, so the sector is never erased then:
+ * when all its 4096 slots are used, a new record is only kept in RAM, and the
+ * sector is erased, and the newest record of each kind written back, once no
+ * record was saved for configDHCP_LEASE_ERASE_DELAY_MS.  A reset before that
+ * loses the records that were kept in RAM.
+ *
+ * A flash word that was torn by a reset usually has a double ECC error, and
+ * reading it raises a bus fault instead of returning wrong data.  So the scan
+ * reads each slot with bus faults ignored, and skips a slot when the read set
+ * the DBECCERR flag of FLASH_SR1.  A torn record that can be read fails its
+ * CRC and is skipped as well.  Both are never written again, new records go
+ * after the last used slot.
+ */
+
+/* The sector that holds the records, it must not be used for code. */
+#ifndef configDHCP_LEASE_FLASH_SECTOR
+    #define configDHCP_LEASE_FLASH_SECTOR     FLASH_SECTOR_7
+#endif
+
+#ifndef configDHCP_LEASE_FLASH_ADDRESS
+    #define configDHCP_LEASE_FLASH_ADDRESS    ( FLASH_BANK1_BASE + ( configDHCP_LEASE_FLASH_SECTOR * FLASH_SECTOR_SIZE ) )
+#endif
+
+/* How long the network must be quiet, i.e. no record was saved, before the
+ * full sector is erased. */
+#ifndef configDHCP_LEASE_ERASE_DELAY_MS
+    #define configDHCP_LEASE_ERASE_DELAY_MS    60000U
+#endif
+
+/* Stack size (in words) and priority of the task that writes the flash. */
+#ifndef configDHCP_LEASE_TASK_STACK_SIZE
+    #define configDHCP_LEASE_TASK_STACK_SIZE    256
+#endif
+
+#ifndef configDHCP_LEASE_TASK_PRIORITY
+    #define configDHCP_LEASE_TASK_PRIORITY      ( tskIDLE_PRIORITY + 1 )
+#endif
+
+/* All addresses in network byte order. */
+typedef struct xDHCP_LEASE
+{
+    uint32_t ulIPAddress;
+    uint32_t ulNetMask;
+    uint32_t ulGatewayAddress;
+    uint32_t ulDNSServerAddress;
+    uint32_t ulLeaseSeconds; /* The lease time as granted, there is no clock to keep the expiry. */
+} DHCPLease_t;
+
+/* A /64 (or shorter) prefix and the link-local address of its router.  It
+ * has the same size as a DHCPLease_t, so that both fit in a flash word. */
+typedef struct xRA_LEASE
+{
+    uint8_t ucPrefix[ 8 ];      /* The first 64 bits of the prefix. */
+    uint8_t ucGatewayIID[ 8 ];  /* The gateway is fe80::<ucGatewayIID>. */
+    uint32_t ulPrefixLength;
+} RALease_t;
+
+/**
+ * @brief Scan the flash for the stored records and create the task that
+ * writes new ones.  Call it before the end-points are configured.
+ *
+ * @return pdPASS if the task was created.
+ */
+BaseType_t xDHCPLeaseInitialise( void );
+
+/**
+ * @brief Get the lease that was stored last, a copy of what
+ * xDHCPLeaseInitialise() found in flash or of what was saved since.
+ *
+ * @return pdPASS if a valid lease was found, pdFAIL otherwise.
+ */
+BaseType_t xDHCPLeaseLoad( DHCPLease_t * pxLease );
+
+/**
+ * @brief Store a lease, unless it equals the one stored last.  Returns at
+ * once, the lease task writes the flash later, or keeps the lease in RAM
+ * until the full sector can be erased.  Only the newest lease waiting to be
+ * written is kept.
+ *
+ * @return pdPASS if the lease was handed to the lease task.
+ */
+BaseType_t xDHCPLeaseSave( const DHCPLease_t * pxLease );
+
+/**
+ * @brief Use the stored lease as the default configuration of an IPv4 end-point.
+ * Call it after FreeRTOS_FillEndPoint().
+ *
+ * @return pdPASS if a stored lease was applied.
+ */
+BaseType_t xDHCPLeaseApply( NetworkEndPoint_t * pxEndPoint );
+
+/**
+ * @brief Store the lease of an end-point that just came up, when it was
+ * obtained from a DHCP server.  Call it from the network event hook.
+ */
+void vDHCPLeaseEndPointUp( NetworkEndPoint_t * pxEndPoint );
+
+/**
+ * @brief Get the prefix and gateway that were stored last.
+ *
+ * @return pdPASS if a valid record was found, pdFAIL otherwise.
+ */
+BaseType_t xRALeaseLoad( RALease_t * pxLease );
+
+/**
+ * @brief Store a prefix and gateway, unless they equal the ones stored last.
+ * Returns at once, like xDHCPLeaseSave().
+ *
+ * @return pdPASS if the record was handed to the lease task.
+ */
+BaseType_t xRALeaseSave( const RALease_t * pxLease );
+
+/**
+ * @brief Use the stored prefix and gateway as the default configuration of an
+ * IPv6 end-point, keeping the interface identifier of its address.  Call it
+ * after FreeRTOS_FillEndPoint_IPv6().
+ *
+ * @return pdPASS if a stored record was applied.
+ */
+BaseType_t xRALeaseApply( NetworkEndPoint_t * pxEndPoint );
+
+/**
+ * @brief Store the prefix and gateway of an IPv6 end-point that just came up
+ * with Router Advertisement.  Call it from the network event hook.
+ */
+void vRALeaseEndPointUp( NetworkEndPoint_t * pxEndPoint );
+
+#endif /* #ifndef DHCP_LEASE_H */
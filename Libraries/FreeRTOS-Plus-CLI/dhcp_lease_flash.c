@@ -0,0 +1,100 @@
+/* Standard includes. */
+#include <string.h>
+
+/* FreeRTOS includes. */
+#include "FreeRTOS.h"
+
+/* FreeRTOS+TCP includes. */
+#include "FreeRTOS_IP.h"
+#include "FreeRTOS_Routing.h"
+
+/* ST includes. */
+#include "stm32h7xx_hal.h"
+
+#include "dhcp_lease.h"
+#include "dhcp_lease_flash.h"
+
+#define prvSLOT( uxSlot )    ( configDHCP_LEASE_FLASH_ADDRESS + ( ( uxSlot ) * dhcpleaseFLASH_WORD_SIZE ) )
+
+/*-----------------------------------------------------------*/
+
+BaseType_t xDHCPLeaseFlashRead( size_t uxSlot,
+                                void * pvWord )
+{
+    uint32_t ulFaultMask = __get_FAULTMASK();
+    BaseType_t xReturn = pdPASS;
+
+    __HAL_FLASH_CLEAR_FLAG_BANK1( FLASH_FLAG_SNECCERR_BANK1 | FLASH_FLAG_DBECCERR_BANK1 );
+
+    /* With FAULTMASK set and BFHFNMIGN, a bus fault of the read is ignored and
+     * the read returns garbage, the ECC flag tells that it happened. */
+    SCB->CCR |= SCB_CCR_BFHFNMIGN_Msk;
+    __DSB();
+    __ISB();
+    __set_FAULTMASK( 1U );
+
+    memcpy( pvWord, ( const void * ) prvSLOT( uxSlot ), dhcpleaseFLASH_WORD_SIZE );
+    __DSB();
+
+    __set_FAULTMASK( ulFaultMask );
+    SCB->CCR &= ~SCB_CCR_BFHFNMIGN_Msk;
+    __DSB();
+    __ISB();
+
+    if( __HAL_FLASH_GET_FLAG_BANK1( FLASH_FLAG_DBECCERR_BANK1 ) )
+    {
+        __HAL_FLASH_CLEAR_FLAG_BANK1( FLASH_FLAG_DBECCERR_BANK1 );
+        xReturn = pdFAIL;
+    }
+
+    return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xDHCPLeaseFlashProgram( size_t uxSlot,
+                                   const void * pvWord )
+{
+    HAL_StatusTypeDef xStatus;
+
+    HAL_FLASH_Unlock();
+    xStatus = HAL_FLASH_Program( FLASH_TYPEPROGRAM_FLASHWORD,
+                                 ( uint32_t ) prvSLOT( uxSlot ),
+                                 ( uint32_t ) pvWord );
+    HAL_FLASH_Lock();
+
+    /* Read it back, the sector may have been worn out. */
+    if( ( xStatus == HAL_OK ) && ( memcmp( ( const void * ) prvSLOT( uxSlot ), pvWord, dhcpleaseFLASH_WORD_SIZE ) != 0 ) )
+    {
+        xStatus = HAL_ERROR;
+    }
+
+    return ( xStatus == HAL_OK ) ? pdPASS : pdFAIL;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xDHCPLeaseFlashErase( void )
+{
+    FLASH_EraseInitTypeDef xErase;
+    uint32_t ulSectorError = 0U;
+    HAL_StatusTypeDef xStatus;
+
+    xErase.TypeErase = FLASH_TYPEERASE_SECTORS;
+    xErase.Banks = FLASH_BANK_1;
+    xErase.Sector = configDHCP_LEASE_FLASH_SECTOR;
+    xErase.NbSectors = 1U;
+    xErase.VoltageRange = FLASH_VOLTAGE_RANGE_3;
+
+    /* The H723 has a single bank, which also holds the code and the vector
+     * table.  Erasing a 128 KB sector takes about 2 seconds (tERASE128KB, up
+     * to 4), and every fetch from the bank waits for it: this task, but also
+     * the ETH and TIM6 interrupts, so received frames are lost once the DMA
+     * descriptors are used up, and the tick falls behind.  That is why
+     * dhcp_lease.c only erases long after the network came up, see
+     * configDHCP_LEASE_ERASE_DELAY_MS. */
+    HAL_FLASH_Unlock();
+    xStatus = HAL_FLASHEx_Erase( &xErase, &ulSectorError );
+    HAL_FLASH_Lock();
+
+    return ( xStatus == HAL_OK ) ? pdPASS : pdFAIL;
+}
+/*-----------------------------------------------------------*/
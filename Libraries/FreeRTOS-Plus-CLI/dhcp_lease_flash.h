@@ -0,0 +1,50 @@
+#ifndef DHCP_LEASE_FLASH_H
+#define DHCP_LEASE_FLASH_H
+
+/* FreeRTOS includes. */
+#include "FreeRTOS.h"
+
+/*
+ * The flash sector of dhcp_lease.c.  dhcp_lease_flash.c implements it with
+ * the HAL of the STM32H7, the host tests with a flash emulator.
+ *
+ * The sector is divided in slots of one flash word each.  A slot can only be
+ * programmed once after an erase, and an erase clears the whole sector to
+ * 0xFF bytes.
+ */
+
+/* The size of a flash word, which holds one record. */
+#define dhcpleaseFLASH_WORD_SIZE    32U
+
+/* The number of slots in the sector. */
+#ifndef configDHCP_LEASE_RECORD_COUNT
+    #define configDHCP_LEASE_RECORD_COUNT    ( FLASH_SECTOR_SIZE / dhcpleaseFLASH_WORD_SIZE )
+#endif
+
+/**
+ * @brief Copy a slot to RAM.
+ *
+ * @return pdFAIL when the slot has an ECC error, i.e. it was torn by a reset
+ * while being programmed.
+ */
+BaseType_t xDHCPLeaseFlashRead( size_t uxSlot,
+                                void * pvWord );
+
+/**
+ * @brief Program an erased slot with dhcpleaseFLASH_WORD_SIZE bytes, and read
+ * it back.
+ *
+ * @return pdPASS if the slot holds the data.
+ */
+BaseType_t xDHCPLeaseFlashProgram( size_t uxSlot,
+                                   const void * pvWord );
+
+/**
+ * @brief Erase the sector.  This stalls the CPU for seconds, see
+ * dhcp_lease_flash.c.
+ *
+ * @return pdPASS if the sector was erased.
+ */
+BaseType_t xDHCPLeaseFlashErase( void );
+
+#endif /* #ifndef DHCP_LEASE_FLASH_H */
@@ -0,0 +1,360 @@
+/* The log messages of this file, see log_levels.h. */
+#define logMODULE    eLogModuleApp
+
+/* Standard includes. */
+#include <string.h>
+
+/* FreeRTOS includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+#include "timers.h"
+
+/* FreeRTOS+TCP includes. */
+#include "FreeRTOS_IP.h"
+
+/* ST includes. */
+#include "stm32h7xx_hal.h"
+
+#include "entropy_pool.h"
+
+#if ( ( configENTROPY_POOL_WORDS & ( configENTROPY_POOL_WORDS - 1 ) ) != 0 )
+    #error configENTROPY_POOL_WORDS must be a power of 2
+#endif
+
+/* Stop restarting the RNG after this many errors in a row. */
+#define entropyMAX_CONSECUTIVE_ERRORS    8U
+
+#define entropyROTL( x, b )    ( uint32_t ) ( ( ( x ) << ( b ) ) | ( ( x ) >> ( 32 - ( b ) ) ) )
+
+#define entropyQUARTERROUND( a, b, c, d )                    \
+    do {                                                     \
+        a += b; d ^= a; d = entropyROTL( d, 16 );            \
+        c += d; b ^= c; b = entropyROTL( b, 12 );            \
+        a += b; d ^= a; d = entropyROTL( d, 8 );             \
+        c += d; b ^= c; b = entropyROTL( b, 7 );             \
+    } while( 0 )
+
+/*
+ * One ChaCha20 block with the current key, nonce 0.
+ */
+static void prvChaChaBlock( uint32_t * pulOutput );
+
+/*
+ * Generate the next 8 words of output, and replace the key.  Called in a
+ * critical section.
+ */
+static void prvNextBlock( void );
+
+/*
+ * Let the RNG produce the next word, unless the pool is full or the RNG is
+ * busy or broken.  Called from the RNG interrupt or in a critical section.
+ */
+static void prvKick( void );
+
+/*
+ * Recover from an RNG error, runs in the timer task.
+ */
+static void prvRecover( void * pvParameter1,
+                        uint32_t ulParameter2 );
+
+/*-----------------------------------------------------------*/
+
+extern RNG_HandleTypeDef hrng;
+
+/* Raw words from the RNG, written by the interrupt, read by tasks. */
+static uint32_t ulPool[ configENTROPY_POOL_WORDS ];
+static volatile uint32_t ulPoolHead = 0U;
+static volatile uint32_t ulPoolTail = 0U;
+
+/* The DRBG. */
+static uint32_t ulKey[ 8 ];
+static uint32_t ulBlockCounter = 0U;
+static uint32_t ulOutput[ 8 ];
+static size_t uxOutputOffset = sizeof( ulOutput ); /* Bytes of ulOutput used. */
+static uint32_t ulBlocksSinceReseed = 0U;
+static BaseType_t xSeeded = pdFALSE;
+
+static volatile BaseType_t xRNGBusy = pdFALSE;
+static volatile BaseType_t xRecovering = pdFALSE;
+static volatile uint32_t ulConsecutiveErrors = 0U;
+
+static EntropyPoolStats_t xStats;
+
+/*-----------------------------------------------------------*/
+
+static void prvChaChaBlock( uint32_t * pulOutput )
+{
+    uint32_t ulState[ 16 ];
+    BaseType_t x;
+
+    /* "expand 32-byte k" */
+    ulState[ 0 ] = 0x61707865UL;
+    ulState[ 1 ] = 0x3320646EUL;
+    ulState[ 2 ] = 0x79622D32UL;
+    ulState[ 3 ] = 0x6B206574UL;
+    memcpy( &( ulState[ 4 ] ), ulKey, sizeof( ulKey ) );
+    ulState[ 12 ] = ulBlockCounter;
+    ulState[ 13 ] = 0U;
+    ulState[ 14 ] = 0U;
+    ulState[ 15 ] = 0U;
+
+    memcpy( pulOutput, ulState, sizeof( ulState ) );
+
+    for( x = 0; x < 10; x++ )
+    {
+        entropyQUARTERROUND( pulOutput[ 0 ], pulOutput[ 4 ], pulOutput[ 8 ], pulOutput[ 12 ] );
+        entropyQUARTERROUND( pulOutput[ 1 ], pulOutput[ 5 ], pulOutput[ 9 ], pulOutput[ 13 ] );
+        entropyQUARTERROUND( pulOutput[ 2 ], pulOutput[ 6 ], pulOutput[ 10 ], pulOutput[ 14 ] );
+        entropyQUARTERROUND( pulOutput[ 3 ], pulOutput[ 7 ], pulOutput[ 11 ], pulOutput[ 15 ] );
+        entropyQUARTERROUND( pulOutput[ 0 ], pulOutput[ 5 ], pulOutput[ 10 ], pulOutput[ 15 ] );
+        entropyQUARTERROUND( pulOutput[ 1 ], pulOutput[ 6 ], pulOutput[ 11 ], pulOutput[ 12 ] );
+        entropyQUARTERROUND( pulOutput[ 2 ], pulOutput[ 7 ], pulOutput[ 8 ], pulOutput[ 13 ] );
+        entropyQUARTERROUND( pulOutput[ 3 ], pulOutput[ 4 ], pulOutput[ 9 ], pulOutput[ 14 ] );
+    }
+
+    for( x = 0; x < 16; x++ )
+    {
+        pulOutput[ x ] += ulState[ x ];
+    }
+}
+/*-----------------------------------------------------------*/
+
+static void prvNextBlock( void )
+{
+    uint32_t ulBlock[ 16 ];
+    BaseType_t x;
+
+    if( ( ulBlocksSinceReseed >= configENTROPY_RESEED_BLOCKS ) &&
+        ( ( ulPoolHead - ulPoolTail ) >= 8U ) )
+    {
+        for( x = 0; x < 8; x++ )
+        {
+            ulKey[ x ] ^= ulPool[ ulPoolTail & ( configENTROPY_POOL_WORDS - 1U ) ];
+            ulPoolTail++;
+        }
+
+        ulBlocksSinceReseed = 0U;
+        xStats.ulReseeds++;
+        prvKick();
+    }
+
+    prvChaChaBlock( ulBlock );
+    ulBlockCounter++;
+    ulBlocksSinceReseed++;
+    xStats.ulBlocks++;
+
+    /* Fast key erasure: the first half of the block becomes the next key, so
+     * earlier output cannot be reconstructed from the state. */
+    memcpy( ulKey, &( ulBlock[ 0 ] ), sizeof( ulKey ) );
+    memcpy( ulOutput, &( ulBlock[ 8 ] ), sizeof( ulOutput ) );
+    uxOutputOffset = 0U;
+
+    memset( ulBlock, 0, sizeof( ulBlock ) );
+}
+/*-----------------------------------------------------------*/
+
+static void prvKick( void )
+{
+    if( ( xRNGBusy == pdFALSE ) &&
+        ( xRecovering == pdFALSE ) &&
+        ( ulConsecutiveErrors < entropyMAX_CONSECUTIVE_ERRORS ) &&
+        ( ( ulPoolHead - ulPoolTail ) < configENTROPY_POOL_WORDS ) )
+    {
+        xRNGBusy = pdTRUE;
+
+        if( HAL_RNG_GenerateRandomNumber_IT( &hrng ) != HAL_OK )
+        {
+            xRNGBusy = pdFALSE;
+        }
+    }
+}
+/*-----------------------------------------------------------*/
+
+void HAL_RNG_ReadyDataCallback( RNG_HandleTypeDef * pxRNG,
+                                uint32_t ulRandom32bit )
+{
+    ( void ) pxRNG;
+
+    xRNGBusy = pdFALSE;
+    ulConsecutiveErrors = 0U;
+
+    if( ( ulPoolHead - ulPoolTail ) < configENTROPY_POOL_WORDS )
+    {
+        ulPool[ ulPoolHead & ( configENTROPY_POOL_WORDS - 1U ) ] = ulRandom32bit;
+        ulPoolHead++;
+        xStats.ulRawWords++;
+    }
+
+    prvKick();
+}
+/*-----------------------------------------------------------*/
+
+void HAL_RNG_ErrorCallback( RNG_HandleTypeDef * pxRNG )
+{
+    BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+
+    xRNGBusy = pdFALSE;
+    ulConsecutiveErrors++;
+
+    if( ( pxRNG->ErrorCode & HAL_RNG_ERROR_SEED ) != 0U )
+    {
+        xStats.ulSeedErrors++;
+    }
+    else
+    {
+        xStats.ulClockErrors++;
+    }
+
+    /* HAL_RNGEx_RecoverSeedError() calls this function as well when it fails,
+     * but then a recovery is already running. */
+    if( xRecovering == pdFALSE )
+    {
+        xRecovering = pdTRUE;
+
+        if( xTimerPendFunctionCallFromISR( prvRecover, NULL, 0U, &xHigherPriorityTaskWoken ) != pdPASS )
+        {
+            xRecovering = pdFALSE;
+        }
+
+        portYIELD_FROM_ISR( xHigherPriorityTaskWoken );
+    }
+}
+/*-----------------------------------------------------------*/
+
+static void prvRecover( void * pvParameter1,
+                        uint32_t ulParameter2 )
+{
+    ( void ) pvParameter1;
+    ( void ) ulParameter2;
+
+    /* The interrupt handler left the handle in the error state, and locked. */
+    hrng.State = HAL_RNG_STATE_READY;
+    __HAL_UNLOCK( &hrng );
+
+    if( ( hrng.ErrorCode & HAL_RNG_ERROR_SEED ) != 0U )
+    {
+        ( void ) HAL_RNGEx_RecoverSeedError( &hrng );
+    }
+
+    /* A clock error only has to be cleared, which the handler did. */
+    hrng.State = HAL_RNG_STATE_READY;
+    hrng.ErrorCode = HAL_RNG_ERROR_NONE;
+    __HAL_UNLOCK( &hrng );
+
+    if( ulConsecutiveErrors >= entropyMAX_CONSECUTIVE_ERRORS )
+    {
+        LogError( ( "Entropy pool: the RNG keeps failing, giving up\n" ) );
+    }
+
+    taskENTER_CRITICAL();
+    {
+        xRecovering = pdFALSE;
+        prvKick();
+    }
+    taskEXIT_CRITICAL();
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xEntropyPoolInitialise( void )
+{
+    BaseType_t x;
+
+    /* The seed is read by polling, so it is there before the first caller. */
+    for( x = 0; x < 8; x++ )
+    {
+        if( HAL_RNG_GenerateRandomNumber( &hrng, &( ulKey[ x ] ) ) != HAL_OK )
+        {
+            break;
+        }
+    }
+
+    if( x == 8 )
+    {
+        xSeeded = pdTRUE;
+    }
+
+    /* The pool fills as soon as the scheduler runs. */
+    taskENTER_CRITICAL();
+    {
+        prvKick();
+    }
+    taskEXIT_CRITICAL();
+
+    return xSeeded;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xEntropyPoolGetRaw( uint32_t * pulValue )
+{
+    BaseType_t xReturn = pdFAIL;
+
+    taskENTER_CRITICAL();
+    {
+        if( ulPoolHead != ulPoolTail )
+        {
+            *pulValue = ulPool[ ulPoolTail & ( configENTROPY_POOL_WORDS - 1U ) ];
+            ulPoolTail++;
+            xReturn = pdPASS;
+            prvKick();
+        }
+    }
+    taskEXIT_CRITICAL();
+
+    return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xEntropyPoolRandom( void * pvBuffer,
+                               size_t uxLength )
+{
+    uint8_t * pucBuffer = ( uint8_t * ) pvBuffer;
+    size_t uxCount;
+
+    if( xSeeded == pdFALSE )
+    {
+        return pdFAIL;
+    }
+
+    while( uxLength > 0U )
+    {
+        /* One block at a time, to keep the critical sections short. */
+        taskENTER_CRITICAL();
+        {
+            if( uxOutputOffset >= sizeof( ulOutput ) )
+            {
+                prvNextBlock();
+            }
+
+            uxCount = sizeof( ulOutput ) - uxOutputOffset;
+
+            if( uxCount > uxLength )
+            {
+                uxCount = uxLength;
+            }
+
+            memcpy( pucBuffer, &( ( ( uint8_t * ) ulOutput )[ uxOutputOffset ] ), uxCount );
+
+            /* Output is never handed out twice. */
+            memset( &( ( ( uint8_t * ) ulOutput )[ uxOutputOffset ] ), 0, uxCount );
+            uxOutputOffset += uxCount;
+        }
+        taskEXIT_CRITICAL();
+
+        pucBuffer += uxCount;
+        uxLength -= uxCount;
+    }
+
+    return pdPASS;
+}
+/*-----------------------------------------------------------*/
+
+void vEntropyPoolGetStats( EntropyPoolStats_t * pxStats )
+{
+    taskENTER_CRITICAL();
+    {
+        memcpy( pxStats, &xStats, sizeof( *pxStats ) );
+        pxStats->uxPoolWords = ( UBaseType_t ) ( ulPoolHead - ulPoolTail );
+    }
+    taskEXIT_CRITICAL();
+}
+/*-----------------------------------------------------------*/
@@ -0,0 +1,71 @@
+#ifndef ENTROPY_POOL_H
+#define ENTROPY_POOL_H
+
+/* FreeRTOS includes. */
+#include "FreeRTOS.h"
+
+/*
+ * Random numbers without waiting for the RNG peripheral.
+ *
+ * The RNG fills a pool of raw words in the background, one interrupt per
+ * word, until the pool is full.  On top of it runs a ChaCha20 DRBG with fast
+ * key erasure: every block of output also replaces the key, and fresh words
+ * from the pool are mixed into the key every configENTROPY_RESEED_BLOCKS
+ * blocks.  So xEntropyPoolRandom() costs a copy from a buffer most of the
+ * time, and one ChaCha20 block every 8 words.
+ *
+ * A seed error of the RNG is recovered with HAL_RNGEx_RecoverSeedError() from
+ * the timer task, a clock error only needs a restart.  While the RNG is
+ * broken the DRBG keeps running on its last key.
+ */
+
+/* Number of raw 32-bit words kept in the pool, must be a power of 2. */
+#ifndef configENTROPY_POOL_WORDS
+    #define configENTROPY_POOL_WORDS       32
+#endif
+
+/* Number of DRBG blocks between two reseeds from the pool. */
+#ifndef configENTROPY_RESEED_BLOCKS
+    #define configENTROPY_RESEED_BLOCKS    64
+#endif
+
+typedef struct xENTROPY_POOL_STATS
+{
+    uint32_t ulRawWords;      /* Words delivered by the RNG. */
+    uint32_t ulBlocks;        /* ChaCha20 blocks generated. */
+    uint32_t ulReseeds;
+    uint32_t ulSeedErrors;
+    uint32_t ulClockErrors;
+    UBaseType_t uxPoolWords;  /* Words in the pool now. */
+} EntropyPoolStats_t;
+
+/**
+ * @brief Seed the DRBG by polling the RNG and start filling the pool.  Must
+ * be called after the RNG was initialised, before the first random number is
+ * needed.
+ *
+ * @return pdPASS if the DRBG was seeded.
+ */
+BaseType_t xEntropyPoolInitialise( void );
+
+/**
+ * @brief Get a raw word from the RNG, for keys.  Never blocks.
+ *
+ * @return pdPASS if a word was available, pdFAIL when the pool is empty.
+ */
+BaseType_t xEntropyPoolGetRaw( uint32_t * pulValue );
+
+/**
+ * @brief Fill a buffer with DRBG output.  Never blocks.
+ *
+ * @return pdPASS, or pdFAIL when xEntropyPoolInitialise() did not succeed.
+ */
+BaseType_t xEntropyPoolRandom( void * pvBuffer,
+                               size_t uxLength );
+
+/**
+ * @brief Get the counters.
+ */
+void vEntropyPoolGetStats( EntropyPoolStats_t * pxStats );
+
+#endif /* #ifndef ENTROPY_POOL_H */
@@ -0,0 +1,1805 @@
+/* The log messages of this file, see log_levels.h. */
+#define logMODULE    eLogModuleIperf
+
+/* Standard includes. */
+#include <string.h>
+
+/* FreeRTOS includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+#include "semphr.h"
+
+/* FreeRTOS+TCP includes. */
+#include "FreeRTOS_IP.h"
+#include "FreeRTOS_Sockets.h"
+
+#include "iperf3.h"
+#include "entropy_pool.h"
+#include "net_stats.h"
+#include "tcp_sendfile.h"
+#include "tcp_rx_batch.h"
+#include "uptime.h"
+
+#if ( USE_IPERF == 1 )
+
+/* The states that are exchanged on the control connection, as in iperf3.
+ * Most are sent by the server, TEST_END, CLIENT_TERMINATE and IPERF_DONE by
+ * the client. */
+#define iperf3TEST_START                  ( ( int8_t ) 1 )
+#define iperf3TEST_RUNNING                ( ( int8_t ) 2 )
+#define iperf3TEST_END                    ( ( int8_t ) 4 )
+#define iperf3PARAM_EXCHANGE              ( ( int8_t ) 9 )
+#define iperf3CREATE_STREAMS              ( ( int8_t ) 10 )
+#define iperf3SERVER_TERMINATE            ( ( int8_t ) 11 )
+#define iperf3CLIENT_TERMINATE            ( ( int8_t ) 12 )
+#define iperf3EXCHANGE_RESULTS            ( ( int8_t ) 13 )
+#define iperf3DISPLAY_RESULTS             ( ( int8_t ) 14 )
+#define iperf3IPERF_DONE                  ( ( int8_t ) 16 )
+#define iperf3ACCESS_DENIED               ( ( int8_t ) -1 )
+
+/* 36 random characters and a NUL, sent first on every connection of a test. */
+#define iperf3COOKIE_SIZE                 37U
+
+/* The first datagram of a UDP stream and the answer to it.  iperf3 sends them
+ * in the byte order of the host, which is little endian on both sides. */
+#define iperf3UDP_CONNECT_MSG             0x36373839UL
+#define iperf3UDP_CONNECT_REPLY           0x39383736UL
+#define iperf3UDP_CONNECT_MSG_LEGACY      123456789UL
+#define iperf3UDP_CONNECT_REPLY_LEGACY    987654321UL
+
+/* A UDP datagram starts with seconds, microseconds and a packet count, in
+ * network byte order.  The count has 64 bits with "udp_counters_64bit". */
+#define iperf3UDP_HEADER_SIZE             12U
+#define iperf3UDP_HEADER_SIZE_64          16U
+
+/* The defaults of iperf3. */
+#define iperf3DEFAULT_TIME_S              10U
+#define iperf3DEFAULT_TCP_LENGTH          ( 128U * 1024U )
+#define iperf3DEFAULT_UDP_LENGTH          1448U
+#define iperf3DEFAULT_UDP_BITRATE         1000000UL
+
+/* Most datagrams sent per UDP stream in one pass of the test loop. */
+#define iperf3UDP_BURST                   16U
+
+/* Time the test loop waits for a socket event. */
+#define iperf3POLL_MS                     100U
+
+/* A TCP receiver: the longest time that data below the batch threshold waits
+ * to be read. */
+#define iperf3RX_BATCH_WAIT_MS            10U
+
+typedef struct xIPERF3_STREAM
+{
+    Socket_t xSocket;                 /* The server shares one UDP socket. */
+    struct freertos_sockaddr xRemote; /* UDP only. */
+    uint32_t ulId;
+    BaseType_t xClosed;
+    uint64_t ullBytes;
+    uint32_t ulPackets;               /* UDP: sent, or the highest count received. */
+    uint32_t ulErrors;                /* UDP: datagrams lost. */
+    uint32_t ulOutOfOrder;
+    int32_t lLastTransit;             /* UDP: for the jitter, in microseconds. */
+    uint32_t ulJitterUs;
+    TCPTxQueue_t xTxQueue;            /* TCP sender only. */
+    TCPCongestion_t xCongestion;      /* TCP sender only. */
+    TCPRxBatch_t xRxBatch;            /* TCP receiver only. */
+    TCPTxRegion_t xRegions[ 2 ];      /* Blocks that are produced in the TX stream. */
+} Iperf3Stream_t;
+
+typedef struct xIPERF3_TEST
+{
+    Iperf3Params_t xParams;
+    BaseType_t xIsServer;
+    BaseType_t xIsSender;
+    BaseType_t xCounters64;
+    Socket_t xControl;
+    Socket_t xUDPSocket;              /* Server: the socket of all UDP streams. */
+    char cCookie[ iperf3COOKIE_SIZE ];
+    Iperf3Stream_t xStreams[ configIPERF3_MAX_STREAMS ];
+    UBaseType_t uxStreams;
+    TickType_t xStartTime;
+    TickType_t xEndTime;
+    uint64_t ullPeerBytes;            /* From the results of the peer. */
+    uint32_t ulPeerPackets;
+    uint32_t ulPeerErrors;
+    SemaphoreHandle_t xWakeUp;        /* TCP receiver: given by the batches and the control socket. */
+    StaticSemaphore_t xWakeUpBuffer;
+} Iperf3Test_t;
+
+/* Builds a JSON message in cJSON. */
+typedef struct xIPERF3_WRITER
+{
+    char * pcBuffer;
+    size_t uxSize;
+    size_t uxLength;
+} Iperf3Writer_t;
+
+/*
+ * The task that accepts control connections and serves one test at a time.
+ */
+static void prvServerTask( void * pvParameters );
+
+/*
+ * The task that runs one client test and deletes itself.
+ */
+static void prvClientTask( void * pvParameters );
+
+/*
+ * The server side of a test, on an accepted control connection.
+ */
+static BaseType_t prvServeTest( Socket_t xListen );
+
+/*
+ * The client side of a test.
+ */
+static BaseType_t prvRunClient( void );
+
+/*
+ * Accept the data connections, or UDP streams, of a test.
+ */
+static BaseType_t prvAcceptStreams( Socket_t xListen );
+
+/*
+ * Open the data connections, or UDP streams, of a test.
+ */
+static BaseType_t prvConnectStreams( void );
+
+/*
+ * Move data until the client ends the test.
+ */
+static BaseType_t prvRunStreams( void );
+
+/*
+ * Send and receive what the sockets allow, without blocking.
+ */
+static void prvTransfer( TickType_t xElapsed );
+
+/*
+ * Account a received UDP datagram.
+ */
+static void prvUDPDatagram( Iperf3Stream_t * pxStream,
+                            const uint8_t * pucData,
+                            size_t uxLength );
+
+/*
+ * A TCP sender writes its blocks in place, through a TX queue.  Each block is
+ * queued again once the peer has acknowledged it.
+ */
+static void prvStartSending( Iperf3Stream_t * pxStream );
+static void prvStartReceiving( Iperf3Stream_t * pxStream );
+static void prvBlockSent( TCPTxRegion_t * pxRegion,
+                          BaseType_t xStatus );
+
+/*
+ * Close all sockets of the test, except the control connection.
+ */
+static void prvCloseStreams( void );
+
+/*
+ * Close a TCP socket gracefully.
+ */
+static void prvCloseSocket( Socket_t xSocket );
+
+/*
+ * Blocking transfers of a whole buffer on a TCP socket.
+ */
+static BaseType_t prvSendAll( Socket_t xSocket,
+                              const void * pvData,
+                              size_t uxLength );
+static BaseType_t prvRecvAll( Socket_t xSocket,
+                              void * pvData,
+                              size_t uxLength );
+
+/*
+ * A state byte on the control connection.
+ */
+static BaseType_t prvSendState( int8_t cState );
+static BaseType_t prvExpectState( int8_t cExpected );
+
+/*
+ * A JSON message on the control connection: a 32-bit length in network byte
+ * order followed by the text.  prvRecvJSON() leaves it in cJSON.
+ */
+static BaseType_t prvSendJSON( const char * pcJSON );
+static BaseType_t prvRecvJSON( void );
+
+/*
+ * Find the value of a key, given with its quotes, or NULL.
+ */
+static const char * prvJSONValue( const char * pcJSON,
+                                  const char * pcKey );
+static uint64_t prvJSONUnsigned( const char * pcValue );
+static BaseType_t prvJSONIsTrue( const char * pcValue );
+static void prvJSONString( const char * pcValue,
+                           char * pcBuffer,
+                           size_t uxSize );
+
+/*
+ * Append to a JSON message.
+ */
+static void prvPut( Iperf3Writer_t * pxWriter,
+                    const char * pcText );
+static void prvPutUnsigned( Iperf3Writer_t * pxWriter,
+                            uint64_t ullValue );
+static void prvPutSeconds( Iperf3Writer_t * pxWriter,
+                           uint32_t ulMicroseconds );
+
+/*
+ * The parameters that the client sends, and the results of both sides.
+ */
+static BaseType_t prvParseParams( const char * pcJSON );
+static void prvFormatParams( void );
+static void prvParseResults( const char * pcJSON );
+static void prvFormatResults( void );
+
+/*
+ * Give a socket of a data stream the timeouts and, for TCP, the windows of the
+ * test.
+ */
+static void prvSetTimeouts( Socket_t xSocket );
+static void prvSetWindows( Socket_t xSocket );
+
+/*
+ * Log the progress, or the result.
+ */
+static void prvReportInterval( TickType_t xFrom,
+                               TickType_t xTo,
+                               uint64_t ullBytes );
+static void prvReportResult( void );
+
+/*
+ * Only one test runs at a time, it uses the buffer and xTest.
+ */
+static BaseType_t prvClaim( void );
+static void prvRelease( void );
+
+/*-----------------------------------------------------------*/
+
+static Iperf3Test_t xTest;
+
+/* The data of all streams, its contents do not matter. */
+static uint8_t ucBuffer[ ipconfigIPERF_RECV_BUFFER_SIZE ];
+
+static char cJSON[ configIPERF3_JSON_SIZE ];
+
+static BaseType_t xTestRunning = pdFALSE;
+
+static TaskHandle_t xServerTaskHandle = NULL;
+
+/*-----------------------------------------------------------*/
+
+BaseType_t xIperf3StartServer( void )
+{
+    BaseType_t xReturn = pdPASS;
+
+    if( xServerTaskHandle == NULL )
+    {
+        xReturn = xTaskCreate( prvServerTask, "iperf3s", ipconfigIPERF_STACK_SIZE_IPERF_TASK, NULL, ipconfigIPERF_PRIORITY_IPERF_TASK, &xServerTaskHandle );
+    }
+
+    return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xIperf3StartClient( const Iperf3Params_t * pxParams )
+{
+    BaseType_t xReturn = pdFAIL;
+
+    if( prvClaim() == pdPASS )
+    {
+        memset( &xTest, 0, sizeof( xTest ) );
+        memcpy( &( xTest.xParams ), pxParams, sizeof( xTest.xParams ) );
+        xReturn = xTaskCreate( prvClientTask, "iperf3c", ipconfigIPERF_STACK_SIZE_IPERF_TASK, NULL, ipconfigIPERF_PRIORITY_IPERF_TASK, NULL );
+
+        if( xReturn != pdPASS )
+        {
+            prvRelease();
+        }
+    }
+
+    return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvClaim( void )
+{
+    BaseType_t xReturn = pdFAIL;
+
+    taskENTER_CRITICAL();
+    {
+        if( xTestRunning == pdFALSE )
+        {
+            xTestRunning = pdTRUE;
+            xReturn = pdPASS;
+        }
+    }
+    taskEXIT_CRITICAL();
+
+    return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+static void prvRelease( void )
+{
+    taskENTER_CRITICAL();
+    {
+        xTestRunning = pdFALSE;
+    }
+    taskEXIT_CRITICAL();
+}
+/*-----------------------------------------------------------*/
+
+static void prvServerTask( void * pvParameters )
+{
+    Socket_t xListen;
+    Socket_t xControl;
+    struct freertos_sockaddr xAddress;
+    uint32_t ulAddressLength = sizeof( xAddress );
+    int8_t cDenied = iperf3ACCESS_DENIED;
+
+    /* Disable unused parameter warning. */
+    ( void ) pvParameters;
+
+    xListen = FreeRTOS_socket( FREERTOS_AF_INET, FREERTOS_SOCK_STREAM, FREERTOS_IPPROTO_TCP );
+    configASSERT( xListen != FREERTOS_INVALID_SOCKET );
+
+    /* Accepting data connections must time out, control connections are
+     * waited for in a loop. */
+    prvSetTimeouts( xListen );
+
+    memset( &xAddress, 0, sizeof( xAddress ) );
+    xAddress.sin_family = FREERTOS_AF_INET;
+    xAddress.sin_port = FreeRTOS_htons( configIPERF3_PORT );
+    ( void ) FreeRTOS_bind( xListen, &xAddress, sizeof( xAddress ) );
+    ( void ) FreeRTOS_listen( xListen, ( BaseType_t ) configIPERF3_MAX_STREAMS + 1 );
+
+    FreeRTOS_printf( ( "iperf3: server listening on port %u\n", ( unsigned ) configIPERF3_PORT ) );
+
+    for( ; ; )
+    {
+        xControl = FreeRTOS_accept( xListen, &xAddress, &ulAddressLength );
+
+        if( ( xControl == NULL ) || ( xControl == FREERTOS_INVALID_SOCKET ) )
+        {
+            continue;
+        }
+
+        prvSetTimeouts( xControl );
+
+        if( prvClaim() == pdPASS )
+        {
+            memset( &xTest, 0, sizeof( xTest ) );
+            xTest.xIsServer = pdTRUE;
+            xTest.xControl = xControl;
+
+            if( prvServeTest( xListen ) == pdFAIL )
+            {
+                FreeRTOS_printf( ( "iperf3: test failed\n" ) );
+            }
+
+            prvCloseStreams();
+            prvRelease();
+        }
+        else
+        {
+            /* A client test is running. */
+            ( void ) prvSendAll( xControl, &cDenied, sizeof( cDenied ) );
+        }
+
+        prvCloseSocket( xControl );
+    }
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvServeTest( Socket_t xListen )
+{
+    BaseType_t xReturn;
+    struct freertos_sockaddr xAddress;
+    int8_t cDenied = iperf3ACCESS_DENIED;
+
+    xReturn = prvRecvAll( xTest.xControl, xTest.cCookie, iperf3COOKIE_SIZE );
+
+    if( xReturn == pdPASS )
+    {
+        xReturn = prvSendState( iperf3PARAM_EXCHANGE );
+    }
+
+    if( xReturn == pdPASS )
+    {
+        xReturn = prvRecvJSON();
+    }
+
+    if( xReturn == pdPASS )
+    {
+        xReturn = prvParseParams( cJSON );
+
+        if( xReturn == pdFAIL )
+        {
+            ( void ) prvSendAll( xTest.xControl, &cDenied, sizeof( cDenied ) );
+        }
+    }
+
+    if( xReturn == pdPASS )
+    {
+        /* The client sends, unless in reverse mode. */
+        xTest.xIsSender = xTest.xParams.xReverse;
+
+        if( xTest.xParams.xUDP != pdFALSE )
+        {
+            xTest.xUDPSocket = FreeRTOS_socket( FREERTOS_AF_INET, FREERTOS_SOCK_DGRAM, FREERTOS_IPPROTO_UDP );
+
+            if( xTest.xUDPSocket == FREERTOS_INVALID_SOCKET )
+            {
+                xTest.xUDPSocket = NULL;
+                xReturn = pdFAIL;
+            }
+            else
+            {
+                prvSetTimeouts( xTest.xUDPSocket );
+                memset( &xAddress, 0, sizeof( xAddress ) );
+                xAddress.sin_family = FREERTOS_AF_INET;
+                xAddress.sin_port = FreeRTOS_htons( configIPERF3_PORT );
+                ( void ) FreeRTOS_bind( xTest.xUDPSocket, &xAddress, sizeof( xAddress ) );
+            }
+        }
+        else
+        {
+            /* The data connections inherit the windows of the listening
+             * socket. */
+            prvSetWindows( xListen );
+        }
+    }
+
+    if( xReturn == pdPASS )
+    {
+        xReturn = prvSendState( iperf3CREATE_STREAMS );
+    }
+
+    if( xReturn == pdPASS )
+    {
+        xReturn = prvAcceptStreams( xListen );
+    }
+
+    if( xReturn == pdPASS )
+    {
+        xReturn = prvSendState( iperf3TEST_START );
+    }
+
+    if( xReturn == pdPASS )
+    {
+        xReturn = prvSendState( iperf3TEST_RUNNING );
+    }
+
+    if( xReturn == pdPASS )
+    {
+        xReturn = prvRunStreams();
+    }
+
+    if( xReturn == pdPASS )
+    {
+        xReturn = prvSendState( iperf3EXCHANGE_RESULTS );
+    }
+
+    if( xReturn == pdPASS )
+    {
+        /* The client sends its results first. */
+        xReturn = prvRecvJSON();
+    }
+
+    if( xReturn == pdPASS )
+    {
+        prvParseResults( cJSON );
+        prvFormatResults();
+        xReturn = prvSendJSON( cJSON );
+    }
+
+    if( xReturn == pdPASS )
+    {
+        xReturn = prvSendState( iperf3DISPLAY_RESULTS );
+    }
+
+    if( xReturn == pdPASS )
+    {
+        /* The test is complete, even if the client does not say goodbye. */
+        ( void ) prvExpectState( iperf3IPERF_DONE );
+        prvReportResult();
+    }
+
+    return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+static void prvClientTask( void * pvParameters )
+{
+    /* Disable unused parameter warning. */
+    ( void ) pvParameters;
+
+    if( prvRunClient() == pdFAIL )
+    {
+        FreeRTOS_printf( ( "iperf3: test failed\n" ) );
+    }
+
+    prvCloseStreams();
+
+    if( xTest.xControl != NULL )
+    {
+        prvCloseSocket( xTest.xControl );
+        xTest.xControl = NULL;
+    }
+
+    prvRelease();
+    vTaskDelete( NULL );
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvRunClient( void )
+{
+    static const char cAlphabet[] = "abcdefghijklmnopqrstuvwxyz234567";
+    Iperf3Params_t * pxParams = &( xTest.xParams );
+    uint8_t ucRandom[ iperf3COOKIE_SIZE - 1U ];
+    BaseType_t xReturn = pdPASS;
+    BaseType_t xIndex;
+
+    if( pxParams->ulTimeSeconds == 0U )
+    {
+        pxParams->ulTimeSeconds = iperf3DEFAULT_TIME_S;
+    }
+
+    if( pxParams->uxParallel == 0U )
+    {
+        pxParams->uxParallel = 1U;
+    }
+
+    if( pxParams->uxParallel > configIPERF3_MAX_STREAMS )
+    {
+        pxParams->uxParallel = configIPERF3_MAX_STREAMS;
+    }
+
+    if( pxParams->uxLength == 0U )
+    {
+        pxParams->uxLength = ( pxParams->xUDP != pdFALSE ) ? iperf3DEFAULT_UDP_LENGTH : iperf3DEFAULT_TCP_LENGTH;
+    }
+
+    if( ( pxParams->xUDP != pdFALSE ) && ( pxParams->ulBitrate == 0U ) )
+    {
+        pxParams->ulBitrate = iperf3DEFAULT_UDP_BITRATE;
+    }
+
+    xTest.xIsSender = ( pxParams->xReverse == pdFALSE ) ? pdTRUE : pdFALSE;
+
+    /* The cookie ties the data connections to the control connection. */
+    ( void ) xEntropyPoolRandom( ucRandom, sizeof( ucRandom ) );
+
+    for( xIndex = 0; xIndex < ( BaseType_t ) sizeof( ucRandom ); xIndex++ )
+    {
+        xTest.cCookie[ xIndex ] = cAlphabet[ ucRandom[ xIndex ] & 0x1FU ];
+    }
+
+    xTest.cCookie[ iperf3COOKIE_SIZE - 1U ] = '\0';
+
+    xTest.xControl = FreeRTOS_socket( pxParams->xServer.sin_family, FREERTOS_SOCK_STREAM, FREERTOS_IPPROTO_TCP );
+
+    if( xTest.xControl == FREERTOS_INVALID_SOCKET )
+    {
+        xTest.xControl = NULL;
+        xReturn = pdFAIL;
+    }
+    else
+    {
+        prvSetTimeouts( xTest.xControl );
+
+        if( FreeRTOS_connect( xTest.xControl, &( pxParams->xServer ), sizeof( pxParams->xServer ) ) != 0 )
+        {
+            FreeRTOS_printf( ( "iperf3: cannot connect to the server\n" ) );
+            xReturn = pdFAIL;
+        }
+    }
+
+    if( xReturn == pdPASS )
+    {
+        xReturn = prvSendAll( xTest.xControl, xTest.cCookie, iperf3COOKIE_SIZE );
+    }
+
+    if( xReturn == pdPASS )
+    {
+        xReturn = prvExpectState( iperf3PARAM_EXCHANGE );
+    }
+
+    if( xReturn == pdPASS )
+    {
+        prvFormatParams();
+        xReturn = prvSendJSON( cJSON );
+    }
+
+    if( xReturn == pdPASS )
+    {
+        xReturn = prvExpectState( iperf3CREATE_STREAMS );
+    }
+
+    if( xReturn == pdPASS )
+    {
+        xReturn = prvConnectStreams();
+    }
+
+    if( xReturn == pdPASS )
+    {
+        xReturn = prvExpectState( iperf3TEST_START );
+    }
+
+    if( xReturn == pdPASS )
+    {
+        xReturn = prvExpectState( iperf3TEST_RUNNING );
+    }
+
+    if( xReturn == pdPASS )
+    {
+        xReturn = prvRunStreams();
+    }
+
+    if( xReturn == pdPASS )
+    {
+        xReturn = prvExpectState( iperf3EXCHANGE_RESULTS );
+    }
+
+    if( xReturn == pdPASS )
+    {
+        prvFormatResults();
+        xReturn = prvSendJSON( cJSON );
+    }
+
+    if( xReturn == pdPASS )
+    {
+        xReturn = prvRecvJSON();
+    }
+
+    if( xReturn == pdPASS )
+    {
+        prvParseResults( cJSON );
+        xReturn = prvExpectState( iperf3DISPLAY_RESULTS );
+    }
+
+    if( xReturn == pdPASS )
+    {
+        ( void ) prvSendState( iperf3IPERF_DONE );
+        prvReportResult();
+    }
+
+    return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvAcceptStreams( Socket_t xListen )
+{
+    BaseType_t xReturn = pdPASS;
+    Iperf3Stream_t * pxStream;
+    Socket_t xSocket;
+    struct freertos_sockaddr xAddress;
+    uint32_t ulAddressLength;
+    char cCookie[ iperf3COOKIE_SIZE ];
+    uint32_t ulMessage;
+    uint32_t ulReply = iperf3UDP_CONNECT_REPLY;
+    int32_t lResult;
+
+    while( ( xReturn == pdPASS ) && ( xTest.uxStreams < xTest.xParams.uxParallel ) )
+    {
+        pxStream = &( xTest.xStreams[ xTest.uxStreams ] );
+        ulAddressLength = sizeof( xAddress );
+
+        if( xTest.xParams.xUDP != pdFALSE )
+        {
+            /* All UDP streams arrive on the one socket, they are told apart
+             * by the address of the client. */
+            ulMessage = 0U;
+            lResult = FreeRTOS_recvfrom( xTest.xUDPSocket, &ulMessage, sizeof( ulMessage ), 0, &xAddress, &ulAddressLength );
+
+            if( lResult <= 0 )
+            {
+                xReturn = pdFAIL;
+            }
+            else if( ( ulMessage == iperf3UDP_CONNECT_MSG ) || ( ulMessage == iperf3UDP_CONNECT_MSG_LEGACY ) )
+            {
+                pxStream->xSocket = xTest.xUDPSocket;
+                memcpy( &( pxStream->xRemote ), &xAddress, sizeof( xAddress ) );
+                ( void ) FreeRTOS_sendto( xTest.xUDPSocket, &ulReply, sizeof( ulReply ), 0, &xAddress, sizeof( xAddress ) );
+                xTest.uxStreams++;
+            }
+        }
+        else
+        {
+            xSocket = FreeRTOS_accept( xListen, &xAddress, &ulAddressLength );
+
+            if( ( xSocket == NULL ) || ( xSocket == FREERTOS_INVALID_SOCKET ) )
+            {
+                xReturn = pdFAIL;
+            }
+            else
+            {
+                prvSetTimeouts( xSocket );
+
+                if( ( prvRecvAll( xSocket, cCookie, sizeof( cCookie ) ) == pdPASS ) &&
+                    ( memcmp( cCookie, xTest.cCookie, sizeof( cCookie ) ) == 0 ) )
+                {
+                    pxStream->xSocket = xSocket;
+                    xTest.uxStreams++;
+                }
+                else
+                {
+                    /* Not part of this test. */
+                    prvCloseSocket( xSocket );
+                }
+            }
+        }
+
+        if( pxStream->xSocket != NULL )
+        {
+            /* Stream IDs as iperf3 gives them out: 1, 3, 4, 5... */
+            pxStream->ulId = ( xTest.uxStreams == 1U ) ? 1U : ( uint32_t ) xTest.uxStreams + 1U;
+        }
+    }
+
+    if( xReturn == pdFAIL )
+    {
+        FreeRTOS_printf( ( "iperf3: %u of %u streams arrived\n", ( unsigned ) xTest.uxStreams, ( unsigned ) xTest.xParams.uxParallel ) );
+    }
+
+    return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvConnectStreams( void )
+{
+    BaseType_t xReturn = pdPASS;
+    Iperf3Params_t * pxParams = &( xTest.xParams );
+    Iperf3Stream_t * pxStream;
+    struct freertos_sockaddr xAddress;
+    uint32_t ulAddressLength;
+    uint32_t ulMessage;
+    int32_t lResult;
+
+    while( ( xReturn == pdPASS ) && ( xTest.uxStreams < pxParams->uxParallel ) )
+    {
+        pxStream = &( xTest.xStreams[ xTest.uxStreams ] );
+        pxStream->xSocket = FreeRTOS_socket( pxParams->xServer.sin_family,
+                                             ( pxParams->xUDP != pdFALSE ) ? FREERTOS_SOCK_DGRAM : FREERTOS_SOCK_STREAM,
+                                             ( pxParams->xUDP != pdFALSE ) ? FREERTOS_IPPROTO_UDP : FREERTOS_IPPROTO_TCP );
+
+        if( pxStream->xSocket == FREERTOS_INVALID_SOCKET )
+        {
+            pxStream->xSocket = NULL;
+            xReturn = pdFAIL;
+            break;
+        }
+
+        xTest.uxStreams++;
+        pxStream->ulId = ( xTest.uxStreams == 1U ) ? 1U : ( uint32_t ) xTest.uxStreams + 1U;
+        prvSetTimeouts( pxStream->xSocket );
+
+        if( pxParams->xUDP != pdFALSE )
+        {
+            memcpy( &( pxStream->xRemote ), &( pxParams->xServer ), sizeof( pxStream->xRemote ) );
+            ( void ) FreeRTOS_bind( pxStream->xSocket, NULL, 0U );
+
+            ulMessage = iperf3UDP_CONNECT_MSG;
+            ( void ) FreeRTOS_sendto( pxStream->xSocket, &ulMessage, sizeof( ulMessage ), 0, &( pxStream->xRemote ), sizeof( pxStream->xRemote ) );
+
+            ulMessage = 0U;
+            ulAddressLength = sizeof( xAddress );
+            lResult = FreeRTOS_recvfrom( pxStream->xSocket, &ulMessage, sizeof( ulMessage ), 0, &xAddress, &ulAddressLength );
+
+            if( ( lResult != ( int32_t ) sizeof( ulMessage ) ) ||
+                ( ( ulMessage != iperf3UDP_CONNECT_REPLY ) && ( ulMessage != iperf3UDP_CONNECT_REPLY_LEGACY ) ) )
+            {
+                xReturn = pdFAIL;
+            }
+        }
+        else
+        {
+            prvSetWindows( pxStream->xSocket );
+
+            if( FreeRTOS_connect( pxStream->xSocket, &( pxParams->xServer ), sizeof( pxParams->xServer ) ) != 0 )
+            {
+                xReturn = pdFAIL;
+            }
+            else
+            {
+                xReturn = prvSendAll( pxStream->xSocket, xTest.cCookie, iperf3COOKIE_SIZE );
+            }
+        }
+    }
+
+    return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvRunStreams( void )
+{
+    BaseType_t xReturn = pdPASS;
+    SocketSet_t xSocketSet;
+    TickType_t xNow;
+    TickType_t xDuration = pdMS_TO_TICKS( xTest.xParams.ulTimeSeconds * 1000U );
+    TickType_t xLastReport;
+    TickType_t xWait;
+    uint64_t ullLastBytes = 0U;
+    uint64_t ullBytes;
+    UBaseType_t uxIndex;
+    BaseType_t xEvents;
+    BaseType_t xResult;
+    int8_t cState;
+    TickType_t xNoSend = 0U;
+
+    xSocketSet = FreeRTOS_CreateSocketSet();
+
+    if( xSocketSet == NULL )
+    {
+        xReturn = pdFAIL;
+    }
+    else
+    {
+        FreeRTOS_FD_SET( xTest.xControl, xSocketSet, eSELECT_READ | eSELECT_EXCEPT );
+
+        /* A UDP sender is paced by time, not by socket events. */
+        xEvents = ( xTest.xIsSender != pdFALSE ) ? eSELECT_WRITE : eSELECT_READ;
+
+        for( uxIndex = 0U; uxIndex < xTest.uxStreams; uxIndex++ )
+        {
+            if( xTest.xParams.xUDP != pdFALSE )
+            {
+                /* Never block in FreeRTOS_sendto() waiting for a network
+                 * buffer, the pacing handles a shortage. */
+                ( void ) FreeRTOS_setsockopt( xTest.xStreams[ uxIndex ].xSocket, 0, FREERTOS_SO_SNDTIMEO, &xNoSend, sizeof( xNoSend ) );
+            }
+            else if( xTest.xIsSender != pdFALSE )
+            {
+                prvStartSending( &( xTest.xStreams[ uxIndex ] ) );
+            }
+            else
+            {
+                prvStartReceiving( &( xTest.xStreams[ uxIndex ] ) );
+            }
+
+            if( ( xTest.xParams.xUDP == pdFALSE ) || ( xTest.xIsSender == pdFALSE ) )
+            {
+                FreeRTOS_FD_SET( xTest.xStreams[ uxIndex ].xSocket, xSocketSet, xEvents | eSELECT_EXCEPT );
+            }
+        }
+
+        if( xTest.xWakeUp != NULL )
+        {
+            /* Wake up for the control connection as for a batch. */
+            ( void ) FreeRTOS_setsockopt( xTest.xControl, 0, FREERTOS_SO_SET_SEMAPHORE, &( xTest.xWakeUp ), sizeof( xTest.xWakeUp ) );
+        }
+
+        xTest.xStartTime = xTaskGetTickCount();
+        xLastReport = xTest.xStartTime;
+
+        for( ; ; )
+        {
+            xNow = xTaskGetTickCount();
+
+            /* The client decides when the test is over. */
+            if( ( xTest.xIsServer == pdFALSE ) && ( ( xNow - xTest.xStartTime ) >= xDuration ) )
+            {
+                xReturn = prvSendState( iperf3TEST_END );
+                break;
+            }
+
+            if( xTest.xWakeUp != NULL )
+            {
+                /* A TCP receiver does not wake up for every segment. */
+                ( void ) xSemaphoreTake( xTest.xWakeUp, pdMS_TO_TICKS( iperf3RX_BATCH_WAIT_MS ) );
+            }
+            else
+            {
+                xWait = ( ( xTest.xParams.xUDP != pdFALSE ) && ( xTest.xIsSender != pdFALSE ) ) ? 1U : pdMS_TO_TICKS( iperf3POLL_MS );
+                ( void ) FreeRTOS_select( xSocketSet, xWait );
+            }
+
+            xResult = FreeRTOS_recv( xTest.xControl, &cState, sizeof( cState ), FREERTOS_MSG_DONTWAIT );
+
+            if( xResult == ( BaseType_t ) sizeof( cState ) )
+            {
+                if( ( xTest.xIsServer != pdFALSE ) && ( cState == iperf3TEST_END ) )
+                {
+                    break;
+                }
+
+                /* CLIENT_TERMINATE, SERVER_TERMINATE or an error. */
+                FreeRTOS_printf( ( "iperf3: test ended by the peer, state %d\n", ( int ) cState ) );
+                xReturn = pdFAIL;
+                break;
+            }
+            else if( ( xResult < 0 ) && ( xResult != -pdFREERTOS_ERRNO_EWOULDBLOCK ) )
+            {
+                FreeRTOS_printf( ( "iperf3: control connection lost\n" ) );
+                xReturn = pdFAIL;
+                break;
+            }
+            else
+            {
+                /* Nothing on the control connection. */
+            }
+
+            prvTransfer( xTaskGetTickCount() - xTest.xStartTime );
+
+            #if ( configIPERF3_INTERVAL_MS != 0 )
+            {
+                xNow = xTaskGetTickCount();
+
+                if( ( xNow - xLastReport ) >= pdMS_TO_TICKS( configIPERF3_INTERVAL_MS ) )
+                {
+                    ullBytes = 0U;
+
+                    for( uxIndex = 0U; uxIndex < xTest.uxStreams; uxIndex++ )
+                    {
+                        ullBytes += xTest.xStreams[ uxIndex ].ullBytes;
+                    }
+
+                    prvReportInterval( xLastReport - xTest.xStartTime, xNow - xTest.xStartTime, ullBytes - ullLastBytes );
+                    ullLastBytes = ullBytes;
+                    xLastReport = xNow;
+                }
+            }
+            #endif /* if ( configIPERF3_INTERVAL_MS != 0 ) */
+        }
+
+        xTest.xEndTime = xTaskGetTickCount();
+        FreeRTOS_DeleteSocketSet( xSocketSet );
+
+        if( xTest.xWakeUp != NULL )
+        {
+            ( void ) FreeRTOS_setsockopt( xTest.xControl, 0, FREERTOS_SO_SET_SEMAPHORE, NULL, 0U );
+        }
+    }
+
+    return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+static void prvTransfer( TickType_t xElapsed )
+{
+    Iperf3Params_t * pxParams = &( xTest.xParams );
+    Iperf3Stream_t * pxStream;
+    UBaseType_t uxIndex;
+    UBaseType_t uxBurst;
+    UBaseType_t uxMatch;
+    BaseType_t xResult;
+    int32_t lResult;
+    uint64_t ullAllowed;
+    uint64_t ullMicroseconds;
+    uint32_t ulQueued;
+    size_t uxLength;
+    struct freertos_sockaddr xAddress;
+    uint32_t ulAddressLength;
+
+    uxLength = ( pxParams->uxLength < sizeof( ucBuffer ) ) ? pxParams->uxLength : sizeof( ucBuffer );
+
+    for( uxIndex = 0U; uxIndex < xTest.uxStreams; uxIndex++ )
+    {
+        pxStream = &( xTest.xStreams[ uxIndex ] );
+
+        if( pxStream->xClosed != pdFALSE )
+        {
+            continue;
+        }
+
+        if( ( pxParams->xUDP == pdFALSE ) && ( xTest.xIsSender != pdFALSE ) )
+        {
+            /* Fill the TX stream as far as it has room, in whole segments. */
+            ulQueued = pxStream->xTxQueue.ulStreamQueued;
+            xResult = xTCPTxQueueProcess( &( pxStream->xTxQueue ), 0U );
+            pxStream->ullBytes += ( uint64_t ) ( pxStream->xTxQueue.ulStreamQueued - ulQueued );
+        }
+        else if( pxParams->xUDP == pdFALSE )
+        {
+            do
+            {
+                if( pxStream->xRxBatch.xSocket == pxStream->xSocket )
+                {
+                    xResult = xTCPRxBatchReceive( &( pxStream->xRxBatch ), ucBuffer, sizeof( ucBuffer ) );
+                }
+                else
+                {
+                    xResult = FreeRTOS_recv( pxStream->xSocket, ucBuffer, sizeof( ucBuffer ), FREERTOS_MSG_DONTWAIT );
+                }
+
+                if( xResult > 0 )
+                {
+                    pxStream->ullBytes += ( uint64_t ) xResult;
+                }
+            } while( xResult > 0 );
+        }
+        else if( xTest.xIsSender != pdFALSE )
+        {
+            /* -b applies to every stream. */
+            ullAllowed = ( ( uint64_t ) pxParams->ulBitrate * ( uint64_t ) pdTICKS_TO_MS( xElapsed ) ) / 8000U;
+            uxLength = ( uxLength < iperf3UDP_HEADER_SIZE_64 ) ? iperf3UDP_HEADER_SIZE_64 : uxLength;
+            xResult = 0;
+
+            for( uxBurst = 0U; uxBurst < iperf3UDP_BURST; uxBurst++ )
+            {
+                /* Leave the stack the buffers it needs to receive. */
+                if( ( ( pxParams->ulBitrate != 0U ) && ( pxStream->ullBytes >= ullAllowed ) ) ||
+                    ( xNetStatsBuffersAvailable( 1U ) == pdFALSE ) )
+                {
+                    break;
+                }
+
+                ullMicroseconds = ullUptimeMicroseconds();
+                *( ( uint32_t * ) &( ucBuffer[ 0 ] ) ) = FreeRTOS_htonl( ( uint32_t ) ( ullMicroseconds / 1000000U ) );
+                *( ( uint32_t * ) &( ucBuffer[ 4 ] ) ) = FreeRTOS_htonl( ( uint32_t ) ( ullMicroseconds % 1000000U ) );
+
+                if( xTest.xCounters64 != pdFALSE )
+                {
+                    *( ( uint32_t * ) &( ucBuffer[ 8 ] ) ) = 0U;
+                    *( ( uint32_t * ) &( ucBuffer[ 12 ] ) ) = FreeRTOS_htonl( pxStream->ulPackets + 1U );
+                }
+                else
+                {
+                    *( ( uint32_t * ) &( ucBuffer[ 8 ] ) ) = FreeRTOS_htonl( pxStream->ulPackets + 1U );
+                }
+
+                lResult = FreeRTOS_sendto( pxStream->xSocket, ucBuffer, uxLength, 0, &( pxStream->xRemote ), sizeof( pxStream->xRemote ) );
+
+                if( lResult <= 0 )
+                {
+                    break;
+                }
+
+                pxStream->ulPackets++;
+                pxStream->ullBytes += ( uint64_t ) lResult;
+            }
+        }
+        else if( ( xTest.xIsServer == pdFALSE ) || ( uxIndex == 0U ) )
+        {
+            /* The server reads its one UDP socket once, for all streams. */
+            for( ; ; )
+            {
+                ulAddressLength = sizeof( xAddress );
+                lResult = FreeRTOS_recvfrom( pxStream->xSocket, ucBuffer, sizeof( ucBuffer ), FREERTOS_MSG_DONTWAIT, &xAddress, &ulAddressLength );
+
+                if( lResult <= 0 )
+                {
+                    break;
+                }
+
+                uxMatch = uxIndex;
+
+                if( xTest.xIsServer != pdFALSE )
+                {
+                    for( uxMatch = 0U; uxMatch < xTest.uxStreams; uxMatch++ )
+                    {
+                        if( ( xTest.xStreams[ uxMatch ].xRemote.sin_port == xAddress.sin_port ) &&
+                            ( xTest.xStreams[ uxMatch ].xRemote.sin_address.ulIP_IPv4 == xAddress.sin_address.ulIP_IPv4 ) )
+                        {
+                            break;
+                        }
+                    }
+                }
+
+                if( uxMatch < xTest.uxStreams )
+                {
+                    prvUDPDatagram( &( xTest.xStreams[ uxMatch ] ), ucBuffer, ( size_t ) lResult );
+                }
+            }
+
+            xResult = 0;
+        }
+        else
+        {
+            xResult = 0;
+        }
+
+        if( ( pxParams->xUDP == pdFALSE ) && ( xResult < 0 ) &&
+            ( xResult != -pdFREERTOS_ERRNO_EWOULDBLOCK ) && ( xResult != -pdFREERTOS_ERRNO_ENOSPC ) )
+        {
+            /* The peer closed the stream, the control connection says when
+             * the test is over. */
+            pxStream->xClosed = pdTRUE;
+        }
+    }
+}
+/*-----------------------------------------------------------*/
+
+static void prvUDPDatagram( Iperf3Stream_t * pxStream,
+                            const uint8_t * pucData,
+                            size_t uxLength )
+{
+    uint32_t ulSentUs;
+    uint32_t ulCount;
+    int32_t lTransit;
+    int32_t lDelta;
+
+    pxStream->ullBytes += uxLength;
+
+    if( uxLength >= ( ( xTest.xCounters64 != pdFALSE ) ? iperf3UDP_HEADER_SIZE_64 : iperf3UDP_HEADER_SIZE ) )
+    {
+        ulSentUs = ( FreeRTOS_ntohl( *( ( const uint32_t * ) &( pucData[ 0 ] ) ) ) * 1000000U ) +
+                   FreeRTOS_ntohl( *( ( const uint32_t * ) &( pucData[ 4 ] ) ) );
+        ulCount = FreeRTOS_ntohl( *( ( const uint32_t * ) &( pucData[ ( xTest.xCounters64 != pdFALSE ) ? 12 : 8 ] ) ) );
+
+        if( ulCount > pxStream->ulPackets )
+        {
+            pxStream->ulErrors += ulCount - pxStream->ulPackets - 1U;
+            pxStream->ulPackets = ulCount;
+        }
+        else
+        {
+            /* It was counted as lost when a later one arrived. */
+            pxStream->ulOutOfOrder++;
+
+            if( pxStream->ulErrors > 0U )
+            {
+                pxStream->ulErrors--;
+            }
+        }
+
+        /* RFC 1889 jitter: the clocks need not agree, only the differences of
+         * the transit times count.  Both are taken modulo 2^32 us. */
+        lTransit = ( int32_t ) ( ( uint32_t ) ullUptimeMicroseconds() - ulSentUs );
+
+        if( pxStream->ulPackets > 1U )
+        {
+            lDelta = ( int32_t ) ( ( uint32_t ) lTransit - ( uint32_t ) pxStream->lLastTransit );
+            lDelta = ( lDelta < 0 ) ? -lDelta : lDelta;
+            pxStream->ulJitterUs = ( uint32_t ) ( ( int32_t ) pxStream->ulJitterUs + ( ( lDelta - ( int32_t ) pxStream->ulJitterUs ) / 16 ) );
+        }
+
+        pxStream->lLastTransit = lTransit;
+    }
+}
+/*-----------------------------------------------------------*/
+
+static void prvStartSending( Iperf3Stream_t * pxStream )
+{
+    UBaseType_t uxIndex;
+
+    vTCPTxQueueInit( &( pxStream->xTxQueue ), pxStream->xSocket );
+    vTCPCongestionInit( &( pxStream->xCongestion ), pxStream->xSocket, NULL );
+
+    if( ( xTest.xParams.cCongestion[ 0 ] != '\0' ) &&
+        ( xTCPCongestionSetAlgorithm( &( pxStream->xCongestion ), xTest.xParams.cCongestion ) != pdPASS ) )
+    {
+        FreeRTOS_printf( ( "iperf3: unknown congestion control \"%s\", using \"%s\"\n",
+                           xTest.xParams.cCongestion,
+                           xTCPCongestionReno.pcName ) );
+    }
+
+    vTCPTxQueueSetCongestion( &( pxStream->xTxQueue ), &( pxStream->xCongestion ) );
+
+    /* Two blocks, so that the stream can be filled with the second while the
+     * first one waits for its last ACK.  iperf3 does not look at the data,
+     * whatever is in the TX stream is sent. */
+    for( uxIndex = 0U; uxIndex < 2U; uxIndex++ )
+    {
+        memset( &( pxStream->xRegions[ uxIndex ] ), 0, sizeof( pxStream->xRegions[ uxIndex ] ) );
+        pxStream->xRegions[ uxIndex ].uxLength = xTest.xParams.uxLength;
+        pxStream->xRegions[ uxIndex ].fnCallback = prvBlockSent;
+        pxStream->xRegions[ uxIndex ].pvContext = pxStream;
+        ( void ) xTCPTxQueueRegion( &( pxStream->xTxQueue ), &( pxStream->xRegions[ uxIndex ] ) );
+    }
+}
+/*-----------------------------------------------------------*/
+
+static void prvStartReceiving( Iperf3Stream_t * pxStream )
+{
+    int32_t lWindow = ipconfigIPERF_RX_WINSIZE / ( int32_t ) xTest.xParams.uxParallel;
+    size_t uxThreshold;
+
+    if( xTest.xWakeUp == NULL )
+    {
+        xTest.xWakeUp = xSemaphoreCreateBinaryStatic( &( xTest.xWakeUpBuffer ) );
+    }
+
+    /* Wake up for half of the receive window of the stream, as set by
+     * prvSetWindows(), so that the peer still has room to send while the
+     * reader catches up. */
+    lWindow = ( lWindow < 2 ) ? 2 : lWindow;
+    uxThreshold = ( size_t ) ( lWindow / 2 ) * ( size_t ) ipconfigTCP_MSS;
+
+    if( xTCPRxBatchInit( &( pxStream->xRxBatch ), pxStream->xSocket, xTest.xWakeUp, uxThreshold ) != pdPASS )
+    {
+        FreeRTOS_printf( ( "iperf3: stream %u reads without batches\n", ( unsigned ) pxStream->ulId ) );
+    }
+}
+/*-----------------------------------------------------------*/
+
+static void prvBlockSent( TCPTxRegion_t * pxRegion,
+                          BaseType_t xStatus )
+{
+    Iperf3Stream_t * pxStream = ( Iperf3Stream_t * ) pxRegion->pvContext;
+
+    if( xStatus == pdPASS )
+    {
+        ( void ) xTCPTxQueueRegion( &( pxStream->xTxQueue ), pxRegion );
+    }
+}
+/*-----------------------------------------------------------*/
+
+static void prvCloseStreams( void )
+{
+    UBaseType_t uxIndex;
+    Iperf3Stream_t * pxStream;
+
+    for( uxIndex = 0U; uxIndex < xTest.uxStreams; uxIndex++ )
+    {
+        pxStream = &( xTest.xStreams[ uxIndex ] );
+
+        if( ( pxStream->xSocket == NULL ) || ( pxStream->xSocket == xTest.xUDPSocket ) )
+        {
+            /* The server closes its shared UDP socket once, below. */
+        }
+        else if( xTest.xParams.xUDP != pdFALSE )
+        {
+            ( void ) FreeRTOS_closesocket( pxStream->xSocket );
+        }
+        else
+        {
+            if( pxStream->xTxQueue.xSocket == pxStream->xSocket )
+            {
+                vTCPTxQueueAbort( &( pxStream->xTxQueue ) );
+                vTCPCongestionDeinit( &( pxStream->xCongestion ) );
+            }
+
+            if( pxStream->xRxBatch.xSocket == pxStream->xSocket )
+            {
+                vTCPRxBatchDetach( &( pxStream->xRxBatch ) );
+            }
+
+            prvCloseSocket( pxStream->xSocket );
+        }
+
+        pxStream->xSocket = NULL;
+    }
+
+    if( xTest.xUDPSocket != NULL )
+    {
+        ( void ) FreeRTOS_closesocket( xTest.xUDPSocket );
+        xTest.xUDPSocket = NULL;
+    }
+
+    xTest.uxStreams = 0U;
+}
+/*-----------------------------------------------------------*/
+
+static void prvCloseSocket( Socket_t xSocket )
+{
+    uint8_t ucDrain[ 32 ];
+    BaseType_t xAttempt;
+
+    /* Let the peer see a FIN, and wait a little for its own.  Not with
+     * ucBuffer, a new test may be using it already. */
+    ( void ) FreeRTOS_shutdown( xSocket, FREERTOS_SHUT_RDWR );
+
+    for( xAttempt = 0; xAttempt < 10; xAttempt++ )
+    {
+        if( FreeRTOS_recv( xSocket, ucDrain, sizeof( ucDrain ), 0 ) < 0 )
+        {
+            break;
+        }
+    }
+
+    ( void ) FreeRTOS_closesocket( xSocket );
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvSendAll( Socket_t xSocket,
+                              const void * pvData,
+                              size_t uxLength )
+{
+    const uint8_t * pucData = ( const uint8_t * ) pvData;
+    BaseType_t xResult;
+
+    while( uxLength > 0U )
+    {
+        xResult = FreeRTOS_send( xSocket, pucData, uxLength, 0 );
+
+        if( xResult <= 0 )
+        {
+            break;
+        }
+
+        pucData += xResult;
+        uxLength -= ( size_t ) xResult;
+    }
+
+    return ( uxLength == 0U ) ? pdPASS : pdFAIL;
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvRecvAll( Socket_t xSocket,
+                              void * pvData,
+                              size_t uxLength )
+{
+    uint8_t * pucData = ( uint8_t * ) pvData;
+    BaseType_t xResult;
+
+    while( uxLength > 0U )
+    {
+        xResult = FreeRTOS_recv( xSocket, pucData, uxLength, 0 );
+
+        if( xResult <= 0 )
+        {
+            break;
+        }
+
+        pucData += xResult;
+        uxLength -= ( size_t ) xResult;
+    }
+
+    return ( uxLength == 0U ) ? pdPASS : pdFAIL;
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvSendState( int8_t cState )
+{
+    return prvSendAll( xTest.xControl, &cState, sizeof( cState ) );
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvExpectState( int8_t cExpected )
+{
+    BaseType_t xReturn;
+    int8_t cState = 0;
+
+    xReturn = prvRecvAll( xTest.xControl, &cState, sizeof( cState ) );
+
+    if( ( xReturn == pdPASS ) && ( cState != cExpected ) )
+    {
+        FreeRTOS_printf( ( "iperf3: expected state %d, got %d\n", ( int ) cExpected, ( int ) cState ) );
+        xReturn = pdFAIL;
+    }
+
+    return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvSendJSON( const char * pcJSON )
+{
+    uint32_t ulLength = FreeRTOS_htonl( ( uint32_t ) strlen( pcJSON ) );
+    BaseType_t xReturn;
+
+    xReturn = prvSendAll( xTest.xControl, &ulLength, sizeof( ulLength ) );
+
+    if( xReturn == pdPASS )
+    {
+        xReturn = prvSendAll( xTest.xControl, pcJSON, strlen( pcJSON ) );
+    }
+
+    return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvRecvJSON( void )
+{
+    uint32_t ulLength = 0U;
+    BaseType_t xReturn;
+
+    xReturn = prvRecvAll( xTest.xControl, &ulLength, sizeof( ulLength ) );
+    ulLength = FreeRTOS_ntohl( ulLength );
+
+    if( ( xReturn == pdPASS ) && ( ulLength >= sizeof( cJSON ) ) )
+    {
+        FreeRTOS_printf( ( "iperf3: JSON message of %u bytes is too long\n", ( unsigned ) ulLength ) );
+        xReturn = pdFAIL;
+    }
+
+    if( xReturn == pdPASS )
+    {
+        xReturn = prvRecvAll( xTest.xControl, cJSON, ulLength );
+        cJSON[ ulLength ] = '\0';
+    }
+
+    return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+static const char * prvJSONValue( const char * pcJSON,
+                                  const char * pcKey )
+{
+    const char * pcValue = strstr( pcJSON, pcKey );
+
+    if( pcValue != NULL )
+    {
+        pcValue += strlen( pcKey );
+
+        while( ( *pcValue == ' ' ) || ( *pcValue == ':' ) )
+        {
+            pcValue++;
+        }
+    }
+
+    return pcValue;
+}
+/*-----------------------------------------------------------*/
+
+static void prvJSONString( const char * pcValue,
+                           char * pcBuffer,
+                           size_t uxSize )
+{
+    size_t uxLength = 0U;
+
+    /* A string without escapes, cut short when it does not fit. */
+    if( ( pcValue != NULL ) && ( *pcValue == '"' ) )
+    {
+        pcValue++;
+
+        while( ( pcValue[ uxLength ] != '"' ) && ( pcValue[ uxLength ] != '\0' ) && ( uxLength < ( uxSize - 1U ) ) )
+        {
+            pcBuffer[ uxLength ] = pcValue[ uxLength ];
+            uxLength++;
+        }
+    }
+
+    pcBuffer[ uxLength ] = '\0';
+}
+/*-----------------------------------------------------------*/
+
+static uint64_t prvJSONUnsigned( const char * pcValue )
+{
+    uint64_t ullValue = 0U;
+
+    if( pcValue != NULL )
+    {
+        if( prvJSONIsTrue( pcValue ) != pdFALSE )
+        {
+            ullValue = 1U;
+        }
+
+        while( ( *pcValue >= '0' ) && ( *pcValue <= '9' ) )
+        {
+            ullValue = ( ullValue * 10U ) + ( uint64_t ) ( *pcValue - '0' );
+            pcValue++;
+        }
+    }
+
+    return ullValue;
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvJSONIsTrue( const char * pcValue )
+{
+    return ( ( pcValue != NULL ) && ( strncmp( pcValue, "true", 4 ) == 0 ) ) ? pdTRUE : pdFALSE;
+}
+/*-----------------------------------------------------------*/
+
+static void prvPut( Iperf3Writer_t * pxWriter,
+                    const char * pcText )
+{
+    size_t uxLength = strlen( pcText );
+
+    /* Keep room for the terminating NUL, a message that does not fit is cut
+     * short and rejected by the peer. */
+    if( ( pxWriter->uxLength + uxLength ) < pxWriter->uxSize )
+    {
+        memcpy( &( pxWriter->pcBuffer[ pxWriter->uxLength ] ), pcText, uxLength + 1U );
+        pxWriter->uxLength += uxLength;
+    }
+}
+/*-----------------------------------------------------------*/
+
+static void prvPutUnsigned( Iperf3Writer_t * pxWriter,
+                            uint64_t ullValue )
+{
+    char cDigits[ 21 ];
+    size_t uxIndex = sizeof( cDigits ) - 1U;
+
+    cDigits[ uxIndex ] = '\0';
+
+    do
+    {
+        uxIndex--;
+        cDigits[ uxIndex ] = ( char ) ( '0' + ( int ) ( ullValue % 10U ) );
+        ullValue /= 10U;
+    } while( ullValue != 0U );
+
+    prvPut( pxWriter, &( cDigits[ uxIndex ] ) );
+}
+/*-----------------------------------------------------------*/
+
+static void prvPutSeconds( Iperf3Writer_t * pxWriter,
+                           uint32_t ulMicroseconds )
+{
+    char cFraction[ 8 ];
+    uint32_t ulRest = ulMicroseconds % 1000000U;
+    BaseType_t xIndex;
+
+    prvPutUnsigned( pxWriter, ulMicroseconds / 1000000U );
+
+    cFraction[ 0 ] = '.';
+
+    for( xIndex = 6; xIndex > 0; xIndex-- )
+    {
+        cFraction[ xIndex ] = ( char ) ( '0' + ( int ) ( ulRest % 10U ) );
+        ulRest /= 10U;
+    }
+
+    cFraction[ 7 ] = '\0';
+    prvPut( pxWriter, cFraction );
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvParseParams( const char * pcJSON )
+{
+    Iperf3Params_t * pxParams = &( xTest.xParams );
+    const char * pcValue;
+    BaseType_t xReturn = pdPASS;
+
+    pxParams->xUDP = prvJSONIsTrue( prvJSONValue( pcJSON, "\"udp\"" ) );
+    pxParams->xReverse = prvJSONIsTrue( prvJSONValue( pcJSON, "\"reverse\"" ) );
+    pxParams->ulTimeSeconds = ( uint32_t ) prvJSONUnsigned( prvJSONValue( pcJSON, "\"time\"" ) );
+    pxParams->uxParallel = ( UBaseType_t ) prvJSONUnsigned( prvJSONValue( pcJSON, "\"parallel\"" ) );
+    pxParams->uxLength = ( size_t ) prvJSONUnsigned( prvJSONValue( pcJSON, "\"len\"" ) );
+    pxParams->ulBitrate = ( uint32_t ) prvJSONUnsigned( prvJSONValue( pcJSON, "\"bandwidth\"" ) );
+    xTest.xCounters64 = ( prvJSONUnsigned( prvJSONValue( pcJSON, "\"udp_counters_64bit\"" ) ) != 0U ) ? pdTRUE : pdFALSE;
+    prvJSONString( prvJSONValue( pcJSON, "\"congestion\"" ), pxParams->cCongestion, sizeof( pxParams->cCongestion ) );
+
+    if( pxParams->uxParallel == 0U )
+    {
+        pxParams->uxParallel = 1U;
+    }
+
+    if( pxParams->uxLength == 0U )
+    {
+        pxParams->uxLength = ( pxParams->xUDP != pdFALSE ) ? iperf3DEFAULT_UDP_LENGTH : iperf3DEFAULT_TCP_LENGTH;
+    }
+
+    pcValue = prvJSONValue( pcJSON, "\"bidirectional\"" );
+
+    if( prvJSONIsTrue( pcValue ) != pdFALSE )
+    {
+        FreeRTOS_printf( ( "iperf3: bidirectional mode is not supported\n" ) );
+        xReturn = pdFAIL;
+    }
+    else if( pxParams->uxParallel > configIPERF3_MAX_STREAMS )
+    {
+        FreeRTOS_printf( ( "iperf3: %u streams asked, at most %u\n", ( unsigned ) pxParams->uxParallel, ( unsigned ) configIPERF3_MAX_STREAMS ) );
+        xReturn = pdFAIL;
+    }
+    else if( ( prvJSONUnsigned( prvJSONValue( pcJSON, "\"num\"" ) ) != 0U ) ||
+             ( prvJSONUnsigned( prvJSONValue( pcJSON, "\"blockcount\"" ) ) != 0U ) )
+    {
+        /* Stock clients send both, 0 for a test that is limited by time. */
+        FreeRTOS_printf( ( "iperf3: only tests limited by time are supported\n" ) );
+        xReturn = pdFAIL;
+    }
+    else
+    {
+        FreeRTOS_printf( ( "iperf3: %s%s, %u stream(s), %u s\n",
+                           ( pxParams->xUDP != pdFALSE ) ? "UDP" : "TCP",
+                           ( pxParams->xReverse != pdFALSE ) ? " reverse" : "",
+                           ( unsigned ) pxParams->uxParallel,
+                           ( unsigned ) pxParams->ulTimeSeconds ) );
+    }
+
+    return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+static void prvFormatParams( void )
+{
+    Iperf3Params_t * pxParams = &( xTest.xParams );
+    Iperf3Writer_t xWriter = { cJSON, sizeof( cJSON ), 0U };
+
+    cJSON[ 0 ] = '\0';
+    prvPut( &xWriter, ( pxParams->xUDP != pdFALSE ) ? "{\"udp\":true" : "{\"tcp\":true" );
+    prvPut( &xWriter, ",\"omit\":0,\"time\":" );
+    prvPutUnsigned( &xWriter, pxParams->ulTimeSeconds );
+    prvPut( &xWriter, ",\"parallel\":" );
+    prvPutUnsigned( &xWriter, pxParams->uxParallel );
+
+    if( pxParams->xReverse != pdFALSE )
+    {
+        prvPut( &xWriter, ",\"reverse\":true" );
+    }
+
+    prvPut( &xWriter, ",\"len\":" );
+    prvPutUnsigned( &xWriter, pxParams->uxLength );
+
+    if( ( pxParams->xUDP == pdFALSE ) && ( pxParams->cCongestion[ 0 ] != '\0' ) )
+    {
+        prvPut( &xWriter, ",\"congestion\":\"" );
+        prvPut( &xWriter, pxParams->cCongestion );
+        prvPut( &xWriter, "\"" );
+    }
+
+    if( pxParams->xUDP != pdFALSE )
+    {
+        prvPut( &xWriter, ",\"bandwidth\":" );
+        prvPutUnsigned( &xWriter, pxParams->ulBitrate );
+    }
+
+    prvPut( &xWriter, ",\"client_version\":\"3.1\"}" );
+}
+/*-----------------------------------------------------------*/
+
+static void prvParseResults( const char * pcJSON )
+{
+    const char * pcStream = strstr( pcJSON, "\"streams\"" );
+
+    xTest.ullPeerBytes = 0U;
+    xTest.ulPeerPackets = 0U;
+    xTest.ulPeerErrors = 0U;
+
+    /* Add up the streams, every stream object has each key once. */
+    while( pcStream != NULL )
+    {
+        pcStream = strstr( pcStream, "\"id\"" );
+
+        if( pcStream != NULL )
+        {
+            xTest.ullPeerBytes += prvJSONUnsigned( prvJSONValue( pcStream, "\"bytes\"" ) );
+            xTest.ulPeerPackets += ( uint32_t ) prvJSONUnsigned( prvJSONValue( pcStream, "\"packets\"" ) );
+            xTest.ulPeerErrors += ( uint32_t ) prvJSONUnsigned( prvJSONValue( pcStream, "\"errors\"" ) );
+            pcStream++;
+        }
+    }
+}
+/*-----------------------------------------------------------*/
+
+static void prvFormatResults( void )
+{
+    Iperf3Writer_t xWriter = { cJSON, sizeof( cJSON ), 0U };
+    Iperf3Stream_t * pxStream;
+    UBaseType_t uxIndex;
+    uint32_t ulDurationUs = pdTICKS_TO_MS( xTest.xEndTime - xTest.xStartTime ) * 1000U;
+
+    cJSON[ 0 ] = '\0';
+
+    /* Retransmissions are not known, so they are not reported. */
+    prvPut( &xWriter, "{\"cpu_util_total\":0,\"cpu_util_user\":0,\"cpu_util_system\":0,\"sender_has_retransmits\":0,\"streams\":[" );
+
+    for( uxIndex = 0U; uxIndex < xTest.uxStreams; uxIndex++ )
+    {
+        pxStream = &( xTest.xStreams[ uxIndex ] );
+
+        prvPut( &xWriter, ( uxIndex == 0U ) ? "{\"id\":" : ",{\"id\":" );
+        prvPutUnsigned( &xWriter, pxStream->ulId );
+        prvPut( &xWriter, ",\"bytes\":" );
+        prvPutUnsigned( &xWriter, pxStream->ullBytes );
+        prvPut( &xWriter, ",\"retransmits\":0,\"jitter\":" );
+        prvPutSeconds( &xWriter, pxStream->ulJitterUs );
+        prvPut( &xWriter, ",\"errors\":" );
+        prvPutUnsigned( &xWriter, pxStream->ulErrors );
+        prvPut( &xWriter, ",\"packets\":" );
+        prvPutUnsigned( &xWriter, pxStream->ulPackets );
+        prvPut( &xWriter, ",\"start_time\":0,\"end_time\":" );
+        prvPutSeconds( &xWriter, ulDurationUs );
+        prvPut( &xWriter, "}" );
+    }
+
+    prvPut( &xWriter, "]}" );
+}
+/*-----------------------------------------------------------*/
+
+static void prvSetTimeouts( Socket_t xSocket )
+{
+    TickType_t xTimeout = pdMS_TO_TICKS( configIPERF3_TIMEOUT_MS );
+
+    ( void ) FreeRTOS_setsockopt( xSocket, 0, FREERTOS_SO_RCVTIMEO, &xTimeout, sizeof( xTimeout ) );
+    ( void ) FreeRTOS_setsockopt( xSocket, 0, FREERTOS_SO_SNDTIMEO, &xTimeout, sizeof( xTimeout ) );
+}
+/*-----------------------------------------------------------*/
+
+static void prvSetWindows( Socket_t xSocket )
+{
+    WinProperties_t xWinProps;
+    int32_t lStreams = ( int32_t ) xTest.xParams.uxParallel;
+    int32_t lBuffer;
+    int32_t lWindow;
+
+    /* The side that sends needs the large TX buffer, the side that receives
+     * the large RX buffer.  The other direction only carries ACKs. */
+    if( xTest.xIsSender != pdFALSE )
+    {
+        lBuffer = ( int32_t ) ipconfigIPERF_TX_BUFSIZE / lStreams;
+        lWindow = ipconfigIPERF_TX_WINSIZE / lStreams;
+    }
+    else
+    {
+        lBuffer = ( int32_t ) ipconfigIPERF_RX_BUFSIZE / lStreams;
+        lWindow = ipconfigIPERF_RX_WINSIZE / lStreams;
+    }
+
+    lBuffer -= lBuffer % ( int32_t ) ipconfigTCP_MSS;
+    lBuffer = ( lBuffer < ( 2 * ( int32_t ) ipconfigTCP_MSS ) ) ? ( 2 * ( int32_t ) ipconfigTCP_MSS ) : lBuffer;
+    lWindow = ( lWindow < 2 ) ? 2 : lWindow;
+
+    xWinProps.lTxBufSize = ( xTest.xIsSender != pdFALSE ) ? lBuffer : ( 2 * ( int32_t ) ipconfigTCP_MSS );
+    xWinProps.lTxWinSize = ( xTest.xIsSender != pdFALSE ) ? lWindow : 2;
+    xWinProps.lRxBufSize = ( xTest.xIsSender != pdFALSE ) ? ( 2 * ( int32_t ) ipconfigTCP_MSS ) : lBuffer;
+    xWinProps.lRxWinSize = ( xTest.xIsSender != pdFALSE ) ? 2 : lWindow;
+
+    ( void ) FreeRTOS_setsockopt( xSocket, 0, FREERTOS_SO_WIN_PROPERTIES, &xWinProps, sizeof( xWinProps ) );
+}
+/*-----------------------------------------------------------*/
+
+static void prvReportInterval( TickType_t xFrom,
+                               TickType_t xTo,
+                               uint64_t ullBytes )
+{
+    uint32_t ulMilliseconds = pdTICKS_TO_MS( xTo - xFrom );
+    uint32_t ulKbits = ( ulMilliseconds != 0U ) ? ( uint32_t ) ( ( ullBytes * 8U ) / ulMilliseconds ) : 0U;
+
+    FreeRTOS_printf( ( "iperf3: %3u-%3u s %7u KB %4u.%02u Mbit/s\n",
+                       ( unsigned ) ( pdTICKS_TO_MS( xFrom ) / 1000U ),
+                       ( unsigned ) ( pdTICKS_TO_MS( xTo ) / 1000U ),
+                       ( unsigned ) ( ullBytes / 1024U ),
+                       ( unsigned ) ( ulKbits / 1000U ),
+                       ( unsigned ) ( ( ulKbits % 1000U ) / 10U ) ) );
+}
+/*-----------------------------------------------------------*/
+
+static void prvReportResult( void )
+{
+    uint64_t ullBytes = 0U;
+    uint32_t ulPackets = 0U;
+    uint32_t ulErrors = 0U;
+    uint32_t ulJitterUs = 0U;
+    UBaseType_t uxIndex;
+    TCPCongestionStats_t xCongestion;
+    const TCPRxBatch_t * pxBatch;
+
+    for( uxIndex = 0U; uxIndex < xTest.uxStreams; uxIndex++ )
+    {
+        ullBytes += xTest.xStreams[ uxIndex ].ullBytes;
+        ulPackets += xTest.xStreams[ uxIndex ].ulPackets;
+        ulErrors += xTest.xStreams[ uxIndex ].ulErrors;
+        ulJitterUs = ( xTest.xStreams[ uxIndex ].ulJitterUs > ulJitterUs ) ? xTest.xStreams[ uxIndex ].ulJitterUs : ulJitterUs;
+    }
+
+    FreeRTOS_printf( ( "iperf3: result, %s %s on %u stream(s)\n",
+                       ( xTest.xIsSender != pdFALSE ) ? "sent" : "received",
+                       ( xTest.xParams.xUDP != pdFALSE ) ? "UDP" : "TCP",
+                       ( unsigned ) xTest.uxStreams ) );
+    prvReportInterval( 0U, xTest.xEndTime - xTest.xStartTime, ullBytes );
+    FreeRTOS_printf( ( "iperf3: peer %s %u KB\n",
+                       ( xTest.xIsSender != pdFALSE ) ? "received" : "sent",
+                       ( unsigned ) ( xTest.ullPeerBytes / 1024U ) ) );
+
+    if( xTest.xParams.xUDP != pdFALSE )
+    {
+        if( xTest.xIsSender != pdFALSE )
+        {
+            ulPackets = xTest.ulPeerPackets;
+            ulErrors = xTest.ulPeerErrors;
+        }
+
+        FreeRTOS_printf( ( "iperf3: lost %u of %u datagrams, jitter %u us\n",
+                           ( unsigned ) ulErrors,
+                           ( unsigned ) ulPackets,
+                           ( unsigned ) ulJitterUs ) );
+    }
+    else if( xTest.xIsSender != pdFALSE )
+    {
+        for( uxIndex = 0U; uxIndex < xTest.uxStreams; uxIndex++ )
+        {
+            vTCPCongestionGetStats( &( xTest.xStreams[ uxIndex ].xCongestion ), &xCongestion );
+            FreeRTOS_printf( ( "iperf3: stream %u %s, cwnd %u, srtt %u ms, resent %u, recovered %u, timed out %u, stalled %u\n",
+                               ( unsigned ) uxIndex,
+                               xCongestion.pcAlgorithm,
+                               ( unsigned ) xCongestion.ulCwnd,
+                               ( unsigned ) xCongestion.ulSRTTMs,
+                               ( unsigned ) xCongestion.ulRetransmits,
+                               ( unsigned ) xCongestion.ulRecoveries,
+                               ( unsigned ) xCongestion.ulTimeouts,
+                               ( unsigned ) xCongestion.ulStalls ) );
+        }
+    }
+    else
+    {
+        for( uxIndex = 0U; uxIndex < xTest.uxStreams; uxIndex++ )
+        {
+            pxBatch = &( xTest.xStreams[ uxIndex ].xRxBatch );
+            FreeRTOS_printf( ( "iperf3: stream %u %u socket events, %u wake-ups, %u reads of %u bytes, largest %u\n",
+                               ( unsigned ) uxIndex,
+                               ( unsigned ) pxBatch->ulEvents,
+                               ( unsigned ) pxBatch->ulWakeUps,
+                               ( unsigned ) pxBatch->ulReads,
+                               ( unsigned ) ( ( pxBatch->ulReads != 0U ) ? ( pxBatch->ulBytes / pxBatch->ulReads ) : 0U ),
+                               ( unsigned ) pxBatch->ulLargestRead ) );
+        }
+    }
+}
+/*-----------------------------------------------------------*/
+
+#endif /* ( USE_IPERF == 1 ) */
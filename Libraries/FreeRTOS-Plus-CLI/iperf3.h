@@ -0,0 +1,95 @@
+#ifndef IPERF3_H
+#define IPERF3_H
+
+/* FreeRTOS+TCP includes. */
+#include "FreeRTOS_IP.h"
+#include "FreeRTOS_Sockets.h"
+
+/*
+ * Throughput tests with the protocol of iperf3, so that a stock iperf3 on a
+ * workstation can be the peer:
+ *
+ *     iperf3 -c <board>                 TCP, workstation sends
+ *     iperf3 -c <board> -R -P 2         TCP, board sends on 2 streams
+ *     iperf3 -c <board> -u -b 50M       UDP at 50 Mbit/s
+ *
+ * The server runs in its own task and serves one test at a time.  A client
+ * test is started with xIperf3StartClient(), against "iperf3 -s".  TCP and
+ * UDP, reverse mode and up to configIPERF3_MAX_STREAMS parallel streams are
+ * supported.  Tests are limited by time, not by a byte or block count, and
+ * bidirectional mode is refused.
+ *
+ * All streams share one buffer of ipconfigIPERF_RECV_BUFFER_SIZE bytes.  The
+ * TCP buffers and windows of ipconfigIPERF_TX_BUFSIZE/_WINSIZE and
+ * ipconfigIPERF_RX_BUFSIZE/_WINSIZE are divided over the parallel streams.
+ * Only the sending side of a stream gets a large TX buffer, and only the
+ * receiving side a large RX buffer.
+ *
+ * The board sends TCP data through a TX queue (tcp_sendfile.h) under
+ * congestion control (tcp_congestion.h), with the algorithm that the client
+ * asks for ("iperf3 -C vegas"), and logs the cwnd, RTT and loss counters of
+ * each stream with the result.
+ *
+ * Progress is logged every configIPERF3_INTERVAL_MS.  The results of both
+ * ends are logged when the test has finished.  UDP datagrams are stamped,
+ * and their jitter measured, with the microsecond uptime clock (uptime.h).
+ */
+
+/* The port of the control connection and of the data streams. */
+#ifndef configIPERF3_PORT
+    #define configIPERF3_PORT               5201U
+#endif
+
+#ifndef configIPERF3_MAX_STREAMS
+    #define configIPERF3_MAX_STREAMS        4U
+#endif
+
+/* Interval between two progress reports, 0 to only report the result. */
+#ifndef configIPERF3_INTERVAL_MS
+    #define configIPERF3_INTERVAL_MS        1000U
+#endif
+
+/* Time to wait for a step of the protocol, for example for the streams to
+ * connect. */
+#ifndef configIPERF3_TIMEOUT_MS
+    #define configIPERF3_TIMEOUT_MS         5000U
+#endif
+
+/* Size of the buffer for the JSON messages. */
+#ifndef configIPERF3_JSON_SIZE
+    #define configIPERF3_JSON_SIZE          1024U
+#endif
+
+typedef struct xIPERF3_PARAMS
+{
+    struct freertos_sockaddr xServer; /* Address and port of "iperf3 -s". */
+    BaseType_t xUDP;
+    BaseType_t xReverse;              /* The server sends. */
+    UBaseType_t uxParallel;           /* Number of streams. */
+    uint32_t ulTimeSeconds;
+    size_t uxLength;                  /* Bytes per write, or per UDP datagram. */
+    uint32_t ulBitrate;               /* UDP only, bits per second, 0 for no limit. */
+    char cCongestion[ 8 ];            /* TCP only, "reno" or "vegas", empty for "reno". */
+} Iperf3Params_t;
+
+/**
+ * @brief Create the server task, which listens on configIPERF3_PORT.  May be
+ * called more than once, the task is only created the first time.
+ *
+ * @return pdPASS if the task runs.
+ */
+BaseType_t xIperf3StartServer( void );
+
+/**
+ * @brief Start a test against an iperf3 server in a task of its own, which
+ * deletes itself when the test is done.
+ *
+ * @param pxParams The test, copied.  Zero fields get the iperf3 defaults:
+ * 10 seconds, 1 stream, 128 KB writes for TCP, 1448-byte datagrams at
+ * 1 Mbit/s for UDP.
+ *
+ * @return pdPASS if the test was started, pdFAIL when a test is running.
+ */
+BaseType_t xIperf3StartClient( const Iperf3Params_t * pxParams );
+
+#endif /* #ifndef IPERF3_H */
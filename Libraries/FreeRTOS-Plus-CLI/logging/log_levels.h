@@ -0,0 +1,195 @@
+#ifndef LOG_LEVELS_H
+#define LOG_LEVELS_H
+
+/* Standard includes. */
+#include <stdint.h>
+
+/*
+ * Log levels and modules.  This file is included by FreeRTOSConfig.h, so it
+ * must not include FreeRTOS.h.
+ *
+ * Log messages are written with LogError(), LogWarn(), LogInfo() and
+ * LogDebug(), with the same double parentheses as configPRINTF():
+ *
+ *     LogWarn( ( "SNTP: cannot resolve %s\n", pcServer ) );
+ *
+ * configPRINTF() and FreeRTOS_printf() are LogInfo(), FreeRTOS_debug_printf()
+ * is LogDebug().
+ *
+ * Every message belongs to the module logMODULE of the file that writes it.
+ * A file picks its module by defining logMODULE before its first include;
+ * FreeRTOS+TCP and files that do not pick one are eLogModuleIP.
+ *
+ * A message is formatted only when its level is at or below the threshold of
+ * its module, which can be changed at run time with vLoggingSetLevel().  A
+ * message that is filtered out costs one compare and one increment.  Levels
+ * above configLOG_LEVEL_COMPILED are removed at compile time, including their
+ * arguments.
+ */
+
+#define logLEVEL_NONE     0U
+#define logLEVEL_ERROR    1U
+#define logLEVEL_WARN     2U
+#define logLEVEL_INFO     3U
+#define logLEVEL_DEBUG    4U
+
+/* The most verbose level that is compiled in.  Set it to logLEVEL_DEBUG in
+ * FreeRTOSConfig.h to compile the debug messages in, those of FreeRTOS+TCP
+ * included, see ipconfigHAS_DEBUG_PRINTF. */
+#ifndef configLOG_LEVEL_COMPILED
+    #define configLOG_LEVEL_COMPILED    logLEVEL_INFO
+#endif
+
+/* The threshold of every module after a reset. */
+#ifndef configLOG_LEVEL_DEFAULT
+    #define configLOG_LEVEL_DEFAULT     logLEVEL_INFO
+#endif
+
+typedef enum eLOG_MODULE
+{
+    eLogModuleIP = 0,   /* FreeRTOS+TCP, and files without a module. */
+    eLogModuleApp,      /* Start-up, crash dump, trace, clocks. */
+    eLogModuleNet,      /* Network services, statistics, DHCP, ping, SNTP. */
+    eLogModuleEcho,     /* Echo clients. */
+    eLogModuleIperf,
+    eLogModuleCount
+} LogModule_t;
+
+typedef struct xLOG_MODULE_STATE
+{
+    uint8_t ucLevel;          /* Threshold, the most verbose level shown. */
+    uint32_t ulEmitted;
+    uint32_t ulSuppressed;
+} LogModuleState_t;
+
+#ifndef logMODULE
+    #define logMODULE    eLogModuleIP
+#endif
+
+/* Owned by logging.c, read by the macros below. */
+extern LogModuleState_t xLogModules[ eLogModuleCount ];
+
+/* Format and queue one message, called by the macros below. */
+void vLoggingPrintfLevel( LogModule_t xModule,
+                          uint8_t ucLevel,
+                          const char * pcFormat,
+                          ... );
+
+/* Removes the parentheses around the arguments of a log macro. */
+#define logARGUMENTS( ... )    __VA_ARGS__
+
+#define logPRINT( xModule, xLevel, X )                                     \
+    do                                                                     \
+    {                                                                      \
+        if( ( xLevel ) <= xLogModules[ ( xModule ) ].ucLevel )             \
+        {                                                                  \
+            vLoggingPrintfLevel( ( xModule ), ( xLevel ), logARGUMENTS X ); \
+        }                                                                  \
+        else                                                               \
+        {                                                                  \
+            xLogModules[ ( xModule ) ].ulSuppressed++;                     \
+        }                                                                  \
+    } while( 0 )
+
+#if ( configLOG_LEVEL_COMPILED >= logLEVEL_ERROR )
+    #define LogError( X )    logPRINT( logMODULE, logLEVEL_ERROR, X )
+#else
+    #define LogError( X )    do {} while( 0 )
+#endif
+
+#if ( configLOG_LEVEL_COMPILED >= logLEVEL_WARN )
+    #define LogWarn( X )     logPRINT( logMODULE, logLEVEL_WARN, X )
+#else
+    #define LogWarn( X )     do {} while( 0 )
+#endif
+
+#if ( configLOG_LEVEL_COMPILED >= logLEVEL_INFO )
+    #define LogInfo( X )     logPRINT( logMODULE, logLEVEL_INFO, X )
+#else
+    #define LogInfo( X )     do {} while( 0 )
+#endif
+
+#if ( configLOG_LEVEL_COMPILED >= logLEVEL_DEBUG )
+    #define LogDebug( X )    logPRINT( logMODULE, logLEVEL_DEBUG, X )
+#else
+    #define LogDebug( X )    do {} while( 0 )
+#endif
+
+/*
+ * From an interrupt, use LogErrorFromISR() to LogDebugFromISR() instead.  They
+ * do not format and do not allocate: the format and its arguments are copied
+ * into a ring, and the logging task formats them later.  Therefore:
+ *
+ * - The format and every %s argument must stay valid, string literals for
+ *   example.
+ * - At most logISR_MAX_ARGUMENTS arguments, each 32 bits or less; no %ll.
+ *   More arguments do not compile.
+ * - Like every FromISR function, they may not be called from an interrupt
+ *   above configMAX_SYSCALL_INTERRUPT_PRIORITY.
+ *
+ * The cost is bounded: the threshold compare, a critical section that copies
+ * the format and logISR_MAX_ARGUMENTS words, and, when both the ring and the
+ * log queue were empty, one xQueueSendFromISR() that wakes the logging task.
+ * Nothing is formatted, allocated or waited for.  The cycles of every call
+ * are measured with the DWT cycle counter, and vLoggingReport() shows the
+ * most taken so far as "at most N cycles".
+ */
+#define logISR_MAX_ARGUMENTS    4
+
+/* Copy one message into the ring, called by the macros below. */
+void vLoggingPrintfFromISR( LogModule_t xModule,
+                            uint8_t ucLevel,
+                            uint32_t ulArgumentCount,
+                            const char * pcFormat,
+                            ... );
+
+/* The number of arguments that follow the format, up to 7. */
+#define logARGUMENT_COUNT( ... ) \
+    logARGUMENT_COUNT_N( __VA_ARGS__, 7, 6, 5, 4, 3, 2, 1, 0, ~ )
+#define logARGUMENT_COUNT_N( pcFormat, a1, a2, a3, a4, a5, a6, a7, N, ... )    N
+
+/* A negative array size, so a compile error, for too many arguments. */
+#define logCHECK_ARGUMENT_COUNT( N ) \
+    ( ( void ) sizeof( char[ ( ( N ) <= logISR_MAX_ARGUMENTS ) ? 1 : -1 ] ) )
+
+#define logPRINT_FROM_ISR( xModule, xLevel, X )                                         \
+    do                                                                                  \
+    {                                                                                   \
+        logCHECK_ARGUMENT_COUNT( logARGUMENT_COUNT X );                                 \
+                                                                                        \
+        if( ( xLevel ) <= xLogModules[ ( xModule ) ].ucLevel )                          \
+        {                                                                               \
+            vLoggingPrintfFromISR( ( xModule ), ( xLevel ), logARGUMENT_COUNT X,        \
+                                   logARGUMENTS X );                                    \
+        }                                                                               \
+        else                                                                            \
+        {                                                                               \
+            xLogModules[ ( xModule ) ].ulSuppressed++;                                  \
+        }                                                                               \
+    } while( 0 )
+
+#if ( configLOG_LEVEL_COMPILED >= logLEVEL_ERROR )
+    #define LogErrorFromISR( X )    logPRINT_FROM_ISR( logMODULE, logLEVEL_ERROR, X )
+#else
+    #define LogErrorFromISR( X )    do {} while( 0 )
+#endif
+
+#if ( configLOG_LEVEL_COMPILED >= logLEVEL_WARN )
+    #define LogWarnFromISR( X )     logPRINT_FROM_ISR( logMODULE, logLEVEL_WARN, X )
+#else
+    #define LogWarnFromISR( X )     do {} while( 0 )
+#endif
+
+#if ( configLOG_LEVEL_COMPILED >= logLEVEL_INFO )
+    #define LogInfoFromISR( X )     logPRINT_FROM_ISR( logMODULE, logLEVEL_INFO, X )
+#else
+    #define LogInfoFromISR( X )     do {} while( 0 )
+#endif
+
+#if ( configLOG_LEVEL_COMPILED >= logLEVEL_DEBUG )
+    #define LogDebugFromISR( X )    logPRINT_FROM_ISR( logMODULE, logLEVEL_DEBUG, X )
+#else
+    #define LogDebugFromISR( X )    do {} while( 0 )
+#endif
+
+#endif /* #ifndef LOG_LEVELS_H */
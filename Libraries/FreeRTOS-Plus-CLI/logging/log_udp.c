@@ -0,0 +1,346 @@
+/* Standard includes. */
+#include <stdio.h>
+#include <string.h>
+
+/* FreeRTOS includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+
+/* FreeRTOS+TCP includes. */
+#include "FreeRTOS_IP.h"
+#include "FreeRTOS_Sockets.h"
+
+#include "log_udp.h"
+#include "route_cache.h"
+#include "wall_clock.h"
+
+/* Syslog severity of each level of log_levels.h: err, warning, info, debug. */
+static const uint8_t ucSeverities[] = { 6U, 3U, 4U, 6U, 7U };
+
+/* Room for the header of one message, up to the text. */
+#define logudpHEADER_SIZE        128U
+
+/*
+ * Write the RFC 5424 time stamp of now into pcBuffer, "-" when the wall
+ * clock was not set yet.
+ */
+static void prvFormatTime( char * pcBuffer,
+                           size_t uxSize );
+
+/*
+ * Add the tokens earned since the last call to the rate limit.
+ */
+static void prvRefill( void );
+
+/*
+ * Send the batch, if it holds anything.
+ */
+static void prvSendBatch( void );
+
+/*
+ * Open or close the socket as asked for by vLogUDPStart() and vLogUDPStop().
+ * Returns pdTRUE when the socket is open.
+ */
+static BaseType_t prvUpdateSocket( void );
+
+/*-----------------------------------------------------------*/
+
+/* Set by vLogUDPStart() and vLogUDPStop(), from any task. */
+static volatile BaseType_t xStarted = pdFALSE;
+static struct freertos_sockaddr xCollector;
+
+/* Only used by the logging task. */
+static Socket_t xSocket = FREERTOS_INVALID_SOCKET;
+static char cBatch[ configLOG_UDP_DATAGRAM_SIZE ];
+static size_t uxBatchLength = 0U;
+static uint32_t ulBatchMessages = 0U;
+static TickType_t xBatchStarted = 0U;
+static uint32_t ulSequence = 0U;
+static uint32_t ulTokens = configLOG_UDP_BURST_BYTES;
+static TickType_t xLastRefill = 0U;
+
+static LogUDPStats_t xStats;
+
+/*-----------------------------------------------------------*/
+
+static void prvFormatTime( char * pcBuffer,
+                           size_t uxSize )
+{
+    uint64_t ullNow;
+    uint32_t ulSeconds;
+    int32_t lDays;
+    int32_t lEra;
+    uint32_t ulDayOfEra;
+    uint32_t ulYearOfEra;
+    uint32_t ulDayOfYear;
+    uint32_t ulMonthIndex;
+    int32_t lYear;
+    uint32_t ulMonth;
+    uint32_t ulDay;
+
+    if( xWallClockIsSet() == pdFALSE )
+    {
+        ( void ) snprintf( pcBuffer, uxSize, "-" );
+        return;
+    }
+
+    ullNow = ullWallClockMicroseconds();
+    lDays = ( int32_t ) ( ullNow / ( 86400ULL * 1000000ULL ) );
+    ulSeconds = ( uint32_t ) ( ( ullNow / 1000000ULL ) % 86400ULL );
+
+    /* The civil date of a day number, in eras of 400 years from 0000-03-01. */
+    lDays += 719468;
+    lEra = lDays / 146097;
+    ulDayOfEra = ( uint32_t ) ( lDays - ( lEra * 146097 ) );
+    ulYearOfEra = ( ulDayOfEra - ( ulDayOfEra / 1460U ) + ( ulDayOfEra / 36524U ) - ( ulDayOfEra / 146096U ) ) / 365U;
+    ulDayOfYear = ulDayOfEra - ( ( 365U * ulYearOfEra ) + ( ulYearOfEra / 4U ) - ( ulYearOfEra / 100U ) );
+    ulMonthIndex = ( ( 5U * ulDayOfYear ) + 2U ) / 153U;
+    ulDay = ulDayOfYear - ( ( ( 153U * ulMonthIndex ) + 2U ) / 5U ) + 1U;
+    ulMonth = ( ulMonthIndex < 10U ) ? ( ulMonthIndex + 3U ) : ( ulMonthIndex - 9U );
+    lYear = ( int32_t ) ulYearOfEra + ( lEra * 400 ) + ( ( ulMonth <= 2U ) ? 1 : 0 );
+
+    ( void ) snprintf( pcBuffer, uxSize, "%04d-%02u-%02uT%02u:%02u:%02u.%06uZ",
+                       ( int ) lYear, ( unsigned ) ulMonth, ( unsigned ) ulDay,
+                       ( unsigned ) ( ulSeconds / 3600U ), ( unsigned ) ( ( ulSeconds / 60U ) % 60U ), ( unsigned ) ( ulSeconds % 60U ),
+                       ( unsigned ) ( ullNow % 1000000ULL ) );
+}
+/*-----------------------------------------------------------*/
+
+static void prvRefill( void )
+{
+    TickType_t xNow = xTaskGetTickCount();
+    uint64_t ullEarned = ( ( uint64_t ) ( xNow - xLastRefill ) * configLOG_UDP_RATE_BYTES ) / configTICK_RATE_HZ;
+
+    if( ullEarned > 0U )
+    {
+        xLastRefill = xNow;
+
+        if( ( ulTokens + ullEarned ) > configLOG_UDP_BURST_BYTES )
+        {
+            ulTokens = configLOG_UDP_BURST_BYTES;
+        }
+        else
+        {
+            ulTokens += ( uint32_t ) ullEarned;
+        }
+    }
+}
+/*-----------------------------------------------------------*/
+
+static void prvSendBatch( void )
+{
+    struct freertos_sockaddr xTo;
+    Route_t xRoute;
+    int32_t lSent = 0;
+
+    if( uxBatchLength > 0U )
+    {
+        taskENTER_CRITICAL();
+        {
+            xTo = xCollector;
+        }
+        taskEXIT_CRITICAL();
+
+        /* Without an end-point towards the collector, for example while DHCP
+         * is still busy, the batch is dropped without a network buffer. */
+        if( xRouteCacheLookup( &xTo, &xRoute ) == pdPASS )
+        {
+            lSent = FreeRTOS_sendto( xSocket, cBatch, uxBatchLength, 0, &xTo, sizeof( xTo ) );
+        }
+
+        if( lSent > 0 )
+        {
+            xStats.ulDatagrams++;
+            xStats.ulMessages += ulBatchMessages;
+            xStats.ulBytes += ( uint32_t ) uxBatchLength;
+        }
+        else
+        {
+            xStats.ulSendFailures++;
+            xStats.ulLostMessages += ulBatchMessages;
+        }
+
+        uxBatchLength = 0U;
+        ulBatchMessages = 0U;
+    }
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvUpdateSocket( void )
+{
+    TickType_t xNoWait = 0U;
+
+    if( xStarted == pdFALSE )
+    {
+        if( xSocket != FREERTOS_INVALID_SOCKET )
+        {
+            prvSendBatch();
+            ( void ) FreeRTOS_closesocket( xSocket );
+            xSocket = FREERTOS_INVALID_SOCKET;
+        }
+    }
+    else if( xSocket == FREERTOS_INVALID_SOCKET )
+    {
+        xSocket = FreeRTOS_socket( FREERTOS_AF_INET, FREERTOS_SOCK_DGRAM, FREERTOS_IPPROTO_UDP );
+
+        if( xSocket != FREERTOS_INVALID_SOCKET )
+        {
+            /* When there is no network buffer, drop the batch rather than
+             * hold up the log. */
+            ( void ) FreeRTOS_setsockopt( xSocket, 0, FREERTOS_SO_SNDTIMEO, &xNoWait, sizeof( xNoWait ) );
+        }
+    }
+    else
+    {
+        /* Open already. */
+    }
+
+    return ( xSocket != FREERTOS_INVALID_SOCKET ) ? pdTRUE : pdFALSE;
+}
+/*-----------------------------------------------------------*/
+
+void vLogUDPStart( const struct freertos_sockaddr * pxCollector )
+{
+    taskENTER_CRITICAL();
+    {
+        xCollector = *pxCollector;
+        xStarted = pdTRUE;
+    }
+    taskEXIT_CRITICAL();
+}
+/*-----------------------------------------------------------*/
+
+void vLogUDPStop( void )
+{
+    xStarted = pdFALSE;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xLogUDPWrite( const char * pcMessage,
+                         uint8_t ucLevel )
+{
+    char cTime[ 32 ];
+    char cHeader[ logudpHEADER_SIZE ];
+    size_t uxHeaderLength;
+    size_t uxTextLength;
+    size_t uxLength;
+    uint8_t ucSeverity;
+
+    if( prvUpdateSocket() == pdFALSE )
+    {
+        return pdFALSE;
+    }
+
+    /* vLoggingPrintf() ends the messages in "\n\r" or "\r". */
+    uxTextLength = strlen( pcMessage );
+
+    while( ( uxTextLength > 0U ) && ( ( pcMessage[ uxTextLength - 1U ] == '\r' ) || ( pcMessage[ uxTextLength - 1U ] == '\n' ) ) )
+    {
+        uxTextLength--;
+    }
+
+    ucSeverity = ( ucLevel < sizeof( ucSeverities ) ) ? ucSeverities[ ucLevel ] : ucSeverities[ logLEVEL_DEBUG ];
+
+    prvFormatTime( cTime, sizeof( cTime ) );
+    uxHeaderLength = ( size_t ) snprintf( cHeader, sizeof( cHeader ), "<%u>1 %s %s %s - - [meta sequenceId=\"%u\"] ",
+                                          ( unsigned ) ( ( configLOG_UDP_FACILITY * 8U ) + ucSeverity ), cTime,
+                                          configLOG_UDP_HOSTNAME, configLOG_UDP_APP_NAME, ( unsigned ) ulSequence );
+    ulSequence++;
+
+    if( uxHeaderLength >= sizeof( cHeader ) )
+    {
+        uxHeaderLength = sizeof( cHeader ) - 1U;
+    }
+
+    /* A message longer than a datagram is cut. */
+    if( ( uxHeaderLength + uxTextLength + 1U ) > sizeof( cBatch ) )
+    {
+        uxTextLength = sizeof( cBatch ) - uxHeaderLength - 1U;
+    }
+
+    uxLength = uxHeaderLength + uxTextLength + 1U;
+
+    prvRefill();
+
+    if( uxLength > ulTokens )
+    {
+        xStats.ulRateLimited++;
+    }
+    else
+    {
+        ulTokens -= ( uint32_t ) uxLength;
+
+        if( ( uxBatchLength + uxLength ) > sizeof( cBatch ) )
+        {
+            prvSendBatch();
+        }
+
+        if( uxBatchLength == 0U )
+        {
+            xBatchStarted = xTaskGetTickCount();
+        }
+
+        memcpy( &( cBatch[ uxBatchLength ] ), cHeader, uxHeaderLength );
+        memcpy( &( cBatch[ uxBatchLength + uxHeaderLength ] ), pcMessage, uxTextLength );
+        cBatch[ uxBatchLength + uxLength - 1U ] = '\n';
+        uxBatchLength += uxLength;
+        ulBatchMessages++;
+
+        vLogUDPFlush();
+    }
+
+    return pdTRUE;
+}
+/*-----------------------------------------------------------*/
+
+void vLogUDPFlush( void )
+{
+    if( ( xStarted == pdFALSE ) || ( xSocket == FREERTOS_INVALID_SOCKET ) )
+    {
+        ( void ) prvUpdateSocket();
+    }
+    else if( ( uxBatchLength > 0U ) &&
+             ( ( xTaskGetTickCount() - xBatchStarted ) >= pdMS_TO_TICKS( configLOG_UDP_FLUSH_MS ) ) )
+    {
+        prvSendBatch();
+    }
+    else
+    {
+        /* Not due yet. */
+    }
+}
+/*-----------------------------------------------------------*/
+
+TickType_t xLogUDPFlushDelay( void )
+{
+    TickType_t xElapsed;
+    TickType_t xDelay = portMAX_DELAY;
+
+    if( ( xStarted == pdFALSE ) && ( xSocket != FREERTOS_INVALID_SOCKET ) )
+    {
+        /* Stopped, close the socket now. */
+        xDelay = 0U;
+    }
+    else if( uxBatchLength > 0U )
+    {
+        xElapsed = xTaskGetTickCount() - xBatchStarted;
+        xDelay = ( xElapsed >= pdMS_TO_TICKS( configLOG_UDP_FLUSH_MS ) ) ? 0U : ( pdMS_TO_TICKS( configLOG_UDP_FLUSH_MS ) - xElapsed );
+    }
+    else
+    {
+        /* Nothing to send. */
+    }
+
+    return xDelay;
+}
+/*-----------------------------------------------------------*/
+
+void vLogUDPGetStats( LogUDPStats_t * pxStats )
+{
+    taskENTER_CRITICAL();
+    {
+        *pxStats = xStats;
+    }
+    taskEXIT_CRITICAL();
+}
+/*-----------------------------------------------------------*/
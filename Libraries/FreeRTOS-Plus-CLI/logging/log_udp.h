@@ -0,0 +1,119 @@
+#ifndef LOG_UDP_H
+#define LOG_UDP_H
+
+/* FreeRTOS includes. */
+#include "FreeRTOS.h"
+
+/* FreeRTOS+TCP includes. */
+#include "FreeRTOS_Sockets.h"
+
+/*
+ * A network sink for the logging task: log messages go to a syslog collector
+ * as RFC 5424 messages, instead of to the 115200 baud UART.
+ *
+ * The logging task passes every message to xLogUDPWrite().  While the sink is
+ * not started, for example while the network is down, that function returns
+ * pdFALSE and the message goes to the UART as before.  Once started, the
+ * messages are batched into datagrams of at most configLOG_UDP_DATAGRAM_SIZE
+ * bytes.  A datagram is sent when it is full, or configLOG_UDP_FLUSH_MS after
+ * its first message.
+ *
+ * A batch holds one or more syslog messages, each ending in a newline.  Each
+ * message has the form:
+ *
+ *     <134>1 2026-10-19T12:00:00.123456Z stm32h7 freertos - - [meta sequenceId="42"] text
+ *
+ * The severity follows the level of the message, see log_levels.h.  The time
+ * is "-" until the wall clock is set.  A gap in sequenceId shows messages that
+ * were lost on the way or dropped here.  Collectors that take a datagram as
+ * one message show a batch as one multi-line message.
+ * tools/log_receiver.py splits the batches.
+ *
+ * A token bucket limits the traffic to configLOG_UDP_RATE_BYTES per second,
+ * with bursts of configLOG_UDP_BURST_BYTES.  Messages over the limit are
+ * dropped and counted.
+ */
+
+#ifndef configLOG_UDP_DATAGRAM_SIZE
+    #define configLOG_UDP_DATAGRAM_SIZE    1472U
+#endif
+
+#ifndef configLOG_UDP_FLUSH_MS
+    #define configLOG_UDP_FLUSH_MS         100U
+#endif
+
+#ifndef configLOG_UDP_RATE_BYTES
+    #define configLOG_UDP_RATE_BYTES       65536U
+#endif
+
+#ifndef configLOG_UDP_BURST_BYTES
+    #define configLOG_UDP_BURST_BYTES      16384U
+#endif
+
+/* Syslog facility, local0. */
+#ifndef configLOG_UDP_FACILITY
+    #define configLOG_UDP_FACILITY         16U
+#endif
+
+#ifndef configLOG_UDP_HOSTNAME
+    #define configLOG_UDP_HOSTNAME         "stm32h7"
+#endif
+
+#ifndef configLOG_UDP_APP_NAME
+    #define configLOG_UDP_APP_NAME         "freertos"
+#endif
+
+typedef struct xLOG_UDP_STATS
+{
+    uint32_t ulMessages;       /* Sent in a datagram. */
+    uint32_t ulDatagrams;
+    uint32_t ulBytes;
+    uint32_t ulRateLimited;    /* Messages dropped by the rate limit. */
+    uint32_t ulSendFailures;   /* Datagrams that could not be sent. */
+    uint32_t ulLostMessages;   /* Messages in those datagrams. */
+} LogUDPStats_t;
+
+/**
+ * @brief Send the log to a collector from now on.  May be called from any
+ * task, the logging task opens the socket when it handles the next message.
+ *
+ * @param pxCollector Address and port of the collector, copied.
+ */
+void vLogUDPStart( const struct freertos_sockaddr * pxCollector );
+
+/**
+ * @brief Go back to the UART, for example when the network goes down.
+ * Messages still in the batch are sent first, if possible.
+ */
+void vLogUDPStop( void );
+
+/**
+ * @brief Called by the logging task for every message.
+ *
+ * @param pcMessage The text.
+ * @param ucLevel The level of log_levels.h, which sets the syslog severity.
+ *
+ * @return pdTRUE if the message was taken, or dropped by the rate limit;
+ * pdFALSE when the sink is stopped and the message should go to the UART.
+ */
+BaseType_t xLogUDPWrite( const char * pcMessage,
+                         uint8_t ucLevel );
+
+/**
+ * @brief Called by the logging task when no message came within
+ * xLogUDPFlushDelay().  Sends the batch when it is due.
+ */
+void vLogUDPFlush( void );
+
+/**
+ * @brief How long the logging task may wait for the next message before the
+ * batch must be flushed, portMAX_DELAY if the batch is empty.
+ */
+TickType_t xLogUDPFlushDelay( void );
+
+/**
+ * @brief Get a copy of the statistics.
+ */
+void vLogUDPGetStats( LogUDPStats_t * pxStats );
+
+#endif /* #ifndef LOG_UDP_H */
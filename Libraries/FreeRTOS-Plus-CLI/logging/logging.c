@@ -1,3 +1,6 @@
+/* The log messages of this file, see log_levels.h. */
+#define logMODULE    eLogModuleApp
+
 /* Standard includes. */
 #include <stdio.h>
 #include <stdarg.h>
@@ -9,6 +12,11 @@
 #include "queue.h"
 #include "semphr.h"
 
+#include "logging.h"
+#include "log_udp.h"
+
+/* For the cycle counter. */
+#include "stm32h7xx_hal.h"
 
 /* Sanity check all the definitions required by this file are set. */
 #ifndef configPRINT_STRING
@@ -19,9 +27,68 @@
     #error configLOGGING_MAX_MESSAGE_LENGTH must be defined in FreeRTOSConfig.h to use this logging file.  configLOGGING_MAX_MESSAGE_LENGTH sets the size of the buffer into which formatted text is written, so also sets the maximum log message length.
 #endif
 
+/* Queue slots that only error messages may use, so that a storm of other
+ * messages cannot hide an error. */
+#ifndef configLOGGING_ERROR_RESERVE
+    #define configLOGGING_ERROR_RESERVE    8U
+#endif
+
+/* Further queue slots that debug messages may not use, so that a storm of
+ * debug messages cannot hide warnings and info either. */
+#ifndef configLOGGING_INFO_RESERVE
+    #define configLOGGING_INFO_RESERVE    16U
+#endif
+
+/* Set to 1 to show a line that repeats as "last message repeated N times". */
+#ifndef configLOGGING_MERGE_REPEATS
+    #define configLOGGING_MERGE_REPEATS    1
+#endif
+
+/* The longest a count of repeats is held back. */
+#ifndef configLOGGING_REPEAT_FLUSH_MS
+    #define configLOGGING_REPEAT_FLUSH_MS    1000U
+#endif
+
+/* The buffers that carry messages to the logging task.  They are not taken
+ * from the heap: a storm of messages cannot use up the heap of the rest of
+ * the application, and running out of buffers is not a failure of
+ * pvPortMalloc(), which would call vApplicationMallocFailedHook(). */
+#ifndef configLOGGING_MESSAGE_BUFFERS
+    #define configLOGGING_MESSAGE_BUFFERS    32U
+#endif
+
+/* The number of messages from interrupts that can wait for the logging task. */
+#ifndef configLOGGING_ISR_RECORDS
+    #define configLOGGING_ISR_RECORDS    32U
+#endif
+
 /* A block time of 0 just means don't block. */
 #define loggingDONT_BLOCK    0
 
+/* Room for the lines that the logging task writes itself. */
+#define loggingMARKER_LENGTH    80
+
+/* The buffer that carries a message to the logging task. */
+typedef struct xLOG_MESSAGE
+{
+    uint16_t usDropped;        /* Messages dropped just before this one. */
+    uint16_t usDroppedErrors;  /* Error messages among them. */
+    uint8_t ucLevel;
+    char cText[];
+} LogMessage_t;
+
+#define loggingMAX_TEXT_LENGTH    ( configLOGGING_MAX_MESSAGE_LENGTH - sizeof( LogMessage_t ) )
+
+/* A message from an interrupt, formatted later by the logging task. */
+typedef struct xLOG_ISR_RECORD
+{
+    const char * pcFormat;
+    uint32_t ulArguments[ logISR_MAX_ARGUMENTS ];
+    uint16_t usDropped;        /* As in LogMessage_t. */
+    uint16_t usDroppedErrors;
+    uint8_t ucLevel;
+} LogISRRecord_t;
+
 /*
  * Wrapper function for vsnprintf to return the actual number of
  * characters written.
@@ -62,13 +129,84 @@ static int vsnprintf_safe( char * s,
  * written.  Using a separate task also serializes access to the output port.
  *
  * The structure of this task is very simple; it blocks on a queue to wait for
- * a pointer to a string, sending any received strings to a macro that performs
- * the actual output.  The macro is port specific, so implemented outside of
- * this file.  This version uses dynamic memory, so the buffer that contained
- * the log message is freed after it has been output.
+ * a pointer to a message, sending any received messages to a macro that
+ * performs the actual output.  The macro is port specific, so implemented
+ * outside of this file.  The buffer that contained the log message is
+ * returned to the pool of configLOGGING_MESSAGE_BUFFERS after it has been
+ * output.
+ *
+ * While the network sink of log_udp.h is started, the messages go to it
+ * instead of the macro.  The task then wakes up in time to send a batch that
+ * is due, even when no further message arrives.
+ *
+ * A message that carries a count of dropped messages is preceded by a
+ * "messages dropped" line.  Repeats of the same message are counted instead
+ * of written, until a different message arrives or
+ * configLOGGING_REPEAT_FLUSH_MS has passed.
  */
 static void prvLoggingTask( void * pvParameters );
 
+/*
+ * Format a message and pass it to the logging task.  A message is dropped,
+ * before it is formatted, when only the slots that are reserved for more
+ * severe levels are left.  The number of messages dropped travels with the
+ * next message that is queued.
+ */
+static void prvLoggingVPrintf( uint8_t ucLevel,
+                               const char * pcFormat,
+                               va_list xArgs );
+
+/*
+ * The number of free queue slots that a message of level ucLevel must leave.
+ */
+static UBaseType_t prvReserve( uint8_t ucLevel );
+
+/*
+ * Take a message buffer from the pool.  As with the queue, a message of level
+ * ucLevel may not take the buffers that are reserved for more severe levels.
+ * Returns NULL when no buffer is left for the level.
+ */
+static LogMessage_t * prvTakeBuffer( uint8_t ucLevel );
+
+/*
+ * Return a buffer of prvTakeBuffer() to the pool.
+ */
+static void prvReturnBuffer( LogMessage_t * pxMessage );
+
+/*
+ * Count a message that could not be queued.  Called with the scheduler
+ * suspended.
+ */
+static void prvDropped( uint8_t ucLevel );
+
+/*
+ * Write a line to the network sink, or to the UART while the sink is stopped.
+ */
+static void prvOutput( uint8_t ucLevel,
+                       const char * pcText );
+
+/*
+ * Write a message received by the logging task, merging repeats of the
+ * previous one.  Takes ownership of the buffer.
+ */
+static void prvWriteMessage( LogMessage_t * pxMessage );
+
+/*
+ * Write the "last message repeated" line, if repeats were merged.
+ */
+static void prvFlushRepeats( void );
+
+/*
+ * The block time of the logging task, until the next batch or count of
+ * repeats is due.
+ */
+static TickType_t prvWaitTime( void );
+
+/*
+ * Format the messages that interrupts left in the ring, and write them.
+ */
+static void prvDrainISRRecords( void );
+
 /*-----------------------------------------------------------*/
 
 /*
@@ -77,6 +215,56 @@ static void prvLoggingTask( void * pvParameters );
  */
 static QueueHandle_t xQueue = NULL;
 
+/* Messages that vLoggingPrintf() had to drop. */
+static volatile uint32_t ulQueueFull = 0U;
+static volatile uint32_t ulNoBuffer = 0U;
+
+/* The pool of message buffers, and a stack of the free ones. */
+static uint32_t ulMessageBuffers[ configLOGGING_MESSAGE_BUFFERS ][ ( configLOGGING_MAX_MESSAGE_LENGTH + 3U ) / 4U ];
+static LogMessage_t * pxFreeBuffers[ configLOGGING_MESSAGE_BUFFERS ];
+static UBaseType_t uxFreeBuffers = 0U;
+
+/* Dropped since the last message that was queued. */
+static uint16_t usPendingDrops = 0U;
+static uint16_t usPendingErrorDrops = 0U;
+
+/* Written by interrupts in a critical section, read by the logging task.  The
+ * head and the tail run freely; the ring holds head - tail records.  Messages
+ * that did not fit are counted, and the count travels with the next record. */
+static LogISRRecord_t xISRRecords[ configLOGGING_ISR_RECORDS ];
+static volatile uint32_t ulISRHead = 0U;
+static volatile uint32_t ulISRTail = 0U;
+static uint16_t usISRPendingDrops = 0U;
+static uint16_t usISRPendingErrorDrops = 0U;
+static volatile uint32_t ulISRFull = 0U;
+static volatile uint32_t ulISRMaxCycles = 0U;
+
+#if ( configLOGGING_MERGE_REPEATS == 1 )
+    /* Only used by the logging task. */
+    static LogMessage_t * pxLastMessage = NULL;
+    static uint32_t ulRepeats = 0U;
+    static TickType_t xFirstRepeat = 0U;
+#endif
+
+/* The thresholds and counters of the modules of log_levels.h. */
+LogModuleState_t xLogModules[ eLogModuleCount ] =
+{
+    { configLOG_LEVEL_DEFAULT, 0U, 0U },
+    { configLOG_LEVEL_DEFAULT, 0U, 0U },
+    { configLOG_LEVEL_DEFAULT, 0U, 0U },
+    { configLOG_LEVEL_DEFAULT, 0U, 0U },
+    { configLOG_LEVEL_DEFAULT, 0U, 0U }
+};
+
+static const char * const pcModuleNames[ eLogModuleCount ] =
+{
+    "ip",
+    "app",
+    "net",
+    "echo",
+    "iperf"
+};
+
 /*-----------------------------------------------------------*/
 
 static int vsnprintf_safe( char * s,
@@ -121,8 +309,21 @@ BaseType_t xLoggingTaskInitialize( uint16_t usStackSize,
     /* Ensure the logging task has not been created already. */
     if( xQueue == NULL )
     {
-        /* Create the queue used to pass pointers to strings to the logging task. */
-        xQueue = xQueueCreate( uxQueueLength, sizeof( char ** ) );
+        configASSERT( uxQueueLength > ( configLOGGING_ERROR_RESERVE + configLOGGING_INFO_RESERVE ) );
+        configASSERT( configLOGGING_MESSAGE_BUFFERS > ( configLOGGING_ERROR_RESERVE + configLOGGING_INFO_RESERVE ) );
+
+        for( uxFreeBuffers = 0U; uxFreeBuffers < configLOGGING_MESSAGE_BUFFERS; uxFreeBuffers++ )
+        {
+            pxFreeBuffers[ uxFreeBuffers ] = ( LogMessage_t * ) ulMessageBuffers[ uxFreeBuffers ];
+        }
+
+        /* The cycle counter measures vLoggingPrintfFromISR(). */
+        CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+        DWT->LAR = 0xC5ACCE55U;
+        DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+        /* Create the queue used to pass pointers to messages to the logging task. */
+        xQueue = xQueueCreate( uxQueueLength, sizeof( LogMessage_t * ) );
 
         if( xQueue != NULL )
         {
@@ -142,63 +343,500 @@ BaseType_t xLoggingTaskInitialize( uint16_t usStackSize,
 }
 /*-----------------------------------------------------------*/
 
+static void prvOutput( uint8_t ucLevel,
+                       const char * pcText )
+{
+    if( xLogUDPWrite( pcText, ucLevel ) == pdFALSE )
+    {
+        configPRINT_STRING( pcText );
+    }
+}
+/*-----------------------------------------------------------*/
+
+static void prvFlushRepeats( void )
+{
+    #if ( configLOGGING_MERGE_REPEATS == 1 )
+    {
+        char cLine[ loggingMARKER_LENGTH ];
+
+        if( ulRepeats != 0U )
+        {
+            ( void ) snprintf( cLine, sizeof( cLine ), "last message repeated %u times\n\r", ( unsigned ) ulRepeats );
+            prvOutput( pxLastMessage->ucLevel, cLine );
+            ulRepeats = 0U;
+        }
+    }
+    #endif
+}
+/*-----------------------------------------------------------*/
+
+static void prvWriteMessage( LogMessage_t * pxMessage )
+{
+    char cLine[ loggingMARKER_LENGTH ];
+
+    if( pxMessage->usDropped != 0U )
+    {
+        prvFlushRepeats();
+
+        ( void ) snprintf( cLine, sizeof( cLine ), "log: %u messages dropped, %u of them errors\n\r",
+                           ( unsigned ) pxMessage->usDropped, ( unsigned ) pxMessage->usDroppedErrors );
+        prvOutput( ( pxMessage->usDroppedErrors != 0U ) ? logLEVEL_ERROR : logLEVEL_WARN, cLine );
+    }
+
+    #if ( configLOGGING_MERGE_REPEATS == 1 )
+    {
+        if( ( pxLastMessage != NULL ) &&
+            ( pxMessage->usDropped == 0U ) &&
+            ( pxLastMessage->ucLevel == pxMessage->ucLevel ) &&
+            ( strcmp( pxLastMessage->cText, pxMessage->cText ) == 0 ) )
+        {
+            if( ulRepeats == 0U )
+            {
+                xFirstRepeat = xTaskGetTickCount();
+            }
+
+            ulRepeats++;
+            prvReturnBuffer( pxMessage );
+        }
+        else
+        {
+            prvFlushRepeats();
+            prvOutput( pxMessage->ucLevel, pxMessage->cText );
+
+            /* Kept to compare the next message with. */
+            if( pxLastMessage != NULL )
+            {
+                prvReturnBuffer( pxLastMessage );
+            }
+
+            pxLastMessage = pxMessage;
+        }
+    }
+    #else /* if ( configLOGGING_MERGE_REPEATS == 1 ) */
+    {
+        prvOutput( pxMessage->ucLevel, pxMessage->cText );
+        prvReturnBuffer( pxMessage );
+    }
+    #endif /* if ( configLOGGING_MERGE_REPEATS == 1 ) */
+}
+/*-----------------------------------------------------------*/
+
+static TickType_t prvWaitTime( void )
+{
+    TickType_t xWait = xLogUDPFlushDelay();
+
+    #if ( configLOGGING_MERGE_REPEATS == 1 )
+    {
+        TickType_t xElapsed;
+        TickType_t xRepeatWait;
+
+        if( ulRepeats != 0U )
+        {
+            xElapsed = xTaskGetTickCount() - xFirstRepeat;
+            xRepeatWait = ( xElapsed >= pdMS_TO_TICKS( configLOGGING_REPEAT_FLUSH_MS ) ) ? 0U : ( pdMS_TO_TICKS( configLOGGING_REPEAT_FLUSH_MS ) - xElapsed );
+
+            if( xRepeatWait < xWait )
+            {
+                xWait = xRepeatWait;
+            }
+        }
+    }
+    #endif
+
+    return xWait;
+}
+/*-----------------------------------------------------------*/
+
 static void prvLoggingTask( void * pvParameters )
 {
     /* Disable unused parameter warning. */
     ( void ) pvParameters;
 
-    char * pcReceivedString = NULL;
+    LogMessage_t * pxReceivedMessage = NULL;
 
     for( ; ; )
     {
-        /* Block to wait for the next string to print. */
-        if( xQueueReceive( xQueue, &pcReceivedString, portMAX_DELAY ) == pdPASS )
+        /* Block to wait for the next message to print, or until the batch of
+         * the network sink or the count of repeats is due. */
+        if( xQueueReceive( xQueue, &pxReceivedMessage, prvWaitTime() ) == pdPASS )
+        {
+            /* NULL only wakes the task for the messages of interrupts. */
+            if( pxReceivedMessage != NULL )
+            {
+                prvWriteMessage( pxReceivedMessage );
+            }
+
+            /* After every message: interrupts do not send a wake-up while
+             * the queue holds one. */
+            prvDrainISRRecords();
+        }
+        else
         {
-            configPRINT_STRING( pcReceivedString );
+            #if ( configLOGGING_MERGE_REPEATS == 1 )
+            {
+                if( ( ulRepeats != 0U ) &&
+                    ( ( xTaskGetTickCount() - xFirstRepeat ) >= pdMS_TO_TICKS( configLOGGING_REPEAT_FLUSH_MS ) ) )
+                {
+                    prvFlushRepeats();
+                }
+            }
+            #endif
 
-            vPortFree( ( void * ) pcReceivedString );
+            vLogUDPFlush();
         }
     }
 }
 
 /*-----------------------------------------------------------*/
 
-void vLoggingPrintf( const char * pcFormat, ... )
+static void prvDrainISRRecords( void )
+{
+    LogISRRecord_t xRecord;
+    LogMessage_t * pxMessage;
+    size_t xLength;
+
+    while( ulISRTail != ulISRHead )
+    {
+        /* The record may only be read once the head shows it is complete. */
+        portMEMORY_BARRIER();
+        xRecord = xISRRecords[ ulISRTail % configLOGGING_ISR_RECORDS ];
+
+        /* The copy must be complete before the slot is handed back. */
+        portMEMORY_BARRIER();
+        ulISRTail++;
+
+        pxMessage = prvTakeBuffer( xRecord.ucLevel );
+
+        if( pxMessage == NULL )
+        {
+            vTaskSuspendAll();
+            {
+                prvDropped( xRecord.ucLevel );
+                ulNoBuffer++;
+            }
+            ( void ) xTaskResumeAll();
+            continue;
+        }
+
+        /* Arguments that the format does not use are ignored. */
+        pxMessage->usDropped = xRecord.usDropped;
+        pxMessage->usDroppedErrors = xRecord.usDroppedErrors;
+        pxMessage->ucLevel = xRecord.ucLevel;
+        xLength = ( size_t ) snprintf( pxMessage->cText, loggingMAX_TEXT_LENGTH - 1, xRecord.pcFormat,
+                                       xRecord.ulArguments[ 0 ], xRecord.ulArguments[ 1 ],
+                                       xRecord.ulArguments[ 2 ], xRecord.ulArguments[ 3 ] );
+
+        if( xLength >= ( loggingMAX_TEXT_LENGTH - 1 ) )
+        {
+            xLength = loggingMAX_TEXT_LENGTH - 2;
+        }
+
+        pxMessage->cText[ xLength ] = '\r';
+        pxMessage->cText[ xLength + 1 ] = '\0';
+
+        prvWriteMessage( pxMessage );
+    }
+}
+/*-----------------------------------------------------------*/
+
+static void prvDropped( uint8_t ucLevel )
+{
+    /* Saturate rather than wrap, the marker then shows 65535. */
+    if( usPendingDrops != UINT16_MAX )
+    {
+        usPendingDrops++;
+    }
+
+    if( ( ucLevel <= logLEVEL_ERROR ) && ( usPendingErrorDrops != UINT16_MAX ) )
+    {
+        usPendingErrorDrops++;
+    }
+}
+/*-----------------------------------------------------------*/
+
+static LogMessage_t * prvTakeBuffer( uint8_t ucLevel )
+{
+    LogMessage_t * pxMessage = NULL;
+
+    /* Only tasks log through the pool, interrupts use the ring. */
+    taskENTER_CRITICAL();
+    {
+        if( uxFreeBuffers > prvReserve( ucLevel ) )
+        {
+            uxFreeBuffers--;
+            pxMessage = pxFreeBuffers[ uxFreeBuffers ];
+        }
+    }
+    taskEXIT_CRITICAL();
+
+    return pxMessage;
+}
+/*-----------------------------------------------------------*/
+
+static void prvReturnBuffer( LogMessage_t * pxMessage )
+{
+    taskENTER_CRITICAL();
+    {
+        configASSERT( uxFreeBuffers < configLOGGING_MESSAGE_BUFFERS );
+        pxFreeBuffers[ uxFreeBuffers ] = pxMessage;
+        uxFreeBuffers++;
+    }
+    taskEXIT_CRITICAL();
+}
+/*-----------------------------------------------------------*/
+
+static UBaseType_t prvReserve( uint8_t ucLevel )
+{
+    UBaseType_t uxReserve;
+
+    if( ucLevel <= logLEVEL_ERROR )
+    {
+        uxReserve = 0U;
+    }
+    else if( ucLevel <= logLEVEL_INFO )
+    {
+        uxReserve = configLOGGING_ERROR_RESERVE;
+    }
+    else
+    {
+        uxReserve = configLOGGING_ERROR_RESERVE + configLOGGING_INFO_RESERVE;
+    }
+
+    return uxReserve;
+}
+/*-----------------------------------------------------------*/
+
+static void prvLoggingVPrintf( uint8_t ucLevel,
+                               const char * pcFormat,
+                               va_list xArgs )
 {
     size_t xLength = 0;
-    char * pcPrintString = NULL;
+    LogMessage_t * pxMessage = NULL;
+    UBaseType_t uxReserve = prvReserve( ucLevel );
+    BaseType_t xQueued = pdFALSE;
+    BaseType_t xHasRoom;
 
     /* The queue is created by xLoggingTaskInitialize().  Check
      * xLoggingTaskInitialize() has been called. */
     configASSERT( xQueue );
     configASSERT( pcFormat != NULL );
 
-    /* Allocate a buffer to hold the log message. */
-    pcPrintString = pvPortMalloc( configLOGGING_MAX_MESSAGE_LENGTH );
+    /* In a storm, give up before the cost of the allocation and of the
+     * formatting. */
+    xHasRoom = ( uxQueueSpacesAvailable( xQueue ) > uxReserve ) ? pdTRUE : pdFALSE;
+
+    if( xHasRoom != pdFALSE )
+    {
+        /* Take a buffer to hold the log message. */
+        pxMessage = prvTakeBuffer( ucLevel );
+    }
+
+    if( pxMessage != NULL )
+    {
+        /* Leave room for the '\r' and the terminating NULL. */
+        pxMessage->ucLevel = ucLevel;
+        xLength = vsnprintf_safe( pxMessage->cText,
+                                  loggingMAX_TEXT_LENGTH - 1,
+                                  pcFormat,
+                                  xArgs );
+
+        pxMessage->cText[ xLength ] = '\r';
+        pxMessage->cText[ xLength + 1 ] = '\0';
+    }
 
-    if( pcPrintString != NULL )
+    /* The check of the free space, the send, and the counts must not be
+     * interleaved with another task that logs. */
+    vTaskSuspendAll();
     {
+        if( ( pxMessage != NULL ) && ( uxQueueSpacesAvailable( xQueue ) > uxReserve ) )
+        {
+            pxMessage->usDropped = usPendingDrops;
+            pxMessage->usDroppedErrors = usPendingErrorDrops;
+
+            /* Cannot fail, there is space and no other task can take it. */
+            xQueued = xQueueSend( xQueue, &pxMessage, loggingDONT_BLOCK );
+            configASSERT( xQueued == pdPASS );
+
+            usPendingDrops = 0U;
+            usPendingErrorDrops = 0U;
+        }
+        else
         {
-            va_list args;
+            prvDropped( ucLevel );
+
+            if( ( xHasRoom != pdFALSE ) && ( pxMessage == NULL ) )
+            {
+                ulNoBuffer++;
+            }
+            else
+            {
+                ulQueueFull++;
+            }
+        }
+    }
+    ( void ) xTaskResumeAll();
+
+    if( ( pxMessage != NULL ) && ( xQueued == pdFALSE ) )
+    {
+        /* The buffer was not sent so must be returned again. */
+        prvReturnBuffer( pxMessage );
+    }
+}
+/*-----------------------------------------------------------*/
+
+void vLoggingPrintf( const char * pcFormat, ... )
+{
+    va_list args;
+
+    va_start( args, pcFormat );
+    prvLoggingVPrintf( logLEVEL_INFO, pcFormat, args );
+    va_end( args );
+}
+/*-----------------------------------------------------------*/
+
+void vLoggingPrintfLevel( LogModule_t xModule,
+                          uint8_t ucLevel,
+                          const char * pcFormat,
+                          ... )
+{
+    va_list args;
+
+    /* Counted here rather than in the macro, which keeps the code at every
+     * call site small. */
+    xLogModules[ xModule ].ulEmitted++;
+
+    va_start( args, pcFormat );
+    prvLoggingVPrintf( ucLevel, pcFormat, args );
+    va_end( args );
+}
+/*-----------------------------------------------------------*/
+
+void vLoggingPrintfFromISR( LogModule_t xModule,
+                            uint8_t ucLevel,
+                            uint32_t ulArgumentCount,
+                            const char * pcFormat,
+                            ... )
+{
+    uint32_t ulStart = DWT->CYCCNT;
+    uint32_t ulCycles;
+    uint32_t x;
+    LogISRRecord_t * pxRecord;
+    UBaseType_t uxSaved;
+    va_list args;
+    BaseType_t xWasEmpty = pdFALSE;
+    BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+    LogMessage_t * pxDoorbell = NULL;
+
+    configASSERT( ulArgumentCount <= logISR_MAX_ARGUMENTS );
+
+    /* Interrupts of a higher priority may log as well. */
+    uxSaved = taskENTER_CRITICAL_FROM_ISR();
+    {
+        if( ( ulISRHead - ulISRTail ) < configLOGGING_ISR_RECORDS )
+        {
+            xWasEmpty = ( ulISRHead == ulISRTail ) ? pdTRUE : pdFALSE;
+            pxRecord = &( xISRRecords[ ulISRHead % configLOGGING_ISR_RECORDS ] );
+
+            pxRecord->pcFormat = pcFormat;
+            pxRecord->ucLevel = ucLevel;
+            pxRecord->usDropped = usISRPendingDrops;
+            pxRecord->usDroppedErrors = usISRPendingErrorDrops;
+            usISRPendingDrops = 0U;
+            usISRPendingErrorDrops = 0U;
 
             va_start( args, pcFormat );
-            xLength = vsnprintf_safe( pcPrintString,
-                                      configLOGGING_MAX_MESSAGE_LENGTH,
-                                      pcFormat,
-                                      args );
+
+            for( x = 0; x < logISR_MAX_ARGUMENTS; x++ )
+            {
+                pxRecord->ulArguments[ x ] = ( x < ulArgumentCount ) ? va_arg( args, uint32_t ) : 0U;
+            }
+
             va_end( args );
+
+            ulISRHead++;
+            xLogModules[ xModule ].ulEmitted++;
         }
+        else
+        {
+            ulISRFull++;
+
+            if( usISRPendingDrops != UINT16_MAX )
+            {
+                usISRPendingDrops++;
+            }
+
+            if( ( ucLevel <= logLEVEL_ERROR ) && ( usISRPendingErrorDrops != UINT16_MAX ) )
+            {
+                usISRPendingErrorDrops++;
+            }
+        }
+    }
+    taskEXIT_CRITICAL_FROM_ISR( uxSaved );
+
+    /* The logging task drains the ring whenever it wakes up, so it only needs
+     * a wake-up when the ring was empty.  While the queue holds a message the
+     * task will wake up anyway, so the wake-up item only ever takes a slot of
+     * an empty queue, never one of those reserved for errors. */
+    if( ( xWasEmpty != pdFALSE ) && ( xQueue != NULL ) &&
+        ( uxQueueMessagesWaitingFromISR( xQueue ) == 0U ) )
+    {
+        ( void ) xQueueSendFromISR( xQueue, &pxDoorbell, &xHigherPriorityTaskWoken );
+    }
+
+    ulCycles = DWT->CYCCNT - ulStart;
+
+    if( ulCycles > ulISRMaxCycles )
+    {
+        ulISRMaxCycles = ulCycles;
+    }
+
+    portYIELD_FROM_ISR( xHigherPriorityTaskWoken );
+}
+/*-----------------------------------------------------------*/
+
+void vLoggingGetDrops( uint32_t * pulQueueFull,
+                       uint32_t * pulNoBuffer )
+{
+    *pulQueueFull = ulQueueFull;
+    *pulNoBuffer = ulNoBuffer;
+}
+/*-----------------------------------------------------------*/
 
-        pcPrintString[ xLength ] = '\r';
-        pcPrintString[ xLength + 1] = '\0';
+void vLoggingSetLevel( LogModule_t xModule,
+                       uint8_t ucLevel )
+{
+    UBaseType_t x;
 
-        /* Send the string to the logging task for IO. */
-        if( xQueueSend( xQueue, &pcPrintString, loggingDONT_BLOCK ) != pdPASS )
+    for( x = 0; x < ( UBaseType_t ) eLogModuleCount; x++ )
+    {
+        if( ( xModule == eLogModuleCount ) || ( x == ( UBaseType_t ) xModule ) )
         {
-            /* The buffer was not sent so must be freed again. */
-            vPortFree( ( void * ) pcPrintString );
+            xLogModules[ x ].ucLevel = ucLevel;
         }
     }
 }
+/*-----------------------------------------------------------*/
+
+void vLoggingReport( void )
+{
+    UBaseType_t x;
+
+    /* Written at level "info" like the other reports, straight to
+     * vLoggingPrintfLevel() so that they show whatever the thresholds.  They
+     * leave the slots of configLOGGING_ERROR_RESERVE to errors. */
+    for( x = 0; x < ( UBaseType_t ) eLogModuleCount; x++ )
+    {
+        vLoggingPrintfLevel( eLogModuleApp, logLEVEL_INFO, "Log %-5s level %u, %u emitted, %u suppressed\n",
+                             pcModuleNames[ x ],
+                             ( unsigned ) xLogModules[ x ].ucLevel,
+                             ( unsigned ) xLogModules[ x ].ulEmitted,
+                             ( unsigned ) xLogModules[ x ].ulSuppressed );
+    }
+
+    vLoggingPrintfLevel( eLogModuleApp, logLEVEL_INFO, "Log dropped %u for a full queue, %u for no free buffer\n",
+                         ( unsigned ) ulQueueFull, ( unsigned ) ulNoBuffer );
+    vLoggingPrintfLevel( eLogModuleApp, logLEVEL_INFO, "Log from interrupts: %u dropped for a full ring, at most %u cycles\n",
+                         ( unsigned ) ulISRFull, ( unsigned ) ulISRMaxCycles );
+}
 
 /*-----------------------------------------------------------*/
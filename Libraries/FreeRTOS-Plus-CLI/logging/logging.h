@@ -4,6 +4,8 @@
 /* Kernel includes. */
 #include "FreeRTOS.h"
 
+#include "log_levels.h"
+
 /**
  * @brief Initialize the logging module.
  *
@@ -17,4 +19,28 @@ BaseType_t xLoggingTaskInitialize( uint16_t usStackSize,
                                    UBaseType_t uxPriority,
                                    UBaseType_t uxQueueLength );
 
+/**
+ * @brief Get the number of messages that vLoggingPrintf() dropped because the
+ * queue was full, or because no message buffer was free.
+ */
+void vLoggingGetDrops( uint32_t * pulQueueFull,
+                       uint32_t * pulNoBuffer );
+
+/**
+ * @brief Set the threshold of a module at run time.  Messages of the module
+ * that are more verbose than ucLevel are neither formatted nor queued.
+ *
+ * @param xModule The module, or eLogModuleCount for all of them.
+ * @param ucLevel One of the logLEVEL_ values of log_levels.h.
+ */
+void vLoggingSetLevel( LogModule_t xModule,
+                       uint8_t ucLevel );
+
+/**
+ * @brief Log the threshold and the counters of every module, and the drop
+ * counters.  The lines are written at level "info" whatever the thresholds,
+ * and may be dropped like other info messages when the queue is full.
+ */
+void vLoggingReport( void );
+
 #endif /* #ifndef LOGGING_H */
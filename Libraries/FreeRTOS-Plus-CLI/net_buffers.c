@@ -0,0 +1,596 @@
+/* The log messages of this file, see log_levels.h. */
+#define logMODULE    eLogModuleNet
+
+/* Standard includes. */
+#include <string.h>
+
+/* FreeRTOS includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+#include "semphr.h"
+
+/* FreeRTOS+TCP includes. */
+#include "FreeRTOS_IP.h"
+#include "FreeRTOS_IP_Private.h"
+#include "NetworkBufferManagement.h"
+
+/* ST includes, for the LDREX/STREX intrinsics. */
+#include "stm32h7xx_hal.h"
+
+#include "net_buffers.h"
+
+/* Blocks are aligned on a cache line of the Cortex-M7. */
+#define netbuffersALIGNMENT       32U
+
+#define netbuffersBLOCK_SIZE( uxSize ) \
+    ( ( ( uxSize ) + ipBUFFER_PADDING + netbuffersALIGNMENT - 1U ) & ~( size_t ) ( netbuffersALIGNMENT - 1U ) )
+
+/* LDREX/STREX of the head of a free list.  A pointer is a word on the
+ * Cortex-M7, a build where it is not (the host tests) defines its own. */
+#ifndef netbuffersLOAD_HEAD
+    #define netbuffersLOAD_HEAD( ppucHead )               ( ( uint8_t * ) __LDREXW( ( volatile uint32_t * ) ( ppucHead ) ) )
+    #define netbuffersSTORE_HEAD( ppucHead, pucValue )    __STREXW( ( uint32_t ) ( pucValue ), ( volatile uint32_t * ) ( ppucHead ) )
+#endif
+
+#if ( configNET_BUFFERS_LARGE_SIZE < ETH_RX_BUF_SIZE )
+    #error configNET_BUFFERS_LARGE_SIZE must hold a received frame.
+#endif
+
+#if ( ( configNET_BUFFERS_SMALL_SIZE >= configNET_BUFFERS_MEDIUM_SIZE ) || ( configNET_BUFFERS_MEDIUM_SIZE >= configNET_BUFFERS_LARGE_SIZE ) )
+    #error The buffer classes must be given from small to large.
+#endif
+
+typedef struct xNET_BUFFER_CLASS
+{
+    size_t uxSize;                     /* Usable bytes of a block. */
+    size_t uxBlockSize;                /* Bytes of a block, with padding and alignment. */
+    UBaseType_t uxCount;
+    uint8_t * pucStart;                /* The blocks, to recognise a released payload. */
+    uint8_t * pucEnd;
+    uint8_t * volatile pucFreeList;    /* The first word of a free block points to the next. */
+    volatile uint32_t ulFree;
+    UBaseType_t uxMinimumFree;
+    volatile uint32_t ulAllocations;
+    volatile uint32_t ulSpills;
+    volatile uint32_t ulRequestedBytes;
+} NetBufferClass_t;
+
+/*
+ * Pop a block from the free list of a class, returns NULL when it is empty.
+ */
+static uint8_t * prvPopBlock( NetBufferClass_t * pxClass );
+
+/*
+ * Push a block onto the free list of a class.
+ */
+static void prvPushBlock( NetBufferClass_t * pxClass,
+                          uint8_t * pucBlock );
+
+/*
+ * Add to a counter that is also changed from other tasks and interrupts.
+ */
+static void prvAtomicAdd( volatile uint32_t * pulValue,
+                          uint32_t ulAmount );
+
+/*
+ * Read a counter and clear it in one go.
+ */
+static uint32_t prvAtomicTake( volatile uint32_t * pulValue );
+
+/*
+ * Find the class that holds a payload, returns NULL for a foreign pointer.
+ */
+static NetBufferClass_t * prvClassOf( const uint8_t * pucEthernetBuffer );
+
+/*-----------------------------------------------------------*/
+
+static NetBufferClass_t xClasses[ netbuffersCLASS_COUNT ] =
+{
+    { .uxSize = configNET_BUFFERS_SMALL_SIZE,  .uxCount = configNET_BUFFERS_SMALL_COUNT  },
+    { .uxSize = configNET_BUFFERS_MEDIUM_SIZE, .uxCount = configNET_BUFFERS_MEDIUM_COUNT },
+    { .uxSize = configNET_BUFFERS_LARGE_SIZE,  .uxCount = configNET_BUFFERS_LARGE_COUNT  },
+};
+
+static volatile uint32_t ulFailures = 0U;
+
+static NetworkBufferDescriptor_t xNetworkBufferDescriptors[ ipconfigNUM_NETWORK_BUFFER_DESCRIPTORS ];
+
+/* The descriptors that are not in use. */
+static List_t xFreeBuffersList;
+
+/* Counts the free descriptors, so that a task can wait for one. */
+static SemaphoreHandle_t xNetworkBufferSemaphore = NULL;
+
+static UBaseType_t uxMinimumFreeNetworkBuffers = 0U;
+
+/* Given on a release while a task waits in xNetBuffersWaitRelease(). */
+static SemaphoreHandle_t xReleaseSemaphore = NULL;
+static volatile UBaseType_t uxReleaseWaiters = 0U;
+
+/*-----------------------------------------------------------*/
+
+/* Between LDREX and STREX the block may be taken and given back by an
+ * interrupt.  That is not a problem: ARMv7-M clears the exclusive monitor on
+ * every exception entry and return, so the STREX fails and the loop starts
+ * over with the new head. */
+static uint8_t * prvPopBlock( NetBufferClass_t * pxClass )
+{
+    uint8_t * pucBlock;
+
+    do
+    {
+        pucBlock = netbuffersLOAD_HEAD( &( pxClass->pucFreeList ) );
+
+        if( pucBlock == NULL )
+        {
+            __CLREX();
+            break;
+        }
+    } while( netbuffersSTORE_HEAD( &( pxClass->pucFreeList ), *( ( uint8_t ** ) pucBlock ) ) != 0U );
+
+    return pucBlock;
+}
+/*-----------------------------------------------------------*/
+
+static void prvPushBlock( NetBufferClass_t * pxClass,
+                          uint8_t * pucBlock )
+{
+    uint8_t * pucHead;
+
+    do
+    {
+        pucHead = netbuffersLOAD_HEAD( &( pxClass->pucFreeList ) );
+        *( ( uint8_t ** ) pucBlock ) = pucHead;
+    } while( netbuffersSTORE_HEAD( &( pxClass->pucFreeList ), pucBlock ) != 0U );
+}
+/*-----------------------------------------------------------*/
+
+static void prvAtomicAdd( volatile uint32_t * pulValue,
+                          uint32_t ulAmount )
+{
+    uint32_t ulValue;
+
+    do
+    {
+        ulValue = __LDREXW( pulValue ) + ulAmount;
+    } while( __STREXW( ulValue, pulValue ) != 0U );
+}
+/*-----------------------------------------------------------*/
+
+static uint32_t prvAtomicTake( volatile uint32_t * pulValue )
+{
+    uint32_t ulValue;
+
+    do
+    {
+        ulValue = __LDREXW( pulValue );
+    } while( __STREXW( 0U, pulValue ) != 0U );
+
+    return ulValue;
+}
+/*-----------------------------------------------------------*/
+
+static NetBufferClass_t * prvClassOf( const uint8_t * pucEthernetBuffer )
+{
+    NetBufferClass_t * pxReturn = NULL;
+    BaseType_t xIndex;
+
+    for( xIndex = 0; xIndex < netbuffersCLASS_COUNT; xIndex++ )
+    {
+        if( ( pucEthernetBuffer >= xClasses[ xIndex ].pucStart ) && ( pucEthernetBuffer < xClasses[ xIndex ].pucEnd ) )
+        {
+            pxReturn = &( xClasses[ xIndex ] );
+            break;
+        }
+    }
+
+    return pxReturn;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xNetworkBuffersInitialise( void )
+{
+    BaseType_t xReturn = pdPASS;
+    BaseType_t xIndex;
+    NetBufferClass_t * pxClass;
+    uint8_t * pucRAM;
+    UBaseType_t uxBlock;
+
+    /* Only initialise once. */
+    if( xNetworkBufferSemaphore == NULL )
+    {
+        for( xIndex = 0; xIndex < netbuffersCLASS_COUNT; xIndex++ )
+        {
+            pxClass = &( xClasses[ xIndex ] );
+            pxClass->uxBlockSize = netbuffersBLOCK_SIZE( pxClass->uxSize );
+
+            /* The heap aligns on 8 bytes only. */
+            pucRAM = ( uint8_t * ) pvPortMalloc( ( pxClass->uxBlockSize * pxClass->uxCount ) + netbuffersALIGNMENT - 1U );
+
+            if( pucRAM == NULL )
+            {
+                xReturn = pdFAIL;
+                break;
+            }
+
+            pxClass->pucStart = ( uint8_t * ) ( ( ( uintptr_t ) pucRAM + netbuffersALIGNMENT - 1U ) & ~( uintptr_t ) ( netbuffersALIGNMENT - 1U ) );
+            pxClass->pucEnd = pxClass->pucStart + ( pxClass->uxBlockSize * pxClass->uxCount );
+            pxClass->pucFreeList = NULL;
+
+            for( uxBlock = 0U; uxBlock < pxClass->uxCount; uxBlock++ )
+            {
+                prvPushBlock( pxClass, pxClass->pucStart + ( uxBlock * pxClass->uxBlockSize ) );
+            }
+
+            pxClass->ulFree = pxClass->uxCount;
+            pxClass->uxMinimumFree = pxClass->uxCount;
+        }
+
+        if( xReturn == pdPASS )
+        {
+            xNetworkBufferSemaphore = xSemaphoreCreateCounting( ipconfigNUM_NETWORK_BUFFER_DESCRIPTORS, ipconfigNUM_NETWORK_BUFFER_DESCRIPTORS );
+            xReleaseSemaphore = xSemaphoreCreateBinary();
+
+            if( ( xNetworkBufferSemaphore == NULL ) || ( xReleaseSemaphore == NULL ) )
+            {
+                xReturn = pdFAIL;
+            }
+        }
+
+        if( xReturn == pdPASS )
+        {
+            vQueueAddToRegistry( xNetworkBufferSemaphore, "NetBufSem" );
+
+            vListInitialise( &xFreeBuffersList );
+
+            for( xIndex = 0; xIndex < ipconfigNUM_NETWORK_BUFFER_DESCRIPTORS; xIndex++ )
+            {
+                xNetworkBufferDescriptors[ xIndex ].pucEthernetBuffer = NULL;
+                vListInitialiseItem( &( xNetworkBufferDescriptors[ xIndex ].xBufferListItem ) );
+                listSET_LIST_ITEM_OWNER( &( xNetworkBufferDescriptors[ xIndex ].xBufferListItem ), &( xNetworkBufferDescriptors[ xIndex ] ) );
+                vListInsertEnd( &xFreeBuffersList, &( xNetworkBufferDescriptors[ xIndex ].xBufferListItem ) );
+            }
+
+            uxMinimumFreeNetworkBuffers = ipconfigNUM_NETWORK_BUFFER_DESCRIPTORS;
+        }
+    }
+
+    return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+uint8_t * pucGetNetworkBuffer( size_t * pxRequestedSizeBytes )
+{
+    uint8_t * pucBlock = NULL;
+    NetBufferClass_t * pxClass;
+    size_t uxSize = *pxRequestedSizeBytes;
+    BaseType_t xIndex;
+    BaseType_t xFirst = -1;
+
+    /* Round up to a whole number of words, as BufferAllocation_2.c does. */
+    if( ( uxSize & ( sizeof( size_t ) - 1U ) ) != 0U )
+    {
+        uxSize = ( uxSize | ( sizeof( size_t ) - 1U ) ) + 1U;
+    }
+
+    for( xIndex = 0; xIndex < netbuffersCLASS_COUNT; xIndex++ )
+    {
+        pxClass = &( xClasses[ xIndex ] );
+
+        if( uxSize <= pxClass->uxSize )
+        {
+            if( xFirst < 0 )
+            {
+                xFirst = xIndex;
+            }
+
+            pucBlock = prvPopBlock( pxClass );
+
+            if( pucBlock != NULL )
+            {
+                prvAtomicAdd( &( pxClass->ulFree ), ( uint32_t ) -1 );
+
+                /* A lost update only makes the statistic a little off. */
+                if( pxClass->ulFree < pxClass->uxMinimumFree )
+                {
+                    pxClass->uxMinimumFree = pxClass->ulFree;
+                }
+
+                prvAtomicAdd( &( pxClass->ulAllocations ), 1U );
+                prvAtomicAdd( &( pxClass->ulRequestedBytes ), ( uint32_t ) *pxRequestedSizeBytes );
+
+                if( xIndex != xFirst )
+                {
+                    prvAtomicAdd( &( pxClass->ulSpills ), 1U );
+                }
+
+                break;
+            }
+        }
+    }
+
+    if( pucBlock != NULL )
+    {
+        *pxRequestedSizeBytes = uxSize;
+        pucBlock += ipBUFFER_PADDING;
+    }
+    else
+    {
+        prvAtomicAdd( &ulFailures, 1U );
+    }
+
+    return pucBlock;
+}
+/*-----------------------------------------------------------*/
+
+void vReleaseNetworkBuffer( uint8_t * pucEthernetBuffer )
+{
+    NetBufferClass_t * pxClass;
+
+    if( pucEthernetBuffer != NULL )
+    {
+        pxClass = prvClassOf( pucEthernetBuffer );
+        configASSERT( pxClass != NULL );
+
+        if( pxClass != NULL )
+        {
+            prvPushBlock( pxClass, pucEthernetBuffer - ipBUFFER_PADDING );
+            prvAtomicAdd( &( pxClass->ulFree ), 1U );
+        }
+    }
+}
+/*-----------------------------------------------------------*/
+
+NetworkBufferDescriptor_t * pxGetNetworkBufferWithDescriptor( size_t xRequestedSizeBytes,
+                                                              TickType_t xBlockTimeTicks )
+{
+    NetworkBufferDescriptor_t * pxReturn = NULL;
+    UBaseType_t uxCount;
+
+    if( ( xNetworkBufferSemaphore != NULL ) &&
+        ( xSemaphoreTake( xNetworkBufferSemaphore, xBlockTimeTicks ) == pdPASS ) )
+    {
+        taskENTER_CRITICAL();
+        {
+            pxReturn = ( NetworkBufferDescriptor_t * ) listGET_OWNER_OF_HEAD_ENTRY( &xFreeBuffersList );
+            ( void ) uxListRemove( &( pxReturn->xBufferListItem ) );
+
+            uxCount = listCURRENT_LIST_LENGTH( &xFreeBuffersList );
+
+            if( uxMinimumFreeNetworkBuffers > uxCount )
+            {
+                uxMinimumFreeNetworkBuffers = uxCount;
+            }
+        }
+        taskEXIT_CRITICAL();
+
+        pxReturn->pxInterface = NULL;
+        pxReturn->pxEndPoint = NULL;
+        pxReturn->xDataLength = 0U;
+        #if ( ipconfigUSE_LINKED_RX_MESSAGES != 0 )
+            pxReturn->pxNextBuffer = NULL;
+        #endif
+
+        if( xRequestedSizeBytes > 0U )
+        {
+            pxReturn->pucEthernetBuffer = pucGetNetworkBuffer( &xRequestedSizeBytes );
+
+            if( pxReturn->pucEthernetBuffer == NULL )
+            {
+                /* No class had a block left, give the descriptor back. */
+                vReleaseNetworkBufferAndDescriptor( pxReturn );
+                pxReturn = NULL;
+            }
+            else
+            {
+                /* The stack finds the descriptor of a payload through this
+                 * pointer, just in front of the Ethernet header. */
+                *( ( NetworkBufferDescriptor_t ** ) ( pxReturn->pucEthernetBuffer - ipBUFFER_PADDING ) ) = pxReturn;
+                pxReturn->xDataLength = xRequestedSizeBytes;
+            }
+        }
+        else
+        {
+            pxReturn->pucEthernetBuffer = NULL;
+        }
+    }
+
+    if( pxReturn == NULL )
+    {
+        iptraceFAILED_TO_OBTAIN_NETWORK_BUFFER();
+    }
+    else
+    {
+        iptraceNETWORK_BUFFER_OBTAINED( pxReturn );
+    }
+
+    return pxReturn;
+}
+/*-----------------------------------------------------------*/
+
+void vReleaseNetworkBufferAndDescriptor( NetworkBufferDescriptor_t * const pxNetworkBuffer )
+{
+    BaseType_t xListItemAlreadyInFreeList;
+
+    /* The payload goes back first, a task that waits for a descriptor may
+     * need a block right away. */
+    vReleaseNetworkBuffer( pxNetworkBuffer->pucEthernetBuffer );
+    pxNetworkBuffer->pucEthernetBuffer = NULL;
+    pxNetworkBuffer->xDataLength = 0U;
+
+    taskENTER_CRITICAL();
+    {
+        xListItemAlreadyInFreeList = listIS_CONTAINED_WITHIN( &xFreeBuffersList, &( pxNetworkBuffer->xBufferListItem ) );
+
+        if( xListItemAlreadyInFreeList == pdFALSE )
+        {
+            vListInsertEnd( &xFreeBuffersList, &( pxNetworkBuffer->xBufferListItem ) );
+        }
+    }
+    taskEXIT_CRITICAL();
+
+    configASSERT( xListItemAlreadyInFreeList == pdFALSE );
+
+    if( xListItemAlreadyInFreeList == pdFALSE )
+    {
+        ( void ) xSemaphoreGive( xNetworkBufferSemaphore );
+
+        if( uxReleaseWaiters != 0U )
+        {
+            ( void ) xSemaphoreGive( xReleaseSemaphore );
+        }
+    }
+
+    iptraceNETWORK_BUFFER_RELEASED( pxNetworkBuffer );
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xNetBuffersWaitRelease( TickType_t xTicksToWait )
+{
+    BaseType_t xReturn = pdFALSE;
+
+    if( xReleaseSemaphore != NULL )
+    {
+        taskENTER_CRITICAL();
+        {
+            uxReleaseWaiters++;
+        }
+        taskEXIT_CRITICAL();
+
+        xReturn = ( xSemaphoreTake( xReleaseSemaphore, xTicksToWait ) == pdPASS ) ? pdTRUE : pdFALSE;
+
+        taskENTER_CRITICAL();
+        {
+            uxReleaseWaiters--;
+        }
+        taskEXIT_CRITICAL();
+    }
+
+    return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+NetworkBufferDescriptor_t * pxResizeNetworkBufferWithDescriptor( NetworkBufferDescriptor_t * pxNetworkBuffer,
+                                                                 size_t xNewSizeBytes )
+{
+    NetBufferClass_t * pxClass = prvClassOf( pxNetworkBuffer->pucEthernetBuffer );
+    uint8_t * pucBuffer;
+    size_t uxCopy;
+
+    if( ( pxClass != NULL ) && ( xNewSizeBytes <= pxClass->uxSize ) )
+    {
+        /* The block is big enough already. */
+        pxNetworkBuffer->xDataLength = xNewSizeBytes;
+    }
+    else
+    {
+        pucBuffer = pucGetNetworkBuffer( &xNewSizeBytes );
+
+        if( pucBuffer == NULL )
+        {
+            /* As in BufferAllocation_2.c the caller still owns the descriptor. */
+            pxNetworkBuffer = NULL;
+        }
+        else
+        {
+            uxCopy = ( pxNetworkBuffer->xDataLength < xNewSizeBytes ) ? pxNetworkBuffer->xDataLength : xNewSizeBytes;
+
+            /* Copy the padding as well, it holds the IP type. */
+            ( void ) memcpy( pucBuffer - ipBUFFER_PADDING, pxNetworkBuffer->pucEthernetBuffer - ipBUFFER_PADDING, uxCopy + ipBUFFER_PADDING );
+            vReleaseNetworkBuffer( pxNetworkBuffer->pucEthernetBuffer );
+
+            pxNetworkBuffer->pucEthernetBuffer = pucBuffer;
+            pxNetworkBuffer->xDataLength = xNewSizeBytes;
+        }
+    }
+
+    return pxNetworkBuffer;
+}
+/*-----------------------------------------------------------*/
+
+UBaseType_t uxGetMinimumFreeNetworkBuffers( void )
+{
+    return uxMinimumFreeNetworkBuffers;
+}
+/*-----------------------------------------------------------*/
+
+UBaseType_t uxGetNumberOfFreeNetworkBuffers( void )
+{
+    return listCURRENT_LIST_LENGTH( &xFreeBuffersList );
+}
+/*-----------------------------------------------------------*/
+
+void vNetBuffersGetStats( NetBuffersStats_t * pxStats,
+                          BaseType_t xReset )
+{
+    NetBuffersClassStats_t * pxOut;
+    NetBufferClass_t * pxClass;
+    BaseType_t xIndex;
+
+    for( xIndex = 0; xIndex < netbuffersCLASS_COUNT; xIndex++ )
+    {
+        pxClass = &( xClasses[ xIndex ] );
+        pxOut = &( pxStats->xClasses[ xIndex ] );
+
+        pxOut->uxSize = pxClass->uxSize;
+        pxOut->uxCount = pxClass->uxCount;
+        pxOut->uxFree = pxClass->ulFree;
+        pxOut->uxMinimumFree = pxClass->uxMinimumFree;
+
+        if( xReset != pdFALSE )
+        {
+            pxOut->ulAllocations = prvAtomicTake( &( pxClass->ulAllocations ) );
+            pxOut->ulSpills = prvAtomicTake( &( pxClass->ulSpills ) );
+            pxOut->ulRequestedBytes = prvAtomicTake( &( pxClass->ulRequestedBytes ) );
+        }
+        else
+        {
+            pxOut->ulAllocations = pxClass->ulAllocations;
+            pxOut->ulSpills = pxClass->ulSpills;
+            pxOut->ulRequestedBytes = pxClass->ulRequestedBytes;
+        }
+    }
+
+    pxStats->ulFailures = ( xReset != pdFALSE ) ? prvAtomicTake( &ulFailures ) : ulFailures;
+}
+/*-----------------------------------------------------------*/
+
+void vNetBuffersReport( void )
+{
+    NetBuffersStats_t xStats;
+    NetBuffersClassStats_t * pxClass;
+    BaseType_t xIndex;
+    uint32_t ulWaste;
+
+    vNetBuffersGetStats( &xStats, pdTRUE );
+
+    for( xIndex = 0; xIndex < netbuffersCLASS_COUNT; xIndex++ )
+    {
+        pxClass = &( xStats.xClasses[ xIndex ] );
+
+        /* Internal fragmentation: the part of the handed out blocks that the
+         * requests did not use. */
+        ulWaste = 0U;
+
+        if( pxClass->ulAllocations != 0U )
+        {
+            ulWaste = 100U - ( uint32_t ) ( ( ( uint64_t ) pxClass->ulRequestedBytes * 100U ) /
+                                            ( ( uint64_t ) pxClass->ulAllocations * pxClass->uxSize ) );
+        }
+
+        FreeRTOS_printf( ( "Buffers %4u: free %u (min %u) of %u, %u allocs, %u spilled, %u%% unused\n",
+                           ( unsigned ) pxClass->uxSize,
+                           ( unsigned ) pxClass->uxFree,
+                           ( unsigned ) pxClass->uxMinimumFree,
+                           ( unsigned ) pxClass->uxCount,
+                           ( unsigned ) pxClass->ulAllocations,
+                           ( unsigned ) pxClass->ulSpills,
+                           ( unsigned ) ulWaste ) );
+    }
+
+    if( xStats.ulFailures != 0U )
+    {
+        LogWarn( ( "Buffers: %u requests failed\n", ( unsigned ) xStats.ulFailures ) );
+    }
+}
+/*-----------------------------------------------------------*/
@@ -0,0 +1,103 @@
+#ifndef NET_BUFFERS_H
+#define NET_BUFFERS_H
+
+/* FreeRTOS includes. */
+#include "FreeRTOS.h"
+
+/*
+ * Network buffer allocation with size classes, replacing BufferAllocation_2.c
+ * of FreeRTOS+TCP.  It implements the functions of NetworkBufferManagement.h.
+ *
+ * BufferAllocation_2.c takes every buffer from the heap with pvPortMalloc(),
+ * so a TCP ACK costs a heap search and leaves a hole between the full-size
+ * frames.  Here the RAM is split at start-up into three pools of fixed-size
+ * blocks: small for ACKs, ARP, ICMP and short UDP messages, medium for DNS
+ * and DHCP, and large for full-size frames.  A request is served by the
+ * smallest class that fits, or by a larger class when that one is empty.
+ *
+ * The free blocks of a class form a stack that is pushed and popped with
+ * LDREX/STREX, so that allocating a payload never disables interrupts.  The
+ * descriptors are managed as in BufferAllocation_2.c: a list, protected by a
+ * critical section, and a counting semaphore to wait for one.
+ *
+ * Blocks are aligned on, and sized in, 32-byte cache lines, so that the cache
+ * maintenance of the Ethernet driver never touches a neighbouring block.
+ *
+ * The zero-copy driver fills every RX descriptor with a large block, because
+ * it cannot know the size of the next frame.  The small classes serve the
+ * packets that the stack and the application send.
+ */
+
+/* The usable size of each class, the large class must hold a whole frame. */
+#ifndef configNET_BUFFERS_SMALL_SIZE
+    #define configNET_BUFFERS_SMALL_SIZE      128U
+#endif
+
+#ifndef configNET_BUFFERS_MEDIUM_SIZE
+    #define configNET_BUFFERS_MEDIUM_SIZE     512U
+#endif
+
+#ifndef configNET_BUFFERS_LARGE_SIZE
+    #define configNET_BUFFERS_LARGE_SIZE      ETH_RX_BUF_SIZE
+#endif
+
+/* The number of blocks in each class.  Together they should be at least
+ * ipconfigNUM_NETWORK_BUFFER_DESCRIPTORS. */
+#ifndef configNET_BUFFERS_SMALL_COUNT
+    #define configNET_BUFFERS_SMALL_COUNT     48U
+#endif
+
+#ifndef configNET_BUFFERS_MEDIUM_COUNT
+    #define configNET_BUFFERS_MEDIUM_COUNT    16U
+#endif
+
+#ifndef configNET_BUFFERS_LARGE_COUNT
+    #define configNET_BUFFERS_LARGE_COUNT     40U
+#endif
+
+#define netbuffersCLASS_COUNT                 3
+
+typedef struct xNET_BUFFERS_CLASS_STATS
+{
+    size_t uxSize;              /* Usable bytes of a block. */
+    UBaseType_t uxCount;        /* Blocks in the class. */
+    UBaseType_t uxFree;         /* Free blocks now. */
+    UBaseType_t uxMinimumFree;  /* The lowest number of free blocks ever. */
+    uint32_t ulAllocations;     /* Blocks handed out since the last reset. */
+    uint32_t ulSpills;          /* Of which for a request of a smaller class. */
+    uint32_t ulRequestedBytes;  /* Bytes asked for by those allocations. */
+} NetBuffersClassStats_t;
+
+typedef struct xNET_BUFFERS_STATS
+{
+    NetBuffersClassStats_t xClasses[ netbuffersCLASS_COUNT ];
+    uint32_t ulFailures;        /* Requests that no class could serve, since the last reset. */
+} NetBuffersStats_t;
+
+/**
+ * @brief Wait until a network buffer is released.  When several tasks wait,
+ * one of them wakes up per release.
+ *
+ * @param xTicksToWait The longest time to wait.
+ *
+ * @return pdTRUE when a buffer was released, pdFALSE after a time-out.
+ */
+BaseType_t xNetBuffersWaitRelease( TickType_t xTicksToWait );
+
+/**
+ * @brief Get the counters of the classes.
+ *
+ * @param xReset When pdTRUE, the counters that count since the last reset are
+ * cleared, so that a report every minute does not overflow them.
+ */
+void vNetBuffersGetStats( NetBuffersStats_t * pxStats,
+                          BaseType_t xReset );
+
+/**
+ * @brief Log the use of each class, and the share of its bytes that was
+ * wasted because the requests were smaller than the blocks.  Resets the
+ * counters.
+ */
+void vNetBuffersReport( void );
+
+#endif /* #ifndef NET_BUFFERS_H */
@@ -0,0 +1,318 @@
+/* The log messages of this file, see log_levels.h. */
+#define logMODULE    eLogModuleNet
+
+/* Standard includes. */
+#include <string.h>
+
+/* FreeRTOS includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+
+/* FreeRTOS+TCP includes. */
+#include "FreeRTOS_IP.h"
+#include "FreeRTOS_Routing.h"
+
+#include "net_services.h"
+
+/*
+ * Remember that an end-point went up or down.
+ */
+static void prvSetEndPointUp( NetworkEndPoint_t * pxEndPoint,
+                              BaseType_t xUp );
+
+/*
+ * Remember when an end-point was up for the first time, and log it.
+ */
+static void prvRecordReady( NetworkEndPoint_t * pxEndPoint );
+
+/*
+ * Log the address of an end-point followed by a message.
+ */
+static void prvLogEndPoint( const NetworkEndPoint_t * pxEndPoint,
+                            const char * pcMessage,
+                            TickType_t xTicks );
+
+/*
+ * Find out which of the netsvcNEEDS_ flags are currently met.
+ */
+static UBaseType_t prvMetNeeds( const NetService_t * pxService );
+
+/*-----------------------------------------------------------*/
+
+static NetService_t * pxServices[ configNET_SERVICES_MAX ];
+static BaseType_t xServiceCount = 0;
+
+/* The end-points that are up. */
+static NetworkEndPoint_t * pxUpEndPoints[ configNET_SERVICES_MAX_ENDPOINTS ];
+
+/* The backward compatible API reports events without an end-point. */
+static BaseType_t xLegacyIPv4Up = pdFALSE;
+
+/* The time from boot until each end-point was up for the first time. */
+typedef struct xNET_SERVICES_READY
+{
+    NetworkEndPoint_t * pxEndPoint;
+    TickType_t xReadyAt;
+} NetServicesReady_t;
+
+static NetServicesReady_t xReady[ configNET_SERVICES_MAX_ENDPOINTS ];
+
+/*-----------------------------------------------------------*/
+
+BaseType_t xNetServicesRegister( NetService_t * pxService )
+{
+    BaseType_t xReturn = pdFAIL;
+
+    configASSERT( pxService != NULL );
+    configASSERT( pxService->fnStart != NULL );
+
+    if( xServiceCount < configNET_SERVICES_MAX )
+    {
+        pxService->eState = eNetServiceWaiting;
+        pxService->xStartedAt = 0U;
+        pxService->xFirstPacketAt = 0U;
+        pxService->ulStartCount = 0U;
+        pxServices[ xServiceCount ] = pxService;
+        xServiceCount++;
+        xReturn = pdPASS;
+    }
+
+    return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+static void prvSetEndPointUp( NetworkEndPoint_t * pxEndPoint,
+                              BaseType_t xUp )
+{
+    BaseType_t x;
+    BaseType_t xFree = -1;
+
+    if( pxEndPoint == NULL )
+    {
+        xLegacyIPv4Up = xUp;
+    }
+    else
+    {
+        for( x = 0; x < configNET_SERVICES_MAX_ENDPOINTS; x++ )
+        {
+            if( pxUpEndPoints[ x ] == pxEndPoint )
+            {
+                if( xUp == pdFALSE )
+                {
+                    pxUpEndPoints[ x ] = NULL;
+                }
+
+                /* Already known. */
+                xFree = -2;
+                break;
+            }
+
+            if( ( pxUpEndPoints[ x ] == NULL ) && ( xFree == -1 ) )
+            {
+                xFree = x;
+            }
+        }
+
+        if( ( xUp != pdFALSE ) && ( xFree >= 0 ) )
+        {
+            pxUpEndPoints[ xFree ] = pxEndPoint;
+        }
+    }
+}
+/*-----------------------------------------------------------*/
+
+static void prvLogEndPoint( const NetworkEndPoint_t * pxEndPoint,
+                            const char * pcMessage,
+                            TickType_t xTicks )
+{
+    #if ( ipconfigUSE_IPv6 != 0 )
+        if( pxEndPoint->bits.bIPv6 != pdFALSE_UNSIGNED )
+        {
+            FreeRTOS_printf( ( "End-point %pip: %s %u ms\n",
+                               pxEndPoint->ipv6_settings.xIPAddress.ucBytes, pcMessage, ( unsigned ) pdTICKS_TO_MS( xTicks ) ) );
+        }
+        else
+    #endif /* ( ipconfigUSE_IPv6 != 0 ) */
+    {
+        FreeRTOS_printf( ( "End-point %xip: %s %u ms\n",
+                           ( unsigned ) FreeRTOS_ntohl( pxEndPoint->ipv4_settings.ulIPAddress ), pcMessage, ( unsigned ) pdTICKS_TO_MS( xTicks ) ) );
+    }
+}
+/*-----------------------------------------------------------*/
+
+static void prvRecordReady( NetworkEndPoint_t * pxEndPoint )
+{
+    BaseType_t x;
+
+    for( x = 0; x < configNET_SERVICES_MAX_ENDPOINTS; x++ )
+    {
+        if( xReady[ x ].pxEndPoint == pxEndPoint )
+        {
+            /* Only the first time counts. */
+            break;
+        }
+
+        if( xReady[ x ].pxEndPoint == NULL )
+        {
+            xReady[ x ].pxEndPoint = pxEndPoint;
+            xReady[ x ].xReadyAt = xTaskGetTickCount();
+            prvLogEndPoint( pxEndPoint, "ready after", xReady[ x ].xReadyAt );
+            break;
+        }
+    }
+}
+/*-----------------------------------------------------------*/
+
+static UBaseType_t prvMetNeeds( const NetService_t * pxService )
+{
+    UBaseType_t uxMet = 0U;
+    NetworkEndPoint_t * pxEndPoint;
+    BaseType_t x;
+
+    if( xLegacyIPv4Up != pdFALSE )
+    {
+        uxMet |= netsvcNEEDS_IPv4;
+    }
+
+    for( x = 0; x < configNET_SERVICES_MAX_ENDPOINTS; x++ )
+    {
+        pxEndPoint = pxUpEndPoints[ x ];
+
+        if( pxEndPoint == NULL )
+        {
+            continue;
+        }
+
+        if( pxEndPoint == pxService->pxEndPoint )
+        {
+            uxMet |= netsvcNEEDS_ENDPOINT;
+        }
+
+        #if ( ipconfigUSE_IPv6 != 0 )
+            if( pxEndPoint->bits.bIPv6 != pdFALSE_UNSIGNED )
+            {
+                uxMet |= netsvcNEEDS_IPv6;
+
+                /* fe80::/10 is link-local. */
+                if( ( pxEndPoint->ipv6_settings.xIPAddress.ucBytes[ 0 ] != 0xFEU ) ||
+                    ( ( pxEndPoint->ipv6_settings.xIPAddress.ucBytes[ 1 ] & 0xC0U ) != 0x80U ) )
+                {
+                    uxMet |= netsvcNEEDS_IPv6_GLOBAL;
+                }
+            }
+            else
+        #endif /* ( ipconfigUSE_IPv6 != 0 ) */
+        {
+            uxMet |= netsvcNEEDS_IPv4;
+        }
+    }
+
+    return uxMet;
+}
+/*-----------------------------------------------------------*/
+
+void vNetServicesNetworkEvent( eIPCallbackEvent_t eNetworkEvent,
+                               NetworkEndPoint_t * pxEndPoint )
+{
+    NetService_t * pxService;
+    BaseType_t xMet;
+    BaseType_t x;
+
+    prvSetEndPointUp( pxEndPoint, ( eNetworkEvent == eNetworkUp ) ? pdTRUE : pdFALSE );
+
+    if( ( eNetworkEvent == eNetworkUp ) && ( pxEndPoint != NULL ) )
+    {
+        prvRecordReady( pxEndPoint );
+    }
+
+    for( x = 0; x < xServiceCount; x++ )
+    {
+        pxService = pxServices[ x ];
+        xMet = ( ( prvMetNeeds( pxService ) & pxService->uxNeeds ) == pxService->uxNeeds ) ? pdTRUE : pdFALSE;
+
+        if( ( xMet != pdFALSE ) && ( pxService->eState != eNetServiceRunning ) )
+        {
+            if( pxService->eState == eNetServiceWaiting )
+            {
+                pxService->xStartedAt = xTaskGetTickCount();
+                FreeRTOS_printf( ( "Service %s: started after %u ms\n",
+                                   pxService->pcName, ( unsigned ) pdTICKS_TO_MS( pxService->xStartedAt ) ) );
+            }
+            else
+            {
+                FreeRTOS_printf( ( "Service %s: resumed\n", pxService->pcName ) );
+            }
+
+            pxService->eState = eNetServiceRunning;
+            pxService->ulStartCount++;
+            pxService->fnStart( pxService );
+        }
+        else if( ( xMet == pdFALSE ) && ( pxService->eState == eNetServiceRunning ) )
+        {
+            FreeRTOS_printf( ( "Service %s: paused\n", pxService->pcName ) );
+            pxService->eState = eNetServicePaused;
+
+            if( pxService->fnPause != NULL )
+            {
+                pxService->fnPause( pxService );
+            }
+        }
+        else
+        {
+            /* No change. */
+        }
+    }
+}
+/*-----------------------------------------------------------*/
+
+void vNetServicesFirstPacket( const char * pcName )
+{
+    NetService_t * pxService;
+    TickType_t xNow = xTaskGetTickCount();
+    BaseType_t x;
+
+    for( x = 0; x < xServiceCount; x++ )
+    {
+        pxService = pxServices[ x ];
+
+        if( strcmp( pxService->pcName, pcName ) == 0 )
+        {
+            taskENTER_CRITICAL();
+            {
+                if( pxService->xFirstPacketAt == 0U )
+                {
+                    /* Zero means "not yet". */
+                    pxService->xFirstPacketAt = ( xNow != 0U ) ? xNow : 1U;
+                }
+            }
+            taskEXIT_CRITICAL();
+            break;
+        }
+    }
+}
+/*-----------------------------------------------------------*/
+
+void vNetServicesReport( void )
+{
+    static const char * const pcStates[] = { "waiting", "running", "paused" };
+    NetService_t * pxService;
+    BaseType_t x;
+
+    for( x = 0; ( x < configNET_SERVICES_MAX_ENDPOINTS ) && ( xReady[ x ].pxEndPoint != NULL ); x++ )
+    {
+        prvLogEndPoint( xReady[ x ].pxEndPoint, "ready at", xReady[ x ].xReadyAt );
+    }
+
+    for( x = 0; x < xServiceCount; x++ )
+    {
+        pxService = pxServices[ x ];
+
+        FreeRTOS_printf( ( "Service %s: %s, started %u times, ready at %u ms, first packet at %u ms\n",
+                           pxService->pcName,
+                           pcStates[ pxService->eState ],
+                           ( unsigned ) pxService->ulStartCount,
+                           ( unsigned ) pdTICKS_TO_MS( pxService->xStartedAt ),
+                           ( unsigned ) pdTICKS_TO_MS( pxService->xFirstPacketAt ) ) );
+    }
+}
+/*-----------------------------------------------------------*/
@@ -0,0 +1,98 @@
+#ifndef NET_SERVICES_H
+#define NET_SERVICES_H
+
+/* FreeRTOS+TCP includes. */
+#include "FreeRTOS_IP.h"
+#include "FreeRTOS_Routing.h"
+
+/*
+ * Start application services as soon as the part of the network that they
+ * need is up, instead of waiting for every end-point.
+ *
+ * Each service declares what it needs: an IPv4 end-point, any IPv6 end-point,
+ * a global (not link-local) IPv6 end-point, or one specific end-point.  The
+ * network event hook passes every eNetworkUp/eNetworkDown to
+ * vNetServicesNetworkEvent().  A service is started the moment its needs are
+ * met and paused when they are lost, and it is resumed (started again) when
+ * they are met again.  So an IPv4 service runs on an IPv4-only LAN even when
+ * the IPv6 end-points never come up.
+ *
+ * For every service the time from boot until it was first started, and until
+ * it first exchanged a packet, is recorded.  So is the time from boot until
+ * each end-point was first up.
+ */
+
+/* Maximum number of services and of end-points that can be tracked. */
+#ifndef configNET_SERVICES_MAX
+    #define configNET_SERVICES_MAX        8
+#endif
+
+#ifndef configNET_SERVICES_MAX_ENDPOINTS
+    #define configNET_SERVICES_MAX_ENDPOINTS    4
+#endif
+
+/* What a service needs, may be OR-ed. */
+#define netsvcNEEDS_IPv4           ( 1U << 0 )  /* Any IPv4 end-point. */
+#define netsvcNEEDS_IPv6           ( 1U << 1 )  /* Any IPv6 end-point. */
+#define netsvcNEEDS_IPv6_GLOBAL    ( 1U << 2 )  /* An IPv6 end-point outside fe80::/10. */
+#define netsvcNEEDS_ENDPOINT       ( 1U << 3 )  /* The end-point in pxEndPoint. */
+
+typedef enum
+{
+    eNetServiceWaiting,   /* Never started. */
+    eNetServiceRunning,
+    eNetServicePaused     /* Started before, needs no longer met. */
+} eNetServiceState_t;
+
+typedef struct xNET_SERVICE NetService_t;
+
+struct xNET_SERVICE
+{
+    const char * pcName;
+    UBaseType_t uxNeeds;
+    NetworkEndPoint_t * pxEndPoint;   /* Only used with netsvcNEEDS_ENDPOINT. */
+
+    /* Called from the IP-task when the needs become met, both for the first
+     * start and for a resume. */
+    void ( * fnStart )( NetService_t * pxService );
+
+    /* Called from the IP-task when the needs are no longer met, may be NULL. */
+    void ( * fnPause )( NetService_t * pxService );
+
+    /* Maintained by this module. */
+    eNetServiceState_t eState;
+    TickType_t xStartedAt;            /* Tick count of the first start. */
+    TickType_t xFirstPacketAt;        /* 0 until vNetServicesFirstPacket(). */
+    uint32_t ulStartCount;
+};
+
+/**
+ * @brief Register a service.  Must be called before FreeRTOS_IPInit().
+ *
+ * @return pdPASS if success, pdFAIL when the table is full.
+ */
+BaseType_t xNetServicesRegister( NetService_t * pxService );
+
+/**
+ * @brief Pass a network event on, to be called from the network event hook.
+ *
+ * @param eNetworkEvent eNetworkUp or eNetworkDown.
+ * @param pxEndPoint The end-point concerned, or NULL for the single IPv4
+ * interface of the backward compatible API.
+ */
+void vNetServicesNetworkEvent( eIPCallbackEvent_t eNetworkEvent,
+                               NetworkEndPoint_t * pxEndPoint );
+
+/**
+ * @brief Record that the named service exchanged its first packet.  Only the
+ * first call per service is recorded.
+ */
+void vNetServicesFirstPacket( const char * pcName );
+
+/**
+ * @brief Log the time-to-ready of the end-points, and the state and start-up
+ * times of all services.
+ */
+void vNetServicesReport( void );
+
+#endif /* #ifndef NET_SERVICES_H */
@@ -0,0 +1,310 @@
+/* The log messages of this file, see log_levels.h. */
+#define logMODULE    eLogModuleNet
+
+/* Standard includes. */
+#include <string.h>
+
+/* FreeRTOS includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+#include "queue.h"
+
+/* FreeRTOS+TCP includes. */
+#include "FreeRTOS_IP.h"
+#include "FreeRTOS_IP_Private.h"
+#include "NetworkBufferManagement.h"
+
+/* ST includes, for ETH_RX_DESC_CNT. */
+#include "stm32h7xx_hal.h"
+
+#include "net_stats.h"
+#include "net_buffers.h"
+
+#if ( ipconfigCHECK_IP_QUEUE_SPACE == 0 )
+    #error ipconfigCHECK_IP_QUEUE_SPACE must be 1 to measure the IP-task event queue.
+#endif
+
+/* Weight of a new sample in the running average: 1 / 2^netstatsAVERAGE_SHIFT. */
+#define netstatsAVERAGE_SHIFT    4
+
+/*
+ * The task that samples the gauges and logs a report now and then.
+ */
+static void prvNetStatsTask( void * pvParameters );
+
+/*
+ * Add a sample to a gauge.
+ */
+static void prvGaugeSample( NetStatsGauge_t * pxGauge,
+                            UBaseType_t uxValue );
+
+/*
+ * Log one line about a gauge.
+ */
+static void prvGaugeReport( const char * pcName,
+                            const NetStatsGauge_t * pxGauge );
+
+/*
+ * Take one sample of the event queue and the network buffers.
+ */
+static void prvSample( void );
+
+/*
+ * Sample the network buffer pool and split the buffers in use up by holder.
+ */
+static void prvSampleBuffers( UBaseType_t uxEventDepth );
+
+/*
+ * Log the buffer gauges and the pool size that would fit the load.
+ */
+static void prvBuffersReport( const NetStats_t * pxStats );
+
+/*-----------------------------------------------------------*/
+
+static NetStats_t xStats;
+
+/* Written by the stack, possibly from an interrupt, so it is kept apart from
+ * xStats which is protected by a critical section. */
+static volatile uint32_t ulBufferFailures = 0U;
+
+/*-----------------------------------------------------------*/
+
+BaseType_t xNetStatsInitialize( uint16_t usStackSize,
+                                UBaseType_t uxPriority )
+{
+    memset( &xStats, 0, sizeof( xStats ) );
+    xStats.xEventQueue.uxCapacity = ipconfigEVENT_QUEUE_LENGTH;
+    xStats.xBuffers.uxCapacity = ipconfigNUM_NETWORK_BUFFER_DESCRIPTORS;
+    xStats.xBuffersQueued.uxCapacity = ipconfigNUM_NETWORK_BUFFER_DESCRIPTORS;
+    xStats.xBuffersOther.uxCapacity = ipconfigNUM_NETWORK_BUFFER_DESCRIPTORS;
+
+    return xTaskCreate( prvNetStatsTask, "NetStats", usStackSize, NULL, uxPriority, NULL );
+}
+/*-----------------------------------------------------------*/
+
+static void prvGaugeSample( NetStatsGauge_t * pxGauge,
+                            UBaseType_t uxValue )
+{
+    uint32_t ulScaled = ( uint32_t ) uxValue * netstatsFIXED_ONE;
+
+    pxGauge->uxCurrent = uxValue;
+
+    if( uxValue > pxGauge->uxHighWater )
+    {
+        pxGauge->uxHighWater = uxValue;
+    }
+
+    /* The samples are taken at a fixed interval, so their running average is
+     * a time weighted average. */
+    if( ulScaled >= pxGauge->ulAverage )
+    {
+        pxGauge->ulAverage += ( ulScaled - pxGauge->ulAverage ) >> netstatsAVERAGE_SHIFT;
+    }
+    else
+    {
+        pxGauge->ulAverage -= ( pxGauge->ulAverage - ulScaled ) >> netstatsAVERAGE_SHIFT;
+    }
+}
+/*-----------------------------------------------------------*/
+
+static void prvGaugeReport( const char * pcName,
+                            const NetStatsGauge_t * pxGauge )
+{
+    FreeRTOS_printf( ( "%s: now %u, avg %u.%02u, max %u of %u\n",
+                       pcName,
+                       ( unsigned ) pxGauge->uxCurrent,
+                       ( unsigned ) ( pxGauge->ulAverage / netstatsFIXED_ONE ),
+                       ( unsigned ) ( ( ( pxGauge->ulAverage % netstatsFIXED_ONE ) * 100U ) / netstatsFIXED_ONE ),
+                       ( unsigned ) pxGauge->uxHighWater,
+                       ( unsigned ) pxGauge->uxCapacity ) );
+}
+/*-----------------------------------------------------------*/
+
+static void prvSampleBuffers( UBaseType_t uxEventDepth )
+{
+    UBaseType_t uxInUse;
+    UBaseType_t uxHeld;
+    UBaseType_t uxQueued;
+    UBaseType_t uxPeak;
+
+    uxInUse = ipconfigNUM_NETWORK_BUFFER_DESCRIPTORS - uxGetNumberOfFreeNetworkBuffers();
+    prvGaugeSample( &( xStats.xBuffers ), uxInUse );
+
+    /* Like the event queue, the pool has a low-water mark of its own. */
+    uxPeak = ipconfigNUM_NETWORK_BUFFER_DESCRIPTORS - uxGetMinimumFreeNetworkBuffers();
+
+    if( uxPeak > xStats.xBuffers.uxHighWater )
+    {
+        xStats.xBuffers.uxHighWater = uxPeak;
+    }
+
+    /* The zero-copy driver keeps a buffer in each RX descriptor all the time.
+     * Not every event carries a buffer, so the event queue depth is an upper
+     * bound of the buffers waiting for the IP-task. */
+    uxHeld = ( uxInUse > ETH_RX_DESC_CNT ) ? ( uxInUse - ETH_RX_DESC_CNT ) : 0U;
+    uxQueued = ( uxEventDepth < uxHeld ) ? uxEventDepth : uxHeld;
+
+    prvGaugeSample( &( xStats.xBuffersQueued ), uxQueued );
+    prvGaugeSample( &( xStats.xBuffersOther ), uxHeld - uxQueued );
+
+    xStats.ulBufferFailures = ulBufferFailures;
+}
+/*-----------------------------------------------------------*/
+
+static void prvBuffersReport( const NetStats_t * pxStats )
+{
+    UBaseType_t uxRecommended;
+
+    prvGaugeReport( "Network buffers", &( pxStats->xBuffers ) );
+    FreeRTOS_printf( ( "  RX ring %u, posted to IP-task max %u, sockets/ARP/TX max %u, failures %u\n",
+                       ( unsigned ) ETH_RX_DESC_CNT,
+                       ( unsigned ) pxStats->xBuffersQueued.uxHighWater,
+                       ( unsigned ) pxStats->xBuffersOther.uxHighWater,
+                       ( unsigned ) pxStats->ulBufferFailures ) );
+
+    /* The peak plus a margin.  When the pool ran dry the real peak is not
+     * known, only that it was more than the pool, so the margin goes on top of
+     * the whole pool. */
+    uxRecommended = pxStats->xBuffers.uxHighWater;
+
+    if( pxStats->ulBufferFailures != 0U )
+    {
+        uxRecommended = ipconfigNUM_NETWORK_BUFFER_DESCRIPTORS;
+    }
+
+    uxRecommended += ( ( uxRecommended * configNET_STATS_BUFFER_MARGIN_PERCENT ) + 99U ) / 100U;
+
+    /* Never less than both DMA rings. */
+    if( uxRecommended < ( ETH_RX_DESC_CNT + ETH_TX_DESC_CNT ) )
+    {
+        uxRecommended = ETH_RX_DESC_CNT + ETH_TX_DESC_CNT;
+    }
+
+    FreeRTOS_printf( ( "  ipconfigNUM_NETWORK_BUFFER_DESCRIPTORS %u, recommended %u\n",
+                       ( unsigned ) ipconfigNUM_NETWORK_BUFFER_DESCRIPTORS,
+                       ( unsigned ) uxRecommended ) );
+}
+/*-----------------------------------------------------------*/
+
+static void prvSample( void )
+{
+    UBaseType_t uxDepth;
+    UBaseType_t uxMinimumSpace;
+
+    /* The queue is created by FreeRTOS_IPInit(). */
+    uxDepth = ( xNetworkEventQueue != NULL ) ? uxQueueMessagesWaiting( xNetworkEventQueue ) : 0U;
+
+    taskENTER_CRITICAL();
+    {
+        xStats.ulSamples++;
+        prvGaugeSample( &( xStats.xEventQueue ), uxDepth );
+
+        /* The stack keeps its own low-water mark of free space, which also
+         * catches peaks between two samples. */
+        uxMinimumSpace = uxGetMinimumIPQueueSpace();
+
+        if( ( ipconfigEVENT_QUEUE_LENGTH - uxMinimumSpace ) > xStats.xEventQueue.uxHighWater )
+        {
+            xStats.xEventQueue.uxHighWater = ipconfigEVENT_QUEUE_LENGTH - uxMinimumSpace;
+        }
+
+        prvSampleBuffers( uxDepth );
+    }
+    taskEXIT_CRITICAL();
+}
+/*-----------------------------------------------------------*/
+
+static void prvNetStatsTask( void * pvParameters )
+{
+    TickType_t xLastWake = xTaskGetTickCount();
+    TickType_t xLastReport = xLastWake;
+
+    /* Disable unused parameter warning. */
+    ( void ) pvParameters;
+
+    for( ; ; )
+    {
+        vTaskDelayUntil( &xLastWake, pdMS_TO_TICKS( configNET_STATS_SAMPLE_PERIOD_MS ) );
+        prvSample();
+
+        #if ( configNET_STATS_REPORT_PERIOD_MS != 0 )
+        {
+            if( ( xLastWake - xLastReport ) >= pdMS_TO_TICKS( configNET_STATS_REPORT_PERIOD_MS ) )
+            {
+                xLastReport = xLastWake;
+                vNetStatsReport();
+                vApplicationNetStatsReportHook();
+            }
+        }
+        #endif
+    }
+}
+/*-----------------------------------------------------------*/
+
+void vNetStatsGet( NetStats_t * pxStats )
+{
+    taskENTER_CRITICAL();
+    {
+        memcpy( pxStats, &xStats, sizeof( *pxStats ) );
+    }
+    taskEXIT_CRITICAL();
+}
+/*-----------------------------------------------------------*/
+
+void vNetStatsReport( void )
+{
+    NetStats_t xCopy;
+
+    vNetStatsGet( &xCopy );
+
+    prvGaugeReport( "IP event queue", &( xCopy.xEventQueue ) );
+    prvBuffersReport( &xCopy );
+    vNetBuffersReport();
+}
+/*-----------------------------------------------------------*/
+
+void vNetStatsBufferFailure( void )
+{
+    /* A lost increment when an interrupt races with a task is acceptable for
+     * a statistic, and it keeps this call cheap inside the stack. */
+    ulBufferFailures++;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xNetStatsBuffersAvailable( UBaseType_t uxNeeded )
+{
+    BaseType_t xReturn = pdFALSE;
+
+    if( uxGetNumberOfFreeNetworkBuffers() >= ( uxNeeded + ETH_RX_DESC_CNT ) )
+    {
+        xReturn = pdTRUE;
+    }
+
+    return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xNetStatsWaitBuffersAvailable( UBaseType_t uxNeeded,
+                                          TickType_t xTicksToWait )
+{
+    TimeOut_t xTimeOut;
+    BaseType_t xReturn;
+
+    vTaskSetTimeOutState( &xTimeOut );
+
+    for( ; ; )
+    {
+        xReturn = xNetStatsBuffersAvailable( uxNeeded );
+
+        if( ( xReturn != pdFALSE ) || ( xTaskCheckForTimeOut( &xTimeOut, &xTicksToWait ) != pdFALSE ) )
+        {
+            break;
+        }
+
+        /* One release may not be enough, check again after each one. */
+        ( void ) xNetBuffersWaitRelease( xTicksToWait );
+    }
+
+    return xReturn;
+}
+/*-----------------------------------------------------------*/
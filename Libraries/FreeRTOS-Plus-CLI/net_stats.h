@@ -0,0 +1,119 @@
+#ifndef NET_STATS_H
+#define NET_STATS_H
+
+/* Kernel includes. */
+#include "FreeRTOS.h"
+
+/*
+ * Periodic sampling of the resources of the IP stack, so that their sizes in
+ * FreeRTOSIPConfig.h can be tuned on measurements instead of guesses.
+ *
+ * IP-task event queue: every received frame, socket send, timer and
+ * DHCP/RA event is posted to one queue of ipconfigEVENT_QUEUE_LENGTH entries.
+ * The depth of that queue is the delay that an urgent event, such as a TCP
+ * ACK, suffers behind bulk traffic.  The queue is a single FIFO inside
+ * FreeRTOS+TCP, so these numbers are what there is to tune it with:
+ * ipconfigEVENT_QUEUE_LENGTH and the priorities of the IP-task and the EMAC
+ * task.
+ *
+ * Network buffers: the pool of ipconfigNUM_NETWORK_BUFFER_DESCRIPTORS
+ * buffers.  The buffers in use are split up by who holds them: the Ethernet
+ * RX ring (one buffer per DMA descriptor), the IP-task event queue (at most
+ * one per event), and the rest, which sit in socket queues, the ARP queue or
+ * are being sent.  When the pool is empty the stack drops the packet and
+ * vNetStatsBufferFailure() counts it.  The report recommends a pool size for
+ * the load seen so far.
+ */
+
+/* How often the resources are sampled. */
+#ifndef configNET_STATS_SAMPLE_PERIOD_MS
+    #define configNET_STATS_SAMPLE_PERIOD_MS    100U
+#endif
+
+/* How often a report is logged, 0 to only report on request. */
+#ifndef configNET_STATS_REPORT_PERIOD_MS
+    #define configNET_STATS_REPORT_PERIOD_MS    60000U
+#endif
+
+/* Buffers to keep free on top of the highest use seen, in percent. */
+#ifndef configNET_STATS_BUFFER_MARGIN_PERCENT
+    #define configNET_STATS_BUFFER_MARGIN_PERCENT    25U
+#endif
+
+/* Averages are kept as fixed point numbers with 8 fractional bits. */
+#define netstatsFIXED_ONE                       256U
+
+typedef struct xNET_STATS_GAUGE
+{
+    UBaseType_t uxCapacity;     /* The maximum possible value. */
+    UBaseType_t uxCurrent;      /* The value at the last sample. */
+    UBaseType_t uxHighWater;    /* The highest value ever. */
+    uint32_t ulAverage;         /* Time weighted average, fixed point. */
+} NetStatsGauge_t;
+
+typedef struct xNET_STATS
+{
+    uint32_t ulSamples;
+    NetStatsGauge_t xEventQueue;    /* Events waiting for the IP-task. */
+    NetStatsGauge_t xBuffers;       /* Network buffers in use. */
+    NetStatsGauge_t xBuffersQueued; /* Of which posted to the IP-task, at most. */
+    NetStatsGauge_t xBuffersOther;  /* Of which in sockets, the ARP queue or TX. */
+    uint32_t ulBufferFailures;      /* Times the pool was empty. */
+} NetStats_t;
+
+/**
+ * @brief Create the task that samples the statistics.
+ *
+ * @param usStackSize Stack size of the task.
+ * @param uxPriority Priority of the task.
+ *
+ * @return pdPASS if success, pdFAIL otherwise.
+ */
+BaseType_t xNetStatsInitialize( uint16_t usStackSize,
+                                UBaseType_t uxPriority );
+
+/**
+ * @brief Get a copy of the current statistics.
+ */
+void vNetStatsGet( NetStats_t * pxStats );
+
+/**
+ * @brief Log the current statistics.
+ */
+void vNetStatsReport( void );
+
+/**
+ * @brief Called by the statistics task after each periodic report.  Defined
+ * by the application, which logs the reports of its other modules there.
+ */
+void vApplicationNetStatsReportHook( void );
+
+/**
+ * @brief Count a failure to obtain a network buffer.  Called by the stack
+ * through iptraceFAILED_TO_OBTAIN_NETWORK_BUFFER(), also from interrupts.
+ */
+void vNetStatsBufferFailure( void );
+
+/**
+ * @brief Backpressure for application tasks: check whether sending a burst of
+ * packets would leave the stack enough buffers to receive.
+ *
+ * @param uxNeeded The number of buffers that the caller is about to use.
+ *
+ * @return pdTRUE when at least uxNeeded buffers plus the RX ring size are free.
+ */
+BaseType_t xNetStatsBuffersAvailable( UBaseType_t uxNeeded );
+
+/**
+ * @brief Like xNetStatsBuffersAvailable(), but block until enough buffers
+ * were released, instead of polling.
+ *
+ * @param uxNeeded The number of buffers that the caller is about to use.
+ * @param xTicksToWait The longest time to wait.
+ *
+ * @return pdTRUE when enough buffers are free, pdFALSE after a time-out.
+ */
+BaseType_t xNetStatsWaitBuffersAvailable( UBaseType_t uxNeeded,
+                                          TickType_t xTicksToWait );
+
+#endif /* #ifndef NET_STATS_H */
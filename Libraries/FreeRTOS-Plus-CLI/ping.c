@@ -0,0 +1,594 @@
+/* The log messages of this file, see log_levels.h. */
+#define logMODULE    eLogModuleNet
+
+/* Standard includes. */
+#include <string.h>
+
+/* FreeRTOS includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+#include "queue.h"
+
+/* FreeRTOS+TCP includes. */
+#include "FreeRTOS_IP.h"
+#include "FreeRTOS_Sockets.h"
+
+#include "ping.h"
+#include "route_cache.h"
+#include "uptime.h"
+
+#if ( ipconfigSUPPORT_OUTGOING_PINGS == 0 )
+    #error ipconfigSUPPORT_OUTGOING_PINGS must be 1 to send echo requests.
+#endif
+
+/* The longest the task sleeps, so that a new target is pinged soon. */
+#define pingMAX_WAIT_MS    1000U
+
+typedef struct xPING_TARGET
+{
+    const char * pcName;
+    BaseType_t xIPv6;
+    IP_Address_t xAddress;   /* IPv4 in network byte order. */
+    TickType_t xPeriod;
+    TickType_t xNextSend;
+    BaseType_t xReplied;     /* A reply was ever received. */
+    uint64_t ullSumUs;       /* Of all round trips, for the average. */
+    PingStats_t xStats;
+} PingTarget_t;
+
+typedef struct xPING_REQUEST
+{
+    BaseType_t xInUse;
+    BaseType_t xTarget;
+    uint16_t usSequence;
+    uint32_t ulSentUs;
+    TickType_t xSent;
+} PingRequest_t;
+
+/* Passed from the IP-task to the ping task. */
+typedef struct xPING_REPLY
+{
+    ePingReplyStatus_t eStatus;
+    uint16_t usSequence;
+    uint32_t ulReceivedUs;
+} PingReply_t;
+
+/*
+ * The task that sends the requests and handles the replies.
+ */
+static void prvPingTask( void * pvParameters );
+
+/*
+ * One round of the ping task: send what is due, expire what timed out, and
+ * wait for replies until the next of those.
+ */
+static void prvPingRound( void );
+
+/*
+ * Send the requests that are due.
+ */
+static void prvSendDue( TickType_t xNow );
+
+/*
+ * Send one request to a target.  Returns pdFALSE when the request has to
+ * wait, see prvSequenceClash().
+ */
+static BaseType_t prvSend( BaseType_t xTarget,
+                           TickType_t xNow );
+
+/*
+ * Tell whether the reply to the next request of an IP type could be taken
+ * for the reply to an outstanding request of the other type.
+ */
+static BaseType_t prvSequenceClash( BaseType_t xIPv6 );
+
+/*
+ * Count the requests that did not get a reply in time as lost.
+ */
+static void prvExpire( TickType_t xNow );
+
+/*
+ * Match a reply to its request and update the statistics of the target.
+ */
+static void prvHandleReply( const PingReply_t * pxReply );
+
+/*
+ * The time until the next request is due or times out.
+ */
+static TickType_t prvTimeToNextEvent( TickType_t xNow );
+
+/*-----------------------------------------------------------*/
+
+static PingTarget_t xTargets[ configPING_MAX_TARGETS ];
+
+static BaseType_t xTargetCount = 0;
+
+/* Only used by the ping task. */
+static PingRequest_t xRequests[ configPING_MAX_OUTSTANDING ];
+
+static QueueHandle_t xReplyQueue = NULL;
+
+/* The sequence number that the stack gave to the last request of each IP
+ * type, IPv4 first.  Only used by the ping task. */
+static uint16_t usLastSequence[ 2 ];
+static BaseType_t xSequenceKnown[ 2 ] = { pdFALSE, pdFALSE };
+
+/*-----------------------------------------------------------*/
+
+BaseType_t xPingInitialise( uint16_t usStackSize,
+                            UBaseType_t uxPriority )
+{
+    BaseType_t xReturn = pdFAIL;
+
+    if( xReplyQueue == NULL )
+    {
+        /* At most one reply per outstanding request. */
+        xReplyQueue = xQueueCreate( configPING_MAX_OUTSTANDING, sizeof( PingReply_t ) );
+
+        if( xReplyQueue != NULL )
+        {
+            xReturn = xTaskCreate( prvPingTask, "Ping", usStackSize, NULL, uxPriority, NULL );
+
+            if( xReturn != pdPASS )
+            {
+                vQueueDelete( xReplyQueue );
+                xReplyQueue = NULL;
+            }
+        }
+    }
+
+    return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xPingAddTarget( const char * pcName,
+                           const char * pcAddress,
+                           uint32_t ulPeriodMS )
+{
+    PingTarget_t xTarget;
+    BaseType_t xReturn = -1;
+
+    memset( &xTarget, 0, sizeof( xTarget ) );
+    xTarget.pcName = pcName;
+    xTarget.xPeriod = pdMS_TO_TICKS( ulPeriodMS );
+    xTarget.xPeriod = ( xTarget.xPeriod == 0U ) ? 1U : xTarget.xPeriod;
+    xTarget.xNextSend = xTaskGetTickCount();
+
+    if( FreeRTOS_inet_pton( FREERTOS_AF_INET4, pcAddress, &( xTarget.xAddress.ulIP_IPv4 ) ) == pdPASS )
+    {
+        xTarget.xIPv6 = pdFALSE;
+        xReturn = 0;
+    }
+
+    #if ( ipconfigUSE_IPv6 != 0 )
+        else if( FreeRTOS_inet_pton( FREERTOS_AF_INET6, pcAddress, xTarget.xAddress.xIP_IPv6.ucBytes ) == pdPASS )
+        {
+            xTarget.xIPv6 = pdTRUE;
+            xReturn = 0;
+        }
+    #endif
+
+    if( xReturn == 0 )
+    {
+        xReturn = -1;
+
+        taskENTER_CRITICAL();
+        {
+            if( xTargetCount < ( BaseType_t ) configPING_MAX_TARGETS )
+            {
+                xReturn = xTargetCount;
+                memcpy( &( xTargets[ xReturn ] ), &xTarget, sizeof( xTarget ) );
+                xTargetCount++;
+            }
+        }
+        taskEXIT_CRITICAL();
+    }
+
+    if( xReturn < 0 )
+    {
+        LogWarn( ( "ping: cannot add %s (%s)\n", pcName, pcAddress ) );
+    }
+
+    return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+void vPingGetStats( BaseType_t xTarget,
+                    PingStats_t * pxStats,
+                    BaseType_t xReset )
+{
+    PingTarget_t * pxTarget;
+
+    configASSERT( ( xTarget >= 0 ) && ( xTarget < xTargetCount ) );
+    pxTarget = &( xTargets[ xTarget ] );
+
+    taskENTER_CRITICAL();
+    {
+        memcpy( pxStats, &( pxTarget->xStats ), sizeof( *pxStats ) );
+
+        if( xReset != pdFALSE )
+        {
+            /* The health signal does not start afresh. */
+            uint32_t ulLostInARow = pxTarget->xStats.ulLostInARow;
+
+            memset( &( pxTarget->xStats ), 0, sizeof( pxTarget->xStats ) );
+            pxTarget->xStats.ulLostInARow = ulLostInARow;
+            pxTarget->ullSumUs = 0U;
+        }
+    }
+    taskEXIT_CRITICAL();
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xPingIsReachable( BaseType_t xTarget )
+{
+    PingTarget_t * pxTarget;
+
+    configASSERT( ( xTarget >= 0 ) && ( xTarget < xTargetCount ) );
+    pxTarget = &( xTargets[ xTarget ] );
+
+    return ( ( pxTarget->xReplied != pdFALSE ) &&
+             ( pxTarget->xStats.ulLostInARow < configPING_UNREACHABLE_AFTER ) ) ? pdTRUE : pdFALSE;
+}
+/*-----------------------------------------------------------*/
+
+void vPingReport( void )
+{
+    PingStats_t xStats;
+    BaseType_t xTarget;
+
+    for( xTarget = 0; xTarget < xTargetCount; xTarget++ )
+    {
+        vPingGetStats( xTarget, &xStats, pdFALSE );
+
+        FreeRTOS_printf( ( "ping: %-10s %s %u/%u replies, %u lost, %u errors, %u no route, rtt min/avg/max/jitter %u/%u/%u/%u us\n",
+                           xTargets[ xTarget ].pcName,
+                           ( xPingIsReachable( xTarget ) != pdFALSE ) ? "up  " : "down",
+                           ( unsigned ) xStats.ulReceived,
+                           ( unsigned ) xStats.ulSent,
+                           ( unsigned ) xStats.ulLost,
+                           ( unsigned ) xStats.ulErrors,
+                           ( unsigned ) xStats.ulNoRoute,
+                           ( unsigned ) xStats.ulMinUs,
+                           ( unsigned ) xStats.ulAvgUs,
+                           ( unsigned ) xStats.ulMaxUs,
+                           ( unsigned ) xStats.ulJitterUs ) );
+    }
+}
+/*-----------------------------------------------------------*/
+
+void vPingReplyReceived( ePingReplyStatus_t eStatus,
+                         uint16_t usIdentifier )
+{
+    PingReply_t xReply;
+
+    /* Take the time first, this runs in the IP-task. */
+    xReply.ulReceivedUs = ulUptimeMicroseconds();
+    xReply.eStatus = eStatus;
+    xReply.usSequence = usIdentifier;
+
+    if( xReplyQueue != NULL )
+    {
+        /* Never block the IP-task.  When the queue is full the request
+         * times out. */
+        ( void ) xQueueSend( xReplyQueue, &xReply, 0U );
+    }
+}
+/*-----------------------------------------------------------*/
+
+static void prvPingRound( void )
+{
+    PingReply_t xReply;
+    TickType_t xNow;
+
+    xNow = xTaskGetTickCount();
+    prvSendDue( xNow );
+    prvExpire( xNow );
+
+    /* Replies that arrive while requests are sent wait in the queue, so
+     * they always find their request. */
+    if( xQueueReceive( xReplyQueue, &xReply, prvTimeToNextEvent( xTaskGetTickCount() ) ) == pdPASS )
+    {
+        do
+        {
+            prvHandleReply( &xReply );
+        } while( xQueueReceive( xReplyQueue, &xReply, 0U ) == pdPASS );
+    }
+}
+/*-----------------------------------------------------------*/
+
+static void prvPingTask( void * pvParameters )
+{
+    /* Disable unused parameter warning. */
+    ( void ) pvParameters;
+
+    for( ; ; )
+    {
+        prvPingRound();
+    }
+}
+/*-----------------------------------------------------------*/
+
+static void prvSendDue( TickType_t xNow )
+{
+    PingTarget_t * pxTarget;
+    BaseType_t xTarget;
+    BaseType_t xCount;
+
+    taskENTER_CRITICAL();
+    {
+        xCount = xTargetCount;
+    }
+    taskEXIT_CRITICAL();
+
+    for( xTarget = 0; xTarget < xCount; xTarget++ )
+    {
+        pxTarget = &( xTargets[ xTarget ] );
+
+        /* Due when xNextSend is not in the future, with wrap-around. */
+        if( ( TickType_t ) ( xNow - pxTarget->xNextSend ) < ( portMAX_DELAY / 2U ) )
+        {
+            if( prvSend( xTarget, xNow ) == pdFALSE )
+            {
+                /* Try again on the next tick. */
+                pxTarget->xNextSend = xNow + 1U;
+            }
+            else
+            {
+                pxTarget->xNextSend += pxTarget->xPeriod;
+
+                /* Do not send a burst to catch up after a long delay. */
+                if( ( TickType_t ) ( xNow - pxTarget->xNextSend ) < ( portMAX_DELAY / 2U ) )
+                {
+                    pxTarget->xNextSend = xNow + pxTarget->xPeriod;
+                }
+            }
+        }
+    }
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvSend( BaseType_t xTarget,
+                           TickType_t xNow )
+{
+    PingTarget_t * pxTarget = &( xTargets[ xTarget ] );
+    PingRequest_t * pxRequest = NULL;
+    BaseType_t xIndex;
+    BaseType_t xSequence = pdFAIL;
+    BaseType_t xReturn = pdTRUE;
+    uint32_t ulSentUs;
+    struct freertos_sockaddr xDestination;
+    Route_t xRoute;
+
+    for( xIndex = 0; xIndex < ( BaseType_t ) configPING_MAX_OUTSTANDING; xIndex++ )
+    {
+        if( xRequests[ xIndex ].xInUse == pdFALSE )
+        {
+            pxRequest = &( xRequests[ xIndex ] );
+            break;
+        }
+    }
+
+    memset( &xDestination, 0, sizeof( xDestination ) );
+    xDestination.sin_family = ( pxTarget->xIPv6 != pdFALSE ) ? FREERTOS_AF_INET6 : FREERTOS_AF_INET4;
+    xDestination.sin_address = pxTarget->xAddress;
+
+    /* A request that no end-point can send would only be counted as lost. */
+    if( xRouteCacheLookup( &xDestination, &xRoute ) != pdPASS )
+    {
+        taskENTER_CRITICAL();
+        {
+            pxTarget->xStats.ulNoRoute++;
+        }
+        taskEXIT_CRITICAL();
+    }
+    else if( prvSequenceClash( pxTarget->xIPv6 ) != pdFALSE )
+    {
+        xReturn = pdFALSE;
+    }
+    else if( pxRequest != NULL )
+    {
+        ulSentUs = ulUptimeMicroseconds();
+
+        /* Do not wait for a network buffer, the next period tries again. */
+        if( pxTarget->xIPv6 == pdFALSE )
+        {
+            xSequence = FreeRTOS_SendPingRequest( pxTarget->xAddress.ulIP_IPv4, configPING_PAYLOAD_SIZE, 0U );
+        }
+
+        #if ( ipconfigUSE_IPv6 != 0 )
+            else
+            {
+                xSequence = FreeRTOS_SendPingRequestIPv6( &( pxTarget->xAddress.xIP_IPv6 ), configPING_PAYLOAD_SIZE, 0U );
+            }
+        #endif
+
+        if( xSequence != pdFAIL )
+        {
+            usLastSequence[ pxTarget->xIPv6 ] = ( uint16_t ) xSequence;
+            xSequenceKnown[ pxTarget->xIPv6 ] = pdTRUE;
+
+            pxRequest->xInUse = pdTRUE;
+            pxRequest->xTarget = xTarget;
+            pxRequest->usSequence = ( uint16_t ) xSequence;
+            pxRequest->ulSentUs = ulSentUs;
+            pxRequest->xSent = xNow;
+
+            taskENTER_CRITICAL();
+            {
+                pxTarget->xStats.ulSent++;
+            }
+            taskEXIT_CRITICAL();
+        }
+    }
+
+    return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvSequenceClash( BaseType_t xIPv6 )
+{
+    BaseType_t xReturn = pdFALSE;
+    BaseType_t xIndex;
+    uint16_t usNext = ( uint16_t ) ( usLastSequence[ xIPv6 ] + 1U );
+
+    /* The stack numbers the requests of each IP type with a counter of its
+     * own, and only this module sends them, so the next number is known once
+     * a request of the type was sent. */
+    for( xIndex = 0; xIndex < ( BaseType_t ) configPING_MAX_OUTSTANDING; xIndex++ )
+    {
+        if( ( xRequests[ xIndex ].xInUse != pdFALSE ) &&
+            ( xTargets[ xRequests[ xIndex ].xTarget ].xIPv6 != xIPv6 ) &&
+            ( ( xSequenceKnown[ xIPv6 ] == pdFALSE ) || ( xRequests[ xIndex ].usSequence == usNext ) ) )
+        {
+            xReturn = pdTRUE;
+            break;
+        }
+    }
+
+    return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+static void prvExpire( TickType_t xNow )
+{
+    PingRequest_t * pxRequest;
+    PingTarget_t * pxTarget;
+    BaseType_t xIndex;
+    uint32_t ulLostInARow;
+
+    for( xIndex = 0; xIndex < ( BaseType_t ) configPING_MAX_OUTSTANDING; xIndex++ )
+    {
+        pxRequest = &( xRequests[ xIndex ] );
+
+        if( ( pxRequest->xInUse != pdFALSE ) &&
+            ( ( xNow - pxRequest->xSent ) >= pdMS_TO_TICKS( configPING_TIMEOUT_MS ) ) )
+        {
+            pxRequest->xInUse = pdFALSE;
+            pxTarget = &( xTargets[ pxRequest->xTarget ] );
+
+            taskENTER_CRITICAL();
+            {
+                pxTarget->xStats.ulLost++;
+                pxTarget->xStats.ulLostInARow++;
+                ulLostInARow = pxTarget->xStats.ulLostInARow;
+            }
+            taskEXIT_CRITICAL();
+
+            if( ulLostInARow == configPING_UNREACHABLE_AFTER )
+            {
+                LogWarn( ( "ping: %s is unreachable\n", pxTarget->pcName ) );
+            }
+        }
+    }
+}
+/*-----------------------------------------------------------*/
+
+static void prvHandleReply( const PingReply_t * pxReply )
+{
+    PingRequest_t * pxRequest = NULL;
+    PingTarget_t * pxTarget;
+    PingStats_t * pxStats;
+    BaseType_t xIndex;
+    TickType_t xNow = xTaskGetTickCount();
+    uint32_t ulRoundTripUs;
+    int32_t lDelta;
+    BaseType_t xWasDown;
+
+    /* The oldest request with this sequence number. */
+    for( xIndex = 0; xIndex < ( BaseType_t ) configPING_MAX_OUTSTANDING; xIndex++ )
+    {
+        if( ( xRequests[ xIndex ].xInUse != pdFALSE ) &&
+            ( xRequests[ xIndex ].usSequence == pxReply->usSequence ) &&
+            ( ( pxRequest == NULL ) || ( ( xNow - xRequests[ xIndex ].xSent ) > ( xNow - pxRequest->xSent ) ) ) )
+        {
+            pxRequest = &( xRequests[ xIndex ] );
+        }
+    }
+
+    if( pxRequest != NULL )
+    {
+        /* Otherwise the reply came after the time-out, and the request was
+         * counted as lost already. */
+        pxRequest->xInUse = pdFALSE;
+        pxTarget = &( xTargets[ pxRequest->xTarget ] );
+        pxStats = &( pxTarget->xStats );
+        ulRoundTripUs = pxReply->ulReceivedUs - pxRequest->ulSentUs;
+        xWasDown = ( xPingIsReachable( pxRequest->xTarget ) == pdFALSE ) ? pdTRUE : pdFALSE;
+
+        taskENTER_CRITICAL();
+        {
+            if( pxReply->eStatus != eSuccess )
+            {
+                pxStats->ulErrors++;
+            }
+            else
+            {
+                if( ( pxStats->ulReceived == 0U ) || ( ulRoundTripUs < pxStats->ulMinUs ) )
+                {
+                    pxStats->ulMinUs = ulRoundTripUs;
+                }
+
+                if( ulRoundTripUs > pxStats->ulMaxUs )
+                {
+                    pxStats->ulMaxUs = ulRoundTripUs;
+                }
+
+                if( pxStats->ulReceived > 0U )
+                {
+                    /* RFC 3550: J += ( |D| - J ) / 16. */
+                    lDelta = ( int32_t ) ( ulRoundTripUs - pxStats->ulLastUs );
+                    lDelta = ( lDelta < 0 ) ? -lDelta : lDelta;
+                    pxStats->ulJitterUs = ( uint32_t ) ( ( int32_t ) pxStats->ulJitterUs + ( ( lDelta - ( int32_t ) pxStats->ulJitterUs ) / 16 ) );
+                }
+
+                pxStats->ulReceived++;
+                pxStats->ulLastUs = ulRoundTripUs;
+                pxStats->ulLostInARow = 0U;
+                pxTarget->ullSumUs += ulRoundTripUs;
+                pxStats->ulAvgUs = ( uint32_t ) ( pxTarget->ullSumUs / pxStats->ulReceived );
+                pxTarget->xReplied = pdTRUE;
+            }
+        }
+        taskEXIT_CRITICAL();
+
+        if( ( xWasDown != pdFALSE ) && ( xPingIsReachable( pxRequest->xTarget ) != pdFALSE ) )
+        {
+            FreeRTOS_printf( ( "ping: %s is reachable, %u us\n", pxTarget->pcName, ( unsigned ) ulRoundTripUs ) );
+        }
+    }
+}
+/*-----------------------------------------------------------*/
+
+static TickType_t prvTimeToNextEvent( TickType_t xNow )
+{
+    TickType_t xWait = pdMS_TO_TICKS( pingMAX_WAIT_MS );
+    TickType_t xUntil;
+    BaseType_t xIndex;
+
+    for( xIndex = 0; xIndex < xTargetCount; xIndex++ )
+    {
+        xUntil = xTargets[ xIndex ].xNextSend - xNow;
+
+        if( xUntil >= ( portMAX_DELAY / 2U ) )
+        {
+            /* Due already. */
+            xUntil = 0U;
+        }
+
+        xWait = ( xUntil < xWait ) ? xUntil : xWait;
+    }
+
+    for( xIndex = 0; xIndex < ( BaseType_t ) configPING_MAX_OUTSTANDING; xIndex++ )
+    {
+        if( xRequests[ xIndex ].xInUse != pdFALSE )
+        {
+            xUntil = ( xRequests[ xIndex ].xSent + pdMS_TO_TICKS( configPING_TIMEOUT_MS ) ) - xNow;
+            xUntil = ( xUntil >= ( portMAX_DELAY / 2U ) ) ? 0U : xUntil;
+            xWait = ( xUntil < xWait ) ? xUntil : xWait;
+        }
+    }
+
+    return xWait;
+}
+/*-----------------------------------------------------------*/
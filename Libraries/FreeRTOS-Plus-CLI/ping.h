@@ -0,0 +1,128 @@
+#ifndef PING_H
+#define PING_H
+
+/* FreeRTOS includes. */
+#include "FreeRTOS.h"
+
+/* FreeRTOS+TCP includes. */
+#include "FreeRTOS_IP.h"
+
+/*
+ * Periodic ICMP and ICMPv6 echo requests to a set of targets, for example the
+ * gateway and the servers that the application talks to.
+ *
+ * One task sends the requests of all targets, each at its own period, and
+ * keeps up to configPING_MAX_OUTSTANDING of them in flight at the same time.
+ * The stack reports replies through vApplicationPingReplyHook(), which must
+ * call vPingReplyReceived().  The round trip is measured from just before
+ * FreeRTOS_SendPingRequest() to the moment the IP-task handles the reply, in
+ * microseconds.
+ *
+ * Per target the module keeps the minimum, average and maximum round trip
+ * time, the jitter (RFC 3550: the smoothed difference between successive
+ * round trips) and the number of requests that were sent, answered and lost.
+ * A request is lost when no reply arrived within configPING_TIMEOUT_MS.
+ * xPingIsReachable() turns this into a health signal.
+ *
+ * The reply hook only gives the sequence number of a request, not its
+ * address.  IPv4 and IPv6 requests have their own sequence numbers, so a
+ * request waits for a tick when an outstanding request of the other type has
+ * the number that it would get.  A reply is matched to the oldest outstanding
+ * request with its number.
+ */
+
+#ifndef configPING_MAX_TARGETS
+    #define configPING_MAX_TARGETS          8U
+#endif
+
+/* Requests that wait for a reply, over all targets. */
+#ifndef configPING_MAX_OUTSTANDING
+    #define configPING_MAX_OUTSTANDING      16U
+#endif
+
+#ifndef configPING_TIMEOUT_MS
+    #define configPING_TIMEOUT_MS           1000U
+#endif
+
+/* Bytes of ICMP data in a request. */
+#ifndef configPING_PAYLOAD_SIZE
+    #define configPING_PAYLOAD_SIZE         16U
+#endif
+
+/* A target is unreachable after this many requests in a row were lost. */
+#ifndef configPING_UNREACHABLE_AFTER
+    #define configPING_UNREACHABLE_AFTER    3U
+#endif
+
+typedef struct xPING_STATS
+{
+    uint32_t ulSent;
+    uint32_t ulReceived;
+    uint32_t ulLost;           /* Timed out. */
+    uint32_t ulErrors;         /* Replies with a bad checksum or bad data. */
+    uint32_t ulNoRoute;        /* Not sent, no end-point leads to the target. */
+    uint32_t ulLostInARow;     /* Reset by every reply. */
+    uint32_t ulMinUs;
+    uint32_t ulAvgUs;
+    uint32_t ulMaxUs;
+    uint32_t ulJitterUs;
+    uint32_t ulLastUs;         /* The round trip of the last reply. */
+} PingStats_t;
+
+/**
+ * @brief Create the task that sends the requests.
+ *
+ * @param usStackSize Stack size of the task.
+ * @param uxPriority Priority of the task.
+ *
+ * @return pdPASS if success, pdFAIL otherwise.
+ */
+BaseType_t xPingInitialise( uint16_t usStackSize,
+                            UBaseType_t uxPriority );
+
+/**
+ * @brief Start pinging a target.
+ *
+ * @param pcName A name for the logs, not copied.
+ * @param pcAddress The IPv4 or IPv6 address of the target, as text.
+ * @param ulPeriodMS Time between two requests.
+ *
+ * @return The index of the target, or -1 when the address is not valid or
+ * the table of targets is full.
+ */
+BaseType_t xPingAddTarget( const char * pcName,
+                           const char * pcAddress,
+                           uint32_t ulPeriodMS );
+
+/**
+ * @brief Get a copy of the statistics of a target.
+ *
+ * @param xTarget The index returned by xPingAddTarget().
+ * @param pxStats Where the statistics are copied to.
+ * @param xReset pdTRUE to start counting afresh.
+ */
+void vPingGetStats( BaseType_t xTarget,
+                    PingStats_t * pxStats,
+                    BaseType_t xReset );
+
+/**
+ * @brief The health signal of a target.
+ *
+ * @return pdTRUE when a reply was received and fewer than
+ * configPING_UNREACHABLE_AFTER requests in a row were lost since.
+ */
+BaseType_t xPingIsReachable( BaseType_t xTarget );
+
+/**
+ * @brief Log the statistics of all targets.
+ */
+void vPingReport( void );
+
+/**
+ * @brief Hand a reply to the module.  To be called from
+ * vApplicationPingReplyHook(), with its parameters.
+ */
+void vPingReplyReceived( ePingReplyStatus_t eStatus,
+                         uint16_t usIdentifier );
+
+#endif /* #ifndef PING_H */
@@ -39,6 +39,14 @@
 #define PAD_RIGHT    1
 #define PAD_ZERO     2
 
+/* sprintf() and vsprintf() are not told the size of the buffer.  They stop
+ * after this many characters, which only limits the damage of a run-away
+ * format; use snprintf() or vsnprintf().  None of these functions allocate or
+ * use static data, so they may be called from tasks and interrupts at the
+ * same time, except that %s checks its pointer with
+ * xApplicationMemoryPermissions(). */
+#define SPRINTF_MAX_LENGTH    1024
+
 int sprintf( char * apBuf,
              const char * apFmt,
              ... );
@@ -863,7 +871,7 @@ int sprintf( char * apBuf,
 
     va_start( args, apFmt );
     struct SStringBuf strBuf;
-    strbuf_init( &strBuf, apBuf, ( const char * ) apBuf + 1024 );
+    strbuf_init( &strBuf, apBuf, ( const char * ) apBuf + SPRINTF_MAX_LENGTH );
     tiny_print( &strBuf, apFmt, args );
     va_end( args );
 
@@ -877,7 +885,7 @@ int vsprintf( char * apBuf,
 {
     struct SStringBuf strBuf;
 
-    strbuf_init( &strBuf, apBuf, ( const char * ) apBuf + 1024 );
+    strbuf_init( &strBuf, apBuf, ( const char * ) apBuf + SPRINTF_MAX_LENGTH );
     tiny_print( &strBuf, apFmt, args );
 
     return strBuf.curLen;
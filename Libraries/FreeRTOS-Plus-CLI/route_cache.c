@@ -0,0 +1,381 @@
+/* The log messages of this file, see log_levels.h. */
+#define logMODULE    eLogModuleNet
+
+/* Standard includes. */
+#include <string.h>
+
+/* FreeRTOS includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+
+/* FreeRTOS+TCP includes. */
+#include "FreeRTOS_IP.h"
+#include "FreeRTOS_Sockets.h"
+#include "FreeRTOS_Routing.h"
+
+#include "route_cache.h"
+
+#if ( ( configROUTE_CACHE_ENTRIES & ( configROUTE_CACHE_ENTRIES - 1 ) ) != 0 ) || ( configROUTE_CACHE_ENTRIES < 2 )
+    #error configROUTE_CACHE_ENTRIES must be a power of 2, at least 2
+#endif
+
+/* Each destination can be in one of two entries, so two destinations with
+ * the same hash do not evict each other on every lookup. */
+#define routecacheWAYS    2U
+#define routecacheSETS    ( configROUTE_CACHE_ENTRIES / routecacheWAYS )
+
+typedef struct xROUTE_CACHE_ENTRY
+{
+    uint32_t ulGeneration;      /* Valid when equal to ulCacheGeneration. */
+    uint8_t ucFamily;
+    IP_Address_t xDestination;
+    Route_t xRoute;
+} RouteCacheEntry_t;
+
+/*
+ * Hash a destination address to a set of routecacheWAYS entries.
+ */
+static size_t prvHash( const struct freertos_sockaddr * pxDestination );
+
+/*
+ * Find the route by walking the end-points (longest prefix match).
+ */
+static BaseType_t prvResolveIPv4( uint32_t ulDestination,
+                                  Route_t * pxRoute );
+#if ( ipconfigUSE_IPv6 != 0 )
+    static BaseType_t prvResolveIPv6( const IPv6_Address_t * pxDestination,
+                                      Route_t * pxRoute );
+#endif
+
+/*-----------------------------------------------------------*/
+
+static RouteCacheEntry_t xEntries[ routecacheSETS ][ routecacheWAYS ];
+
+/* Per set, the way that was not used last, replaced by the next miss. */
+static uint8_t ucVictims[ routecacheSETS ];
+
+/* Bumping the generation invalidates all entries at once.  It starts at 1
+ * because the entries start at 0. */
+static uint32_t ulCacheGeneration = 1U;
+
+static RouteCacheStats_t xCacheStats;
+
+/*-----------------------------------------------------------*/
+
+static size_t prvHash( const struct freertos_sockaddr * pxDestination )
+{
+    const uint8_t * pucBytes;
+    size_t uxLength;
+    size_t x;
+    uint32_t ulHash = 2166136261UL; /* FNV-1a */
+
+    if( pxDestination->sin_family == FREERTOS_AF_INET6 )
+    {
+        pucBytes = pxDestination->sin_address.xIP_IPv6.ucBytes;
+        uxLength = sizeof( IPv6_Address_t );
+    }
+    else
+    {
+        pucBytes = ( const uint8_t * ) &( pxDestination->sin_address.ulIP_IPv4 );
+        uxLength = sizeof( uint32_t );
+    }
+
+    for( x = 0; x < uxLength; x++ )
+    {
+        ulHash ^= pucBytes[ x ];
+        ulHash *= 16777619UL;
+    }
+
+    return ( size_t ) ( ulHash & ( routecacheSETS - 1U ) );
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvResolveIPv4( uint32_t ulDestination,
+                                  Route_t * pxRoute )
+{
+    NetworkEndPoint_t * pxEndPoint;
+    NetworkEndPoint_t * pxBest = NULL;
+    NetworkEndPoint_t * pxGateway = NULL;
+    BaseType_t xBestLength = -1;
+    BaseType_t xLength;
+    uint32_t ulMask;
+
+    for( pxEndPoint = FreeRTOS_FirstEndPoint( NULL ); pxEndPoint != NULL; pxEndPoint = FreeRTOS_NextEndPoint( NULL, pxEndPoint ) )
+    {
+        if( ( pxEndPoint->bits.bIPv6 != pdFALSE_UNSIGNED ) || ( pxEndPoint->bits.bEndPointUp == pdFALSE_UNSIGNED ) )
+        {
+            continue;
+        }
+
+        ulMask = pxEndPoint->ipv4_settings.ulNetMask;
+
+        if( ( ( ulDestination ^ pxEndPoint->ipv4_settings.ulIPAddress ) & ulMask ) == 0U )
+        {
+            /* The mask is contiguous, so its bit count is the prefix length,
+             * whatever the byte order. */
+            for( xLength = 0; ulMask != 0U; ulMask &= ulMask - 1U )
+            {
+                xLength++;
+            }
+
+            if( xLength > xBestLength )
+            {
+                xBestLength = xLength;
+                pxBest = pxEndPoint;
+            }
+        }
+
+        if( ( pxGateway == NULL ) && ( pxEndPoint->ipv4_settings.ulGatewayAddress != 0U ) )
+        {
+            pxGateway = pxEndPoint;
+        }
+    }
+
+    if( pxBest != NULL )
+    {
+        pxRoute->pxEndPoint = pxBest;
+        pxRoute->xNextHop.ulIP_IPv4 = ulDestination;
+        pxRoute->xOnLink = pdTRUE;
+    }
+    else if( pxGateway != NULL )
+    {
+        pxRoute->pxEndPoint = pxGateway;
+        pxRoute->xNextHop.ulIP_IPv4 = pxGateway->ipv4_settings.ulGatewayAddress;
+        pxRoute->xOnLink = pdFALSE;
+    }
+    else
+    {
+        pxRoute->pxEndPoint = NULL;
+    }
+
+    return ( pxRoute->pxEndPoint != NULL ) ? pdPASS : pdFAIL;
+}
+/*-----------------------------------------------------------*/
+
+#if ( ipconfigUSE_IPv6 != 0 )
+
+    static BaseType_t prvPrefixMatches( const IPv6_Address_t * pxLeft,
+                                        const IPv6_Address_t * pxRight,
+                                        size_t uxPrefixLength )
+    {
+        size_t uxBytes = uxPrefixLength / 8U;
+        size_t uxBits = uxPrefixLength % 8U;
+        uint8_t ucMask;
+        BaseType_t xReturn = pdFALSE;
+
+        if( ( uxPrefixLength <= 128U ) && ( memcmp( pxLeft->ucBytes, pxRight->ucBytes, uxBytes ) == 0 ) )
+        {
+            xReturn = pdTRUE;
+
+            if( uxBits != 0U )
+            {
+                ucMask = ( uint8_t ) ( 0xFFU << ( 8U - uxBits ) );
+
+                if( ( ( pxLeft->ucBytes[ uxBytes ] ^ pxRight->ucBytes[ uxBytes ] ) & ucMask ) != 0U )
+                {
+                    xReturn = pdFALSE;
+                }
+            }
+        }
+
+        return xReturn;
+    }
+    /*-----------------------------------------------------------*/
+
+    static BaseType_t prvResolveIPv6( const IPv6_Address_t * pxDestination,
+                                      Route_t * pxRoute )
+    {
+        static const IPv6_Address_t xZero = { { 0 } };
+        NetworkEndPoint_t * pxEndPoint;
+        NetworkEndPoint_t * pxBest = NULL;
+        NetworkEndPoint_t * pxGateway = NULL;
+        size_t uxBestLength = 0U;
+
+        for( pxEndPoint = FreeRTOS_FirstEndPoint( NULL ); pxEndPoint != NULL; pxEndPoint = FreeRTOS_NextEndPoint( NULL, pxEndPoint ) )
+        {
+            if( ( pxEndPoint->bits.bIPv6 == pdFALSE_UNSIGNED ) || ( pxEndPoint->bits.bEndPointUp == pdFALSE_UNSIGNED ) )
+            {
+                continue;
+            }
+
+            if( ( prvPrefixMatches( pxDestination, &( pxEndPoint->ipv6_settings.xIPAddress ), pxEndPoint->ipv6_settings.uxPrefixLength ) != pdFALSE ) &&
+                ( ( pxBest == NULL ) || ( pxEndPoint->ipv6_settings.uxPrefixLength > uxBestLength ) ) )
+            {
+                uxBestLength = pxEndPoint->ipv6_settings.uxPrefixLength;
+                pxBest = pxEndPoint;
+            }
+
+            if( ( pxGateway == NULL ) && ( memcmp( pxEndPoint->ipv6_settings.xGatewayAddress.ucBytes, xZero.ucBytes, sizeof( xZero ) ) != 0 ) )
+            {
+                pxGateway = pxEndPoint;
+            }
+        }
+
+        if( pxBest != NULL )
+        {
+            pxRoute->pxEndPoint = pxBest;
+            memcpy( pxRoute->xNextHop.xIP_IPv6.ucBytes, pxDestination->ucBytes, sizeof( IPv6_Address_t ) );
+            pxRoute->xOnLink = pdTRUE;
+        }
+        else if( pxGateway != NULL )
+        {
+            pxRoute->pxEndPoint = pxGateway;
+            memcpy( pxRoute->xNextHop.xIP_IPv6.ucBytes, pxGateway->ipv6_settings.xGatewayAddress.ucBytes, sizeof( IPv6_Address_t ) );
+            pxRoute->xOnLink = pdFALSE;
+        }
+        else
+        {
+            pxRoute->pxEndPoint = NULL;
+        }
+
+        return ( pxRoute->pxEndPoint != NULL ) ? pdPASS : pdFAIL;
+    }
+
+#endif /* ( ipconfigUSE_IPv6 != 0 ) */
+/*-----------------------------------------------------------*/
+
+BaseType_t xRouteCacheLookup( const struct freertos_sockaddr * pxDestination,
+                              Route_t * pxRoute )
+{
+    size_t uxSet = prvHash( pxDestination );
+    RouteCacheEntry_t * pxEntry = NULL;
+    BaseType_t xReturn = pdFAIL;
+    BaseType_t xHit = pdFALSE;
+    uint32_t ulGeneration;
+    size_t uxWay;
+
+    taskENTER_CRITICAL();
+    {
+        ulGeneration = ulCacheGeneration;
+
+        for( uxWay = 0U; ( uxWay < routecacheWAYS ) && ( xHit == pdFALSE ); uxWay++ )
+        {
+            pxEntry = &( xEntries[ uxSet ][ uxWay ] );
+
+            if( ( pxEntry->ulGeneration == ulGeneration ) && ( pxEntry->ucFamily == pxDestination->sin_family ) )
+            {
+                if( pxDestination->sin_family == FREERTOS_AF_INET6 )
+                {
+                    xHit = ( memcmp( pxEntry->xDestination.xIP_IPv6.ucBytes, pxDestination->sin_address.xIP_IPv6.ucBytes, sizeof( IPv6_Address_t ) ) == 0 ) ? pdTRUE : pdFALSE;
+                }
+                else
+                {
+                    xHit = ( pxEntry->xDestination.ulIP_IPv4 == pxDestination->sin_address.ulIP_IPv4 ) ? pdTRUE : pdFALSE;
+                }
+            }
+
+            if( xHit != pdFALSE )
+            {
+                memcpy( pxRoute, &( pxEntry->xRoute ), sizeof( *pxRoute ) );
+                ucVictims[ uxSet ] = ( uint8_t ) ( ( uxWay + 1U ) % routecacheWAYS );
+                xCacheStats.ulHits++;
+                xReturn = pdPASS;
+            }
+        }
+    }
+    taskEXIT_CRITICAL();
+
+    if( xHit == pdFALSE )
+    {
+        /* Walk the end-points outside the critical section. */
+        if( pxDestination->sin_family == FREERTOS_AF_INET6 )
+        {
+            #if ( ipconfigUSE_IPv6 != 0 )
+                xReturn = prvResolveIPv6( &( pxDestination->sin_address.xIP_IPv6 ), pxRoute );
+            #endif
+        }
+        else
+        {
+            xReturn = prvResolveIPv4( pxDestination->sin_address.ulIP_IPv4, pxRoute );
+        }
+
+        taskENTER_CRITICAL();
+        {
+            xCacheStats.ulMisses++;
+
+            /* Only store the result when no invalidation happened during the
+             * walk, and also remember that there is no route. */
+            if( ulGeneration == ulCacheGeneration )
+            {
+                /* An entry of an older generation is free, otherwise the one
+                 * that was not used last is replaced. */
+                uxWay = ucVictims[ uxSet ];
+
+                if( xEntries[ uxSet ][ 0 ].ulGeneration != ulGeneration )
+                {
+                    uxWay = 0U;
+                }
+                else if( xEntries[ uxSet ][ 1 ].ulGeneration != ulGeneration )
+                {
+                    uxWay = 1U;
+                }
+
+                ucVictims[ uxSet ] = ( uint8_t ) ( ( uxWay + 1U ) % routecacheWAYS );
+                pxEntry = &( xEntries[ uxSet ][ uxWay ] );
+                pxEntry->ulGeneration = ulGeneration;
+                pxEntry->ucFamily = pxDestination->sin_family;
+                memcpy( &( pxEntry->xDestination ), &( pxDestination->sin_address ), sizeof( pxEntry->xDestination ) );
+
+                if( xReturn != pdPASS )
+                {
+                    pxRoute->pxEndPoint = NULL;
+                }
+
+                memcpy( &( pxEntry->xRoute ), pxRoute, sizeof( pxEntry->xRoute ) );
+            }
+        }
+        taskEXIT_CRITICAL();
+    }
+    else if( pxRoute->pxEndPoint == NULL )
+    {
+        /* A cached "no route". */
+        xReturn = pdFAIL;
+    }
+
+    return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+void vRouteCacheInvalidate( void )
+{
+    taskENTER_CRITICAL();
+    {
+        ulCacheGeneration++;
+
+        if( ulCacheGeneration == 0U )
+        {
+            /* Zero is the generation of unused entries. */
+            ulCacheGeneration = 1U;
+            memset( xEntries, 0, sizeof( xEntries ) );
+        }
+
+        xCacheStats.ulInvalidations++;
+    }
+    taskEXIT_CRITICAL();
+}
+/*-----------------------------------------------------------*/
+
+void vRouteCacheGetStats( RouteCacheStats_t * pxStats )
+{
+    taskENTER_CRITICAL();
+    {
+        memcpy( pxStats, &xCacheStats, sizeof( *pxStats ) );
+    }
+    taskEXIT_CRITICAL();
+}
+/*-----------------------------------------------------------*/
+
+void vRouteCacheReport( void )
+{
+    RouteCacheStats_t xStats;
+    uint32_t ulLookups;
+
+    vRouteCacheGetStats( &xStats );
+    ulLookups = xStats.ulHits + xStats.ulMisses;
+
+    FreeRTOS_printf( ( "Route cache: %u lookups, %u%% hits, %u invalidations\n",
+                       ( unsigned ) ulLookups,
+                       ( unsigned ) ( ( ulLookups != 0U ) ? ( uint32_t ) ( ( ( uint64_t ) xStats.ulHits * 100U ) / ulLookups ) : 0U ),
+                       ( unsigned ) xStats.ulInvalidations ) );
+}
+/*-----------------------------------------------------------*/
@@ -0,0 +1,74 @@
+#ifndef ROUTE_CACHE_H
+#define ROUTE_CACHE_H
+
+/* FreeRTOS+TCP includes. */
+#include "FreeRTOS_IP.h"
+#include "FreeRTOS_Sockets.h"
+#include "FreeRTOS_Routing.h"
+
+/*
+ * Destination indexed cache of the end-point and next-hop to use for a
+ * remote address.
+ *
+ * A miss walks all end-points once and picks the one with the longest
+ * matching prefix, falling back to an end-point that has a gateway.  The
+ * result is stored in a 2-way set associative hash table, so later lookups of
+ * the same destination cost one hash and at most two compares, however many
+ * end-points there are.
+ *
+ * The stack selects the end-point of its own packets.  The application uses
+ * the cache before it sends: ping.c and log_udp.c do not send to destinations
+ * that no end-point leads to.
+ *
+ * The cache must be flushed with vRouteCacheInvalidate() whenever addresses
+ * change: when an end-point goes up or down, or when a Router Advertisement
+ * brought a new prefix or gateway.  The network event hook in app_main.c does
+ * this.
+ */
+
+/* Number of destinations in the cache, must be a power of 2. */
+#ifndef configROUTE_CACHE_ENTRIES
+    #define configROUTE_CACHE_ENTRIES    16
+#endif
+
+typedef struct xROUTE
+{
+    NetworkEndPoint_t * pxEndPoint; /* NULL when there is no route. */
+    IP_Address_t xNextHop;          /* The gateway, or the destination itself when on-link. */
+    BaseType_t xOnLink;
+} Route_t;
+
+typedef struct xROUTE_CACHE_STATS
+{
+    uint32_t ulHits;
+    uint32_t ulMisses;
+    uint32_t ulInvalidations;
+} RouteCacheStats_t;
+
+/**
+ * @brief Find the route to a destination.
+ *
+ * @param pxDestination The destination, FREERTOS_AF_INET4 or FREERTOS_AF_INET6.
+ * @param pxRoute Filled in with the end-point and next-hop.
+ *
+ * @return pdPASS when a route was found, pdFAIL otherwise.
+ */
+BaseType_t xRouteCacheLookup( const struct freertos_sockaddr * pxDestination,
+                              Route_t * pxRoute );
+
+/**
+ * @brief Forget all cached routes.  Safe to call from the IP-task.
+ */
+void vRouteCacheInvalidate( void );
+
+/**
+ * @brief Get the hit and miss counters.
+ */
+void vRouteCacheGetStats( RouteCacheStats_t * pxStats );
+
+/**
+ * @brief Log the hit rate and the number of invalidations.
+ */
+void vRouteCacheReport( void );
+
+#endif /* #ifndef ROUTE_CACHE_H */
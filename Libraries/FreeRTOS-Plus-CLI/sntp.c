@@ -0,0 +1,353 @@
+/* The log messages of this file, see log_levels.h. */
+#define logMODULE    eLogModuleNet
+
+/* Standard includes. */
+#include <string.h>
+
+/* FreeRTOS includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+
+/* FreeRTOS+TCP includes. */
+#include "FreeRTOS_IP.h"
+#include "FreeRTOS_Sockets.h"
+#include "FreeRTOS_DNS.h"
+
+#include "sntp.h"
+#include "wall_clock.h"
+#include "uptime.h"
+
+#define sntpPORT                   123U
+#define sntpPACKET_SIZE            48U
+
+/* LI 0, version 4, mode 3 (client). */
+#define sntpCLIENT_REQUEST         0x23U
+
+#define sntpMODE_MASK              0x07U
+#define sntpMODE_SERVER            4U
+#define sntpLI_UNSYNCHRONISED      0xC0U
+
+/* Offsets of the fields in a packet. */
+#define sntpSTRATUM_OFFSET         1U
+#define sntpREFERENCE_ID_OFFSET    12U
+#define sntpORIGINATE_OFFSET       24U
+#define sntpRECEIVE_OFFSET         32U
+#define sntpTRANSMIT_OFFSET        40U
+
+/* Seconds from 1900, the NTP epoch, to 1970. */
+#define sntpUNIX_EPOCH             2208988800ULL
+
+typedef enum
+{
+    eSNTPGood,
+    eSNTPFailed,
+    eSNTPKissOfDeath
+} eSNTPResult_t;
+
+/*
+ * The task that polls the server.
+ */
+static void prvSNTPTask( void * pvParameters );
+
+/*
+ * One request and its reply.
+ */
+static eSNTPResult_t prvPoll( int64_t * pllOffsetUs,
+                              uint32_t * pulDelayUs,
+                              uint8_t * pucStratum );
+
+/*
+ * Check a reply, and compute the offset and round trip from it.
+ */
+static eSNTPResult_t prvParseReply( const uint8_t * pucReply,
+                                    uint64_t ullSentUs,
+                                    uint64_t ullReceivedUs,
+                                    int64_t * pllOffsetUs,
+                                    uint32_t * pulDelayUs );
+
+/*
+ * Conversion between Unix microseconds and 64-bit NTP timestamps in network
+ * byte order.
+ */
+static void prvWriteTimestamp( uint8_t * pucTimestamp,
+                               uint64_t ullUnixUs );
+static uint64_t prvReadTimestamp( const uint8_t * pucTimestamp );
+
+/*-----------------------------------------------------------*/
+
+static SNTPStatus_t xStatus;
+
+static TaskHandle_t xSNTPTaskHandle = NULL;
+
+/*-----------------------------------------------------------*/
+
+BaseType_t xSNTPStart( uint16_t usStackSize,
+                       UBaseType_t uxPriority )
+{
+    BaseType_t xReturn = pdPASS;
+
+    if( xSNTPTaskHandle == NULL )
+    {
+        xReturn = xTaskCreate( prvSNTPTask, "SNTP", usStackSize, NULL, uxPriority, &xSNTPTaskHandle );
+    }
+
+    return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+void vSNTPGetStatus( SNTPStatus_t * pxStatus )
+{
+    taskENTER_CRITICAL();
+    {
+        memcpy( pxStatus, &xStatus, sizeof( *pxStatus ) );
+    }
+    taskEXIT_CRITICAL();
+}
+/*-----------------------------------------------------------*/
+
+static void prvSNTPTask( void * pvParameters )
+{
+    uint32_t ulPollSeconds = configSNTP_MIN_POLL_S;
+    uint32_t ulRetrySeconds = configSNTP_RETRY_S;
+    uint32_t ulWaitSeconds;
+    int64_t llOffsetUs;
+    uint32_t ulDelayUs;
+    uint8_t ucStratum;
+    eSNTPResult_t eResult;
+
+    /* Disable unused parameter warning. */
+    ( void ) pvParameters;
+
+    for( ; ; )
+    {
+        eResult = prvPoll( &llOffsetUs, &ulDelayUs, &ucStratum );
+
+        if( eResult == eSNTPGood )
+        {
+            vWallClockCorrect( llOffsetUs, pdTRUE );
+
+            /* Poll often again when the clock was off by much. */
+            if( ( llOffsetUs > ( ( int64_t ) configWALL_CLOCK_STEP_MS * 1000 ) ) ||
+                ( llOffsetUs < -( ( int64_t ) configWALL_CLOCK_STEP_MS * 1000 ) ) )
+            {
+                ulPollSeconds = configSNTP_MIN_POLL_S;
+            }
+
+            ulWaitSeconds = ulPollSeconds;
+            ulPollSeconds = ( ( 2U * ulPollSeconds ) < configSNTP_MAX_POLL_S ) ? ( 2U * ulPollSeconds ) : configSNTP_MAX_POLL_S;
+            ulRetrySeconds = configSNTP_RETRY_S;
+        }
+        else if( eResult == eSNTPKissOfDeath )
+        {
+            ulWaitSeconds = configSNTP_MAX_POLL_S;
+        }
+        else
+        {
+            ulWaitSeconds = ulRetrySeconds;
+            ulRetrySeconds = ( ( 2U * ulRetrySeconds ) < configSNTP_MAX_POLL_S ) ? ( 2U * ulRetrySeconds ) : configSNTP_MAX_POLL_S;
+        }
+
+        taskENTER_CRITICAL();
+        {
+            if( eResult == eSNTPGood )
+            {
+                xStatus.ulPolls++;
+                xStatus.llLastOffsetUs = llOffsetUs;
+                xStatus.ulLastDelayUs = ulDelayUs;
+                xStatus.ucStratum = ucStratum;
+            }
+            else
+            {
+                xStatus.ulFailures++;
+            }
+
+            xStatus.ulPollSeconds = ulWaitSeconds;
+        }
+        taskEXIT_CRITICAL();
+
+        vTaskDelay( pdMS_TO_TICKS( ulWaitSeconds * 1000U ) );
+    }
+}
+/*-----------------------------------------------------------*/
+
+static eSNTPResult_t prvPoll( int64_t * pllOffsetUs,
+                              uint32_t * pulDelayUs,
+                              uint8_t * pucStratum )
+{
+    eSNTPResult_t eResult = eSNTPFailed;
+    uint8_t ucRequest[ sntpPACKET_SIZE ];
+    uint8_t ucReply[ sntpPACKET_SIZE ];
+    struct freertos_sockaddr xServer;
+    struct freertos_sockaddr xFrom;
+    uint32_t ulFromLength;
+    uint32_t ulServerIP;
+    uint64_t ullSentUptime;
+    uint64_t ullSentWall;
+    uint64_t ullReceivedUptime;
+    TickType_t xTimeout = pdMS_TO_TICKS( configSNTP_TIMEOUT_MS );
+    TickType_t xStart;
+    Socket_t xSocket;
+    int32_t lResult;
+
+    ulServerIP = FreeRTOS_gethostbyname( configSNTP_SERVER );
+
+    if( ulServerIP == 0U )
+    {
+        LogWarn( ( "SNTP: cannot resolve %s\n", configSNTP_SERVER ) );
+    }
+    else
+    {
+        xSocket = FreeRTOS_socket( FREERTOS_AF_INET, FREERTOS_SOCK_DGRAM, FREERTOS_IPPROTO_UDP );
+
+        if( xSocket != FREERTOS_INVALID_SOCKET )
+        {
+            ( void ) FreeRTOS_setsockopt( xSocket, 0, FREERTOS_SO_RCVTIMEO, &xTimeout, sizeof( xTimeout ) );
+            ( void ) FreeRTOS_bind( xSocket, NULL, 0U );
+
+            memset( &xServer, 0, sizeof( xServer ) );
+            xServer.sin_family = FREERTOS_AF_INET;
+            xServer.sin_port = FreeRTOS_htons( sntpPORT );
+            xServer.sin_address.ulIP_IPv4 = ulServerIP;
+
+            /* The server copies the transmit timestamp into the originate
+             * timestamp of its reply, which ties the two together. */
+            memset( ucRequest, 0, sizeof( ucRequest ) );
+            ucRequest[ 0 ] = sntpCLIENT_REQUEST;
+            ullSentUptime = ullUptimeMicroseconds();
+            ullSentWall = ullWallClockMicroseconds();
+            prvWriteTimestamp( &( ucRequest[ sntpTRANSMIT_OFFSET ] ), ullSentWall );
+
+            if( FreeRTOS_sendto( xSocket, ucRequest, sizeof( ucRequest ), 0, &xServer, sizeof( xServer ) ) > 0 )
+            {
+                xStart = xTaskGetTickCount();
+
+                /* Skip whatever else arrives, until the time-out. */
+                while( ( eResult == eSNTPFailed ) && ( ( xTaskGetTickCount() - xStart ) < xTimeout ) )
+                {
+                    ulFromLength = sizeof( xFrom );
+                    lResult = FreeRTOS_recvfrom( xSocket, ucReply, sizeof( ucReply ), 0, &xFrom, &ulFromLength );
+                    ullReceivedUptime = ullUptimeMicroseconds();
+
+                    if( lResult <= 0 )
+                    {
+                        break;
+                    }
+
+                    if( ( lResult >= ( int32_t ) sntpPACKET_SIZE ) &&
+                        ( xFrom.sin_address.ulIP_IPv4 == ulServerIP ) &&
+                        ( xFrom.sin_port == FreeRTOS_htons( sntpPORT ) ) &&
+                        ( memcmp( &( ucReply[ sntpORIGINATE_OFFSET ] ), &( ucRequest[ sntpTRANSMIT_OFFSET ] ), 8U ) == 0 ) )
+                    {
+                        /* The wall clock at the moment of the reply, as it
+                         * was read when the request left. */
+                        eResult = prvParseReply( ucReply,
+                                                 ullSentWall,
+                                                 ullSentWall + ( ullReceivedUptime - ullSentUptime ),
+                                                 pllOffsetUs,
+                                                 pulDelayUs );
+                        *pucStratum = ucReply[ sntpSTRATUM_OFFSET ];
+
+                        if( eResult == eSNTPFailed )
+                        {
+                            /* Do not wait for another reply. */
+                            break;
+                        }
+                    }
+                }
+            }
+
+            ( void ) FreeRTOS_closesocket( xSocket );
+        }
+    }
+
+    return eResult;
+}
+/*-----------------------------------------------------------*/
+
+static eSNTPResult_t prvParseReply( const uint8_t * pucReply,
+                                    uint64_t ullSentUs,
+                                    uint64_t ullReceivedUs,
+                                    int64_t * pllOffsetUs,
+                                    uint32_t * pulDelayUs )
+{
+    eSNTPResult_t eResult = eSNTPFailed;
+    uint8_t ucStratum = pucReply[ sntpSTRATUM_OFFSET ];
+    int64_t llServerReceivedUs;
+    int64_t llServerSentUs;
+    int64_t llDelayUs;
+
+    if( ( pucReply[ 0 ] & sntpMODE_MASK ) != sntpMODE_SERVER )
+    {
+        LogWarn( ( "SNTP: not a server reply\n" ) );
+    }
+    else if( ucStratum == 0U )
+    {
+        /* The reference ID holds four ASCII characters, like "RATE". */
+        LogWarn( ( "SNTP: kiss-o'-death %c%c%c%c\n",
+                   pucReply[ sntpREFERENCE_ID_OFFSET ],
+                   pucReply[ sntpREFERENCE_ID_OFFSET + 1U ],
+                   pucReply[ sntpREFERENCE_ID_OFFSET + 2U ],
+                   pucReply[ sntpREFERENCE_ID_OFFSET + 3U ] ) );
+        eResult = eSNTPKissOfDeath;
+    }
+    else if( ( ucStratum > 15U ) || ( ( pucReply[ 0 ] & sntpLI_UNSYNCHRONISED ) == sntpLI_UNSYNCHRONISED ) )
+    {
+        LogWarn( ( "SNTP: server is not synchronised\n" ) );
+    }
+    else
+    {
+        llServerReceivedUs = ( int64_t ) prvReadTimestamp( &( pucReply[ sntpRECEIVE_OFFSET ] ) );
+        llServerSentUs = ( int64_t ) prvReadTimestamp( &( pucReply[ sntpTRANSMIT_OFFSET ] ) );
+
+        /* RFC 4330:  offset = ( ( T2 - T1 ) + ( T3 - T4 ) ) / 2
+         *            delay  = ( T4 - T1 ) - ( T3 - T2 ) */
+        llDelayUs = ( ( int64_t ) ( ullReceivedUs - ullSentUs ) ) - ( llServerSentUs - llServerReceivedUs );
+        llDelayUs = ( llDelayUs < 0 ) ? 0 : llDelayUs;
+
+        if( llDelayUs > ( ( int64_t ) configSNTP_MAX_DELAY_MS * 1000 ) )
+        {
+            LogWarn( ( "SNTP: round trip of %u ms is too long\n", ( unsigned ) ( llDelayUs / 1000 ) ) );
+        }
+        else
+        {
+            *pllOffsetUs = ( ( llServerReceivedUs - ( int64_t ) ullSentUs ) + ( llServerSentUs - ( int64_t ) ullReceivedUs ) ) / 2;
+            *pulDelayUs = ( uint32_t ) llDelayUs;
+            eResult = eSNTPGood;
+        }
+    }
+
+    return eResult;
+}
+/*-----------------------------------------------------------*/
+
+static void prvWriteTimestamp( uint8_t * pucTimestamp,
+                               uint64_t ullUnixUs )
+{
+    uint32_t ulSeconds = ( uint32_t ) ( ( ullUnixUs / 1000000U ) + sntpUNIX_EPOCH );
+    uint32_t ulFraction = ( uint32_t ) ( ( ( ullUnixUs % 1000000U ) << 32 ) / 1000000U );
+
+    ulSeconds = FreeRTOS_htonl( ulSeconds );
+    ulFraction = FreeRTOS_htonl( ulFraction );
+    memcpy( &( pucTimestamp[ 0 ] ), &ulSeconds, sizeof( ulSeconds ) );
+    memcpy( &( pucTimestamp[ 4 ] ), &ulFraction, sizeof( ulFraction ) );
+}
+/*-----------------------------------------------------------*/
+
+static uint64_t prvReadTimestamp( const uint8_t * pucTimestamp )
+{
+    uint32_t ulSeconds;
+    uint32_t ulFraction;
+    uint64_t ullSeconds;
+
+    memcpy( &ulSeconds, &( pucTimestamp[ 0 ] ), sizeof( ulSeconds ) );
+    memcpy( &ulFraction, &( pucTimestamp[ 4 ] ), sizeof( ulFraction ) );
+    ulSeconds = FreeRTOS_ntohl( ulSeconds );
+    ulFraction = FreeRTOS_ntohl( ulFraction );
+
+    /* Seconds below the Unix epoch are from NTP era 1, which starts in
+     * 2036. */
+    ullSeconds = ( ( uint64_t ) ulSeconds < sntpUNIX_EPOCH ) ? ( ( uint64_t ) ulSeconds + ( 1ULL << 32 ) ) : ( uint64_t ) ulSeconds;
+
+    return ( ( ullSeconds - sntpUNIX_EPOCH ) * 1000000U ) + ( ( ( uint64_t ) ulFraction * 1000000U ) >> 32 );
+}
+/*-----------------------------------------------------------*/
@@ -0,0 +1,74 @@
+#ifndef SNTP_H
+#define SNTP_H
+
+/* FreeRTOS includes. */
+#include "FreeRTOS.h"
+
+/*
+ * An SNTP client (RFC 4330) that keeps the wall clock (wall_clock.h) on time.
+ *
+ * Every poll sends one request to configSNTP_SERVER, and the offset that the
+ * reply shows is handed to the wall clock, which steps or slews.  Replies
+ * that do not answer the request, come from an unsynchronised server, or took
+ * longer than configSNTP_MAX_DELAY_MS for the round trip are ignored.
+ *
+ * The poll interval starts at configSNTP_MIN_POLL_S and doubles after every
+ * good poll, up to configSNTP_MAX_POLL_S.  It falls back to the minimum after
+ * a step.  A failed poll is retried after configSNTP_RETRY_S, and the retry
+ * interval doubles with every failure in a row, up to configSNTP_MAX_POLL_S.
+ * A Kiss-o'-Death reply makes the client wait configSNTP_MAX_POLL_S.
+ */
+
+#ifndef configSNTP_SERVER
+    #define configSNTP_SERVER           "pool.ntp.org"
+#endif
+
+#ifndef configSNTP_MIN_POLL_S
+    #define configSNTP_MIN_POLL_S       16U
+#endif
+
+#ifndef configSNTP_MAX_POLL_S
+    #define configSNTP_MAX_POLL_S       1024U
+#endif
+
+#ifndef configSNTP_RETRY_S
+    #define configSNTP_RETRY_S          2U
+#endif
+
+/* Time to wait for a reply. */
+#ifndef configSNTP_TIMEOUT_MS
+    #define configSNTP_TIMEOUT_MS       2000U
+#endif
+
+#ifndef configSNTP_MAX_DELAY_MS
+    #define configSNTP_MAX_DELAY_MS     500U
+#endif
+
+typedef struct xSNTP_STATUS
+{
+    uint32_t ulPolls;          /* Good polls. */
+    uint32_t ulFailures;       /* Failed polls. */
+    int64_t llLastOffsetUs;    /* Of the last good poll. */
+    uint32_t ulLastDelayUs;    /* Round trip of the last good poll. */
+    uint32_t ulPollSeconds;    /* Time until the next poll. */
+    uint8_t ucStratum;         /* Of the server. */
+} SNTPStatus_t;
+
+/**
+ * @brief Create the SNTP task.  May be called more than once, the task is only
+ * created the first time.
+ *
+ * @param usStackSize Stack size of the task.
+ * @param uxPriority Priority of the task.
+ *
+ * @return pdPASS if the task runs.
+ */
+BaseType_t xSNTPStart( uint16_t usStackSize,
+                       UBaseType_t uxPriority );
+
+/**
+ * @brief Get a copy of the status of the client.
+ */
+void vSNTPGetStatus( SNTPStatus_t * pxStatus );
+
+#endif /* #ifndef SNTP_H */
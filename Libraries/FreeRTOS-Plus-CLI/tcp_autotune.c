@@ -0,0 +1,360 @@
+/* The log messages of this file, see log_levels.h. */
+#define logMODULE    eLogModuleNet
+
+/* Standard includes. */
+#include <string.h>
+
+/* FreeRTOS includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+
+/* FreeRTOS+TCP includes. */
+#include "FreeRTOS_IP.h"
+#include "FreeRTOS_Sockets.h"
+
+#include "tcp_autotune.h"
+
+/* A destination of which nothing is known yet gets the stack's defaults. */
+#define autotuneINITIAL_BUFFER    ( ipconfigTCP_RX_BUFFER_LENGTH )
+
+/* What is remembered about a destination. */
+typedef struct xAUTOTUNE_CACHE_ENTRY
+{
+    uint8_t ucFamily;            /* 0 when the entry is free. */
+    IP_Address_t xAddress;
+    uint32_t ulBDP;              /* Bandwidth-delay product in bytes. */
+    TickType_t xLastUsed;
+} AutotuneCacheEntry_t;
+
+/*
+ * Find the cache entry of a destination, or NULL when it is not known.
+ */
+static AutotuneCacheEntry_t * prvCacheLookup( const struct freertos_sockaddr * pxRemote );
+
+/*
+ * Find the cache entry of a destination, recycling the least recently used
+ * entry when it is not known.
+ */
+static AutotuneCacheEntry_t * prvCacheInsert( const struct freertos_sockaddr * pxRemote );
+
+/*
+ * Round a buffer size to a multiple of the MSS within the configured limits.
+ */
+static size_t prvClampBuffer( size_t uxSize );
+
+/*
+ * Bytes per second transferred since the connection was made.
+ */
+static uint32_t prvRate( const TCPAutotune_t * pxTune );
+
+/*-----------------------------------------------------------*/
+
+static AutotuneCacheEntry_t xCache[ configTCP_AUTOTUNE_CACHE_ENTRIES ];
+
+/* Buffer space currently taken by autotuned sockets, and its history. */
+static TCPAutotuneBudget_t xBudget;
+
+/* All sockets that hold a reservation, for reporting. */
+static TCPAutotune_t * pxActiveList = NULL;
+
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvSameAddress( const AutotuneCacheEntry_t * pxEntry,
+                                  const struct freertos_sockaddr * pxRemote )
+{
+    BaseType_t xReturn = pdFALSE;
+
+    if( pxEntry->ucFamily == pxRemote->sin_family )
+    {
+        if( pxRemote->sin_family == FREERTOS_AF_INET6 )
+        {
+            xReturn = ( memcmp( pxEntry->xAddress.xIP_IPv6.ucBytes, pxRemote->sin_address.xIP_IPv6.ucBytes, sizeof( IPv6_Address_t ) ) == 0 ) ? pdTRUE : pdFALSE;
+        }
+        else
+        {
+            xReturn = ( pxEntry->xAddress.ulIP_IPv4 == pxRemote->sin_address.ulIP_IPv4 ) ? pdTRUE : pdFALSE;
+        }
+    }
+
+    return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+static AutotuneCacheEntry_t * prvCacheLookup( const struct freertos_sockaddr * pxRemote )
+{
+    AutotuneCacheEntry_t * pxReturn = NULL;
+    BaseType_t x;
+
+    for( x = 0; x < configTCP_AUTOTUNE_CACHE_ENTRIES; x++ )
+    {
+        if( prvSameAddress( &( xCache[ x ] ), pxRemote ) != pdFALSE )
+        {
+            pxReturn = &( xCache[ x ] );
+            break;
+        }
+    }
+
+    return pxReturn;
+}
+/*-----------------------------------------------------------*/
+
+static AutotuneCacheEntry_t * prvCacheInsert( const struct freertos_sockaddr * pxRemote )
+{
+    AutotuneCacheEntry_t * pxEntry = prvCacheLookup( pxRemote );
+    TickType_t xNow = xTaskGetTickCount();
+    BaseType_t x;
+
+    if( pxEntry == NULL )
+    {
+        /* Take a free entry, or else the one that was not used the longest. */
+        pxEntry = &( xCache[ 0 ] );
+
+        for( x = 0; x < configTCP_AUTOTUNE_CACHE_ENTRIES; x++ )
+        {
+            if( xCache[ x ].ucFamily == 0U )
+            {
+                pxEntry = &( xCache[ x ] );
+                break;
+            }
+
+            if( ( xNow - xCache[ x ].xLastUsed ) > ( xNow - pxEntry->xLastUsed ) )
+            {
+                pxEntry = &( xCache[ x ] );
+            }
+        }
+
+        pxEntry->ucFamily = pxRemote->sin_family;
+        memcpy( &( pxEntry->xAddress ), &( pxRemote->sin_address ), sizeof( pxEntry->xAddress ) );
+        pxEntry->ulBDP = 0U;
+    }
+
+    pxEntry->xLastUsed = xNow;
+
+    return pxEntry;
+}
+/*-----------------------------------------------------------*/
+
+static size_t prvClampBuffer( size_t uxSize )
+{
+    /* Round up to whole segments. */
+    uxSize = ( ( uxSize + ipconfigTCP_MSS - 1U ) / ipconfigTCP_MSS ) * ipconfigTCP_MSS;
+
+    if( uxSize < configTCP_AUTOTUNE_MIN_BUFFER )
+    {
+        uxSize = configTCP_AUTOTUNE_MIN_BUFFER;
+    }
+    else if( uxSize > configTCP_AUTOTUNE_MAX_BUFFER )
+    {
+        uxSize = configTCP_AUTOTUNE_MAX_BUFFER;
+    }
+
+    return uxSize;
+}
+/*-----------------------------------------------------------*/
+
+static uint32_t prvRate( const TCPAutotune_t * pxTune )
+{
+    uint32_t ulRate = 0U;
+    uint32_t ulElapsedMs;
+
+    if( pxTune->ulBytes > 0U )
+    {
+        ulElapsedMs = ( uint32_t ) pdTICKS_TO_MS( xTaskGetTickCount() - pxTune->xTransferStart );
+
+        if( ulElapsedMs == 0U )
+        {
+            ulElapsedMs = 1U;
+        }
+
+        ulRate = ( uint32_t ) ( ( ( uint64_t ) pxTune->ulBytes * 1000U ) / ulElapsedMs );
+    }
+
+    return ulRate;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xTCPAutotuneApply( TCPAutotune_t * pxTune,
+                              Socket_t xSocket,
+                              const struct freertos_sockaddr * pxRemote )
+{
+    AutotuneCacheEntry_t * pxEntry;
+    size_t uxBuffer = autotuneINITIAL_BUFFER;
+    size_t uxAvailable;
+    BaseType_t xReturn = -pdFREERTOS_ERRNO_ENOMEM;
+
+    configASSERT( pxTune != NULL );
+    configASSERT( pxRemote != NULL );
+
+    memset( pxTune, 0, sizeof( *pxTune ) );
+    pxTune->xSocket = xSocket;
+    memcpy( &( pxTune->xRemote ), pxRemote, sizeof( pxTune->xRemote ) );
+
+    taskENTER_CRITICAL();
+    {
+        pxEntry = prvCacheLookup( pxRemote );
+
+        if( ( pxEntry != NULL ) && ( pxEntry->ulBDP > 0U ) )
+        {
+            /* Twice the BDP: enough to fill the pipe, and room to find out
+             * that the pipe is larger than measured. */
+            uxBuffer = 2U * ( size_t ) pxEntry->ulBDP;
+        }
+
+        uxBuffer = prvClampBuffer( uxBuffer );
+
+        /* RX and TX buffer both come out of the budget. */
+        uxAvailable = configTCP_AUTOTUNE_MEMORY_BUDGET - xBudget.uxUsed;
+
+        if( ( 2U * uxBuffer ) > uxAvailable )
+        {
+            uxBuffer = ( ( uxAvailable / 2U ) / ipconfigTCP_MSS ) * ipconfigTCP_MSS;
+
+            if( uxBuffer < configTCP_AUTOTUNE_MIN_BUFFER )
+            {
+                /* The socket would exceed the budget. */
+                uxBuffer = 0U;
+                xBudget.ulRefused++;
+            }
+            else
+            {
+                xBudget.ulShrunk++;
+            }
+        }
+
+        if( uxBuffer > 0U )
+        {
+            pxTune->uxReserved = 2U * uxBuffer;
+            xBudget.uxUsed += pxTune->uxReserved;
+
+            if( xBudget.uxUsed > xBudget.uxHighWater )
+            {
+                xBudget.uxHighWater = xBudget.uxUsed;
+            }
+
+            pxTune->pxNext = pxActiveList;
+            pxActiveList = pxTune;
+        }
+    }
+    taskEXIT_CRITICAL();
+
+    if( uxBuffer > 0U )
+    {
+        pxTune->xWinProps.lRxBufSize = ( int32_t ) uxBuffer;
+        pxTune->xWinProps.lRxWinSize = ( int32_t ) ( uxBuffer / ipconfigTCP_MSS );
+        pxTune->xWinProps.lTxBufSize = ( int32_t ) uxBuffer;
+        pxTune->xWinProps.lTxWinSize = ( int32_t ) ( uxBuffer / ipconfigTCP_MSS );
+
+        pxTune->xConnectStart = xTaskGetTickCount();
+
+        xReturn = FreeRTOS_setsockopt( xSocket, 0, FREERTOS_SO_WIN_PROPERTIES, ( void * ) &( pxTune->xWinProps ), sizeof( pxTune->xWinProps ) );
+    }
+
+    return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+void vTCPAutotuneConnected( TCPAutotune_t * pxTune )
+{
+    TickType_t xNow = xTaskGetTickCount();
+
+    /* The 3-way handshake takes one round trip. */
+    pxTune->ulRTTMs = ( uint32_t ) pdTICKS_TO_MS( xNow - pxTune->xConnectStart );
+
+    if( pxTune->ulRTTMs == 0U )
+    {
+        pxTune->ulRTTMs = 1U;
+    }
+
+    pxTune->xTransferStart = xNow;
+    pxTune->ulBytes = 0U;
+}
+/*-----------------------------------------------------------*/
+
+void vTCPAutotuneTransferred( TCPAutotune_t * pxTune,
+                              size_t uxBytes )
+{
+    pxTune->ulBytes += ( uint32_t ) uxBytes;
+}
+/*-----------------------------------------------------------*/
+
+void vTCPAutotuneRelease( TCPAutotune_t * pxTune )
+{
+    TCPAutotune_t ** ppxLink;
+    AutotuneCacheEntry_t * pxEntry;
+    uint32_t ulRate = prvRate( pxTune );
+
+    taskENTER_CRITICAL();
+    {
+        if( ( ulRate > 0U ) && ( pxTune->ulRTTMs > 0U ) )
+        {
+            pxEntry = prvCacheInsert( &( pxTune->xRemote ) );
+            pxEntry->ulBDP = ( uint32_t ) ( ( ( uint64_t ) ulRate * pxTune->ulRTTMs ) / 1000U );
+        }
+
+        for( ppxLink = &pxActiveList; *ppxLink != NULL; ppxLink = &( ( *ppxLink )->pxNext ) )
+        {
+            if( *ppxLink == pxTune )
+            {
+                *ppxLink = pxTune->pxNext;
+                xBudget.uxUsed -= pxTune->uxReserved;
+                pxTune->uxReserved = 0U;
+                break;
+            }
+        }
+    }
+    taskEXIT_CRITICAL();
+
+    pxTune->pxNext = NULL;
+}
+/*-----------------------------------------------------------*/
+
+void vTCPAutotuneGetStatus( const TCPAutotune_t * pxTune,
+                            TCPAutotuneStatus_t * pxStatus )
+{
+    pxStatus->lRxBufSize = pxTune->xWinProps.lRxBufSize;
+    pxStatus->lRxWinSize = pxTune->xWinProps.lRxWinSize;
+    pxStatus->lTxBufSize = pxTune->xWinProps.lTxBufSize;
+    pxStatus->lTxWinSize = pxTune->xWinProps.lTxWinSize;
+    pxStatus->xRxFill = FreeRTOS_rx_size( pxTune->xSocket );
+    pxStatus->xTxFill = FreeRTOS_tx_size( pxTune->xSocket );
+    pxStatus->ulRTTMs = pxTune->ulRTTMs;
+    pxStatus->ulRateBytesPerSec = prvRate( pxTune );
+}
+/*-----------------------------------------------------------*/
+
+void vTCPAutotuneGetBudget( TCPAutotuneBudget_t * pxBudget )
+{
+    taskENTER_CRITICAL();
+    {
+        memcpy( pxBudget, &xBudget, sizeof( *pxBudget ) );
+    }
+    taskEXIT_CRITICAL();
+}
+/*-----------------------------------------------------------*/
+
+void vTCPAutotuneReport( void )
+{
+    TCPAutotune_t * pxTune;
+    TCPAutotuneStatus_t xStatus;
+
+    /* Keep the list stable while it is printed. */
+    vTaskSuspendAll();
+    {
+        FreeRTOS_printf( ( "TCP autotune: %u of %u budget bytes in use, peak %u, %u sockets shrunk, %u refused\n",
+                           ( unsigned ) xBudget.uxUsed, ( unsigned ) configTCP_AUTOTUNE_MEMORY_BUDGET,
+                           ( unsigned ) xBudget.uxHighWater, ( unsigned ) xBudget.ulShrunk,
+                           ( unsigned ) xBudget.ulRefused ) );
+
+        for( pxTune = pxActiveList; pxTune != NULL; pxTune = pxTune->pxNext )
+        {
+            vTCPAutotuneGetStatus( pxTune, &xStatus );
+            FreeRTOS_printf( ( "  port %u: rx %d/%d win %d, tx %d/%d win %d, rtt %u ms, %u B/s\n",
+                               ( unsigned ) FreeRTOS_ntohs( pxTune->xRemote.sin_port ),
+                               ( int ) xStatus.xRxFill, ( int ) xStatus.lRxBufSize, ( int ) xStatus.lRxWinSize,
+                               ( int ) xStatus.xTxFill, ( int ) xStatus.lTxBufSize, ( int ) xStatus.lTxWinSize,
+                               ( unsigned ) xStatus.ulRTTMs, ( unsigned ) xStatus.ulRateBytesPerSec ) );
+        }
+    }
+    ( void ) xTaskResumeAll();
+}
+/*-----------------------------------------------------------*/
@@ -0,0 +1,132 @@
+#ifndef TCP_AUTOTUNE_H
+#define TCP_AUTOTUNE_H
+
+/* FreeRTOS+TCP includes. */
+#include "FreeRTOS_IP.h"
+#include "FreeRTOS_Sockets.h"
+
+/*
+ * Per-socket TCP buffer and window autotuning.
+ *
+ * FreeRTOS+TCP fixes the size of a socket's stream buffers and windows when
+ * the connection is made (FREERTOS_SO_WIN_PROPERTIES).  This module learns
+ * the bandwidth-delay product (BDP) of every destination from the connections
+ * made to it: the connect time is used as an RTT sample, and the application
+ * reports the bytes it transferred.  The next socket to the same destination
+ * gets buffers of twice the measured BDP, so a connection that was limited by
+ * its window gets a larger one the next time.
+ *
+ * All sockets share a single memory budget (configTCP_AUTOTUNE_MEMORY_BUDGET
+ * bytes of RX plus TX buffer space), which is a hard bound.  A socket that
+ * does not fit gets what is left, rounded down to whole segments.  When not
+ * even configTCP_AUTOTUNE_MIN_BUFFER is left, xTCPAutotuneApply() refuses the
+ * socket, and the caller must not connect it until another socket has been
+ * released.
+ */
+
+/* The total amount of stream buffer space that autotuned sockets may use. */
+#ifndef configTCP_AUTOTUNE_MEMORY_BUDGET
+    #define configTCP_AUTOTUNE_MEMORY_BUDGET    ( 48 * ipconfigTCP_MSS )
+#endif
+
+/* Limits for the size of a single RX or TX buffer.  The minimum allows 4
+segments in flight, the least that can produce the 3 duplicate ACKs needed for
+a fast retransmit.  Losses recovered that way and losses that needed a time-out
+are counted by tcp_congestion.h. */
+#ifndef configTCP_AUTOTUNE_MIN_BUFFER
+    #define configTCP_AUTOTUNE_MIN_BUFFER       ( 4 * ipconfigTCP_MSS )
+#endif
+
+#ifndef configTCP_AUTOTUNE_MAX_BUFFER
+    #define configTCP_AUTOTUNE_MAX_BUFFER       ( 24 * ipconfigTCP_MSS )
+#endif
+
+/* The number of destinations of which the BDP is remembered. */
+#ifndef configTCP_AUTOTUNE_CACHE_ENTRIES
+    #define configTCP_AUTOTUNE_CACHE_ENTRIES    4
+#endif
+
+typedef struct xTCP_AUTOTUNE
+{
+    Socket_t xSocket;
+    struct freertos_sockaddr xRemote;
+    WinProperties_t xWinProps;   /* The properties given to the socket. */
+    size_t uxReserved;           /* Bytes taken from the memory budget. */
+    TickType_t xConnectStart;
+    TickType_t xTransferStart;
+    uint32_t ulRTTMs;            /* Connect time, at least 1 ms. */
+    uint32_t ulBytes;            /* Bytes transferred while connected. */
+    struct xTCP_AUTOTUNE * pxNext;
+} TCPAutotune_t;
+
+typedef struct xTCP_AUTOTUNE_STATUS
+{
+    int32_t lRxBufSize;          /* Current RX buffer size in bytes. */
+    int32_t lRxWinSize;          /* Current RX window in segments. */
+    int32_t lTxBufSize;
+    int32_t lTxWinSize;
+    BaseType_t xRxFill;          /* Bytes waiting in the RX stream. */
+    BaseType_t xTxFill;          /* Bytes waiting in the TX stream. */
+    uint32_t ulRTTMs;
+    uint32_t ulRateBytesPerSec;  /* Measured over the current connection. */
+} TCPAutotuneStatus_t;
+
+typedef struct xTCP_AUTOTUNE_BUDGET
+{
+    size_t uxUsed;               /* Bytes reserved by connected sockets. */
+    size_t uxHighWater;          /* The most that was ever reserved. */
+    uint32_t ulShrunk;           /* Sockets that got less than they asked for. */
+    uint32_t ulRefused;          /* Sockets that got nothing. */
+} TCPAutotuneBudget_t;
+
+/**
+ * @brief Choose and apply the buffer and window sizes for a socket that is
+ * about to connect to pxRemote.  Must be called before FreeRTOS_connect().
+ *
+ * @param pxTune Autotune state of the socket, owned by the caller.
+ * @param xSocket A TCP socket that is not yet connected.
+ * @param pxRemote The address that the socket will connect to.
+ *
+ * @return The result of FREERTOS_SO_WIN_PROPERTIES, or
+ * -pdFREERTOS_ERRNO_ENOMEM when the budget has no room for the socket.
+ * vTCPAutotuneRelease() may be called in either case.
+ */
+BaseType_t xTCPAutotuneApply( TCPAutotune_t * pxTune,
+                              Socket_t xSocket,
+                              const struct freertos_sockaddr * pxRemote );
+
+/**
+ * @brief Report that FreeRTOS_connect() has returned successfully.
+ * Starts the RTT and throughput measurements.
+ */
+void vTCPAutotuneConnected( TCPAutotune_t * pxTune );
+
+/**
+ * @brief Report the number of payload bytes sent or received.
+ */
+void vTCPAutotuneTransferred( TCPAutotune_t * pxTune,
+                              size_t uxBytes );
+
+/**
+ * @brief Store what was learned about the destination and return the buffer
+ * space to the budget.  Must be called before the socket is closed.
+ */
+void vTCPAutotuneRelease( TCPAutotune_t * pxTune );
+
+/**
+ * @brief Get the current window and buffer fill of an autotuned socket.
+ */
+void vTCPAutotuneGetStatus( const TCPAutotune_t * pxTune,
+                            TCPAutotuneStatus_t * pxStatus );
+
+/**
+ * @brief Get the use of the memory budget.
+ */
+void vTCPAutotuneGetBudget( TCPAutotuneBudget_t * pxBudget );
+
+/**
+ * @brief Log the status of all autotuned sockets and the memory budget.
+ */
+void vTCPAutotuneReport( void );
+
+#endif /* #ifndef TCP_AUTOTUNE_H */
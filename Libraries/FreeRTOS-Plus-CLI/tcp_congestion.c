@@ -0,0 +1,778 @@
+/* The log messages of this file, see log_levels.h. */
+#define logMODULE    eLogModuleNet
+
+/* Standard includes. */
+#include <string.h>
+
+/* FreeRTOS includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+
+/* FreeRTOS+TCP includes. */
+#include "FreeRTOS_IP.h"
+#include "FreeRTOS_Sockets.h"
+#include "FreeRTOS_Routing.h"
+
+#include "tcp_congestion.h"
+
+/* The RTO before the first RTT sample, RFC 6298. */
+#define tcpccINITIAL_RTO_MS    1000U
+
+/* "No threshold yet". */
+#define tcpccINFINITE          0xFFFFFFFFUL
+
+/* The stack resends a segment by time-out when it is older than twice its
+ * SRTT, and its SRTT is never less than this. */
+#ifdef ipconfigTCP_SRTT_MINIMUM_VALUE_MS
+    #define tcpccSTACK_MIN_SRTT_MS    ipconfigTCP_SRTT_MINIMUM_VALUE_MS
+#else
+    #define tcpccSTACK_MIN_SRTT_MS    50U
+#endif
+
+/* The parts of a frame that the tap looks at. */
+#define tcpccETH_HEADER_SIZE        14U
+#define tcpccETH_TYPE_OFFSET        12U
+#define tcpccETH_TYPE_IPv4          0x0800U
+#define tcpccETH_TYPE_IPv6          0x86DDU
+#define tcpccIPv4_HEADER_SIZE       20U
+#define tcpccIPv6_HEADER_SIZE       40U
+#define tcpccPROTOCOL_TCP           6U
+#define tcpccTCP_HEADER_SIZE        20U
+#define tcpccTCP_FLAG_SYN           0x02U
+
+/*
+ * Feed an RTT sample into the RFC 6298 estimators.
+ */
+static void prvRTTSample( TCPCongestion_t * pxCC,
+                          uint32_t ulRTTMs );
+
+/*
+ * Start the response to a loss when the tap saw a retransmission, unless
+ * the response to an earlier one is still running.
+ */
+static void prvCheckRetransmits( TCPCongestion_t * pxCC,
+                                 uint32_t ulInFlight );
+
+/*
+ * The output function that vTCPCongestionWatchInterface() installs: look at
+ * the frame, then pass it on to the driver.
+ */
+static BaseType_t prvOutput( NetworkInterface_t * pxInterface,
+                             NetworkBufferDescriptor_t * const pxNetworkBuffer,
+                             BaseType_t xReleaseAfterSend );
+
+/*
+ * Find the data of a TCP segment in an Ethernet frame, IPv4 or IPv6 without
+ * extension headers, and pass it to prvSegmentSent().
+ */
+static void prvInspectFrame( const uint8_t * pucFrame,
+                             size_t uxLength );
+
+/*
+ * Follow the highest sequence number sent on a watched connection, and count
+ * the segments that start before it.
+ */
+static void prvSegmentSent( uint16_t usLocalPort,
+                            uint16_t usRemotePort,
+                            uint32_t ulSequence,
+                            uint32_t ulLength );
+
+/*
+ * The initial window of RFC 3390.
+ */
+static uint32_t prvInitialWindow( const TCPCongestion_t * pxCC );
+
+/* "reno" */
+static void prvRenoInit( TCPCongestion_t * pxCC );
+static void prvRenoOnAck( TCPCongestion_t * pxCC,
+                          uint32_t ulAcked,
+                          uint32_t ulRTTMs );
+static void prvRenoOnLoss( TCPCongestion_t * pxCC,
+                           uint32_t ulInFlight );
+
+/* "vegas" */
+static void prvVegasInit( TCPCongestion_t * pxCC );
+static void prvVegasOnAck( TCPCongestion_t * pxCC,
+                           uint32_t ulAcked,
+                           uint32_t ulRTTMs );
+
+/*-----------------------------------------------------------*/
+
+const TCPCongestionOps_t xTCPCongestionReno =
+{
+    "reno",
+    prvRenoInit,
+    prvRenoOnAck,
+    prvRenoOnLoss
+};
+
+const TCPCongestionOps_t xTCPCongestionVegas =
+{
+    "vegas",
+    prvVegasInit,
+    prvVegasOnAck,
+    prvRenoOnLoss
+};
+
+static const TCPCongestionOps_t * const pxAlgorithms[] =
+{
+    &xTCPCongestionReno,
+    &xTCPCongestionVegas
+};
+
+/* A lost increment when two tasks race is acceptable for a statistic. */
+static TCPCongestionLosses_t xLosses;
+
+/* The sockets followed by the tap, and the output function of the driver. */
+static TCPCongestion_t * pxWatched[ configTCP_CONGESTION_MAX_SOCKETS ];
+static NetworkInterfaceOutputFunction_t pfDriverOutput = NULL;
+
+/*-----------------------------------------------------------*/
+
+static uint32_t prvInitialWindow( const TCPCongestion_t * pxCC )
+{
+    uint32_t ulWindow = 4380U;
+
+    /* min( 4 * MSS, max( 2 * MSS, 4380 ) ) */
+    if( ulWindow < ( 2U * pxCC->ulMSS ) )
+    {
+        ulWindow = 2U * pxCC->ulMSS;
+    }
+
+    if( ulWindow > ( 4U * pxCC->ulMSS ) )
+    {
+        ulWindow = 4U * pxCC->ulMSS;
+    }
+
+    return ulWindow;
+}
+/*-----------------------------------------------------------*/
+
+static void prvRenoInit( TCPCongestion_t * pxCC )
+{
+    pxCC->ulCwnd = prvInitialWindow( pxCC );
+    pxCC->ulSsthresh = tcpccINFINITE;
+    pxCC->ulCwndCredit = 0U;
+}
+/*-----------------------------------------------------------*/
+
+static void prvRenoOnAck( TCPCongestion_t * pxCC,
+                          uint32_t ulAcked,
+                          uint32_t ulRTTMs )
+{
+    uint32_t ulInFlight = ( pxCC->ulStreamQueued - pxCC->ulStreamAcked ) + ulAcked;
+
+    ( void ) ulRTTMs;
+
+    if( ( ulInFlight + ( 2U * pxCC->ulMSS ) ) < pxCC->ulCwnd )
+    {
+        /* The window was not used, by lack of data or of space in the TX
+         * stream: it is not validated by this ACK (RFC 7661). */
+    }
+    else if( pxCC->ulCwnd < pxCC->ulSsthresh )
+    {
+        /* Slow start, with appropriate byte counting (L = 2 * MSS). */
+        pxCC->ulCwnd += ( ulAcked < ( 2U * pxCC->ulMSS ) ) ? ulAcked : ( 2U * pxCC->ulMSS );
+    }
+    else
+    {
+        /* Congestion avoidance: one MSS per window of acknowledged data. */
+        pxCC->ulCwndCredit += ulAcked;
+
+        if( pxCC->ulCwndCredit >= pxCC->ulCwnd )
+        {
+            pxCC->ulCwndCredit -= pxCC->ulCwnd;
+            pxCC->ulCwnd += pxCC->ulMSS;
+        }
+    }
+}
+/*-----------------------------------------------------------*/
+
+static void prvRenoOnLoss( TCPCongestion_t * pxCC,
+                           uint32_t ulInFlight )
+{
+    /* The lost segment has been resent already, by the stack: continue from
+     * half the window in congestion avoidance. */
+    pxCC->ulSsthresh = ulInFlight / 2U;
+
+    if( pxCC->ulSsthresh < ( 2U * pxCC->ulMSS ) )
+    {
+        pxCC->ulSsthresh = 2U * pxCC->ulMSS;
+    }
+
+    pxCC->ulCwnd = pxCC->ulSsthresh;
+    pxCC->ulCwndCredit = 0U;
+}
+/*-----------------------------------------------------------*/
+
+static void prvVegasInit( TCPCongestion_t * pxCC )
+{
+    prvRenoInit( pxCC );
+    pxCC->ulVegasEnd = pxCC->ulStreamQueued;
+    pxCC->ulVegasMinRTTMs = tcpccINFINITE;
+}
+/*-----------------------------------------------------------*/
+
+static void prvVegasOnAck( TCPCongestion_t * pxCC,
+                           uint32_t ulAcked,
+                           uint32_t ulRTTMs )
+{
+    uint32_t ulQueued;
+
+    if( ( ulRTTMs != 0U ) && ( ulRTTMs < pxCC->ulVegasMinRTTMs ) )
+    {
+        pxCC->ulVegasMinRTTMs = ulRTTMs;
+    }
+
+    if( ( int32_t ) ( pxCC->ulStreamAcked - pxCC->ulVegasEnd ) < 0 )
+    {
+        /* Decisions are made once per round trip, in slow-start cwnd grows
+         * on every ACK in the mean time. */
+        if( pxCC->ulCwnd < pxCC->ulSsthresh )
+        {
+            prvRenoOnAck( pxCC, ulAcked, ulRTTMs );
+        }
+    }
+    else
+    {
+        if( pxCC->ulVegasMinRTTMs != tcpccINFINITE )
+        {
+            /* Bytes that are sitting in queues along the path:
+             * cwnd * ( RTT - baseRTT ) / RTT */
+            ulQueued = ( uint32_t ) ( ( ( uint64_t ) pxCC->ulCwnd * ( pxCC->ulVegasMinRTTMs - pxCC->ulMinRTTMs ) ) / pxCC->ulVegasMinRTTMs );
+
+            if( pxCC->ulCwnd < pxCC->ulSsthresh )
+            {
+                if( ulQueued > pxCC->ulMSS )
+                {
+                    /* The path starts to queue: leave slow-start. */
+                    pxCC->ulSsthresh = pxCC->ulCwnd;
+                }
+                else
+                {
+                    prvRenoOnAck( pxCC, ulAcked, ulRTTMs );
+                }
+            }
+            else if( ulQueued < ( tcpccVEGAS_ALPHA * pxCC->ulMSS ) )
+            {
+                pxCC->ulCwnd += pxCC->ulMSS;
+            }
+            else if( ulQueued > ( tcpccVEGAS_BETA * pxCC->ulMSS ) )
+            {
+                if( pxCC->ulCwnd > ( 2U * pxCC->ulMSS ) )
+                {
+                    pxCC->ulCwnd -= pxCC->ulMSS;
+                }
+            }
+            else
+            {
+                /* Between alpha and beta: stay. */
+            }
+        }
+        else if( pxCC->ulCwnd < pxCC->ulSsthresh )
+        {
+            prvRenoOnAck( pxCC, ulAcked, ulRTTMs );
+        }
+
+        /* Start the next round trip. */
+        pxCC->ulVegasEnd = pxCC->ulStreamQueued;
+        pxCC->ulVegasMinRTTMs = tcpccINFINITE;
+    }
+}
+/*-----------------------------------------------------------*/
+
+static void prvRTTSample( TCPCongestion_t * pxCC,
+                          uint32_t ulRTTMs )
+{
+    uint32_t ulDelta;
+    uint32_t ulRTO;
+
+    if( pxCC->ulSRTTMs == 0U )
+    {
+        pxCC->ulSRTTMs = ulRTTMs;
+        pxCC->ulRTTVarMs = ulRTTMs / 2U;
+    }
+    else
+    {
+        ulDelta = ( pxCC->ulSRTTMs > ulRTTMs ) ? ( pxCC->ulSRTTMs - ulRTTMs ) : ( ulRTTMs - pxCC->ulSRTTMs );
+        pxCC->ulRTTVarMs = ( ( 3U * pxCC->ulRTTVarMs ) + ulDelta ) / 4U;
+        pxCC->ulSRTTMs = ( ( 7U * pxCC->ulSRTTMs ) + ulRTTMs ) / 8U;
+    }
+
+    if( ( pxCC->ulMinRTTMs == 0U ) || ( ulRTTMs < pxCC->ulMinRTTMs ) )
+    {
+        pxCC->ulMinRTTMs = ulRTTMs;
+    }
+
+    ulRTO = pxCC->ulSRTTMs + ( 4U * pxCC->ulRTTVarMs );
+
+    if( ulRTO < tcpccMIN_RTO_MS )
+    {
+        ulRTO = tcpccMIN_RTO_MS;
+    }
+    else if( ulRTO > tcpccMAX_RTO_MS )
+    {
+        ulRTO = tcpccMAX_RTO_MS;
+    }
+
+    pxCC->ulRTOMs = ulRTO;
+}
+/*-----------------------------------------------------------*/
+
+void vTCPCongestionInit( TCPCongestion_t * pxCC,
+                         Socket_t xSocket,
+                         const TCPCongestionOps_t * pxOps )
+{
+    BaseType_t xMSS;
+    struct freertos_sockaddr xAddress;
+    size_t x;
+
+    configASSERT( pxCC != NULL );
+
+    /* The tap must not write into the state while it is cleared. */
+    vTCPCongestionDeinit( pxCC );
+
+    memset( pxCC, 0, sizeof( *pxCC ) );
+    pxCC->xSocket = xSocket;
+    pxCC->pxOps = ( pxOps != NULL ) ? pxOps : &xTCPCongestionReno;
+    pxCC->ulRTOMs = tcpccINITIAL_RTO_MS;
+    pxCC->xLastProgress = xTaskGetTickCount();
+    pxCC->xRTOStart = pxCC->xLastProgress;
+
+    xMSS = FreeRTOS_mss( xSocket );
+    pxCC->ulMSS = ( xMSS > 0 ) ? ( uint32_t ) xMSS : ipconfigTCP_MSS;
+
+    pxCC->pxOps->fnInit( pxCC );
+
+    memset( &xAddress, 0, sizeof( xAddress ) );
+    ( void ) FreeRTOS_GetLocalAddress( xSocket, &xAddress );
+    pxCC->usLocalPort = FreeRTOS_ntohs( xAddress.sin_port );
+    memset( &xAddress, 0, sizeof( xAddress ) );
+    ( void ) FreeRTOS_GetRemoteAddress( xSocket, &xAddress );
+    pxCC->usRemotePort = FreeRTOS_ntohs( xAddress.sin_port );
+
+    taskENTER_CRITICAL();
+    {
+        for( x = 0; x < configTCP_CONGESTION_MAX_SOCKETS; x++ )
+        {
+            if( pxWatched[ x ] == NULL )
+            {
+                pxWatched[ x ] = pxCC;
+                break;
+            }
+        }
+    }
+    taskEXIT_CRITICAL();
+
+    if( x == configTCP_CONGESTION_MAX_SOCKETS )
+    {
+        LogWarn( ( "TCP congestion: no room to watch port %u, losses are not seen\n",
+                   ( unsigned ) pxCC->usLocalPort ) );
+    }
+}
+/*-----------------------------------------------------------*/
+
+void vTCPCongestionDeinit( TCPCongestion_t * pxCC )
+{
+    size_t x;
+
+    taskENTER_CRITICAL();
+    {
+        for( x = 0; x < configTCP_CONGESTION_MAX_SOCKETS; x++ )
+        {
+            if( pxWatched[ x ] == pxCC )
+            {
+                pxWatched[ x ] = NULL;
+            }
+        }
+    }
+    taskEXIT_CRITICAL();
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xTCPCongestionSetAlgorithm( TCPCongestion_t * pxCC,
+                                       const char * pcName )
+{
+    BaseType_t xReturn = pdFAIL;
+    size_t x;
+
+    for( x = 0; x < ( sizeof( pxAlgorithms ) / sizeof( pxAlgorithms[ 0 ] ) ); x++ )
+    {
+        if( strcmp( pxAlgorithms[ x ]->pcName, pcName ) == 0 )
+        {
+            pxCC->pxOps = pxAlgorithms[ x ];
+            pxCC->pxOps->fnInit( pxCC );
+            xReturn = pdPASS;
+            break;
+        }
+    }
+
+    return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+static void prvCheckRetransmits( TCPCongestion_t * pxCC,
+                                 uint32_t ulInFlight )
+{
+    uint32_t ulRetransmitted = pxCC->ulRetransmitted;
+    TickType_t xRetransmitTime = pxCC->xRetransmitTime;
+    uint32_t ulSpan = pxCC->ulRetransmitSpan;
+    uint32_t ulGapMs = 0U;
+    uint32_t ulLimitMs;
+
+    if( ulRetransmitted != pxCC->ulRetransmitsHandled )
+    {
+        pxCC->ulRetransmitsHandled = ulRetransmitted;
+
+        if( pxCC->xInRecovery == pdFALSE )
+        {
+            /* The progress is the one before this update, the ACKs that came
+             * after the retransmission are counted below. */
+            if( ( int32_t ) ( xRetransmitTime - pxCC->xLastProgress ) > 0 )
+            {
+                ulGapMs = ( uint32_t ) pdTICKS_TO_MS( xRetransmitTime - pxCC->xLastProgress );
+            }
+
+            ulLimitMs = ( pxCC->ulSRTTMs > tcpccSTACK_MIN_SRTT_MS ) ? pxCC->ulSRTTMs : tcpccSTACK_MIN_SRTT_MS;
+            ulLimitMs *= 2U;
+
+            if( ( pxCC->xTimedOut != pdFALSE ) || ( ulGapMs >= ulLimitMs ) )
+            {
+                pxCC->ulTimeouts++;
+                xLosses.ulTimeouts++;
+            }
+            else
+            {
+                /* The duplicate ACKs or SACK of the peer made the stack resend
+                 * while the ACKs were still coming in. */
+                pxCC->ulRecoveries++;
+                xLosses.ulRecoveries++;
+            }
+
+            /* One response per window of data: the stack resends the oldest
+             * segment first, so the window ends ulSpan bytes after the first
+             * one that is not acknowledged.  ACKs of a retransmission are not
+             * timed (Karn). */
+            if( ulSpan > ulInFlight )
+            {
+                ulSpan = ulInFlight;
+            }
+
+            pxCC->xInRecovery = pdTRUE;
+            pxCC->ulRecoverPosition = pxCC->ulStreamAcked + ulSpan;
+            pxCC->xTiming = pdFALSE;
+            pxCC->pxOps->fnOnLoss( pxCC, ulInFlight );
+        }
+    }
+}
+/*-----------------------------------------------------------*/
+
+void vTCPCongestionUpdate( TCPCongestion_t * pxCC )
+{
+    TickType_t xNow = xTaskGetTickCount();
+    BaseType_t xOutstanding;
+    uint32_t ulAcked;
+    uint32_t ulInFlight;
+    uint32_t ulRTTMs = 0U;
+
+    xOutstanding = FreeRTOS_outstanding( pxCC->xSocket );
+
+    if( xOutstanding >= 0 )
+    {
+        ulInFlight = pxCC->ulStreamQueued - pxCC->ulStreamAcked;
+        prvCheckRetransmits( pxCC, ulInFlight );
+
+        ulAcked = ( pxCC->ulStreamQueued - ( uint32_t ) xOutstanding ) - pxCC->ulStreamAcked;
+
+        if( ulAcked > 0U )
+        {
+            pxCC->ulStreamAcked += ulAcked;
+            pxCC->ulBytesAcked += ulAcked;
+
+            if( pxCC->xInRecovery != pdFALSE )
+            {
+                /* cwnd stays at ssthresh until the data that was in flight at
+                 * the loss has been acknowledged. */
+                if( ( int32_t ) ( pxCC->ulStreamAcked - pxCC->ulRecoverPosition ) >= 0 )
+                {
+                    pxCC->xInRecovery = pdFALSE;
+                }
+            }
+            else
+            {
+                if( pxCC->xTimedOut != pdFALSE )
+                {
+                    /* Progress without a retransmission: cwnd stays. */
+                    pxCC->ulStalls++;
+                    xLosses.ulStalls++;
+                    pxCC->xTiming = pdFALSE;
+                }
+
+                if( ( pxCC->xTiming != pdFALSE ) &&
+                    ( ( int32_t ) ( pxCC->ulStreamAcked - pxCC->ulTimedPosition ) >= 0 ) )
+                {
+                    ulRTTMs = ( uint32_t ) pdTICKS_TO_MS( xNow - pxCC->xTimedSent );
+
+                    if( ulRTTMs == 0U )
+                    {
+                        ulRTTMs = 1U;
+                    }
+
+                    pxCC->xTiming = pdFALSE;
+                    prvRTTSample( pxCC, ulRTTMs );
+                }
+
+                pxCC->pxOps->fnOnAck( pxCC, ulAcked, ulRTTMs );
+            }
+
+            pxCC->xTimedOut = pdFALSE;
+            pxCC->xLastProgress = xNow;
+            pxCC->xRTOStart = xNow;
+        }
+        else if( ( ulInFlight != 0U ) &&
+                 ( pdTICKS_TO_MS( xNow - pxCC->xRTOStart ) >= pxCC->ulRTOMs ) )
+        {
+            /* Nothing was acknowledged for an RTO: the stack is retransmitting,
+             * or the peer's window is closed.  Which of the two is known when
+             * the tap sees a retransmission, or the ACKs come back.  Back off,
+             * and do not time a retransmitted segment (Karn). */
+            pxCC->xTimedOut = pdTRUE;
+            pxCC->ulRTOMs = ( ( 2U * pxCC->ulRTOMs ) < tcpccMAX_RTO_MS ) ? ( 2U * pxCC->ulRTOMs ) : tcpccMAX_RTO_MS;
+            pxCC->xTiming = pdFALSE;
+            pxCC->xRTOStart = xNow;
+        }
+        else
+        {
+            /* Waiting for an ACK. */
+        }
+    }
+}
+/*-----------------------------------------------------------*/
+
+uint32_t ulTCPCongestionAllowance( TCPCongestion_t * pxCC )
+{
+    uint32_t ulInFlight;
+    uint32_t ulAllowed = 0U;
+
+    vTCPCongestionUpdate( pxCC );
+
+    ulInFlight = pxCC->ulStreamQueued - pxCC->ulStreamAcked;
+
+    if( ulInFlight < pxCC->ulCwnd )
+    {
+        ulAllowed = pxCC->ulCwnd - ulInFlight;
+    }
+
+    return ulAllowed;
+}
+/*-----------------------------------------------------------*/
+
+void vTCPCongestionSent( TCPCongestion_t * pxCC,
+                         uint32_t ulBytes )
+{
+    TickType_t xNow = xTaskGetTickCount();
+
+    if( ulBytes > 0U )
+    {
+        if( pxCC->ulStreamQueued == pxCC->ulStreamAcked )
+        {
+            /* The RTO runs from the moment data is outstanding. */
+            pxCC->xLastProgress = xNow;
+            pxCC->xRTOStart = xNow;
+        }
+
+        if( pxCC->xTiming == pdFALSE )
+        {
+            pxCC->xTiming = pdTRUE;
+            pxCC->ulTimedPosition = pxCC->ulStreamQueued + ulBytes;
+            pxCC->xTimedSent = xNow;
+        }
+
+        pxCC->ulStreamQueued += ulBytes;
+    }
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xTCPCongestionSend( TCPCongestion_t * pxCC,
+                               const void * pvBuffer,
+                               size_t uxLength,
+                               BaseType_t xFlags )
+{
+    BaseType_t xResult = 0;
+    uint32_t ulAllowed;
+
+    ulAllowed = ulTCPCongestionAllowance( pxCC );
+
+    if( ulAllowed > 0U )
+    {
+        if( uxLength > ( size_t ) ulAllowed )
+        {
+            uxLength = ( size_t ) ulAllowed;
+        }
+
+        xResult = FreeRTOS_send( pxCC->xSocket, pvBuffer, uxLength, xFlags );
+
+        if( xResult > 0 )
+        {
+            vTCPCongestionSent( pxCC, ( uint32_t ) xResult );
+        }
+    }
+
+    return xResult;
+}
+/*-----------------------------------------------------------*/
+
+void vTCPCongestionGetStats( const TCPCongestion_t * pxCC,
+                             TCPCongestionStats_t * pxStats )
+{
+    pxStats->pcAlgorithm = pxCC->pxOps->pcName;
+    pxStats->ulCwnd = pxCC->ulCwnd;
+    pxStats->ulSsthresh = pxCC->ulSsthresh;
+    pxStats->ulInFlight = pxCC->ulStreamQueued - pxCC->ulStreamAcked;
+    pxStats->ulSRTTMs = pxCC->ulSRTTMs;
+    pxStats->ulRTTVarMs = pxCC->ulRTTVarMs;
+    pxStats->ulMinRTTMs = pxCC->ulMinRTTMs;
+    pxStats->ulRTOMs = pxCC->ulRTOMs;
+    pxStats->ulBytesAcked = pxCC->ulBytesAcked;
+    pxStats->ulRetransmits = pxCC->ulRetransmitted;
+    pxStats->ulRecoveries = pxCC->ulRecoveries;
+    pxStats->ulTimeouts = pxCC->ulTimeouts;
+    pxStats->ulStalls = pxCC->ulStalls;
+}
+/*-----------------------------------------------------------*/
+
+void vTCPCongestionGetLosses( TCPCongestionLosses_t * pxLosses )
+{
+    memcpy( pxLosses, &xLosses, sizeof( *pxLosses ) );
+}
+/*-----------------------------------------------------------*/
+
+void vTCPCongestionReport( void )
+{
+    FreeRTOS_printf( ( "TCP losses: %u segments resent, %u recovered by fast retransmit, %u after a time-out, %u stalls\n",
+                       ( unsigned ) xLosses.ulRetransmits,
+                       ( unsigned ) xLosses.ulRecoveries,
+                       ( unsigned ) xLosses.ulTimeouts,
+                       ( unsigned ) xLosses.ulStalls ) );
+}
+/*-----------------------------------------------------------*/
+
+static void prvSegmentSent( uint16_t usLocalPort,
+                            uint16_t usRemotePort,
+                            uint32_t ulSequence,
+                            uint32_t ulLength )
+{
+    TCPCongestion_t * pxCC;
+    uint32_t ulEnd = ulSequence + ulLength;
+    size_t x;
+
+    taskENTER_CRITICAL();
+    {
+        for( x = 0; x < configTCP_CONGESTION_MAX_SOCKETS; x++ )
+        {
+            pxCC = pxWatched[ x ];
+
+            if( ( pxCC != NULL ) && ( pxCC->usLocalPort == usLocalPort ) && ( pxCC->usRemotePort == usRemotePort ) )
+            {
+                if( pxCC->xSequenceKnown == pdFALSE )
+                {
+                    pxCC->xSequenceKnown = pdTRUE;
+                    pxCC->ulHighestSequence = ulEnd;
+                }
+                else
+                {
+                    if( ( int32_t ) ( ulSequence - pxCC->ulHighestSequence ) < 0 )
+                    {
+                        pxCC->ulRetransmitted++;
+                        pxCC->xRetransmitTime = xTaskGetTickCount();
+                        pxCC->ulRetransmitSpan = pxCC->ulHighestSequence - ulSequence;
+                        xLosses.ulRetransmits++;
+                    }
+
+                    if( ( int32_t ) ( ulEnd - pxCC->ulHighestSequence ) > 0 )
+                    {
+                        pxCC->ulHighestSequence = ulEnd;
+                    }
+                }
+
+                break;
+            }
+        }
+    }
+    taskEXIT_CRITICAL();
+}
+/*-----------------------------------------------------------*/
+
+static void prvInspectFrame( const uint8_t * pucFrame,
+                             size_t uxLength )
+{
+    size_t uxOffset = tcpccETH_HEADER_SIZE;
+    size_t uxEnd = 0U;
+    size_t uxHeader;
+    uint16_t usType;
+
+    if( uxLength >= ( tcpccETH_HEADER_SIZE + tcpccIPv4_HEADER_SIZE ) )
+    {
+        usType = ( uint16_t ) ( ( pucFrame[ tcpccETH_TYPE_OFFSET ] << 8 ) | pucFrame[ tcpccETH_TYPE_OFFSET + 1U ] );
+
+        if( ( usType == tcpccETH_TYPE_IPv4 ) && ( pucFrame[ uxOffset + 9U ] == tcpccPROTOCOL_TCP ) )
+        {
+            /* The total length, the frame may be padded. */
+            uxEnd = uxOffset + ( ( ( size_t ) pucFrame[ uxOffset + 2U ] << 8 ) | pucFrame[ uxOffset + 3U ] );
+            uxOffset += ( size_t ) ( pucFrame[ uxOffset ] & 0x0FU ) * 4U;
+        }
+        else if( ( usType == tcpccETH_TYPE_IPv6 ) &&
+                 ( uxLength >= ( tcpccETH_HEADER_SIZE + tcpccIPv6_HEADER_SIZE ) ) &&
+                 ( pucFrame[ uxOffset + 6U ] == tcpccPROTOCOL_TCP ) )
+        {
+            /* The payload length. */
+            uxEnd = uxOffset + tcpccIPv6_HEADER_SIZE + ( ( ( size_t ) pucFrame[ uxOffset + 4U ] << 8 ) | pucFrame[ uxOffset + 5U ] );
+            uxOffset += tcpccIPv6_HEADER_SIZE;
+        }
+        else
+        {
+            /* Not TCP. */
+        }
+    }
+
+    if( ( uxEnd <= uxLength ) && ( ( uxOffset + tcpccTCP_HEADER_SIZE ) <= uxEnd ) )
+    {
+        uxHeader = ( size_t ) ( pucFrame[ uxOffset + 12U ] >> 4 ) * 4U;
+
+        /* Only data counts, a SYN takes a sequence number of its own. */
+        if( ( ( pucFrame[ uxOffset + 13U ] & tcpccTCP_FLAG_SYN ) == 0U ) &&
+            ( ( uxOffset + uxHeader ) < uxEnd ) )
+        {
+            prvSegmentSent( ( uint16_t ) ( ( pucFrame[ uxOffset ] << 8 ) | pucFrame[ uxOffset + 1U ] ),
+                            ( uint16_t ) ( ( pucFrame[ uxOffset + 2U ] << 8 ) | pucFrame[ uxOffset + 3U ] ),
+                            ( ( uint32_t ) pucFrame[ uxOffset + 4U ] << 24 ) |
+                            ( ( uint32_t ) pucFrame[ uxOffset + 5U ] << 16 ) |
+                            ( ( uint32_t ) pucFrame[ uxOffset + 6U ] << 8 ) |
+                            ( uint32_t ) pucFrame[ uxOffset + 7U ],
+                            ( uint32_t ) ( uxEnd - ( uxOffset + uxHeader ) ) );
+        }
+    }
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvOutput( NetworkInterface_t * pxInterface,
+                             NetworkBufferDescriptor_t * const pxNetworkBuffer,
+                             BaseType_t xReleaseAfterSend )
+{
+    prvInspectFrame( pxNetworkBuffer->pucEthernetBuffer, pxNetworkBuffer->xDataLength );
+
+    return pfDriverOutput( pxInterface, pxNetworkBuffer, xReleaseAfterSend );
+}
+/*-----------------------------------------------------------*/
+
+void vTCPCongestionWatchInterface( NetworkInterface_t * pxInterface )
+{
+    /* One driver, installed once. */
+    if( pxInterface->pfOutput != prvOutput )
+    {
+        configASSERT( ( pfDriverOutput == NULL ) || ( pfDriverOutput == pxInterface->pfOutput ) );
+        pfDriverOutput = pxInterface->pfOutput;
+        pxInterface->pfOutput = prvOutput;
+    }
+}
+/*-----------------------------------------------------------*/
@@ -0,0 +1,259 @@
+#ifndef TCP_CONGESTION_H
+#define TCP_CONGESTION_H
+
+/* FreeRTOS+TCP includes. */
+#include "FreeRTOS_IP.h"
+#include "FreeRTOS_Sockets.h"
+#include "FreeRTOS_Routing.h"
+
+/*
+ * Sender-side congestion control for TCP sockets.
+ *
+ * The TCP window of FreeRTOS+TCP is a fixed-size scheme.  This module puts a
+ * congestion window (cwnd) in front of it: ulTCPCongestionAllowance() tells
+ * how much more data may enter a socket's TX stream, so that no more than
+ * cwnd is unacknowledged.  The TX queue of tcp_sendfile.h applies it when one
+ * is attached with vTCPTxQueueSetCongestion(); xTCPCongestionSend() does the
+ * same for a plain FreeRTOS_send().
+ *
+ * The ACKs come from FreeRTOS_outstanding(): a drop in outstanding bytes is
+ * an ACK, and the time it takes a stream position to be acknowledged is an
+ * RTT sample.  Duplicate ACKs and SACK are not visible outside the stack, but
+ * what the stack does about them is: vTCPCongestionWatchInterface() puts a
+ * tap in front of the output function of the network interface, and a data
+ * segment that starts before the highest sequence number sent on its
+ * connection is a retransmission.  The first one starts the response to a
+ * loss, the others until all that was sent before it is acknowledged belong
+ * to the same loss (as NewReno, RFC 6582):
+ * - A loss repaired by a fast retransmit: the retransmission came while the
+ *   ACKs were still moving, less than twice the SRTT (never less than the
+ *   stack's ipconfigTCP_SRTT_MINIMUM_VALUE_MS) after the last progress.
+ *   Reno halves cwnd (fast recovery, RFC 5681 3.2), without slow-start.
+ * - A loss repaired by a retransmission time-out: the retransmission came
+ *   later than that, or after the RTO of this module expired.  Treated like
+ *   the above, as the stack has already resent the data by itself.
+ * - A stall: no progress for an RTO or longer, and then the ACKs came back
+ *   without a retransmission.  That is what a zero window of the peer looks
+ *   like from here, and a peer that did not read is no reason to think the
+ *   path is congested, so cwnd and ssthresh are kept (as in RFC 7661).
+ * Each RTO without progress doubles the RTO, up to tcpccMAX_RTO_MS.  A socket
+ * that is not watched, because its interface has no tap or all
+ * configTCP_CONGESTION_MAX_SOCKETS entries are in use, only sees stalls.
+ * Connections are told apart by their ports.
+ *
+ * Besides the statistics of each socket, the losses of all sockets are added
+ * up (vTCPCongestionGetLosses()).  The SACK and fast retransmit code of the
+ * TCP window of FreeRTOS+TCP keeps no counters of its own, so these are the
+ * only numbers of losses recovered by a fast retransmit versus a time-out.
+ *
+ * The algorithm is pluggable per socket (TCPCongestionOps_t).  Two are
+ * provided:
+ * - "reno": slow-start and congestion avoidance (RFC 5681), and the
+ *   multiplicative decrease above after a loss.  cwnd only grows while it is
+ *   used, not while the sender is limited by its data or its TX stream.
+ * - "vegas": delay based.  It keeps between tcpccVEGAS_ALPHA and
+ *   tcpccVEGAS_BETA segments queued in the network, so it backs off when
+ *   the RTT grows, before a small router or switch buffer overflows.  After
+ *   a loss it behaves as "reno".
+ *
+ * RTT samples have the resolution of the tick (configTICK_RATE_HZ), and are
+ * never less than 1 ms.
+ */
+
+/* Segments that "vegas" tries to keep queued in the path. */
+#define tcpccVEGAS_ALPHA       2U
+#define tcpccVEGAS_BETA        4U
+
+/* Limits of the retransmission time-out, in ms. */
+#define tcpccMIN_RTO_MS        200U
+#define tcpccMAX_RTO_MS        60000U
+
+/* Sockets that the tap of vTCPCongestionWatchInterface() follows at once. */
+#ifndef configTCP_CONGESTION_MAX_SOCKETS
+    #define configTCP_CONGESTION_MAX_SOCKETS    4U
+#endif
+
+typedef struct xTCP_CONGESTION TCPCongestion_t;
+
+/* The operations that make up a congestion control algorithm. */
+typedef struct xTCP_CONGESTION_OPS
+{
+    const char * pcName;
+
+    /* Set cwnd and ssthresh for a new connection. */
+    void ( * fnInit )( TCPCongestion_t * pxCC );
+
+    /* Bytes were acknowledged.  ulRTTMs is 0 when there is no new sample. */
+    void ( * fnOnAck )( TCPCongestion_t * pxCC,
+                        uint32_t ulAcked,
+                        uint32_t ulRTTMs );
+
+    /* The stack resent a lost segment, ulInFlight bytes were
+     * unacknowledged at the time. */
+    void ( * fnOnLoss )( TCPCongestion_t * pxCC,
+                         uint32_t ulInFlight );
+} TCPCongestionOps_t;
+
+/* Statistics that can be read at any time. */
+typedef struct xTCP_CONGESTION_STATS
+{
+    const char * pcAlgorithm;
+    uint32_t ulCwnd;          /* Congestion window in bytes. */
+    uint32_t ulSsthresh;      /* Slow-start threshold in bytes. */
+    uint32_t ulInFlight;      /* Bytes in the TX stream, not acknowledged. */
+    uint32_t ulSRTTMs;        /* Smoothed RTT. */
+    uint32_t ulRTTVarMs;      /* RTT variation. */
+    uint32_t ulMinRTTMs;      /* Lowest RTT seen, the "base" RTT. */
+    uint32_t ulRTOMs;
+    uint32_t ulBytesAcked;
+    uint32_t ulRetransmits;   /* Segments resent by the stack. */
+    uint32_t ulRecoveries;    /* Losses repaired by a fast retransmit. */
+    uint32_t ulTimeouts;      /* Losses repaired after a time-out. */
+    uint32_t ulStalls;        /* Pauses without a loss, e.g. a zero window. */
+} TCPCongestionStats_t;
+
+/* The losses of all sockets with congestion control. */
+typedef struct xTCP_CONGESTION_LOSSES
+{
+    uint32_t ulRetransmits;   /* Segments resent by the stack. */
+    uint32_t ulRecoveries;    /* Repaired by a fast retransmit. */
+    uint32_t ulTimeouts;      /* Repaired after a time-out. */
+    uint32_t ulStalls;
+} TCPCongestionLosses_t;
+
+struct xTCP_CONGESTION
+{
+    Socket_t xSocket;
+    const TCPCongestionOps_t * pxOps;
+    uint32_t ulMSS;
+    uint32_t ulCwnd;
+    uint32_t ulSsthresh;
+    uint32_t ulCwndCredit;    /* Acked bytes not yet turned into cwnd. */
+
+    /* Stream accounting, see tcp_sendfile.c. */
+    uint32_t ulStreamQueued;
+    uint32_t ulStreamAcked;
+    TickType_t xLastProgress;
+    TickType_t xRTOStart;     /* Start of the running RTO. */
+    BaseType_t xTimedOut;     /* An RTO expired since xLastProgress. */
+
+    /* One RTT measurement at a time. */
+    BaseType_t xTiming;
+    uint32_t ulTimedPosition;
+    TickType_t xTimedSent;
+
+    /* Written by the tap, in the IP task. */
+    uint16_t usLocalPort;
+    uint16_t usRemotePort;
+    BaseType_t xSequenceKnown;
+    uint32_t ulHighestSequence;
+    volatile uint32_t ulRetransmitted; /* Retransmitted segments. */
+    volatile TickType_t xRetransmitTime;
+    volatile uint32_t ulRetransmitSpan; /* From it to the highest sent. */
+
+    /* The response to a loss lasts until ulRecoverPosition is acked. */
+    uint32_t ulRetransmitsHandled;
+    BaseType_t xInRecovery;
+    uint32_t ulRecoverPosition;
+
+    /* RTT estimators, RFC 6298. */
+    uint32_t ulSRTTMs;
+    uint32_t ulRTTVarMs;
+    uint32_t ulMinRTTMs;
+    uint32_t ulRTOMs;
+
+    /* Per-RTT state of "vegas". */
+    uint32_t ulVegasEnd;
+    uint32_t ulVegasMinRTTMs;
+
+    uint32_t ulBytesAcked;
+    uint32_t ulRecoveries;
+    uint32_t ulTimeouts;
+    uint32_t ulStalls;
+};
+
+extern const TCPCongestionOps_t xTCPCongestionReno;
+extern const TCPCongestionOps_t xTCPCongestionVegas;
+
+/**
+ * @brief Attach congestion control to a connected TCP socket.
+ *
+ * @param pxCC The state, owned by the caller.
+ * @param xSocket A connected TCP socket.
+ * @param pxOps The algorithm, or NULL for "reno".
+ */
+void vTCPCongestionInit( TCPCongestion_t * pxCC,
+                         Socket_t xSocket,
+                         const TCPCongestionOps_t * pxOps );
+
+/**
+ * @brief Stop following the retransmissions of a socket.  Call it before
+ * the socket is closed, or the state is reused.
+ */
+void vTCPCongestionDeinit( TCPCongestion_t * pxCC );
+
+/**
+ * @brief Look at the segments that leave through an interface, so that
+ * retransmissions are seen.  Call it once, after the interface descriptor
+ * was filled in, and before FreeRTOS_IPInit_Multi().
+ */
+void vTCPCongestionWatchInterface( NetworkInterface_t * pxInterface );
+
+/**
+ * @brief Select the algorithm of a socket by name, "reno" or "vegas".  The
+ * new algorithm starts from its initial window.
+ *
+ * @return pdPASS when the name is known, pdFAIL otherwise.
+ */
+BaseType_t xTCPCongestionSetAlgorithm( TCPCongestion_t * pxCC,
+                                       const char * pcName );
+
+/**
+ * @brief Process ACK progress and time-outs.  Called by
+ * ulTCPCongestionAllowance(), but may also be called periodically by the
+ * owner of the socket.
+ */
+void vTCPCongestionUpdate( TCPCongestion_t * pxCC );
+
+/**
+ * @brief Get the number of bytes that may be added to the TX stream now.
+ *
+ * @return cwnd minus the unacknowledged bytes, or 0.
+ */
+uint32_t ulTCPCongestionAllowance( TCPCongestion_t * pxCC );
+
+/**
+ * @brief Report that ulBytes were added to the TX stream.
+ */
+void vTCPCongestionSent( TCPCongestion_t * pxCC,
+                         uint32_t ulBytes );
+
+/**
+ * @brief Send no more than the congestion window allows.  All data must be
+ * sent through this function while congestion control is attached.
+ *
+ * @return Bytes sent (possibly 0 when cwnd is full), or a negative errno
+ * from FreeRTOS_send().
+ */
+BaseType_t xTCPCongestionSend( TCPCongestion_t * pxCC,
+                               const void * pvBuffer,
+                               size_t uxLength,
+                               BaseType_t xFlags );
+
+/**
+ * @brief Get the cwnd, ssthresh and RTT statistics of a socket.
+ */
+void vTCPCongestionGetStats( const TCPCongestion_t * pxCC,
+                             TCPCongestionStats_t * pxStats );
+
+/**
+ * @brief Get the losses of all sockets since start-up.
+ */
+void vTCPCongestionGetLosses( TCPCongestionLosses_t * pxLosses );
+
+/**
+ * @brief Log the losses of all sockets.
+ */
+void vTCPCongestionReport( void );
+
+#endif /* #ifndef TCP_CONGESTION_H */
@@ -1,6 +1,12 @@
+/* The log messages of this file, see log_levels.h. */
+#define logMODULE    eLogModuleEcho
+
 #include "FreeRTOS.h"
 #include "FreeRTOS_IP.h"
 
+#include "tcp_autotune.h"
+#include "net_services.h"
+
 #define echoNUM_ECHO_CLIENTS				1
 #define echoTCP_ECHO_SERVER_PORT			5050
 #define configTCP_ECHO_SERVER_ADDR			"192.168.0.100"
@@ -28,6 +34,11 @@ congested. */
 
 static void prvEchoClientTask( void *pvParameters );
 
+/* Set while the network that the echo server is on is down.  The tasks then
+wait for a notification from a resume instead of trying to connect. */
+static volatile BaseType_t xPaused = pdFALSE;
+static TaskHandle_t xEchoTasks[ echoNUM_ECHO_CLIENTS ] = { NULL };
+
 /* Rx and Tx buffers for each created task. */
 static char cTxBuffers[ echoNUM_ECHO_CLIENTS ][ echoBUFFER_SIZES ],
 			cRxBuffers[ echoNUM_ECHO_CLIENTS ][ echoBUFFER_SIZES ];
@@ -36,17 +47,36 @@ void vStartTCPEchoClientTasks_SingleTasks( uint16_t usTaskStackSize, UBaseType_t
 {
 BaseType_t x;
 
-	/* Create the echo client tasks. */
-	for( x = 0; x < echoNUM_ECHO_CLIENTS; x++ )
+	if( xEchoTasks[ 0 ] != NULL )
+	{
+		/* Started before, so this is a resume. */
+		xPaused = pdFALSE;
+
+		for( x = 0; x < echoNUM_ECHO_CLIENTS; x++ )
+		{
+			xTaskNotifyGive( xEchoTasks[ x ] );
+		}
+	}
+	else
 	{
-		xTaskCreate( 	prvEchoClientTask,	/* The function that implements the task. */
-						"Echo0",			/* Just a text name for the task to aid debugging. */
-						usTaskStackSize,	/* The stack size is defined in FreeRTOSIPConfig.h. */
-						( void * ) x,		/* The task parameter, not used in this case. */
-						uxTaskPriority,		/* The priority assigned to the task is defined in FreeRTOSConfig.h. */
-						NULL );				/* The task handle is not used. */
+		/* Create the echo client tasks. */
+		for( x = 0; x < echoNUM_ECHO_CLIENTS; x++ )
+		{
+			xTaskCreate( 	prvEchoClientTask,	/* The function that implements the task. */
+							"Echo0",			/* Just a text name for the task to aid debugging. */
+							usTaskStackSize,	/* The stack size is defined in FreeRTOSIPConfig.h. */
+							( void * ) x,		/* The task parameter, not used in this case. */
+							uxTaskPriority,		/* The priority assigned to the task is defined in FreeRTOSConfig.h. */
+							&( xEchoTasks[ x ] ) );	/* Needed to resume the task. */
+		}
 	}
 }
+/*-----------------------------------------------------------*/
+
+void vPauseTCPEchoClientTasks_SingleTasks( void )
+{
+	xPaused = pdTRUE;
+}
 
 /*-----------------------------------------------------------*/
 #if 0
@@ -95,17 +125,11 @@ static void prvEchoClientTask( void *pvParameters )
 	BaseType_t xReceivedBytes, xReturned, xInstance;
 	BaseType_t lTransmitted, lStringLength;
 	char *pcTransmittedString, *pcReceivedString;
-	WinProperties_t xWinProps;
+	TCPAutotune_t xAutotune;
 	TickType_t xTimeOnEntering;
     BaseType_t xFamily = FREERTOS_AF_INET;
     uint8_t ucIPType = ipTYPE_IPv4;
 
-	/* Fill in the buffer and window sizes that will be used by the socket. */
-	xWinProps.lTxBufSize = 6 * ipconfigTCP_MSS;
-	xWinProps.lTxWinSize = 3;
-	xWinProps.lRxBufSize = 6 * ipconfigTCP_MSS;
-	xWinProps.lRxWinSize = 3;
-
 	/* This task can be created a number of times.  Each instance is numbered
 	to enable each instance to use a different Rx and Tx buffer.  The number is
 	passed in as the task's parameter. */
@@ -139,6 +163,12 @@ static void prvEchoClientTask( void *pvParameters )
 
 	for( ;; )
 	{
+		/* Do not try to connect while paused. */
+		while( xPaused != pdFALSE )
+		{
+			( void ) ulTaskNotifyTake( pdTRUE, portMAX_DELAY );
+		}
+
 		/* Create a TCP socket. */
 		xSocket = FreeRTOS_socket( xFamily, FREERTOS_SOCK_STREAM, FREERTOS_IPPROTO_TCP );
 		configASSERT( xSocket != FREERTOS_INVALID_SOCKET );
@@ -148,19 +178,20 @@ static void prvEchoClientTask( void *pvParameters )
 		FreeRTOS_setsockopt( xSocket, 0, FREERTOS_SO_RCVTIMEO, &xReceiveTimeOut, sizeof( xReceiveTimeOut ) );
 		FreeRTOS_setsockopt( xSocket, 0, FREERTOS_SO_SNDTIMEO, &xSendTimeOut, sizeof( xSendTimeOut ) );
 
-		/* Set the window and buffer sizes. */
-		FreeRTOS_setsockopt( xSocket, 0, FREERTOS_SO_WIN_PROPERTIES, ( void * ) &xWinProps,	sizeof( xWinProps ) );
-
-		/* Connect to the echo server. */
-		if( FreeRTOS_connect( xSocket, &xEchoServerAddress, sizeof( xEchoServerAddress ) ) == 0 )
+		/* Set the window and buffer sizes, based on what was learned from
+		earlier connections to the echo server.  When the memory budget is used
+		up, skip this round. */
+		if( ( xTCPAutotuneApply( &xAutotune, xSocket, &xEchoServerAddress ) == 0 ) &&
+			( FreeRTOS_connect( xSocket, &xEchoServerAddress, sizeof( xEchoServerAddress ) ) == 0 ) )
 		{
 			ulConnections[ xInstance ]++;
+			vTCPAutotuneConnected( &xAutotune );
 
 			/* Send a number of echo requests. */
-			for( lLoopCount = 0; lLoopCount < lMaxLoopCount; lLoopCount++ )
+			for( lLoopCount = 0; ( lLoopCount < lMaxLoopCount ) && ( xPaused == pdFALSE ); lLoopCount++ )
 			{
 				/* Create the string that is sent to the echo server. */
-				sprintf( pcTransmittedString, "TxRx message number %lu", ulTxCount );
+				snprintf( pcTransmittedString, sizeof( cTxBuffers[ 0 ] ), "TxRx message number %lu", ulTxCount );
 				lStringLength = strlen(pcTransmittedString);
 				ulTxCount++;
 
@@ -176,6 +207,8 @@ static void prvEchoClientTask( void *pvParameters )
 					break;
 				}
 
+				vTCPAutotuneTransferred( &xAutotune, ( size_t ) lTransmitted );
+
 				/* Clear the buffer into which the echoed string will be
 				placed. */
 				memset( ( void * ) pcReceivedString, 0x00, echoBUFFER_SIZES );
@@ -205,6 +238,7 @@ static void prvEchoClientTask( void *pvParameters )
 					{
 						/* Keep a count of the bytes received so far. */
 						xReceivedBytes += xReturned;
+						vTCPAutotuneTransferred( &xAutotune, ( size_t ) xReturned );
 					}
 				}
 
@@ -219,6 +253,7 @@ static void prvEchoClientTask( void *pvParameters )
 					{
 						/* The echo reply was received without error. */
 						ulTxRxCycles[ xInstance ]++;
+						vNetServicesFirstPacket( "TCP echo" );
 					}
 					else
 					{
@@ -240,6 +275,15 @@ static void prvEchoClientTask( void *pvParameters )
 				}
 			}
 
+			#if( ipconfigHAS_DEBUG_PRINTF == 1 )
+			{
+				TCPAutotuneStatus_t xStatus;
+
+				vTCPAutotuneGetStatus( &xAutotune, &xStatus );
+				FreeRTOS_debug_printf( ( "Echo: buffers %d bytes, rtt %lu ms, %lu B/s\n", ( int ) xStatus.lRxBufSize, xStatus.ulRTTMs, xStatus.ulRateBytesPerSec ) );
+			}
+			#endif
+
 			/* Finished using the connected socket, initiate a graceful close:
 			FIN, FIN+ACK, ACK. */
 			FreeRTOS_shutdown( xSocket, FREERTOS_SHUT_RDWR );
@@ -262,7 +306,9 @@ static void prvEchoClientTask( void *pvParameters )
 			} while( ( xTaskGetTickCount() - xTimeOnEntering ) < xReceiveTimeOut );
 		}
 
-		/* Close this socket before looping back to create another. */
+		/* Close this socket before looping back to create another.  The
+		measurements are kept for the next connection. */
+		vTCPAutotuneRelease( &xAutotune );
 		FreeRTOS_closesocket( xSocket );
 
 		/* Pause for a short while to ensure the network is not too
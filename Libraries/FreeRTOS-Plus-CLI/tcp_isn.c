@@ -0,0 +1,201 @@
+/* The log messages of this file, see log_levels.h. */
+#define logMODULE    eLogModuleApp
+
+/* Standard includes. */
+#include <string.h>
+
+/* FreeRTOS includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+#include "timers.h"
+
+/* FreeRTOS+TCP includes. */
+#include "FreeRTOS_IP.h"
+
+/* ST includes. */
+#include "stm32h7xx_hal.h"
+
+#include "tcp_isn.h"
+#include "entropy_pool.h"
+#include "uptime.h"
+
+/* Retry period while the entropy pool did not deliver a key. */
+#define isnRETRY_PERIOD_MS    1000UL
+
+#define isnROTL( x, b )    ( uint64_t ) ( ( ( x ) << ( b ) ) | ( ( x ) >> ( 64 - ( b ) ) ) )
+
+#define isnSIPROUND( v0, v1, v2, v3 ) \
+    do {                              \
+        v0 += v1;                     \
+        v1 = isnROTL( v1, 13 );       \
+        v1 ^= v0;                     \
+        v0 = isnROTL( v0, 32 );       \
+        v2 += v3;                     \
+        v3 = isnROTL( v3, 16 );       \
+        v3 ^= v2;                     \
+        v0 += v3;                     \
+        v3 = isnROTL( v3, 21 );       \
+        v3 ^= v0;                     \
+        v2 += v1;                     \
+        v1 = isnROTL( v1, 17 );       \
+        v1 ^= v2;                     \
+        v2 = isnROTL( v2, 32 );       \
+    } while( 0 )
+
+/*
+ * SipHash-2-4 of the 12-byte message { ulWord0, ulWord1, ulWord2 }.
+ */
+static uint64_t prvSipHash( const uint64_t * pullKey,
+                            uint32_t ulWord0,
+                            uint32_t ulWord1,
+                            uint32_t ulWord2 );
+
+/*
+ * Get a new key from the entropy pool, returns pdFAIL when it is not seeded.
+ */
+static BaseType_t prvReadKey( void );
+
+/*
+ * Replace the key now and then.
+ */
+static void prvRekeyTimerCallback( TimerHandle_t xTimer );
+
+/*-----------------------------------------------------------*/
+
+static uint64_t ullKey[ 2 ];
+
+static TimerHandle_t xRekeyTimer = NULL;
+
+/*-----------------------------------------------------------*/
+
+static uint64_t prvSipHash( const uint64_t * pullKey,
+                            uint32_t ulWord0,
+                            uint32_t ulWord1,
+                            uint32_t ulWord2 )
+{
+    uint64_t v0 = pullKey[ 0 ] ^ 0x736F6D6570736575ULL;
+    uint64_t v1 = pullKey[ 1 ] ^ 0x646F72616E646F6DULL;
+    uint64_t v2 = pullKey[ 0 ] ^ 0x6C7967656E657261ULL;
+    uint64_t v3 = pullKey[ 1 ] ^ 0x7465646279746573ULL;
+    uint64_t ullMessage;
+
+    /* The first 8 bytes, little endian. */
+    ullMessage = ( uint64_t ) ulWord0 | ( ( uint64_t ) ulWord1 << 32 );
+    v3 ^= ullMessage;
+    isnSIPROUND( v0, v1, v2, v3 );
+    isnSIPROUND( v0, v1, v2, v3 );
+    v0 ^= ullMessage;
+
+    /* The last 4 bytes, with the message length in the top byte. */
+    ullMessage = ( uint64_t ) ulWord2 | ( 12ULL << 56 );
+    v3 ^= ullMessage;
+    isnSIPROUND( v0, v1, v2, v3 );
+    isnSIPROUND( v0, v1, v2, v3 );
+    v0 ^= ullMessage;
+
+    v2 ^= 0xFFU;
+    isnSIPROUND( v0, v1, v2, v3 );
+    isnSIPROUND( v0, v1, v2, v3 );
+    isnSIPROUND( v0, v1, v2, v3 );
+    isnSIPROUND( v0, v1, v2, v3 );
+
+    return v0 ^ v1 ^ v2 ^ v3;
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvReadKey( void )
+{
+    uint32_t ulWords[ 4 ];
+    BaseType_t xReturn;
+
+    xReturn = xEntropyPoolRandom( ulWords, sizeof( ulWords ) );
+
+    if( xReturn == pdPASS )
+    {
+        taskENTER_CRITICAL();
+        {
+            ullKey[ 0 ] = ( uint64_t ) ulWords[ 0 ] | ( ( uint64_t ) ulWords[ 1 ] << 32 );
+            ullKey[ 1 ] = ( uint64_t ) ulWords[ 2 ] | ( ( uint64_t ) ulWords[ 3 ] << 32 );
+        }
+        taskEXIT_CRITICAL();
+    }
+
+    memset( ulWords, 0, sizeof( ulWords ) );
+
+    return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+static void prvRekeyTimerCallback( TimerHandle_t xTimer )
+{
+    if( prvReadKey() == pdPASS )
+    {
+        #if ( configTCP_ISN_REKEY_PERIOD_MS != 0 )
+            if( xTimerGetPeriod( xTimer ) != pdMS_TO_TICKS( configTCP_ISN_REKEY_PERIOD_MS ) )
+            {
+                ( void ) xTimerChangePeriod( xTimer, pdMS_TO_TICKS( configTCP_ISN_REKEY_PERIOD_MS ), 0U );
+            }
+        #else
+            ( void ) xTimerStop( xTimer, 0U );
+        #endif
+    }
+    else
+    {
+        /* Keep the old key, and try again soon. */
+        ( void ) xTimerChangePeriod( xTimer, pdMS_TO_TICKS( isnRETRY_PERIOD_MS ), 0U );
+    }
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xTCPISNInitialise( void )
+{
+    TickType_t xPeriod = pdMS_TO_TICKS( configTCP_ISN_REKEY_PERIOD_MS );
+    BaseType_t xReturn = pdPASS;
+
+    if( prvReadKey() == pdFAIL )
+    {
+        /* Better than nothing until the pool is seeded: the 96-bit unique device
+         * ID and the time. */
+        ullKey[ 0 ] = ( ( uint64_t ) HAL_GetUIDw0() << 32 ) ^ HAL_GetUIDw1() ^ SysTick->VAL;
+        ullKey[ 1 ] = ( ( uint64_t ) HAL_GetUIDw2() << 32 ) ^ HAL_GetTick();
+        xPeriod = pdMS_TO_TICKS( isnRETRY_PERIOD_MS );
+        LogWarn( ( "TCP ISN: no entropy, using a weak key for now\n" ) );
+    }
+
+    if( xPeriod != 0U )
+    {
+        xRekeyTimer = xTimerCreate( "ISNKey", xPeriod, pdTRUE, NULL, prvRekeyTimerCallback );
+
+        if( ( xRekeyTimer == NULL ) || ( xTimerStart( xRekeyTimer, 0U ) != pdPASS ) )
+        {
+            xReturn = pdFAIL;
+        }
+    }
+
+    return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+uint32_t ulTCPISNGenerate( uint32_t ulSourceAddress,
+                           uint16_t usSourcePort,
+                           uint32_t ulDestinationAddress,
+                           uint16_t usDestinationPort )
+{
+    uint64_t ullCopy[ 2 ];
+    uint32_t ulHash;
+
+    taskENTER_CRITICAL();
+    {
+        ullCopy[ 0 ] = ullKey[ 0 ];
+        ullCopy[ 1 ] = ullKey[ 1 ];
+    }
+    taskEXIT_CRITICAL();
+
+    ulHash = ( uint32_t ) prvSipHash( ullCopy,
+                                      ulSourceAddress,
+                                      ulDestinationAddress,
+                                      ( ( uint32_t ) usSourcePort << 16 ) | usDestinationPort );
+
+    return ulUptimeMicroseconds() + ulHash;
+}
+/*-----------------------------------------------------------*/
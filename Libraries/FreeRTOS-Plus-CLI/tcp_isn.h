@@ -0,0 +1,46 @@
+#ifndef TCP_ISN_H
+#define TCP_ISN_H
+
+/* FreeRTOS includes. */
+#include "FreeRTOS.h"
+
+/*
+ * TCP initial sequence numbers as in RFC 6528:
+ *
+ *     ISN = M + F( local IP, local port, remote IP, remote port, key )
+ *
+ * M is a clock that ticks every microsecond, and F is SipHash-2-4 with a
+ * 128-bit secret key.  So the ISNs of one connection 4-tuple keep increasing,
+ * while an off-path attacker cannot predict them.
+ *
+ * The key is taken from the entropy pool by xTCPISNInitialise(), and then
+ * replaced by a timer every configTCP_ISN_REKEY_PERIOD_MS.  A new key makes
+ * the ISNs of a 4-tuple jump, so the period should be well above 2 * MSL.
+ * Generating an ISN never waits for the RNG and never fails.
+ */
+
+/* Time between two key changes, 0 to keep the first key. */
+#ifndef configTCP_ISN_REKEY_PERIOD_MS
+    #define configTCP_ISN_REKEY_PERIOD_MS    ( 60UL * 60UL * 1000UL )
+#endif
+
+/**
+ * @brief Read the first key and start the rekey timer.  Must be called
+ * before FreeRTOS_IPInit(), after xEntropyPoolInitialise().
+ *
+ * @return pdPASS if success, pdFAIL when the timer could not be created.
+ */
+BaseType_t xTCPISNInitialise( void );
+
+/**
+ * @brief Get the initial sequence number of a new connection.
+ *
+ * Addresses and ports may be in any byte order, as long as it is always the
+ * same one.
+ */
+uint32_t ulTCPISNGenerate( uint32_t ulSourceAddress,
+                           uint16_t usSourcePort,
+                           uint32_t ulDestinationAddress,
+                           uint16_t usDestinationPort );
+
+#endif /* #ifndef TCP_ISN_H */
@@ -0,0 +1,158 @@
+/* Standard includes. */
+#include <string.h>
+
+/* FreeRTOS includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+#include "semphr.h"
+
+/* FreeRTOS+TCP includes. */
+#include "FreeRTOS_IP.h"
+#include "FreeRTOS_Sockets.h"
+
+#include "tcp_rx_batch.h"
+
+#if ( ipconfigSOCKET_HAS_USER_WAKE_CALLBACK == 0 )
+    #error tcp_rx_batch needs ipconfigSOCKET_HAS_USER_WAKE_CALLBACK
+#endif
+
+/*
+ * The wake-up callback of the sockets, called by the IP-task.
+ */
+static void prvWakeUp( Socket_t xSocket );
+
+/*-----------------------------------------------------------*/
+
+/* The callback only gets the socket. */
+static TCPRxBatch_t * pxBatches[ configTCP_RX_BATCH_MAX_SOCKETS ];
+
+/*-----------------------------------------------------------*/
+
+static void prvWakeUp( Socket_t xSocket )
+{
+    TCPRxBatch_t * pxBatch = NULL;
+    size_t x;
+
+    for( x = 0; x < configTCP_RX_BATCH_MAX_SOCKETS; x++ )
+    {
+        if( ( pxBatches[ x ] != NULL ) && ( pxBatches[ x ]->xSocket == xSocket ) )
+        {
+            pxBatch = pxBatches[ x ];
+            break;
+        }
+    }
+
+    if( pxBatch != NULL )
+    {
+        pxBatch->ulEvents++;
+
+        if( ( ( size_t ) FreeRTOS_rx_size( xSocket ) >= pxBatch->uxThreshold ) ||
+            ( FreeRTOS_issocketconnected( xSocket ) != pdTRUE ) )
+        {
+            pxBatch->ulWakeUps++;
+            ( void ) xSemaphoreGive( pxBatch->xWakeUp );
+        }
+    }
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xTCPRxBatchInit( TCPRxBatch_t * pxBatch,
+                            Socket_t xSocket,
+                            SemaphoreHandle_t xWakeUp,
+                            size_t uxThreshold )
+{
+    BaseType_t xReturn = pdFAIL;
+    size_t x;
+
+    configASSERT( ( pxBatch != NULL ) && ( xWakeUp != NULL ) );
+
+    memset( pxBatch, 0, sizeof( *pxBatch ) );
+    pxBatch->xSocket = xSocket;
+    pxBatch->xWakeUp = xWakeUp;
+    pxBatch->uxThreshold = ( uxThreshold > 0U ) ? uxThreshold : 1U;
+
+    /* The IP-task reads the table without a lock: an entry is filled in
+     * before the callback is installed, and cleared after it is removed. */
+    taskENTER_CRITICAL();
+    {
+        for( x = 0; x < configTCP_RX_BATCH_MAX_SOCKETS; x++ )
+        {
+            if( pxBatches[ x ] == NULL )
+            {
+                pxBatches[ x ] = pxBatch;
+                xReturn = pdPASS;
+                break;
+            }
+        }
+    }
+    taskEXIT_CRITICAL();
+
+    if( xReturn == pdPASS )
+    {
+        ( void ) FreeRTOS_setsockopt( xSocket, 0, FREERTOS_SO_WAKEUP_CALLBACK, ( void * ) prvWakeUp, sizeof( void * ) );
+    }
+    else
+    {
+        pxBatch->xSocket = FREERTOS_INVALID_SOCKET;
+    }
+
+    return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xTCPRxBatchReceive( TCPRxBatch_t * pxBatch,
+                               void * pvBuffer,
+                               size_t uxBufferLength )
+{
+    BaseType_t xResult;
+
+    configASSERT( pxBatch != NULL );
+
+    xResult = FreeRTOS_recv( pxBatch->xSocket, pvBuffer, uxBufferLength, FREERTOS_MSG_DONTWAIT );
+
+    if( xResult == -pdFREERTOS_ERRNO_EWOULDBLOCK )
+    {
+        xResult = 0;
+    }
+
+    if( xResult > 0 )
+    {
+        pxBatch->ulReads++;
+        pxBatch->ulBytes += ( uint32_t ) xResult;
+
+        if( ( uint32_t ) xResult > pxBatch->ulLargestRead )
+        {
+            pxBatch->ulLargestRead = ( uint32_t ) xResult;
+        }
+    }
+
+    return xResult;
+}
+/*-----------------------------------------------------------*/
+
+void vTCPRxBatchDetach( TCPRxBatch_t * pxBatch )
+{
+    size_t x;
+
+    configASSERT( pxBatch != NULL );
+
+    if( pxBatch->xSocket != FREERTOS_INVALID_SOCKET )
+    {
+        ( void ) FreeRTOS_setsockopt( pxBatch->xSocket, 0, FREERTOS_SO_WAKEUP_CALLBACK, NULL, sizeof( void * ) );
+
+        taskENTER_CRITICAL();
+        {
+            for( x = 0; x < configTCP_RX_BATCH_MAX_SOCKETS; x++ )
+            {
+                if( pxBatches[ x ] == pxBatch )
+                {
+                    pxBatches[ x ] = NULL;
+                }
+            }
+        }
+        taskEXIT_CRITICAL();
+
+        pxBatch->xSocket = FREERTOS_INVALID_SOCKET;
+    }
+}
+/*-----------------------------------------------------------*/
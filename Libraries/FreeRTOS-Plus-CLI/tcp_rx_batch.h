@@ -0,0 +1,88 @@
+#ifndef TCP_RX_BATCH_H
+#define TCP_RX_BATCH_H
+
+/* Kernel includes. */
+#include "FreeRTOS.h"
+#include "semphr.h"
+
+/* FreeRTOS+TCP includes. */
+#include "FreeRTOS_IP.h"
+#include "FreeRTOS_Sockets.h"
+
+/*
+ * Batched reception for bulk TCP readers.
+ *
+ * The IP-task wakes the owner of a socket just before it goes to sleep, so
+ * the segments that it processed in one go cause one wake-up.  For bulk
+ * receive that is still one wake-up for every one or two segments, each
+ * followed by a FreeRTOS_recv() that opens the receive window a little.
+ *
+ * This module installs a wake-up callback (FREERTOS_SO_WAKEUP_CALLBACK).  It
+ * runs in the IP-task on every socket event, and gives the reader's semaphore
+ * only when uxThreshold bytes are waiting in the stream, or the connection is
+ * gone.  The reader then takes all of it with xTCPRxBatchReceive(): one
+ * wake-up, and one window update and ACK decision by the stack, per batch of
+ * segments.  Data below the threshold is taken when the reader's own wait for
+ * the semaphore times out, so the threshold must be well below the receive
+ * window, or the peer stops sending before the reader wakes.
+ *
+ * Several batches may share one semaphore, and other sockets may give it
+ * with FREERTOS_SO_SET_SEMAPHORE.  The segment boundaries are not kept by the
+ * stream, the statistics count socket events and bytes: ulEvents / ulWakeUps
+ * is the number of deliveries merged into one wake-up.
+ */
+
+/* Sockets that can have a batch at the same time. */
+#ifndef configTCP_RX_BATCH_MAX_SOCKETS
+    #define configTCP_RX_BATCH_MAX_SOCKETS    4U
+#endif
+
+typedef struct xTCP_RX_BATCH
+{
+    Socket_t xSocket;
+    SemaphoreHandle_t xWakeUp;  /* Given when a batch is ready. */
+    size_t uxThreshold;         /* Bytes that make a batch. */
+
+    /* Written by the IP-task. */
+    volatile uint32_t ulEvents; /* Socket events seen. */
+    volatile uint32_t ulWakeUps;
+
+    /* Written by the reader. */
+    uint32_t ulReads;           /* Calls that returned data. */
+    uint32_t ulBytes;
+    uint32_t ulLargestRead;     /* In bytes. */
+} TCPRxBatch_t;
+
+/**
+ * @brief Attach a batch to a connected TCP socket.
+ *
+ * @param pxBatch The batch to initialise, owned by the caller.
+ * @param xSocket A connected TCP socket.
+ * @param xWakeUp The semaphore that the reader waits for.
+ * @param uxThreshold Wake the reader when this many bytes are waiting.
+ *
+ * @return pdPASS, or pdFAIL when configTCP_RX_BATCH_MAX_SOCKETS batches are
+ * attached already.
+ */
+BaseType_t xTCPRxBatchInit( TCPRxBatch_t * pxBatch,
+                            Socket_t xSocket,
+                            SemaphoreHandle_t xWakeUp,
+                            size_t uxThreshold );
+
+/**
+ * @brief Take all that is waiting, without blocking.
+ *
+ * @return The number of bytes received, 0 when nothing was waiting, or a
+ * negative FreeRTOS errno as returned by FreeRTOS_recv().
+ */
+BaseType_t xTCPRxBatchReceive( TCPRxBatch_t * pxBatch,
+                               void * pvBuffer,
+                               size_t uxBufferLength );
+
+/**
+ * @brief Detach the batch from its socket.  Must be called before the socket
+ * is closed.
+ */
+void vTCPRxBatchDetach( TCPRxBatch_t * pxBatch );
+
+#endif /* #ifndef TCP_RX_BATCH_H */
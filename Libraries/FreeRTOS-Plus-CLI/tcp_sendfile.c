@@ -0,0 +1,446 @@
+/* Standard includes. */
+#include <string.h>
+
+/* FreeRTOS includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+#include "semphr.h"
+
+/* FreeRTOS+TCP includes. */
+#include "FreeRTOS_IP.h"
+#include "FreeRTOS_Sockets.h"
+
+#include "tcp_sendfile.h"
+
+/* FreeRTOS_send() returns one of these when the TX stream is full. */
+#define sendfileIS_NO_SPACE( xResult )                       \
+    ( ( ( xResult ) == 0 ) ||                                \
+      ( ( xResult ) == -pdFREERTOS_ERRNO_ENOSPC ) ||         \
+      ( ( xResult ) == -pdFREERTOS_ERRNO_EWOULDBLOCK ) )
+
+/* Size of the buffer for the first write of a produced region, made before
+ * the socket has a TX stream. */
+#define sendfileFIRST_WRITE_SIZE    32U
+
+/*
+ * Write as much of the pending regions into the TX stream as it will take.
+ * Returns the number of bytes written, or a negative errno.
+ */
+static BaseType_t prvFillStream( TCPTxQueue_t * pxQueue );
+
+/*
+ * Write up to uxLength bytes of a region at the head of the TX stream and
+ * commit them.  Returns the result of FreeRTOS_send().
+ */
+static BaseType_t prvWriteRegion( TCPTxQueue_t * pxQueue,
+                                  TCPTxRegion_t * pxRegion,
+                                  size_t uxLength );
+
+/*
+ * Put the next uxLength bytes of a region at pucDestination.
+ */
+static void prvProduce( TCPTxRegion_t * pxRegion,
+                        uint8_t * pucDestination,
+                        size_t uxLength );
+
+/*
+ * Complete all regions of which the last byte has been acknowledged.
+ * Returns the number of regions completed.
+ */
+static BaseType_t prvReapAcknowledged( TCPTxQueue_t * pxQueue );
+
+/*
+ * Unlink the oldest region and call its callback.
+ */
+static void prvCompleteHead( TCPTxQueue_t * pxQueue,
+                             BaseType_t xStatus );
+
+/*
+ * Switch FREERTOS_SO_SET_FULL_SIZE on or off, when it changes.
+ */
+static void prvSetFullSize( TCPTxQueue_t * pxQueue,
+                            BaseType_t xFullSize );
+
+/*-----------------------------------------------------------*/
+
+void vTCPTxQueueInit( TCPTxQueue_t * pxQueue,
+                      Socket_t xSocket )
+{
+    configASSERT( pxQueue != NULL );
+    configASSERT( xSocket != FREERTOS_INVALID_SOCKET );
+
+    memset( pxQueue, 0, sizeof( *pxQueue ) );
+    pxQueue->xSocket = xSocket;
+    pxQueue->xSemaphore = xSemaphoreCreateBinaryStatic( &( pxQueue->xSemaphoreBuffer ) );
+
+    /* The IP-task will give the semaphore on every socket event, including
+     * the arrival of an ACK that frees space in the TX stream. */
+    FreeRTOS_setsockopt( xSocket, 0, FREERTOS_SO_SET_SEMAPHORE, ( void * ) &( pxQueue->xSemaphore ), sizeof( pxQueue->xSemaphore ) );
+}
+/*-----------------------------------------------------------*/
+
+void vTCPTxQueueSetCongestion( TCPTxQueue_t * pxQueue,
+                               TCPCongestion_t * pxCC )
+{
+    configASSERT( pxQueue != NULL );
+
+    pxQueue->pxCongestion = pxCC;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xTCPTxQueueRegion( TCPTxQueue_t * pxQueue,
+                              TCPTxRegion_t * pxRegion )
+{
+    BaseType_t xReturn = pdFAIL;
+
+    if( ( pxRegion != NULL ) && ( pxRegion->uxLength > 0U ) )
+    {
+        pxRegion->uxOffset = 0U;
+        pxRegion->ulStreamEnd = 0U;
+        pxRegion->pxNext = NULL;
+
+        if( pxQueue->pxTail == NULL )
+        {
+            pxQueue->pxHead = pxRegion;
+        }
+        else
+        {
+            pxQueue->pxTail->pxNext = pxRegion;
+        }
+
+        pxQueue->pxTail = pxRegion;
+
+        if( pxQueue->pxSending == NULL )
+        {
+            pxQueue->pxSending = pxRegion;
+        }
+
+        xReturn = pdPASS;
+    }
+
+    return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+static void prvSetFullSize( TCPTxQueue_t * pxQueue,
+                            BaseType_t xFullSize )
+{
+    if( pxQueue->xFullSize != xFullSize )
+    {
+        pxQueue->xFullSize = xFullSize;
+
+        /* Clearing the option makes the IP-task send what is left over. */
+        FreeRTOS_setsockopt( pxQueue->xSocket, 0, FREERTOS_SO_SET_FULL_SIZE, ( void * ) &xFullSize, sizeof( xFullSize ) );
+    }
+}
+/*-----------------------------------------------------------*/
+
+static void prvProduce( TCPTxRegion_t * pxRegion,
+                        uint8_t * pucDestination,
+                        size_t uxLength )
+{
+    if( pxRegion->pucData != NULL )
+    {
+        memcpy( pucDestination, &( pxRegion->pucData[ pxRegion->uxOffset ] ), uxLength );
+    }
+    else if( pxRegion->fnFill != NULL )
+    {
+        pxRegion->fnFill( pxRegion, pucDestination, pxRegion->uxOffset, uxLength );
+    }
+    else
+    {
+        /* The bytes in the stream are sent as they are. */
+    }
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvWriteRegion( TCPTxQueue_t * pxQueue,
+                                  TCPTxRegion_t * pxRegion,
+                                  size_t uxLength )
+{
+    uint8_t ucFirst[ sendfileFIRST_WRITE_SIZE ];
+    const uint8_t * pucSource = NULL;
+    uint8_t * pucHead;
+    BaseType_t xHeadLength = 0;
+    BaseType_t xResult = 0;
+
+    pucHead = FreeRTOS_get_tx_head( pxQueue->xSocket, &xHeadLength );
+
+    if( pucHead != NULL )
+    {
+        /* The data goes from its origin directly into the TX stream, up to
+         * the end of the stream's buffer.  The rest is written at the start of
+         * the buffer in the next round. */
+        if( uxLength > ( size_t ) xHeadLength )
+        {
+            uxLength = ( xHeadLength > 0 ) ? ( size_t ) xHeadLength : 0U;
+        }
+
+        if( uxLength > 0U )
+        {
+            prvProduce( pxRegion, pucHead, uxLength );
+            xResult = FreeRTOS_send( pxQueue->xSocket, NULL, uxLength, FREERTOS_MSG_DONTWAIT );
+        }
+    }
+    else
+    {
+        /* There is no TX stream yet, the first FreeRTOS_send() creates it. */
+        if( pxRegion->pucData != NULL )
+        {
+            pucSource = &( pxRegion->pucData[ pxRegion->uxOffset ] );
+        }
+        else
+        {
+            if( uxLength > sizeof( ucFirst ) )
+            {
+                uxLength = sizeof( ucFirst );
+            }
+
+            memset( ucFirst, 0, sizeof( ucFirst ) );
+            prvProduce( pxRegion, ucFirst, uxLength );
+            pucSource = ucFirst;
+        }
+
+        xResult = FreeRTOS_send( pxQueue->xSocket, pucSource, uxLength, FREERTOS_MSG_DONTWAIT );
+    }
+
+    return xResult;
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvFillStream( TCPTxQueue_t * pxQueue )
+{
+    BaseType_t xTotal = 0;
+    BaseType_t xResult;
+    BaseType_t xSpace;
+    BaseType_t xMSS;
+    size_t uxLength;
+    size_t uxAllowed;
+    TCPTxRegion_t * pxRegion;
+
+    if( pxQueue->pxSending != NULL )
+    {
+        prvSetFullSize( pxQueue, pdTRUE );
+    }
+
+    xMSS = FreeRTOS_mss( pxQueue->xSocket );
+
+    while( pxQueue->pxSending != NULL )
+    {
+        pxRegion = pxQueue->pxSending;
+        uxLength = pxRegion->uxLength - pxRegion->uxOffset;
+        xSpace = FreeRTOS_tx_space( pxQueue->xSocket );
+
+        /* When the rest does not fit, only fill whole segments.  A write of a
+         * few bytes would wake the IP-task for nothing, as it holds back
+         * partial segments now. */
+        if( ( xSpace >= 0 ) && ( xMSS > 0 ) && ( uxLength > ( size_t ) xSpace ) )
+        {
+            uxLength = ( size_t ) xSpace - ( ( size_t ) xSpace % ( size_t ) xMSS );
+
+            if( uxLength == 0U )
+            {
+                break;
+            }
+        }
+
+        if( pxQueue->pxCongestion != NULL )
+        {
+            /* The same rule for the congestion window. */
+            uxAllowed = ( size_t ) ulTCPCongestionAllowance( pxQueue->pxCongestion );
+
+            if( uxLength > uxAllowed )
+            {
+                uxLength = ( xMSS > 0 ) ? ( uxAllowed - ( uxAllowed % ( size_t ) xMSS ) ) : uxAllowed;
+
+                if( uxLength == 0U )
+                {
+                    break;
+                }
+            }
+        }
+
+        xResult = prvWriteRegion( pxQueue, pxRegion, uxLength );
+
+        if( xResult > 0 )
+        {
+            pxRegion->uxOffset += ( size_t ) xResult;
+            pxQueue->ulStreamQueued += ( uint32_t ) xResult;
+            xTotal += xResult;
+
+            if( pxQueue->pxCongestion != NULL )
+            {
+                vTCPCongestionSent( pxQueue->pxCongestion, ( uint32_t ) xResult );
+            }
+
+            if( pxRegion->uxOffset == pxRegion->uxLength )
+            {
+                pxRegion->ulStreamEnd = pxQueue->ulStreamQueued;
+                pxQueue->pxSending = pxRegion->pxNext;
+            }
+        }
+        else
+        {
+            if( sendfileIS_NO_SPACE( xResult ) == pdFALSE )
+            {
+                /* Connection lost or reset. */
+                xTotal = xResult;
+            }
+
+            break;
+        }
+    }
+
+    if( ( pxQueue->pxSending == NULL ) && ( xTotal >= 0 ) )
+    {
+        /* Everything is in the stream, let the last segment go. */
+        prvSetFullSize( pxQueue, pdFALSE );
+    }
+
+    return xTotal;
+}
+/*-----------------------------------------------------------*/
+
+static void prvCompleteHead( TCPTxQueue_t * pxQueue,
+                             BaseType_t xStatus )
+{
+    TCPTxRegion_t * pxRegion = pxQueue->pxHead;
+
+    pxQueue->pxHead = pxRegion->pxNext;
+
+    if( pxQueue->pxHead == NULL )
+    {
+        pxQueue->pxTail = NULL;
+    }
+
+    if( pxQueue->pxSending == pxRegion )
+    {
+        pxQueue->pxSending = pxRegion->pxNext;
+    }
+
+    pxRegion->pxNext = NULL;
+
+    if( xStatus == pdPASS )
+    {
+        pxQueue->ulRegionsDone++;
+    }
+    else
+    {
+        pxQueue->ulRegionsFailed++;
+    }
+
+    /* The region is handed back to its owner. */
+    if( pxRegion->fnCallback != NULL )
+    {
+        pxRegion->fnCallback( pxRegion, xStatus );
+    }
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvReapAcknowledged( TCPTxQueue_t * pxQueue )
+{
+    BaseType_t xCompleted = 0;
+    BaseType_t xOutstanding;
+    TCPTxRegion_t * pxRegion;
+
+    /* The TX stream only holds data of this queue, so everything that was
+     * written and is no longer outstanding has been acknowledged. */
+    xOutstanding = FreeRTOS_outstanding( pxQueue->xSocket );
+
+    if( xOutstanding >= 0 )
+    {
+        pxQueue->ulStreamAcked = pxQueue->ulStreamQueued - ( uint32_t ) xOutstanding;
+    }
+
+    if( pxQueue->pxCongestion != NULL )
+    {
+        /* Also when the TX stream is full and nothing is written. */
+        vTCPCongestionUpdate( pxQueue->pxCongestion );
+    }
+
+    while( pxQueue->pxHead != NULL )
+    {
+        pxRegion = pxQueue->pxHead;
+
+        /* Only a region that is completely in the stream can be finished.
+         * The stream counters wrap, so compare their difference. */
+        if( ( pxRegion->uxOffset != pxRegion->uxLength ) ||
+            ( ( int32_t ) ( pxQueue->ulStreamAcked - pxRegion->ulStreamEnd ) < 0 ) )
+        {
+            break;
+        }
+
+        prvCompleteHead( pxQueue, pdPASS );
+        xCompleted++;
+    }
+
+    return xCompleted;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xTCPTxQueueProcess( TCPTxQueue_t * pxQueue,
+                               TickType_t xBlockTime )
+{
+    BaseType_t xWritten;
+    BaseType_t xCompleted;
+    BaseType_t xPending = 0;
+    TCPTxRegion_t * pxRegion;
+
+    configASSERT( pxQueue != NULL );
+
+    /* Consume a pending event, the state is re-evaluated below anyway. */
+    ( void ) xSemaphoreTake( pxQueue->xSemaphore, 0U );
+
+    xCompleted = prvReapAcknowledged( pxQueue );
+    xWritten = prvFillStream( pxQueue );
+
+    if( ( xWritten == 0 ) && ( xCompleted == 0 ) && ( pxQueue->pxHead != NULL ) )
+    {
+        /* No progress possible now: wait for the peer to acknowledge data. */
+        if( xSemaphoreTake( pxQueue->xSemaphore, xBlockTime ) == pdPASS )
+        {
+            ( void ) prvReapAcknowledged( pxQueue );
+            xWritten = prvFillStream( pxQueue );
+        }
+    }
+
+    if( ( xWritten < 0 ) || ( ( pxQueue->pxHead != NULL ) && ( FreeRTOS_issocketconnected( pxQueue->xSocket ) != pdTRUE ) ) )
+    {
+        /* Data that is not acknowledged now never will be. */
+        vTCPTxQueueAbort( pxQueue );
+        xPending = -pdFREERTOS_ERRNO_ENOTCONN;
+    }
+    else
+    {
+        for( pxRegion = pxQueue->pxHead; pxRegion != NULL; pxRegion = pxRegion->pxNext )
+        {
+            xPending++;
+        }
+    }
+
+    return xPending;
+}
+/*-----------------------------------------------------------*/
+
+void vTCPTxQueueAbort( TCPTxQueue_t * pxQueue )
+{
+    SemaphoreHandle_t xNoSemaphore = NULL;
+
+    configASSERT( pxQueue != NULL );
+
+    /* Complete what was acknowledged already before failing the rest. */
+    ( void ) prvReapAcknowledged( pxQueue );
+
+    while( pxQueue->pxHead != NULL )
+    {
+        prvCompleteHead( pxQueue, pdFAIL );
+    }
+
+    if( pxQueue->xSocket != FREERTOS_INVALID_SOCKET )
+    {
+        prvSetFullSize( pxQueue, pdFALSE );
+        FreeRTOS_setsockopt( pxQueue->xSocket, 0, FREERTOS_SO_SET_SEMAPHORE, ( void * ) &xNoSemaphore, sizeof( xNoSemaphore ) );
+        pxQueue->xSocket = FREERTOS_INVALID_SOCKET;
+    }
+}
+/*-----------------------------------------------------------*/
@@ -0,0 +1,170 @@
+#ifndef TCP_SENDFILE_H
+#define TCP_SENDFILE_H
+
+/* Kernel includes. */
+#include "FreeRTOS.h"
+#include "semphr.h"
+
+/* FreeRTOS+TCP includes. */
+#include "FreeRTOS_IP.h"
+#include "FreeRTOS_Sockets.h"
+
+#include "tcp_congestion.h"
+
+/*
+ * Scatter-gather TCP transmission from caller owned memory.
+ *
+ * Instead of staging data in an application buffer and handing it to
+ * FreeRTOS_send(), the application queues descriptors (TCPTxRegion_t) that
+ * point at read-only memory, for example a firmware image in flash.  The data
+ * is written directly at the head of the socket's TX stream, found with
+ * FreeRTOS_get_tx_head(), and committed with a FreeRTOS_send() without a
+ * buffer.  That is the only copy: FreeRTOS+TCP sends and retransmits from the
+ * TX stream, so the bytes have to be there until the peer acknowledges them.
+ * A region's callback is called once the peer has acknowledged its last byte.
+ * FreeRTOS_outstanding() tells how many bytes of the stream are still waiting
+ * for an ACK, which is all that is needed to complete regions in order.
+ *
+ * A region without pucData is produced in place: its fnFill writes the bytes
+ * straight into the TX stream, and when fnFill is NULL as well, whatever is
+ * in the stream is sent, which suits generated test traffic.  The stream is
+ * created by the first FreeRTOS_send() of the socket, so the first few bytes
+ * of a connection go through a small buffer on the stack.
+ *
+ * Ownership rules:
+ * - From the moment xTCPTxQueueRegion() returns pdPASS until the callback of
+ *   that region has been called, both the TCPTxRegion_t and the memory it
+ *   points to belong to the TX queue.  They must not be modified or freed.
+ * - The callback is called exactly once per queued region, always from the
+ *   task that calls xTCPTxQueueProcess() or vTCPTxQueueAbort(), never from the
+ *   IP-task.  xStatus is pdPASS when every byte was acknowledged by the peer,
+ *   or pdFAIL when the queue was aborted or the connection was lost.
+ * - A callback may queue its region again, but only when xStatus is pdPASS.
+ * - Regions complete in the order in which they were queued.
+ * - While a TX queue is attached to a socket, all data must be sent through
+ *   the queue: mixing it with FreeRTOS_send() breaks the ACK accounting.
+ * - The queue installs its own semaphore on the socket with
+ *   FREERTOS_SO_SET_SEMAPHORE, and removes it again in vTCPTxQueueAbort().
+ *
+ * Bulk transmission: while regions are pending, the socket only sends
+ * full-size segments (FREERTOS_SO_SET_FULL_SIZE), and data is written into
+ * the TX stream in whole segments.  So each write wakes the IP-task once for a
+ * train of back-to-back MSS segments, instead of once per region or per few
+ * bytes of space.  The option is cleared when the last byte has been written,
+ * which flushes the final partial segment.
+ *
+ * Congestion control: when a TCPCongestion_t is attached with
+ * vTCPTxQueueSetCongestion(), no more than its cwnd is unacknowledged, and the
+ * bytes written are reported to it.  The TX queue then owns its accounting.
+ */
+
+typedef struct xTCP_TX_REGION TCPTxRegion_t;
+
+/**
+ * @brief Called when a region has been acknowledged or abandoned.
+ *
+ * @param pxRegion The region that completed.
+ * @param xStatus pdPASS when acknowledged by the peer, pdFAIL otherwise.
+ */
+typedef void (* TCPTxRegionCallback_t)( TCPTxRegion_t * pxRegion,
+                                        BaseType_t xStatus );
+
+/**
+ * @brief Writes the data of a region that has no pucData, in place.
+ *
+ * @param pxRegion The region being sent.
+ * @param pucDestination Where the bytes go, inside the TX stream.
+ * @param uxOffset Offset of the first byte within the region.
+ * @param uxLength Number of bytes to write.
+ */
+typedef void (* TCPTxRegionFill_t)( TCPTxRegion_t * pxRegion,
+                                    uint8_t * pucDestination,
+                                    size_t uxOffset,
+                                    size_t uxLength );
+
+struct xTCP_TX_REGION
+{
+    const uint8_t * pucData;          /* Start of the caller owned data, or NULL. */
+    size_t uxLength;                  /* Number of bytes to send. */
+    TCPTxRegionFill_t fnFill;         /* Used when pucData is NULL, may be NULL. */
+    TCPTxRegionCallback_t fnCallback; /* May be NULL. */
+    void * pvContext;                 /* Free for use by the owner. */
+
+    /* Private fields, maintained by the TX queue. */
+    size_t uxOffset;                  /* Bytes already written to the stream. */
+    uint32_t ulStreamEnd;             /* Stream position of the last byte + 1. */
+    TCPTxRegion_t * pxNext;
+};
+
+typedef struct xTCP_TX_QUEUE
+{
+    Socket_t xSocket;
+    TCPTxRegion_t * pxHead;     /* Oldest region, not yet acknowledged. */
+    TCPTxRegion_t * pxTail;     /* Most recently queued region. */
+    TCPTxRegion_t * pxSending;  /* First region with bytes not yet in the stream. */
+    uint32_t ulStreamQueued;    /* Total bytes written to the TX stream. */
+    uint32_t ulStreamAcked;     /* Total bytes acknowledged by the peer. */
+    uint32_t ulRegionsDone;     /* Statistics: regions acknowledged. */
+    uint32_t ulRegionsFailed;   /* Statistics: regions abandoned. */
+    BaseType_t xFullSize;       /* FREERTOS_SO_SET_FULL_SIZE is set. */
+    TCPCongestion_t * pxCongestion; /* May be NULL. */
+    SemaphoreHandle_t xSemaphore; /* Given by the IP-task on socket events. */
+    StaticSemaphore_t xSemaphoreBuffer;
+} TCPTxQueue_t;
+
+/**
+ * @brief Attach a TX queue to a connected TCP socket.
+ *
+ * @param pxQueue The queue to initialise.
+ * @param xSocket A connected TCP socket.
+ */
+void vTCPTxQueueInit( TCPTxQueue_t * pxQueue,
+                      Socket_t xSocket );
+
+/**
+ * @brief Limit the data in flight to the congestion window of pxCC.
+ *
+ * @param pxQueue The TX queue.
+ * @param pxCC Congestion control of the same socket, initialised with
+ * vTCPCongestionInit(), or NULL to detach it.
+ */
+void vTCPTxQueueSetCongestion( TCPTxQueue_t * pxQueue,
+                               TCPCongestion_t * pxCC );
+
+/**
+ * @brief Append a caller owned region to the queue.  Nothing is sent until
+ * xTCPTxQueueProcess() is called.
+ *
+ * @param pxQueue The TX queue.
+ * @param pxRegion The region, with pucData or fnFill, uxLength and fnCallback
+ * filled in.
+ *
+ * @return pdPASS if queued, pdFAIL if the region is invalid.
+ */
+BaseType_t xTCPTxQueueRegion( TCPTxQueue_t * pxQueue,
+                              TCPTxRegion_t * pxRegion );
+
+/**
+ * @brief Move queued data into the TX stream as far as space allows and
+ * complete the regions that were acknowledged by the peer.
+ *
+ * @param pxQueue The TX queue.
+ * @param xBlockTime Maximum time to wait for TX space when no progress can be
+ * made.
+ *
+ * @return The number of regions that are still pending, or a negative
+ * FreeRTOS errno when the connection was lost.
+ */
+BaseType_t xTCPTxQueueProcess( TCPTxQueue_t * pxQueue,
+                               TickType_t xBlockTime );
+
+/**
+ * @brief Abandon all pending regions, calling their callbacks with pdFAIL,
+ * and detach the queue from its socket.  Must be called before the socket is
+ * closed.
+ *
+ * @param pxQueue The TX queue.
+ */
+void vTCPTxQueueAbort( TCPTxQueue_t * pxQueue );
+
+#endif /* #ifndef TCP_SENDFILE_H */
@@ -0,0 +1,421 @@
+/* The log messages of this file, see log_levels.h. */
+#define logMODULE    eLogModuleApp
+
+/* FreeRTOS includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+
+/* FreeRTOS+TCP includes, for FreeRTOS_printf(). */
+#include "FreeRTOS_IP.h"
+
+/* ST includes. */
+#include "stm32h7xx_hal.h"
+
+#include "tickless.h"
+
+/* The HAL has no LPTIM driver for this part, so LPTIM1 is programmed through
+ * its registers.  Kernel clock selection LSI in RCC_D2CCIP2R. */
+#define ticklessLPTIM1SEL_LSI      RCC_D2CCIP2R_LPTIM1SEL_2
+
+#define ticklessCOUNTER_MASK       0xFFFFU
+
+/* A new compare value takes a few LSI cycles to reach the counter, so sleeps
+ * shorter than this are not scheduled. */
+#define ticklessMIN_COUNTS         4U
+
+/* Leave room in the 16-bit counter to measure a late wake-up. */
+#define ticklessMAX_COUNTS         0xF000U
+
+/* The shortest period SysTick is restarted with. */
+#define ticklessMIN_SYSTICK        2U
+
+#define ticklessLSI_TIMEOUT_MS     10U
+
+/*
+ * Read the counter of LPTIM1, which runs asynchronously to the bus.  It is
+ * read until two reads agree.
+ */
+static uint32_t prvReadCounter( void );
+
+/*
+ * Convert ullAsleepQ16, the time since the start of the tick in which the
+ * sleep began, into the number of whole ticks that passed, at most xMaxTicks.
+ * *pulSysTickCount gets the number of CPU cycles that SysTick must count
+ * until the next tick.
+ */
+static void prvCompensate( uint64_t ullAsleepQ16,
+                           uint32_t ulCountsPerTickQ16,
+                           uint32_t ulReload,
+                           TickType_t xMaxTicks,
+                           TickType_t * pxTicks,
+                           uint32_t * pulSysTickCount );
+
+/*
+ * Convert a number of microseconds into LPTIM counts * 65536, and back.
+ */
+static uint64_t prvMicrosecondsToQ16( uint32_t ulMicroseconds );
+static uint32_t prvCountsToMicroseconds( uint32_t ulCounts );
+
+/*-----------------------------------------------------------*/
+
+static TicklessStats_t xStats;
+static volatile BaseType_t xStopAllowed = pdFALSE;
+
+/* A write to CMP must be completed (CMPOK) before the next one. */
+static BaseType_t xCompareWritten = pdFALSE;
+
+/*-----------------------------------------------------------*/
+
+static uint32_t prvReadCounter( void )
+{
+    uint32_t ulFirst;
+    uint32_t ulSecond;
+
+    do
+    {
+        ulFirst = LPTIM1->CNT;
+        ulSecond = LPTIM1->CNT;
+    } while( ulFirst != ulSecond );
+
+    return ulFirst & ticklessCOUNTER_MASK;
+}
+/*-----------------------------------------------------------*/
+
+static void prvCompensate( uint64_t ullAsleepQ16,
+                           uint32_t ulCountsPerTickQ16,
+                           uint32_t ulReload,
+                           TickType_t xMaxTicks,
+                           TickType_t * pxTicks,
+                           uint32_t * pulSysTickCount )
+{
+    uint64_t ullTicks = ullAsleepQ16 / ulCountsPerTickQ16;
+    uint64_t ullRest = ullAsleepQ16 % ulCountsPerTickQ16;
+    uint32_t ulCount;
+
+    if( ullTicks > xMaxTicks )
+    {
+        /* Woke up after the tick at which a task is due.  Step to just before
+         * it and let SysTick report it at once. */
+        *pxTicks = xMaxTicks;
+        ulCount = ticklessMIN_SYSTICK;
+    }
+    else
+    {
+        *pxTicks = ( TickType_t ) ullTicks;
+        ulCount = ulReload - ( uint32_t ) ( ( ullRest * ulReload ) / ulCountsPerTickQ16 );
+
+        if( ulCount < ticklessMIN_SYSTICK )
+        {
+            ulCount = ticklessMIN_SYSTICK;
+        }
+    }
+
+    *pulSysTickCount = ulCount;
+}
+/*-----------------------------------------------------------*/
+
+static uint64_t prvMicrosecondsToQ16( uint32_t ulMicroseconds )
+{
+    return ( ( uint64_t ) ulMicroseconds * xStats.ulCountsPerTickQ16 * configTICK_RATE_HZ ) / 1000000U;
+}
+/*-----------------------------------------------------------*/
+
+static uint32_t prvCountsToMicroseconds( uint32_t ulCounts )
+{
+    return ( uint32_t ) ( ( ( uint64_t ) ulCounts * 65536U * 1000000U ) /
+                          ( ( uint64_t ) xStats.ulCountsPerTickQ16 * configTICK_RATE_HZ ) );
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xTicklessInitialise( void )
+{
+    uint32_t ulStart;
+    uint32_t ulCycles;
+    uint32_t ulCounts;
+    uint32_t ulFirst;
+
+    /* The DWT cycle counter is the reference for the calibration and for the
+     * LSI start-up timeout. */
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->LAR = 0xC5ACCE55U;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+    RCC->CSR |= RCC_CSR_LSION;
+    ulStart = DWT->CYCCNT;
+
+    while( ( RCC->CSR & RCC_CSR_LSIRDY ) == 0U )
+    {
+        if( ( DWT->CYCCNT - ulStart ) > ( ( SystemCoreClock / 1000U ) * ticklessLSI_TIMEOUT_MS ) )
+        {
+            return pdFAIL;
+        }
+    }
+
+    MODIFY_REG( RCC->D2CCIP2R, RCC_D2CCIP2R_LPTIM1SEL, ticklessLPTIM1SEL_LSI );
+    SET_BIT( RCC->APB1LENR, RCC_APB1LENR_LPTIM1EN );
+    SET_BIT( RCC->APB1LLPENR, RCC_APB1LLPENR_LPTIM1LPEN );
+    ( void ) READ_BIT( RCC->APB1LENR, RCC_APB1LENR_LPTIM1EN );
+
+    /* CFGR and IER can only be written while the timer is disabled, ARR and
+     * CMP only while it is enabled.  Internal clock, no prescaler, no
+     * trigger: the counter runs freely from 0 to ARR. */
+    LPTIM1->CR = 0U;
+    LPTIM1->CFGR = 0U;
+    LPTIM1->IER = LPTIM_IER_CMPMIE;
+    LPTIM1->CR = LPTIM_CR_ENABLE;
+    LPTIM1->ARR = ticklessCOUNTER_MASK;
+
+    while( ( LPTIM1->ISR & LPTIM_ISR_ARROK ) == 0U )
+    {
+    }
+
+    LPTIM1->ICR = LPTIM_ICR_ARROKCF;
+    LPTIM1->CR |= LPTIM_CR_CNTSTRT;
+
+    /* Measure the LSI, nominally 32 kHz but off by several percent. */
+    ulFirst = prvReadCounter();
+    ulStart = DWT->CYCCNT;
+
+    while( ( DWT->CYCCNT - ulStart ) < ( ( SystemCoreClock / 1000U ) * configTICKLESS_CALIBRATION_MS ) )
+    {
+    }
+
+    ulCounts = ( prvReadCounter() - ulFirst ) & ticklessCOUNTER_MASK;
+    ulCycles = DWT->CYCCNT - ulStart;
+
+    xStats.ulCountsPerTickQ16 = ( uint32_t ) ( ( ( uint64_t ) ulCounts * 65536U * SystemCoreClock ) /
+                                               ( ( uint64_t ) ulCycles * configTICK_RATE_HZ ) );
+
+    /* Both wake-up sources must also be able to end Stop mode. */
+    SET_BIT( EXTI_D1->IMR2, EXTI_IMR2_IM47 );
+    SET_BIT( EXTI->RTSR3, EXTI_RTSR3_TR86 );
+    SET_BIT( EXTI_D1->IMR3, EXTI_IMR3_IM86 );
+
+    /* Enabled only while the core sleeps. */
+    HAL_NVIC_SetPriority( LPTIM1_IRQn, 5, 0 );
+    HAL_NVIC_DisableIRQ( LPTIM1_IRQn );
+
+    return pdPASS;
+}
+/*-----------------------------------------------------------*/
+
+void vTicklessAllowStop( BaseType_t xAllow )
+{
+    xStopAllowed = xAllow;
+}
+/*-----------------------------------------------------------*/
+
+void vTicklessGetStats( TicklessStats_t * pxStats )
+{
+    taskENTER_CRITICAL();
+    {
+        *pxStats = xStats;
+    }
+    taskEXIT_CRITICAL();
+}
+/*-----------------------------------------------------------*/
+
+void vTicklessReport( void )
+{
+    TicklessStats_t xCopy;
+
+    vTicklessGetStats( &xCopy );
+
+    FreeRTOS_printf( ( "Tickless: %u sleeps, %u stops, %u ticks suppressed, %u too short, %u aborted\n",
+                       ( unsigned ) xCopy.ulSleeps,
+                       ( unsigned ) xCopy.ulStops,
+                       ( unsigned ) xCopy.ulTicksSuppressed,
+                       ( unsigned ) xCopy.ulTooShort,
+                       ( unsigned ) xCopy.ulAborted ) );
+    FreeRTOS_printf( ( "Tickless: wake-up latency max %u us, %u over budget, %u Ethernet wake-ups\n",
+                       ( unsigned ) xCopy.ulMaxLatencyUs,
+                       ( unsigned ) xCopy.ulOverBudget,
+                       ( unsigned ) xCopy.ulEthernetWakeups ) );
+}
+/*-----------------------------------------------------------*/
+
+void vTicklessLPTIMInterrupt( void )
+{
+    /* The sleep ends here, vPortSuppressTicksAndSleep() does the rest. */
+    LPTIM1->ICR = LPTIM_ICR_CMPMCF;
+}
+/*-----------------------------------------------------------*/
+
+void vTicklessEthernetWakeup( void )
+{
+    EXTI_D1->PR3 = EXTI_PR3_PR86;
+    xStats.ulEthernetWakeups++;
+}
+/*-----------------------------------------------------------*/
+
+uint32_t ulTicklessSleepCount( void )
+{
+    /* Only written with interrupts masked. */
+    return xStats.ulSleeps + xStats.ulStops;
+}
+/*-----------------------------------------------------------*/
+
+void vPortSuppressTicksAndSleep( TickType_t xExpectedIdleTime )
+{
+    uint32_t ulReload = SysTick->LOAD + 1U;
+    uint32_t ulCountsPerTickQ16 = xStats.ulCountsPerTickQ16;
+    BaseType_t xStop = xStopAllowed;
+    uint32_t ulBudgetUs = ( xStop != pdFALSE ) ? configTICKLESS_STOP_LATENCY_US : configTICKLESS_SLEEP_LATENCY_US;
+    TickType_t xModifiableIdleTime;
+    TickType_t xTicks;
+    uint64_t ullPartialQ16;
+    uint64_t ullTargetQ16;
+    uint64_t ullLatencyQ16;
+    uint32_t ulStart;
+    uint32_t ulEnd;
+    uint32_t ulCompare;
+    uint32_t ulLate;
+    uint32_t ulAsleep;
+    uint32_t ulLatencyUs;
+    uint32_t ulSysTickCount;
+    BaseType_t xWokenByTimer;
+
+    if( ulCountsPerTickQ16 == 0U )
+    {
+        /* xTicklessInitialise() was not called or failed. */
+        __DSB();
+        __WFI();
+        __ISB();
+        return;
+    }
+
+    __disable_irq();
+    __DSB();
+    __ISB();
+
+    if( ( eTaskConfirmSleepModeStatus() == eAbortSleep ) ||
+        ( ( SCB->ICSR & SCB_ICSR_PENDSTSET_Msk ) != 0U ) )
+    {
+        xStats.ulAborted++;
+        __enable_irq();
+        return;
+    }
+
+    /* Freeze SysTick.  The part of the current tick that has passed is where
+     * the sleep starts. */
+    SysTick->CTRL &= ~SysTick_CTRL_ENABLE_Msk;
+    ulStart = prvReadCounter();
+    ullPartialQ16 = ( ( uint64_t ) ( ulReload - 1U - SysTick->VAL ) * ulCountsPerTickQ16 ) / ulReload;
+
+    /* Wake up at the start of the tick at which a task is due, minus the
+     * latency budget. */
+    ullLatencyQ16 = prvMicrosecondsToQ16( ulBudgetUs );
+    ullTargetQ16 = ( uint64_t ) xExpectedIdleTime * ulCountsPerTickQ16;
+
+    if( ullTargetQ16 < ( ullPartialQ16 + ullLatencyQ16 + ( ( uint64_t ) ticklessMIN_COUNTS << 16 ) ) )
+    {
+        xStats.ulTooShort++;
+        SysTick->CTRL |= SysTick_CTRL_ENABLE_Msk;
+        __enable_irq();
+        return;
+    }
+
+    ullTargetQ16 -= ullPartialQ16 + ullLatencyQ16;
+
+    if( ullTargetQ16 > ( ( uint64_t ) ticklessMAX_COUNTS << 16 ) )
+    {
+        ullTargetQ16 = ( uint64_t ) ticklessMAX_COUNTS << 16;
+    }
+
+    ulCompare = ( ulStart + ( uint32_t ) ( ullTargetQ16 >> 16 ) ) & ticklessCOUNTER_MASK;
+
+    if( xCompareWritten != pdFALSE )
+    {
+        while( ( LPTIM1->ISR & LPTIM_ISR_CMPOK ) == 0U )
+        {
+        }
+
+        LPTIM1->ICR = LPTIM_ICR_CMPOKCF;
+    }
+
+    LPTIM1->CMP = ulCompare;
+    xCompareWritten = pdTRUE;
+
+    HAL_SuspendTick();
+    LPTIM1->ICR = LPTIM_ICR_CMPMCF;
+    NVIC_ClearPendingIRQ( LPTIM1_IRQn );
+    NVIC_EnableIRQ( LPTIM1_IRQn );
+
+    xModifiableIdleTime = xExpectedIdleTime;
+    configPRE_SLEEP_PROCESSING( xModifiableIdleTime );
+
+    if( xModifiableIdleTime > 0U )
+    {
+        if( xStop != pdFALSE )
+        {
+            xStats.ulStops++;
+            HAL_PWREx_EnterSTOPMode( PWR_LOWPOWERREGULATOR_ON, PWR_STOPENTRY_WFI, PWR_D1_DOMAIN );
+        }
+        else
+        {
+            xStats.ulSleeps++;
+            __DSB();
+            __WFI();
+            __ISB();
+        }
+    }
+
+    configPOST_SLEEP_PROCESSING( xExpectedIdleTime );
+
+    /* Interrupts are still masked: the one that woke the core is pending. */
+    ulEnd = prvReadCounter();
+    xWokenByTimer = ( ( LPTIM1->ISR & LPTIM_ISR_CMPM ) != 0U ) ? pdTRUE : pdFALSE;
+
+    NVIC_DisableIRQ( LPTIM1_IRQn );
+    LPTIM1->ICR = LPTIM_ICR_CMPMCF;
+    NVIC_ClearPendingIRQ( LPTIM1_IRQn );
+
+    if( xWokenByTimer != pdFALSE )
+    {
+        ulLate = ( ulEnd - ulCompare ) & ticklessCOUNTER_MASK;
+
+        /* A match of the previous compare value, while the new one was on its
+         * way, looks like a wake-up from the future. */
+        if( ulLate < ( ticklessCOUNTER_MASK - ticklessMAX_COUNTS ) )
+        {
+            ulLatencyUs = prvCountsToMicroseconds( ulLate );
+
+            if( ulLatencyUs > xStats.ulMaxLatencyUs )
+            {
+                xStats.ulMaxLatencyUs = ulLatencyUs;
+            }
+
+            if( ulLatencyUs > ulBudgetUs )
+            {
+                xStats.ulOverBudget++;
+            }
+        }
+    }
+
+    ulAsleep = ( ulEnd - ulStart ) & ticklessCOUNTER_MASK;
+    prvCompensate( ullPartialQ16 + ( ( uint64_t ) ulAsleep << 16 ),
+                   ulCountsPerTickQ16, ulReload, xExpectedIdleTime - 1U, &xTicks, &ulSysTickCount );
+
+    #if ( configUSE_EVENT_TRACE == 1 )
+        /* The DWT cycle counter of the trace stood still.  SysTick runs at
+         * the CPU clock, so ulReload is the number of cycles of a tick. */
+        vTraceAddSleepCycles( ( uint32_t ) ( ( ( ( uint64_t ) ulAsleep << 16 ) * ulReload ) / ulCountsPerTickQ16 ) );
+    #endif
+
+    /* Let SysTick count the rest of the current tick, then run at the normal
+     * period again. */
+    SysTick->LOAD = ulSysTickCount - 1U;
+    SysTick->VAL = 0U;
+    SysTick->CTRL |= SysTick_CTRL_ENABLE_Msk;
+    SysTick->LOAD = ulReload - 1U;
+
+    vTaskStepTick( xTicks );
+    xStats.ulTicksSuppressed += xTicks;
+
+    /* The HAL tick follows the kernel tick. */
+    uwTick += ( uint32_t ) xTicks * ( 1000U / configTICK_RATE_HZ );
+    HAL_ResumeTick();
+
+    __enable_irq();
+}
+/*-----------------------------------------------------------*/
@@ -0,0 +1,110 @@
+#ifndef TICKLESS_H
+#define TICKLESS_H
+
+/* FreeRTOS includes. */
+#include "FreeRTOS.h"
+
+/*
+ * Tickless idle (configUSE_TICKLESS_IDLE 2) with LPTIM1 as the wake source.
+ *
+ * When all tasks block for at least configEXPECTED_IDLE_TIME_BEFORE_SLEEP
+ * ticks, the kernel calls vPortSuppressTicksAndSleep().  That function stops
+ * SysTick and the HAL time base (TIM6).  It then sets LPTIM1 to wake the core
+ * just before the next task is due, and sleeps.  Any other interrupt, such as
+ * Ethernet RX, ends the sleep early.  On waking, the time asleep is measured
+ * with LPTIM1 and converted into whole ticks for vTaskStepTick(), plus the
+ * part of a tick that SysTick must still count.
+ *
+ * LPTIM1 runs from the LSI oscillator, which keeps running in Stop mode.  The
+ * LSI is not accurate, so xTicklessInitialise() measures it against the CPU
+ * clock.  At about 32 LPTIM counts per tick, a sleep lasts at most about 1900
+ * ticks.
+ *
+ * Wake-latency budget: the core is woken configTICKLESS_SLEEP_LATENCY_US, or
+ * configTICKLESS_STOP_LATENCY_US for Stop mode, before the next task is due.
+ * Idle periods that are not longer than the budget are not suppressed.  The
+ * measured latency, from the LPTIM1 compare match to the first instruction
+ * after the wake-up, is kept in the statistics.  Every wake-up that took
+ * longer than its budget is counted.
+ *
+ * Stop mode stops the Ethernet DMA, so it is only used after
+ * vTicklessAllowStop( pdTRUE ).  The application allows it while the network
+ * is down, from its network event hook, and forbids it again when an
+ * end-point comes up.  The link is still polled in Stop mode, as the timers
+ * of the IP-task wake the core through LPTIM1.  The
+ * Ethernet wake-up interrupt (ETH_WKUP_IRQn, EXTI line 86) can then end the
+ * stop, as can LPTIM1 (EXTI line 47).  SystemClock_Config() runs from the HSI
+ * without a PLL, which is also the clock after Stop, so nothing needs to be
+ * restored.
+ */
+
+/* The wake-up is scheduled this much before the next task is due. */
+#ifndef configTICKLESS_SLEEP_LATENCY_US
+    #define configTICKLESS_SLEEP_LATENCY_US    100U
+#endif
+
+#ifndef configTICKLESS_STOP_LATENCY_US
+    #define configTICKLESS_STOP_LATENCY_US     500U
+#endif
+
+/* Time spent measuring the LSI against the CPU clock. */
+#ifndef configTICKLESS_CALIBRATION_MS
+    #define configTICKLESS_CALIBRATION_MS      50U
+#endif
+
+typedef struct xTICKLESS_STATS
+{
+    uint32_t ulSleeps;             /* Sleep mode entries. */
+    uint32_t ulStops;              /* Stop mode entries. */
+    uint32_t ulTooShort;           /* Idle periods within the latency budget. */
+    uint32_t ulAborted;            /* A task became ready before the sleep. */
+    uint32_t ulTicksSuppressed;
+    uint32_t ulMaxLatencyUs;       /* Of the wake-ups by LPTIM1. */
+    uint32_t ulOverBudget;         /* Wake-ups that took longer than the budget. */
+    uint32_t ulEthernetWakeups;
+    uint32_t ulCountsPerTickQ16;   /* The calibrated LSI, in LPTIM counts per tick * 65536. */
+} TicklessStats_t;
+
+/**
+ * @brief Start LPTIM1 and calibrate the LSI.  Must be called before
+ * vTaskStartScheduler(), it busy-waits for configTICKLESS_CALIBRATION_MS.
+ *
+ * @return pdPASS if success, pdFAIL when the LSI does not start.
+ */
+BaseType_t xTicklessInitialise( void );
+
+/**
+ * @brief Allow or forbid Stop mode in idle periods.
+ */
+void vTicklessAllowStop( BaseType_t xAllow );
+
+/**
+ * @brief Get a copy of the statistics.
+ */
+void vTicklessGetStats( TicklessStats_t * pxStats );
+
+/**
+ * @brief Log the statistics.
+ */
+void vTicklessReport( void );
+
+/**
+ * @brief The interrupt handlers of LPTIM1 and of the Ethernet wake-up line,
+ * to be called from LPTIM1_IRQHandler() and ETH_WKUP_IRQHandler().
+ */
+void vTicklessLPTIMInterrupt( void );
+void vTicklessEthernetWakeup( void );
+
+/**
+ * @brief The number of sleeps so far.  The HAL time base (TIM6) does not
+ * interrupt during a sleep, so its first interrupt after one is late by
+ * design.  May be called from interrupts.
+ */
+uint32_t ulTicklessSleepCount( void );
+
+/**
+ * @brief Called by the kernel through portSUPPRESS_TICKS_AND_SLEEP().
+ */
+void vPortSuppressTicksAndSleep( TickType_t xExpectedIdleTime );
+
+#endif /* #ifndef TICKLESS_H */
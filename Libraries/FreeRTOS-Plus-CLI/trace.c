@@ -0,0 +1,361 @@
+/* The log messages of this file, see log_levels.h. */
+#define logMODULE    eLogModuleApp
+
+/* Standard includes. */
+#include <string.h>
+
+/* FreeRTOS includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+
+/* FreeRTOS+TCP includes. */
+#include "FreeRTOS_IP.h"
+#include "FreeRTOS_Sockets.h"
+
+/* ST includes. */
+#include "stm32h7xx_hal.h"
+
+#include "trace.h"
+
+#define traceMASK               ( configTRACE_EVENTS - 1U )
+
+/* Records per datagram, which stays within a 1500-byte MTU. */
+#define traceEVENTS_PER_DATAGRAM    ( ( 1472U - sizeof( TraceHeader_t ) ) / sizeof( TraceEvent_t ) )
+
+#define traceMAX_NAMES          32U
+
+/*
+ * The stream task.
+ */
+static void prvStreamTask( void * pvParameters );
+
+/*
+ * Copy up to uxMaximum committed events, from event number *pulNext on, and
+ * advance *pulNext.  Events that were overwritten are skipped and counted in
+ * *pulLost.
+ */
+static size_t prvCollect( TraceEvent_t * pxEvents,
+                          size_t uxMaximum,
+                          uint32_t * pulNext,
+                          uint32_t * pulLost );
+
+/*
+ * Send the names of all tasks.
+ */
+static void prvSendNames( Socket_t xSocket );
+
+static void prvFillHeader( TraceHeader_t * pxHeader,
+                           uint16_t usType,
+                           uint32_t ulSequence,
+                           uint16_t usCount );
+
+/*-----------------------------------------------------------*/
+
+typedef struct xTRACE_RING
+{
+    uint32_t ulMagic;
+    uint32_t ulSize;
+    volatile uint32_t ulHead;   /* The number of the next event. */
+    uint32_t ulCpuHz;
+    TraceEvent_t xEvents[ configTRACE_EVENTS ];
+} TraceRing_t;
+
+/* The linker scripts place .dtcm in DTCMRAM, where writes do not wait for the
+ * AXI bus.  Not cleared by start-up, see vTraceInitialise(). */
+TraceRing_t xTraceRing __attribute__( ( section( ".dtcm" ) ) );
+
+/* The cycles that the core slept, see vTraceAddSleepCycles().  Only
+ * changed with interrupts masked. */
+static volatile uint32_t ulSleepCycles = 0U;
+
+static TaskHandle_t xStreamTask = NULL;
+static struct freertos_sockaddr xCollector;
+static BaseType_t xStreamContinuous = pdFALSE;
+static volatile BaseType_t xStreamStop = pdFALSE;
+static uint32_t ulStreamLost = 0U;
+
+/* The datagram under construction, only used by the stream task. */
+static uint32_t ulDatagram[ 1472U / sizeof( uint32_t ) ];
+
+/*-----------------------------------------------------------*/
+
+void vTraceInitialise( void )
+{
+    uint32_t ul;
+
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->LAR = 0xC5ACCE55U;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+    xTraceRing.ulHead = 0U;
+
+    /* Mark every record as belonging to the lap before the first. */
+    for( ul = 0U; ul < configTRACE_EVENTS; ul++ )
+    {
+        memset( &( xTraceRing.xEvents[ ul ] ), 0, sizeof( TraceEvent_t ) );
+        xTraceRing.xEvents[ ul ].usSequence = ( uint16_t ) ( ul - configTRACE_EVENTS );
+    }
+
+    xTraceRing.ulSize = configTRACE_EVENTS;
+    xTraceRing.ulCpuHz = SystemCoreClock;
+    xTraceRing.ulMagic = traceRING_MAGIC;
+}
+/*-----------------------------------------------------------*/
+
+void vTraceRecord( uint32_t ulEvent,
+                   uint32_t ulArg1,
+                   uint32_t ulArg2 )
+{
+    uint32_t ulIndex;
+    TraceEvent_t * pxEvent;
+
+    /* An interrupt between the LDREX and the STREX makes the STREX fail,
+     * so every writer gets its own number. */
+    do
+    {
+        ulIndex = __LDREXW( &( xTraceRing.ulHead ) );
+    } while( __STREXW( ulIndex + 1U, &( xTraceRing.ulHead ) ) != 0U );
+
+    pxEvent = &( xTraceRing.xEvents[ ulIndex & traceMASK ] );
+    pxEvent->ulCycles = DWT->CYCCNT + ulSleepCycles;
+    pxEvent->usEvent = ( uint16_t ) ulEvent;
+    pxEvent->ulArg1 = ulArg1;
+    pxEvent->ulArg2 = ulArg2;
+
+    /* Commit. */
+    __DMB();
+    pxEvent->usSequence = ( uint16_t ) ulIndex;
+}
+/*-----------------------------------------------------------*/
+
+void vTraceAddSleepCycles( uint32_t ulCycles )
+{
+    ulSleepCycles += ulCycles;
+}
+/*-----------------------------------------------------------*/
+
+void vTraceMark( uint32_t ulIdentifier,
+                 uint32_t ulValue )
+{
+    vTraceRecord( traceEVENT_MARK, ulIdentifier, ulValue );
+}
+/*-----------------------------------------------------------*/
+
+static size_t prvCollect( TraceEvent_t * pxEvents,
+                          size_t uxMaximum,
+                          uint32_t * pulNext,
+                          uint32_t * pulLost )
+{
+    uint32_t ulHead = xTraceRing.ulHead;
+    uint32_t ulNext = *pulNext;
+    size_t uxCount = 0U;
+    size_t uxValid;
+    size_t x;
+
+    if( ( ulHead - ulNext ) > configTRACE_EVENTS )
+    {
+        /* The writers went round the ring. */
+        *pulLost += ( ulHead - ulNext ) - configTRACE_EVENTS;
+        ulNext = ulHead - configTRACE_EVENTS;
+    }
+
+    while( ( uxCount < uxMaximum ) && ( ulNext + uxCount != ulHead ) )
+    {
+        const TraceEvent_t * pxEvent = &( xTraceRing.xEvents[ ( ulNext + uxCount ) & traceMASK ] );
+
+        if( pxEvent->usSequence != ( uint16_t ) ( ulNext + uxCount ) )
+        {
+            /* Taken but not yet written. */
+            break;
+        }
+
+        pxEvents[ uxCount ] = *pxEvent;
+        uxCount++;
+    }
+
+    /* Events copied while a writer overwrote them are not trusted. */
+    __DMB();
+    ulHead = xTraceRing.ulHead;
+    uxValid = uxCount;
+
+    for( x = 0U; x < uxCount; x++ )
+    {
+        if( ( ulHead - ( ulNext + x ) ) <= configTRACE_EVENTS )
+        {
+            break;
+        }
+
+        uxValid--;
+    }
+
+    if( uxValid != uxCount )
+    {
+        *pulLost += uxCount - uxValid;
+        memmove( pxEvents, &( pxEvents[ uxCount - uxValid ] ), uxValid * sizeof( TraceEvent_t ) );
+    }
+
+    *pulNext = ulNext + uxCount;
+
+    return uxValid;
+}
+/*-----------------------------------------------------------*/
+
+size_t uxTraceCopyLast( TraceEvent_t * pxEvents,
+                        size_t uxMaximum )
+{
+    uint32_t ulHead = xTraceRing.ulHead;
+    uint32_t ulNext;
+    uint32_t ulLost = 0U;
+
+    if( uxMaximum > configTRACE_EVENTS )
+    {
+        uxMaximum = configTRACE_EVENTS;
+    }
+
+    if( ( xTraceRing.ulMagic != traceRING_MAGIC ) || ( uxMaximum == 0U ) )
+    {
+        return 0U;
+    }
+
+    ulNext = ( ulHead > uxMaximum ) ? ( ulHead - ( uint32_t ) uxMaximum ) : 0U;
+
+    return prvCollect( pxEvents, uxMaximum, &ulNext, &ulLost );
+}
+/*-----------------------------------------------------------*/
+
+static void prvFillHeader( TraceHeader_t * pxHeader,
+                           uint16_t usType,
+                           uint32_t ulSequence,
+                           uint16_t usCount )
+{
+    pxHeader->ulMagic = traceDATAGRAM_MAGIC;
+    pxHeader->usVersion = traceVERSION;
+    pxHeader->usType = usType;
+    pxHeader->ulCpuHz = SystemCoreClock;
+    pxHeader->ulSequence = ulSequence;
+    pxHeader->ulLost = ulStreamLost;
+    pxHeader->usCount = usCount;
+    pxHeader->usReserved = 0U;
+}
+/*-----------------------------------------------------------*/
+
+static void prvSendNames( Socket_t xSocket )
+{
+    static TaskStatus_t xStatus[ traceMAX_NAMES ];
+    TraceName_t * pxNames = ( TraceName_t * ) &( ( ( TraceHeader_t * ) ulDatagram )[ 1 ] );
+    UBaseType_t uxCount;
+    UBaseType_t x;
+
+    uxCount = uxTaskGetSystemState( xStatus, traceMAX_NAMES, NULL );
+
+    for( x = 0; x < uxCount; x++ )
+    {
+        pxNames[ x ].ulHandle = ( uint32_t ) xStatus[ x ].xHandle;
+        memset( pxNames[ x ].cName, 0, sizeof( pxNames[ x ].cName ) );
+        strncpy( pxNames[ x ].cName, xStatus[ x ].pcTaskName, sizeof( pxNames[ x ].cName ) - 1U );
+    }
+
+    prvFillHeader( ( TraceHeader_t * ) ulDatagram, traceDATAGRAM_NAMES, 0U, ( uint16_t ) uxCount );
+    ( void ) FreeRTOS_sendto( xSocket, ulDatagram, sizeof( TraceHeader_t ) + ( uxCount * sizeof( TraceName_t ) ),
+                              0, &xCollector, sizeof( xCollector ) );
+}
+/*-----------------------------------------------------------*/
+
+static void prvStreamTask( void * pvParameters )
+{
+    Socket_t xSocket;
+    TraceEvent_t * pxEvents = ( TraceEvent_t * ) &( ( ( TraceHeader_t * ) ulDatagram )[ 1 ] );
+    uint32_t ulNext;
+    uint32_t ulFirst;
+    uint32_t ulEnd;
+    size_t uxCount;
+    TickType_t xNamesSent;
+
+    ( void ) pvParameters;
+
+    xSocket = FreeRTOS_socket( FREERTOS_AF_INET, FREERTOS_SOCK_DGRAM, FREERTOS_IPPROTO_UDP );
+
+    if( xSocket != FREERTOS_INVALID_SOCKET )
+    {
+        /* Start with the oldest event.  A snapshot ends at the newest event
+         * of this moment. */
+        ulEnd = xTraceRing.ulHead;
+        ulNext = ( ulEnd > configTRACE_EVENTS ) ? ( ulEnd - configTRACE_EVENTS ) : 0U;
+
+        prvSendNames( xSocket );
+        xNamesSent = xTaskGetTickCount();
+
+        while( xStreamStop == pdFALSE )
+        {
+            if( ( xTaskGetTickCount() - xNamesSent ) >= pdMS_TO_TICKS( configTRACE_NAMES_PERIOD_MS ) )
+            {
+                prvSendNames( xSocket );
+                xNamesSent = xTaskGetTickCount();
+            }
+
+            if( ( xStreamContinuous == pdFALSE ) && ( ( ulEnd - ulNext ) < traceEVENTS_PER_DATAGRAM ) )
+            {
+                uxCount = prvCollect( pxEvents, ulEnd - ulNext, &ulNext, &ulStreamLost );
+            }
+            else
+            {
+                uxCount = prvCollect( pxEvents, traceEVENTS_PER_DATAGRAM, &ulNext, &ulStreamLost );
+            }
+
+            if( uxCount > 0U )
+            {
+                ulFirst = ulNext - ( uint32_t ) uxCount;
+                prvFillHeader( ( TraceHeader_t * ) ulDatagram, traceDATAGRAM_EVENTS, ulFirst, ( uint16_t ) uxCount );
+                ( void ) FreeRTOS_sendto( xSocket, ulDatagram, sizeof( TraceHeader_t ) + ( uxCount * sizeof( TraceEvent_t ) ),
+                                          0, &xCollector, sizeof( xCollector ) );
+            }
+
+            if( xStreamContinuous == pdFALSE )
+            {
+                if( ( int32_t ) ( ulEnd - ulNext ) <= 0 )
+                {
+                    break;
+                }
+            }
+            else if( uxCount < traceEVENTS_PER_DATAGRAM )
+            {
+                /* Caught up. */
+                vTaskDelay( pdMS_TO_TICKS( configTRACE_STREAM_PERIOD_MS ) );
+            }
+        }
+
+        LogWarn( ( "trace: stream stopped, %u events lost\n", ( unsigned ) ulStreamLost ) );
+        ( void ) FreeRTOS_closesocket( xSocket );
+    }
+
+    xStreamTask = NULL;
+    vTaskDelete( NULL );
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xTraceStreamStart( const struct freertos_sockaddr * pxCollector,
+                              BaseType_t xContinuous,
+                              uint16_t usStackSize,
+                              UBaseType_t uxPriority )
+{
+    BaseType_t xReturn = pdFAIL;
+
+    if( xStreamTask == NULL )
+    {
+        xCollector = *pxCollector;
+        xStreamContinuous = xContinuous;
+        xStreamStop = pdFALSE;
+        ulStreamLost = 0U;
+
+        xReturn = xTaskCreate( prvStreamTask, "Trace", usStackSize, NULL, uxPriority, &xStreamTask );
+    }
+
+    return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+void vTraceStreamStop( void )
+{
+    xStreamStop = pdTRUE;
+}
+/*-----------------------------------------------------------*/
@@ -0,0 +1,127 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+/* FreeRTOS includes. */
+#include "FreeRTOS.h"
+
+/* FreeRTOS+TCP includes. */
+#include "FreeRTOS_Sockets.h"
+
+#include "trace_events.h"
+
+/*
+ * Event tracing.  The trace macros of the kernel and of FreeRTOS+TCP, set in
+ * FreeRTOSConfig.h and FreeRTOSIPConfig.h, write fixed-size TraceEvent_t
+ * records into a ring of configTRACE_EVENTS in DTCM.  The records hold:
+ * - context switches;
+ * - task creation and deletion;
+ * - blocking on queues and event groups (socket waits);
+ * - delays;
+ * - frames received and sent;
+ * - network buffer failures and lost IP-task events.
+ *
+ * Writing takes a few dozen cycles and no lock.  The index is taken with
+ * LDREX/STREX, so interrupts can record events too.  The part has one core,
+ * so there is one ring.  When the ring is full the oldest events are
+ * overwritten.  Each record is stamped with the DWT cycle counter, which
+ * runs at SystemCoreClock.  The counter stands still while the core sleeps,
+ * so tickless idle (tickless.h) adds the time asleep, measured with LPTIM1 to
+ * about 30 us, through vTraceAddSleepCycles().
+ *
+ * A record's usSequence is written last, which commits it.  Readers only take
+ * records whose usSequence matches the position they read.
+ *
+ * xTraceStreamStart() sends the ring to a collector in UDP datagrams, either
+ * continuously or as a single snapshot.  The last events also go into the
+ * crash dump.  A debugger can dump the ring as well: xTraceRing starts with
+ * traceRING_MAGIC.  tools/trace_to_perfetto.py receives the datagrams and
+ * converts them to a trace that Perfetto opens.
+ *
+ * Datagram format, little-endian: a TraceHeader_t, then usCount records.
+ * - traceDATAGRAM_EVENTS: TraceEvent_t records, from event number
+ *   ulSequence on.
+ * - traceDATAGRAM_NAMES: TraceName_t records, the names of the tasks.
+ */
+
+/* Number of events in the ring, a power of two, at most 32768. */
+#ifndef configTRACE_EVENTS
+    #define configTRACE_EVENTS          1024U
+#endif
+
+/* Interval at which the stream task empties the ring. */
+#ifndef configTRACE_STREAM_PERIOD_MS
+    #define configTRACE_STREAM_PERIOD_MS    50U
+#endif
+
+/* Interval at which the task names are sent again. */
+#ifndef configTRACE_NAMES_PERIOD_MS
+    #define configTRACE_NAMES_PERIOD_MS     1000U
+#endif
+
+#define traceRING_MAGIC             0x474E5254UL /* "TRNG" */
+#define traceDATAGRAM_MAGIC         0x45435254UL /* "TRCE" */
+#define traceVERSION                1U
+
+#define traceDATAGRAM_EVENTS        1U
+#define traceDATAGRAM_NAMES         2U
+
+typedef struct xTRACE_HEADER
+{
+    uint32_t ulMagic;
+    uint16_t usVersion;
+    uint16_t usType;
+    uint32_t ulCpuHz;       /* Rate of TraceEvent_t.ulCycles, SystemCoreClock. */
+    uint32_t ulSequence;    /* The number of the first event. */
+    uint32_t ulLost;        /* Events overwritten before they were sent, in total. */
+    uint16_t usCount;
+    uint16_t usReserved;
+} TraceHeader_t;
+
+typedef struct xTRACE_NAME
+{
+    uint32_t ulHandle;
+    char cName[ 16 ];
+} TraceName_t;
+
+/**
+ * @brief Clear the ring and start the cycle counter.  Events recorded before
+ * this call are lost.
+ */
+void vTraceInitialise( void );
+
+/**
+ * @brief Record an application event, shown as a marker on the timeline.
+ */
+void vTraceMark( uint32_t ulIdentifier,
+                 uint32_t ulValue );
+
+/**
+ * @brief Copy the last events, oldest first.  Takes no lock and calls no
+ * kernel function, so it works in a fault handler.
+ *
+ * @return The number of events copied, at most uxMaximum.
+ */
+size_t uxTraceCopyLast( TraceEvent_t * pxEvents,
+                        size_t uxMaximum );
+
+/**
+ * @brief Start a task that sends the ring to a collector.  It starts with
+ * the oldest event in the ring.
+ *
+ * @param pxCollector The address and port of the collector, copied.
+ * @param xContinuous pdTRUE to keep streaming until vTraceStreamStop(),
+ * pdFALSE to send one snapshot of the ring.
+ *
+ * @return pdPASS if the task runs, pdFAIL when a stream is running already.
+ */
+BaseType_t xTraceStreamStart( const struct freertos_sockaddr * pxCollector,
+                              BaseType_t xContinuous,
+                              uint16_t usStackSize,
+                              UBaseType_t uxPriority );
+
+/**
+ * @brief Stop a continuous stream after its next datagram.
+ */
+void vTraceStreamStop( void );
+
+#endif /* #ifndef TRACE_H */
@@ -0,0 +1,61 @@
+#ifndef TRACE_EVENTS_H
+#define TRACE_EVENTS_H
+
+/* Standard includes. */
+#include <stdint.h>
+
+/*
+ * The events of trace.h, and the function that the trace macros of
+ * FreeRTOSConfig.h and FreeRTOSIPConfig.h call.  This file is included by
+ * those configuration files, so it must not include FreeRTOS.h.
+ */
+
+/* Set to 0 to compile the trace macros out. */
+#ifndef configUSE_EVENT_TRACE
+    #define configUSE_EVENT_TRACE    1
+#endif
+
+/* Kernel events. */
+#define traceEVENT_TASK_SWITCHED_IN       1U   /* Task handle. */
+#define traceEVENT_TASK_CREATE            2U   /* Task handle, priority. */
+#define traceEVENT_TASK_DELETE            3U   /* Task handle. */
+#define traceEVENT_QUEUE_RECEIVE_BLOCK    4U   /* Queue. */
+#define traceEVENT_QUEUE_SEND_BLOCK       5U   /* Queue. */
+#define traceEVENT_EVENT_GROUP_WAIT       6U   /* Event group, bits. */
+#define traceEVENT_EVENT_GROUP_WAIT_END   7U   /* Event group, timed out. */
+#define traceEVENT_TASK_DELAY             8U   /* Ticks. */
+
+/* FreeRTOS+TCP events.  A socket wait is an event group wait. */
+#define traceEVENT_NET_RX                 16U
+#define traceEVENT_NET_TX                 17U  /* Length. */
+#define traceEVENT_NET_BUFFER_FAILURE     18U
+#define traceEVENT_NET_RX_EVENT_LOST      19U
+#define traceEVENT_NET_TX_EVENT_LOST      20U  /* IP-task event. */
+
+/* Application events, see vTraceMark(). */
+#define traceEVENT_MARK                   32U  /* Identifier, value. */
+
+/* One event, 16 bytes. */
+typedef struct xTRACE_EVENT
+{
+    uint32_t ulCycles;      /* DWT cycle counter, plus the time asleep. */
+    uint16_t usEvent;
+    uint16_t usSequence;    /* The number of the event, written last. */
+    uint32_t ulArg1;
+    uint32_t ulArg2;
+} TraceEvent_t;
+
+/**
+ * @brief Add an event to the ring.  Lock-free, from any task or interrupt.
+ */
+void vTraceRecord( uint32_t ulEvent,
+                   uint32_t ulArg1,
+                   uint32_t ulArg2 );
+
+/**
+ * @brief Add the CPU cycles of a sleep, during which the DWT cycle counter
+ * stands still.  Called by tickless idle, with interrupts masked.
+ */
+void vTraceAddSleepCycles( uint32_t ulCycles );
+
+#endif /* #ifndef TRACE_EVENTS_H */
@@ -0,0 +1,85 @@
+/* FreeRTOS includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+
+/* ST includes. */
+#include "stm32h7xx_hal.h"
+
+#include "uptime.h"
+
+#define uptimeUS_PER_TICK    ( 1000000UL / configTICK_RATE_HZ )
+
+/*
+ * Read SysTick, and tell whether it wrapped while its interrupt did not run
+ * yet.  Must be called with interrupts masked.
+ */
+static uint32_t prvReadSysTick( BaseType_t * pxPending );
+
+/*-----------------------------------------------------------*/
+
+static uint32_t prvReadSysTick( BaseType_t * pxPending )
+{
+    uint32_t ulCount = SysTick->VAL;
+    uint32_t ulReload = SysTick->LOAD + 1U;
+
+    *pxPending = pdFALSE;
+
+    if( ( SCB->ICSR & SCB_ICSR_PENDSTSET_Msk ) != 0U )
+    {
+        *pxPending = pdTRUE;
+        ulCount = SysTick->VAL;
+    }
+
+    /* SysTick counts down from LOAD to 0 once per tick. */
+    return ( uint32_t ) ( ( ( uint64_t ) ( ulReload - 1U - ulCount ) * uptimeUS_PER_TICK ) / ulReload );
+}
+/*-----------------------------------------------------------*/
+
+uint32_t ulUptimeMicroseconds( void )
+{
+    TickType_t xTicks;
+    uint32_t ulFraction;
+    BaseType_t xPending;
+    UBaseType_t uxSavedInterruptStatus;
+
+    uxSavedInterruptStatus = taskENTER_CRITICAL_FROM_ISR();
+    {
+        xTicks = xTaskGetTickCountFromISR();
+        ulFraction = prvReadSysTick( &xPending );
+    }
+    taskEXIT_CRITICAL_FROM_ISR( uxSavedInterruptStatus );
+
+    if( xPending != pdFALSE )
+    {
+        xTicks++;
+    }
+
+    return ( ( uint32_t ) xTicks * uptimeUS_PER_TICK ) + ulFraction;
+}
+/*-----------------------------------------------------------*/
+
+uint64_t ullUptimeMicroseconds( void )
+{
+    TimeOut_t xTimeOut;
+    uint64_t ullTicks;
+    uint32_t ulFraction;
+    BaseType_t xPending;
+
+    taskENTER_CRITICAL();
+    {
+        /* The only way to read the overflow count of the tick. */
+        vTaskSetTimeOutState( &xTimeOut );
+        ulFraction = prvReadSysTick( &xPending );
+    }
+    taskEXIT_CRITICAL();
+
+    ullTicks = ( ( uint64_t ) ( uint32_t ) xTimeOut.xOverflowCount << 32 ) + ( uint64_t ) xTimeOut.xTimeOnEntering;
+
+    if( xPending != pdFALSE )
+    {
+        ullTicks++;
+    }
+
+    return ( ullTicks * uptimeUS_PER_TICK ) + ulFraction;
+}
+/*-----------------------------------------------------------*/
@@ -0,0 +1,29 @@
+#ifndef UPTIME_H
+#define UPTIME_H
+
+/* FreeRTOS includes. */
+#include "FreeRTOS.h"
+
+/*
+ * A clock that counts microseconds since the scheduler started.  It comes
+ * from the tick count and the SysTick counter, so it needs no timer of its
+ * own.
+ *
+ * ulUptimeMicroseconds() wraps after about 71 minutes, so use it for
+ * intervals only, computed as the unsigned difference of two readings.
+ * ullUptimeMicroseconds() includes the tick overflow count of the kernel and
+ * does not wrap.
+ */
+
+/**
+ * @brief Read the 32-bit clock.  May be called from tasks and from interrupts
+ * below configMAX_SYSCALL_INTERRUPT_PRIORITY.
+ */
+uint32_t ulUptimeMicroseconds( void );
+
+/**
+ * @brief Read the 64-bit clock.  Only to be called from tasks.
+ */
+uint64_t ullUptimeMicroseconds( void );
+
+#endif /* #ifndef UPTIME_H */
@@ -0,0 +1,189 @@
+/* The log messages of this file, see log_levels.h. */
+#define logMODULE    eLogModuleApp
+
+/* FreeRTOS includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+
+/* FreeRTOS+TCP includes, for FreeRTOS_printf(). */
+#include "FreeRTOS_IP.h"
+
+#include "wall_clock.h"
+#include "uptime.h"
+
+/* A measured frequency error goes for 1 / wallclockDRIFT_GAIN into the
+ * frequency correction. */
+#define wallclockDRIFT_GAIN          4
+
+/* Offsets measured closer together than this do not train the frequency. */
+#define wallclockMIN_TRAIN_US        ( 16ULL * 1000000ULL )
+
+/*
+ * The time of day at an uptime, which must not be before ullBaseUptime.
+ * Returns the part of the slew applied so far through pllSlewed.
+ */
+static uint64_t prvWallAt( uint64_t ullUptime,
+                           int64_t * pllSlewed );
+
+/*
+ * Start a new period of constant rate at ullUptime, without a jump.
+ */
+static void prvRebase( uint64_t ullUptime );
+
+/*-----------------------------------------------------------*/
+
+/* The clock read ullBaseWall at ullBaseUptime, all in microseconds.  Since
+ * then it ran at the rate of the uptime clock plus lDriftPpb, plus the slew
+ * until llSlewUs is applied.  All protected by a critical section. */
+static uint64_t ullBaseUptime = 0U;
+static uint64_t ullBaseWall = 0U;
+static int64_t llSlewUs = 0;
+static int32_t lDriftPpb = 0;
+
+static uint64_t ullLastCorrection = 0U;
+static BaseType_t xIsSet = pdFALSE;
+
+/*-----------------------------------------------------------*/
+
+static uint64_t prvWallAt( uint64_t ullUptime,
+                           int64_t * pllSlewed )
+{
+    int64_t llElapsed = ( int64_t ) ( ullUptime - ullBaseUptime );
+    int64_t llSlewMax = ( llElapsed * configWALL_CLOCK_SLEW_PPM ) / 1000000;
+    int64_t llSlewed;
+    int64_t llDrift;
+
+    if( llSlewUs >= 0 )
+    {
+        llSlewed = ( llSlewUs < llSlewMax ) ? llSlewUs : llSlewMax;
+    }
+    else
+    {
+        llSlewed = ( -llSlewUs < llSlewMax ) ? llSlewUs : -llSlewMax;
+    }
+
+    *pllSlewed = llSlewed;
+
+    /* The drift in whole and partial seconds: llElapsed * lDriftPpb would
+     * overflow after some 200 days without a correction. */
+    llDrift = ( ( llElapsed / 1000000 ) * lDriftPpb ) / 1000 + ( ( llElapsed % 1000000 ) * lDriftPpb ) / 1000000000;
+
+    /* configWALL_CLOCK_SLEW_PPM and the drift are far below a million ppm,
+     * so the clock always moves forward. */
+    return ( uint64_t ) ( ( int64_t ) ullBaseWall + llElapsed + llDrift + llSlewed );
+}
+/*-----------------------------------------------------------*/
+
+static void prvRebase( uint64_t ullUptime )
+{
+    int64_t llSlewed;
+
+    ullBaseWall = prvWallAt( ullUptime, &llSlewed );
+    ullBaseUptime = ullUptime;
+    llSlewUs -= llSlewed;
+}
+/*-----------------------------------------------------------*/
+
+uint64_t ullWallClockMicroseconds( void )
+{
+    uint64_t ullWall;
+    int64_t llSlewed;
+
+    taskENTER_CRITICAL();
+    {
+        ullWall = prvWallAt( ullUptimeMicroseconds(), &llSlewed );
+    }
+    taskEXIT_CRITICAL();
+
+    return ullWall;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xWallClockIsSet( void )
+{
+    return xIsSet;
+}
+/*-----------------------------------------------------------*/
+
+void vWallClockCorrect( int64_t llOffsetUs,
+                        BaseType_t xTrainFrequency )
+{
+    uint64_t ullNow;
+    int64_t llInterval;
+    int64_t llResidual;
+    int64_t llDrift;
+    BaseType_t xStepped = pdFALSE;
+
+    taskENTER_CRITICAL();
+    {
+        ullNow = ullUptimeMicroseconds();
+        prvRebase( ullNow );
+
+        if( xIsSet == pdFALSE )
+        {
+            /* The first time, in any direction. */
+            ullBaseWall = ( ( llOffsetUs < 0 ) && ( ( uint64_t ) -llOffsetUs > ullBaseWall ) ) ? 0U : ( uint64_t ) ( ( int64_t ) ullBaseWall + llOffsetUs );
+            llSlewUs = 0;
+            xIsSet = pdTRUE;
+            xStepped = pdTRUE;
+        }
+        else
+        {
+            llInterval = ( int64_t ) ( ullNow - ullLastCorrection );
+
+            /* What is left after the slew that was still planned, grew with
+             * the drift since the last correction. */
+            llResidual = llOffsetUs - llSlewUs;
+
+            if( ( xTrainFrequency != pdFALSE ) && ( ullLastCorrection != 0U ) &&
+                ( llInterval >= ( int64_t ) wallclockMIN_TRAIN_US ) &&
+                ( llResidual <= ( ( int64_t ) configWALL_CLOCK_STEP_MS * 1000 ) ) &&
+                ( llResidual >= -( ( int64_t ) configWALL_CLOCK_STEP_MS * 1000 ) ) )
+            {
+                llDrift = lDriftPpb + ( ( ( llResidual * 1000000000 ) / llInterval ) / wallclockDRIFT_GAIN );
+
+                if( llDrift > ( configWALL_CLOCK_MAX_DRIFT_PPM * 1000 ) )
+                {
+                    llDrift = configWALL_CLOCK_MAX_DRIFT_PPM * 1000;
+                }
+                else if( llDrift < -( configWALL_CLOCK_MAX_DRIFT_PPM * 1000 ) )
+                {
+                    llDrift = -( configWALL_CLOCK_MAX_DRIFT_PPM * 1000 );
+                }
+                else
+                {
+                    /* Within the limits. */
+                }
+
+                lDriftPpb = ( int32_t ) llDrift;
+            }
+
+            if( ( xTrainFrequency == pdFALSE ) ||
+                ( llOffsetUs > ( ( int64_t ) configWALL_CLOCK_STEP_MS * 1000 ) ) )
+            {
+                /* A time set by hand is stepped in either direction. */
+                ullBaseWall = ( ( llOffsetUs < 0 ) && ( ( uint64_t ) -llOffsetUs > ullBaseWall ) ) ? 0U : ( uint64_t ) ( ( int64_t ) ullBaseWall + llOffsetUs );
+                llSlewUs = 0;
+                xStepped = pdTRUE;
+            }
+            else
+            {
+                /* The offset was measured against the clock as it is, with
+                 * the slew so far, so it replaces the remaining slew. */
+                llSlewUs = llOffsetUs;
+            }
+        }
+
+        if( xTrainFrequency != pdFALSE )
+        {
+            ullLastCorrection = ullNow;
+        }
+    }
+    taskEXIT_CRITICAL();
+
+    if( xStepped != pdFALSE )
+    {
+        FreeRTOS_printf( ( "wall clock: stepped by %d ms\n", ( int ) ( llOffsetUs / 1000 ) ) );
+    }
+}
+/*-----------------------------------------------------------*/
@@ -0,0 +1,68 @@
+#ifndef WALL_CLOCK_H
+#define WALL_CLOCK_H
+
+/* FreeRTOS includes. */
+#include "FreeRTOS.h"
+
+/*
+ * A software clock of the time of day, in microseconds since the Unix epoch.
+ *
+ * It runs on the microsecond uptime clock (uptime.h), corrected for the drift
+ * of the crystal.  The SNTP client (sntp.h) hands it every offset that it
+ * measures:
+ *
+ * - The first offset sets the clock.
+ * - Later offsets are slewed: the clock runs up to configWALL_CLOCK_SLEW_PPM
+ *   faster or slower until the offset is gone.
+ * - A forward offset of more than configWALL_CLOCK_STEP_MS is stepped.
+ * - Backward offsets are always slewed.  At the default rate of 5000 ppm, it
+ *   takes 200 seconds to take back one second.
+ *
+ * So once set by SNTP, the clock never goes backwards.  A time set by hand
+ * (set_time()) is an exception: it is stepped, in either direction.  The
+ * offsets of SNTP also train a frequency correction, so that the clock drifts
+ * less between two polls.
+ *
+ * Until the clock is set, it counts from 0, the epoch.
+ */
+
+/* Rate of the slew, in parts per million. */
+#ifndef configWALL_CLOCK_SLEW_PPM
+    #define configWALL_CLOCK_SLEW_PPM           5000
+#endif
+
+/* Forward offsets above this are stepped. */
+#ifndef configWALL_CLOCK_STEP_MS
+    #define configWALL_CLOCK_STEP_MS            1000
+#endif
+
+/* Limit of the frequency correction, in parts per million. */
+#ifndef configWALL_CLOCK_MAX_DRIFT_PPM
+    #define configWALL_CLOCK_MAX_DRIFT_PPM      500
+#endif
+
+/**
+ * @brief Read the clock.  Only to be called from tasks.
+ *
+ * @return Microseconds since 1970-01-01 00:00:00 UTC.
+ */
+uint64_t ullWallClockMicroseconds( void );
+
+/**
+ * @brief Whether the clock was set since the last reset.
+ */
+BaseType_t xWallClockIsSet( void );
+
+/**
+ * @brief Correct the clock.
+ *
+ * @param llOffsetUs The true time minus the time of the clock, in
+ * microseconds.
+ * @param xTrainFrequency pdTRUE when the offset is a measurement that may
+ * train the frequency correction and is slewed, pdFALSE for a time set by
+ * hand, which is stepped.
+ */
+void vWallClockCorrect( int64_t llOffsetUs,
+                        BaseType_t xTrainFrequency );
+
+#endif /* #ifndef WALL_CLOCK_H */
@@ -0,0 +1,102 @@
+/* Standard includes. */
+#include <string.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "fake_flash.h"
+
+static FakeFlash_t xFlash;
+
+/*
+ * Return pdTRUE when all bytes of a slot are 0xFF.
+ */
+static BaseType_t prvIsErased( size_t uxSlot );
+
+/*-----------------------------------------------------------*/
+
+void vFakeFlashReset( void )
+{
+    memset( &xFlash, 0, sizeof( xFlash ) );
+    memset( xFlash.ucSlots, 0xFF, sizeof( xFlash.ucSlots ) );
+}
+/*-----------------------------------------------------------*/
+
+FakeFlash_t * pxFakeFlash( void )
+{
+    return &xFlash;
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvIsErased( size_t uxSlot )
+{
+    BaseType_t xReturn = pdTRUE;
+    size_t x;
+
+    for( x = 0; x < dhcpleaseFLASH_WORD_SIZE; x++ )
+    {
+        if( xFlash.ucSlots[ uxSlot ][ x ] != 0xFFU )
+        {
+            xReturn = pdFALSE;
+            break;
+        }
+    }
+
+    return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xDHCPLeaseFlashRead( size_t uxSlot,
+                                void * pvWord )
+{
+    configASSERT( uxSlot < fakeFLASH_SLOTS );
+
+    memcpy( pvWord, xFlash.ucSlots[ uxSlot ], dhcpleaseFLASH_WORD_SIZE );
+
+    return ( xFlash.xECCError[ uxSlot ] == pdFALSE ) ? pdPASS : pdFAIL;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xDHCPLeaseFlashProgram( size_t uxSlot,
+                                   const void * pvWord )
+{
+    BaseType_t xReturn = pdPASS;
+
+    configASSERT( uxSlot < fakeFLASH_SLOTS );
+
+    xFlash.ulPrograms++;
+
+    if( prvIsErased( uxSlot ) == pdFALSE )
+    {
+        xFlash.xECCError[ uxSlot ] = pdTRUE;
+        xReturn = pdFAIL;
+    }
+    else
+    {
+        memcpy( xFlash.ucSlots[ uxSlot ], pvWord, dhcpleaseFLASH_WORD_SIZE );
+
+        if( xFlash.xWornOut != pdFALSE )
+        {
+            xFlash.ucSlots[ uxSlot ][ 9 ] ^= 0x10U;
+            xReturn = pdFAIL;
+        }
+    }
+
+    return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xDHCPLeaseFlashErase( void )
+{
+    xFlash.ulErases++;
+    xFlash.xEraseTick = xTaskGetTickCount();
+
+    if( xFlash.xEraseFails == pdFALSE )
+    {
+        memset( xFlash.ucSlots, 0xFF, sizeof( xFlash.ucSlots ) );
+        memset( xFlash.xECCError, 0, sizeof( xFlash.xECCError ) );
+    }
+
+    return ( xFlash.xEraseFails == pdFALSE ) ? pdPASS : pdFAIL;
+}
+/*-----------------------------------------------------------*/
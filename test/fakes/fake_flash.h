@@ -0,0 +1,38 @@
+#ifndef FAKE_FLASH_H
+#define FAKE_FLASH_H
+
+#include "FreeRTOS.h"
+
+#include "dhcp_lease_flash.h"
+
+/*
+ * A flash emulator behind dhcp_lease_flash.h, for the host tests.
+ *
+ * Erased bytes read as 0xFF.  A slot can be programmed once after an erase,
+ * programming it again corrupts its ECC, like on the STM32H7.  A slot with an
+ * ECC error fails xDHCPLeaseFlashRead(), as a slot torn by a reset does.
+ *
+ * The tests compile dhcp_lease.c with configDHCP_LEASE_RECORD_COUNT at most
+ * fakeFLASH_SLOTS.
+ */
+
+#define fakeFLASH_SLOTS    64U
+
+typedef struct xFAKE_FLASH
+{
+    uint8_t ucSlots[ fakeFLASH_SLOTS ][ dhcpleaseFLASH_WORD_SIZE ];
+    BaseType_t xECCError[ fakeFLASH_SLOTS ];
+    BaseType_t xWornOut;    /* Programming leaves a bit unchanged. */
+    BaseType_t xEraseFails; /* Erasing leaves the sector as it is. */
+    uint32_t ulPrograms;
+    uint32_t ulErases;
+    TickType_t xEraseTick;  /* When the last erase was done. */
+} FakeFlash_t;
+
+/* An erased sector, no faults, all counters 0. */
+void vFakeFlashReset( void );
+
+/* The sector and its counters, which a test may change at will. */
+FakeFlash_t * pxFakeFlash( void );
+
+#endif /* FAKE_FLASH_H */
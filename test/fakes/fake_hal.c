@@ -0,0 +1,119 @@
+/* Standard includes. */
+#include <stdint.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "stm32h7xx_hal.h"
+#include "fake_hal.h"
+
+/* The registers of stm32h7xx_hal.h, set by the tests. */
+SysTick_Type xFakeSysTick;
+SCB_Type xFakeSCB;
+CoreDebug_Type xFakeCoreDebug;
+RCC_TypeDef xFakeRCC;
+LPTIM_TypeDef xFakeLPTIM1;
+EXTI_TypeDef xFakeEXTI;
+EXTI_Core_TypeDef xFakeEXTI_D1;
+
+uint32_t SystemCoreClock = 64000000U;
+volatile uint32_t uwTick;
+
+static DWT_Type xDWT;
+static uint32_t ulLSIHz = 32000U;
+static uint32_t ulCyclesPerRead = 0U;
+static uint64_t ullLSIRemainder = 0U;
+static FakeSleepHook_t fnSleepHook = NULL;
+
+/*-----------------------------------------------------------*/
+
+uint32_t HAL_GetTick( void )
+{
+    return ( uint32_t ) xTaskGetTickCount();
+}
+/*-----------------------------------------------------------*/
+
+uint32_t HAL_GetUIDw0( void )
+{
+    return 0x00300040UL;
+}
+/*-----------------------------------------------------------*/
+
+uint32_t HAL_GetUIDw1( void )
+{
+    return 0x31395110UL;
+}
+/*-----------------------------------------------------------*/
+
+uint32_t HAL_GetUIDw2( void )
+{
+    return 0x33383437UL;
+}
+/*-----------------------------------------------------------*/
+
+void vFakeHALSetClocks( uint32_t ulLSI,
+                        uint32_t ulCycles )
+{
+    ulLSIHz = ulLSI;
+    ulCyclesPerRead = ulCycles;
+    ullLSIRemainder = 0U;
+}
+/*-----------------------------------------------------------*/
+
+void vFakeHALAdvanceCycles( uint32_t ulCycles )
+{
+    uint64_t ullCounts;
+
+    xDWT.CYCCNT += ulCycles;
+
+    ullLSIRemainder += ( uint64_t ) ulCycles * ulLSIHz;
+    ullCounts = ullLSIRemainder / SystemCoreClock;
+    ullLSIRemainder %= SystemCoreClock;
+    xFakeLPTIM1.CNT = ( uint32_t ) ( ( xFakeLPTIM1.CNT + ullCounts ) & 0xFFFFU );
+}
+/*-----------------------------------------------------------*/
+
+DWT_Type * pxFakeDWT( void )
+{
+    vFakeHALAdvanceCycles( ulCyclesPerRead );
+
+    return &xDWT;
+}
+/*-----------------------------------------------------------*/
+
+void vFakeHALSetSleepHook( FakeSleepHook_t fnHook )
+{
+    fnSleepHook = fnHook;
+}
+/*-----------------------------------------------------------*/
+
+void vFakeHALSleep( int xStop )
+{
+    if( fnSleepHook != NULL )
+    {
+        fnSleepHook( ( BaseType_t ) xStop );
+    }
+}
+/*-----------------------------------------------------------*/
+
+void HAL_PWREx_EnterSTOPMode( uint32_t Regulator,
+                              uint8_t STOPEntry,
+                              uint32_t Domain )
+{
+    ( void ) Regulator;
+    ( void ) STOPEntry;
+    ( void ) Domain;
+
+    vFakeHALSleep( 1 );
+}
+/*-----------------------------------------------------------*/
+
+void HAL_SuspendTick( void )
+{
+}
+/*-----------------------------------------------------------*/
+
+void HAL_ResumeTick( void )
+{
+}
+/*-----------------------------------------------------------*/
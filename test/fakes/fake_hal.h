@@ -0,0 +1,28 @@
+#ifndef FAKE_HAL_H
+#define FAKE_HAL_H
+
+#include "FreeRTOS.h"
+
+/*
+ * Control of the fake registers of stm32h7xx_hal.h.
+ *
+ * The CPU clock (DWT->CYCCNT) and the LSI (LPTIM1->CNT) only move when a
+ * test advances them, or by ulCycles on every access to DWT, so code that
+ * busy-waits on the cycle counter sees time pass.  __WFI() and
+ * HAL_PWREx_EnterSTOPMode() call the sleep hook, which plays the part of the
+ * interrupt that ends the sleep.
+ */
+
+typedef void (* FakeSleepHook_t)( BaseType_t xStop );
+
+/* The LSI frequency, and the CPU cycles that pass on each access to DWT. */
+void vFakeHALSetClocks( uint32_t ulLSI,
+                        uint32_t ulCycles );
+
+/* Move the CPU clock, and LPTIM1 with it, forward. */
+void vFakeHALAdvanceCycles( uint32_t ulCycles );
+
+/* Called when the core sleeps, NULL to remove it. */
+void vFakeHALSetSleepHook( FakeSleepHook_t fnHook );
+
+#endif /* FAKE_HAL_H */
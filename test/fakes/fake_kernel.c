@@ -0,0 +1,899 @@
+/* Standard includes. */
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "FreeRTOS.h"
+#include "list.h"
+#include "task.h"
+#include "queue.h"
+#include "semphr.h"
+#include "timers.h"
+
+#include "fake_kernel.h"
+
+typedef struct QueueDefinition
+{
+    uint8_t * pucItems;
+    UBaseType_t uxLength;
+    UBaseType_t uxItemSize;
+    UBaseType_t uxHead;
+    UBaseType_t uxCount;
+} FakeQueue_t;
+
+typedef struct tmrTimerControl
+{
+    TickType_t xPeriod;
+    TickType_t xExpiry;
+    BaseType_t xAutoReload;
+    BaseType_t xRunning;
+    void * pvTimerID;
+    TimerCallbackFunction_t pxCallback;
+} FakeTimer_t;
+
+typedef struct xFAKE_PENDED_CALL
+{
+    PendedFunction_t pxFunction;
+    void * pvParameter1;
+    uint32_t ulParameter2;
+} FakePendedCall_t;
+
+#define fakeMAX_TIMERS          8
+#define fakeMAX_PENDED_CALLS    8
+
+static pthread_mutex_t xLock;
+static pthread_once_t xLockOnce = PTHREAD_ONCE_INIT;
+static pthread_cond_t xChanged = PTHREAD_COND_INITIALIZER;
+
+static volatile TickType_t xTickCount = 0U;
+static FakeTickHook_t fnTickHook = NULL;
+static BaseType_t xUseThreads = pdFALSE;
+static TaskFunction_t pxLastTask = NULL;
+static size_t uxHeapInUse = 0U;
+static FakeTimer_t xTimers[ fakeMAX_TIMERS ];
+static size_t uxTimerCount = 0U;
+
+/* The calls for the timer task, run on the next tick like the timers. */
+static FakePendedCall_t xPendedCalls[ fakeMAX_PENDED_CALLS ];
+static size_t uxPendedCount = 0U;
+
+/* Tasks do not run, so all of them share one notification value. */
+static uint32_t ulNotifyValue = 0U;
+
+/*
+ * Call the callbacks of the timers that expire at the current tick, and the
+ * pended function calls.
+ */
+static void prvRunTimers( void );
+
+/*-----------------------------------------------------------*/
+
+static void prvInitLock( void )
+{
+    pthread_mutexattr_t xAttr;
+
+    pthread_mutexattr_init( &xAttr );
+    pthread_mutexattr_settype( &xAttr, PTHREAD_MUTEX_RECURSIVE );
+    pthread_mutex_init( &xLock, &xAttr );
+}
+/*-----------------------------------------------------------*/
+
+void vFakeEnterCritical( void )
+{
+    pthread_once( &xLockOnce, prvInitLock );
+    pthread_mutex_lock( &xLock );
+}
+/*-----------------------------------------------------------*/
+
+void vFakeExitCritical( void )
+{
+    pthread_mutex_unlock( &xLock );
+}
+/*-----------------------------------------------------------*/
+
+void vFakeKernelReset( void )
+{
+    xTickCount = 0U;
+    fnTickHook = NULL;
+    xUseThreads = pdFALSE;
+    pxLastTask = NULL;
+    uxTimerCount = 0U;
+    uxPendedCount = 0U;
+    ulNotifyValue = 0U;
+}
+/*-----------------------------------------------------------*/
+
+void vFakeKernelSetTickHook( FakeTickHook_t fnHook )
+{
+    fnTickHook = fnHook;
+}
+/*-----------------------------------------------------------*/
+
+void vFakeKernelAdvance( TickType_t xTicks )
+{
+    while( xTicks > 0U )
+    {
+        xTickCount++;
+
+        if( fnTickHook != NULL )
+        {
+            fnTickHook();
+        }
+
+        prvRunTimers();
+        xTicks--;
+    }
+}
+/*-----------------------------------------------------------*/
+
+void vFakeKernelSetTickCount( TickType_t xCount )
+{
+    xTickCount = xCount;
+}
+/*-----------------------------------------------------------*/
+
+void vFakeKernelUseThreads( void )
+{
+    xUseThreads = pdTRUE;
+}
+/*-----------------------------------------------------------*/
+
+TaskFunction_t pxFakeKernelLastTask( void )
+{
+    return pxLastTask;
+}
+/*-----------------------------------------------------------*/
+
+size_t uxFakeKernelHeapInUse( void )
+{
+    return uxHeapInUse;
+}
+/*-----------------------------------------------------------*/
+
+void vCrashAssert( const char * pcFile,
+                   uint32_t ulLine )
+{
+    fprintf( stderr, "configASSERT failed at %s:%u\n", pcFile, ( unsigned ) ulLine );
+    abort();
+}
+/*-----------------------------------------------------------*/
+
+void * pvPortMalloc( size_t xWantedSize )
+{
+    size_t * puxBlock = malloc( sizeof( size_t ) + xWantedSize );
+
+    if( puxBlock != NULL )
+    {
+        puxBlock[ 0 ] = xWantedSize;
+        uxHeapInUse += xWantedSize;
+        puxBlock++;
+    }
+
+    return puxBlock;
+}
+/*-----------------------------------------------------------*/
+
+void vPortFree( void * pv )
+{
+    size_t * puxBlock = pv;
+
+    if( puxBlock != NULL )
+    {
+        puxBlock--;
+        uxHeapInUse -= puxBlock[ 0 ];
+        free( puxBlock );
+    }
+}
+/*-----------------------------------------------------------*/
+
+size_t xPortGetFreeHeapSize( void )
+{
+    return 64U * 1024U;
+}
+/*-----------------------------------------------------------*/
+
+size_t xPortGetMinimumEverFreeHeapSize( void )
+{
+    return 64U * 1024U;
+}
+/*-----------------------------------------------------------*/
+
+/*
+ * Wait for a change of any queue.  Returns pdFALSE when the time is up.
+ * Called with xLock held.
+ */
+static BaseType_t prvBlock( TickType_t * pxTicksToWait )
+{
+    BaseType_t xReturn = pdTRUE;
+    struct timespec xDeadline;
+
+    if( *pxTicksToWait == 0U )
+    {
+        xReturn = pdFALSE;
+    }
+    else if( xUseThreads != pdFALSE )
+    {
+        clock_gettime( CLOCK_REALTIME, &xDeadline );
+        xDeadline.tv_nsec += 1000000L;
+
+        if( xDeadline.tv_nsec >= 1000000000L )
+        {
+            xDeadline.tv_sec++;
+            xDeadline.tv_nsec -= 1000000000L;
+        }
+
+        ( void ) pthread_cond_timedwait( &xChanged, &xLock, &xDeadline );
+    }
+    else
+    {
+        /* Nobody else runs: let the simulation take a step. */
+        pthread_mutex_unlock( &xLock );
+        vFakeKernelAdvance( 1U );
+        pthread_mutex_lock( &xLock );
+    }
+
+    if( ( xReturn != pdFALSE ) && ( *pxTicksToWait != portMAX_DELAY ) )
+    {
+        ( *pxTicksToWait )--;
+    }
+
+    return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+static QueueHandle_t prvCreate( UBaseType_t uxLength,
+                                UBaseType_t uxItemSize,
+                                UBaseType_t uxInitialCount )
+{
+    FakeQueue_t * pxQueue = calloc( 1, sizeof( *pxQueue ) );
+
+    pthread_once( &xLockOnce, prvInitLock );
+
+    if( pxQueue != NULL )
+    {
+        pxQueue->uxLength = uxLength;
+        pxQueue->uxItemSize = uxItemSize;
+        pxQueue->uxCount = uxInitialCount;
+        pxQueue->pucItems = calloc( uxLength, ( uxItemSize > 0U ) ? uxItemSize : 1U );
+    }
+
+    return pxQueue;
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvSend( QueueHandle_t xQueue,
+                           const void * pvItem,
+                           TickType_t xTicksToWait,
+                           BaseType_t xToFront )
+{
+    BaseType_t xReturn = pdFAIL;
+    UBaseType_t uxSlot;
+
+    pthread_mutex_lock( &xLock );
+
+    for( ; ; )
+    {
+        if( xQueue->uxCount < xQueue->uxLength )
+        {
+            if( xToFront != pdFALSE )
+            {
+                xQueue->uxHead = ( xQueue->uxHead + xQueue->uxLength - 1U ) % xQueue->uxLength;
+                uxSlot = xQueue->uxHead;
+            }
+            else
+            {
+                uxSlot = ( xQueue->uxHead + xQueue->uxCount ) % xQueue->uxLength;
+            }
+
+            if( xQueue->uxItemSize > 0U )
+            {
+                memcpy( &( xQueue->pucItems[ uxSlot * xQueue->uxItemSize ] ), pvItem, xQueue->uxItemSize );
+            }
+
+            xQueue->uxCount++;
+            pthread_cond_broadcast( &xChanged );
+            xReturn = pdPASS;
+            break;
+        }
+
+        if( prvBlock( &xTicksToWait ) == pdFALSE )
+        {
+            break;
+        }
+    }
+
+    pthread_mutex_unlock( &xLock );
+
+    return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+QueueHandle_t xQueueCreate( UBaseType_t uxQueueLength,
+                            UBaseType_t uxItemSize )
+{
+    return prvCreate( uxQueueLength, uxItemSize, 0U );
+}
+/*-----------------------------------------------------------*/
+
+QueueHandle_t xQueueCreateStatic( UBaseType_t uxQueueLength,
+                                  UBaseType_t uxItemSize,
+                                  uint8_t * pucQueueStorage,
+                                  StaticQueue_t * pxStaticQueue )
+{
+    ( void ) pucQueueStorage;
+    ( void ) pxStaticQueue;
+
+    return prvCreate( uxQueueLength, uxItemSize, 0U );
+}
+/*-----------------------------------------------------------*/
+
+void vQueueDelete( QueueHandle_t xQueue )
+{
+    free( xQueue->pucItems );
+    free( xQueue );
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xQueueSendToBack( QueueHandle_t xQueue,
+                             const void * pvItemToQueue,
+                             TickType_t xTicksToWait )
+{
+    return prvSend( xQueue, pvItemToQueue, xTicksToWait, pdFALSE );
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xQueueSendToFront( QueueHandle_t xQueue,
+                              const void * pvItemToQueue,
+                              TickType_t xTicksToWait )
+{
+    return prvSend( xQueue, pvItemToQueue, xTicksToWait, pdTRUE );
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xQueueSendToBackFromISR( QueueHandle_t xQueue,
+                                    const void * pvItemToQueue,
+                                    BaseType_t * pxHigherPriorityTaskWoken )
+{
+    if( pxHigherPriorityTaskWoken != NULL )
+    {
+        *pxHigherPriorityTaskWoken = pdFALSE;
+    }
+
+    return prvSend( xQueue, pvItemToQueue, 0U, pdFALSE );
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xQueueReceive( QueueHandle_t xQueue,
+                          void * pvBuffer,
+                          TickType_t xTicksToWait )
+{
+    BaseType_t xReturn = pdFAIL;
+
+    pthread_mutex_lock( &xLock );
+
+    for( ; ; )
+    {
+        if( xQueue->uxCount > 0U )
+        {
+            if( ( xQueue->uxItemSize > 0U ) && ( pvBuffer != NULL ) )
+            {
+                memcpy( pvBuffer, &( xQueue->pucItems[ xQueue->uxHead * xQueue->uxItemSize ] ), xQueue->uxItemSize );
+            }
+
+            xQueue->uxHead = ( xQueue->uxHead + 1U ) % xQueue->uxLength;
+            xQueue->uxCount--;
+            pthread_cond_broadcast( &xChanged );
+            xReturn = pdPASS;
+            break;
+        }
+
+        if( prvBlock( &xTicksToWait ) == pdFALSE )
+        {
+            break;
+        }
+    }
+
+    pthread_mutex_unlock( &xLock );
+
+    return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xQueueReceiveFromISR( QueueHandle_t xQueue,
+                                 void * pvBuffer,
+                                 BaseType_t * pxHigherPriorityTaskWoken )
+{
+    if( pxHigherPriorityTaskWoken != NULL )
+    {
+        *pxHigherPriorityTaskWoken = pdFALSE;
+    }
+
+    return xQueueReceive( xQueue, pvBuffer, 0U );
+}
+/*-----------------------------------------------------------*/
+
+UBaseType_t uxQueueMessagesWaiting( QueueHandle_t xQueue )
+{
+    UBaseType_t uxCount;
+
+    pthread_mutex_lock( &xLock );
+    uxCount = xQueue->uxCount;
+    pthread_mutex_unlock( &xLock );
+
+    return uxCount;
+}
+/*-----------------------------------------------------------*/
+
+UBaseType_t uxQueueMessagesWaitingFromISR( QueueHandle_t xQueue )
+{
+    return uxQueueMessagesWaiting( xQueue );
+}
+/*-----------------------------------------------------------*/
+
+UBaseType_t uxQueueSpacesAvailable( QueueHandle_t xQueue )
+{
+    return xQueue->uxLength - uxQueueMessagesWaiting( xQueue );
+}
+/*-----------------------------------------------------------*/
+
+void vQueueAddToRegistry( QueueHandle_t xQueue,
+                          const char * pcQueueName )
+{
+    ( void ) xQueue;
+    ( void ) pcQueueName;
+}
+/*-----------------------------------------------------------*/
+
+SemaphoreHandle_t xSemaphoreCreateBinary( void )
+{
+    return prvCreate( 1U, 0U, 0U );
+}
+/*-----------------------------------------------------------*/
+
+SemaphoreHandle_t xSemaphoreCreateBinaryStatic( StaticSemaphore_t * pxSemaphoreBuffer )
+{
+    ( void ) pxSemaphoreBuffer;
+
+    return prvCreate( 1U, 0U, 0U );
+}
+/*-----------------------------------------------------------*/
+
+SemaphoreHandle_t xSemaphoreCreateMutex( void )
+{
+    return prvCreate( 1U, 0U, 1U );
+}
+/*-----------------------------------------------------------*/
+
+SemaphoreHandle_t xSemaphoreCreateMutexStatic( StaticSemaphore_t * pxMutexBuffer )
+{
+    ( void ) pxMutexBuffer;
+
+    return prvCreate( 1U, 0U, 1U );
+}
+/*-----------------------------------------------------------*/
+
+SemaphoreHandle_t xSemaphoreCreateCounting( UBaseType_t uxMaxCount,
+                                            UBaseType_t uxInitialCount )
+{
+    return prvCreate( uxMaxCount, 0U, uxInitialCount );
+}
+/*-----------------------------------------------------------*/
+
+UBaseType_t uxSemaphoreGetCount( SemaphoreHandle_t xSemaphore )
+{
+    return uxQueueMessagesWaiting( xSemaphore );
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xTaskCreate( TaskFunction_t pxTaskCode,
+                        const char * const pcName,
+                        const uint16_t usStackDepth,
+                        void * const pvParameters,
+                        UBaseType_t uxPriority,
+                        TaskHandle_t * const pxCreatedTask )
+{
+    ( void ) pcName;
+    ( void ) usStackDepth;
+    ( void ) pvParameters;
+    ( void ) uxPriority;
+
+    pxLastTask = pxTaskCode;
+
+    if( pxCreatedTask != NULL )
+    {
+        *pxCreatedTask = ( TaskHandle_t ) pxTaskCode;
+    }
+
+    return pdPASS;
+}
+/*-----------------------------------------------------------*/
+
+TaskHandle_t xTaskCreateStatic( TaskFunction_t pxTaskCode,
+                                const char * const pcName,
+                                const uint32_t ulStackDepth,
+                                void * const pvParameters,
+                                UBaseType_t uxPriority,
+                                StackType_t * const puxStackBuffer,
+                                StaticTask_t * const pxTaskBuffer )
+{
+    TaskHandle_t xHandle = NULL;
+
+    ( void ) puxStackBuffer;
+    ( void ) pxTaskBuffer;
+
+    ( void ) xTaskCreate( pxTaskCode, pcName, ( uint16_t ) ulStackDepth, pvParameters, uxPriority, &xHandle );
+
+    return xHandle;
+}
+/*-----------------------------------------------------------*/
+
+void vTaskDelete( TaskHandle_t xTaskToDelete )
+{
+    ( void ) xTaskToDelete;
+}
+/*-----------------------------------------------------------*/
+
+void vTaskDelay( const TickType_t xTicksToDelay )
+{
+    struct timespec xSleep = { 0, 1000000L };
+    TickType_t xTicks;
+
+    for( xTicks = 0U; xTicks < xTicksToDelay; xTicks++ )
+    {
+        if( xUseThreads != pdFALSE )
+        {
+            nanosleep( &xSleep, NULL );
+        }
+        else
+        {
+            vFakeKernelAdvance( 1U );
+        }
+    }
+}
+/*-----------------------------------------------------------*/
+
+void vTaskDelayUntil( TickType_t * const pxPreviousWakeTime,
+                      const TickType_t xTimeIncrement )
+{
+    TickType_t xWake = *pxPreviousWakeTime + xTimeIncrement;
+
+    if( ( int32_t ) ( xWake - xTickCount ) > 0 )
+    {
+        vTaskDelay( xWake - xTickCount );
+    }
+
+    *pxPreviousWakeTime = xWake;
+}
+/*-----------------------------------------------------------*/
+
+TickType_t xTaskGetTickCount( void )
+{
+    return xTickCount;
+}
+/*-----------------------------------------------------------*/
+
+TickType_t xTaskGetTickCountFromISR( void )
+{
+    return xTickCount;
+}
+/*-----------------------------------------------------------*/
+
+/* The tick count never overflows in a test. */
+void vTaskSetTimeOutState( TimeOut_t * const pxTimeOut )
+{
+    pxTimeOut->xOverflowCount = 0;
+    pxTimeOut->xTimeOnEntering = xTickCount;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xTaskCheckForTimeOut( TimeOut_t * const pxTimeOut,
+                                 TickType_t * const pxTicksToWait )
+{
+    TickType_t xElapsed = xTickCount - pxTimeOut->xTimeOnEntering;
+    BaseType_t xReturn = pdFALSE;
+
+    if( *pxTicksToWait == portMAX_DELAY )
+    {
+        /* Waits forever. */
+    }
+    else if( xElapsed < *pxTicksToWait )
+    {
+        *pxTicksToWait -= xElapsed;
+        vTaskSetTimeOutState( pxTimeOut );
+    }
+    else
+    {
+        *pxTicksToWait = 0U;
+        xReturn = pdTRUE;
+    }
+
+    return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+TaskHandle_t xTaskGetCurrentTaskHandle( void )
+{
+    return ( TaskHandle_t ) ( uintptr_t ) pthread_self();
+}
+/*-----------------------------------------------------------*/
+
+char * pcTaskGetName( TaskHandle_t xTaskToQuery )
+{
+    static char cName[] = "host";
+
+    ( void ) xTaskToQuery;
+
+    return cName;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xTaskGetSchedulerState( void )
+{
+    return taskSCHEDULER_RUNNING;
+}
+/*-----------------------------------------------------------*/
+
+void vTaskSuspendAll( void )
+{
+    vFakeEnterCritical();
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xTaskResumeAll( void )
+{
+    vFakeExitCritical();
+
+    return pdFALSE;
+}
+/*-----------------------------------------------------------*/
+
+void vTaskStepTick( TickType_t xTicksToJump )
+{
+    xTickCount += xTicksToJump;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xTaskNotifyGive( TaskHandle_t xTaskToNotify )
+{
+    ( void ) xTaskToNotify;
+
+    vFakeEnterCritical();
+    ulNotifyValue++;
+    pthread_cond_broadcast( &xChanged );
+    vFakeExitCritical();
+
+    return pdPASS;
+}
+/*-----------------------------------------------------------*/
+
+void vTaskNotifyGiveFromISR( TaskHandle_t xTaskToNotify,
+                             BaseType_t * pxHigherPriorityTaskWoken )
+{
+    if( pxHigherPriorityTaskWoken != NULL )
+    {
+        *pxHigherPriorityTaskWoken = pdFALSE;
+    }
+
+    ( void ) xTaskNotifyGive( xTaskToNotify );
+}
+/*-----------------------------------------------------------*/
+
+uint32_t ulTaskNotifyTake( BaseType_t xClearCountOnExit,
+                           TickType_t xTicksToWait )
+{
+    uint32_t ulReturn = 0U;
+
+    vFakeEnterCritical();
+
+    for( ; ; )
+    {
+        if( ulNotifyValue > 0U )
+        {
+            ulReturn = ulNotifyValue;
+            ulNotifyValue = ( xClearCountOnExit != pdFALSE ) ? 0U : ( ulNotifyValue - 1U );
+            break;
+        }
+
+        if( prvBlock( &xTicksToWait ) == pdFALSE )
+        {
+            break;
+        }
+    }
+
+    vFakeExitCritical();
+
+    return ulReturn;
+}
+/*-----------------------------------------------------------*/
+
+static void prvRunTimers( void )
+{
+    FakeTimer_t * pxTimer;
+    FakePendedCall_t xCalls[ fakeMAX_PENDED_CALLS ];
+    size_t uxCount;
+    size_t x;
+
+    for( x = 0U; x < uxTimerCount; x++ )
+    {
+        pxTimer = &( xTimers[ x ] );
+
+        if( ( pxTimer->xRunning != pdFALSE ) && ( pxTimer->xExpiry == xTickCount ) )
+        {
+            pxTimer->xRunning = pxTimer->xAutoReload;
+            pxTimer->xExpiry = xTickCount + pxTimer->xPeriod;
+            pxTimer->pxCallback( pxTimer );
+        }
+    }
+
+    /* A pended call may pend another one, which runs on the next tick. */
+    uxCount = uxPendedCount;
+    uxPendedCount = 0U;
+    memcpy( xCalls, xPendedCalls, uxCount * sizeof( xCalls[ 0 ] ) );
+
+    for( x = 0U; x < uxCount; x++ )
+    {
+        xCalls[ x ].pxFunction( xCalls[ x ].pvParameter1, xCalls[ x ].ulParameter2 );
+    }
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xTimerPendFunctionCall( PendedFunction_t xFunctionToPend,
+                                   void * pvParameter1,
+                                   uint32_t ulParameter2,
+                                   TickType_t xTicksToWait )
+{
+    BaseType_t xReturn = pdFAIL;
+
+    ( void ) xTicksToWait;
+
+    if( uxPendedCount < fakeMAX_PENDED_CALLS )
+    {
+        xPendedCalls[ uxPendedCount ].pxFunction = xFunctionToPend;
+        xPendedCalls[ uxPendedCount ].pvParameter1 = pvParameter1;
+        xPendedCalls[ uxPendedCount ].ulParameter2 = ulParameter2;
+        uxPendedCount++;
+        xReturn = pdPASS;
+    }
+
+    return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xTimerPendFunctionCallFromISR( PendedFunction_t xFunctionToPend,
+                                          void * pvParameter1,
+                                          uint32_t ulParameter2,
+                                          BaseType_t * pxHigherPriorityTaskWoken )
+{
+    if( pxHigherPriorityTaskWoken != NULL )
+    {
+        *pxHigherPriorityTaskWoken = pdFALSE;
+    }
+
+    return xTimerPendFunctionCall( xFunctionToPend, pvParameter1, ulParameter2, 0U );
+}
+/*-----------------------------------------------------------*/
+
+TimerHandle_t xTimerCreate( const char * const pcTimerName,
+                            const TickType_t xTimerPeriodInTicks,
+                            const UBaseType_t uxAutoReload,
+                            void * const pvTimerID,
+                            TimerCallbackFunction_t pxCallbackFunction )
+{
+    FakeTimer_t * pxTimer = NULL;
+
+    ( void ) pcTimerName;
+
+    if( uxTimerCount < fakeMAX_TIMERS )
+    {
+        pxTimer = &( xTimers[ uxTimerCount ] );
+        uxTimerCount++;
+
+        memset( pxTimer, 0, sizeof( *pxTimer ) );
+        pxTimer->xPeriod = xTimerPeriodInTicks;
+        pxTimer->xAutoReload = ( uxAutoReload != 0U ) ? pdTRUE : pdFALSE;
+        pxTimer->pvTimerID = pvTimerID;
+        pxTimer->pxCallback = pxCallbackFunction;
+    }
+
+    return pxTimer;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xTimerStart( TimerHandle_t xTimer,
+                        TickType_t xTicksToWait )
+{
+    ( void ) xTicksToWait;
+
+    xTimer->xRunning = pdTRUE;
+    xTimer->xExpiry = xTickCount + xTimer->xPeriod;
+
+    return pdPASS;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xTimerStop( TimerHandle_t xTimer,
+                       TickType_t xTicksToWait )
+{
+    ( void ) xTicksToWait;
+
+    xTimer->xRunning = pdFALSE;
+
+    return pdPASS;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xTimerChangePeriod( TimerHandle_t xTimer,
+                               TickType_t xNewPeriod,
+                               TickType_t xTicksToWait )
+{
+    xTimer->xPeriod = xNewPeriod;
+
+    /* As in the kernel, this also starts the timer. */
+    return xTimerStart( xTimer, xTicksToWait );
+}
+/*-----------------------------------------------------------*/
+
+TickType_t xTimerGetPeriod( TimerHandle_t xTimer )
+{
+    return xTimer->xPeriod;
+}
+/*-----------------------------------------------------------*/
+
+void * pvTimerGetTimerID( const TimerHandle_t xTimer )
+{
+    return xTimer->pvTimerID;
+}
+/*-----------------------------------------------------------*/
+
+void vListInitialise( List_t * const pxList )
+{
+    pxList->xListEnd.xItemValue = portMAX_DELAY;
+    pxList->xListEnd.pxNext = &( pxList->xListEnd );
+    pxList->xListEnd.pxPrevious = &( pxList->xListEnd );
+    pxList->xListEnd.pvContainer = NULL;
+    pxList->pxIndex = &( pxList->xListEnd );
+    pxList->uxNumberOfItems = 0U;
+}
+/*-----------------------------------------------------------*/
+
+void vListInitialiseItem( ListItem_t * const pxItem )
+{
+    pxItem->pvContainer = NULL;
+}
+/*-----------------------------------------------------------*/
+
+void vListInsertEnd( List_t * const pxList,
+                     ListItem_t * const pxNewListItem )
+{
+    ListItem_t * const pxIndex = pxList->pxIndex;
+
+    /* In front of the index, so it is the last one that a walk visits. */
+    pxNewListItem->pxNext = pxIndex;
+    pxNewListItem->pxPrevious = pxIndex->pxPrevious;
+    pxIndex->pxPrevious->pxNext = pxNewListItem;
+    pxIndex->pxPrevious = pxNewListItem;
+    pxNewListItem->pvContainer = pxList;
+    pxList->uxNumberOfItems++;
+}
+/*-----------------------------------------------------------*/
+
+UBaseType_t uxListRemove( ListItem_t * const pxItemToRemove )
+{
+    List_t * const pxList = pxItemToRemove->pvContainer;
+
+    pxItemToRemove->pxNext->pxPrevious = pxItemToRemove->pxPrevious;
+    pxItemToRemove->pxPrevious->pxNext = pxItemToRemove->pxNext;
+
+    if( pxList->pxIndex == pxItemToRemove )
+    {
+        pxList->pxIndex = pxItemToRemove->pxPrevious;
+    }
+
+    pxItemToRemove->pvContainer = NULL;
+    pxList->uxNumberOfItems--;
+
+    return pxList->uxNumberOfItems;
+}
+/*-----------------------------------------------------------*/
@@ -0,0 +1,48 @@
+#ifndef FAKE_KERNEL_H
+#define FAKE_KERNEL_H
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+/*
+ * Control of the fake kernel of the host tests.
+ *
+ * Time only moves when a test advances it.  A task that blocks (a queue or
+ * semaphore with a block time, vTaskDelay()) advances the time itself, one
+ * tick at a time, and runs the tick hook on every tick, so a simulation
+ * hooked in there plays the part of the other tasks and the network.
+ *
+ * Software timers run their callbacks from vFakeKernelAdvance(), when the
+ * time reaches their expiry.  Pended function calls run on the next tick.
+ *
+ * Tasks are not run, so the task notifications of all of them share one
+ * value: a test plays the part of the task that waits for them.
+ *
+ * Tests that run real threads call vFakeKernelUseThreads(): blocking calls
+ * then wait on a condition variable, for one millisecond per tick, and the
+ * tick count does not move by itself.
+ */
+
+typedef void (* FakeTickHook_t)( void );
+
+/* Back to tick 0, no hook, no threads, no timers, no pended calls. */
+void vFakeKernelReset( void );
+
+/* Run fnHook on every tick, NULL to remove it. */
+void vFakeKernelSetTickHook( FakeTickHook_t fnHook );
+
+/* Move the time forward, running the tick hook on each tick. */
+void vFakeKernelAdvance( TickType_t xTicks );
+
+void vFakeKernelSetTickCount( TickType_t xCount );
+
+/* Block on real threads instead of advancing the time. */
+void vFakeKernelUseThreads( void );
+
+/* The last task that xTaskCreate() was asked to create, which does not run. */
+TaskFunction_t pxFakeKernelLastTask( void );
+
+/* Bytes that pvPortMalloc() handed out and that were not freed. */
+size_t uxFakeKernelHeapInUse( void );
+
+#endif /* FAKE_KERNEL_H */
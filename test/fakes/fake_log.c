@@ -0,0 +1,41 @@
+/* Standard includes. */
+#include <stdarg.h>
+#include <stdio.h>
+
+#include "FreeRTOS.h"
+
+#include "fake_log.h"
+
+/* Everything is shown, the tests check what the modules do, not the log. */
+LogModuleState_t xLogModules[ eLogModuleCount ] =
+{
+    [ 0 ... ( eLogModuleCount - 1 ) ] = { logLEVEL_DEBUG, 0U, 0U }
+};
+
+static uint32_t ulMessages = 0U;
+
+/*-----------------------------------------------------------*/
+
+void vLoggingPrintfLevel( LogModule_t xModule,
+                          uint8_t ucLevel,
+                          const char * pcFormat,
+                          ... )
+{
+    va_list xArgs;
+
+    ( void ) xModule;
+    ( void ) ucLevel;
+
+    ulMessages++;
+
+    va_start( xArgs, pcFormat );
+    vprintf( pcFormat, xArgs );
+    va_end( xArgs );
+}
+/*-----------------------------------------------------------*/
+
+uint32_t ulFakeLogMessages( void )
+{
+    return ulMessages;
+}
+/*-----------------------------------------------------------*/
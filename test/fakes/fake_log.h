@@ -0,0 +1,14 @@
+#ifndef FAKE_LOG_H
+#define FAKE_LOG_H
+
+#include "log_levels.h"
+
+/*
+ * A stand-in for logging.c, for the tests of modules that log: messages are
+ * printed to stdout right away.
+ */
+
+/* The number of messages logged so far. */
+uint32_t ulFakeLogMessages( void );
+
+#endif /* FAKE_LOG_H */
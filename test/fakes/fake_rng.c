@@ -0,0 +1,140 @@
+#include "FreeRTOS.h"
+
+#include "stm32h7xx_hal.h"
+#include "fake_rng.h"
+
+static uint32_t ulRNGNextWord = 1U;
+static uint32_t ulRNGErrorCode = HAL_RNG_ERROR_NONE;
+static uint32_t ulRNGErrors = 0U;
+static uint32_t ulRNGConversions = 0U;
+static uint32_t ulRNGRecoveries = 0U;
+static RNG_HandleTypeDef * pxRNGRunning = NULL;
+
+/*
+ * One conversion: pdPASS and the next word, or pdFAIL and the error code in
+ * the handle.
+ */
+static BaseType_t prvRNGConvert( RNG_HandleTypeDef * pxRNG,
+                                 uint32_t * pulWord );
+
+/*-----------------------------------------------------------*/
+
+void vFakeRNGReset( void )
+{
+    ulRNGNextWord = 1U;
+    ulRNGErrorCode = HAL_RNG_ERROR_NONE;
+    ulRNGErrors = 0U;
+    ulRNGConversions = 0U;
+    ulRNGRecoveries = 0U;
+    pxRNGRunning = NULL;
+}
+/*-----------------------------------------------------------*/
+
+void vFakeRNGFail( uint32_t ulErrorCode,
+                   uint32_t ulCount )
+{
+    ulRNGErrorCode = ulErrorCode;
+    ulRNGErrors = ulCount;
+}
+/*-----------------------------------------------------------*/
+
+uint32_t ulFakeRNGConversions( void )
+{
+    return ulRNGConversions;
+}
+/*-----------------------------------------------------------*/
+
+uint32_t ulFakeRNGRecoveries( void )
+{
+    return ulRNGRecoveries;
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvRNGConvert( RNG_HandleTypeDef * pxRNG,
+                                 uint32_t * pulWord )
+{
+    BaseType_t xReturn = pdPASS;
+
+    if( ulRNGErrors > 0U )
+    {
+        ulRNGErrors--;
+        pxRNG->ErrorCode = ulRNGErrorCode;
+        xReturn = pdFAIL;
+    }
+    else
+    {
+        *pulWord = ulRNGNextWord;
+        ulRNGNextWord++;
+    }
+
+    return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+HAL_StatusTypeDef HAL_RNG_GenerateRandomNumber( RNG_HandleTypeDef * hrng,
+                                                uint32_t * random32bit )
+{
+    HAL_StatusTypeDef xStatus = HAL_BUSY;
+
+    if( hrng->State == HAL_RNG_STATE_READY )
+    {
+        ulRNGConversions++;
+        xStatus = ( prvRNGConvert( hrng, random32bit ) == pdPASS ) ? HAL_OK : HAL_ERROR;
+    }
+
+    return xStatus;
+}
+/*-----------------------------------------------------------*/
+
+HAL_StatusTypeDef HAL_RNG_GenerateRandomNumber_IT( RNG_HandleTypeDef * hrng )
+{
+    HAL_StatusTypeDef xStatus = HAL_BUSY;
+
+    if( ( hrng->State == HAL_RNG_STATE_READY ) && ( hrng->Lock == HAL_UNLOCKED ) )
+    {
+        ulRNGConversions++;
+        hrng->State = HAL_RNG_STATE_BUSY;
+        pxRNGRunning = hrng;
+        xStatus = HAL_OK;
+    }
+
+    return xStatus;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xFakeRNGInterrupt( void )
+{
+    RNG_HandleTypeDef * pxRNG = pxRNGRunning;
+    uint32_t ulWord = 0U;
+
+    if( pxRNG != NULL )
+    {
+        pxRNGRunning = NULL;
+
+        if( prvRNGConvert( pxRNG, &ulWord ) == pdPASS )
+        {
+            pxRNG->RandomNumber = ulWord;
+            pxRNG->State = HAL_RNG_STATE_READY;
+            HAL_RNG_ReadyDataCallback( pxRNG, ulWord );
+        }
+        else
+        {
+            /* Like HAL_RNG_IRQHandler(), which leaves the handle locked. */
+            pxRNG->State = HAL_RNG_STATE_ERROR;
+            pxRNG->Lock = HAL_LOCKED;
+            HAL_RNG_ErrorCallback( pxRNG );
+        }
+    }
+
+    return ( pxRNG != NULL ) ? pdTRUE : pdFALSE;
+}
+/*-----------------------------------------------------------*/
+
+HAL_StatusTypeDef HAL_RNGEx_RecoverSeedError( RNG_HandleTypeDef * hrng )
+{
+    ulRNGRecoveries++;
+    hrng->ErrorCode &= ~HAL_RNG_ERROR_SEED;
+
+    return HAL_OK;
+}
+/*-----------------------------------------------------------*/
@@ -0,0 +1,33 @@
+#ifndef FAKE_RNG_H
+#define FAKE_RNG_H
+
+#include "FreeRTOS.h"
+
+/*
+ * Control of the fake RNG of stm32h7xx_hal.h.
+ *
+ * The RNG delivers the words 1, 2, 3, ... in that order, so that a test can
+ * tell which word went where.  A conversion started in interrupt mode
+ * completes when the test plays the interrupt with xFakeRNGInterrupt().
+ */
+
+/* Back to word 1, no conversion running, no errors to come. */
+void vFakeRNGReset( void );
+
+/* The next ulCount conversions fail with ulErrorCode, HAL_RNG_ERROR_SEED or
+ * HAL_RNG_ERROR_CLOCK. */
+void vFakeRNGFail( uint32_t ulErrorCode,
+                   uint32_t ulCount );
+
+/* Complete the conversion that runs in interrupt mode, which calls
+ * HAL_RNG_ReadyDataCallback() or HAL_RNG_ErrorCallback().  Returns pdFALSE
+ * when no conversion was running. */
+BaseType_t xFakeRNGInterrupt( void );
+
+/* Conversions started, in polling and in interrupt mode. */
+uint32_t ulFakeRNGConversions( void );
+
+/* Calls of HAL_RNGEx_RecoverSeedError(). */
+uint32_t ulFakeRNGRecoveries( void );
+
+#endif /* FAKE_RNG_H */
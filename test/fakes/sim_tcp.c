@@ -0,0 +1,739 @@
+/* Standard includes. */
+#include <stdlib.h>
+#include <string.h>
+
+#include "FreeRTOS.h"
+#include "semphr.h"
+#include "FreeRTOS_IP.h"
+#include "FreeRTOS_Sockets.h"
+
+#include "fake_kernel.h"
+#include "sim_tcp.h"
+
+/* Segments and ACKs that can be on the link at the same time. */
+#define simMAX_SEGMENTS      4096U
+#define simMAX_ACKS          8192U
+
+/* The peer keeps this many bytes of what it received. */
+#define simRECEIVED_SIZE     ( 8U * 1024U * 1024U )
+
+/* Out-of-order ranges that the peer remembers. */
+#define simMAX_RANGES        64U
+
+#define simMAX_MSS           1460U
+
+/* Ethernet, IPv4 and TCP headers without options. */
+#define simHEADERS_SIZE      54U
+
+typedef struct xSIM_SEGMENT
+{
+    uint32_t ulSeq;
+    uint32_t ulLength;
+    uint32_t ulArrival;      /* 0 while waiting in the bottleneck queue. */
+    uint8_t ucData[ simMAX_MSS ];
+} SimSegment_t;
+
+typedef struct xSIM_ACK
+{
+    uint32_t ulAck;
+    uint32_t ulWindow;
+    uint32_t ulArrival;
+} SimAck_t;
+
+typedef struct xSIM_RANGE
+{
+    uint32_t ulStart;
+    uint32_t ulEnd;
+} SimRange_t;
+
+struct xSOCKET
+{
+    SimTCPConfig_t xConfig;
+    SimTCPStats_t xStats;
+    BaseType_t xConnected;
+    BaseType_t xFullSize;
+    SemaphoreHandle_t xSemaphore;
+    TickType_t xSendTimeout;
+
+    /* The TX stream, positions count bytes from the start. */
+    uint8_t * pucStream;
+    BaseType_t xStreamCreated;
+    uint32_t ulWritten;
+    uint32_t ulUnacked;
+    uint32_t ulNext;
+    uint32_t ulHighest;
+
+    /* Loss recovery of the sending stack. */
+    uint32_t ulPeerWindow;
+    uint32_t ulDupAcks;
+    BaseType_t xInRecovery;
+    uint32_t ulRecover;
+    uint32_t ulRTO;
+    uint32_t ulLastProgress;
+    uint32_t ulNewSegments;
+
+    /* The link: a FIFO of segments, the first ulQueued wait for the
+     * bottleneck, the others are on the wire. */
+    SimSegment_t * pxSegments;
+    uint32_t ulSegHead;
+    uint32_t ulSegCount;
+    uint32_t ulSegServed;
+    uint32_t ulQueueBytes;
+    uint32_t ulCredit;
+
+    SimAck_t xAcks[ simMAX_ACKS ];
+    uint32_t ulAckHead;
+    uint32_t ulAckCount;
+
+    /* The peer. */
+    uint32_t ulReceiveNext;
+    SimRange_t xRanges[ simMAX_RANGES ];
+    uint32_t ulRanges;
+    uint8_t * pucReceived;
+};
+
+static struct xSOCKET xSim;
+
+static BaseType_t prvDriverOutput( NetworkInterface_t * pxInterface,
+                                   NetworkBufferDescriptor_t * const pxNetworkBuffer,
+                                   BaseType_t xReleaseAfterSend );
+
+static NetworkInterface_t xInterface = { "sim", prvDriverOutput, NULL };
+static uint8_t ucFrame[ simHEADERS_SIZE + simMAX_MSS ];
+
+/*-----------------------------------------------------------*/
+
+void vSimTCPInit( const SimTCPConfig_t * pxConfig )
+{
+    free( xSim.pucStream );
+    free( xSim.pxSegments );
+    free( xSim.pucReceived );
+
+    memset( &xSim, 0, sizeof( xSim ) );
+    memcpy( &( xSim.xConfig ), pxConfig, sizeof( xSim.xConfig ) );
+
+    if( xSim.xConfig.ulMSS == 0U )
+    {
+        xSim.xConfig.ulMSS = simMAX_MSS;
+    }
+
+    if( xSim.xConfig.ulStackRTO == 0U )
+    {
+        xSim.xConfig.ulStackRTO = 200U;
+    }
+
+    xSim.xConnected = pdTRUE;
+    xSim.xSendTimeout = pdMS_TO_TICKS( 5000U );
+    xSim.ulPeerWindow = xSim.xConfig.ulPeerWindow;
+    xSim.ulRTO = xSim.xConfig.ulStackRTO;
+    xSim.pucStream = calloc( 1, xSim.xConfig.uxTxStreamSize );
+    xSim.pxSegments = calloc( simMAX_SEGMENTS, sizeof( SimSegment_t ) );
+    xSim.pucReceived = calloc( 1, simRECEIVED_SIZE );
+
+    vFakeKernelSetTickHook( vSimTCPTick );
+}
+/*-----------------------------------------------------------*/
+
+Socket_t xSimTCPSocket( void )
+{
+    return &xSim;
+}
+/*-----------------------------------------------------------*/
+
+NetworkInterface_t * pxSimTCPInterface( void )
+{
+    return &xInterface;
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvDriverOutput( NetworkInterface_t * pxInterface,
+                                   NetworkBufferDescriptor_t * const pxNetworkBuffer,
+                                   BaseType_t xReleaseAfterSend )
+{
+    ( void ) pxInterface;
+    ( void ) pxNetworkBuffer;
+    ( void ) xReleaseAfterSend;
+
+    return pdTRUE;
+}
+/*-----------------------------------------------------------*/
+
+static void prvPut16( uint8_t * pucBuffer,
+                      uint16_t usValue )
+{
+    pucBuffer[ 0 ] = ( uint8_t ) ( usValue >> 8 );
+    pucBuffer[ 1 ] = ( uint8_t ) usValue;
+}
+/*-----------------------------------------------------------*/
+
+/* The stack hands the segment to the driver.  Only the headers are filled
+ * in, the data stays in the simulated link. */
+static void prvOutput( uint32_t ulSeq,
+                       uint32_t ulLength )
+{
+    NetworkBufferDescriptor_t xBuffer;
+    uint8_t * pucIP = &( ucFrame[ 14 ] );
+    uint8_t * pucTCP = &( ucFrame[ 34 ] );
+
+    memset( ucFrame, 0, simHEADERS_SIZE );
+    prvPut16( &( ucFrame[ 12 ] ), 0x0800U );
+    pucIP[ 0 ] = 0x45U;
+    prvPut16( &( pucIP[ 2 ] ), ( uint16_t ) ( 40U + ulLength ) );
+    pucIP[ 8 ] = 64U;
+    pucIP[ 9 ] = 6U;
+    prvPut16( &( pucTCP[ 0 ] ), simLOCAL_PORT );
+    prvPut16( &( pucTCP[ 2 ] ), simREMOTE_PORT );
+    prvPut16( &( pucTCP[ 4 ] ), ( uint16_t ) ( ulSeq >> 16 ) );
+    prvPut16( &( pucTCP[ 6 ] ), ( uint16_t ) ulSeq );
+    pucTCP[ 12 ] = 0x50U;
+    pucTCP[ 13 ] = 0x18U;
+
+    memset( &xBuffer, 0, sizeof( xBuffer ) );
+    xBuffer.pucEthernetBuffer = ucFrame;
+    xBuffer.xDataLength = simHEADERS_SIZE + ulLength;
+    ( void ) xInterface.pfOutput( &xInterface, &xBuffer, pdFALSE );
+}
+/*-----------------------------------------------------------*/
+
+void vSimTCPGetStats( SimTCPStats_t * pxStats )
+{
+    memcpy( pxStats, &( xSim.xStats ), sizeof( *pxStats ) );
+}
+/*-----------------------------------------------------------*/
+
+const uint8_t * pucSimTCPReceived( void )
+{
+    return xSim.pucReceived;
+}
+/*-----------------------------------------------------------*/
+
+uint32_t ulSimTCPQueuedBytes( void )
+{
+    return xSim.ulQueueBytes;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xSimTCPFullSize( void )
+{
+    return xSim.xFullSize;
+}
+/*-----------------------------------------------------------*/
+
+void vSimTCPSetPeerWindow( uint32_t ulWindow )
+{
+    /* A window update reaches the sender right away. */
+    xSim.xConfig.ulPeerWindow = ulWindow;
+    xSim.ulPeerWindow = ulWindow;
+}
+/*-----------------------------------------------------------*/
+
+void vSimTCPDisconnect( void )
+{
+    xSim.xConnected = pdFALSE;
+
+    if( xSim.xSemaphore != NULL )
+    {
+        ( void ) xSemaphoreGive( xSim.xSemaphore );
+    }
+}
+/*-----------------------------------------------------------*/
+
+static void prvTransmit( uint32_t ulSeq,
+                         uint32_t ulLength,
+                         BaseType_t xNew )
+{
+    SimSegment_t * pxSegment;
+    uint32_t ulOffset;
+    uint32_t ulByte;
+    BaseType_t xDrop = pdFALSE;
+
+    xSim.xStats.ulSegments++;
+    prvOutput( ulSeq, ulLength );
+
+    if( ulLength < xSim.xConfig.ulMSS )
+    {
+        xSim.xStats.ulPartialSegments++;
+    }
+
+    if( xNew != pdFALSE )
+    {
+        xSim.ulNewSegments++;
+
+        if( ( xSim.xConfig.ulLossEvery != 0U ) && ( ( xSim.ulNewSegments % xSim.xConfig.ulLossEvery ) == 0U ) )
+        {
+            xDrop = pdTRUE;
+        }
+    }
+
+    if( ( xSim.xConfig.ulQueueLimit != 0U ) && ( ( xSim.ulQueueBytes + ulLength ) > xSim.xConfig.ulQueueLimit ) )
+    {
+        xSim.xStats.ulOverflows++;
+        xDrop = pdTRUE;
+    }
+
+    if( ( xDrop != pdFALSE ) || ( xSim.ulSegCount == simMAX_SEGMENTS ) )
+    {
+        xSim.xStats.ulDrops++;
+    }
+    else
+    {
+        pxSegment = &( xSim.pxSegments[ ( xSim.ulSegHead + xSim.ulSegCount ) % simMAX_SEGMENTS ] );
+        pxSegment->ulSeq = ulSeq;
+        pxSegment->ulLength = ulLength;
+        pxSegment->ulArrival = 0U;
+
+        /* The stack copies from its stream into a network buffer. */
+        for( ulOffset = 0U; ulOffset < ulLength; ulOffset++ )
+        {
+            ulByte = ( ulSeq + ulOffset ) % ( uint32_t ) xSim.xConfig.uxTxStreamSize;
+            pxSegment->ucData[ ulOffset ] = xSim.pucStream[ ulByte ];
+        }
+
+        xSim.ulSegCount++;
+        xSim.ulQueueBytes += ulLength;
+
+        if( xSim.ulQueueBytes > xSim.xStats.ulMaxQueue )
+        {
+            xSim.xStats.ulMaxQueue = xSim.ulQueueBytes;
+        }
+    }
+}
+/*-----------------------------------------------------------*/
+
+static void prvRetransmit( void )
+{
+    uint32_t ulLength = xSim.ulHighest - xSim.ulUnacked;
+
+    if( ulLength > xSim.xConfig.ulMSS )
+    {
+        ulLength = xSim.xConfig.ulMSS;
+    }
+
+    if( ulLength > 0U )
+    {
+        xSim.xStats.ulRetransmits++;
+        prvTransmit( xSim.ulUnacked, ulLength, pdFALSE );
+    }
+}
+/*-----------------------------------------------------------*/
+
+static void prvPeerReceive( const SimSegment_t * pxSegment,
+                            uint32_t ulNow )
+{
+    uint32_t ulStart = pxSegment->ulSeq;
+    uint32_t ulEnd = pxSegment->ulSeq + pxSegment->ulLength;
+    uint32_t ulIndex;
+    BaseType_t xMerged;
+    SimAck_t * pxAck;
+
+    if( ( ulEnd <= simRECEIVED_SIZE ) && ( ulEnd > xSim.ulReceiveNext ) )
+    {
+        memcpy( &( xSim.pucReceived[ ulStart ] ), pxSegment->ucData, pxSegment->ulLength );
+    }
+
+    if( ulEnd > xSim.ulReceiveNext )
+    {
+        if( ulStart <= xSim.ulReceiveNext )
+        {
+            xSim.xStats.ulDelivered += ulEnd - xSim.ulReceiveNext;
+            xSim.ulReceiveNext = ulEnd;
+        }
+        else if( xSim.ulRanges < simMAX_RANGES )
+        {
+            xSim.xRanges[ xSim.ulRanges ].ulStart = ulStart;
+            xSim.xRanges[ xSim.ulRanges ].ulEnd = ulEnd;
+            xSim.ulRanges++;
+        }
+
+        /* Take in what was received out of order before. */
+        do
+        {
+            xMerged = pdFALSE;
+
+            for( ulIndex = 0U; ulIndex < xSim.ulRanges; ulIndex++ )
+            {
+                if( xSim.xRanges[ ulIndex ].ulStart <= xSim.ulReceiveNext )
+                {
+                    if( xSim.xRanges[ ulIndex ].ulEnd > xSim.ulReceiveNext )
+                    {
+                        xSim.xStats.ulDelivered += xSim.xRanges[ ulIndex ].ulEnd - xSim.ulReceiveNext;
+                        xSim.ulReceiveNext = xSim.xRanges[ ulIndex ].ulEnd;
+                    }
+
+                    xSim.ulRanges--;
+                    xSim.xRanges[ ulIndex ] = xSim.xRanges[ xSim.ulRanges ];
+                    xMerged = pdTRUE;
+                    break;
+                }
+            }
+        } while( xMerged != pdFALSE );
+    }
+
+    /* Every segment is acknowledged, a duplicate ACK for one that is out of
+     * order. */
+    if( xSim.ulAckCount < simMAX_ACKS )
+    {
+        pxAck = &( xSim.xAcks[ ( xSim.ulAckHead + xSim.ulAckCount ) % simMAX_ACKS ] );
+        pxAck->ulAck = xSim.ulReceiveNext;
+        pxAck->ulWindow = xSim.xConfig.ulPeerWindow;
+        pxAck->ulArrival = ulNow + xSim.xConfig.ulAckDelay + xSim.xConfig.ulDelay;
+        xSim.ulAckCount++;
+    }
+}
+/*-----------------------------------------------------------*/
+
+static void prvSenderAck( const SimAck_t * pxAck,
+                          uint32_t ulNow )
+{
+    xSim.ulPeerWindow = pxAck->ulWindow;
+
+    if( pxAck->ulAck > xSim.ulUnacked )
+    {
+        xSim.xStats.ulAcked += pxAck->ulAck - xSim.ulUnacked;
+        xSim.ulUnacked = pxAck->ulAck;
+        xSim.ulDupAcks = 0U;
+        xSim.ulLastProgress = ulNow;
+        xSim.ulRTO = xSim.xConfig.ulStackRTO;
+
+        if( xSim.ulNext < xSim.ulUnacked )
+        {
+            xSim.ulNext = xSim.ulUnacked;
+        }
+
+        if( xSim.xInRecovery != pdFALSE )
+        {
+            if( xSim.ulUnacked < xSim.ulRecover )
+            {
+                /* A partial ACK: the next hole. */
+                prvRetransmit();
+            }
+            else
+            {
+                xSim.xInRecovery = pdFALSE;
+            }
+        }
+
+        if( xSim.xSemaphore != NULL )
+        {
+            ( void ) xSemaphoreGive( xSim.xSemaphore );
+        }
+    }
+    else if( ( pxAck->ulAck == xSim.ulUnacked ) && ( xSim.ulHighest > xSim.ulUnacked ) )
+    {
+        xSim.ulDupAcks++;
+
+        if( ( xSim.ulDupAcks == 3U ) && ( xSim.xInRecovery == pdFALSE ) )
+        {
+            xSim.xStats.ulFastRetransmits++;
+            xSim.xInRecovery = pdTRUE;
+            xSim.ulRecover = xSim.ulHighest;
+            xSim.ulLastProgress = ulNow;
+            prvRetransmit();
+        }
+    }
+}
+/*-----------------------------------------------------------*/
+
+static void prvSendNew( void )
+{
+    uint32_t ulLimit;
+    uint32_t ulLength;
+    uint32_t ulWindow = xSim.ulPeerWindow;
+
+    if( ( xSim.xConfig.ulTxWindow != 0U ) && ( ulWindow > ( xSim.xConfig.ulTxWindow * xSim.xConfig.ulMSS ) ) )
+    {
+        ulWindow = xSim.xConfig.ulTxWindow * xSim.xConfig.ulMSS;
+    }
+
+    ulLimit = xSim.ulUnacked + ulWindow;
+
+    while( ( xSim.ulNext < xSim.ulWritten ) && ( xSim.ulNext < ulLimit ) )
+    {
+        ulLength = xSim.ulWritten - xSim.ulNext;
+
+        if( ulLength > xSim.xConfig.ulMSS )
+        {
+            ulLength = xSim.xConfig.ulMSS;
+        }
+
+        if( ulLength > ( ulLimit - xSim.ulNext ) )
+        {
+            /* Silly window avoidance. */
+            break;
+        }
+
+        if( ( ulLength < xSim.xConfig.ulMSS ) && ( xSim.xFullSize != pdFALSE ) && ( xSim.xConfig.xNoFullSize == pdFALSE ) )
+        {
+            break;
+        }
+
+        if( xSim.ulHighest == xSim.ulUnacked )
+        {
+            xSim.ulLastProgress = ( uint32_t ) xTaskGetTickCount();
+        }
+
+        prvTransmit( xSim.ulNext, ulLength, ( xSim.ulNext >= xSim.ulHighest ) ? pdTRUE : pdFALSE );
+        xSim.ulNext += ulLength;
+
+        if( xSim.ulNext > xSim.ulHighest )
+        {
+            xSim.ulHighest = xSim.ulNext;
+        }
+    }
+}
+/*-----------------------------------------------------------*/
+
+void vSimTCPTick( void )
+{
+    uint32_t ulNow = ( uint32_t ) xTaskGetTickCount();
+    SimSegment_t * pxSegment;
+    uint32_t ulIndex;
+
+    if( xSim.xConnected == pdFALSE )
+    {
+        return;
+    }
+
+    /* Segments that reach the peer. */
+    while( xSim.ulSegServed > 0U )
+    {
+        pxSegment = &( xSim.pxSegments[ xSim.ulSegHead ] );
+
+        if( pxSegment->ulArrival > ulNow )
+        {
+            break;
+        }
+
+        prvPeerReceive( pxSegment, ulNow );
+        xSim.ulSegHead = ( xSim.ulSegHead + 1U ) % simMAX_SEGMENTS;
+        xSim.ulSegCount--;
+        xSim.ulSegServed--;
+    }
+
+    /* ACKs that reach the sender. */
+    while( ( xSim.ulAckCount > 0U ) && ( xSim.xAcks[ xSim.ulAckHead ].ulArrival <= ulNow ) )
+    {
+        prvSenderAck( &( xSim.xAcks[ xSim.ulAckHead ] ), ulNow );
+        xSim.ulAckHead = ( xSim.ulAckHead + 1U ) % simMAX_ACKS;
+        xSim.ulAckCount--;
+    }
+
+    /* The retransmission timer, which does not run while the peer's window
+     * is closed and everything sent was acknowledged. */
+    if( ( xSim.ulHighest > xSim.ulUnacked ) && ( ( ulNow - xSim.ulLastProgress ) >= xSim.ulRTO ) )
+    {
+        xSim.xStats.ulTimeouts++;
+        xSim.xInRecovery = pdFALSE;
+        xSim.ulDupAcks = 0U;
+        xSim.ulNext = xSim.ulUnacked;
+        xSim.ulLastProgress = ulNow;
+        xSim.ulRTO = ( xSim.ulRTO < 30000U ) ? ( 2U * xSim.ulRTO ) : xSim.ulRTO;
+        prvRetransmit();
+        xSim.ulNext += ( xSim.ulHighest - xSim.ulUnacked < xSim.xConfig.ulMSS ) ? ( xSim.ulHighest - xSim.ulUnacked ) : xSim.xConfig.ulMSS;
+    }
+
+    prvSendNew();
+
+    /* The bottleneck serves its queue. */
+    xSim.ulCredit += ( xSim.xConfig.ulRate != 0U ) ? xSim.xConfig.ulRate : 0xFFFFFFU;
+
+    while( xSim.ulSegServed < xSim.ulSegCount )
+    {
+        ulIndex = ( xSim.ulSegHead + xSim.ulSegServed ) % simMAX_SEGMENTS;
+        pxSegment = &( xSim.pxSegments[ ulIndex ] );
+
+        if( pxSegment->ulLength > xSim.ulCredit )
+        {
+            break;
+        }
+
+        xSim.ulCredit -= pxSegment->ulLength;
+        xSim.ulQueueBytes -= pxSegment->ulLength;
+        pxSegment->ulArrival = ulNow + ( ( xSim.xConfig.ulDelay > 0U ) ? xSim.xConfig.ulDelay : 1U );
+        xSim.ulSegServed++;
+    }
+
+    if( xSim.ulSegServed == xSim.ulSegCount )
+    {
+        /* An idle link does not save up. */
+        xSim.ulCredit = 0U;
+    }
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t FreeRTOS_setsockopt( Socket_t xSocket,
+                                int32_t lLevel,
+                                int32_t lOptionName,
+                                const void * pvOptionValue,
+                                size_t uxOptionLength )
+{
+    ( void ) lLevel;
+    ( void ) uxOptionLength;
+
+    switch( lOptionName )
+    {
+        case FREERTOS_SO_SET_SEMAPHORE:
+            xSocket->xSemaphore = *( ( const SemaphoreHandle_t * ) pvOptionValue );
+            break;
+
+        case FREERTOS_SO_SET_FULL_SIZE:
+            xSocket->xFullSize = *( ( const BaseType_t * ) pvOptionValue );
+            break;
+
+        case FREERTOS_SO_SNDTIMEO:
+            xSocket->xSendTimeout = *( ( const TickType_t * ) pvOptionValue );
+            break;
+
+        default:
+            break;
+    }
+
+    return 0;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t FreeRTOS_send( Socket_t xSocket,
+                          const void * pvBuffer,
+                          size_t uxDataLength,
+                          BaseType_t xFlags )
+{
+    BaseType_t xReturn;
+    TickType_t xWaited = 0U;
+    uint32_t ulSpace;
+    uint32_t ulOffset;
+    const uint8_t * pucBuffer = pvBuffer;
+
+    for( ; ; )
+    {
+        ulSpace = ( uint32_t ) FreeRTOS_tx_space( xSocket );
+
+        if( ( xSocket->xConnected == pdFALSE ) || ( ulSpace > 0U ) ||
+            ( ( xFlags & FREERTOS_MSG_DONTWAIT ) != 0 ) || ( xWaited >= xSocket->xSendTimeout ) )
+        {
+            break;
+        }
+
+        vFakeKernelAdvance( 1U );
+        xWaited++;
+    }
+
+    if( xSocket->xConnected == pdFALSE )
+    {
+        xReturn = -pdFREERTOS_ERRNO_ENOTCONN;
+    }
+    else if( ulSpace == 0U )
+    {
+        xReturn = -pdFREERTOS_ERRNO_ENOSPC;
+    }
+    else
+    {
+        if( uxDataLength > ulSpace )
+        {
+            uxDataLength = ulSpace;
+        }
+
+        /* Without a buffer, the data was written at the head already. */
+        if( pucBuffer != NULL )
+        {
+            for( ulOffset = 0U; ulOffset < uxDataLength; ulOffset++ )
+            {
+                xSocket->pucStream[ ( xSocket->ulWritten + ulOffset ) % ( uint32_t ) xSocket->xConfig.uxTxStreamSize ] = pucBuffer[ ulOffset ];
+            }
+        }
+
+        xSocket->xStreamCreated = pdTRUE;
+        xSocket->ulWritten += ( uint32_t ) uxDataLength;
+        xSocket->xStats.ulWrites++;
+        xReturn = ( BaseType_t ) uxDataLength;
+    }
+
+    return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+uint8_t * FreeRTOS_get_tx_head( Socket_t xSocket,
+                                BaseType_t * pxLength )
+{
+    uint8_t * pucReturn = NULL;
+    uint32_t ulHead;
+    uint32_t ulToEnd;
+    BaseType_t xSpace;
+
+    *pxLength = 0;
+
+    /* As in the stack, the stream is created by the first FreeRTOS_send(). */
+    if( xSocket->xStreamCreated != pdFALSE )
+    {
+        ulHead = xSocket->ulWritten % ( uint32_t ) xSocket->xConfig.uxTxStreamSize;
+        ulToEnd = ( uint32_t ) xSocket->xConfig.uxTxStreamSize - ulHead;
+        xSpace = FreeRTOS_tx_space( xSocket );
+        *pxLength = ( xSpace < ( BaseType_t ) ulToEnd ) ? xSpace : ( BaseType_t ) ulToEnd;
+        pucReturn = &( xSocket->pucStream[ ulHead ] );
+    }
+
+    return pucReturn;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t FreeRTOS_outstanding( ConstSocket_t xSocket )
+{
+    return ( BaseType_t ) ( xSocket->ulWritten - xSocket->ulUnacked );
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t FreeRTOS_tx_space( ConstSocket_t xSocket )
+{
+    return ( BaseType_t ) ( xSocket->xConfig.uxTxStreamSize - ( xSocket->ulWritten - xSocket->ulUnacked ) );
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t FreeRTOS_tx_size( ConstSocket_t xSocket )
+{
+    return FreeRTOS_outstanding( xSocket );
+}
+/*-----------------------------------------------------------*/
+
+size_t FreeRTOS_GetLocalAddress( ConstSocket_t xSocket,
+                                 struct freertos_sockaddr * pxAddress )
+{
+    ( void ) xSocket;
+
+    pxAddress->sin_family = FREERTOS_AF_INET;
+    pxAddress->sin_port = FreeRTOS_htons( simLOCAL_PORT );
+
+    return sizeof( *pxAddress );
+}
+/*-----------------------------------------------------------*/
+
+size_t FreeRTOS_GetRemoteAddress( ConstSocket_t xSocket,
+                                  struct freertos_sockaddr * pxAddress )
+{
+    ( void ) xSocket;
+
+    pxAddress->sin_family = FREERTOS_AF_INET;
+    pxAddress->sin_port = FreeRTOS_htons( simREMOTE_PORT );
+
+    return sizeof( *pxAddress );
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t FreeRTOS_mss( ConstSocket_t xSocket )
+{
+    return ( BaseType_t ) xSocket->xConfig.ulMSS;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t FreeRTOS_issocketconnected( ConstSocket_t xSocket )
+{
+    return xSocket->xConnected;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t FreeRTOS_rx_size( ConstSocket_t xSocket )
+{
+    /* The simulated connection only sends. */
+    ( void ) xSocket;
+
+    return 0;
+}
+/*-----------------------------------------------------------*/
@@ -0,0 +1,82 @@
+#ifndef SIM_TCP_H
+#define SIM_TCP_H
+
+#include "FreeRTOS.h"
+#include "FreeRTOS_Sockets.h"
+
+/*
+ * A simulated TCP connection for the host tests, behind the socket API of
+ * FreeRTOS+TCP: one connected socket whose TX stream is sent over a link with
+ * a bottleneck, a delay and chosen losses, to a peer that acknowledges every
+ * segment.  The stack side retransmits after three duplicate ACKs, a partial
+ * ACK during recovery, or its own time-out.
+ *
+ * Every segment the stack sends, a retransmission too, is passed as an
+ * Ethernet frame to the output function of pxSimTCPInterface(), from local
+ * port simLOCAL_PORT to simREMOTE_PORT.
+ *
+ * The simulation runs from the tick hook of the fake kernel, one step per
+ * tick, so it moves while the code under test blocks on the semaphore of the
+ * socket or calls vFakeKernelAdvance().
+ */
+
+#define simLOCAL_PORT     49152U
+#define simREMOTE_PORT    5201U
+
+typedef struct xSIM_TCP_CONFIG
+{
+    size_t uxTxStreamSize;   /* Size of the TX stream in bytes. */
+    uint32_t ulMSS;
+    uint32_t ulTxWindow;     /* Segments in flight, 0 for no limit. */
+    uint32_t ulDelay;        /* One-way delay in ticks. */
+    uint32_t ulRate;         /* Bottleneck in bytes per tick, 0 for none. */
+    uint32_t ulQueueLimit;   /* Bottleneck buffer in bytes, 0 for no limit. */
+    uint32_t ulLossEvery;    /* Drop every Nth new segment, 0 for none. */
+    uint32_t ulAckDelay;     /* Ticks before the peer acknowledges. */
+    uint32_t ulPeerWindow;   /* Receive window of the peer in bytes. */
+    uint32_t ulStackRTO;     /* First retransmission time-out in ticks. */
+    BaseType_t xNoFullSize;  /* Send partial segments also when FREERTOS_SO_SET_FULL_SIZE is set. */
+} SimTCPConfig_t;
+
+typedef struct xSIM_TCP_STATS
+{
+    uint32_t ulSegments;        /* Data segments sent, retransmissions too. */
+    uint32_t ulPartialSegments; /* Segments shorter than the MSS. */
+    uint32_t ulRetransmits;
+    uint32_t ulFastRetransmits;
+    uint32_t ulTimeouts;
+    uint32_t ulDrops;           /* Lost on purpose or by queue overflow. */
+    uint32_t ulOverflows;       /* Drops by queue overflow. */
+    uint32_t ulMaxQueue;        /* Largest bottleneck queue in bytes. */
+    uint32_t ulDelivered;       /* In-order bytes received by the peer. */
+    uint32_t ulAcked;           /* Bytes acknowledged to the sender. */
+    uint32_t ulWrites;          /* FreeRTOS_send() calls that added data. */
+} SimTCPStats_t;
+
+/* Start a new connection, and hook the simulation into the fake kernel. */
+void vSimTCPInit( const SimTCPConfig_t * pxConfig );
+
+Socket_t xSimTCPSocket( void );
+
+/* The interface that the frames leave through. */
+NetworkInterface_t * pxSimTCPInterface( void );
+
+/* One tick of the simulation, normally called by the fake kernel. */
+void vSimTCPTick( void );
+
+void vSimTCPGetStats( SimTCPStats_t * pxStats );
+
+/* The bytes that the peer received in order, from the first one. */
+const uint8_t * pucSimTCPReceived( void );
+
+/* Bytes in the TX stream that were written but not acknowledged. */
+uint32_t ulSimTCPQueuedBytes( void );
+
+BaseType_t xSimTCPFullSize( void );
+
+void vSimTCPSetPeerWindow( uint32_t ulWindow );
+
+/* The connection is reset, nothing more is sent or acknowledged. */
+void vSimTCPDisconnect( void );
+
+#endif /* SIM_TCP_H */
@@ -0,0 +1,76 @@
+#ifndef INC_FREERTOS_H
+#define INC_FREERTOS_H
+
+/*
+ * Host build stand-in for the kernel headers: the types of the Cortex-M7 port
+ * and the parts of the API that the application modules use.  The functions
+ * are implemented by fakes/fake_kernel.c.
+ */
+
+/* Standard includes. */
+#include <stddef.h>
+#include <stdint.h>
+
+#include "FreeRTOSConfig.h"
+
+typedef long BaseType_t;
+typedef unsigned long UBaseType_t;
+typedef uint32_t TickType_t;
+typedef uint32_t StackType_t;
+
+#define portMAX_DELAY                    ( ( TickType_t ) 0xffffffffUL )
+#define portTICK_PERIOD_MS               ( ( TickType_t ) 1000 / configTICK_RATE_HZ )
+#define portBYTE_ALIGNMENT               8
+
+#define pdFALSE                          ( ( BaseType_t ) 0 )
+#define pdTRUE                           ( ( BaseType_t ) 1 )
+#define pdPASS                           ( pdTRUE )
+#define pdFAIL                           ( pdFALSE )
+
+#define pdMS_TO_TICKS( xTimeInMs )       ( ( TickType_t ) ( ( ( uint64_t ) ( xTimeInMs ) * ( uint64_t ) configTICK_RATE_HZ ) / ( uint64_t ) 1000U ) )
+#define pdTICKS_TO_MS( xTimeInTicks )    ( ( TickType_t ) ( ( ( uint64_t ) ( xTimeInTicks ) * ( uint64_t ) 1000U ) / ( uint64_t ) configTICK_RATE_HZ ) )
+
+#define tskIDLE_PRIORITY                 ( ( UBaseType_t ) 0U )
+
+/* Interrupts and critical sections share one recursive lock on the host. */
+void vFakeEnterCritical( void );
+void vFakeExitCritical( void );
+
+#define portENTER_CRITICAL()                  vFakeEnterCritical()
+#define portEXIT_CRITICAL()                   vFakeExitCritical()
+#define taskENTER_CRITICAL()                  vFakeEnterCritical()
+#define taskEXIT_CRITICAL()                   vFakeExitCritical()
+#define taskENTER_CRITICAL_FROM_ISR()         ( vFakeEnterCritical(), ( UBaseType_t ) 0U )
+#define taskEXIT_CRITICAL_FROM_ISR( x )       do { ( void ) ( x ); vFakeExitCritical(); } while( 0 )
+#define taskDISABLE_INTERRUPTS()
+#define taskENABLE_INTERRUPTS()
+#define portDISABLE_INTERRUPTS()
+#define portENABLE_INTERRUPTS()
+#define portYIELD_FROM_ISR( x )               ( ( void ) ( x ) )
+#define portEND_SWITCHING_ISR( x )            ( ( void ) ( x ) )
+#define portMEMORY_BARRIER()                  __asm volatile ( "" ::: "memory" )
+
+#ifndef configPRE_SLEEP_PROCESSING
+    #define configPRE_SLEEP_PROCESSING( x )
+#endif
+
+#ifndef configPOST_SLEEP_PROCESSING
+    #define configPOST_SLEEP_PROCESSING( x )
+#endif
+
+/* Big enough for the fakes, which keep their state in these buffers. */
+typedef struct xSTATIC_FAKE
+{
+    void * pvDummy[ 16 ];
+} StaticTask_t;
+
+typedef StaticTask_t StaticQueue_t;
+typedef StaticTask_t StaticSemaphore_t;
+typedef StaticTask_t StaticTimer_t;
+
+void * pvPortMalloc( size_t xWantedSize );
+void vPortFree( void * pv );
+size_t xPortGetFreeHeapSize( void );
+size_t xPortGetMinimumEverFreeHeapSize( void );
+
+#endif /* INC_FREERTOS_H */
@@ -0,0 +1,6 @@
+#ifndef FREERTOS_DHCP_H
+#define FREERTOS_DHCP_H
+
+#include "FreeRTOS_IP.h"
+
+#endif /* FREERTOS_DHCP_H */
@@ -0,0 +1,8 @@
+#ifndef FREERTOS_DNS_H
+#define FREERTOS_DNS_H
+
+#include "FreeRTOS_IP.h"
+
+uint32_t FreeRTOS_gethostbyname( const char * pcHostName );
+
+#endif /* FREERTOS_DNS_H */
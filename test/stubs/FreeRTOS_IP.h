@@ -0,0 +1,256 @@
+#ifndef FREERTOS_IP_H
+#define FREERTOS_IP_H
+
+/*
+ * Host build stand-in for the FreeRTOS+TCP headers: the types and functions
+ * that the application modules use.  Tests implement the functions they need,
+ * the TCP socket calls are simulated by fakes/sim_tcp.c.
+ */
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "list.h"
+
+#include "FreeRTOSIPConfig.h"
+
+/* Defaults of FreeRTOSIPConfigDefaults.h that the configuration leaves out. */
+#ifndef ipconfigUSE_IPv4
+    #define ipconfigUSE_IPv4    1
+#endif
+
+#ifndef ipconfigUSE_IPv6
+    #define ipconfigUSE_IPv6    1
+#endif
+
+#ifndef ipconfigUSE_RA
+    #define ipconfigUSE_RA      1
+#endif
+
+#ifndef ipconfigUSE_DHCPv6
+    #define ipconfigUSE_DHCPv6    0
+#endif
+
+#ifndef ipconfigIPv4_BACKWARD_COMPATIBLE
+    #define ipconfigIPv4_BACKWARD_COMPATIBLE    0
+#endif
+
+#ifndef ipconfigTCP_MSS
+    #define ipconfigTCP_MSS    1460
+#endif
+
+#ifndef FreeRTOS_printf
+    #define FreeRTOS_printf( X )
+#endif
+
+#ifndef FreeRTOS_debug_printf
+    #define FreeRTOS_debug_printf( X )
+#endif
+
+#define pdFALSE_UNSIGNED                ( 0U )
+#define pdTRUE_UNSIGNED                 ( 1U )
+
+#define ipTYPE_IPv4                     ( 0x40U )
+#define ipTYPE_IPv6                     ( 0x60U )
+
+#define ipSIZE_OF_ETH_HEADER            14U
+#define ipSIZE_OF_IPv4_HEADER           20U
+#define ipSIZE_OF_IPv6_HEADER           40U
+#define ipSIZE_OF_TCP_HEADER            20U
+#define ipSIZE_OF_UDP_HEADER            8U
+#define ipSIZE_OF_ICMPv4_HEADER         8U
+#define ipTOTAL_ETHERNET_FRAME_SIZE     1514U
+#define ipBUFFER_PADDING                10U
+
+#define pdFREERTOS_ERRNO_NONE           0
+#define pdFREERTOS_ERRNO_EINTR          4
+#define pdFREERTOS_ERRNO_EAGAIN         11
+#define pdFREERTOS_ERRNO_EWOULDBLOCK    11
+#define pdFREERTOS_ERRNO_ENOMEM         12
+#define pdFREERTOS_ERRNO_EINVAL         22
+#define pdFREERTOS_ERRNO_ENOSPC         28
+#define pdFREERTOS_ERRNO_ENOTCONN       128
+#define pdFREERTOS_ERRNO_EALREADY       120
+#define pdFREERTOS_ERRNO_EINPROGRESS    119
+
+typedef struct xIPv6_Address
+{
+    uint8_t ucBytes[ 16 ];
+} IPv6_Address_t;
+
+typedef struct xMAC_ADDRESS
+{
+    uint8_t ucBytes[ 6 ];
+} MACAddress_t;
+
+typedef union xIP_ADDRESS
+{
+    uint32_t ulIP_IPv4;
+    IPv6_Address_t xIP_IPv6;
+} IP_Address_t;
+
+typedef enum eIP_EVENT
+{
+    eNetworkUp,
+    eNetworkDown
+} eIPCallbackEvent_t;
+
+typedef enum eDHCP_ANSWERS
+{
+    eDHCPContinue,
+    eDHCPUseDefaults,
+    eDHCPStopNoChanges
+} eDHCPCallbackAnswer_t;
+
+typedef enum eDHCP_PHASE
+{
+    eDHCPPhasePreDiscover,
+    eDHCPPhasePreRequest
+} eDHCPCallbackPhase_t;
+
+typedef enum
+{
+    eSuccess = 0,
+    eInvalidChecksum,
+    eInvalidData
+} ePingReplyStatus_t;
+
+typedef enum
+{
+    eInitialWait,
+    eWaitingSendFirstDiscover,
+    eWaitingOffer,
+    eWaitingAcknowledge,
+    eLeasedAddress,
+    eNotUsingLeasedAddress
+} eDHCPState_t;
+
+typedef struct xNetworkBufferDescriptor
+{
+    ListItem_t xBufferListItem;
+    uint8_t * pucEthernetBuffer;
+    size_t xDataLength;
+    struct xNetworkEndPoint * pxEndPoint;
+    struct xNetworkInterface * pxInterface;
+    IP_Address_t xIPAddress;
+    uint16_t usPort;
+    uint16_t usBoundPort;
+    struct xNetworkBufferDescriptor * pxNextBuffer;
+} NetworkBufferDescriptor_t;
+
+typedef struct xIPV4Parameters
+{
+    uint32_t ulIPAddress;
+    uint32_t ulNetMask;
+    uint32_t ulGatewayAddress;
+    uint32_t ulDNSServerAddresses[ 2 ];
+    uint32_t ulBroadcastAddress;
+} IPV4Parameters_t;
+
+typedef struct xIPV6Parameters
+{
+    IPv6_Address_t xIPAddress;
+    size_t uxPrefixLength;
+    IPv6_Address_t xPrefix;
+    IPv6_Address_t xGatewayAddress;
+    IPv6_Address_t xDNSServerAddresses[ 2 ];
+} IPV6Parameters_t;
+
+typedef struct xDHCPData
+{
+    uint32_t ulTransactionId;
+    uint32_t ulOfferedIPAddress;
+    uint32_t ulPreferredIPAddress;
+    uint32_t ulDHCPServerAddress;
+    uint32_t ulLeaseTime;
+    eDHCPState_t eDHCPState;
+} DHCPData_t;
+
+typedef struct xNetworkEndPoint
+{
+    union
+    {
+        struct
+        {
+            IPV4Parameters_t ipv4_settings;
+            IPV4Parameters_t ipv4_defaults;
+        };
+        struct
+        {
+            IPV6Parameters_t ipv6_settings;
+            IPV6Parameters_t ipv6_defaults;
+        };
+    };
+    MACAddress_t xMACAddress;
+    struct
+    {
+        uint32_t bIPv6 : 1,
+                 bWantDHCP : 1,
+                 bWantRA : 1,
+                 bEndPointUp : 1;
+    } bits;
+    DHCPData_t xDHCPData;
+    struct xNetworkInterface * pxNetworkInterface;
+    struct xNetworkEndPoint * pxNext;
+} NetworkEndPoint_t;
+
+struct xNetworkInterface;
+
+typedef BaseType_t ( * NetworkInterfaceOutputFunction_t ) ( struct xNetworkInterface * pxDescriptor,
+                                                            NetworkBufferDescriptor_t * const pxNetworkBuffer,
+                                                            BaseType_t xReleaseAfterSend );
+
+typedef struct xNetworkInterface
+{
+    const char * pcName;
+    NetworkInterfaceOutputFunction_t pfOutput;
+    struct xNetworkInterface * pxNext;
+} NetworkInterface_t;
+
+#define FreeRTOS_inet_addr_quick( ucOctet0, ucOctet1, ucOctet2, ucOctet3 ) \
+    ( ( ( ( uint32_t ) ( ucOctet3 ) ) << 24 ) |                             \
+      ( ( ( uint32_t ) ( ucOctet2 ) ) << 16 ) |                             \
+      ( ( ( uint32_t ) ( ucOctet1 ) ) << 8 ) |                              \
+      ( ( uint32_t ) ( ucOctet0 ) ) )
+
+/* The host is little endian, as the target. */
+#define FreeRTOS_htons( usIn )    ( ( uint16_t ) ( ( ( ( uint16_t ) ( usIn ) ) << 8 ) | ( ( ( uint16_t ) ( usIn ) ) >> 8 ) ) )
+#define FreeRTOS_ntohs( usIn )    FreeRTOS_htons( usIn )
+#define FreeRTOS_htonl( ulIn )    __builtin_bswap32( ( uint32_t ) ( ulIn ) )
+#define FreeRTOS_ntohl( ulIn )    FreeRTOS_htonl( ulIn )
+
+BaseType_t xApplicationGetRandomNumber( uint32_t * pulNumber );
+BaseType_t FreeRTOS_IsNetworkUp( void );
+BaseType_t FreeRTOS_IsEndPointUp( const NetworkEndPoint_t * pxEndPoint );
+NetworkEndPoint_t * FreeRTOS_FirstEndPoint( const NetworkInterface_t * pxInterface );
+NetworkEndPoint_t * FreeRTOS_NextEndPoint( const NetworkInterface_t * pxInterface,
+                                           NetworkEndPoint_t * pxEndPoint );
+NetworkEndPoint_t * FreeRTOS_FindEndPointOnNetMask( uint32_t ulIPAddress,
+                                                    uint32_t ulWhere );
+NetworkEndPoint_t * FreeRTOS_FindEndPointOnNetMask_IPv6( const IPv6_Address_t * pxIPv6Address );
+NetworkEndPoint_t * FreeRTOS_FindGateWay( BaseType_t xIPType );
+BaseType_t FreeRTOS_inet_pton( BaseType_t xAddressFamily,
+                               const char * pcSource,
+                               void * pvDestination );
+const char * FreeRTOS_inet_ntop( BaseType_t xAddressFamily,
+                                 const void * pvSource,
+                                 char * pcDestination,
+                                 size_t uxSize );
+void FreeRTOS_inet_ntoa( uint32_t ulIPAddress,
+                         char * pcBuffer );
+uint32_t FreeRTOS_inet_addr( const char * pcIPAddress );
+UBaseType_t uxGetMinimumIPQueueSpace( void );
+UBaseType_t uxGetNumberOfFreeNetworkBuffers( void );
+UBaseType_t uxGetMinimumFreeNetworkBuffers( void );
+NetworkBufferDescriptor_t * pxGetNetworkBufferWithDescriptor( size_t xRequestedSizeBytes,
+                                                              TickType_t xBlockTimeTicks );
+void vReleaseNetworkBufferAndDescriptor( NetworkBufferDescriptor_t * const pxNetworkBuffer );
+BaseType_t FreeRTOS_SendPingRequest( uint32_t ulIPAddress,
+                                     size_t uxNumberOfBytesToSend,
+                                     TickType_t uxBlockTimeTicks );
+BaseType_t FreeRTOS_SendPingRequestIPv6( const IPv6_Address_t * pxIPAddress,
+                                         size_t uxNumberOfBytesToSend,
+                                         TickType_t uxBlockTimeTicks );
+
+#include "FreeRTOS_Sockets.h"
+
+#endif /* FREERTOS_IP_H */
@@ -0,0 +1,24 @@
+#ifndef FREERTOS_IP_PRIVATE_H
+#define FREERTOS_IP_PRIVATE_H
+
+#include "FreeRTOS_IP.h"
+#include "queue.h"
+
+/* The events for the IP-task, defined by the test that posts them. */
+extern QueueHandle_t xNetworkEventQueue;
+
+/* The trace macros that FreeRTOSIPConfig.h leaves out, as in
+ * IPTraceMacroDefaults.h. */
+#ifndef iptraceFAILED_TO_OBTAIN_NETWORK_BUFFER
+    #define iptraceFAILED_TO_OBTAIN_NETWORK_BUFFER()
+#endif
+
+#ifndef iptraceNETWORK_BUFFER_OBTAINED
+    #define iptraceNETWORK_BUFFER_OBTAINED( pxBufferAddress )
+#endif
+
+#ifndef iptraceNETWORK_BUFFER_RELEASED
+    #define iptraceNETWORK_BUFFER_RELEASED( pxBufferAddress )
+#endif
+
+#endif /* FREERTOS_IP_PRIVATE_H */
@@ -0,0 +1,6 @@
+#ifndef FREERTOS_ND_H
+#define FREERTOS_ND_H
+
+#include "FreeRTOS_IP.h"
+
+#endif /* FREERTOS_ND_H */
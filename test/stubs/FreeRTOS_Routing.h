@@ -0,0 +1,6 @@
+#ifndef FREERTOS_ROUTING_H
+#define FREERTOS_ROUTING_H
+
+#include "FreeRTOS_IP.h"
+
+#endif /* FREERTOS_ROUTING_H */
@@ -0,0 +1,153 @@
+#ifndef FREERTOS_SOCKETS_H
+#define FREERTOS_SOCKETS_H
+
+#include "FreeRTOS_IP.h"
+
+typedef struct xSOCKET * Socket_t;
+typedef struct xSOCKET const * ConstSocket_t;
+typedef struct xSOCKET_SET * SocketSet_t;
+
+#define FREERTOS_INVALID_SOCKET            ( ( Socket_t ) ~0U )
+
+#define FREERTOS_AF_INET                   ( 2 )
+#define FREERTOS_AF_INET4                  ( FREERTOS_AF_INET )
+#define FREERTOS_AF_INET6                  ( 10 )
+#define FREERTOS_SOCK_DGRAM                ( 2 )
+#define FREERTOS_SOCK_STREAM               ( 1 )
+#define FREERTOS_IPPROTO_UDP               ( 17 )
+#define FREERTOS_IPPROTO_TCP               ( 6 )
+
+#define FREERTOS_SO_RCVTIMEO               ( 0 )
+#define FREERTOS_SO_SNDTIMEO               ( 1 )
+#define FREERTOS_SO_UDPCKSUM_OUT           ( 2 )
+#define FREERTOS_SO_SET_SEMAPHORE          ( 3 )
+#define FREERTOS_SO_SNDBUF                 ( 4 )
+#define FREERTOS_SO_RCVBUF                 ( 5 )
+#define FREERTOS_SO_TCP_CONN_HANDLER       ( 6 )
+#define FREERTOS_SO_TCP_RECV_HANDLER       ( 7 )
+#define FREERTOS_SO_TCP_SENT_HANDLER       ( 8 )
+#define FREERTOS_SO_UDP_RECV_HANDLER       ( 9 )
+#define FREERTOS_SO_REUSE_LISTEN_SOCKET    ( 11 )
+#define FREERTOS_SO_CLOSE_AFTER_SEND       ( 12 )
+#define FREERTOS_SO_WIN_PROPERTIES         ( 13 )
+#define FREERTOS_SO_SET_FULL_SIZE          ( 14 )
+#define FREERTOS_SO_STOP_RX                ( 15 )
+#define FREERTOS_SO_WAKEUP_CALLBACK        ( 17 )
+#define FREERTOS_SO_SET_LOW_HIGH_WATER     ( 18 )
+
+#define FREERTOS_ZERO_COPY                 ( 1 )
+#define FREERTOS_MSG_PEEK                  ( 2 )
+#define FREERTOS_MSG_DONTWAIT              ( 16 )
+
+#define FREERTOS_SHUT_RDWR                 ( 2 )
+
+#define eSELECT_READ                       ( 1 )
+#define eSELECT_WRITE                      ( 2 )
+#define eSELECT_EXCEPT                     ( 4 )
+#define eSELECT_INTR                       ( 8 )
+
+typedef struct xWIN_PROPS
+{
+    int32_t lTxBufSize;
+    int32_t lTxWinSize;
+    int32_t lRxBufSize;
+    int32_t lRxWinSize;
+} WinProperties_t;
+
+typedef struct xLOW_HIGH_WATER
+{
+    size_t uxLittleSpace;
+    size_t uxEnoughSpace;
+} LowHighWater_t;
+
+struct freertos_sockaddr
+{
+    uint8_t sin_len;
+    uint8_t sin_family;
+    uint16_t sin_port;
+    uint32_t sin_flowinfo;
+    IP_Address_t sin_address;
+};
+
+typedef void (* FOnTCPReceive_t)( Socket_t xSocket,
+                                  void * pData,
+                                  size_t xLength );
+typedef void (* FOnTCPSent_t)( Socket_t xSocket,
+                               size_t xLength );
+
+typedef struct xTCP_UDP_HANDLER
+{
+    FOnTCPReceive_t pxOnTCPReceive;
+    FOnTCPSent_t pxOnTCPSent;
+} F_TCP_UDP_Handler_t;
+
+Socket_t FreeRTOS_socket( BaseType_t xDomain,
+                          BaseType_t xType,
+                          BaseType_t xProtocol );
+BaseType_t FreeRTOS_setsockopt( Socket_t xSocket,
+                                int32_t lLevel,
+                                int32_t lOptionName,
+                                const void * pvOptionValue,
+                                size_t uxOptionLength );
+BaseType_t FreeRTOS_bind( Socket_t xSocket,
+                          struct freertos_sockaddr const * pxAddress,
+                          uint32_t xAddressLength );
+BaseType_t FreeRTOS_connect( Socket_t xClientSocket,
+                             const struct freertos_sockaddr * pxAddress,
+                             uint32_t xAddressLength );
+BaseType_t FreeRTOS_listen( Socket_t xSocket,
+                            BaseType_t xBacklog );
+Socket_t FreeRTOS_accept( Socket_t xServerSocket,
+                          struct freertos_sockaddr * pxAddress,
+                          uint32_t * pxAddressLength );
+BaseType_t FreeRTOS_send( Socket_t xSocket,
+                          const void * pvBuffer,
+                          size_t uxDataLength,
+                          BaseType_t xFlags );
+BaseType_t FreeRTOS_recv( Socket_t xSocket,
+                          void * pvBuffer,
+                          size_t uxBufferLength,
+                          BaseType_t xFlags );
+int32_t FreeRTOS_sendto( Socket_t xSocket,
+                         const void * pvBuffer,
+                         size_t uxTotalDataLength,
+                         BaseType_t xFlags,
+                         const struct freertos_sockaddr * pxDestinationAddress,
+                         uint32_t xDestinationAddressLength );
+int32_t FreeRTOS_recvfrom( Socket_t xSocket,
+                           void * pvBuffer,
+                           size_t uxBufferLength,
+                           BaseType_t xFlags,
+                           struct freertos_sockaddr * pxSourceAddress,
+                           uint32_t * pxSourceAddressLength );
+BaseType_t FreeRTOS_shutdown( Socket_t xSocket,
+                              BaseType_t xHow );
+BaseType_t FreeRTOS_closesocket( Socket_t xSocket );
+BaseType_t FreeRTOS_outstanding( ConstSocket_t xSocket );
+BaseType_t FreeRTOS_tx_space( ConstSocket_t xSocket );
+BaseType_t FreeRTOS_tx_size( ConstSocket_t xSocket );
+BaseType_t FreeRTOS_rx_size( ConstSocket_t xSocket );
+BaseType_t FreeRTOS_issocketconnected( ConstSocket_t xSocket );
+BaseType_t FreeRTOS_mss( ConstSocket_t xSocket );
+BaseType_t FreeRTOS_connstatus( ConstSocket_t xSocket );
+uint8_t * FreeRTOS_get_tx_head( Socket_t xSocket,
+                                BaseType_t * pxLength );
+size_t FreeRTOS_GetRemoteAddress( ConstSocket_t xSocket,
+                                  struct freertos_sockaddr * pxAddress );
+size_t FreeRTOS_GetLocalAddress( ConstSocket_t xSocket,
+                                 struct freertos_sockaddr * pxAddress );
+SocketSet_t FreeRTOS_CreateSocketSet( void );
+void FreeRTOS_DeleteSocketSet( SocketSet_t xSocketSet );
+void FreeRTOS_FD_SET( Socket_t xSocket,
+                      SocketSet_t xSocketSet,
+                      BaseType_t xBitsToSet );
+void FreeRTOS_FD_CLR( Socket_t xSocket,
+                      SocketSet_t xSocketSet,
+                      BaseType_t xBitsToClear );
+BaseType_t FreeRTOS_FD_ISSET( const ConstSocket_t xSocket,
+                              const SocketSet_t xSocketSet );
+BaseType_t FreeRTOS_select( SocketSet_t xSocketSet,
+                            TickType_t xBlockTimeTicks );
+void FreeRTOS_ReleaseUDPPayloadBuffer( void const * pvBuffer );
+
+#endif /* FREERTOS_SOCKETS_H */
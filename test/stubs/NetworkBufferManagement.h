@@ -0,0 +1,15 @@
+#ifndef NETWORK_BUFFER_MANAGEMENT_H
+#define NETWORK_BUFFER_MANAGEMENT_H
+
+#include "FreeRTOS_IP.h"
+
+/* The functions that a BufferAllocation_x.c implements, see net_buffers.c.
+ * pxGetNetworkBufferWithDescriptor() and vReleaseNetworkBufferAndDescriptor()
+ * are in FreeRTOS_IP.h. */
+BaseType_t xNetworkBuffersInitialise( void );
+uint8_t * pucGetNetworkBuffer( size_t * pxRequestedSizeBytes );
+void vReleaseNetworkBuffer( uint8_t * pucEthernetBuffer );
+NetworkBufferDescriptor_t * pxResizeNetworkBufferWithDescriptor( NetworkBufferDescriptor_t * pxNetworkBuffer,
+                                                                 size_t xNewSizeBytes );
+
+#endif /* NETWORK_BUFFER_MANAGEMENT_H */
@@ -0,0 +1,36 @@
+#ifndef LIST_H
+#define LIST_H
+
+#include "FreeRTOS.h"
+
+/* The types, and the functions of list.c that net_buffers.c uses, see
+ * fake_kernel.c.  The end marker is a whole item here. */
+typedef struct xLIST_ITEM
+{
+    TickType_t xItemValue;
+    struct xLIST_ITEM * pxNext;
+    struct xLIST_ITEM * pxPrevious;
+    void * pvOwner;
+    void * pvContainer;
+} ListItem_t;
+
+typedef struct xLIST
+{
+    UBaseType_t uxNumberOfItems;
+    ListItem_t * pxIndex;
+    ListItem_t xListEnd;
+} List_t;
+
+#define listSET_LIST_ITEM_OWNER( pxListItem, pxOwner )    ( ( pxListItem )->pvOwner = ( void * ) ( pxOwner ) )
+#define listGET_OWNER_OF_HEAD_ENTRY( pxList )             ( ( &( ( pxList )->xListEnd ) )->pxNext->pvOwner )
+#define listCURRENT_LIST_LENGTH( pxList )                 ( ( pxList )->uxNumberOfItems )
+#define listLIST_IS_EMPTY( pxList )                       ( ( ( pxList )->uxNumberOfItems == 0U ) ? pdTRUE : pdFALSE )
+#define listIS_CONTAINED_WITHIN( pxList, pxListItem )     ( ( ( pxListItem )->pvContainer == ( void * ) ( pxList ) ) ? pdTRUE : pdFALSE )
+
+void vListInitialise( List_t * const pxList );
+void vListInitialiseItem( ListItem_t * const pxItem );
+void vListInsertEnd( List_t * const pxList,
+                     ListItem_t * const pxNewListItem );
+UBaseType_t uxListRemove( ListItem_t * const pxItemToRemove );
+
+#endif /* LIST_H */
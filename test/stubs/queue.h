@@ -0,0 +1,41 @@
+#ifndef QUEUE_H
+#define QUEUE_H
+
+#include "FreeRTOS.h"
+
+typedef struct QueueDefinition * QueueHandle_t;
+typedef struct QueueDefinition * QueueSetHandle_t;
+typedef struct QueueDefinition * QueueSetMemberHandle_t;
+
+QueueHandle_t xQueueCreate( UBaseType_t uxQueueLength,
+                            UBaseType_t uxItemSize );
+QueueHandle_t xQueueCreateStatic( UBaseType_t uxQueueLength,
+                                  UBaseType_t uxItemSize,
+                                  uint8_t * pucQueueStorage,
+                                  StaticQueue_t * pxStaticQueue );
+void vQueueDelete( QueueHandle_t xQueue );
+BaseType_t xQueueSendToBack( QueueHandle_t xQueue,
+                             const void * pvItemToQueue,
+                             TickType_t xTicksToWait );
+BaseType_t xQueueSendToFront( QueueHandle_t xQueue,
+                              const void * pvItemToQueue,
+                              TickType_t xTicksToWait );
+BaseType_t xQueueSendToBackFromISR( QueueHandle_t xQueue,
+                                    const void * pvItemToQueue,
+                                    BaseType_t * pxHigherPriorityTaskWoken );
+BaseType_t xQueueReceive( QueueHandle_t xQueue,
+                          void * pvBuffer,
+                          TickType_t xTicksToWait );
+BaseType_t xQueueReceiveFromISR( QueueHandle_t xQueue,
+                                 void * pvBuffer,
+                                 BaseType_t * pxHigherPriorityTaskWoken );
+UBaseType_t uxQueueMessagesWaiting( QueueHandle_t xQueue );
+UBaseType_t uxQueueMessagesWaitingFromISR( QueueHandle_t xQueue );
+UBaseType_t uxQueueSpacesAvailable( QueueHandle_t xQueue );
+void vQueueAddToRegistry( QueueHandle_t xQueue,
+                          const char * pcQueueName );
+
+#define xQueueSend( xQueue, pvItemToQueue, xTicksToWait )                  xQueueSendToBack( ( xQueue ), ( pvItemToQueue ), ( xTicksToWait ) )
+#define xQueueSendFromISR( xQueue, pvItemToQueue, pxHigherPriorityTaskWoken )    xQueueSendToBackFromISR( ( xQueue ), ( pvItemToQueue ), ( pxHigherPriorityTaskWoken ) )
+
+#endif /* QUEUE_H */
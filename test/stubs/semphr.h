@@ -0,0 +1,22 @@
+#ifndef SEMAPHORE_H
+#define SEMAPHORE_H
+
+#include "queue.h"
+
+/* Semaphores are queues of items without contents, as in the kernel. */
+typedef QueueHandle_t SemaphoreHandle_t;
+
+SemaphoreHandle_t xSemaphoreCreateBinary( void );
+SemaphoreHandle_t xSemaphoreCreateBinaryStatic( StaticSemaphore_t * pxSemaphoreBuffer );
+SemaphoreHandle_t xSemaphoreCreateMutex( void );
+SemaphoreHandle_t xSemaphoreCreateMutexStatic( StaticSemaphore_t * pxMutexBuffer );
+SemaphoreHandle_t xSemaphoreCreateCounting( UBaseType_t uxMaxCount,
+                                            UBaseType_t uxInitialCount );
+UBaseType_t uxSemaphoreGetCount( SemaphoreHandle_t xSemaphore );
+
+#define xSemaphoreTake( xSemaphore, xBlockTime )                          xQueueReceive( ( xSemaphore ), NULL, ( xBlockTime ) )
+#define xSemaphoreGive( xSemaphore )                                      xQueueSendToBack( ( xSemaphore ), NULL, 0U )
+#define xSemaphoreGiveFromISR( xSemaphore, pxHigherPriorityTaskWoken )    xQueueSendToBackFromISR( ( xSemaphore ), NULL, ( pxHigherPriorityTaskWoken ) )
+#define vSemaphoreDelete( xSemaphore )                                    vQueueDelete( ( xSemaphore ) )
+
+#endif /* SEMAPHORE_H */
@@ -0,0 +1,230 @@
+#ifndef STM32H7xx_HAL_H
+#define STM32H7xx_HAL_H
+
+/*
+ * Host build stand-in for the HAL: the configuration headers include it, but
+ * neither the CMSIS core nor the peripherals can be used on the host.  The
+ * few registers that the modules under test touch are plain variables here.
+ */
+
+/* Standard includes. */
+#include <stdint.h>
+
+typedef struct
+{
+    volatile uint32_t CTRL;
+    volatile uint32_t LOAD;
+    volatile uint32_t VAL;
+    volatile uint32_t CALIB;
+} SysTick_Type;
+
+extern SysTick_Type xFakeSysTick;
+#define SysTick    ( &xFakeSysTick )
+
+#define SysTick_CTRL_ENABLE_Msk        ( 1UL )
+
+typedef struct
+{
+    volatile uint32_t ICSR;
+} SCB_Type;
+
+extern SCB_Type xFakeSCB;
+#define SCB                            ( &xFakeSCB )
+
+#define SCB_ICSR_PENDSTSET_Msk         ( 1UL << 26U )
+
+typedef struct
+{
+    volatile uint32_t DEMCR;
+} CoreDebug_Type;
+
+extern CoreDebug_Type xFakeCoreDebug;
+#define CoreDebug                      ( &xFakeCoreDebug )
+
+#define CoreDebug_DEMCR_TRCENA_Msk     ( 1UL << 24U )
+
+/* Every access to DWT moves the CPU clock, and the LSI with it, forward, see
+ * fake_hal.h. */
+typedef struct
+{
+    volatile uint32_t CTRL;
+    volatile uint32_t CYCCNT;
+    volatile uint32_t LAR;
+} DWT_Type;
+
+DWT_Type * pxFakeDWT( void );
+#define DWT                            ( pxFakeDWT() )
+
+#define DWT_CTRL_CYCCNTENA_Msk         ( 1UL )
+
+typedef struct
+{
+    volatile uint32_t CSR;
+    volatile uint32_t D2CCIP2R;
+    volatile uint32_t APB1LENR;
+    volatile uint32_t APB1LLPENR;
+} RCC_TypeDef;
+
+extern RCC_TypeDef xFakeRCC;
+#define RCC                            ( &xFakeRCC )
+
+#define RCC_CSR_LSION                  ( 0x00000001UL )
+#define RCC_CSR_LSIRDY                 ( 0x00000002UL )
+#define RCC_D2CCIP2R_LPTIM1SEL         ( 0x70000000UL )
+#define RCC_D2CCIP2R_LPTIM1SEL_2       ( 0x40000000UL )
+#define RCC_APB1LENR_LPTIM1EN          ( 0x00000200UL )
+#define RCC_APB1LLPENR_LPTIM1LPEN      ( 0x00000200UL )
+
+typedef struct
+{
+    volatile uint32_t ISR;
+    volatile uint32_t ICR;
+    volatile uint32_t IER;
+    volatile uint32_t CFGR;
+    volatile uint32_t CR;
+    volatile uint32_t CMP;
+    volatile uint32_t ARR;
+    volatile uint32_t CNT;
+} LPTIM_TypeDef;
+
+extern LPTIM_TypeDef xFakeLPTIM1;
+#define LPTIM1                         ( &xFakeLPTIM1 )
+
+#define LPTIM_ISR_CMPM                 ( 0x00000001UL )
+#define LPTIM_ISR_ARROK                ( 0x00000010UL )
+#define LPTIM_ISR_CMPOK                ( 0x00000008UL )
+#define LPTIM_ICR_CMPMCF               ( 0x00000001UL )
+#define LPTIM_ICR_ARROKCF              ( 0x00000010UL )
+#define LPTIM_ICR_CMPOKCF              ( 0x00000008UL )
+#define LPTIM_IER_CMPMIE               ( 0x00000001UL )
+#define LPTIM_CR_ENABLE                ( 0x00000001UL )
+#define LPTIM_CR_CNTSTRT               ( 0x00000004UL )
+
+typedef struct
+{
+    volatile uint32_t RTSR3;
+} EXTI_TypeDef;
+
+typedef struct
+{
+    volatile uint32_t IMR2;
+    volatile uint32_t IMR3;
+    volatile uint32_t PR3;
+} EXTI_Core_TypeDef;
+
+extern EXTI_TypeDef xFakeEXTI;
+extern EXTI_Core_TypeDef xFakeEXTI_D1;
+#define EXTI                           ( &xFakeEXTI )
+#define EXTI_D1                        ( &xFakeEXTI_D1 )
+
+#define EXTI_IMR2_IM47                 ( 0x00008000UL )
+#define EXTI_RTSR3_TR86                ( 0x00400000UL )
+#define EXTI_IMR3_IM86                 ( 0x00400000UL )
+#define EXTI_PR3_PR86                  ( 0x00400000UL )
+
+typedef enum
+{
+    LPTIM1_IRQn = 93
+} IRQn_Type;
+
+#define SET_BIT( REG, BIT )                     ( ( REG ) |= ( BIT ) )
+#define CLEAR_BIT( REG, BIT )                   ( ( REG ) &= ~( BIT ) )
+#define READ_BIT( REG, BIT )                    ( ( REG ) & ( BIT ) )
+#define MODIFY_REG( REG, CLEARMASK, SETMASK )   ( ( REG ) = ( ( ( REG ) & ( ~( CLEARMASK ) ) ) | ( SETMASK ) ) )
+
+/* Interrupts are not simulated: masking and the barriers do nothing, and
+ * the core sleeps in the sleep hook of fake_hal.h. */
+#define __disable_irq()
+#define __enable_irq()
+#define __DSB()
+#define __ISB()
+#define __WFI()                                 vFakeHALSleep( 0 )
+
+/* Nothing comes between a load and a store, so an exclusive store always
+ * succeeds. */
+#define __LDREXW( pulAddress )                  ( *( pulAddress ) )
+#define __STREXW( ulValue, pulAddress )         ( *( pulAddress ) = ( ulValue ), 0U )
+#define __CLREX()
+
+void vFakeHALSleep( int xStop );
+
+#define NVIC_EnableIRQ( IRQn )                  ( ( void ) ( IRQn ) )
+#define NVIC_DisableIRQ( IRQn )                 ( ( void ) ( IRQn ) )
+#define NVIC_ClearPendingIRQ( IRQn )            ( ( void ) ( IRQn ) )
+#define HAL_NVIC_SetPriority( IRQn, P, S )      ( ( void ) ( IRQn ), ( void ) ( P ), ( void ) ( S ) )
+#define HAL_NVIC_DisableIRQ( IRQn )             ( ( void ) ( IRQn ) )
+
+#define PWR_LOWPOWERREGULATOR_ON                ( 0x00000001UL )
+#define PWR_STOPENTRY_WFI                       ( 0x01U )
+#define PWR_D1_DOMAIN                           ( 0x00000000U )
+
+void HAL_PWREx_EnterSTOPMode( uint32_t Regulator,
+                              uint8_t STOPEntry,
+                              uint32_t Domain );
+
+/* The DMA rings of the Ethernet MAC, as in stm32h7xx_hal_conf.h. */
+#define ETH_TX_DESC_CNT                         4
+#define ETH_RX_DESC_CNT                         4
+
+typedef enum
+{
+    HAL_OK = 0x00U,
+    HAL_ERROR = 0x01U,
+    HAL_BUSY = 0x02U,
+    HAL_TIMEOUT = 0x03U
+} HAL_StatusTypeDef;
+
+typedef enum
+{
+    HAL_UNLOCKED = 0x00U,
+    HAL_LOCKED = 0x01U
+} HAL_LockTypeDef;
+
+#define __HAL_UNLOCK( HANDLE )                  ( ( HANDLE )->Lock = HAL_UNLOCKED )
+
+/* The RNG makes the words of fake_rng.h, and fails on demand.  A conversion
+ * started with HAL_RNG_GenerateRandomNumber_IT() completes when the test
+ * plays its interrupt. */
+typedef enum
+{
+    HAL_RNG_STATE_RESET = 0x00U,
+    HAL_RNG_STATE_READY = 0x01U,
+    HAL_RNG_STATE_BUSY = 0x02U,
+    HAL_RNG_STATE_TIMEOUT = 0x03U,
+    HAL_RNG_STATE_ERROR = 0x04U
+} HAL_RNG_StateTypeDef;
+
+typedef struct
+{
+    HAL_LockTypeDef Lock;
+    volatile HAL_RNG_StateTypeDef State;
+    volatile uint32_t ErrorCode;
+    uint32_t RandomNumber;
+} RNG_HandleTypeDef;
+
+#define HAL_RNG_ERROR_NONE                      ( 0x00000000U )
+#define HAL_RNG_ERROR_TIMEOUT                   ( 0x00000002U )
+#define HAL_RNG_ERROR_BUSY                      ( 0x00000004U )
+#define HAL_RNG_ERROR_SEED                      ( 0x00000008U )
+#define HAL_RNG_ERROR_CLOCK                     ( 0x00000010U )
+
+HAL_StatusTypeDef HAL_RNG_GenerateRandomNumber( RNG_HandleTypeDef * hrng,
+                                                uint32_t * random32bit );
+HAL_StatusTypeDef HAL_RNG_GenerateRandomNumber_IT( RNG_HandleTypeDef * hrng );
+HAL_StatusTypeDef HAL_RNGEx_RecoverSeedError( RNG_HandleTypeDef * hrng );
+void HAL_RNG_ReadyDataCallback( RNG_HandleTypeDef * hrng,
+                                uint32_t random32bit );
+void HAL_RNG_ErrorCallback( RNG_HandleTypeDef * hrng );
+
+extern uint32_t SystemCoreClock;
+extern volatile uint32_t uwTick;
+
+void HAL_SuspendTick( void );
+void HAL_ResumeTick( void );
+
+uint32_t HAL_GetTick( void );
+uint32_t HAL_GetUIDw0( void );
+uint32_t HAL_GetUIDw1( void );
+uint32_t HAL_GetUIDw2( void );
+
+#endif /* STM32H7xx_HAL_H */
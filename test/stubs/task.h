@@ -0,0 +1,93 @@
+#ifndef INC_TASK_H
+#define INC_TASK_H
+
+#include "FreeRTOS.h"
+#include "list.h"
+
+typedef struct tskTaskControlBlock * TaskHandle_t;
+typedef void (* TaskFunction_t)( void * pvParameters );
+
+typedef enum
+{
+    eRunning = 0,
+    eReady,
+    eBlocked,
+    eSuspended,
+    eDeleted,
+    eInvalid
+} eTaskState;
+
+typedef enum
+{
+    eAbortSleep = 0,
+    eStandardSleep,
+    eNoTasksWaitingTimeout
+} eSleepModeStatus;
+
+typedef struct xTASK_STATUS
+{
+    TaskHandle_t xHandle;
+    const char * pcTaskName;
+    UBaseType_t xTaskNumber;
+    eTaskState eCurrentState;
+    UBaseType_t uxCurrentPriority;
+    UBaseType_t uxBasePriority;
+    uint32_t ulRunTimeCounter;
+    StackType_t * pxStackBase;
+    uint16_t usStackHighWaterMark;
+} TaskStatus_t;
+
+typedef struct xTIME_OUT
+{
+    BaseType_t xOverflowCount;
+    TickType_t xTimeOnEntering;
+} TimeOut_t;
+
+#define taskSCHEDULER_SUSPENDED      ( ( BaseType_t ) 0 )
+#define taskSCHEDULER_NOT_STARTED    ( ( BaseType_t ) 1 )
+#define taskSCHEDULER_RUNNING        ( ( BaseType_t ) 2 )
+
+BaseType_t xTaskCreate( TaskFunction_t pxTaskCode,
+                        const char * const pcName,
+                        const uint16_t usStackDepth,
+                        void * const pvParameters,
+                        UBaseType_t uxPriority,
+                        TaskHandle_t * const pxCreatedTask );
+TaskHandle_t xTaskCreateStatic( TaskFunction_t pxTaskCode,
+                                const char * const pcName,
+                                const uint32_t ulStackDepth,
+                                void * const pvParameters,
+                                UBaseType_t uxPriority,
+                                StackType_t * const puxStackBuffer,
+                                StaticTask_t * const pxTaskBuffer );
+void vTaskDelete( TaskHandle_t xTaskToDelete );
+void vTaskDelay( const TickType_t xTicksToDelay );
+void vTaskDelayUntil( TickType_t * const pxPreviousWakeTime,
+                      const TickType_t xTimeIncrement );
+void vTaskSuspend( TaskHandle_t xTaskToSuspend );
+void vTaskResume( TaskHandle_t xTaskToResume );
+TickType_t xTaskGetTickCount( void );
+TickType_t xTaskGetTickCountFromISR( void );
+TaskHandle_t xTaskGetCurrentTaskHandle( void );
+char * pcTaskGetName( TaskHandle_t xTaskToQuery );
+UBaseType_t uxTaskGetNumberOfTasks( void );
+UBaseType_t uxTaskGetSystemState( TaskStatus_t * const pxTaskStatusArray,
+                                  const UBaseType_t uxArraySize,
+                                  uint32_t * const pulTotalRunTime );
+UBaseType_t uxTaskGetStackHighWaterMark( TaskHandle_t xTask );
+BaseType_t xTaskNotifyGive( TaskHandle_t xTaskToNotify );
+void vTaskNotifyGiveFromISR( TaskHandle_t xTaskToNotify,
+                             BaseType_t * pxHigherPriorityTaskWoken );
+uint32_t ulTaskNotifyTake( BaseType_t xClearCountOnExit,
+                           TickType_t xTicksToWait );
+BaseType_t xTaskGetSchedulerState( void );
+void vTaskSuspendAll( void );
+BaseType_t xTaskResumeAll( void );
+void vTaskStepTick( TickType_t xTicksToJump );
+eSleepModeStatus eTaskConfirmSleepModeStatus( void );
+void vTaskSetTimeOutState( TimeOut_t * const pxTimeOut );
+BaseType_t xTaskCheckForTimeOut( TimeOut_t * const pxTimeOut,
+                                 TickType_t * const pxTicksToWait );
+void vTaskStartScheduler( void );
+
+#endif /* INC_TASK_H */
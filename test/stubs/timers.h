@@ -0,0 +1,35 @@
+#ifndef TIMERS_H
+#define TIMERS_H
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+typedef struct tmrTimerControl * TimerHandle_t;
+typedef void (* TimerCallbackFunction_t)( TimerHandle_t xTimer );
+typedef void (* PendedFunction_t)( void * pvParameter1,
+                                   uint32_t ulParameter2 );
+
+TimerHandle_t xTimerCreate( const char * const pcTimerName,
+                            const TickType_t xTimerPeriodInTicks,
+                            const UBaseType_t uxAutoReload,
+                            void * const pvTimerID,
+                            TimerCallbackFunction_t pxCallbackFunction );
+BaseType_t xTimerStart( TimerHandle_t xTimer,
+                        TickType_t xTicksToWait );
+BaseType_t xTimerStop( TimerHandle_t xTimer,
+                       TickType_t xTicksToWait );
+BaseType_t xTimerChangePeriod( TimerHandle_t xTimer,
+                               TickType_t xNewPeriod,
+                               TickType_t xTicksToWait );
+TickType_t xTimerGetPeriod( TimerHandle_t xTimer );
+void * pvTimerGetTimerID( const TimerHandle_t xTimer );
+BaseType_t xTimerPendFunctionCall( PendedFunction_t xFunctionToPend,
+                                   void * pvParameter1,
+                                   uint32_t ulParameter2,
+                                   TickType_t xTicksToWait );
+BaseType_t xTimerPendFunctionCallFromISR( PendedFunction_t xFunctionToPend,
+                                          void * pvParameter1,
+                                          uint32_t ulParameter2,
+                                          BaseType_t * pxHigherPriorityTaskWoken );
+
+#endif /* TIMERS_H */
@@ -0,0 +1,41 @@
+#ifndef TEST_H
+#define TEST_H
+
+/* Standard includes. */
+#include <stdio.h>
+#include <stdlib.h>
+
+/*
+ * Checks for the host tests.  A failed check prints where and what, and ends
+ * the test with a non-zero exit code.
+ */
+
+#define TEST_CHECK( xCondition )                                              \
+    do {                                                                      \
+        if( !( xCondition ) )                                                 \
+        {                                                                     \
+            fprintf( stderr, "%s:%d: check failed: %s\n",                     \
+                     __FILE__, __LINE__, #xCondition );                       \
+            exit( 1 );                                                        \
+        }                                                                     \
+    } while( 0 )
+
+#define TEST_CHECK_EQUAL( xExpected, xActual )                                \
+    do {                                                                      \
+        long long llExpected_ = ( long long ) ( xExpected );                  \
+        long long llActual_ = ( long long ) ( xActual );                      \
+        if( llExpected_ != llActual_ )                                        \
+        {                                                                     \
+            fprintf( stderr, "%s:%d: %s is %lld, expected %lld\n",            \
+                     __FILE__, __LINE__, #xActual, llActual_, llExpected_ );  \
+            exit( 1 );                                                        \
+        }                                                                     \
+    } while( 0 )
+
+#define TEST_RUN( fnTest )                    \
+    do {                                      \
+        printf( "%s\n", #fnTest );            \
+        fnTest();                             \
+    } while( 0 )
+
+#endif /* TEST_H */
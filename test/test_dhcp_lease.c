@@ -0,0 +1,423 @@
+/* A small sector, so that it fills up quickly. */
+#define configDHCP_LEASE_RECORD_COUNT    8U
+
+/* Included, so that a reset can be simulated by clearing the RAM copies. */
+#include "dhcp_lease.c"
+
+/* Standard includes. */
+#include <string.h>
+
+#include "fake_flash.h"
+#include "fake_kernel.h"
+#include "test.h"
+
+#define testSLOTS    configDHCP_LEASE_RECORD_COUNT
+
+/* The sector, see fake_flash.h. */
+static FakeFlash_t * pxFlash;
+
+/* Saves that the tick hook makes at a given tick. */
+static TickType_t xSaveAtTick = 0U;
+static DHCPLease_t xSaveAtTickLease;
+
+/*-----------------------------------------------------------*/
+
+static void prvSaveAtTick( void )
+{
+    if( xTaskGetTickCount() == xSaveAtTick )
+    {
+        ( void ) xDHCPLeaseSave( &xSaveAtTickLease );
+    }
+}
+/*-----------------------------------------------------------*/
+
+static DHCPLease_t prvLease( uint32_t ulHost )
+{
+    DHCPLease_t xLease;
+
+    memset( &xLease, 0, sizeof( xLease ) );
+    xLease.ulIPAddress = FreeRTOS_htonl( 0xC0A80100UL + ulHost );
+    xLease.ulNetMask = FreeRTOS_htonl( 0xFFFFFF00UL );
+    xLease.ulGatewayAddress = FreeRTOS_htonl( 0xC0A80101UL );
+    xLease.ulDNSServerAddress = FreeRTOS_htonl( 0xC0A80101UL );
+    xLease.ulLeaseSeconds = 3600U;
+
+    return xLease;
+}
+/*-----------------------------------------------------------*/
+
+static RALease_t prvRALease( uint8_t ucSubnet )
+{
+    RALease_t xLease;
+
+    memset( &xLease, 0, sizeof( xLease ) );
+    xLease.ucPrefix[ 0 ] = 0x20U;
+    xLease.ucPrefix[ 1 ] = 0x01U;
+    xLease.ucPrefix[ 7 ] = ucSubnet;
+    xLease.ucGatewayIID[ 7 ] = 0x01U;
+    xLease.ulPrefixLength = 64U;
+
+    return xLease;
+}
+/*-----------------------------------------------------------*/
+
+/* Write a record straight into the flash, as an older firmware would have. */
+static void prvPutRecord( size_t uxSlot,
+                          BaseType_t xKind,
+                          uint32_t ulSequence,
+                          uint32_t ulHost,
+                          BaseType_t xGoodCRC )
+{
+    DHCPLeaseRecord_t xRecord;
+    DHCPLease_t xLease = prvLease( ulHost );
+    RALease_t xRA = prvRALease( ( uint8_t ) ulHost );
+
+    memset( &xRecord, 0, sizeof( xRecord ) );
+    xRecord.ulMagic = ulMagics[ xKind ];
+    xRecord.ulSequence = ulSequence;
+
+    if( xKind == dhcpleaseKIND_DHCP )
+    {
+        memcpy( &( xRecord.u ), &xLease, sizeof( xLease ) );
+    }
+    else
+    {
+        memcpy( &( xRecord.u ), &xRA, sizeof( xRA ) );
+    }
+
+    xRecord.ulCRC = prvRecordCRC( &xRecord ) ^ ( ( xGoodCRC != pdFALSE ) ? 0U : 1U );
+    memcpy( pxFlash->ucSlots[ uxSlot ], &xRecord, sizeof( xRecord ) );
+}
+/*-----------------------------------------------------------*/
+
+/* A reset: the RAM is gone, the flash stays. */
+static void prvBoot( void )
+{
+    vFakeKernelReset();
+    memset( xNewest, 0, sizeof( xNewest ) );
+    memset( xHaveNewest, 0, sizeof( xHaveNewest ) );
+    memset( xPending, 0, sizeof( xPending ) );
+    memset( xHavePending, 0, sizeof( xHavePending ) );
+    xLeaseTask = NULL;
+    ulLastSequence = 0U;
+    uxNextSlot = 0U;
+    xEraseNeeded = pdFALSE;
+    pxFlash->ulPrograms = 0U;
+    pxFlash->ulErases = 0U;
+
+    TEST_CHECK_EQUAL( pdPASS, xDHCPLeaseInitialise() );
+    TEST_CHECK( xLeaseTask != NULL );
+}
+/*-----------------------------------------------------------*/
+
+/* A new board, with an erased sector. */
+static void prvSetUp( void )
+{
+    vFakeFlashReset();
+    pxFlash = pxFakeFlash();
+    xSaveAtTick = 0U;
+
+    prvBoot();
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvHaveLease( uint32_t ulHost )
+{
+    DHCPLease_t xExpected = prvLease( ulHost );
+    DHCPLease_t xLease;
+
+    return ( xDHCPLeaseLoad( &xLease ) == pdPASS ) && ( memcmp( &xLease, &xExpected, sizeof( xLease ) ) == 0 );
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvHaveRALease( uint8_t ucSubnet )
+{
+    RALease_t xExpected = prvRALease( ucSubnet );
+    RALease_t xLease;
+
+    return ( xRALeaseLoad( &xLease ) == pdPASS ) && ( memcmp( &xLease, &xExpected, sizeof( xLease ) ) == 0 );
+}
+/*-----------------------------------------------------------*/
+
+static void prvSaveLease( uint32_t ulHost )
+{
+    DHCPLease_t xLease = prvLease( ulHost );
+
+    TEST_CHECK_EQUAL( pdPASS, xDHCPLeaseSave( &xLease ) );
+    prvWriteRecords();
+}
+/*-----------------------------------------------------------*/
+
+static void prvSaveRALease( uint8_t ucSubnet )
+{
+    RALease_t xLease = prvRALease( ucSubnet );
+
+    TEST_CHECK_EQUAL( pdPASS, xRALeaseSave( &xLease ) );
+    prvWriteRecords();
+}
+/*-----------------------------------------------------------*/
+
+static void test_erased_sector( void )
+{
+    DHCPLease_t xLease;
+    RALease_t xRA;
+
+    prvSetUp();
+
+    TEST_CHECK_EQUAL( pdFAIL, xDHCPLeaseLoad( &xLease ) );
+    TEST_CHECK_EQUAL( pdFAIL, xRALeaseLoad( &xRA ) );
+    TEST_CHECK_EQUAL( 0, uxNextSlot );
+    TEST_CHECK_EQUAL( 0, pxFlash->ulPrograms );
+    TEST_CHECK_EQUAL( 0, pxFlash->ulErases );
+}
+/*-----------------------------------------------------------*/
+
+static void test_round_trip( void )
+{
+    prvSetUp();
+
+    prvSaveLease( 10U );
+    prvSaveRALease( 1U );
+    TEST_CHECK_EQUAL( 2, pxFlash->ulPrograms );
+    TEST_CHECK( prvHaveLease( 10U ) );
+    TEST_CHECK( prvHaveRALease( 1U ) );
+
+    prvBoot();
+    TEST_CHECK( prvHaveLease( 10U ) );
+    TEST_CHECK( prvHaveRALease( 1U ) );
+    TEST_CHECK_EQUAL( 2, uxNextSlot );
+
+    /* The same lease again is not written. */
+    prvSaveLease( 10U );
+    TEST_CHECK_EQUAL( 0, pxFlash->ulPrograms );
+
+    prvSaveLease( 11U );
+    TEST_CHECK_EQUAL( 1, pxFlash->ulPrograms );
+
+    prvBoot();
+    TEST_CHECK( prvHaveLease( 11U ) );
+    TEST_CHECK( prvHaveRALease( 1U ) );
+    TEST_CHECK_EQUAL( 3, uxNextSlot );
+}
+/*-----------------------------------------------------------*/
+
+static void test_newest_pending( void )
+{
+    DHCPLease_t xFirst = prvLease( 20U );
+    DHCPLease_t xSecond = prvLease( 21U );
+
+    prvSetUp();
+
+    /* Two saves before the lease task runs: only the second is written. */
+    TEST_CHECK_EQUAL( pdPASS, xDHCPLeaseSave( &xFirst ) );
+    TEST_CHECK_EQUAL( pdPASS, xDHCPLeaseSave( &xSecond ) );
+    prvWriteRecords();
+
+    TEST_CHECK_EQUAL( 1, pxFlash->ulPrograms );
+    TEST_CHECK( prvHaveLease( 21U ) );
+}
+/*-----------------------------------------------------------*/
+
+static void test_damaged_slots( void )
+{
+    prvSetUp();
+
+    prvPutRecord( 0U, dhcpleaseKIND_DHCP, 1U, 30U, pdTRUE );
+    prvPutRecord( 1U, dhcpleaseKIND_DHCP, 4U, 31U, pdFALSE );
+    prvPutRecord( 2U, dhcpleaseKIND_DHCP, 5U, 32U, pdTRUE );
+    pxFlash->xECCError[ 2 ] = pdTRUE;
+    prvPutRecord( 3U, dhcpleaseKIND_RA, 2U, 3U, pdTRUE );
+    prvPutRecord( 4U, dhcpleaseKIND_DHCP, 3U, 33U, pdTRUE );
+
+    /* The CRC error and the ECC error are skipped, and the newest of the
+     * rest wins, whatever its place. */
+    prvBoot();
+    TEST_CHECK( prvHaveLease( 33U ) );
+    TEST_CHECK( prvHaveRALease( 3U ) );
+    TEST_CHECK_EQUAL( 5, uxNextSlot );
+    TEST_CHECK_EQUAL( 3, ulLastSequence );
+
+    /* New records go after the last used slot, and get a higher number than
+     * all valid records. */
+    prvSaveLease( 34U );
+    TEST_CHECK_EQUAL( 4, xNewest[ dhcpleaseKIND_DHCP ].ulSequence );
+    TEST_CHECK_EQUAL( 6, uxNextSlot );
+
+    /* A record torn by a reset at the end of the log, the next one goes after
+     * it. */
+    prvPutRecord( 6U, dhcpleaseKIND_DHCP, 5U, 35U, pdTRUE );
+    pxFlash->xECCError[ 6 ] = pdTRUE;
+    prvBoot();
+    TEST_CHECK( prvHaveLease( 34U ) );
+    TEST_CHECK_EQUAL( 7, uxNextSlot );
+
+    prvSaveLease( 36U );
+    TEST_CHECK_EQUAL( 1, pxFlash->ulPrograms );
+    TEST_CHECK_EQUAL( pdFALSE, pxFlash->xECCError[ 7 ] );
+
+    prvBoot();
+    TEST_CHECK( prvHaveLease( 36U ) );
+    TEST_CHECK( prvHaveRALease( 3U ) );
+}
+/*-----------------------------------------------------------*/
+
+static void test_full_sector( void )
+{
+    TickType_t xLastSave;
+    uint32_t x;
+
+    prvSetUp();
+
+    prvSaveRALease( 4U );
+
+    for( x = 0; x < ( testSLOTS - 1U ); x++ )
+    {
+        prvSaveLease( 40U + x );
+    }
+
+    TEST_CHECK_EQUAL( testSLOTS, uxNextSlot );
+
+    /* The network comes up: the new records are kept in RAM only. */
+    vFakeKernelAdvance( 1000U );
+    prvSaveLease( 50U );
+    prvSaveRALease( 5U );
+    TEST_CHECK_EQUAL( 0, pxFlash->ulErases );
+    TEST_CHECK_EQUAL( testSLOTS, pxFlash->ulPrograms );
+    TEST_CHECK( xEraseNeeded != pdFALSE );
+    TEST_CHECK( prvHaveLease( 50U ) );
+    TEST_CHECK( prvHaveRALease( 5U ) );
+
+    /* Another save before the delay ran out starts it again. */
+    xSaveAtTick = xTaskGetTickCount() + ( configDHCP_LEASE_ERASE_DELAY_MS / 2U );
+    xSaveAtTickLease = prvLease( 51U );
+    vFakeKernelSetTickHook( prvSaveAtTick );
+    prvWriteRecords();
+    vFakeKernelSetTickHook( NULL );
+    TEST_CHECK_EQUAL( 0, pxFlash->ulErases );
+    TEST_CHECK( prvHaveLease( 51U ) );
+    xLastSave = xTaskGetTickCount();
+
+    /* Quiet for configDHCP_LEASE_ERASE_DELAY_MS: erase, and write back the
+     * newest record of each kind. */
+    prvWriteRecords();
+    TEST_CHECK_EQUAL( 1, pxFlash->ulErases );
+    TEST_CHECK_EQUAL( pdMS_TO_TICKS( configDHCP_LEASE_ERASE_DELAY_MS ), pxFlash->xEraseTick - xLastSave );
+    TEST_CHECK_EQUAL( pdFALSE, xEraseNeeded );
+    TEST_CHECK_EQUAL( 2, uxNextSlot );
+
+    prvBoot();
+    TEST_CHECK( prvHaveLease( 51U ) );
+    TEST_CHECK( prvHaveRALease( 5U ) );
+    TEST_CHECK_EQUAL( 2, uxNextSlot );
+}
+/*-----------------------------------------------------------*/
+
+static void test_boot_with_full_sector( void )
+{
+    uint32_t x;
+
+    prvSetUp();
+
+    for( x = 0; x < testSLOTS; x++ )
+    {
+        prvPutRecord( x, dhcpleaseKIND_DHCP, x + 1U, 60U + x, pdTRUE );
+    }
+
+    /* Saving at bring-up never erases. */
+    prvBoot();
+    TEST_CHECK_EQUAL( testSLOTS, uxNextSlot );
+    prvSaveLease( 70U );
+    TEST_CHECK_EQUAL( 0, pxFlash->ulErases );
+    TEST_CHECK_EQUAL( 0, pxFlash->ulPrograms );
+    TEST_CHECK( prvHaveLease( 70U ) );
+
+    /* A failed erase leaves the sector full, and the next save tries again
+     * after the delay. */
+    pxFlash->xEraseFails = pdTRUE;
+    prvWriteRecords();
+    TEST_CHECK_EQUAL( 1, pxFlash->ulErases );
+    TEST_CHECK_EQUAL( 0, pxFlash->ulPrograms );
+    TEST_CHECK_EQUAL( testSLOTS, uxNextSlot );
+    TEST_CHECK_EQUAL( pdFALSE, xEraseNeeded );
+
+    pxFlash->xEraseFails = pdFALSE;
+    prvSaveLease( 71U );
+    TEST_CHECK( xEraseNeeded != pdFALSE );
+    prvWriteRecords();
+    TEST_CHECK_EQUAL( 2, pxFlash->ulErases );
+
+    prvBoot();
+    TEST_CHECK( prvHaveLease( 71U ) );
+    TEST_CHECK_EQUAL( 1, uxNextSlot );
+}
+/*-----------------------------------------------------------*/
+
+static void test_worn_out( void )
+{
+    prvSetUp();
+
+    prvSaveLease( 80U );
+
+    /* The read back fails: the old lease stays, and the slot is not used
+     * again. */
+    pxFlash->xWornOut = pdTRUE;
+    prvSaveLease( 81U );
+    TEST_CHECK( prvHaveLease( 80U ) );
+    TEST_CHECK_EQUAL( 2, uxNextSlot );
+
+    pxFlash->xWornOut = pdFALSE;
+    prvSaveLease( 82U );
+    TEST_CHECK_EQUAL( 3, uxNextSlot );
+
+    prvBoot();
+    TEST_CHECK( prvHaveLease( 82U ) );
+}
+/*-----------------------------------------------------------*/
+
+static void test_end_point( void )
+{
+    NetworkEndPoint_t xEndPoint;
+    DHCPLease_t xLease;
+
+    prvSetUp();
+
+    memset( &xEndPoint, 0, sizeof( xEndPoint ) );
+    xEndPoint.bits.bWantDHCP = pdTRUE_UNSIGNED;
+    xEndPoint.ipv4_settings.ulIPAddress = FreeRTOS_htonl( 0xC0A80140UL );
+    xEndPoint.ipv4_settings.ulNetMask = FreeRTOS_htonl( 0xFFFFFF00UL );
+    xEndPoint.xDHCPData.ulLeaseTime = 7200U * configTICK_RATE_HZ;
+
+    /* The defaults after DHCP failed are not stored. */
+    xEndPoint.xDHCPData.eDHCPState = eInitialWait;
+    vDHCPLeaseEndPointUp( &xEndPoint );
+    TEST_CHECK_EQUAL( pdFALSE, xHavePending[ dhcpleaseKIND_DHCP ] );
+
+    xEndPoint.xDHCPData.eDHCPState = eLeasedAddress;
+    vDHCPLeaseEndPointUp( &xEndPoint );
+    prvWriteRecords();
+    TEST_CHECK_EQUAL( pdPASS, xDHCPLeaseLoad( &xLease ) );
+    TEST_CHECK_EQUAL( 7200, xLease.ulLeaseSeconds );
+
+    /* The next boot starts from the lease. */
+    prvBoot();
+    memset( &xEndPoint, 0, sizeof( xEndPoint ) );
+    TEST_CHECK_EQUAL( pdPASS, xDHCPLeaseApply( &xEndPoint ) );
+    TEST_CHECK_EQUAL( FreeRTOS_htonl( 0xC0A80140UL ), xEndPoint.ipv4_settings.ulIPAddress );
+    TEST_CHECK_EQUAL( FreeRTOS_htonl( 0xC0A801FFUL ), xEndPoint.ipv4_defaults.ulBroadcastAddress );
+}
+/*-----------------------------------------------------------*/
+
+int main( void )
+{
+    TEST_RUN( test_erased_sector );
+    TEST_RUN( test_round_trip );
+    TEST_RUN( test_newest_pending );
+    TEST_RUN( test_damaged_slots );
+    TEST_RUN( test_full_sector );
+    TEST_RUN( test_boot_with_full_sector );
+    TEST_RUN( test_worn_out );
+    TEST_RUN( test_end_point );
+
+    return 0;
+}
+/*-----------------------------------------------------------*/
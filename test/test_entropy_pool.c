@@ -0,0 +1,328 @@
+/* Included, so that the pool and the DRBG can be reset between the tests. */
+#include "entropy_pool.c"
+
+/* Standard includes. */
+#include <string.h>
+
+#include "fake_kernel.h"
+#include "fake_rng.h"
+#include "test.h"
+
+/* The handle of main.c. */
+RNG_HandleTypeDef hrng;
+
+/*-----------------------------------------------------------*/
+
+static void prvSetUp( void )
+{
+    vFakeKernelReset();
+    vFakeRNGReset();
+    memset( &hrng, 0, sizeof( hrng ) );
+    hrng.State = HAL_RNG_STATE_READY;
+
+    /* The state of entropy_pool.c. */
+    memset( ulPool, 0, sizeof( ulPool ) );
+    ulPoolHead = 0U;
+    ulPoolTail = 0U;
+    memset( ulKey, 0, sizeof( ulKey ) );
+    ulBlockCounter = 0U;
+    memset( ulOutput, 0, sizeof( ulOutput ) );
+    uxOutputOffset = sizeof( ulOutput );
+    ulBlocksSinceReseed = 0U;
+    xSeeded = pdFALSE;
+    xRNGBusy = pdFALSE;
+    xRecovering = pdFALSE;
+    ulConsecutiveErrors = 0U;
+    memset( &xStats, 0, sizeof( xStats ) );
+}
+/*-----------------------------------------------------------*/
+
+/* Play the RNG interrupts until no conversion runs any more. */
+static uint32_t prvRunRNG( void )
+{
+    uint32_t ulInterrupts = 0U;
+
+    while( xFakeRNGInterrupt() != pdFALSE )
+    {
+        ulInterrupts++;
+    }
+
+    return ulInterrupts;
+}
+/*-----------------------------------------------------------*/
+
+/* RFC 7539, appendix A.1, test vector #1: zero key, nonce and counter. */
+static void test_chacha_block( void )
+{
+    static const uint32_t ulExpected[ 16 ] =
+    {
+        0xADE0B876UL, 0x903DF1A0UL, 0xE56A5D40UL, 0x28BD8653UL,
+        0xB819D2BDUL, 0x1AED8DA0UL, 0xCCEF36A8UL, 0xC70D778BUL,
+        0x7C5941DAUL, 0x8D485751UL, 0x3FE02477UL, 0x374AD8B8UL,
+        0xF4B8436AUL, 0x1CA11815UL, 0x69B687C3UL, 0x8665EEB2UL
+    };
+    uint32_t ulBlock[ 16 ];
+    size_t x;
+
+    prvSetUp();
+    prvChaChaBlock( ulBlock );
+
+    for( x = 0; x < 16U; x++ )
+    {
+        TEST_CHECK_EQUAL( ulExpected[ x ], ulBlock[ x ] );
+    }
+}
+/*-----------------------------------------------------------*/
+
+static void test_seed_and_fill( void )
+{
+    EntropyPoolStats_t xPoolStats;
+    size_t x;
+
+    prvSetUp();
+
+    /* The key is polled, then the pool fills one interrupt at a time. */
+    TEST_CHECK_EQUAL( pdPASS, xEntropyPoolInitialise() );
+    TEST_CHECK_EQUAL( 9, ulFakeRNGConversions() );
+
+    for( x = 0; x < 8U; x++ )
+    {
+        TEST_CHECK_EQUAL( x + 1U, ulKey[ x ] );
+    }
+
+    TEST_CHECK_EQUAL( configENTROPY_POOL_WORDS, prvRunRNG() );
+    vEntropyPoolGetStats( &xPoolStats );
+    TEST_CHECK_EQUAL( configENTROPY_POOL_WORDS, xPoolStats.ulRawWords );
+    TEST_CHECK_EQUAL( configENTROPY_POOL_WORDS, xPoolStats.uxPoolWords );
+
+    /* A full pool does not start the RNG. */
+    TEST_CHECK_EQUAL( 8 + configENTROPY_POOL_WORDS, ulFakeRNGConversions() );
+}
+/*-----------------------------------------------------------*/
+
+static void test_raw_words( void )
+{
+    uint32_t ulValue = 0U;
+    uint32_t x;
+
+    prvSetUp();
+    TEST_CHECK_EQUAL( pdPASS, xEntropyPoolInitialise() );
+    ( void ) prvRunRNG();
+
+    /* In the order of the RNG, without waiting. */
+    for( x = 0; x < configENTROPY_POOL_WORDS; x++ )
+    {
+        TEST_CHECK_EQUAL( pdPASS, xEntropyPoolGetRaw( &ulValue ) );
+        TEST_CHECK_EQUAL( 9U + x, ulValue );
+    }
+
+    TEST_CHECK_EQUAL( pdFAIL, xEntropyPoolGetRaw( &ulValue ) );
+
+    /* The first read started a conversion, which refills the pool. */
+    TEST_CHECK_EQUAL( configENTROPY_POOL_WORDS, prvRunRNG() );
+    TEST_CHECK_EQUAL( pdPASS, xEntropyPoolGetRaw( &ulValue ) );
+    TEST_CHECK_EQUAL( 9U + configENTROPY_POOL_WORDS, ulValue );
+}
+/*-----------------------------------------------------------*/
+
+static void test_output( void )
+{
+    static uint8_t ucFirst[ 100 ];
+    static uint8_t ucSecond[ 100 ];
+    EntropyPoolStats_t xPoolStats;
+    uint32_t ulOldKey[ 8 ];
+    size_t x;
+    size_t y;
+
+    prvSetUp();
+    TEST_CHECK_EQUAL( pdPASS, xEntropyPoolInitialise() );
+    memcpy( ulOldKey, ulKey, sizeof( ulOldKey ) );
+
+    /* 32 bytes per block. */
+    TEST_CHECK_EQUAL( pdPASS, xEntropyPoolRandom( ucFirst, sizeof( ucFirst ) ) );
+    vEntropyPoolGetStats( &xPoolStats );
+    TEST_CHECK_EQUAL( 4, xPoolStats.ulBlocks );
+
+    /* The rest of the last block is used first. */
+    TEST_CHECK_EQUAL( pdPASS, xEntropyPoolRandom( ucSecond, 28U ) );
+    vEntropyPoolGetStats( &xPoolStats );
+    TEST_CHECK_EQUAL( 4, xPoolStats.ulBlocks );
+    TEST_CHECK_EQUAL( pdPASS, xEntropyPoolRandom( &( ucSecond[ 28 ] ), sizeof( ucSecond ) - 28U ) );
+    vEntropyPoolGetStats( &xPoolStats );
+    TEST_CHECK_EQUAL( 7, xPoolStats.ulBlocks );
+
+    /* No word of output comes twice. */
+    for( x = 0; x < sizeof( ucFirst ); x += 4U )
+    {
+        for( y = 0; y < sizeof( ucSecond ); y += 4U )
+        {
+            TEST_CHECK( memcmp( &( ucFirst[ x ] ), &( ucSecond[ y ] ), 4U ) != 0 );
+        }
+    }
+
+    /* The key was replaced, and the output that was handed out is gone. */
+    TEST_CHECK( memcmp( ulOldKey, ulKey, sizeof( ulKey ) ) != 0 );
+
+    TEST_CHECK_EQUAL( 8, uxOutputOffset );
+    TEST_CHECK_EQUAL( 0, ulOutput[ 0 ] );
+    TEST_CHECK_EQUAL( 0, ulOutput[ 1 ] );
+    TEST_CHECK( ulOutput[ 2 ] != 0U );
+
+    /* The same seed gives the same output. */
+    prvSetUp();
+    TEST_CHECK_EQUAL( pdPASS, xEntropyPoolInitialise() );
+    TEST_CHECK_EQUAL( pdPASS, xEntropyPoolRandom( ucSecond, sizeof( ucSecond ) ) );
+    TEST_CHECK( memcmp( ucFirst, ucSecond, sizeof( ucFirst ) ) == 0 );
+}
+/*-----------------------------------------------------------*/
+
+static void test_reseed( void )
+{
+    EntropyPoolStats_t xPoolStats;
+    uint8_t ucBlock[ 32 ];
+    uint32_t ulValue;
+    uint32_t x;
+
+    prvSetUp();
+    TEST_CHECK_EQUAL( pdPASS, xEntropyPoolInitialise() );
+    ( void ) prvRunRNG();
+
+    for( x = 0; x < configENTROPY_RESEED_BLOCKS; x++ )
+    {
+        TEST_CHECK_EQUAL( pdPASS, xEntropyPoolRandom( ucBlock, sizeof( ucBlock ) ) );
+    }
+
+    vEntropyPoolGetStats( &xPoolStats );
+    TEST_CHECK_EQUAL( 0, xPoolStats.ulReseeds );
+
+    /* The next block takes 8 words from the pool, and the RNG refills it. */
+    TEST_CHECK_EQUAL( pdPASS, xEntropyPoolRandom( ucBlock, sizeof( ucBlock ) ) );
+    vEntropyPoolGetStats( &xPoolStats );
+    TEST_CHECK_EQUAL( 1, xPoolStats.ulReseeds );
+    TEST_CHECK_EQUAL( configENTROPY_POOL_WORDS - 8, xPoolStats.uxPoolWords );
+    TEST_CHECK_EQUAL( 8, prvRunRNG() );
+
+    /* With an empty pool the DRBG goes on, and reseeds when words came. */
+    while( xEntropyPoolGetRaw( &ulValue ) == pdPASS )
+    {
+    }
+
+    for( x = 0; x <= configENTROPY_RESEED_BLOCKS; x++ )
+    {
+        TEST_CHECK_EQUAL( pdPASS, xEntropyPoolRandom( ucBlock, sizeof( ucBlock ) ) );
+    }
+
+    vEntropyPoolGetStats( &xPoolStats );
+    TEST_CHECK_EQUAL( 1, xPoolStats.ulReseeds );
+
+    ( void ) prvRunRNG();
+    TEST_CHECK_EQUAL( pdPASS, xEntropyPoolRandom( ucBlock, sizeof( ucBlock ) ) );
+    vEntropyPoolGetStats( &xPoolStats );
+    TEST_CHECK_EQUAL( 2, xPoolStats.ulReseeds );
+}
+/*-----------------------------------------------------------*/
+
+static void test_seed_error( void )
+{
+    EntropyPoolStats_t xPoolStats;
+
+    prvSetUp();
+    TEST_CHECK_EQUAL( pdPASS, xEntropyPoolInitialise() );
+
+    /* The interrupt reports the error, the timer task recovers. */
+    vFakeRNGFail( HAL_RNG_ERROR_SEED, 1U );
+    TEST_CHECK_EQUAL( pdTRUE, xFakeRNGInterrupt() );
+    TEST_CHECK_EQUAL( pdFALSE, xFakeRNGInterrupt() );
+    TEST_CHECK_EQUAL( HAL_RNG_STATE_ERROR, hrng.State );
+
+    vFakeKernelAdvance( 1U );
+    TEST_CHECK_EQUAL( 1, ulFakeRNGRecoveries() );
+    TEST_CHECK_EQUAL( HAL_RNG_STATE_BUSY, hrng.State );
+    TEST_CHECK_EQUAL( HAL_UNLOCKED, hrng.Lock );
+    TEST_CHECK_EQUAL( HAL_RNG_ERROR_NONE, hrng.ErrorCode );
+
+    TEST_CHECK_EQUAL( configENTROPY_POOL_WORDS, prvRunRNG() );
+    vEntropyPoolGetStats( &xPoolStats );
+    TEST_CHECK_EQUAL( 1, xPoolStats.ulSeedErrors );
+    TEST_CHECK_EQUAL( 0, xPoolStats.ulClockErrors );
+    TEST_CHECK_EQUAL( configENTROPY_POOL_WORDS, xPoolStats.uxPoolWords );
+}
+/*-----------------------------------------------------------*/
+
+static void test_clock_error( void )
+{
+    EntropyPoolStats_t xPoolStats;
+
+    /* A clock error needs no seed recovery, only a restart. */
+    prvSetUp();
+    TEST_CHECK_EQUAL( pdPASS, xEntropyPoolInitialise() );
+    vFakeRNGFail( HAL_RNG_ERROR_CLOCK, 1U );
+    TEST_CHECK_EQUAL( 1, prvRunRNG() );
+    vFakeKernelAdvance( 1U );
+    TEST_CHECK_EQUAL( 0, ulFakeRNGRecoveries() );
+
+    TEST_CHECK_EQUAL( configENTROPY_POOL_WORDS, prvRunRNG() );
+    vEntropyPoolGetStats( &xPoolStats );
+    TEST_CHECK_EQUAL( 1, xPoolStats.ulClockErrors );
+}
+/*-----------------------------------------------------------*/
+
+static void test_broken_rng( void )
+{
+    EntropyPoolStats_t xPoolStats;
+    uint8_t ucBlock[ 64 ];
+    uint32_t ulValue;
+    uint32_t x;
+
+    prvSetUp();
+    TEST_CHECK_EQUAL( pdPASS, xEntropyPoolInitialise() );
+    TEST_CHECK_EQUAL( 1, xFakeRNGInterrupt() );
+
+    /* After entropyMAX_CONSECUTIVE_ERRORS the RNG is left alone. */
+    vFakeRNGFail( HAL_RNG_ERROR_SEED, 100U );
+
+    for( x = 0; x < 20U; x++ )
+    {
+        ( void ) prvRunRNG();
+        vFakeKernelAdvance( 1U );
+    }
+
+    vEntropyPoolGetStats( &xPoolStats );
+    TEST_CHECK_EQUAL( entropyMAX_CONSECUTIVE_ERRORS, xPoolStats.ulSeedErrors );
+    TEST_CHECK_EQUAL( pdFALSE, xFakeRNGInterrupt() );
+
+    /* The word that came is still there, and the DRBG runs on its key. */
+    TEST_CHECK_EQUAL( pdPASS, xEntropyPoolGetRaw( &ulValue ) );
+    TEST_CHECK_EQUAL( 9, ulValue );
+    TEST_CHECK_EQUAL( pdFAIL, xEntropyPoolGetRaw( &ulValue ) );
+    TEST_CHECK_EQUAL( pdPASS, xEntropyPoolRandom( ucBlock, sizeof( ucBlock ) ) );
+}
+/*-----------------------------------------------------------*/
+
+static void test_not_seeded( void )
+{
+    uint8_t ucBlock[ 16 ];
+
+    /* The RNG fails while the key is polled. */
+    prvSetUp();
+    vFakeRNGFail( HAL_RNG_ERROR_CLOCK, 1U );
+    TEST_CHECK_EQUAL( pdFAIL, xEntropyPoolInitialise() );
+    TEST_CHECK_EQUAL( pdFAIL, xEntropyPoolRandom( ucBlock, sizeof( ucBlock ) ) );
+}
+/*-----------------------------------------------------------*/
+
+int main( void )
+{
+    TEST_RUN( test_chacha_block );
+    TEST_RUN( test_seed_and_fill );
+    TEST_RUN( test_raw_words );
+    TEST_RUN( test_output );
+    TEST_RUN( test_reseed );
+    TEST_RUN( test_seed_error );
+    TEST_RUN( test_clock_error );
+    TEST_RUN( test_broken_rng );
+    TEST_RUN( test_not_seeded );
+
+    return 0;
+}
+/*-----------------------------------------------------------*/
@@ -0,0 +1,1357 @@
+/* The server and client are left out by FreeRTOSIPConfig.h, build them in.
+ * Included, so that a test can be served without the server task, and the
+ * state can be looked at.  The module is the one of iperf3.c already. */
+#define logMODULE    eLogModuleIperf
+#include "FreeRTOS_IP.h"
+
+#undef USE_IPERF
+#define USE_IPERF    1
+
+#include "iperf3.c"
+
+/* Standard includes. */
+#include <stdarg.h>
+#include <stdio.h>
+
+#include "fake_kernel.h"
+#include "test.h"
+
+/*
+ * The peer replays the control exchange of a stock iperf3, as recorded with
+ * "iperf3 --debug": the messages are the ones that it sends, in the order
+ * that it sends them, each one in reply to a state or message of the board.
+ * Only the byte counts in the results are those of the run.  The data
+ * connections are modelled, not recorded: the peer delivers or takes a few
+ * segments per tick.
+ */
+
+#define testMAX_SOCKETS         16U
+#define testCONTROL_SIZE        4096U
+#define testMAX_DATAGRAMS       64U
+#define testMAX_STATES          32U
+#define testSEGMENTS_PER_TICK   2U
+
+/* The address of the workstation, 192.168.1.20, in network order. */
+#define testPEER_ADDRESS        FreeRTOS_inet_addr_quick( 192, 168, 1, 20 )
+#define testPEER_PORT           40001U
+
+typedef struct xTEST_DATAGRAM
+{
+    uint16_t usPort;   /* Of the sender, in network order. */
+    size_t uxLength;
+    uint8_t ucHeader[ iperf3UDP_HEADER_SIZE_64 ];
+} TestDatagram_t;
+
+/* A socket of the board, with the peer on the other side. */
+struct xSOCKET
+{
+    BaseType_t xUsed;
+    BaseType_t xUDP;
+    BaseType_t xShutdown;
+    TickType_t xReceiveTimeout;
+    WinProperties_t xWindows;
+    SemaphoreHandle_t xSemaphore; /* FREERTOS_SO_SET_SEMAPHORE */
+
+    /* For the board: control messages or a cookie, then uxData bytes of
+     * test data. */
+    uint8_t ucRx[ testCONTROL_SIZE ];
+    size_t uxRxHead;
+    size_t uxRxTail;
+    size_t uxData;
+
+    /* From the board, except the test data. */
+    uint8_t ucTx[ testCONTROL_SIZE ];
+    size_t uxTxLength;
+    size_t uxTxParsed;
+
+    /* UDP: datagrams for the board. */
+    TestDatagram_t xDatagrams[ testMAX_DATAGRAMS ];
+    size_t uxDatagramHead;
+    size_t uxDatagramCount;
+
+    /* Listening: connections that were not accepted yet. */
+    Socket_t xBacklog[ configIPERF3_MAX_STREAMS + 1U ];
+    size_t uxBacklog;
+};
+
+struct xSOCKET_SET
+{
+    int iUnused;
+};
+
+/* The stock iperf3 on the other side. */
+typedef struct xTEST_PEER
+{
+    BaseType_t xBoardIsServer;
+    const char * pcParams;        /* The client's parameters. */
+    const char * pcResults;       /* The peer's results, a format for the byte counts. */
+    UBaseType_t uxStreams;
+    BaseType_t xUDP;
+    BaseType_t xReverse;          /* The board sends. */
+    BaseType_t xStrayConnection;  /* A connection with another cookie comes first. */
+    uint32_t ulSeconds;
+
+    char cCookie[ iperf3COOKIE_SIZE ];
+    Socket_t xControl;
+    Socket_t xListen;
+    Socket_t xStreams[ configIPERF3_MAX_STREAMS ];
+    UBaseType_t uxConnected;
+
+    BaseType_t xRunning;
+    TickType_t xRunStart;
+    uint64_t ullDelivered[ configIPERF3_MAX_STREAMS ];
+    uint32_t ulDatagrams[ configIPERF3_MAX_STREAMS ];
+    uint8_t ucConnectReply[ configIPERF3_MAX_STREAMS ][ 4 ];
+
+    int8_t cStates[ testMAX_STATES ]; /* Sent by the board. */
+    size_t uxStates;
+    size_t uxUnit;                    /* Next unit of the board's control stream. */
+    char cBoardParams[ configIPERF3_JSON_SIZE ];
+    char cBoardResults[ configIPERF3_JSON_SIZE ];
+} TestPeer_t;
+
+/* A unit of the control stream of the board, in the order that they come. */
+typedef enum
+{
+    eUnitCookie,
+    eUnitState,
+    eUnitJSON
+} TestUnit_t;
+
+static struct xSOCKET xSockets[ testMAX_SOCKETS ];
+static struct xSOCKET_SET xSocketSet;
+static uint32_t ulOpenSockets = 0U;
+
+static TestPeer_t xPeer;
+
+static char cCongestionAsked[ 16 ];
+static uint32_t ulTxQueueAborts = 0U;
+static uint32_t ulRxBatchDetaches = 0U;
+
+/*
+ * Recorded parameters.  Since 3.9 the client sends "num" and "blockcount"
+ * also when they are 0.
+ */
+
+/* iperf3 -c <board> -t 1 -P 2, iperf3 3.9 */
+static const char cParamsTCP[] =
+    "{\"tcp\":true,\"omit\":0,\"time\":1,\"num\":0,\"blockcount\":0,\"parallel\":2,\"len\":131072,"
+    "\"pacing_timer\":1000,\"client_version\":\"3.9\"}";
+
+/* iperf3 -c <board> -t 1 -R -C vegas, iperf3 3.7 */
+static const char cParamsReverse[] =
+    "{\"tcp\":true,\"omit\":0,\"time\":1,\"parallel\":1,\"reverse\":true,\"len\":131072,"
+    "\"pacing_timer\":1000,\"congestion\":\"vegas\",\"client_version\":\"3.7\"}";
+
+/* iperf3 -c <board> -t 1 -u -b 10M -l 1000, iperf3 3.16 */
+static const char cParamsUDP[] =
+    "{\"udp\":true,\"omit\":0,\"time\":1,\"num\":0,\"blockcount\":0,\"parallel\":1,\"len\":1000,"
+    "\"bandwidth\":10000000,\"pacing_timer\":1000,\"client_version\":\"3.16\"}";
+
+/* iperf3 -c <board> -t 1 --bidir, iperf3 3.9 */
+static const char cParamsBidirectional[] =
+    "{\"tcp\":true,\"omit\":0,\"time\":1,\"num\":0,\"blockcount\":0,\"parallel\":1,\"bidirectional\":true,"
+    "\"len\":131072,\"pacing_timer\":1000,\"client_version\":\"3.9\"}";
+
+/* iperf3 -c <board> -n 1M, iperf3 3.9 */
+static const char cParamsBytes[] =
+    "{\"tcp\":true,\"omit\":0,\"time\":0,\"num\":1048576,\"blockcount\":0,\"parallel\":1,\"len\":131072,"
+    "\"pacing_timer\":1000,\"client_version\":\"3.9\"}";
+
+/*
+ * Recorded results, with the byte and packet counts left open.
+ */
+
+/* The client of cParamsTCP, which sent. */
+static const char cResultsTCP[] =
+    "{\"cpu_util_total\":1.2386838041335939,\"cpu_util_user\":0.086349137163773487,"
+    "\"cpu_util_system\":1.1523346669698205,\"sender_has_retransmits\":1,\"congestion_used\":\"cubic\","
+    "\"streams\":[{\"id\":1,\"bytes\":%llu,\"retransmits\":0,\"jitter\":0,\"errors\":0,\"packets\":0,"
+    "\"start_time\":0,\"end_time\":1.000154},{\"id\":3,\"bytes\":%llu,\"retransmits\":2,\"jitter\":0,"
+    "\"errors\":0,\"packets\":0,\"start_time\":0,\"end_time\":1.000161}]}";
+
+/* The client of cParamsReverse, which received. */
+static const char cResultsReverse[] =
+    "{\"cpu_util_total\":0.57102374138410442,\"cpu_util_user\":0,\"cpu_util_system\":0.57102374138410442,"
+    "\"sender_has_retransmits\":-1,\"congestion_used\":\"cubic\",\"streams\":[{\"id\":1,\"bytes\":%llu,"
+    "\"retransmits\":-1,\"jitter\":0,\"errors\":0,\"packets\":0,\"start_time\":0,\"end_time\":1.000887}]}";
+
+/* The client of cParamsUDP, which sent. */
+static const char cResultsUDP[] =
+    "{\"cpu_util_total\":0.41566128146357524,\"cpu_util_user\":0.10391532036589381,"
+    "\"cpu_util_system\":0.31174596109768144,\"sender_has_retransmits\":0,\"streams\":[{\"id\":1,"
+    "\"bytes\":%llu,\"retransmits\":0,\"jitter\":0,\"errors\":0,\"omitted_errors\":0,\"packets\":%u,"
+    "\"omitted_packets\":0,\"start_time\":0,\"end_time\":1.000051}]}";
+
+/* "iperf3 -s", 3.9, which received from the board. */
+static const char cResultsServer[] =
+    "{\"cpu_util_total\":0.92883749597802389,\"cpu_util_user\":0.035128983530203281,"
+    "\"cpu_util_system\":0.89370851244782063,\"sender_has_retransmits\":-1,\"congestion_used\":\"cubic\","
+    "\"streams\":[{\"id\":1,\"bytes\":%llu,\"retransmits\":-1,\"jitter\":0,\"errors\":0,\"packets\":0,"
+    "\"start_time\":0,\"end_time\":1.000416}]}";
+
+/*-----------------------------------------------------------*/
+
+/* The microsecond clock ticks with the kernel. */
+uint64_t ullUptimeMicroseconds( void )
+{
+    return ( uint64_t ) xTaskGetTickCount() * 1000ULL;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xEntropyPoolRandom( void * pvBuffer,
+                               size_t uxLength )
+{
+    uint8_t * pucBuffer = ( uint8_t * ) pvBuffer;
+    size_t x;
+
+    for( x = 0; x < uxLength; x++ )
+    {
+        pucBuffer[ x ] = ( uint8_t ) ( ( x * 7U ) + 3U );
+    }
+
+    return pdPASS;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xNetStatsBuffersAvailable( UBaseType_t uxNeeded )
+{
+    ( void ) uxNeeded;
+
+    return pdTRUE;
+}
+/*-----------------------------------------------------------*/
+
+/* The TX queue moves a few segments into the stream per call. */
+void vTCPTxQueueInit( TCPTxQueue_t * pxQueue,
+                      Socket_t xSocket )
+{
+    memset( pxQueue, 0, sizeof( *pxQueue ) );
+    pxQueue->xSocket = xSocket;
+}
+/*-----------------------------------------------------------*/
+
+void vTCPTxQueueSetCongestion( TCPTxQueue_t * pxQueue,
+                               TCPCongestion_t * pxCC )
+{
+    pxQueue->pxCongestion = pxCC;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xTCPTxQueueRegion( TCPTxQueue_t * pxQueue,
+                              TCPTxRegion_t * pxRegion )
+{
+    ( void ) pxQueue;
+    TEST_CHECK( pxRegion->uxLength > 0U );
+
+    return pdPASS;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xTCPTxQueueProcess( TCPTxQueue_t * pxQueue,
+                               TickType_t xBlockTime )
+{
+    TEST_CHECK_EQUAL( 0, xBlockTime );
+    pxQueue->ulStreamQueued += testSEGMENTS_PER_TICK * ipconfigTCP_MSS;
+
+    return 2;
+}
+/*-----------------------------------------------------------*/
+
+void vTCPTxQueueAbort( TCPTxQueue_t * pxQueue )
+{
+    pxQueue->xSocket = NULL;
+    ulTxQueueAborts++;
+}
+/*-----------------------------------------------------------*/
+
+const TCPCongestionOps_t xTCPCongestionReno = { .pcName = "reno" };
+
+void vTCPCongestionInit( TCPCongestion_t * pxCC,
+                         Socket_t xSocket,
+                         const TCPCongestionOps_t * pxOps )
+{
+    ( void ) pxCC;
+    ( void ) xSocket;
+    TEST_CHECK( pxOps == NULL );
+}
+/*-----------------------------------------------------------*/
+
+void vTCPCongestionDeinit( TCPCongestion_t * pxCC )
+{
+    ( void ) pxCC;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xTCPCongestionSetAlgorithm( TCPCongestion_t * pxCC,
+                                       const char * pcName )
+{
+    ( void ) pxCC;
+    ( void ) snprintf( cCongestionAsked, sizeof( cCongestionAsked ), "%s", pcName );
+
+    return ( ( strcmp( pcName, "reno" ) == 0 ) || ( strcmp( pcName, "vegas" ) == 0 ) ) ? pdPASS : pdFAIL;
+}
+/*-----------------------------------------------------------*/
+
+void vTCPCongestionGetStats( const TCPCongestion_t * pxCC,
+                             TCPCongestionStats_t * pxStats )
+{
+    ( void ) pxCC;
+    memset( pxStats, 0, sizeof( *pxStats ) );
+    pxStats->pcAlgorithm = ( cCongestionAsked[ 0 ] != '\0' ) ? cCongestionAsked : "reno";
+}
+/*-----------------------------------------------------------*/
+
+/* A batch reads whatever is waiting. */
+BaseType_t xTCPRxBatchInit( TCPRxBatch_t * pxBatch,
+                            Socket_t xSocket,
+                            SemaphoreHandle_t xWakeUp,
+                            size_t uxThreshold )
+{
+    memset( pxBatch, 0, sizeof( *pxBatch ) );
+    pxBatch->xSocket = xSocket;
+    pxBatch->xWakeUp = xWakeUp;
+    pxBatch->uxThreshold = uxThreshold;
+
+    return pdPASS;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xTCPRxBatchReceive( TCPRxBatch_t * pxBatch,
+                               void * pvBuffer,
+                               size_t uxBufferLength )
+{
+    BaseType_t xResult = FreeRTOS_recv( pxBatch->xSocket, pvBuffer, uxBufferLength, FREERTOS_MSG_DONTWAIT );
+
+    if( xResult > 0 )
+    {
+        pxBatch->ulReads++;
+        pxBatch->ulBytes += ( uint32_t ) xResult;
+    }
+
+    return ( xResult == -pdFREERTOS_ERRNO_EWOULDBLOCK ) ? 0 : xResult;
+}
+/*-----------------------------------------------------------*/
+
+void vTCPRxBatchDetach( TCPRxBatch_t * pxBatch )
+{
+    pxBatch->xSocket = NULL;
+    ulRxBatchDetaches++;
+}
+/*-----------------------------------------------------------*/
+
+/* Bytes for the board, as the peer writes them. */
+static void prvPush( Socket_t xSocket,
+                     const void * pvData,
+                     size_t uxLength )
+{
+    TEST_CHECK( ( xSocket->uxRxTail + uxLength ) <= sizeof( xSocket->ucRx ) );
+    memcpy( &( xSocket->ucRx[ xSocket->uxRxTail ] ), pvData, uxLength );
+    xSocket->uxRxTail += uxLength;
+
+    if( xSocket->xSemaphore != NULL )
+    {
+        ( void ) xSemaphoreGive( xSocket->xSemaphore );
+    }
+}
+/*-----------------------------------------------------------*/
+
+static void prvPushState( int8_t cState )
+{
+    prvPush( xPeer.xControl, &cState, sizeof( cState ) );
+}
+/*-----------------------------------------------------------*/
+
+/* A JSON message: the length in network order, then the text. */
+static void prvPushJSON( const char * pcFormat,
+                         ... )
+{
+    char cText[ configIPERF3_JSON_SIZE ];
+    uint32_t ulLength;
+    va_list xArgs;
+
+    va_start( xArgs, pcFormat );
+    ( void ) vsnprintf( cText, sizeof( cText ), pcFormat, xArgs );
+    va_end( xArgs );
+
+    ulLength = FreeRTOS_htonl( ( uint32_t ) strlen( cText ) );
+    prvPush( xPeer.xControl, &ulLength, sizeof( ulLength ) );
+    prvPush( xPeer.xControl, cText, strlen( cText ) );
+}
+/*-----------------------------------------------------------*/
+
+static uint64_t prvDeliveredTotal( void )
+{
+    uint64_t ullTotal = 0U;
+    UBaseType_t x;
+
+    for( x = 0U; x < xPeer.uxStreams; x++ )
+    {
+        ullTotal += xPeer.ullDelivered[ x ];
+    }
+
+    return ullTotal;
+}
+/*-----------------------------------------------------------*/
+
+/* The board's test data, as the peer counted it. */
+static uint64_t prvBoardSent( UBaseType_t uxStream )
+{
+    return xTest.xStreams[ uxStream ].xTxQueue.ulStreamQueued;
+}
+/*-----------------------------------------------------------*/
+
+/* iperf3 -c: what it sends when the board, as the server, is in cState. */
+static void prvClientReact( int8_t cState )
+{
+    static const char cStray[ iperf3COOKIE_SIZE ] = "a cookie of a test that is not this";
+    Socket_t xConnection;
+    TestDatagram_t * pxDatagram;
+    uint8_t ucConnect[ 4 ] = { 0x39U, 0x38U, 0x37U, 0x36U }; /* UDP_CONNECT_MSG, written by x86. */
+    UBaseType_t x;
+
+    switch( cState )
+    {
+        case iperf3PARAM_EXCHANGE:
+            prvPushJSON( "%s", xPeer.pcParams );
+            break;
+
+        case iperf3CREATE_STREAMS:
+
+            if( xPeer.xUDP != pdFALSE )
+            {
+                for( x = 0U; x < xPeer.uxStreams; x++ )
+                {
+                    TEST_CHECK( xTest.xUDPSocket != NULL );
+                    pxDatagram = &( xTest.xUDPSocket->xDatagrams[ xTest.xUDPSocket->uxDatagramCount ] );
+                    pxDatagram->usPort = FreeRTOS_htons( testPEER_PORT + x );
+                    pxDatagram->uxLength = sizeof( ucConnect );
+                    memcpy( pxDatagram->ucHeader, ucConnect, sizeof( ucConnect ) );
+                    xTest.xUDPSocket->uxDatagramCount++;
+                }
+            }
+            else
+            {
+                if( xPeer.xStrayConnection != pdFALSE )
+                {
+                    xConnection = FreeRTOS_socket( FREERTOS_AF_INET, FREERTOS_SOCK_STREAM, FREERTOS_IPPROTO_TCP );
+                    prvPush( xConnection, cStray, sizeof( cStray ) );
+                    xPeer.xListen->xBacklog[ xPeer.xListen->uxBacklog++ ] = xConnection;
+                }
+
+                for( x = 0U; x < xPeer.uxStreams; x++ )
+                {
+                    xConnection = FreeRTOS_socket( FREERTOS_AF_INET, FREERTOS_SOCK_STREAM, FREERTOS_IPPROTO_TCP );
+                    prvPush( xConnection, xPeer.cCookie, iperf3COOKIE_SIZE );
+                    xPeer.xListen->xBacklog[ xPeer.xListen->uxBacklog++ ] = xConnection;
+                    xPeer.xStreams[ x ] = xConnection;
+                }
+            }
+
+            break;
+
+        case iperf3TEST_RUNNING:
+            xPeer.xRunning = pdTRUE;
+            xPeer.xRunStart = xTaskGetTickCount();
+            break;
+
+        case iperf3EXCHANGE_RESULTS:
+
+            if( xPeer.xUDP != pdFALSE )
+            {
+                prvPushJSON( xPeer.pcResults, ( unsigned long long ) prvDeliveredTotal(), ( unsigned ) xPeer.ulDatagrams[ 0 ] );
+            }
+            else if( xPeer.xReverse != pdFALSE )
+            {
+                prvPushJSON( xPeer.pcResults, ( unsigned long long ) prvBoardSent( 0U ) );
+            }
+            else
+            {
+                prvPushJSON( xPeer.pcResults, ( unsigned long long ) xPeer.ullDelivered[ 0 ], ( unsigned long long ) xPeer.ullDelivered[ 1 ] );
+            }
+
+            break;
+
+        case iperf3DISPLAY_RESULTS:
+            prvPushState( iperf3IPERF_DONE );
+            break;
+
+        default:
+            /* TEST_START, ACCESS_DENIED: nothing to say. */
+            break;
+    }
+}
+/*-----------------------------------------------------------*/
+
+/* iperf3 -s: what it sends after the board, as the client, sent a unit. */
+static void prvServerReact( TestUnit_t eUnit,
+                            int8_t cState )
+{
+    if( eUnit == eUnitCookie )
+    {
+        prvPushState( iperf3PARAM_EXCHANGE );
+    }
+    else if( ( eUnit == eUnitJSON ) && ( xPeer.cBoardResults[ 0 ] == '\0' ) )
+    {
+        /* The parameters. */
+        prvPushState( iperf3CREATE_STREAMS );
+    }
+    else if( eUnit == eUnitJSON )
+    {
+        /* The client's results come first. */
+        prvPushJSON( xPeer.pcResults, ( unsigned long long ) prvBoardSent( 0U ) );
+        prvPushState( iperf3DISPLAY_RESULTS );
+    }
+    else if( cState == iperf3TEST_END )
+    {
+        xPeer.xRunning = pdFALSE;
+        prvPushState( iperf3EXCHANGE_RESULTS );
+    }
+    else
+    {
+        /* IPERF_DONE */
+    }
+}
+/*-----------------------------------------------------------*/
+
+/* Take the complete units that the board wrote to the control connection,
+ * and let the peer answer them. */
+static void prvPeerRead( void )
+{
+    Socket_t xControl = xPeer.xControl;
+    const uint8_t * pucNext;
+    size_t uxWaiting;
+    uint32_t ulLength;
+    TestUnit_t eUnit;
+    char * pcJSON;
+
+    for( ; ; )
+    {
+        pucNext = &( xControl->ucTx[ xControl->uxTxParsed ] );
+        uxWaiting = xControl->uxTxLength - xControl->uxTxParsed;
+
+        /* The board as a client starts with its cookie, and sends its
+         * parameters next.  Either side sends its results after
+         * EXCHANGE_RESULTS. */
+        if( ( xPeer.xBoardIsServer == pdFALSE ) && ( xPeer.uxUnit == 0U ) )
+        {
+            eUnit = eUnitCookie;
+        }
+        else if( ( xPeer.xBoardIsServer == pdFALSE ) && ( xPeer.uxUnit == 1U ) )
+        {
+            eUnit = eUnitJSON;
+        }
+        else if( ( xPeer.uxStates > 0U ) && ( xPeer.cStates[ xPeer.uxStates - 1U ] == iperf3EXCHANGE_RESULTS ) &&
+                 ( xPeer.xBoardIsServer != pdFALSE ) && ( xPeer.cBoardResults[ 0 ] == '\0' ) )
+        {
+            eUnit = eUnitJSON;
+        }
+        else if( ( xPeer.uxStates > 0U ) && ( xPeer.cStates[ xPeer.uxStates - 1U ] == iperf3TEST_END ) &&
+                 ( xPeer.xBoardIsServer == pdFALSE ) && ( xPeer.cBoardResults[ 0 ] == '\0' ) )
+        {
+            eUnit = eUnitJSON;
+        }
+        else
+        {
+            eUnit = eUnitState;
+        }
+
+        if( eUnit == eUnitCookie )
+        {
+            if( uxWaiting < iperf3COOKIE_SIZE )
+            {
+                break;
+            }
+
+            memcpy( xPeer.cCookie, pucNext, iperf3COOKIE_SIZE );
+            xControl->uxTxParsed += iperf3COOKIE_SIZE;
+            prvServerReact( eUnit, 0 );
+        }
+        else if( eUnit == eUnitJSON )
+        {
+            if( uxWaiting < sizeof( ulLength ) )
+            {
+                break;
+            }
+
+            memcpy( &ulLength, pucNext, sizeof( ulLength ) );
+            ulLength = FreeRTOS_ntohl( ulLength );
+            TEST_CHECK( ulLength < configIPERF3_JSON_SIZE );
+
+            if( uxWaiting < ( sizeof( ulLength ) + ulLength ) )
+            {
+                break;
+            }
+
+            pcJSON = ( ( xPeer.uxUnit == 1U ) && ( xPeer.xBoardIsServer == pdFALSE ) ) ? xPeer.cBoardParams : xPeer.cBoardResults;
+            memcpy( pcJSON, &( pucNext[ sizeof( ulLength ) ] ), ulLength );
+            pcJSON[ ulLength ] = '\0';
+            xControl->uxTxParsed += sizeof( ulLength ) + ulLength;
+
+            if( xPeer.xBoardIsServer == pdFALSE )
+            {
+                prvServerReact( eUnit, 0 );
+            }
+        }
+        else
+        {
+            if( uxWaiting < 1U )
+            {
+                break;
+            }
+
+            TEST_CHECK( xPeer.uxStates < testMAX_STATES );
+            xPeer.cStates[ xPeer.uxStates++ ] = ( int8_t ) pucNext[ 0 ];
+            xControl->uxTxParsed++;
+
+            if( xPeer.xBoardIsServer != pdFALSE )
+            {
+                prvClientReact( ( int8_t ) pucNext[ 0 ] );
+            }
+            else
+            {
+                prvServerReact( eUnit, ( int8_t ) pucNext[ 0 ] );
+            }
+        }
+
+        xPeer.uxUnit++;
+    }
+}
+/*-----------------------------------------------------------*/
+
+/* The peer's side of the data connections, one tick at a time. */
+static void prvPeerTick( void )
+{
+    TickType_t xElapsed = xTaskGetTickCount() - xPeer.xRunStart;
+    TestDatagram_t * pxDatagram;
+    Socket_t xUDPSocket = xTest.xUDPSocket;
+    uint32_t ulCount;
+    uint32_t ulTransitUs;
+    uint32_t ulSentUs;
+    UBaseType_t x;
+
+    if( xPeer.xRunning == pdFALSE )
+    {
+        return;
+    }
+
+    if( ( xPeer.xBoardIsServer != pdFALSE ) && ( xElapsed >= pdMS_TO_TICKS( xPeer.ulSeconds * 1000U ) ) )
+    {
+        /* The client ends the test. */
+        xPeer.xRunning = pdFALSE;
+        prvPushState( iperf3TEST_END );
+        return;
+    }
+
+    if( xPeer.xReverse != pdFALSE )
+    {
+        /* The board sends, see xTCPTxQueueProcess(). */
+    }
+    else if( xPeer.xUDP != pdFALSE )
+    {
+        /* One datagram per stream per tick.  Datagrams 100 to 102 are lost,
+         * 201 overtakes 200, and the transit time alternates between 200
+         * and 600 us. */
+        for( x = 0U; x < xPeer.uxStreams; x++ )
+        {
+            xPeer.ulDatagrams[ x ]++;
+            ulCount = xPeer.ulDatagrams[ x ];
+
+            if( ( ulCount >= 100U ) && ( ulCount <= 102U ) )
+            {
+                continue;
+            }
+
+            ulCount = ( ulCount == 200U ) ? 201U : ( ( ulCount == 201U ) ? 200U : ulCount );
+            ulTransitUs = ( ( ulCount % 2U ) == 0U ) ? 200U : 600U;
+            ulSentUs = ( xTaskGetTickCount() * 1000U ) - ulTransitUs;
+
+            TEST_CHECK( xUDPSocket->uxDatagramCount < testMAX_DATAGRAMS );
+            pxDatagram = &( xUDPSocket->xDatagrams[ ( xUDPSocket->uxDatagramHead + xUDPSocket->uxDatagramCount ) % testMAX_DATAGRAMS ] );
+            xUDPSocket->uxDatagramCount++;
+
+            pxDatagram->usPort = FreeRTOS_htons( testPEER_PORT + x );
+            pxDatagram->uxLength = xTest.xParams.uxLength;
+            *( ( uint32_t * ) &( pxDatagram->ucHeader[ 0 ] ) ) = FreeRTOS_htonl( ulSentUs / 1000000U );
+            *( ( uint32_t * ) &( pxDatagram->ucHeader[ 4 ] ) ) = FreeRTOS_htonl( ulSentUs % 1000000U );
+            *( ( uint32_t * ) &( pxDatagram->ucHeader[ 8 ] ) ) = FreeRTOS_htonl( ulCount );
+            xPeer.ullDelivered[ x ] += pxDatagram->uxLength;
+        }
+    }
+    else if( xPeer.xBoardIsServer != pdFALSE )
+    {
+        /* TCP: the client sends a few segments per tick on every stream. */
+        for( x = 0U; x < xPeer.uxStreams; x++ )
+        {
+            xPeer.xStreams[ x ]->uxData += ( x + 1U ) * testSEGMENTS_PER_TICK * ipconfigTCP_MSS;
+            xPeer.ullDelivered[ x ] += ( x + 1U ) * testSEGMENTS_PER_TICK * ipconfigTCP_MSS;
+
+            if( xTest.xWakeUp != NULL )
+            {
+                ( void ) xSemaphoreGive( xTest.xWakeUp );
+            }
+        }
+    }
+    else
+    {
+        /* The board sends. */
+    }
+}
+/*-----------------------------------------------------------*/
+
+Socket_t FreeRTOS_socket( BaseType_t xDomain,
+                          BaseType_t xType,
+                          BaseType_t xProtocol )
+{
+    Socket_t xSocket = NULL;
+    size_t x;
+
+    TEST_CHECK_EQUAL( FREERTOS_AF_INET, xDomain );
+    TEST_CHECK_EQUAL( ( xType == FREERTOS_SOCK_DGRAM ) ? FREERTOS_IPPROTO_UDP : FREERTOS_IPPROTO_TCP, xProtocol );
+
+    for( x = 0; x < testMAX_SOCKETS; x++ )
+    {
+        if( xSockets[ x ].xUsed == pdFALSE )
+        {
+            xSocket = &( xSockets[ x ] );
+            break;
+        }
+    }
+
+    TEST_CHECK( xSocket != NULL );
+    memset( xSocket, 0, sizeof( *xSocket ) );
+    xSocket->xUsed = pdTRUE;
+    xSocket->xUDP = ( xType == FREERTOS_SOCK_DGRAM ) ? pdTRUE : pdFALSE;
+    xSocket->xReceiveTimeout = portMAX_DELAY;
+    ulOpenSockets++;
+
+    return xSocket;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t FreeRTOS_setsockopt( Socket_t xSocket,
+                                int32_t lLevel,
+                                int32_t lOptionName,
+                                const void * pvOptionValue,
+                                size_t uxOptionLength )
+{
+    ( void ) lLevel;
+    ( void ) uxOptionLength;
+
+    switch( lOptionName )
+    {
+        case FREERTOS_SO_RCVTIMEO:
+            xSocket->xReceiveTimeout = *( ( const TickType_t * ) pvOptionValue );
+            break;
+
+        case FREERTOS_SO_WIN_PROPERTIES:
+            memcpy( &( xSocket->xWindows ), pvOptionValue, sizeof( xSocket->xWindows ) );
+            break;
+
+        case FREERTOS_SO_SET_SEMAPHORE:
+            xSocket->xSemaphore = ( pvOptionValue != NULL ) ? *( ( SemaphoreHandle_t const * ) pvOptionValue ) : NULL;
+            break;
+
+        default:
+            /* FREERTOS_SO_SNDTIMEO: sending never blocks here. */
+            break;
+    }
+
+    return 0;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t FreeRTOS_bind( Socket_t xSocket,
+                          struct freertos_sockaddr const * pxAddress,
+                          uint32_t xAddressLength )
+{
+    ( void ) xSocket;
+    ( void ) xAddressLength;
+
+    if( pxAddress != NULL )
+    {
+        TEST_CHECK_EQUAL( configIPERF3_PORT, FreeRTOS_ntohs( pxAddress->sin_port ) );
+    }
+
+    return 0;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t FreeRTOS_listen( Socket_t xSocket,
+                            BaseType_t xBacklog )
+{
+    ( void ) xSocket;
+    TEST_CHECK( xBacklog > ( BaseType_t ) configIPERF3_MAX_STREAMS );
+
+    return 0;
+}
+/*-----------------------------------------------------------*/
+
+Socket_t FreeRTOS_accept( Socket_t xServerSocket,
+                          struct freertos_sockaddr * pxAddress,
+                          uint32_t * pxAddressLength )
+{
+    Socket_t xSocket = NULL;
+    TickType_t xWaited = 0U;
+
+    ( void ) pxAddressLength;
+
+    while( ( xServerSocket->uxBacklog == 0U ) && ( xWaited < xServerSocket->xReceiveTimeout ) )
+    {
+        vFakeKernelAdvance( 1U );
+        xWaited++;
+    }
+
+    if( xServerSocket->uxBacklog > 0U )
+    {
+        xSocket = xServerSocket->xBacklog[ 0 ];
+        xServerSocket->uxBacklog--;
+        memmove( &( xServerSocket->xBacklog[ 0 ] ), &( xServerSocket->xBacklog[ 1 ] ), xServerSocket->uxBacklog * sizeof( Socket_t ) );
+
+        /* A connection inherits the windows of the listening socket. */
+        xSocket->xWindows = xServerSocket->xWindows;
+
+        memset( pxAddress, 0, sizeof( *pxAddress ) );
+        pxAddress->sin_family = FREERTOS_AF_INET;
+        pxAddress->sin_address.ulIP_IPv4 = testPEER_ADDRESS;
+    }
+
+    return xSocket;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t FreeRTOS_connect( Socket_t xClientSocket,
+                             const struct freertos_sockaddr * pxAddress,
+                             uint32_t xAddressLength )
+{
+    ( void ) xAddressLength;
+    TEST_CHECK_EQUAL( configIPERF3_PORT, FreeRTOS_ntohs( pxAddress->sin_port ) );
+    TEST_CHECK_EQUAL( testPEER_ADDRESS, pxAddress->sin_address.ulIP_IPv4 );
+
+    if( xPeer.xControl == NULL )
+    {
+        xPeer.xControl = xClientSocket;
+    }
+    else
+    {
+        TEST_CHECK( xPeer.uxConnected < xPeer.uxStreams );
+        xPeer.xStreams[ xPeer.uxConnected++ ] = xClientSocket;
+    }
+
+    return 0;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t FreeRTOS_send( Socket_t xSocket,
+                          const void * pvBuffer,
+                          size_t uxDataLength,
+                          BaseType_t xFlags )
+{
+    UBaseType_t x;
+    BaseType_t xAllCookies = pdTRUE;
+
+    ( void ) xFlags;
+
+    if( xSocket->xShutdown != pdFALSE )
+    {
+        return -pdFREERTOS_ERRNO_ENOTCONN;
+    }
+
+    TEST_CHECK( ( xSocket->uxTxLength + uxDataLength ) <= sizeof( xSocket->ucTx ) );
+    memcpy( &( xSocket->ucTx[ xSocket->uxTxLength ] ), pvBuffer, uxDataLength );
+    xSocket->uxTxLength += uxDataLength;
+
+    if( xSocket == xPeer.xControl )
+    {
+        prvPeerRead();
+    }
+    else if( ( xPeer.xBoardIsServer == pdFALSE ) && ( xPeer.xRunning == pdFALSE ) )
+    {
+        /* A cookie on a data connection.  The test starts when all streams
+         * are there. */
+        for( x = 0U; x < xPeer.uxStreams; x++ )
+        {
+            if( ( x >= xPeer.uxConnected ) || ( xPeer.xStreams[ x ]->uxTxLength < iperf3COOKIE_SIZE ) )
+            {
+                xAllCookies = pdFALSE;
+            }
+            else
+            {
+                TEST_CHECK( memcmp( xPeer.xStreams[ x ]->ucTx, xPeer.cCookie, iperf3COOKIE_SIZE ) == 0 );
+            }
+        }
+
+        if( xAllCookies != pdFALSE )
+        {
+            prvPushState( iperf3TEST_START );
+            prvPushState( iperf3TEST_RUNNING );
+            xPeer.xRunning = pdTRUE;
+            xPeer.xRunStart = xTaskGetTickCount();
+        }
+    }
+    else
+    {
+        /* Test data goes through the TX queue. */
+        TEST_CHECK( 0 );
+    }
+
+    return ( BaseType_t ) uxDataLength;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t FreeRTOS_recv( Socket_t xSocket,
+                          void * pvBuffer,
+                          size_t uxBufferLength,
+                          BaseType_t xFlags )
+{
+    TickType_t xWaited = 0U;
+    size_t uxCount;
+
+    while( ( xSocket->uxRxHead == xSocket->uxRxTail ) && ( xSocket->uxData == 0U ) &&
+           ( xSocket->xShutdown == pdFALSE ) && ( ( xFlags & FREERTOS_MSG_DONTWAIT ) == 0 ) &&
+           ( xWaited < xSocket->xReceiveTimeout ) )
+    {
+        vFakeKernelAdvance( 1U );
+        xWaited++;
+    }
+
+    if( xSocket->uxRxHead != xSocket->uxRxTail )
+    {
+        uxCount = xSocket->uxRxTail - xSocket->uxRxHead;
+        uxCount = ( uxCount < uxBufferLength ) ? uxCount : uxBufferLength;
+        memcpy( pvBuffer, &( xSocket->ucRx[ xSocket->uxRxHead ] ), uxCount );
+        xSocket->uxRxHead += uxCount;
+    }
+    else if( xSocket->uxData > 0U )
+    {
+        uxCount = ( xSocket->uxData < uxBufferLength ) ? xSocket->uxData : uxBufferLength;
+        memset( pvBuffer, 0, uxCount );
+        xSocket->uxData -= uxCount;
+    }
+    else
+    {
+        return ( xSocket->xShutdown != pdFALSE ) ? -pdFREERTOS_ERRNO_ENOTCONN : -pdFREERTOS_ERRNO_EWOULDBLOCK;
+    }
+
+    return ( BaseType_t ) uxCount;
+}
+/*-----------------------------------------------------------*/
+
+int32_t FreeRTOS_sendto( Socket_t xSocket,
+                         const void * pvBuffer,
+                         size_t uxTotalDataLength,
+                         BaseType_t xFlags,
+                         const struct freertos_sockaddr * pxDestinationAddress,
+                         uint32_t xDestinationAddressLength )
+{
+    UBaseType_t uxStream = FreeRTOS_ntohs( pxDestinationAddress->sin_port ) - testPEER_PORT;
+
+    ( void ) xFlags;
+    ( void ) xDestinationAddressLength;
+
+    /* Only the replies to the connect messages of the streams. */
+    TEST_CHECK( xSocket->xUDP != pdFALSE );
+    TEST_CHECK_EQUAL( 4, uxTotalDataLength );
+    TEST_CHECK( uxStream < configIPERF3_MAX_STREAMS );
+    TEST_CHECK_EQUAL( testPEER_ADDRESS, pxDestinationAddress->sin_address.ulIP_IPv4 );
+    memcpy( xPeer.ucConnectReply[ uxStream ], pvBuffer, 4U );
+
+    return ( int32_t ) uxTotalDataLength;
+}
+/*-----------------------------------------------------------*/
+
+int32_t FreeRTOS_recvfrom( Socket_t xSocket,
+                           void * pvBuffer,
+                           size_t uxBufferLength,
+                           BaseType_t xFlags,
+                           struct freertos_sockaddr * pxSourceAddress,
+                           uint32_t * pxSourceAddressLength )
+{
+    TickType_t xWaited = 0U;
+    TestDatagram_t * pxDatagram;
+    size_t uxCount;
+
+    ( void ) pxSourceAddressLength;
+
+    while( ( xSocket->uxDatagramCount == 0U ) && ( ( xFlags & FREERTOS_MSG_DONTWAIT ) == 0 ) &&
+           ( xWaited < xSocket->xReceiveTimeout ) )
+    {
+        vFakeKernelAdvance( 1U );
+        xWaited++;
+    }
+
+    if( xSocket->uxDatagramCount == 0U )
+    {
+        return -pdFREERTOS_ERRNO_EWOULDBLOCK;
+    }
+
+    pxDatagram = &( xSocket->xDatagrams[ xSocket->uxDatagramHead ] );
+    xSocket->uxDatagramHead = ( xSocket->uxDatagramHead + 1U ) % testMAX_DATAGRAMS;
+    xSocket->uxDatagramCount--;
+
+    uxCount = ( pxDatagram->uxLength < uxBufferLength ) ? pxDatagram->uxLength : uxBufferLength;
+    memset( pvBuffer, 0, uxCount );
+    memcpy( pvBuffer, pxDatagram->ucHeader, ( uxCount < sizeof( pxDatagram->ucHeader ) ) ? uxCount : sizeof( pxDatagram->ucHeader ) );
+
+    memset( pxSourceAddress, 0, sizeof( *pxSourceAddress ) );
+    pxSourceAddress->sin_family = FREERTOS_AF_INET;
+    pxSourceAddress->sin_port = pxDatagram->usPort;
+    pxSourceAddress->sin_address.ulIP_IPv4 = testPEER_ADDRESS;
+
+    return ( int32_t ) uxCount;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t FreeRTOS_shutdown( Socket_t xSocket,
+                              BaseType_t xHow )
+{
+    TEST_CHECK_EQUAL( FREERTOS_SHUT_RDWR, xHow );
+    xSocket->xShutdown = pdTRUE;
+
+    return 0;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t FreeRTOS_closesocket( Socket_t xSocket )
+{
+    TEST_CHECK( xSocket->xUsed != pdFALSE );
+    xSocket->xUsed = pdFALSE;
+    ulOpenSockets--;
+
+    return 1;
+}
+/*-----------------------------------------------------------*/
+
+SocketSet_t FreeRTOS_CreateSocketSet( void )
+{
+    return &xSocketSet;
+}
+/*-----------------------------------------------------------*/
+
+void FreeRTOS_DeleteSocketSet( SocketSet_t xSocketSet )
+{
+    ( void ) xSocketSet;
+}
+/*-----------------------------------------------------------*/
+
+void FreeRTOS_FD_SET( Socket_t xSocket,
+                      SocketSet_t xSocketSet,
+                      BaseType_t xBitsToSet )
+{
+    ( void ) xSocket;
+    ( void ) xSocketSet;
+    ( void ) xBitsToSet;
+}
+/*-----------------------------------------------------------*/
+
+/* There is something to do every tick. */
+BaseType_t FreeRTOS_select( SocketSet_t xSocketSet,
+                            TickType_t xBlockTimeTicks )
+{
+    ( void ) xSocketSet;
+    TEST_CHECK( xBlockTimeTicks > 0U );
+    vFakeKernelAdvance( 1U );
+
+    return 1;
+}
+/*-----------------------------------------------------------*/
+
+static void prvSetUp( void )
+{
+    vFakeKernelReset();
+    vFakeKernelSetTickHook( prvPeerTick );
+
+    memset( xSockets, 0, sizeof( xSockets ) );
+    ulOpenSockets = 0U;
+    memset( &xPeer, 0, sizeof( xPeer ) );
+    cCongestionAsked[ 0 ] = '\0';
+    ulTxQueueAborts = 0U;
+    ulRxBatchDetaches = 0U;
+
+    /* The state of iperf3.c. */
+    memset( &xTest, 0, sizeof( xTest ) );
+    xTestRunning = pdFALSE;
+}
+/*-----------------------------------------------------------*/
+
+/* Serve one test, as prvServerTask() does for each control connection. */
+static BaseType_t prvServe( void )
+{
+    BaseType_t xReturn;
+    Socket_t xControl;
+
+    xPeer.xBoardIsServer = pdTRUE;
+    xPeer.ulSeconds = 1U;
+    ( void ) snprintf( xPeer.cCookie, sizeof( xPeer.cCookie ), "%s", "nduzdaywrjo7tdmbxtn5wxhdlvcquhoalpwn" );
+
+    xPeer.xListen = FreeRTOS_socket( FREERTOS_AF_INET, FREERTOS_SOCK_STREAM, FREERTOS_IPPROTO_TCP );
+    prvSetTimeouts( xPeer.xListen );
+
+    /* The client connects and sends its cookie. */
+    xControl = FreeRTOS_socket( FREERTOS_AF_INET, FREERTOS_SOCK_STREAM, FREERTOS_IPPROTO_TCP );
+    xPeer.xControl = xControl;
+    prvPush( xControl, xPeer.cCookie, iperf3COOKIE_SIZE );
+    prvSetTimeouts( xControl );
+
+    TEST_CHECK_EQUAL( pdPASS, prvClaim() );
+    xTest.xIsServer = pdTRUE;
+    xTest.xControl = xControl;
+    xReturn = prvServeTest( xPeer.xListen );
+    prvCloseStreams();
+    prvRelease();
+    prvCloseSocket( xControl );
+
+    /* Only the listening socket is left. */
+    TEST_CHECK_EQUAL( 1, ulOpenSockets );
+
+    return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+static void prvCheckStates( const int8_t * pcExpected,
+                            size_t uxCount )
+{
+    size_t x;
+
+    TEST_CHECK_EQUAL( uxCount, xPeer.uxStates );
+
+    for( x = 0; x < uxCount; x++ )
+    {
+        TEST_CHECK_EQUAL( pcExpected[ x ], xPeer.cStates[ x ] );
+    }
+}
+/*-----------------------------------------------------------*/
+
+static void test_server_tcp( void )
+{
+    static const int8_t cExpected[] =
+    {
+        iperf3PARAM_EXCHANGE, iperf3CREATE_STREAMS, iperf3TEST_START, iperf3TEST_RUNNING,
+        iperf3EXCHANGE_RESULTS, iperf3DISPLAY_RESULTS
+    };
+    char cResults[ configIPERF3_JSON_SIZE ];
+    uint32_t ulEndUs;
+
+    prvSetUp();
+    xPeer.pcParams = cParamsTCP;
+    xPeer.pcResults = cResultsTCP;
+    xPeer.uxStreams = 2U;
+    xPeer.xStrayConnection = pdTRUE;
+
+    TEST_CHECK_EQUAL( pdPASS, prvServe() );
+    prvCheckStates( cExpected, sizeof( cExpected ) );
+
+    /* The parameters, as understood. */
+    TEST_CHECK_EQUAL( pdFALSE, xTest.xParams.xUDP );
+    TEST_CHECK_EQUAL( pdFALSE, xTest.xParams.xReverse );
+    TEST_CHECK_EQUAL( pdFALSE, xTest.xIsSender );
+    TEST_CHECK_EQUAL( 2, xTest.xParams.uxParallel );
+    TEST_CHECK_EQUAL( 1, xTest.xParams.ulTimeSeconds );
+    TEST_CHECK_EQUAL( 131072, xTest.xParams.uxLength );
+
+    /* The data connections were accepted with the receiver's windows, the
+     * one with a wrong cookie was not. */
+    TEST_CHECK_EQUAL( ( ( 24 * ipconfigTCP_MSS ) / 2 ), xPeer.xListen->xWindows.lRxBufSize );
+    TEST_CHECK_EQUAL( ipconfigIPERF_RX_WINSIZE / 2, xPeer.xListen->xWindows.lRxWinSize );
+    TEST_CHECK_EQUAL( 2 * ipconfigTCP_MSS, xPeer.xListen->xWindows.lTxBufSize );
+    TEST_CHECK_EQUAL( 2, ulRxBatchDetaches );
+
+    /* All that the client sent was counted, under iperf3's stream IDs. */
+    TEST_CHECK( xPeer.ullDelivered[ 0 ] > 0U );
+    ulEndUs = pdTICKS_TO_MS( xTest.xEndTime - xTest.xStartTime ) * 1000U;
+    ( void ) snprintf( cResults, sizeof( cResults ),
+                       "{\"cpu_util_total\":0,\"cpu_util_user\":0,\"cpu_util_system\":0,\"sender_has_retransmits\":0,\"streams\":["
+                       "{\"id\":1,\"bytes\":%llu,\"retransmits\":0,\"jitter\":0.000000,\"errors\":0,\"packets\":0,\"start_time\":0,\"end_time\":%u.%06u},"
+                       "{\"id\":3,\"bytes\":%llu,\"retransmits\":0,\"jitter\":0.000000,\"errors\":0,\"packets\":0,\"start_time\":0,\"end_time\":%u.%06u}]}",
+                       ( unsigned long long ) xPeer.ullDelivered[ 0 ], ( unsigned ) ( ulEndUs / 1000000U ), ( unsigned ) ( ulEndUs % 1000000U ),
+                       ( unsigned long long ) xPeer.ullDelivered[ 1 ], ( unsigned ) ( ulEndUs / 1000000U ), ( unsigned ) ( ulEndUs % 1000000U ) );
+    TEST_CHECK( strcmp( cResults, xPeer.cBoardResults ) == 0 );
+    TEST_CHECK( ( ulEndUs >= 1000000U ) && ( ulEndUs <= 1002000U ) );
+
+    /* And what the client said it sent. */
+    TEST_CHECK_EQUAL( prvDeliveredTotal(), xTest.ullPeerBytes );
+}
+/*-----------------------------------------------------------*/
+
+static void test_server_reverse( void )
+{
+    static const int8_t cExpected[] =
+    {
+        iperf3PARAM_EXCHANGE, iperf3CREATE_STREAMS, iperf3TEST_START, iperf3TEST_RUNNING,
+        iperf3EXCHANGE_RESULTS, iperf3DISPLAY_RESULTS
+    };
+    uint64_t ullSent;
+
+    prvSetUp();
+    xPeer.pcParams = cParamsReverse;
+    xPeer.pcResults = cResultsReverse;
+    xPeer.uxStreams = 1U;
+    xPeer.xReverse = pdTRUE;
+
+    TEST_CHECK_EQUAL( pdPASS, prvServe() );
+    prvCheckStates( cExpected, sizeof( cExpected ) );
+
+    /* The board sent, with the algorithm that the client asked for, and
+     * the sender's windows. */
+    TEST_CHECK_EQUAL( pdTRUE, xTest.xIsSender );
+    TEST_CHECK( strcmp( cCongestionAsked, "vegas" ) == 0 );
+    TEST_CHECK_EQUAL( 24 * ipconfigTCP_MSS, xPeer.xListen->xWindows.lTxBufSize );
+    TEST_CHECK_EQUAL( ipconfigIPERF_TX_WINSIZE, xPeer.xListen->xWindows.lTxWinSize );
+    TEST_CHECK_EQUAL( 2 * ipconfigTCP_MSS, xPeer.xListen->xWindows.lRxBufSize );
+    TEST_CHECK_EQUAL( 1, ulTxQueueAborts );
+
+    ullSent = xTest.xStreams[ 0 ].ullBytes;
+    TEST_CHECK( ullSent > 0U );
+    TEST_CHECK_EQUAL( ullSent, prvBoardSent( 0U ) );
+    TEST_CHECK( strstr( xPeer.cBoardResults, "{\"id\":1,\"bytes\":" ) != NULL );
+    TEST_CHECK_EQUAL( ullSent, prvJSONUnsigned( prvJSONValue( xPeer.cBoardResults, "\"bytes\"" ) ) );
+    TEST_CHECK_EQUAL( ullSent, xTest.ullPeerBytes );
+}
+/*-----------------------------------------------------------*/
+
+static void test_server_udp( void )
+{
+    static const int8_t cExpected[] =
+    {
+        iperf3PARAM_EXCHANGE, iperf3CREATE_STREAMS, iperf3TEST_START, iperf3TEST_RUNNING,
+        iperf3EXCHANGE_RESULTS, iperf3DISPLAY_RESULTS
+    };
+    static const uint8_t ucReply[ 4 ] = { 0x36U, 0x37U, 0x38U, 0x39U };
+    Iperf3Stream_t * pxStream = &( xTest.xStreams[ 0 ] );
+    char cExpectedCounts[ 64 ];
+    uint32_t ulSent;
+    uint32_t ulJitterUs;
+
+    prvSetUp();
+    xPeer.pcParams = cParamsUDP;
+    xPeer.pcResults = cResultsUDP;
+    xPeer.uxStreams = 1U;
+    xPeer.xUDP = pdTRUE;
+
+    TEST_CHECK_EQUAL( pdPASS, prvServe() );
+    prvCheckStates( cExpected, sizeof( cExpected ) );
+
+    TEST_CHECK_EQUAL( pdTRUE, xTest.xParams.xUDP );
+    TEST_CHECK_EQUAL( 10000000, xTest.xParams.ulBitrate );
+    TEST_CHECK_EQUAL( 1000, xTest.xParams.uxLength );
+
+    /* UDP_CONNECT_REPLY, as an x86 client reads it. */
+    TEST_CHECK( memcmp( xPeer.ucConnectReply[ 0 ], ucReply, sizeof( ucReply ) ) == 0 );
+
+    /* Three datagrams lost, one out of order. */
+    ulSent = xPeer.ulDatagrams[ 0 ];
+    TEST_CHECK( ulSent > 900U );
+    TEST_CHECK_EQUAL( ulSent, pxStream->ulPackets );
+    TEST_CHECK_EQUAL( 3, pxStream->ulErrors );
+    TEST_CHECK_EQUAL( 1, pxStream->ulOutOfOrder );
+    TEST_CHECK_EQUAL( ( uint64_t ) ( ulSent - 3U ) * 1000U, pxStream->ullBytes );
+    TEST_CHECK_EQUAL( prvDeliveredTotal(), pxStream->ullBytes );
+
+    /* The transit time changes by 400 us from one datagram to the next. */
+    ulJitterUs = pxStream->ulJitterUs;
+    TEST_CHECK( ( ulJitterUs > 370U ) && ( ulJitterUs <= 400U ) );
+
+    ( void ) snprintf( cExpectedCounts, sizeof( cExpectedCounts ), "\"jitter\":0.000%03u,\"errors\":3,\"packets\":%u,",
+                       ( unsigned ) ulJitterUs, ( unsigned ) ulSent );
+    TEST_CHECK( strstr( xPeer.cBoardResults, cExpectedCounts ) != NULL );
+
+    /* The client's counts, "omitted_errors" and "omitted_packets" are not
+     * taken for them. */
+    TEST_CHECK_EQUAL( ulSent, xTest.ulPeerPackets );
+    TEST_CHECK_EQUAL( 0, xTest.ulPeerErrors );
+    TEST_CHECK_EQUAL( prvDeliveredTotal(), xTest.ullPeerBytes );
+}
+/*-----------------------------------------------------------*/
+
+static void test_server_refuses( void )
+{
+    static const int8_t cExpected[] = { iperf3PARAM_EXCHANGE, iperf3ACCESS_DENIED };
+
+    /* iperf3 3.9 prints "error - access denied" and stops. */
+    prvSetUp();
+    xPeer.pcParams = cParamsBidirectional;
+    xPeer.uxStreams = 1U;
+    TEST_CHECK_EQUAL( pdFAIL, prvServe() );
+    prvCheckStates( cExpected, sizeof( cExpected ) );
+
+    prvSetUp();
+    xPeer.pcParams = cParamsBytes;
+    xPeer.uxStreams = 1U;
+    TEST_CHECK_EQUAL( pdFAIL, prvServe() );
+    prvCheckStates( cExpected, sizeof( cExpected ) );
+
+    /* The next client is served. */
+    prvSetUp();
+    xPeer.pcParams = cParamsReverse;
+    xPeer.pcResults = cResultsReverse;
+    xPeer.uxStreams = 1U;
+    xPeer.xReverse = pdTRUE;
+    TEST_CHECK_EQUAL( pdPASS, prvServe() );
+}
+/*-----------------------------------------------------------*/
+
+static void test_client( void )
+{
+    static const char cAlphabet[] = "abcdefghijklmnopqrstuvwxyz234567";
+    static const int8_t cExpected[] = { iperf3TEST_END, iperf3IPERF_DONE };
+    Iperf3Params_t xParams;
+    TaskFunction_t pxTask;
+    char cCookie[ iperf3COOKIE_SIZE ];
+    uint64_t ullSent;
+    size_t x;
+
+    prvSetUp();
+    xPeer.pcResults = cResultsServer;
+    xPeer.uxStreams = 1U;
+    xPeer.ulSeconds = 1U;
+
+    memset( &xParams, 0, sizeof( xParams ) );
+    xParams.xServer.sin_family = FREERTOS_AF_INET;
+    xParams.xServer.sin_port = FreeRTOS_htons( configIPERF3_PORT );
+    xParams.xServer.sin_address.ulIP_IPv4 = testPEER_ADDRESS;
+    xParams.ulTimeSeconds = 1U;
+
+    TEST_CHECK_EQUAL( pdPASS, xIperf3StartClient( &xParams ) );
+    TEST_CHECK_EQUAL( pdFAIL, xIperf3StartClient( &xParams ) );
+
+    /* Run the client task, which deletes itself at the end. */
+    pxTask = pxFakeKernelLastTask();
+    TEST_CHECK( pxTask == prvClientTask );
+    pxTask( NULL );
+
+    /* A cookie as iperf3 makes them: 36 base32 characters. */
+    for( x = 0; x < ( iperf3COOKIE_SIZE - 1U ); x++ )
+    {
+        cCookie[ x ] = cAlphabet[ ( ( x * 7U ) + 3U ) & 0x1FU ];
+    }
+
+    cCookie[ iperf3COOKIE_SIZE - 1U ] = '\0';
+    TEST_CHECK( memcmp( cCookie, xPeer.cCookie, iperf3COOKIE_SIZE ) == 0 );
+
+    /* The defaults of iperf3, except the time. */
+    TEST_CHECK( strcmp( xPeer.cBoardParams,
+                        "{\"tcp\":true,\"omit\":0,\"time\":1,\"parallel\":1,\"len\":131072,\"client_version\":\"3.1\"}" ) == 0 );
+    prvCheckStates( cExpected, sizeof( cExpected ) );
+
+    ullSent = xTest.xStreams[ 0 ].ullBytes;
+    TEST_CHECK( ullSent > 0U );
+    TEST_CHECK_EQUAL( ullSent, prvJSONUnsigned( prvJSONValue( xPeer.cBoardResults, "\"bytes\"" ) ) );
+    TEST_CHECK_EQUAL( ullSent, xTest.ullPeerBytes );
+
+    /* Everything was closed, and another test may start. */
+    TEST_CHECK_EQUAL( 0, ulOpenSockets );
+    TEST_CHECK_EQUAL( pdFALSE, xTestRunning );
+}
+/*-----------------------------------------------------------*/
+
+int main( void )
+{
+    TEST_RUN( test_server_tcp );
+    TEST_RUN( test_server_reverse );
+    TEST_RUN( test_server_udp );
+    TEST_RUN( test_server_refuses );
+    TEST_RUN( test_client );
+
+    return 0;
+}
+/*-----------------------------------------------------------*/
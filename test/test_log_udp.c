@@ -0,0 +1,605 @@
+/* Included, so that the batch, the rate limit and the counters can be
+ * cleared between tests. */
+#include "log_udp.c"
+
+/* Standard includes. */
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "fake_kernel.h"
+#include "test.h"
+
+/* 2026-10-19T08:30:15.250000Z */
+#define testWALL_CLOCK_US       ( ( 1792398615ULL * 1000000ULL ) + 250000ULL )
+
+#define testMAX_MESSAGES        256U
+#define testMAX_TEXT            2048U
+
+/* The sockets of the module are UDP sockets of the host, so the datagrams go
+ * over the loopback to the receiver of the test. */
+struct xSOCKET
+{
+    int iDescriptor;
+};
+
+/* A message as the receiver parsed it. */
+typedef struct xTEST_MESSAGE
+{
+    unsigned uPriority;
+    char cTime[ 40 ];
+    unsigned uSequence;
+    char cText[ testMAX_TEXT ];
+    size_t uxDatagram; /* Counted from 0 per call to prvReceive(). */
+} TestMessage_t;
+
+static int iReceiver = -1;
+static struct freertos_sockaddr xCollectorAddress;
+
+static TestMessage_t xMessages[ testMAX_MESSAGES ];
+static size_t uxMessageCount = 0U;
+static size_t uxDatagramCount = 0U;
+static size_t uxLargestDatagram = 0U;
+static size_t uxReceivedBytes = 0U;
+
+static BaseType_t xWallClockSet = pdFALSE;
+static BaseType_t xNoRoute = pdFALSE;
+static BaseType_t xNoBuffer = pdFALSE;
+static uint32_t ulOpenSockets = 0U;
+static uint32_t ulSocketsOpened = 0U;
+
+/*-----------------------------------------------------------*/
+
+BaseType_t xWallClockIsSet( void )
+{
+    return xWallClockSet;
+}
+/*-----------------------------------------------------------*/
+
+uint64_t ullWallClockMicroseconds( void )
+{
+    return testWALL_CLOCK_US + ( ( uint64_t ) xTaskGetTickCount() * 1000ULL );
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xRouteCacheLookup( const struct freertos_sockaddr * pxDestination,
+                              Route_t * pxRoute )
+{
+    TEST_CHECK_EQUAL( FREERTOS_AF_INET, pxDestination->sin_family );
+    memset( pxRoute, 0, sizeof( *pxRoute ) );
+
+    return ( xNoRoute == pdFALSE ) ? pdPASS : pdFAIL;
+}
+/*-----------------------------------------------------------*/
+
+Socket_t FreeRTOS_socket( BaseType_t xDomain,
+                          BaseType_t xType,
+                          BaseType_t xProtocol )
+{
+    struct xSOCKET * pxSocket;
+
+    TEST_CHECK_EQUAL( FREERTOS_AF_INET, xDomain );
+    TEST_CHECK_EQUAL( FREERTOS_SOCK_DGRAM, xType );
+    TEST_CHECK_EQUAL( FREERTOS_IPPROTO_UDP, xProtocol );
+
+    pxSocket = malloc( sizeof( *pxSocket ) );
+    TEST_CHECK( pxSocket != NULL );
+    pxSocket->iDescriptor = socket( AF_INET, SOCK_DGRAM, IPPROTO_UDP );
+    TEST_CHECK( pxSocket->iDescriptor >= 0 );
+
+    ulOpenSockets++;
+    ulSocketsOpened++;
+
+    return pxSocket;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t FreeRTOS_setsockopt( Socket_t xSocket,
+                                int32_t lLevel,
+                                int32_t lOptionName,
+                                const void * pvOptionValue,
+                                size_t uxOptionLength )
+{
+    ( void ) xSocket;
+    ( void ) lLevel;
+
+    /* The module must never wait for a network buffer. */
+    TEST_CHECK_EQUAL( FREERTOS_SO_SNDTIMEO, lOptionName );
+    TEST_CHECK_EQUAL( sizeof( TickType_t ), uxOptionLength );
+    TEST_CHECK_EQUAL( 0, *( ( const TickType_t * ) pvOptionValue ) );
+
+    return 0;
+}
+/*-----------------------------------------------------------*/
+
+int32_t FreeRTOS_sendto( Socket_t xSocket,
+                         const void * pvBuffer,
+                         size_t uxTotalDataLength,
+                         BaseType_t xFlags,
+                         const struct freertos_sockaddr * pxDestinationAddress,
+                         uint32_t xDestinationAddressLength )
+{
+    struct sockaddr_in xTo;
+    ssize_t xSent;
+
+    ( void ) xFlags;
+    TEST_CHECK_EQUAL( sizeof( struct freertos_sockaddr ), xDestinationAddressLength );
+    TEST_CHECK( uxTotalDataLength <= configLOG_UDP_DATAGRAM_SIZE );
+
+    if( xNoBuffer != pdFALSE )
+    {
+        return 0;
+    }
+
+    memset( &xTo, 0, sizeof( xTo ) );
+    xTo.sin_family = AF_INET;
+    xTo.sin_port = pxDestinationAddress->sin_port;
+    xTo.sin_addr.s_addr = pxDestinationAddress->sin_address.ulIP_IPv4;
+
+    xSent = sendto( xSocket->iDescriptor, pvBuffer, uxTotalDataLength, 0, ( struct sockaddr * ) &xTo, sizeof( xTo ) );
+    TEST_CHECK_EQUAL( uxTotalDataLength, xSent );
+
+    return ( int32_t ) xSent;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t FreeRTOS_closesocket( Socket_t xSocket )
+{
+    TEST_CHECK( ulOpenSockets > 0U );
+    ( void ) close( xSocket->iDescriptor );
+    free( xSocket );
+    ulOpenSockets--;
+
+    return 1;
+}
+/*-----------------------------------------------------------*/
+
+/* Read every datagram that has arrived, and parse the messages in it. */
+static void prvReceive( void )
+{
+    char cDatagram[ 2048 ];
+    ssize_t xLength;
+    char * pcMessage;
+    char * pcEnd;
+    int iTextStart;
+    size_t uxDatagram = 0U;
+
+    uxMessageCount = 0U;
+    uxDatagramCount = 0U;
+    uxLargestDatagram = 0U;
+
+    for( ; ; )
+    {
+        xLength = recv( iReceiver, cDatagram, sizeof( cDatagram ) - 1U, MSG_DONTWAIT );
+
+        if( xLength < 0 )
+        {
+            break;
+        }
+
+        TEST_CHECK( xLength > 0 );
+        TEST_CHECK( ( size_t ) xLength <= configLOG_UDP_DATAGRAM_SIZE );
+
+        /* Only whole messages go into a datagram. */
+        TEST_CHECK_EQUAL( '\n', cDatagram[ xLength - 1 ] );
+        cDatagram[ xLength ] = '\0';
+
+        uxDatagramCount++;
+        uxReceivedBytes += ( size_t ) xLength;
+
+        if( ( size_t ) xLength > uxLargestDatagram )
+        {
+            uxLargestDatagram = ( size_t ) xLength;
+        }
+
+        for( pcMessage = cDatagram; *pcMessage != '\0'; pcMessage = pcEnd + 1 )
+        {
+            TestMessage_t * pxMessage = &( xMessages[ uxMessageCount ] );
+
+            TEST_CHECK( uxMessageCount < testMAX_MESSAGES );
+            pcEnd = strchr( pcMessage, '\n' );
+            *pcEnd = '\0';
+
+            iTextStart = -1;
+            ( void ) sscanf( pcMessage, "<%u>1 %39s stm32h7 freertos - - [meta sequenceId=\"%u\"] %n",
+                             &( pxMessage->uPriority ), pxMessage->cTime, &( pxMessage->uSequence ), &iTextStart );
+            TEST_CHECK( iTextStart > 0 );
+
+            ( void ) snprintf( pxMessage->cText, sizeof( pxMessage->cText ), "%s", &( pcMessage[ iTextStart ] ) );
+            pxMessage->uxDatagram = uxDatagram;
+            uxMessageCount++;
+        }
+
+        uxDatagram++;
+    }
+}
+/*-----------------------------------------------------------*/
+
+/* A message of uxLength characters that starts with its number. */
+static const char * prvText( uint32_t ulNumber,
+                             size_t uxLength )
+{
+    static char cText[ testMAX_TEXT ];
+    int iLength = snprintf( cText, sizeof( cText ), "message %u ", ( unsigned ) ulNumber );
+
+    memset( &( cText[ iLength ] ), 'x', uxLength - ( size_t ) iLength );
+    cText[ uxLength ] = '\0';
+
+    return cText;
+}
+/*-----------------------------------------------------------*/
+
+/* The logging task waits for the next message as long as the module asks. */
+static void prvIdle( TickType_t xTicks )
+{
+    TickType_t xEnd = xTaskGetTickCount() + xTicks;
+    TickType_t xDelay;
+
+    while( xTaskGetTickCount() != xEnd )
+    {
+        xDelay = xLogUDPFlushDelay();
+
+        if( xDelay > ( xEnd - xTaskGetTickCount() ) )
+        {
+            xDelay = xEnd - xTaskGetTickCount();
+        }
+
+        vFakeKernelAdvance( xDelay );
+        vLogUDPFlush();
+    }
+}
+/*-----------------------------------------------------------*/
+
+static void prvSetUp( void )
+{
+    struct sockaddr_in xAddress;
+    socklen_t xAddressLength = sizeof( xAddress );
+
+    vFakeKernelReset();
+
+    /* The state of log_udp.c. */
+    if( xSocket != FREERTOS_INVALID_SOCKET )
+    {
+        ( void ) FreeRTOS_closesocket( xSocket );
+    }
+
+    xStarted = pdFALSE;
+    memset( &xCollector, 0, sizeof( xCollector ) );
+    xSocket = FREERTOS_INVALID_SOCKET;
+    uxBatchLength = 0U;
+    ulBatchMessages = 0U;
+    xBatchStarted = 0U;
+    ulSequence = 0U;
+    ulTokens = configLOG_UDP_BURST_BYTES;
+    xLastRefill = 0U;
+    memset( &xStats, 0, sizeof( xStats ) );
+
+    xWallClockSet = pdFALSE;
+    xNoRoute = pdFALSE;
+    xNoBuffer = pdFALSE;
+    ulSocketsOpened = 0U;
+    uxReceivedBytes = 0U;
+
+    /* A collector on the loopback, at a port of the host's choosing. */
+    if( iReceiver >= 0 )
+    {
+        ( void ) close( iReceiver );
+    }
+
+    iReceiver = socket( AF_INET, SOCK_DGRAM, IPPROTO_UDP );
+    TEST_CHECK( iReceiver >= 0 );
+
+    memset( &xAddress, 0, sizeof( xAddress ) );
+    xAddress.sin_family = AF_INET;
+    xAddress.sin_addr.s_addr = htonl( INADDR_LOOPBACK );
+    TEST_CHECK_EQUAL( 0, bind( iReceiver, ( struct sockaddr * ) &xAddress, sizeof( xAddress ) ) );
+    TEST_CHECK_EQUAL( 0, getsockname( iReceiver, ( struct sockaddr * ) &xAddress, &xAddressLength ) );
+
+    memset( &xCollectorAddress, 0, sizeof( xCollectorAddress ) );
+    xCollectorAddress.sin_len = sizeof( xCollectorAddress );
+    xCollectorAddress.sin_family = FREERTOS_AF_INET;
+    xCollectorAddress.sin_port = xAddress.sin_port;
+    xCollectorAddress.sin_address.ulIP_IPv4 = xAddress.sin_addr.s_addr;
+}
+/*-----------------------------------------------------------*/
+
+static void test_not_started( void )
+{
+    LogUDPStats_t xStatsNow;
+
+    prvSetUp();
+
+    /* Until vLogUDPStart(), the messages go to the UART. */
+    TEST_CHECK_EQUAL( pdFALSE, xLogUDPWrite( "boot\r\n", logLEVEL_INFO ) );
+    TEST_CHECK_EQUAL( portMAX_DELAY, xLogUDPFlushDelay() );
+    TEST_CHECK_EQUAL( 0, ulSocketsOpened );
+
+    prvReceive();
+    TEST_CHECK_EQUAL( 0, uxDatagramCount );
+
+    vLogUDPGetStats( &xStatsNow );
+    TEST_CHECK_EQUAL( 0, xStatsNow.ulMessages );
+}
+/*-----------------------------------------------------------*/
+
+static void test_batching( void )
+{
+    LogUDPStats_t xStatsNow;
+    uint32_t ulNumber;
+    size_t x;
+
+    prvSetUp();
+    vLogUDPStart( &xCollectorAddress );
+
+    /* A header of 52 or 53 bytes, 100 bytes of text and the newline: 9
+     * messages go into a datagram of 1472 bytes, a 10th does not fit. */
+    for( ulNumber = 0U; ulNumber < 30U; ulNumber++ )
+    {
+        TEST_CHECK_EQUAL( pdTRUE, xLogUDPWrite( prvText( ulNumber, 100U ), logLEVEL_INFO ) );
+    }
+
+    TEST_CHECK_EQUAL( 1, ulSocketsOpened );
+
+    prvReceive();
+    TEST_CHECK_EQUAL( 3, uxDatagramCount );
+    TEST_CHECK_EQUAL( 27, uxMessageCount );
+    TEST_CHECK( uxLargestDatagram > ( configLOG_UDP_DATAGRAM_SIZE - 154U ) );
+
+    for( x = 0; x < uxMessageCount; x++ )
+    {
+        TEST_CHECK_EQUAL( x, xMessages[ x ].uSequence );
+        TEST_CHECK_EQUAL( x / 9U, xMessages[ x ].uxDatagram );
+        TEST_CHECK_EQUAL( ( 16 * 8 ) + 6, xMessages[ x ].uPriority );
+        TEST_CHECK( strcmp( xMessages[ x ].cTime, "-" ) == 0 );
+        TEST_CHECK( strcmp( xMessages[ x ].cText, prvText( ( uint32_t ) x, 100U ) ) == 0 );
+    }
+
+    /* The last three wait for configLOG_UDP_FLUSH_MS. */
+    TEST_CHECK_EQUAL( pdMS_TO_TICKS( configLOG_UDP_FLUSH_MS ), xLogUDPFlushDelay() );
+    vFakeKernelAdvance( pdMS_TO_TICKS( configLOG_UDP_FLUSH_MS ) - 1U );
+    vLogUDPFlush();
+    prvReceive();
+    TEST_CHECK_EQUAL( 0, uxDatagramCount );
+    TEST_CHECK_EQUAL( 1, xLogUDPFlushDelay() );
+
+    prvIdle( 1U );
+    prvReceive();
+    TEST_CHECK_EQUAL( 1, uxDatagramCount );
+    TEST_CHECK_EQUAL( 3, uxMessageCount );
+    TEST_CHECK_EQUAL( 27, xMessages[ 0 ].uSequence );
+    TEST_CHECK_EQUAL( 29, xMessages[ 2 ].uSequence );
+    TEST_CHECK_EQUAL( portMAX_DELAY, xLogUDPFlushDelay() );
+
+    vLogUDPGetStats( &xStatsNow );
+    TEST_CHECK_EQUAL( 4, xStatsNow.ulDatagrams );
+    TEST_CHECK_EQUAL( 30, xStatsNow.ulMessages );
+    TEST_CHECK_EQUAL( uxReceivedBytes, xStatsNow.ulBytes );
+    TEST_CHECK_EQUAL( 0, xStatsNow.ulSendFailures );
+    TEST_CHECK_EQUAL( 0, xStatsNow.ulRateLimited );
+
+    printf( "    30 messages in %u datagrams, %u bytes, %u bytes per message\n",
+            ( unsigned ) xStatsNow.ulDatagrams, ( unsigned ) xStatsNow.ulBytes,
+            ( unsigned ) ( xStatsNow.ulBytes / xStatsNow.ulMessages ) );
+}
+/*-----------------------------------------------------------*/
+
+static void test_format( void )
+{
+    const char * pcLong;
+
+    prvSetUp();
+    vLogUDPStart( &xCollectorAddress );
+    xWallClockSet = pdTRUE;
+    vFakeKernelAdvance( 5U );
+
+    TEST_CHECK_EQUAL( pdTRUE, xLogUDPWrite( "error\r\n", logLEVEL_ERROR ) );
+    TEST_CHECK_EQUAL( pdTRUE, xLogUDPWrite( "warn\n\r", logLEVEL_WARN ) );
+    TEST_CHECK_EQUAL( pdTRUE, xLogUDPWrite( "info\r", logLEVEL_INFO ) );
+    TEST_CHECK_EQUAL( pdTRUE, xLogUDPWrite( "debug", logLEVEL_DEBUG ) );
+    TEST_CHECK_EQUAL( pdTRUE, xLogUDPWrite( "unknown", 9U ) );
+    TEST_CHECK_EQUAL( pdTRUE, xLogUDPWrite( "\r\n", logLEVEL_INFO ) );
+
+    /* A message longer than a datagram is cut to fill one. */
+    pcLong = prvText( 6U, 2000U );
+    TEST_CHECK_EQUAL( pdTRUE, xLogUDPWrite( pcLong, logLEVEL_INFO ) );
+    prvIdle( pdMS_TO_TICKS( configLOG_UDP_FLUSH_MS ) );
+
+    prvReceive();
+    TEST_CHECK_EQUAL( 2, uxDatagramCount );
+    TEST_CHECK_EQUAL( 7, uxMessageCount );
+    TEST_CHECK_EQUAL( configLOG_UDP_DATAGRAM_SIZE, uxLargestDatagram );
+
+    TEST_CHECK_EQUAL( ( 16 * 8 ) + 3, xMessages[ 0 ].uPriority );
+    TEST_CHECK_EQUAL( ( 16 * 8 ) + 4, xMessages[ 1 ].uPriority );
+    TEST_CHECK_EQUAL( ( 16 * 8 ) + 6, xMessages[ 2 ].uPriority );
+    TEST_CHECK_EQUAL( ( 16 * 8 ) + 7, xMessages[ 3 ].uPriority );
+    TEST_CHECK_EQUAL( ( 16 * 8 ) + 7, xMessages[ 4 ].uPriority );
+
+    TEST_CHECK( strcmp( xMessages[ 0 ].cText, "error" ) == 0 );
+    TEST_CHECK( strcmp( xMessages[ 1 ].cText, "warn" ) == 0 );
+    TEST_CHECK( strcmp( xMessages[ 2 ].cText, "info" ) == 0 );
+    TEST_CHECK( strcmp( xMessages[ 3 ].cText, "debug" ) == 0 );
+    TEST_CHECK( strcmp( xMessages[ 5 ].cText, "" ) == 0 );
+    TEST_CHECK( strlen( xMessages[ 6 ].cText ) < 2000U );
+    TEST_CHECK( strncmp( xMessages[ 6 ].cText, pcLong, strlen( xMessages[ 6 ].cText ) ) == 0 );
+    TEST_CHECK_EQUAL( 1, xMessages[ 6 ].uxDatagram );
+
+    /* RFC 5424 time, in UTC, to the microsecond. */
+    TEST_CHECK( strcmp( xMessages[ 0 ].cTime, "2026-10-19T08:30:15.255000Z" ) == 0 );
+}
+/*-----------------------------------------------------------*/
+
+static void test_rate_limit( void )
+{
+    LogUDPStats_t xStatsNow;
+    static uint32_t ulReceived[ 512 ];
+    size_t uxReceived = 0U;
+    uint32_t ulNumber;
+    uint32_t ulSeconds = 2U;
+    uint32_t ulGaps = 0U;
+    size_t x;
+
+    prvSetUp();
+    vLogUDPStart( &xCollectorAddress );
+
+    /* One message of about 1 kB per millisecond, 1 MB/s: far more than
+     * configLOG_UDP_RATE_BYTES. */
+    for( ulNumber = 0U; ulNumber < ( ulSeconds * configTICK_RATE_HZ ); ulNumber++ )
+    {
+        TEST_CHECK_EQUAL( pdTRUE, xLogUDPWrite( prvText( ulNumber, 1000U ), logLEVEL_DEBUG ) );
+        vFakeKernelAdvance( 1U );
+
+        if( ( ( ulNumber % 64U ) == 63U ) || ( ( ulNumber + 1U ) == ( ulSeconds * configTICK_RATE_HZ ) ) )
+        {
+            if( ( ulNumber + 1U ) == ( ulSeconds * configTICK_RATE_HZ ) )
+            {
+                prvIdle( pdMS_TO_TICKS( configLOG_UDP_FLUSH_MS ) );
+            }
+
+            prvReceive();
+
+            for( x = 0; x < uxMessageCount; x++ )
+            {
+                TEST_CHECK( uxReceived < ( sizeof( ulReceived ) / sizeof( ulReceived[ 0 ] ) ) );
+                ulReceived[ uxReceived ] = xMessages[ x ].uSequence;
+                uxReceived++;
+            }
+        }
+    }
+
+    vLogUDPGetStats( &xStatsNow );
+    TEST_CHECK_EQUAL( ulSeconds * configTICK_RATE_HZ, xStatsNow.ulMessages + xStatsNow.ulRateLimited );
+    TEST_CHECK_EQUAL( xStatsNow.ulMessages, uxReceived );
+    TEST_CHECK_EQUAL( 0, xStatsNow.ulSendFailures );
+
+    /* The burst holds the first 15 messages, after that only every 16th
+     * or so gets through, and the gaps in the sequence show it. */
+    for( x = 0; x < uxReceived; x++ )
+    {
+        if( x < 15U )
+        {
+            TEST_CHECK_EQUAL( x, ulReceived[ x ] );
+        }
+        else
+        {
+            TEST_CHECK( ulReceived[ x ] > ulReceived[ x - 1U ] );
+            ulGaps += ulReceived[ x ] - ulReceived[ x - 1U ] - 1U;
+        }
+    }
+
+    TEST_CHECK_EQUAL( xStatsNow.ulRateLimited, ulGaps + ( ( ulSeconds * configTICK_RATE_HZ ) - 1U - ulReceived[ uxReceived - 1U ] ) );
+
+    /* The burst, then no more than the rate, and all of it arrived. */
+    TEST_CHECK_EQUAL( xStatsNow.ulBytes, uxReceivedBytes );
+    TEST_CHECK( xStatsNow.ulBytes <= ( configLOG_UDP_BURST_BYTES + ( ulSeconds * configLOG_UDP_RATE_BYTES ) ) );
+    TEST_CHECK( xStatsNow.ulBytes >= ( ( configLOG_UDP_BURST_BYTES + ( ulSeconds * configLOG_UDP_RATE_BYTES ) ) * 97U ) / 100U );
+
+    printf( "    %u of %u messages sent in %u s, %u bytes, %u dropped\n",
+            ( unsigned ) xStatsNow.ulMessages, ( unsigned ) ( ulSeconds * configTICK_RATE_HZ ), ( unsigned ) ulSeconds,
+            ( unsigned ) xStatsNow.ulBytes, ( unsigned ) xStatsNow.ulRateLimited );
+
+    /* After a quiet second the burst is back. */
+    vFakeKernelAdvance( configTICK_RATE_HZ );
+    ulSequence = 0U;
+
+    for( ulNumber = 0U; ulNumber < 16U; ulNumber++ )
+    {
+        TEST_CHECK_EQUAL( pdTRUE, xLogUDPWrite( prvText( ulNumber, 1000U ), logLEVEL_DEBUG ) );
+    }
+
+    prvIdle( pdMS_TO_TICKS( configLOG_UDP_FLUSH_MS ) );
+    prvReceive();
+    TEST_CHECK_EQUAL( 15, uxMessageCount );
+    TEST_CHECK_EQUAL( 14, xMessages[ 14 ].uSequence );
+}
+/*-----------------------------------------------------------*/
+
+static void test_drops( void )
+{
+    LogUDPStats_t xStatsNow;
+
+    prvSetUp();
+    vLogUDPStart( &xCollectorAddress );
+
+    /* No route to the collector yet: the batch is dropped. */
+    xNoRoute = pdTRUE;
+    TEST_CHECK_EQUAL( pdTRUE, xLogUDPWrite( "one", logLEVEL_INFO ) );
+    TEST_CHECK_EQUAL( pdTRUE, xLogUDPWrite( "two", logLEVEL_INFO ) );
+    prvIdle( pdMS_TO_TICKS( configLOG_UDP_FLUSH_MS ) );
+
+    /* No network buffer. */
+    xNoRoute = pdFALSE;
+    xNoBuffer = pdTRUE;
+    TEST_CHECK_EQUAL( pdTRUE, xLogUDPWrite( "three", logLEVEL_INFO ) );
+    prvIdle( pdMS_TO_TICKS( configLOG_UDP_FLUSH_MS ) );
+
+    prvReceive();
+    TEST_CHECK_EQUAL( 0, uxDatagramCount );
+
+    xNoBuffer = pdFALSE;
+    TEST_CHECK_EQUAL( pdTRUE, xLogUDPWrite( "four", logLEVEL_INFO ) );
+    prvIdle( pdMS_TO_TICKS( configLOG_UDP_FLUSH_MS ) );
+
+    /* The gap in the sequence numbers shows the collector what is lost. */
+    prvReceive();
+    TEST_CHECK_EQUAL( 1, uxMessageCount );
+    TEST_CHECK_EQUAL( 3, xMessages[ 0 ].uSequence );
+    TEST_CHECK( strcmp( xMessages[ 0 ].cText, "four" ) == 0 );
+
+    vLogUDPGetStats( &xStatsNow );
+    TEST_CHECK_EQUAL( 1, xStatsNow.ulDatagrams );
+    TEST_CHECK_EQUAL( 1, xStatsNow.ulMessages );
+    TEST_CHECK_EQUAL( 2, xStatsNow.ulSendFailures );
+    TEST_CHECK_EQUAL( 3, xStatsNow.ulLostMessages );
+}
+/*-----------------------------------------------------------*/
+
+static void test_stop( void )
+{
+    prvSetUp();
+    vLogUDPStart( &xCollectorAddress );
+
+    TEST_CHECK_EQUAL( pdTRUE, xLogUDPWrite( "one", logLEVEL_INFO ) );
+    TEST_CHECK_EQUAL( pdTRUE, xLogUDPWrite( "two", logLEVEL_INFO ) );
+    TEST_CHECK_EQUAL( 1, ulOpenSockets );
+
+    /* The logging task is woken to send what is left and close the
+     * socket. */
+    vLogUDPStop();
+    TEST_CHECK_EQUAL( 0, xLogUDPFlushDelay() );
+    vLogUDPFlush();
+    TEST_CHECK_EQUAL( 0, ulOpenSockets );
+    TEST_CHECK_EQUAL( portMAX_DELAY, xLogUDPFlushDelay() );
+
+    prvReceive();
+    TEST_CHECK_EQUAL( 1, uxDatagramCount );
+    TEST_CHECK_EQUAL( 2, uxMessageCount );
+
+    TEST_CHECK_EQUAL( pdFALSE, xLogUDPWrite( "three", logLEVEL_INFO ) );
+
+    /* Started again, with a new socket. */
+    vLogUDPStart( &xCollectorAddress );
+    TEST_CHECK_EQUAL( pdTRUE, xLogUDPWrite( "four", logLEVEL_INFO ) );
+    TEST_CHECK_EQUAL( 1, ulOpenSockets );
+    TEST_CHECK_EQUAL( 2, ulSocketsOpened );
+    prvIdle( pdMS_TO_TICKS( configLOG_UDP_FLUSH_MS ) );
+
+    prvReceive();
+    TEST_CHECK_EQUAL( 1, uxMessageCount );
+    TEST_CHECK_EQUAL( 2, xMessages[ 0 ].uSequence );
+}
+/*-----------------------------------------------------------*/
+
+int main( void )
+{
+    TEST_RUN( test_not_started );
+    TEST_RUN( test_batching );
+    TEST_RUN( test_format );
+    TEST_RUN( test_rate_limit );
+    TEST_RUN( test_drops );
+    TEST_RUN( test_stop );
+
+    return 0;
+}
+/*-----------------------------------------------------------*/
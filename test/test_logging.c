@@ -0,0 +1,520 @@
+/* Included first, with its logMODULE, so that the queue and the writer of the
+ * logging task can be reached. */
+#include "logging.c"
+
+/* Standard includes. */
+#include <pthread.h>
+#include <string.h>
+#include <time.h>
+
+#include "fake_kernel.h"
+#include "test.h"
+
+#define testQUEUE_LENGTH    32U
+#define testMAX_LINES       64U
+#define testLINE_LENGTH     128U
+
+/* Interrupts that log at the same time, and their messages.  The total stays
+ * below the 65535 at which the count of a "messages dropped" line saturates. */
+#define testPRODUCERS       4U
+#define testPER_PRODUCER    15000U
+
+/* What the UART was given, the oldest first. */
+static char cLines[ testMAX_LINES ][ testLINE_LENGTH ];
+static uint32_t ulLines;
+
+/* The number of times an argument of a log macro was evaluated. */
+static uint32_t ulEvaluated;
+
+/* When set, the lines are passed to it instead of being kept. */
+static void ( * pfnCheckLine )( const char * pcLine );
+
+/* What prvCheckISRLine() saw. */
+static uint32_t ulNextSequence[ testPRODUCERS ];
+static volatile uint32_t ulDelivered;
+static volatile uint32_t ulMarkedDrops;
+static uint32_t ulBadLines;
+
+/*-----------------------------------------------------------*/
+
+void vPrintStringToUart( const char * str )
+{
+    if( pfnCheckLine != NULL )
+    {
+        pfnCheckLine( str );
+    }
+    else if( ulLines < testMAX_LINES )
+    {
+        ( void ) snprintf( cLines[ ulLines ], testLINE_LENGTH, "%s", str );
+    }
+
+    ulLines++;
+}
+/*-----------------------------------------------------------*/
+
+/* The network sink is stopped, everything goes to the UART. */
+BaseType_t xLogUDPWrite( const char * pcMessage,
+                         uint8_t ucLevel )
+{
+    ( void ) pcMessage;
+    ( void ) ucLevel;
+
+    return pdFALSE;
+}
+/*-----------------------------------------------------------*/
+
+void vLogUDPFlush( void )
+{
+}
+/*-----------------------------------------------------------*/
+
+TickType_t xLogUDPFlushDelay( void )
+{
+    return portMAX_DELAY;
+}
+/*-----------------------------------------------------------*/
+
+static uint32_t prvArgument( uint32_t ulValue )
+{
+    ulEvaluated++;
+
+    return ulValue;
+}
+/*-----------------------------------------------------------*/
+
+/* What the logging task does once it wakes up, without blocking. */
+static void prvRunLoggingTask( void )
+{
+    LogMessage_t * pxMessage;
+
+    while( xQueueReceive( xQueue, &pxMessage, 0U ) == pdPASS )
+    {
+        if( pxMessage != NULL )
+        {
+            prvWriteMessage( pxMessage );
+        }
+
+        prvDrainISRRecords();
+    }
+
+    prvFlushRepeats();
+}
+/*-----------------------------------------------------------*/
+
+static void prvSetUp( void )
+{
+    vFakeKernelReset();
+
+    if( xQueue == NULL )
+    {
+        TEST_CHECK_EQUAL( pdPASS, xLoggingTaskInitialize( 512U, 1U, testQUEUE_LENGTH ) );
+    }
+
+    prvRunLoggingTask();
+
+    #if ( configLOGGING_MERGE_REPEATS == 1 )
+        if( pxLastMessage != NULL )
+        {
+            prvReturnBuffer( pxLastMessage );
+        }
+
+        pxLastMessage = NULL;
+    #endif
+
+    memset( xLogModules, 0, sizeof( xLogModules ) );
+    vLoggingSetLevel( eLogModuleCount, configLOG_LEVEL_DEFAULT );
+    ulQueueFull = 0U;
+    ulNoBuffer = 0U;
+    usPendingDrops = 0U;
+    usPendingErrorDrops = 0U;
+
+    ulLines = 0U;
+    ulEvaluated = 0U;
+}
+/*-----------------------------------------------------------*/
+
+static void test_threshold( void )
+{
+    prvSetUp();
+
+    LogInfo( ( "app %u\n", ( unsigned ) prvArgument( 1U ) ) );
+    logPRINT( eLogModuleNet, logLEVEL_INFO, ( "net %u\n", ( unsigned ) prvArgument( 2U ) ) );
+    prvRunLoggingTask();
+
+    TEST_CHECK_EQUAL( 2U, ulLines );
+    TEST_CHECK( strcmp( cLines[ 0 ], "app 1\n\r" ) == 0 );
+    TEST_CHECK( strcmp( cLines[ 1 ], "net 2\n\r" ) == 0 );
+    TEST_CHECK_EQUAL( 2U, ulEvaluated );
+
+    /* Below the threshold of its module a message is not formatted, its
+     * arguments are not even evaluated, and only counted. */
+    vLoggingSetLevel( eLogModuleNet, logLEVEL_WARN );
+    logPRINT( eLogModuleNet, logLEVEL_INFO, ( "net %u\n", ( unsigned ) prvArgument( 3U ) ) );
+    logPRINT( eLogModuleNet, logLEVEL_WARN, ( "net warning\n" ) );
+    LogInfo( ( "app %u\n", ( unsigned ) prvArgument( 4U ) ) );
+    prvRunLoggingTask();
+
+    TEST_CHECK_EQUAL( 4U, ulLines );
+    TEST_CHECK( strcmp( cLines[ 2 ], "net warning\n\r" ) == 0 );
+    TEST_CHECK( strcmp( cLines[ 3 ], "app 4\n\r" ) == 0 );
+    TEST_CHECK_EQUAL( 3U, ulEvaluated );
+
+    TEST_CHECK_EQUAL( 2U, xLogModules[ eLogModuleNet ].ulEmitted );
+    TEST_CHECK_EQUAL( 1U, xLogModules[ eLogModuleNet ].ulSuppressed );
+    TEST_CHECK_EQUAL( 2U, xLogModules[ eLogModuleApp ].ulEmitted );
+    TEST_CHECK_EQUAL( 0U, xLogModules[ eLogModuleApp ].ulSuppressed );
+
+    /* Nothing at all, errors included. */
+    vLoggingSetLevel( eLogModuleCount, logLEVEL_NONE );
+    LogError( ( "app error\n" ) );
+    prvRunLoggingTask();
+
+    TEST_CHECK_EQUAL( 4U, ulLines );
+    TEST_CHECK_EQUAL( 1U, xLogModules[ eLogModuleApp ].ulSuppressed );
+}
+/*-----------------------------------------------------------*/
+
+/* The debug level is not compiled in by default: raising the threshold does
+ * not bring its messages back, and they are not even counted. */
+static void test_compiled_out( void )
+{
+    prvSetUp();
+    vLoggingSetLevel( eLogModuleCount, logLEVEL_DEBUG );
+
+    LogDebug( ( "debug %u\n", ( unsigned ) prvArgument( 1U ) ) );
+    prvRunLoggingTask();
+
+    #if ( configLOG_LEVEL_COMPILED < logLEVEL_DEBUG )
+        TEST_CHECK_EQUAL( 0U, ulLines );
+        TEST_CHECK_EQUAL( 0U, ulEvaluated );
+        TEST_CHECK_EQUAL( 0U, xLogModules[ eLogModuleApp ].ulEmitted );
+        TEST_CHECK_EQUAL( 0U, xLogModules[ eLogModuleApp ].ulSuppressed );
+    #else
+        TEST_CHECK_EQUAL( 1U, ulLines );
+    #endif
+}
+/*-----------------------------------------------------------*/
+
+static void test_report( void )
+{
+    uint32_t x;
+
+    prvSetUp();
+
+    vLoggingSetLevel( eLogModuleEcho, logLEVEL_ERROR );
+    logPRINT( eLogModuleEcho, logLEVEL_INFO, ( "echo\n" ) );
+    logPRINT( eLogModuleEcho, logLEVEL_ERROR, ( "echo error\n" ) );
+
+    /* The report is written whatever the thresholds. */
+    vLoggingSetLevel( eLogModuleApp, logLEVEL_NONE );
+    vLoggingReport();
+    prvRunLoggingTask();
+
+    TEST_CHECK_EQUAL( 1U + eLogModuleCount + 2U, ulLines );
+    TEST_CHECK( strcmp( cLines[ 1 + eLogModuleEcho ], "Log echo  level 1, 1 emitted, 1 suppressed\n\r" ) == 0 );
+    TEST_CHECK( strcmp( cLines[ 1 + eLogModuleCount ], "Log dropped 0 for a full queue, 0 for no free buffer\n\r" ) == 0 );
+
+    /* While the queue only has the slots that are kept for errors, the
+     * report is dropped like info, and the errors still fit. */
+    vLoggingSetLevel( eLogModuleCount, logLEVEL_INFO );
+
+    while( uxQueueSpacesAvailable( xQueue ) > configLOGGING_ERROR_RESERVE )
+    {
+        LogInfo( ( "busy\n" ) );
+    }
+
+    vLoggingReport();
+    TEST_CHECK_EQUAL( eLogModuleCount + 2U, ulQueueFull );
+
+    for( x = 0U; x < configLOGGING_ERROR_RESERVE; x++ )
+    {
+        LogError( ( "error %u\n", ( unsigned ) x ) );
+    }
+
+    TEST_CHECK_EQUAL( eLogModuleCount + 2U, ulQueueFull );
+    TEST_CHECK_EQUAL( testQUEUE_LENGTH, uxQueueMessagesWaiting( xQueue ) );
+
+    ulLines = 0U;
+    prvRunLoggingTask();
+
+    TEST_CHECK( strcmp( cLines[ ulLines - configLOGGING_ERROR_RESERVE - 1U ], "log: 7 messages dropped, 0 of them errors\n\r" ) == 0 );
+    TEST_CHECK( strcmp( cLines[ ulLines - 1U ], "error 7\n\r" ) == 0 );
+}
+/*-----------------------------------------------------------*/
+
+/* A storm of messages while the logging task cannot run.  Each level only
+ * fills the slots that are not reserved for more severe levels, the rest is
+ * dropped before it is formatted, and markers tell how many were lost. */
+static void test_storm( void )
+{
+    uint32_t x;
+    const UBaseType_t uxDebugSlots = testQUEUE_LENGTH - configLOGGING_ERROR_RESERVE - configLOGGING_INFO_RESERVE;
+
+    prvSetUp();
+    vLoggingSetLevel( eLogModuleCount, logLEVEL_DEBUG );
+
+    for( x = 0U; x < 1000U; x++ )
+    {
+        logPRINT( eLogModuleNet, logLEVEL_DEBUG, ( "debug %u\n", ( unsigned ) x ) );
+    }
+
+    TEST_CHECK_EQUAL( uxDebugSlots, uxQueueMessagesWaiting( xQueue ) );
+
+    for( x = 0U; x < 1000U; x++ )
+    {
+        logPRINT( eLogModuleNet, logLEVEL_INFO, ( "info %u\n", ( unsigned ) x ) );
+    }
+
+    TEST_CHECK_EQUAL( uxDebugSlots + configLOGGING_INFO_RESERVE, uxQueueMessagesWaiting( xQueue ) );
+
+    for( x = 0U; x < 100U; x++ )
+    {
+        logPRINT( eLogModuleNet, logLEVEL_ERROR, ( "error %u\n", ( unsigned ) x ) );
+    }
+
+    TEST_CHECK_EQUAL( testQUEUE_LENGTH, uxQueueMessagesWaiting( xQueue ) );
+    TEST_CHECK_EQUAL( 2100U - testQUEUE_LENGTH, ulQueueFull );
+    TEST_CHECK_EQUAL( 0U, ulNoBuffer );
+
+    /* Only the queued messages hold a buffer, and none is on the heap. */
+    TEST_CHECK_EQUAL( configLOGGING_MESSAGE_BUFFERS - testQUEUE_LENGTH, uxFreeBuffers );
+    TEST_CHECK_EQUAL( 0U, uxFakeKernelHeapInUse() );
+
+    prvRunLoggingTask();
+
+    TEST_CHECK_EQUAL( testQUEUE_LENGTH + 2U, ulLines );
+    TEST_CHECK( strcmp( cLines[ 0 ], "debug 0\n\r" ) == 0 );
+    TEST_CHECK( strcmp( cLines[ uxDebugSlots ], "log: 992 messages dropped, 0 of them errors\n\r" ) == 0 );
+    TEST_CHECK( strcmp( cLines[ uxDebugSlots + 1U ], "info 0\n\r" ) == 0 );
+    TEST_CHECK( strcmp( cLines[ uxDebugSlots + configLOGGING_INFO_RESERVE + 1U ], "log: 984 messages dropped, 0 of them errors\n\r" ) == 0 );
+    TEST_CHECK( strcmp( cLines[ uxDebugSlots + configLOGGING_INFO_RESERVE + 2U ], "error 0\n\r" ) == 0 );
+
+    /* The errors that did not fit are announced by the next message. */
+    logPRINT( eLogModuleNet, logLEVEL_DEBUG, ( "calm\n" ) );
+    prvRunLoggingTask();
+
+    TEST_CHECK( strcmp( cLines[ testQUEUE_LENGTH + 2U ], "log: 92 messages dropped, 92 of them errors\n\r" ) == 0 );
+    TEST_CHECK( strcmp( cLines[ testQUEUE_LENGTH + 3U ], "calm\n\r" ) == 0 );
+}
+/*-----------------------------------------------------------*/
+
+/* A storm while other tasks hold most of the buffers, with room left in the
+ * queue.  The buffers run out instead of the queue, for each level at its own
+ * reserve, and the errors still get the last ones. */
+static void test_no_buffer( void )
+{
+    LogMessage_t * pxHeld[ configLOGGING_MESSAGE_BUFFERS ];
+    UBaseType_t uxHeld = 0U;
+    UBaseType_t uxDebugBuffers;
+    uint32_t x;
+
+    prvSetUp();
+    vLoggingSetLevel( eLogModuleCount, logLEVEL_DEBUG );
+
+    /* Leave a few buffers to debug messages, fewer than the free queue slots. */
+    while( uxFreeBuffers > ( configLOGGING_ERROR_RESERVE + configLOGGING_INFO_RESERVE + 2U ) )
+    {
+        pxHeld[ uxHeld ] = prvTakeBuffer( logLEVEL_DEBUG );
+        TEST_CHECK( pxHeld[ uxHeld ] != NULL );
+        uxHeld++;
+    }
+
+    uxDebugBuffers = uxFreeBuffers - configLOGGING_ERROR_RESERVE - configLOGGING_INFO_RESERVE;
+
+    for( x = 0U; x < 100U; x++ )
+    {
+        logPRINT( eLogModuleNet, logLEVEL_DEBUG, ( "debug %u\n", ( unsigned ) x ) );
+    }
+
+    for( x = 0U; x < 100U; x++ )
+    {
+        logPRINT( eLogModuleNet, logLEVEL_INFO, ( "info %u\n", ( unsigned ) x ) );
+    }
+
+    for( x = 0U; x < 100U; x++ )
+    {
+        logPRINT( eLogModuleNet, logLEVEL_ERROR, ( "error %u\n", ( unsigned ) x ) );
+    }
+
+    TEST_CHECK_EQUAL( uxDebugBuffers + configLOGGING_INFO_RESERVE + configLOGGING_ERROR_RESERVE, uxQueueMessagesWaiting( xQueue ) );
+    TEST_CHECK( uxQueueMessagesWaiting( xQueue ) < testQUEUE_LENGTH );
+    TEST_CHECK_EQUAL( 0U, uxFreeBuffers );
+    TEST_CHECK_EQUAL( 300U - uxQueueMessagesWaiting( xQueue ), ulNoBuffer );
+    TEST_CHECK_EQUAL( 0U, ulQueueFull );
+
+    /* Nothing came from the heap, so vApplicationMallocFailedHook() was
+     * never called. */
+    TEST_CHECK_EQUAL( 0U, uxFakeKernelHeapInUse() );
+
+    prvRunLoggingTask();
+
+    TEST_CHECK( strcmp( cLines[ 0 ], "debug 0\n\r" ) == 0 );
+    TEST_CHECK( strcmp( cLines[ uxDebugBuffers ], "log: 98 messages dropped, 0 of them errors\n\r" ) == 0 );
+    TEST_CHECK( strcmp( cLines[ uxDebugBuffers + 1U ], "info 0\n\r" ) == 0 );
+    TEST_CHECK( strcmp( cLines[ uxDebugBuffers + configLOGGING_INFO_RESERVE + 1U ], "log: 84 messages dropped, 0 of them errors\n\r" ) == 0 );
+    TEST_CHECK( strcmp( cLines[ uxDebugBuffers + configLOGGING_INFO_RESERVE + 2U ], "error 0\n\r" ) == 0 );
+
+    /* Once the buffers are back, the count of lost errors is shown. */
+    while( uxHeld > 0U )
+    {
+        uxHeld--;
+        prvReturnBuffer( pxHeld[ uxHeld ] );
+    }
+
+    logPRINT( eLogModuleNet, logLEVEL_DEBUG, ( "calm\n" ) );
+    prvRunLoggingTask();
+
+    TEST_CHECK( strcmp( cLines[ ulLines - 2U ], "log: 92 messages dropped, 92 of them errors\n\r" ) == 0 );
+    TEST_CHECK( strcmp( cLines[ ulLines - 1U ], "calm\n\r" ) == 0 );
+
+    /* All but the one kept to compare repeats with are free again. */
+    TEST_CHECK_EQUAL( configLOGGING_MESSAGE_BUFFERS - 1U, uxFreeBuffers );
+}
+/*-----------------------------------------------------------*/
+
+/* Repeats of a line are counted, not written. */
+static void test_repeats( void )
+{
+    uint32_t x;
+
+    prvSetUp();
+
+    for( x = 0U; x < 5U; x++ )
+    {
+        LogInfo( ( "link down\n" ) );
+    }
+
+    LogInfo( ( "link up\n" ) );
+    prvRunLoggingTask();
+
+    #if ( configLOGGING_MERGE_REPEATS == 1 )
+        TEST_CHECK_EQUAL( 3U, ulLines );
+        TEST_CHECK( strcmp( cLines[ 0 ], "link down\n\r" ) == 0 );
+        TEST_CHECK( strcmp( cLines[ 1 ], "last message repeated 4 times\n\r" ) == 0 );
+        TEST_CHECK( strcmp( cLines[ 2 ], "link up\n\r" ) == 0 );
+    #else
+        TEST_CHECK_EQUAL( 6U, ulLines );
+    #endif
+}
+/*-----------------------------------------------------------*/
+
+/* Each producer numbers its messages, which must arrive in order.  A gap is
+ * only allowed where a "messages dropped" line accounts for it. */
+static void prvCheckISRLine( const char * pcLine )
+{
+    unsigned uxProducer;
+    unsigned uxSequence;
+    unsigned uxDropped;
+    unsigned uxErrors;
+
+    if( sscanf( pcLine, "isr %u %u", &uxProducer, &uxSequence ) == 2 )
+    {
+        if( ( uxProducer < testPRODUCERS ) && ( uxSequence >= ulNextSequence[ uxProducer ] ) )
+        {
+            ulNextSequence[ uxProducer ] = uxSequence + 1U;
+        }
+        else
+        {
+            ulBadLines++;
+        }
+
+        ulDelivered++;
+    }
+    else if( sscanf( pcLine, "log: %u messages dropped, %u", &uxDropped, &uxErrors ) == 2 )
+    {
+        ulMarkedDrops += uxDropped;
+    }
+    else
+    {
+        ulBadLines++;
+    }
+}
+/*-----------------------------------------------------------*/
+
+/* Bursts of messages, with a pause in which the logging task can catch up. */
+static void * prvProducer( void * pvParameter )
+{
+    unsigned uxProducer = ( unsigned ) ( uintptr_t ) pvParameter;
+    const struct timespec xPause = { 0, 50000L };
+    uint32_t x;
+
+    for( x = 0U; x < testPER_PRODUCER; x++ )
+    {
+        LogInfoFromISR( ( "isr %u %u\n", uxProducer, ( unsigned ) x ) );
+
+        if( ( x % 8U ) == 7U )
+        {
+            nanosleep( &xPause, NULL );
+        }
+    }
+
+    return NULL;
+}
+/*-----------------------------------------------------------*/
+
+static void * prvLoggingThread( void * pvParameter )
+{
+    prvLoggingTask( pvParameter );
+
+    return NULL;
+}
+/*-----------------------------------------------------------*/
+
+/* Four threads stand for interrupts that log at the same time, while the real
+ * logging task drains the ring.  Every message is written or counted as
+ * dropped, and a lost wake-up would leave messages in the ring for good.
+ * The logging task keeps running, so this test comes last. */
+static void test_isr_producers( void )
+{
+    pthread_t xProducers[ testPRODUCERS ];
+    pthread_t xLogging;
+    const struct timespec xOneMs = { 0, 1000000L };
+    const uint32_t ulTotal = testPRODUCERS * testPER_PRODUCER;
+    uint32_t x;
+
+    prvSetUp();
+    vFakeKernelUseThreads();
+    pfnCheckLine = prvCheckISRLine;
+
+    TEST_CHECK_EQUAL( 0, pthread_create( &xLogging, NULL, prvLoggingThread, NULL ) );
+
+    for( x = 0U; x < testPRODUCERS; x++ )
+    {
+        TEST_CHECK_EQUAL( 0, pthread_create( &( xProducers[ x ] ), NULL, prvProducer, ( void * ) ( uintptr_t ) x ) );
+    }
+
+    for( x = 0U; x < testPRODUCERS; x++ )
+    {
+        TEST_CHECK_EQUAL( 0, pthread_join( xProducers[ x ], NULL ) );
+    }
+
+    for( x = 0U; ( x < 5000U ) && ( ( ulDelivered + ulISRFull ) < ulTotal ); x++ )
+    {
+        nanosleep( &xOneMs, NULL );
+    }
+
+    printf( "%u delivered, %u dropped\n", ( unsigned ) ulDelivered, ( unsigned ) ulISRFull );
+
+    TEST_CHECK_EQUAL( ulTotal, ulDelivered + ulISRFull );
+    TEST_CHECK_EQUAL( ulISRFull, ulMarkedDrops + usISRPendingDrops );
+    TEST_CHECK_EQUAL( 0U, ulBadLines );
+    TEST_CHECK_EQUAL( ulDelivered, xLogModules[ eLogModuleApp ].ulEmitted );
+
+    /* Only the wake-up items were ever queued. */
+    TEST_CHECK_EQUAL( 0U, ulQueueFull );
+}
+/*-----------------------------------------------------------*/
+
+int main( void )
+{
+    TEST_RUN( test_threshold );
+    TEST_RUN( test_compiled_out );
+    TEST_RUN( test_report );
+    TEST_RUN( test_storm );
+    TEST_RUN( test_no_buffer );
+    TEST_RUN( test_repeats );
+    TEST_RUN( test_isr_producers );
+
+    return 0;
+}
+/*-----------------------------------------------------------*/
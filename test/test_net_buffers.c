@@ -0,0 +1,511 @@
+/* A pointer does not fit in the 32-bit exclusive access of the target, and
+ * nothing interrupts a load and a store here. */
+#define netbuffersLOAD_HEAD( ppucHead )               ( *( ppucHead ) )
+#define netbuffersSTORE_HEAD( ppucHead, pucValue )    ( *( ppucHead ) = ( pucValue ), 0U )
+
+/* Included, so that the pools can be set up again for every test. */
+#include "net_buffers.c"
+
+/* Standard includes. */
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "fake_kernel.h"
+#include "test.h"
+
+/* The RAM of the three classes, and the number of full-size blocks that it
+ * would hold instead. */
+#define testPOOL_BYTES                                                          \
+    ( ( configNET_BUFFERS_SMALL_COUNT * netbuffersBLOCK_SIZE( configNET_BUFFERS_SMALL_SIZE ) ) +   \
+      ( configNET_BUFFERS_MEDIUM_COUNT * netbuffersBLOCK_SIZE( configNET_BUFFERS_MEDIUM_SIZE ) ) + \
+      ( configNET_BUFFERS_LARGE_COUNT * netbuffersBLOCK_SIZE( configNET_BUFFERS_LARGE_SIZE ) ) )
+#define testFULL_SIZE_BLOCKS    ( testPOOL_BYTES / netbuffersBLOCK_SIZE( configNET_BUFFERS_LARGE_SIZE ) )
+
+/* Packets in flight while the throughput is measured. */
+#define testIN_FLIGHT           32U
+#define testROUNDS              1000000U
+
+/* A traffic mix: the sizes of the frames that the stack allocates for it,
+ * Ethernet header included, and how often each size occurs per 100 frames. */
+typedef struct xTEST_SIZE
+{
+    size_t uxSize;
+    uint32_t ulCount;
+} TestSize_t;
+
+typedef struct xTEST_MIX
+{
+    const char * pcName;
+    const TestSize_t * pxSizes;
+    size_t uxSizeCount;
+} TestMix_t;
+
+/* The board receives a bulk transfer (iperf3 -R, an HTTP upload), the stack
+ * sends the ACKs and an ARP now and then. */
+static const TestSize_t xBulkReceive[] =
+{
+    { 60U,   96U }, /* ACK, padded to the minimum frame. */
+    { 42U,   2U  }, /* ARP reply. */
+    { 86U,   2U  }, /* Neighbour advertisement. */
+};
+
+/* The board sends a bulk transfer (tcp_sendfile, iperf3). */
+static const TestSize_t xBulkSend[] =
+{
+    { 1514U, 90U }, /* Full-size TCP segment. */
+    { 590U,  4U  }, /* The tail of a send. */
+    { 60U,   6U  }, /* ACK, window update. */
+};
+
+/* The UDP echo, ping, and the services that keep the board on the network. */
+static const TestSize_t xServices[] =
+{
+    { 67U,   50U }, /* UDP echo of TX_RX_STR_SIZE bytes. */
+    { 98U,   20U }, /* Echo reply to a ping of 56 bytes. */
+    { 42U,   8U  }, /* ARP. */
+    { 86U,   6U  }, /* Neighbour solicitation and advertisement. */
+    { 84U,   5U  }, /* DNS query. */
+    { 90U,   5U  }, /* SNTP. */
+    { 342U,  2U  }, /* DHCP discover and request. */
+    { 512U,  4U  }, /* A batch of log messages of log_udp.c. */
+};
+
+static const TestMix_t xMixes[] =
+{
+    { "bulk receive", xBulkReceive, sizeof( xBulkReceive ) / sizeof( xBulkReceive[ 0 ] ) },
+    { "bulk send",    xBulkSend,    sizeof( xBulkSend ) / sizeof( xBulkSend[ 0 ] )       },
+    { "services",     xServices,    sizeof( xServices ) / sizeof( xServices[ 0 ] )       },
+};
+
+static uint32_t ulBufferFailures = 0U;
+static uint32_t ulRandom = 1U;
+
+/*-----------------------------------------------------------*/
+
+void vNetStatsBufferFailure( void )
+{
+    ulBufferFailures++;
+}
+/*-----------------------------------------------------------*/
+
+void vTraceRecord( uint32_t ulEvent,
+                   uint32_t ulArg1,
+                   uint32_t ulArg2 )
+{
+    ( void ) ulEvent;
+    ( void ) ulArg1;
+    ( void ) ulArg2;
+}
+/*-----------------------------------------------------------*/
+
+static void prvSetUp( void )
+{
+    BaseType_t xIndex;
+
+    vFakeKernelReset();
+
+    /* The pools of the previous test are not freed, the fake heap does not
+     * mind. */
+    for( xIndex = 0; xIndex < netbuffersCLASS_COUNT; xIndex++ )
+    {
+        xClasses[ xIndex ].ulAllocations = 0U;
+        xClasses[ xIndex ].ulSpills = 0U;
+        xClasses[ xIndex ].ulRequestedBytes = 0U;
+    }
+
+    ulFailures = 0U;
+    xNetworkBufferSemaphore = NULL;
+    xReleaseSemaphore = NULL;
+    uxReleaseWaiters = 0U;
+    ulBufferFailures = 0U;
+    ulRandom = 1U;
+
+    TEST_CHECK_EQUAL( pdPASS, xNetworkBuffersInitialise() );
+}
+/*-----------------------------------------------------------*/
+
+/* The next frame size of a mix, drawn with the weights of the mix. */
+static size_t prvNextSize( const TestMix_t * pxMix )
+{
+    uint32_t ulTotal = 0U;
+    uint32_t ulPick;
+    size_t x;
+
+    for( x = 0; x < pxMix->uxSizeCount; x++ )
+    {
+        ulTotal += pxMix->pxSizes[ x ].ulCount;
+    }
+
+    ulRandom = ( ulRandom * 1103515245U ) + 12345U;
+    ulPick = ( ulRandom >> 8 ) % ulTotal;
+
+    for( x = 0; x < pxMix->uxSizeCount; x++ )
+    {
+        if( ulPick < pxMix->pxSizes[ x ].ulCount )
+        {
+            break;
+        }
+
+        ulPick -= pxMix->pxSizes[ x ].ulCount;
+    }
+
+    return pxMix->pxSizes[ x ].uxSize;
+}
+/*-----------------------------------------------------------*/
+
+/* The share of the handed out bytes that the requests did not use, in
+ * percent, as vNetBuffersReport() logs it. */
+static uint32_t prvUnused( const NetBuffersStats_t * pxStats )
+{
+    uint64_t ullRequested = 0U;
+    uint64_t ullHandedOut = 0U;
+    BaseType_t xIndex;
+
+    for( xIndex = 0; xIndex < netbuffersCLASS_COUNT; xIndex++ )
+    {
+        ullRequested += pxStats->xClasses[ xIndex ].ulRequestedBytes;
+        ullHandedOut += ( uint64_t ) pxStats->xClasses[ xIndex ].ulAllocations * pxStats->xClasses[ xIndex ].uxSize;
+    }
+
+    return 100U - ( uint32_t ) ( ( ullRequested * 100U ) / ullHandedOut );
+}
+/*-----------------------------------------------------------*/
+
+static void test_classes( void )
+{
+    static const size_t uxRequests[] = { 1U, 128U, 129U, 512U, 513U, 1536U };
+    static const size_t uxClass[] = { 0U, 0U, 1U, 1U, 2U, 2U };
+    NetBuffersStats_t xStats;
+    uint8_t * pucBuffer;
+    size_t uxSize;
+    size_t x;
+
+    prvSetUp();
+
+    for( x = 0; x < sizeof( uxRequests ) / sizeof( uxRequests[ 0 ] ); x++ )
+    {
+        uxSize = uxRequests[ x ];
+        pucBuffer = pucGetNetworkBuffer( &uxSize );
+        TEST_CHECK( pucBuffer != NULL );
+        TEST_CHECK( prvClassOf( pucBuffer ) == &( xClasses[ uxClass[ x ] ] ) );
+
+        /* Rounded to words, the block starts on a cache line. */
+        TEST_CHECK_EQUAL( ( uxRequests[ x ] + 7U ) & ~( size_t ) 7U, uxSize );
+        TEST_CHECK_EQUAL( 0, ( ( uintptr_t ) ( pucBuffer - ipBUFFER_PADDING ) ) % netbuffersALIGNMENT );
+
+        memset( pucBuffer, 0xA5, uxRequests[ x ] );
+        vReleaseNetworkBuffer( pucBuffer );
+    }
+
+    /* Nothing holds more than a frame. */
+    uxSize = configNET_BUFFERS_LARGE_SIZE + 1U;
+    TEST_CHECK( pucGetNetworkBuffer( &uxSize ) == NULL );
+
+    vNetBuffersGetStats( &xStats, pdTRUE );
+    TEST_CHECK_EQUAL( 2, xStats.xClasses[ 0 ].ulAllocations );
+    TEST_CHECK_EQUAL( 129, xStats.xClasses[ 0 ].ulRequestedBytes );
+    TEST_CHECK_EQUAL( 2, xStats.xClasses[ 1 ].ulAllocations );
+    TEST_CHECK_EQUAL( 2, xStats.xClasses[ 2 ].ulAllocations );
+    TEST_CHECK_EQUAL( 0, xStats.xClasses[ 2 ].ulSpills );
+    TEST_CHECK_EQUAL( 1, xStats.ulFailures );
+
+    for( x = 0; x < netbuffersCLASS_COUNT; x++ )
+    {
+        TEST_CHECK_EQUAL( xStats.xClasses[ x ].uxCount, xStats.xClasses[ x ].uxFree );
+    }
+
+    /* The reset cleared the counters. */
+    vNetBuffersGetStats( &xStats, pdFALSE );
+    TEST_CHECK_EQUAL( 0, xStats.xClasses[ 0 ].ulAllocations );
+    TEST_CHECK_EQUAL( 0, xStats.ulFailures );
+}
+/*-----------------------------------------------------------*/
+
+static void test_spill( void )
+{
+    static uint8_t * pucSmall[ configNET_BUFFERS_SMALL_COUNT ];
+    NetBuffersStats_t xStats;
+    uint8_t * pucBuffer;
+    size_t uxSize;
+    size_t x;
+
+    prvSetUp();
+
+    for( x = 0; x < configNET_BUFFERS_SMALL_COUNT; x++ )
+    {
+        uxSize = 60U;
+        pucSmall[ x ] = pucGetNetworkBuffer( &uxSize );
+        TEST_CHECK( pucSmall[ x ] != NULL );
+    }
+
+    /* The small class is empty, a medium block serves the ACK. */
+    uxSize = 60U;
+    pucBuffer = pucGetNetworkBuffer( &uxSize );
+    TEST_CHECK( prvClassOf( pucBuffer ) == &( xClasses[ 1 ] ) );
+
+    vNetBuffersGetStats( &xStats, pdFALSE );
+    TEST_CHECK_EQUAL( 0, xStats.xClasses[ 0 ].uxFree );
+    TEST_CHECK_EQUAL( 0, xStats.xClasses[ 0 ].uxMinimumFree );
+    TEST_CHECK_EQUAL( 1, xStats.xClasses[ 1 ].ulSpills );
+
+    /* A released block is the next one handed out. */
+    vReleaseNetworkBuffer( pucSmall[ 3 ] );
+    uxSize = 60U;
+    TEST_CHECK( pucGetNetworkBuffer( &uxSize ) == pucSmall[ 3 ] );
+}
+/*-----------------------------------------------------------*/
+
+static void test_descriptors( void )
+{
+    static NetworkBufferDescriptor_t * pxBuffers[ ipconfigNUM_NETWORK_BUFFER_DESCRIPTORS ];
+    NetworkBufferDescriptor_t * pxBuffer;
+    size_t x;
+
+    prvSetUp();
+
+    pxBuffer = pxGetNetworkBufferWithDescriptor( 60U, 0U );
+    TEST_CHECK( pxBuffer != NULL );
+    TEST_CHECK_EQUAL( 64, pxBuffer->xDataLength );
+
+    /* The stack finds the descriptor in front of the frame. */
+    TEST_CHECK( *( ( NetworkBufferDescriptor_t ** ) ( pxBuffer->pucEthernetBuffer - ipBUFFER_PADDING ) ) == pxBuffer );
+    TEST_CHECK_EQUAL( ipconfigNUM_NETWORK_BUFFER_DESCRIPTORS - 1, uxGetNumberOfFreeNetworkBuffers() );
+    vReleaseNetworkBufferAndDescriptor( pxBuffer );
+    TEST_CHECK_EQUAL( ipconfigNUM_NETWORK_BUFFER_DESCRIPTORS, uxGetNumberOfFreeNetworkBuffers() );
+
+    /* A descriptor without a payload, as the zero-copy driver takes them. */
+    pxBuffer = pxGetNetworkBufferWithDescriptor( 0U, 0U );
+    TEST_CHECK( pxBuffer->pucEthernetBuffer == NULL );
+    vReleaseNetworkBufferAndDescriptor( pxBuffer );
+
+    /* The descriptors run out before the blocks of the ACKs. */
+    for( x = 0; x < ipconfigNUM_NETWORK_BUFFER_DESCRIPTORS; x++ )
+    {
+        pxBuffers[ x ] = pxGetNetworkBufferWithDescriptor( 60U, 0U );
+        TEST_CHECK( pxBuffers[ x ] != NULL );
+    }
+
+    TEST_CHECK( pxGetNetworkBufferWithDescriptor( 60U, 10U ) == NULL );
+    TEST_CHECK_EQUAL( 10, xTaskGetTickCount() );
+    TEST_CHECK_EQUAL( 1, ulBufferFailures );
+    TEST_CHECK_EQUAL( 0, uxGetMinimumFreeNetworkBuffers() );
+
+    for( x = 0; x < ipconfigNUM_NETWORK_BUFFER_DESCRIPTORS; x++ )
+    {
+        vReleaseNetworkBufferAndDescriptor( pxBuffers[ x ] );
+    }
+
+    /* A full-size request that finds no block gives its descriptor back. */
+    for( x = 0; x < configNET_BUFFERS_LARGE_COUNT; x++ )
+    {
+        pxBuffers[ x ] = pxGetNetworkBufferWithDescriptor( 1514U, 0U );
+        TEST_CHECK( pxBuffers[ x ] != NULL );
+    }
+
+    TEST_CHECK( pxGetNetworkBufferWithDescriptor( 1514U, 0U ) == NULL );
+    TEST_CHECK_EQUAL( 2, ulBufferFailures );
+    TEST_CHECK_EQUAL( ipconfigNUM_NETWORK_BUFFER_DESCRIPTORS - configNET_BUFFERS_LARGE_COUNT, uxGetNumberOfFreeNetworkBuffers() );
+}
+/*-----------------------------------------------------------*/
+
+static void test_resize( void )
+{
+    NetworkBufferDescriptor_t * pxBuffer;
+    uint8_t * pucSmall;
+    size_t x;
+
+    prvSetUp();
+
+    pxBuffer = pxGetNetworkBufferWithDescriptor( 100U, 0U );
+    pucSmall = pxBuffer->pucEthernetBuffer;
+
+    for( x = 0; x < 100U; x++ )
+    {
+        pucSmall[ x ] = ( uint8_t ) x;
+    }
+
+    pucSmall[ -1 ] = ipTYPE_IPv6;
+
+    /* It still fits. */
+    TEST_CHECK( pxResizeNetworkBufferWithDescriptor( pxBuffer, 120U ) == pxBuffer );
+    TEST_CHECK( pxBuffer->pucEthernetBuffer == pucSmall );
+    TEST_CHECK_EQUAL( 120, pxBuffer->xDataLength );
+
+    /* To a large block, with the data and the padding. */
+    pxBuffer->xDataLength = 100U;
+    TEST_CHECK( pxResizeNetworkBufferWithDescriptor( pxBuffer, 1000U ) == pxBuffer );
+    TEST_CHECK( prvClassOf( pxBuffer->pucEthernetBuffer ) == &( xClasses[ 2 ] ) );
+    TEST_CHECK_EQUAL( 1000, pxBuffer->xDataLength );
+    TEST_CHECK_EQUAL( ipTYPE_IPv6, pxBuffer->pucEthernetBuffer[ -1 ] );
+
+    for( x = 0; x < 100U; x++ )
+    {
+        TEST_CHECK_EQUAL( x, pxBuffer->pucEthernetBuffer[ x ] );
+    }
+
+    TEST_CHECK_EQUAL( configNET_BUFFERS_SMALL_COUNT, xClasses[ 0 ].ulFree );
+
+    /* Too large: the caller keeps the buffer. */
+    TEST_CHECK( pxResizeNetworkBufferWithDescriptor( pxBuffer, 2000U ) == NULL );
+    vReleaseNetworkBufferAndDescriptor( pxBuffer );
+    TEST_CHECK_EQUAL( configNET_BUFFERS_LARGE_COUNT, xClasses[ 2 ].ulFree );
+}
+/*-----------------------------------------------------------*/
+
+static NetworkBufferDescriptor_t * pxReleaseAtTick = NULL;
+
+static void prvReleaseAtTick( void )
+{
+    if( ( xTaskGetTickCount() == 5U ) && ( pxReleaseAtTick != NULL ) )
+    {
+        vReleaseNetworkBufferAndDescriptor( pxReleaseAtTick );
+        pxReleaseAtTick = NULL;
+    }
+}
+/*-----------------------------------------------------------*/
+
+static void test_wait_release( void )
+{
+    NetworkBufferDescriptor_t * pxBuffer;
+
+    prvSetUp();
+
+    TEST_CHECK_EQUAL( pdFALSE, xNetBuffersWaitRelease( 3U ) );
+    TEST_CHECK_EQUAL( 3, xTaskGetTickCount() );
+
+    /* Another task releases a buffer while this one waits. */
+    pxReleaseAtTick = pxGetNetworkBufferWithDescriptor( 67U, 0U );
+    vFakeKernelSetTickHook( prvReleaseAtTick );
+    TEST_CHECK_EQUAL( pdTRUE, xNetBuffersWaitRelease( 100U ) );
+    TEST_CHECK_EQUAL( 5, xTaskGetTickCount() );
+    TEST_CHECK_EQUAL( 0, uxReleaseWaiters );
+
+    /* Without a waiter a release does not leave a token behind. */
+    pxBuffer = pxGetNetworkBufferWithDescriptor( 67U, 0U );
+    vReleaseNetworkBufferAndDescriptor( pxBuffer );
+    TEST_CHECK_EQUAL( pdFALSE, xNetBuffersWaitRelease( 0U ) );
+}
+/*-----------------------------------------------------------*/
+
+/* For each mix: the share of the handed out bytes that is unused, against
+ * full-size buffers for every frame, and how many frames can be in flight
+ * in the RAM of the pools, against as many full-size buffers as fit in it.
+ * The throughput is printed only, it depends on the host. */
+static void test_mixes( void )
+{
+    static uint8_t * pucInFlight[ configNET_BUFFERS_SMALL_COUNT + configNET_BUFFERS_MEDIUM_COUNT + configNET_BUFFERS_LARGE_COUNT ];
+    NetBuffersStats_t xStats;
+    const TestMix_t * pxMix;
+    uint64_t ullRequested;
+    uint32_t ulFullSizeUnused;
+    uint32_t ulUnused;
+    size_t uxCount;
+    size_t uxSize;
+    size_t x;
+    size_t y;
+    struct timespec xStart;
+    struct timespec xEnd;
+    double dSeconds;
+
+    printf( "  %-12s %8s %8s %9s %9s %12s\n", "mix", "unused", "(full)", "in flight", "(full)", "allocs/s" );
+
+    for( x = 0; x < sizeof( xMixes ) / sizeof( xMixes[ 0 ] ); x++ )
+    {
+        pxMix = &( xMixes[ x ] );
+        prvSetUp();
+
+        /* Fragmentation, over 10000 frames. */
+        ullRequested = 0U;
+
+        for( y = 0; y < 10000U; y++ )
+        {
+            uxSize = prvNextSize( pxMix );
+            ullRequested += uxSize;
+            pucInFlight[ 0 ] = pucGetNetworkBuffer( &uxSize );
+            vReleaseNetworkBuffer( pucInFlight[ 0 ] );
+        }
+
+        vNetBuffersGetStats( &xStats, pdTRUE );
+        ulUnused = prvUnused( &xStats );
+        ulFullSizeUnused = 100U - ( uint32_t ) ( ( ullRequested * 100U ) / ( 10000U * ( uint64_t ) configNET_BUFFERS_LARGE_SIZE ) );
+
+        /* Every frame had a block of its own class. */
+        TEST_CHECK_EQUAL( 0, xStats.xClasses[ 1 ].ulSpills + xStats.xClasses[ 2 ].ulSpills );
+        TEST_CHECK( ulUnused <= ulFullSizeUnused );
+
+        /* Frames in flight, until the classes that fit are empty. */
+        for( uxCount = 0; uxCount < sizeof( pucInFlight ) / sizeof( pucInFlight[ 0 ] ); uxCount++ )
+        {
+            uxSize = prvNextSize( pxMix );
+            pucInFlight[ uxCount ] = pucGetNetworkBuffer( &uxSize );
+
+            if( pucInFlight[ uxCount ] == NULL )
+            {
+                break;
+            }
+        }
+
+        for( y = 0; y < uxCount; y++ )
+        {
+            vReleaseNetworkBuffer( pucInFlight[ y ] );
+        }
+
+        TEST_CHECK( uxCount >= configNET_BUFFERS_LARGE_COUNT );
+
+        /* Throughput, with testIN_FLIGHT frames held. */
+        for( y = 0; y < testIN_FLIGHT; y++ )
+        {
+            uxSize = prvNextSize( pxMix );
+            pucInFlight[ y ] = pucGetNetworkBuffer( &uxSize );
+        }
+
+        clock_gettime( CLOCK_MONOTONIC, &xStart );
+
+        for( y = 0; y < testROUNDS; y++ )
+        {
+            vReleaseNetworkBuffer( pucInFlight[ y % testIN_FLIGHT ] );
+            uxSize = prvNextSize( pxMix );
+            pucInFlight[ y % testIN_FLIGHT ] = pucGetNetworkBuffer( &uxSize );
+            TEST_CHECK( pucInFlight[ y % testIN_FLIGHT ] != NULL );
+        }
+
+        clock_gettime( CLOCK_MONOTONIC, &xEnd );
+        dSeconds = ( double ) ( xEnd.tv_sec - xStart.tv_sec ) + ( ( double ) ( xEnd.tv_nsec - xStart.tv_nsec ) / 1e9 );
+
+        printf( "  %-12s %7u%% %7u%% %9u %9u %12.0f\n",
+                pxMix->pcName,
+                ( unsigned ) ulUnused,
+                ( unsigned ) ulFullSizeUnused,
+                ( unsigned ) uxCount,
+                ( unsigned ) testFULL_SIZE_BLOCKS,
+                ( double ) testROUNDS / dSeconds );
+
+        if( pxMix->pxSizes == xBulkSend )
+        {
+            /* Mostly full-size frames: the large class is the limit, and the
+             * RAM of the small classes would have held a few more. */
+            TEST_CHECK( uxCount < testFULL_SIZE_BLOCKS );
+        }
+        else
+        {
+            /* Small frames: at least twice as many in flight. */
+            TEST_CHECK( uxCount >= 2U * testFULL_SIZE_BLOCKS );
+            TEST_CHECK( ulUnused < ulFullSizeUnused );
+        }
+    }
+}
+/*-----------------------------------------------------------*/
+
+int main( void )
+{
+    TEST_RUN( test_classes );
+    TEST_RUN( test_spill );
+    TEST_RUN( test_descriptors );
+    TEST_RUN( test_resize );
+    TEST_RUN( test_wait_release );
+    TEST_RUN( test_mixes );
+
+    return 0;
+}
+/*-----------------------------------------------------------*/
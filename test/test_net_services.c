@@ -0,0 +1,283 @@
+/* Included, so that the tables can be emptied between the tests. */
+#include "net_services.c"
+
+/* Standard includes. */
+#include <string.h>
+
+#include "fake_kernel.h"
+#include "test.h"
+
+/* The end-points of the script. */
+#define testIPv4          0U
+#define testLINK_LOCAL    1U
+#define testGLOBAL        2U
+#define testIPv4_B        3U
+#define testLEGACY        4U   /* NULL, the backward compatible API. */
+
+#define testSERVICES      4U
+
+/* One network event of a script, and the states of the services after it:
+ * 'W' waiting, 'R' running, 'P' paused, one letter per service. */
+typedef struct xTEST_STEP
+{
+    uint32_t ulAtMs;
+    eIPCallbackEvent_t eEvent;
+    size_t uxEndPoint;
+    const char * pcStates;
+} TestStep_t;
+
+static NetworkEndPoint_t xEndPoints[ 4 ];
+static NetService_t xServices[ testSERVICES ];
+static uint32_t ulStarts[ testSERVICES ];
+static uint32_t ulPauses[ testSERVICES ];
+
+/*-----------------------------------------------------------*/
+
+static void prvStart( NetService_t * pxService )
+{
+    ulStarts[ pxService - xServices ]++;
+}
+/*-----------------------------------------------------------*/
+
+static void prvPause( NetService_t * pxService )
+{
+    ulPauses[ pxService - xServices ]++;
+}
+/*-----------------------------------------------------------*/
+
+static void prvSetUp( void )
+{
+    static const uint8_t ucGlobal[ 2 ] = { 0x20U, 0x01U };
+    static const uint8_t ucLinkLocal[ 2 ] = { 0xFEU, 0x80U };
+    static const char * const pcNames[ testSERVICES ] = { "ipv4", "global", "dual", "link-local" };
+    static const UBaseType_t uxNeeds[ testSERVICES ] =
+    {
+        netsvcNEEDS_IPv4,
+        netsvcNEEDS_IPv6_GLOBAL,
+        netsvcNEEDS_IPv4 | netsvcNEEDS_IPv6,
+        netsvcNEEDS_ENDPOINT
+    };
+    size_t x;
+
+    vFakeKernelReset();
+
+    /* The state of net_services.c. */
+    memset( pxServices, 0, sizeof( pxServices ) );
+    xServiceCount = 0;
+    memset( pxUpEndPoints, 0, sizeof( pxUpEndPoints ) );
+    xLegacyIPv4Up = pdFALSE;
+    memset( xReady, 0, sizeof( xReady ) );
+
+    memset( xEndPoints, 0, sizeof( xEndPoints ) );
+    xEndPoints[ testIPv4 ].ipv4_settings.ulIPAddress = FreeRTOS_inet_addr_quick( 192, 168, 1, 10 );
+    xEndPoints[ testIPv4_B ].ipv4_settings.ulIPAddress = FreeRTOS_inet_addr_quick( 10, 0, 0, 10 );
+    xEndPoints[ testLINK_LOCAL ].bits.bIPv6 = pdTRUE_UNSIGNED;
+    memcpy( xEndPoints[ testLINK_LOCAL ].ipv6_settings.xIPAddress.ucBytes, ucLinkLocal, sizeof( ucLinkLocal ) );
+    xEndPoints[ testGLOBAL ].bits.bIPv6 = pdTRUE_UNSIGNED;
+    memcpy( xEndPoints[ testGLOBAL ].ipv6_settings.xIPAddress.ucBytes, ucGlobal, sizeof( ucGlobal ) );
+
+    memset( xServices, 0, sizeof( xServices ) );
+    memset( ulStarts, 0, sizeof( ulStarts ) );
+    memset( ulPauses, 0, sizeof( ulPauses ) );
+
+    for( x = 0U; x < testSERVICES; x++ )
+    {
+        xServices[ x ].pcName = pcNames[ x ];
+        xServices[ x ].uxNeeds = uxNeeds[ x ];
+        xServices[ x ].fnStart = prvStart;
+        xServices[ x ].fnPause = prvPause;
+        TEST_CHECK_EQUAL( pdPASS, xNetServicesRegister( &( xServices[ x ] ) ) );
+    }
+
+    xServices[ 3 ].pxEndPoint = &( xEndPoints[ testLINK_LOCAL ] );
+}
+/*-----------------------------------------------------------*/
+
+static void prvCheckStates( const char * pcStates,
+                            size_t uxStep )
+{
+    static const char cLetters[] = { 'W', 'R', 'P' };
+    size_t x;
+
+    for( x = 0U; x < testSERVICES; x++ )
+    {
+        if( cLetters[ xServices[ x ].eState ] != pcStates[ x ] )
+        {
+            fprintf( stderr, "step %u: service %s is %c, expected %c\n",
+                     ( unsigned ) uxStep, xServices[ x ].pcName, cLetters[ xServices[ x ].eState ], pcStates[ x ] );
+        }
+
+        TEST_CHECK( cLetters[ xServices[ x ].eState ] == pcStates[ x ] );
+    }
+}
+/*-----------------------------------------------------------*/
+
+/* Play the events at their time, and check the states after each. */
+static void prvRunScript( const TestStep_t * pxSteps,
+                          size_t uxCount )
+{
+    size_t x;
+    TickType_t xAt;
+
+    for( x = 0U; x < uxCount; x++ )
+    {
+        xAt = pdMS_TO_TICKS( pxSteps[ x ].ulAtMs );
+        TEST_CHECK( xAt >= xTaskGetTickCount() );
+        vFakeKernelAdvance( xAt - xTaskGetTickCount() );
+
+        vNetServicesNetworkEvent( pxSteps[ x ].eEvent,
+                                  ( pxSteps[ x ].uxEndPoint == testLEGACY ) ? NULL : &( xEndPoints[ pxSteps[ x ].uxEndPoint ] ) );
+        prvCheckStates( pxSteps[ x ].pcStates, x );
+    }
+}
+/*-----------------------------------------------------------*/
+
+/* A LAN with IPv4 and link-local IPv6 only: the global address never comes,
+ * and the rest must not wait for it. */
+static void test_partial_network( void )
+{
+    static const TestStep_t xScript[] =
+    {
+        /* ms, event, end-point, ipv4 global dual link-local. */
+        { 300U,  eNetworkUp,   testLINK_LOCAL, "WWWR" },
+        { 1800U, eNetworkUp,   testIPv4,       "RWRR" },
+        { 5000U, eNetworkDown, testLINK_LOCAL, "RWPP" },
+        { 5200U, eNetworkUp,   testLINK_LOCAL, "RWRR" },
+    };
+
+    prvSetUp();
+    prvRunScript( xScript, sizeof( xScript ) / sizeof( xScript[ 0 ] ) );
+
+    TEST_CHECK_EQUAL( pdMS_TO_TICKS( 1800U ), xServices[ 0 ].xStartedAt );
+    TEST_CHECK_EQUAL( 0U, xServices[ 1 ].xStartedAt );
+    TEST_CHECK_EQUAL( pdMS_TO_TICKS( 1800U ), xServices[ 2 ].xStartedAt );
+
+    /* Paused and resumed, the first start stays the one recorded. */
+    TEST_CHECK_EQUAL( 2U, ulStarts[ 3 ] );
+    TEST_CHECK_EQUAL( 1U, ulPauses[ 3 ] );
+    TEST_CHECK_EQUAL( 2U, xServices[ 3 ].ulStartCount );
+    TEST_CHECK_EQUAL( pdMS_TO_TICKS( 300U ), xServices[ 3 ].xStartedAt );
+
+    /* The end-points in the order they were first up. */
+    TEST_CHECK( xReady[ 0 ].pxEndPoint == &( xEndPoints[ testLINK_LOCAL ] ) );
+    TEST_CHECK_EQUAL( pdMS_TO_TICKS( 300U ), xReady[ 0 ].xReadyAt );
+    TEST_CHECK( xReady[ 1 ].pxEndPoint == &( xEndPoints[ testIPv4 ] ) );
+    TEST_CHECK_EQUAL( pdMS_TO_TICKS( 1800U ), xReady[ 1 ].xReadyAt );
+    TEST_CHECK( xReady[ 2 ].pxEndPoint == NULL );
+}
+/*-----------------------------------------------------------*/
+
+/* A link that flaps, with two IPv4 end-points: a service stays up while any
+ * end-point of its kind is, and repeated events change nothing. */
+static void test_flapping_link( void )
+{
+    static const TestStep_t xScript[] =
+    {
+        { 1000U, eNetworkUp,   testIPv4,       "RWWW" },
+        { 1000U, eNetworkUp,   testIPv4,       "RWWW" },
+        { 1100U, eNetworkUp,   testIPv4_B,     "RWWW" },
+        { 1200U, eNetworkUp,   testGLOBAL,     "RRRW" },
+        { 2000U, eNetworkDown, testIPv4,       "RRRW" },
+        { 2100U, eNetworkDown, testIPv4_B,     "PRPW" },
+        { 2100U, eNetworkDown, testIPv4_B,     "PRPW" },
+        { 2200U, eNetworkDown, testGLOBAL,     "PPPW" },
+        { 2300U, eNetworkDown, testLINK_LOCAL, "PPPW" },
+        { 3000U, eNetworkUp,   testIPv4_B,     "RPPW" },
+        { 3500U, eNetworkUp,   testLINK_LOCAL, "RPRR" },
+        { 4000U, eNetworkUp,   testGLOBAL,     "RRRR" },
+    };
+
+    prvSetUp();
+    prvRunScript( xScript, sizeof( xScript ) / sizeof( xScript[ 0 ] ) );
+
+    TEST_CHECK_EQUAL( 2U, ulStarts[ 0 ] );
+    TEST_CHECK_EQUAL( 1U, ulPauses[ 0 ] );
+    TEST_CHECK_EQUAL( 2U, ulStarts[ 1 ] );
+    TEST_CHECK_EQUAL( 1U, ulPauses[ 1 ] );
+    TEST_CHECK_EQUAL( 2U, ulStarts[ 2 ] );
+    TEST_CHECK_EQUAL( 1U, ulStarts[ 3 ] );
+    TEST_CHECK_EQUAL( 0U, ulPauses[ 3 ] );
+    TEST_CHECK_EQUAL( pdMS_TO_TICKS( 1000U ), xServices[ 0 ].xStartedAt );
+    TEST_CHECK_EQUAL( pdMS_TO_TICKS( 3500U ), xServices[ 3 ].xStartedAt );
+
+    /* Only the first time up of an end-point counts. */
+    TEST_CHECK( xReady[ 0 ].pxEndPoint == &( xEndPoints[ testIPv4 ] ) );
+    TEST_CHECK_EQUAL( pdMS_TO_TICKS( 1000U ), xReady[ 0 ].xReadyAt );
+    TEST_CHECK( xReady[ 2 ].pxEndPoint == &( xEndPoints[ testGLOBAL ] ) );
+    TEST_CHECK_EQUAL( pdMS_TO_TICKS( 1200U ), xReady[ 2 ].xReadyAt );
+}
+/*-----------------------------------------------------------*/
+
+/* The backward compatible API only tells about its one IPv4 interface. */
+static void test_legacy_events( void )
+{
+    static const TestStep_t xScript[] =
+    {
+        { 500U, eNetworkUp,   testLEGACY,     "RWWW" },
+        { 600U, eNetworkUp,   testGLOBAL,     "RRRW" },
+        { 700U, eNetworkDown, testLEGACY,     "PRPW" },
+        { 800U, eNetworkUp,   testLEGACY,     "RRRW" },
+    };
+
+    prvSetUp();
+    prvRunScript( xScript, sizeof( xScript ) / sizeof( xScript[ 0 ] ) );
+
+    TEST_CHECK_EQUAL( 2U, ulStarts[ 0 ] );
+    TEST_CHECK_EQUAL( 1U, ulPauses[ 0 ] );
+
+    /* No end-point to record. */
+    TEST_CHECK( xReady[ 0 ].pxEndPoint == &( xEndPoints[ testGLOBAL ] ) );
+    TEST_CHECK( xReady[ 1 ].pxEndPoint == NULL );
+}
+/*-----------------------------------------------------------*/
+
+static void test_first_packet( void )
+{
+    prvSetUp();
+
+    /* At tick 0, which is kept apart from "not yet". */
+    vNetServicesFirstPacket( "ipv4" );
+    TEST_CHECK_EQUAL( 1U, xServices[ 0 ].xFirstPacketAt );
+
+    vFakeKernelAdvance( 100U );
+    vNetServicesFirstPacket( "ipv4" );
+    vNetServicesFirstPacket( "dual" );
+    vNetServicesFirstPacket( "unknown" );
+    TEST_CHECK_EQUAL( 1U, xServices[ 0 ].xFirstPacketAt );
+    TEST_CHECK_EQUAL( 100U, xServices[ 2 ].xFirstPacketAt );
+    TEST_CHECK_EQUAL( 0U, xServices[ 1 ].xFirstPacketAt );
+}
+/*-----------------------------------------------------------*/
+
+static void test_full_table( void )
+{
+    NetService_t xExtra[ configNET_SERVICES_MAX ];
+    size_t x;
+
+    prvSetUp();
+    memset( xExtra, 0, sizeof( xExtra ) );
+
+    for( x = 0U; x < ( configNET_SERVICES_MAX - testSERVICES ); x++ )
+    {
+        xExtra[ x ].pcName = "extra";
+        xExtra[ x ].fnStart = prvStart;
+        TEST_CHECK_EQUAL( pdPASS, xNetServicesRegister( &( xExtra[ x ] ) ) );
+    }
+
+    xExtra[ x ].pcName = "one too many";
+    xExtra[ x ].fnStart = prvStart;
+    TEST_CHECK_EQUAL( pdFAIL, xNetServicesRegister( &( xExtra[ x ] ) ) );
+}
+/*-----------------------------------------------------------*/
+
+int main( void )
+{
+    TEST_RUN( test_partial_network );
+    TEST_RUN( test_flapping_link );
+    TEST_RUN( test_legacy_events );
+    TEST_RUN( test_first_packet );
+    TEST_RUN( test_full_table );
+
+    return 0;
+}
+/*-----------------------------------------------------------*/
@@ -0,0 +1,265 @@
+/* Included, so that the samples can be taken without the task. */
+#include "net_stats.c"
+
+/* Standard includes. */
+#include <stdio.h>
+#include <string.h>
+
+#include "fake_kernel.h"
+#include "test.h"
+
+/*
+ * A model of the single FIFO in front of the IP-task, under a mixed load:
+ * bursts of received bulk frames, and a latency-sensitive event (a TCP ACK
+ * or a small UDP send) every few ticks.  The IP-task handles a fixed number
+ * of events per tick.  The test measures how long the urgent events wait
+ * behind the bulk frames, and checks that the event queue gauge of net_stats
+ * tells that delay.
+ */
+
+/* Received frames in a burst, each one holds a network buffer until the
+ * IP-task takes it.  The period does not divide the sample period, so the
+ * samples see every phase of a burst. */
+#define testBURST_FRAMES       48U
+#define testBURST_PERIOD       37U
+
+/* Ticks between two urgent events. */
+#define testURGENT_PERIOD      3U
+
+#define testRUN_TICKS          20000U
+
+typedef struct xTEST_EVENT
+{
+    BaseType_t xUrgent;
+    TickType_t xPosted;
+} TestEvent_t;
+
+typedef struct xTEST_RESULT
+{
+    UBaseType_t uxPeakDepth;       /* The real peak, right after the arrivals. */
+    uint32_t ulUrgent;
+    uint32_t ulWorstLatency;       /* In ticks. */
+    uint32_t ulTotalLatency;
+    NetStats_t xStats;
+} TestResult_t;
+
+QueueHandle_t xNetworkEventQueue = NULL;
+
+static UBaseType_t uxServiceRate;
+static UBaseType_t uxMinimumSpace;
+static UBaseType_t uxBulkWaiting;
+static UBaseType_t uxMinimumFree;
+static TestResult_t xResult;
+
+/*-----------------------------------------------------------*/
+
+UBaseType_t uxGetMinimumIPQueueSpace( void )
+{
+    return uxMinimumSpace;
+}
+/*-----------------------------------------------------------*/
+
+/* The RX ring holds a buffer in each descriptor, the bulk frames that wait
+ * for the IP-task hold one each. */
+UBaseType_t uxGetNumberOfFreeNetworkBuffers( void )
+{
+    return ipconfigNUM_NETWORK_BUFFER_DESCRIPTORS - ETH_RX_DESC_CNT - uxBulkWaiting;
+}
+/*-----------------------------------------------------------*/
+
+UBaseType_t uxGetMinimumFreeNetworkBuffers( void )
+{
+    return uxMinimumFree;
+}
+/*-----------------------------------------------------------*/
+
+void vNetBuffersReport( void )
+{
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xNetBuffersWaitRelease( TickType_t xTicksToWait )
+{
+    vFakeKernelAdvance( xTicksToWait );
+
+    return pdFALSE;
+}
+/*-----------------------------------------------------------*/
+
+void vApplicationNetStatsReportHook( void )
+{
+}
+/*-----------------------------------------------------------*/
+
+/* Post an event to the back of the queue, as xSendEventStructToIPTask()
+ * does, and keep the low-water marks as the stack keeps them. */
+static void prvPost( BaseType_t xUrgent )
+{
+    TestEvent_t xEvent = { xUrgent, xTaskGetTickCount() };
+    UBaseType_t uxSpace;
+    UBaseType_t uxFree;
+
+    TEST_CHECK_EQUAL( pdPASS, xQueueSendToBack( xNetworkEventQueue, &xEvent, 0U ) );
+
+    if( xUrgent == pdFALSE )
+    {
+        uxBulkWaiting++;
+    }
+
+    uxSpace = uxQueueSpacesAvailable( xNetworkEventQueue );
+    uxMinimumSpace = ( uxSpace < uxMinimumSpace ) ? uxSpace : uxMinimumSpace;
+    uxFree = uxGetNumberOfFreeNetworkBuffers();
+    uxMinimumFree = ( uxFree < uxMinimumFree ) ? uxFree : uxMinimumFree;
+}
+/*-----------------------------------------------------------*/
+
+/* One tick: the arrivals, then the IP-task, then a sample now and then. */
+static void prvTick( void )
+{
+    TickType_t xNow = xTaskGetTickCount();
+    TestEvent_t xEvent;
+    UBaseType_t uxDepth;
+    UBaseType_t x;
+    uint32_t ulLatency;
+
+    if( ( xNow % testBURST_PERIOD ) == 0U )
+    {
+        for( x = 0U; x < testBURST_FRAMES; x++ )
+        {
+            prvPost( pdFALSE );
+        }
+    }
+
+    if( ( xNow % testURGENT_PERIOD ) == 0U )
+    {
+        prvPost( pdTRUE );
+    }
+
+    uxDepth = uxQueueMessagesWaiting( xNetworkEventQueue );
+    xResult.uxPeakDepth = ( uxDepth > xResult.uxPeakDepth ) ? uxDepth : xResult.uxPeakDepth;
+
+    for( x = 0U; ( x < uxServiceRate ) && ( xQueueReceive( xNetworkEventQueue, &xEvent, 0U ) == pdPASS ); x++ )
+    {
+        if( xEvent.xUrgent != pdFALSE )
+        {
+            ulLatency = ( uint32_t ) ( xNow - xEvent.xPosted );
+            xResult.ulUrgent++;
+            xResult.ulTotalLatency += ulLatency;
+            xResult.ulWorstLatency = ( ulLatency > xResult.ulWorstLatency ) ? ulLatency : xResult.ulWorstLatency;
+        }
+        else
+        {
+            uxBulkWaiting--;
+        }
+    }
+
+    if( ( xNow % pdMS_TO_TICKS( configNET_STATS_SAMPLE_PERIOD_MS ) ) == 0U )
+    {
+        prvSample();
+    }
+}
+/*-----------------------------------------------------------*/
+
+static void prvRun( UBaseType_t uxRate )
+{
+    vFakeKernelReset();
+
+    xNetworkEventQueue = xQueueCreate( ipconfigEVENT_QUEUE_LENGTH, sizeof( TestEvent_t ) );
+    uxServiceRate = uxRate;
+    uxMinimumSpace = ipconfigEVENT_QUEUE_LENGTH;
+    uxBulkWaiting = 0U;
+    uxMinimumFree = uxGetNumberOfFreeNetworkBuffers();
+    memset( &xResult, 0, sizeof( xResult ) );
+
+    TEST_CHECK_EQUAL( pdPASS, xNetStatsInitialize( 512U, tskIDLE_PRIORITY ) );
+    TEST_CHECK( pxFakeKernelLastTask() == prvNetStatsTask );
+
+    vFakeKernelSetTickHook( prvTick );
+    vFakeKernelAdvance( testRUN_TICKS );
+    vFakeKernelSetTickHook( NULL );
+
+    vNetStatsGet( &( xResult.xStats ) );
+    vQueueDelete( xNetworkEventQueue );
+    xNetworkEventQueue = NULL;
+
+    printf( "%2u events/tick: queue max %u, avg %u.%02u, urgent wait max %u ticks, mean %u.%02u\n",
+            ( unsigned ) uxRate,
+            ( unsigned ) xResult.xStats.xEventQueue.uxHighWater,
+            ( unsigned ) ( xResult.xStats.xEventQueue.ulAverage / netstatsFIXED_ONE ),
+            ( unsigned ) ( ( ( xResult.xStats.xEventQueue.ulAverage % netstatsFIXED_ONE ) * 100U ) / netstatsFIXED_ONE ),
+            ( unsigned ) xResult.ulWorstLatency,
+            ( unsigned ) ( xResult.ulTotalLatency / xResult.ulUrgent ),
+            ( unsigned ) ( ( ( xResult.ulTotalLatency % xResult.ulUrgent ) * 100U ) / xResult.ulUrgent ) );
+}
+/*-----------------------------------------------------------*/
+
+/* The worst wait of an event behind uxDepth events, in whole ticks. */
+static uint32_t prvPredictedWait( UBaseType_t uxDepth,
+                                  UBaseType_t uxRate )
+{
+    return ( uint32_t ) ( ( uxDepth + uxRate - 1U ) / uxRate ) - 1U;
+}
+/*-----------------------------------------------------------*/
+
+static void test_head_of_line( void )
+{
+    prvRun( 8U );
+
+    TEST_CHECK_EQUAL( testRUN_TICKS / configNET_STATS_SAMPLE_PERIOD_MS, xResult.xStats.ulSamples );
+    TEST_CHECK_EQUAL( testRUN_TICKS / testURGENT_PERIOD, xResult.ulUrgent );
+
+    /* Samples at 100 ms see a burst only by chance.  The high-water mark
+     * comes from the low-water mark of the stack, and is the real peak: a
+     * whole burst with an urgent event behind it. */
+    TEST_CHECK_EQUAL( testBURST_FRAMES + 1U, xResult.uxPeakDepth );
+    TEST_CHECK_EQUAL( xResult.uxPeakDepth, xResult.xStats.xEventQueue.uxHighWater );
+
+    /* That urgent event waits for the whole burst.  So the worst head-of-line
+     * delay is the high-water mark over the rate of the IP-task. */
+    TEST_CHECK_EQUAL( prvPredictedWait( xResult.xStats.xEventQueue.uxHighWater, 8U ), xResult.ulWorstLatency );
+    TEST_CHECK_EQUAL( 6, xResult.ulWorstLatency );
+
+    /* The queue does not stand, it fills in bursts: the average is far below
+     * the peak. */
+    TEST_CHECK( ( xResult.xStats.xEventQueue.ulAverage * 4U ) < ( xResult.xStats.xEventQueue.uxHighWater * netstatsFIXED_ONE ) );
+
+    /* Each bulk frame in the queue holds a buffer. */
+    TEST_CHECK_EQUAL( ETH_RX_DESC_CNT + testBURST_FRAMES, xResult.xStats.xBuffers.uxHighWater );
+    TEST_CHECK_EQUAL( 0, xResult.xStats.ulBufferFailures );
+}
+/*-----------------------------------------------------------*/
+
+static void test_faster_ip_task( void )
+{
+    uint32_t ulSlowWorst;
+    uint32_t ulSlowTotal;
+
+    prvRun( 8U );
+    ulSlowWorst = xResult.ulWorstLatency;
+    ulSlowTotal = xResult.ulTotalLatency;
+
+    /* An IP-task that gets twice the CPU time, by its priority over the EMAC
+     * task.  The bursts are as large, but the wait behind them halves. */
+    prvRun( 16U );
+
+    TEST_CHECK_EQUAL( testBURST_FRAMES + 1U, xResult.xStats.xEventQueue.uxHighWater );
+    TEST_CHECK_EQUAL( prvPredictedWait( xResult.xStats.xEventQueue.uxHighWater, 16U ), xResult.ulWorstLatency );
+    TEST_CHECK( ( xResult.ulWorstLatency * 2U ) <= ulSlowWorst );
+    TEST_CHECK( ( xResult.ulTotalLatency * 2U ) <= ulSlowTotal );
+
+    /* An IP-task that keeps up with every event in the tick it arrives. */
+    prvRun( testBURST_FRAMES + 1U );
+
+    TEST_CHECK_EQUAL( 0, xResult.ulWorstLatency );
+    TEST_CHECK_EQUAL( 0, prvPredictedWait( xResult.xStats.xEventQueue.uxHighWater, testBURST_FRAMES + 1U ) );
+}
+/*-----------------------------------------------------------*/
+
+int main( void )
+{
+    TEST_RUN( test_head_of_line );
+    TEST_RUN( test_faster_ip_task );
+
+    return 0;
+}
+/*-----------------------------------------------------------*/
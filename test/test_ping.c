@@ -0,0 +1,456 @@
+/* Included, so that the targets and requests can be cleared between tests,
+ * and the task can be run one round at a time. */
+#include "ping.c"
+#include "uptime.c"
+
+/* Standard includes. */
+#include <arpa/inet.h>
+#include <string.h>
+
+#include "fake_kernel.h"
+#include "test.h"
+
+/* SysTick of a 480 MHz core, ticking at 1 kHz. */
+#define testSYSTICK_LOAD        ( ( 480000000UL / configTICK_RATE_HZ ) - 1UL )
+
+#define testMAX_RESPONDERS      8U
+#define testMAX_PENDING         64U
+
+/* A host on the other side of the loopback.  It answers every request after
+ * the next of its round trip times, unless it is down. */
+typedef struct xTEST_RESPONDER
+{
+    const char * pcAddress;
+    BaseType_t xIPv6;
+    IP_Address_t xAddress;
+    const uint32_t * pulRoundTripUs;  /* Used in turn. */
+    size_t uxRoundTrips;
+    size_t uxNext;
+    BaseType_t xDown;
+    BaseType_t xNoRoute;
+    BaseType_t xNoBuffer;
+    ePingReplyStatus_t eStatus;
+    uint32_t ulRequests;
+} TestResponder_t;
+
+/* A reply on its way back. */
+typedef struct xTEST_PENDING
+{
+    uint16_t usSequence;
+    uint32_t ulDueUs;
+    ePingReplyStatus_t eStatus;
+} TestPending_t;
+
+static TestResponder_t xResponders[ testMAX_RESPONDERS ];
+static size_t uxResponderCount = 0U;
+
+static TestPending_t xPending[ testMAX_PENDING ];
+static size_t uxPendingCount = 0U;
+
+/* The counters of the stack, one per IP type. */
+static uint16_t usStackSequence[ 2 ];
+
+/*-----------------------------------------------------------*/
+
+BaseType_t FreeRTOS_inet_pton( BaseType_t xAddressFamily,
+                               const char * pcSource,
+                               void * pvDestination )
+{
+    int iFamily = ( xAddressFamily == FREERTOS_AF_INET6 ) ? AF_INET6 : AF_INET;
+
+    return ( inet_pton( iFamily, pcSource, pvDestination ) == 1 ) ? pdPASS : pdFAIL;
+}
+/*-----------------------------------------------------------*/
+
+static TestResponder_t * prvFindResponder( BaseType_t xIPv6,
+                                           const void * pvAddress )
+{
+    TestResponder_t * pxReturn = NULL;
+    size_t x;
+
+    for( x = 0; x < uxResponderCount; x++ )
+    {
+        if( ( xResponders[ x ].xIPv6 == xIPv6 ) &&
+            ( memcmp( &( xResponders[ x ].xAddress ), pvAddress, ( xIPv6 != pdFALSE ) ? 16U : 4U ) == 0 ) )
+        {
+            pxReturn = &( xResponders[ x ] );
+        }
+    }
+
+    return pxReturn;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xRouteCacheLookup( const struct freertos_sockaddr * pxDestination,
+                              Route_t * pxRoute )
+{
+    BaseType_t xIPv6 = ( pxDestination->sin_family == FREERTOS_AF_INET6 ) ? pdTRUE : pdFALSE;
+    TestResponder_t * pxResponder = prvFindResponder( xIPv6, &( pxDestination->sin_address ) );
+
+    memset( pxRoute, 0, sizeof( *pxRoute ) );
+
+    return ( ( pxResponder != NULL ) && ( pxResponder->xNoRoute == pdFALSE ) ) ? pdPASS : pdFAIL;
+}
+/*-----------------------------------------------------------*/
+
+/* Hand a reply to the module as the IP-task does, with SysTick at the
+ * microsecond that it arrives. */
+static void prvDeliver( const TestPending_t * pxReply )
+{
+    uint32_t ulFraction = pxReply->ulDueUs - ( xTaskGetTickCount() * 1000U );
+
+    xFakeSysTick.VAL = testSYSTICK_LOAD - ( ulFraction * ( ( testSYSTICK_LOAD + 1UL ) / 1000UL ) );
+    vPingReplyReceived( pxReply->eStatus, pxReply->usSequence );
+    xFakeSysTick.VAL = testSYSTICK_LOAD;
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvRequest( BaseType_t xIPv6,
+                              const void * pvAddress,
+                              size_t uxNumberOfBytesToSend )
+{
+    TestResponder_t * pxResponder = prvFindResponder( xIPv6, pvAddress );
+    TestPending_t xReply;
+
+    TEST_CHECK( pxResponder != NULL );
+    TEST_CHECK_EQUAL( configPING_PAYLOAD_SIZE, uxNumberOfBytesToSend );
+
+    if( pxResponder->xNoBuffer != pdFALSE )
+    {
+        return pdFAIL;
+    }
+
+    pxResponder->ulRequests++;
+    usStackSequence[ xIPv6 ]++;
+
+    if( pxResponder->xDown == pdFALSE )
+    {
+        xReply.usSequence = usStackSequence[ xIPv6 ];
+        xReply.ulDueUs = ulUptimeMicroseconds() + pxResponder->pulRoundTripUs[ pxResponder->uxNext ];
+        xReply.eStatus = pxResponder->eStatus;
+        pxResponder->uxNext = ( pxResponder->uxNext + 1U ) % pxResponder->uxRoundTrips;
+
+        if( ( xReply.ulDueUs / 1000U ) == xTaskGetTickCount() )
+        {
+            /* Back within the tick, before the request is recorded. */
+            prvDeliver( &xReply );
+        }
+        else
+        {
+            TEST_CHECK( uxPendingCount < testMAX_PENDING );
+            xPending[ uxPendingCount ] = xReply;
+            uxPendingCount++;
+        }
+    }
+
+    return ( BaseType_t ) usStackSequence[ xIPv6 ];
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t FreeRTOS_SendPingRequest( uint32_t ulIPAddress,
+                                     size_t uxNumberOfBytesToSend,
+                                     TickType_t uxBlockTimeTicks )
+{
+    TEST_CHECK_EQUAL( 0, uxBlockTimeTicks );
+
+    return prvRequest( pdFALSE, &ulIPAddress, uxNumberOfBytesToSend );
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t FreeRTOS_SendPingRequestIPv6( const IPv6_Address_t * pxIPAddress,
+                                         size_t uxNumberOfBytesToSend,
+                                         TickType_t uxBlockTimeTicks )
+{
+    TEST_CHECK_EQUAL( 0, uxBlockTimeTicks );
+
+    return prvRequest( pdTRUE, pxIPAddress, uxNumberOfBytesToSend );
+}
+/*-----------------------------------------------------------*/
+
+/* The replies that arrive during this tick. */
+static void prvLoopbackTick( void )
+{
+    size_t x = 0U;
+
+    while( x < uxPendingCount )
+    {
+        if( ( xPending[ x ].ulDueUs / 1000U ) == xTaskGetTickCount() )
+        {
+            prvDeliver( &( xPending[ x ] ) );
+            uxPendingCount--;
+            memmove( &( xPending[ x ] ), &( xPending[ x + 1U ] ), ( uxPendingCount - x ) * sizeof( xPending[ 0 ] ) );
+        }
+        else
+        {
+            x++;
+        }
+    }
+}
+/*-----------------------------------------------------------*/
+
+static void prvSetUp( void )
+{
+    vFakeKernelReset();
+    vFakeKernelSetTickHook( prvLoopbackTick );
+    xFakeSysTick.LOAD = testSYSTICK_LOAD;
+    xFakeSysTick.VAL = testSYSTICK_LOAD;
+    xFakeSCB.ICSR = 0U;
+
+    /* The state of ping.c. */
+    memset( xTargets, 0, sizeof( xTargets ) );
+    xTargetCount = 0;
+    memset( xRequests, 0, sizeof( xRequests ) );
+    xReplyQueue = NULL;
+    memset( usLastSequence, 0, sizeof( usLastSequence ) );
+    xSequenceKnown[ 0 ] = pdFALSE;
+    xSequenceKnown[ 1 ] = pdFALSE;
+
+    memset( xResponders, 0, sizeof( xResponders ) );
+    uxResponderCount = 0U;
+    uxPendingCount = 0U;
+    memset( usStackSequence, 0, sizeof( usStackSequence ) );
+
+    TEST_CHECK_EQUAL( pdPASS, xPingInitialise( 512U, 1U ) );
+}
+/*-----------------------------------------------------------*/
+
+/* A responder, and the target that pings it. */
+static BaseType_t prvAddHost( const char * pcAddress,
+                              const uint32_t * pulRoundTripUs,
+                              size_t uxRoundTrips,
+                              uint32_t ulPeriodMS )
+{
+    TestResponder_t * pxResponder = &( xResponders[ uxResponderCount ] );
+
+    TEST_CHECK( uxResponderCount < testMAX_RESPONDERS );
+    uxResponderCount++;
+
+    pxResponder->pcAddress = pcAddress;
+    pxResponder->pulRoundTripUs = pulRoundTripUs;
+    pxResponder->uxRoundTrips = uxRoundTrips;
+    pxResponder->eStatus = eSuccess;
+    pxResponder->xIPv6 = ( strchr( pcAddress, ':' ) != NULL ) ? pdTRUE : pdFALSE;
+    TEST_CHECK_EQUAL( pdPASS, FreeRTOS_inet_pton( pxResponder->xIPv6 ? FREERTOS_AF_INET6 : FREERTOS_AF_INET4, pcAddress, &( pxResponder->xAddress ) ) );
+
+    return xPingAddTarget( pcAddress, pcAddress, ulPeriodMS );
+}
+/*-----------------------------------------------------------*/
+
+static void prvRunUntil( TickType_t xTick )
+{
+    while( xTaskGetTickCount() < xTick )
+    {
+        prvPingRound();
+    }
+}
+/*-----------------------------------------------------------*/
+
+static void test_round_trips( void )
+{
+    static const uint32_t ulRoundTrips[] = { 250U, 410U, 330U, 1800U };
+    PingStats_t xStats;
+    BaseType_t xTarget;
+
+    prvSetUp();
+    xTarget = prvAddHost( "192.168.1.1", ulRoundTrips, 4U, 1000U );
+    TEST_CHECK_EQUAL( 0, xTarget );
+    TEST_CHECK_EQUAL( pdFALSE, xPingIsReachable( xTarget ) );
+
+    /* Requests at 0, 1000, 2000 and 3000 ms. */
+    prvRunUntil( 3500U );
+    vPingGetStats( xTarget, &xStats, pdFALSE );
+
+    TEST_CHECK_EQUAL( 4, xStats.ulSent );
+    TEST_CHECK_EQUAL( 4, xStats.ulReceived );
+    TEST_CHECK_EQUAL( 0, xStats.ulLost );
+    TEST_CHECK_EQUAL( 250, xStats.ulMinUs );
+    TEST_CHECK_EQUAL( 1800, xStats.ulMaxUs );
+    TEST_CHECK_EQUAL( ( 250 + 410 + 330 + 1800 ) / 4, xStats.ulAvgUs );
+    TEST_CHECK_EQUAL( 1800, xStats.ulLastUs );
+
+    /* RFC 3550: 0 + 160 / 16 = 10, 10 + ( 80 - 10 ) / 16 = 14,
+     * 14 + ( 1470 - 14 ) / 16 = 105. */
+    TEST_CHECK_EQUAL( 105, xStats.ulJitterUs );
+    TEST_CHECK_EQUAL( pdTRUE, xPingIsReachable( xTarget ) );
+    TEST_CHECK_EQUAL( 4, xResponders[ 0 ].ulRequests );
+}
+/*-----------------------------------------------------------*/
+
+/* The stack gives the first IPv4 and the first IPv6 request both number 1:
+ * the faster IPv6 reply must not be taken for the IPv4 one. */
+static void test_ipv4_and_ipv6( void )
+{
+    static const uint32_t ulSlow[] = { 3000U };
+    static const uint32_t ulFast[] = { 500U };
+    PingStats_t xStats;
+    BaseType_t xIPv4;
+    BaseType_t xIPv6;
+
+    prvSetUp();
+    xIPv4 = prvAddHost( "192.168.1.1", ulSlow, 1U, 100U );
+    xIPv6 = prvAddHost( "fd00::1", ulFast, 1U, 100U );
+
+    prvRunUntil( 1050U );
+
+    vPingGetStats( xIPv4, &xStats, pdFALSE );
+    TEST_CHECK_EQUAL( 11, xStats.ulSent );
+    TEST_CHECK_EQUAL( 11, xStats.ulReceived );
+    TEST_CHECK_EQUAL( 3000, xStats.ulMinUs );
+    TEST_CHECK_EQUAL( 3000, xStats.ulMaxUs );
+
+    vPingGetStats( xIPv6, &xStats, pdFALSE );
+    TEST_CHECK_EQUAL( 11, xStats.ulSent );
+    TEST_CHECK_EQUAL( 11, xStats.ulReceived );
+    TEST_CHECK_EQUAL( 500, xStats.ulMinUs );
+    TEST_CHECK_EQUAL( 500, xStats.ulMaxUs );
+
+    /* The same numbers went out for both types. */
+    TEST_CHECK_EQUAL( 11, usStackSequence[ 0 ] );
+    TEST_CHECK_EQUAL( 11, usStackSequence[ 1 ] );
+}
+/*-----------------------------------------------------------*/
+
+/* More requests in flight than configPING_MAX_OUTSTANDING, each target with
+ * a round trip of its own. */
+static void test_many_targets( void )
+{
+    static const char * pcAddresses[ 8 ] =
+    {
+        "10.0.0.1", "10.0.0.2", "10.0.0.3", "10.0.0.4",
+        "10.0.0.5", "10.0.0.6", "10.0.0.7", "10.0.0.8"
+    };
+    static uint32_t ulRoundTrips[ 8 ];
+    PingStats_t xStats;
+    uint32_t ulSent = 0U;
+    size_t x;
+
+    prvSetUp();
+
+    for( x = 0; x < 8U; x++ )
+    {
+        ulRoundTrips[ x ] = 500000U + ( x * 1000U );
+        TEST_CHECK_EQUAL( x, prvAddHost( pcAddresses[ x ], &( ulRoundTrips[ x ] ), 1U, 200U ) );
+    }
+
+    TEST_CHECK_EQUAL( -1, xPingAddTarget( "full", "10.0.0.9", 200U ) );
+    TEST_CHECK_EQUAL( -1, xPingAddTarget( "bad", "10.0.0", 200U ) );
+
+    prvRunUntil( 3000U );
+
+    for( x = 0; x < 8U; x++ )
+    {
+        vPingGetStats( ( BaseType_t ) x, &xStats, pdFALSE );
+        TEST_CHECK_EQUAL( 0, xStats.ulLost );
+        TEST_CHECK_EQUAL( ulRoundTrips[ x ], xStats.ulMinUs );
+        TEST_CHECK_EQUAL( ulRoundTrips[ x ], xStats.ulMaxUs );
+        TEST_CHECK( xStats.ulReceived + 3U >= xStats.ulSent );
+        ulSent += xStats.ulSent;
+    }
+
+    /* Three per target would be in flight, only 16 fit: some periods were
+     * skipped, and a slot was used again once its reply came. */
+    TEST_CHECK( ulSent < ( 8U * 3000U ) / 200U );
+    TEST_CHECK( ulSent > 2U * configPING_MAX_OUTSTANDING );
+}
+/*-----------------------------------------------------------*/
+
+static void test_loss( void )
+{
+    static const uint32_t ulRoundTrip[] = { 700U };
+    static const uint32_t ulLate[] = { 1200000U };
+    PingStats_t xStats;
+    BaseType_t xTarget;
+
+    prvSetUp();
+    xTarget = prvAddHost( "192.168.1.1", ulRoundTrip, 1U, 1000U );
+    prvRunUntil( 500U );
+    TEST_CHECK_EQUAL( pdTRUE, xPingIsReachable( xTarget ) );
+
+    /* The requests of 1000, 2000 and 3000 ms time out, the last one at
+     * 4000 ms. */
+    xResponders[ 0 ].xDown = pdTRUE;
+    prvRunUntil( 3500U );
+    TEST_CHECK_EQUAL( pdTRUE, xPingIsReachable( xTarget ) );
+    prvRunUntil( 4001U );
+    TEST_CHECK_EQUAL( pdFALSE, xPingIsReachable( xTarget ) );
+
+    /* The counters start afresh, the health signal does not. */
+    vPingGetStats( xTarget, &xStats, pdTRUE );
+    TEST_CHECK_EQUAL( 3, xStats.ulLost );
+    TEST_CHECK_EQUAL( 3, xStats.ulLostInARow );
+    vPingGetStats( xTarget, &xStats, pdFALSE );
+    TEST_CHECK_EQUAL( 0, xStats.ulLost );
+    TEST_CHECK_EQUAL( 3, xStats.ulLostInARow );
+    TEST_CHECK_EQUAL( pdFALSE, xPingIsReachable( xTarget ) );
+
+    /* The request of 4000 ms times out, and so does the one of 5000 ms,
+     * whose reply comes at 6200 ms. */
+    xResponders[ 0 ].xDown = pdFALSE;
+    xResponders[ 0 ].pulRoundTripUs = ulLate;
+    prvRunUntil( 6500U );
+    vPingGetStats( xTarget, &xStats, pdFALSE );
+    TEST_CHECK_EQUAL( 2, xStats.ulLost );
+    TEST_CHECK_EQUAL( 0, xStats.ulReceived );
+    TEST_CHECK_EQUAL( pdFALSE, xPingIsReachable( xTarget ) );
+
+    /* Back up with the first reply in time. */
+    xResponders[ 0 ].pulRoundTripUs = ulRoundTrip;
+    prvRunUntil( 7001U );
+    TEST_CHECK_EQUAL( pdTRUE, xPingIsReachable( xTarget ) );
+    vPingGetStats( xTarget, &xStats, pdFALSE );
+    TEST_CHECK_EQUAL( 3, xStats.ulLost );
+    TEST_CHECK_EQUAL( 1, xStats.ulReceived );
+    TEST_CHECK_EQUAL( 0, xStats.ulLostInARow );
+    TEST_CHECK_EQUAL( 700, xStats.ulMinUs );
+}
+/*-----------------------------------------------------------*/
+
+static void test_errors( void )
+{
+    static const uint32_t ulRoundTrip[] = { 400U };
+    PingStats_t xStats;
+    BaseType_t xBad;
+    BaseType_t xNoRoute;
+    BaseType_t xNoBuffer;
+
+    prvSetUp();
+    xBad = prvAddHost( "192.168.1.1", ulRoundTrip, 1U, 1000U );
+    xNoRoute = prvAddHost( "fd00::2", ulRoundTrip, 1U, 1000U );
+    xNoBuffer = prvAddHost( "192.168.1.3", ulRoundTrip, 1U, 1000U );
+    xResponders[ 0 ].eStatus = eInvalidData;
+    xResponders[ 1 ].xNoRoute = pdTRUE;
+    xResponders[ 2 ].xNoBuffer = pdTRUE;
+
+    prvRunUntil( 2500U );
+
+    /* A damaged reply is no round trip, but the request is not lost. */
+    vPingGetStats( xBad, &xStats, pdFALSE );
+    TEST_CHECK_EQUAL( 3, xStats.ulSent );
+    TEST_CHECK_EQUAL( 3, xStats.ulErrors );
+    TEST_CHECK_EQUAL( 0, xStats.ulReceived );
+    TEST_CHECK_EQUAL( 0, xStats.ulLost );
+    TEST_CHECK_EQUAL( pdFALSE, xPingIsReachable( xBad ) );
+
+    /* Not sent at all. */
+    vPingGetStats( xNoRoute, &xStats, pdFALSE );
+    TEST_CHECK_EQUAL( 0, xStats.ulSent );
+    TEST_CHECK_EQUAL( 3, xStats.ulNoRoute );
+    TEST_CHECK_EQUAL( 0, xResponders[ 1 ].ulRequests );
+
+    vPingGetStats( xNoBuffer, &xStats, pdFALSE );
+    TEST_CHECK_EQUAL( 0, xStats.ulSent );
+    TEST_CHECK_EQUAL( 0, xStats.ulLost );
+}
+/*-----------------------------------------------------------*/
+
+int main( void )
+{
+    TEST_RUN( test_round_trips );
+    TEST_RUN( test_ipv4_and_ipv6 );
+    TEST_RUN( test_many_targets );
+    TEST_RUN( test_loss );
+    TEST_RUN( test_errors );
+
+    return 0;
+}
+/*-----------------------------------------------------------*/
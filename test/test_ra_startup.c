@@ -0,0 +1,430 @@
+/* See fake_flash.h. */
+#define configDHCP_LEASE_RECORD_COUNT    64U
+
+/* Included, for the time-to-ready table and to run the lease task. */
+#include "net_services.c"
+#include "dhcp_lease.c"
+
+/* Standard includes. */
+#include <string.h>
+
+#include "fake_flash.h"
+#include "fake_kernel.h"
+#include "test.h"
+
+/*
+ * The start-up of the public IPv6 end-point, against a scripted router.
+ *
+ * The RA state machine of the stack is not part of this tree, so the test
+ * plays it, with the timing of FreeRTOSIPConfig.h: a Router Solicitation when
+ * the link comes up, repeated ipconfigRA_SEARCH_COUNT times, after which the
+ * default configuration is used.  Then ipconfigRA_IP_TEST_COUNT Neighbour
+ * Solicitations test the address for duplicates; when a neighbour defends it,
+ * another interface identifier is tried.  When no probe was answered, the
+ * end-point is up, and the network event hook runs as in app_main.c.
+ */
+
+#define testLINK_UP_MS    10U
+
+/* The router, and the neighbour that already uses our address. */
+typedef struct xTEST_ROUTER
+{
+    uint32_t ulUpAtMs;       /* It ignores solicitations before this time. */
+    uint32_t ulDelayMs;      /* From the solicitation to the advertisement. */
+    uint8_t ucSubnet;        /* The prefix is 2001:db8:0:<ucSubnet>::/64. */
+    BaseType_t xPresent;
+    uint32_t ulDefends;      /* Neighbour Advertisements for our address. */
+} TestRouter_t;
+
+typedef enum
+{
+    eTestSearch,
+    eTestProbe,
+    eTestUp
+} TestRAState_t;
+
+static TestRouter_t xRouter;
+static NetworkEndPoint_t xEndPoint;
+static NetService_t xService;
+static TestRAState_t eState;
+static uint32_t ulTries;
+static TickType_t xTimeOut;
+static TickType_t xAdvertisementAt;
+static BaseType_t xAdvertisementDue;
+static uint32_t ulSolicitations;
+static uint32_t ulProbes;
+static uint32_t ulStarts;
+
+/*-----------------------------------------------------------*/
+
+static void prvStart( NetService_t * pxService )
+{
+    ( void ) pxService;
+    ulStarts++;
+}
+/*-----------------------------------------------------------*/
+
+static void prvSolicit( void )
+{
+    TickType_t xNow = xTaskGetTickCount();
+
+    ulSolicitations++;
+    xTimeOut = xNow + pdMS_TO_TICKS( ipconfigRA_SEARCH_TIME_OUT_MSEC );
+
+    if( ( xRouter.xPresent != pdFALSE ) && ( xNow >= pdMS_TO_TICKS( xRouter.ulUpAtMs ) ) )
+    {
+        xAdvertisementAt = xNow + pdMS_TO_TICKS( xRouter.ulDelayMs );
+        xAdvertisementDue = pdTRUE;
+    }
+}
+/*-----------------------------------------------------------*/
+
+static void prvProbe( void )
+{
+    ulProbes++;
+    eState = eTestProbe;
+    xTimeOut = xTaskGetTickCount() + pdMS_TO_TICKS( ipconfigRA_IP_TEST_TIME_OUT_MSEC );
+}
+/*-----------------------------------------------------------*/
+
+/* What the network event hook of app_main.c does for eNetworkUp. */
+static void prvNetworkUp( void )
+{
+    eState = eTestUp;
+    vNetServicesNetworkEvent( eNetworkUp, &xEndPoint );
+    vRALeaseEndPointUp( &xEndPoint );
+}
+/*-----------------------------------------------------------*/
+
+/* One millisecond of the stack and the router. */
+static void prvTick( void )
+{
+    IPV6Parameters_t * pxSettings = &( xEndPoint.ipv6_settings );
+    TickType_t xNow = xTaskGetTickCount();
+
+    if( xNow == pdMS_TO_TICKS( testLINK_UP_MS ) )
+    {
+        eState = eTestSearch;
+        ulTries = 0U;
+        prvSolicit();
+    }
+    else if( xNow < pdMS_TO_TICKS( testLINK_UP_MS ) )
+    {
+        /* The link is still down. */
+    }
+    else if( eState == eTestSearch )
+    {
+        if( ( xAdvertisementDue != pdFALSE ) && ( xNow >= xAdvertisementAt ) )
+        {
+            /* SLAAC: the prefix of the router and our interface identifier,
+             * the router is the gateway. */
+            xAdvertisementDue = pdFALSE;
+            memset( pxSettings->xPrefix.ucBytes, 0, sizeof( pxSettings->xPrefix.ucBytes ) );
+            pxSettings->xPrefix.ucBytes[ 0 ] = 0x20U;
+            pxSettings->xPrefix.ucBytes[ 1 ] = 0x01U;
+            pxSettings->xPrefix.ucBytes[ 2 ] = 0x0DU;
+            pxSettings->xPrefix.ucBytes[ 3 ] = 0xB8U;
+            pxSettings->xPrefix.ucBytes[ 7 ] = xRouter.ucSubnet;
+            pxSettings->uxPrefixLength = 64U;
+            memcpy( pxSettings->xIPAddress.ucBytes, pxSettings->xPrefix.ucBytes, 8U );
+            memset( pxSettings->xGatewayAddress.ucBytes, 0, sizeof( pxSettings->xGatewayAddress.ucBytes ) );
+            pxSettings->xGatewayAddress.ucBytes[ 0 ] = 0xFEU;
+            pxSettings->xGatewayAddress.ucBytes[ 1 ] = 0x80U;
+            pxSettings->xGatewayAddress.ucBytes[ 15 ] = 0x01U;
+            ulTries = 0U;
+            prvProbe();
+        }
+        else if( xNow >= xTimeOut )
+        {
+            ulTries++;
+
+            if( ulTries < ipconfigRA_SEARCH_COUNT )
+            {
+                prvSolicit();
+            }
+            else
+            {
+                /* No router: use the defaults, the stored prefix if any. */
+                memcpy( pxSettings, &( xEndPoint.ipv6_defaults ), sizeof( *pxSettings ) );
+                ulTries = 0U;
+                prvProbe();
+            }
+        }
+    }
+    else if( eState == eTestProbe )
+    {
+        if( xRouter.ulDefends > 0U )
+        {
+            /* Our address is taken, try another interface identifier. */
+            xRouter.ulDefends--;
+            pxSettings->xIPAddress.ucBytes[ 15 ]++;
+            ulTries = 0U;
+            prvProbe();
+        }
+        else if( xNow >= xTimeOut )
+        {
+            ulTries++;
+
+            if( ulTries < ipconfigRA_IP_TEST_COUNT )
+            {
+                prvProbe();
+            }
+            else
+            {
+                prvNetworkUp();
+            }
+        }
+    }
+}
+/*-----------------------------------------------------------*/
+
+/* A reset: RAM is cleared, the flash keeps the records.  The end-point is
+ * configured as app_main.c does it. */
+static void prvBoot( void )
+{
+    IPV6Parameters_t * pxDefaults = &( xEndPoint.ipv6_defaults );
+
+    vFakeKernelReset();
+
+    /* The state of net_services.c. */
+    memset( pxServices, 0, sizeof( pxServices ) );
+    xServiceCount = 0;
+    memset( pxUpEndPoints, 0, sizeof( pxUpEndPoints ) );
+    xLegacyIPv4Up = pdFALSE;
+    memset( xReady, 0, sizeof( xReady ) );
+
+    /* The state of dhcp_lease.c. */
+    memset( xHaveNewest, 0, sizeof( xHaveNewest ) );
+    memset( xHavePending, 0, sizeof( xHavePending ) );
+    xLeaseTask = NULL;
+    ulLastSequence = 0U;
+    xEraseNeeded = pdFALSE;
+    TEST_CHECK_EQUAL( pdPASS, xDHCPLeaseInitialise() );
+
+    /* The hard-coded defaults: 2001:db8:0:ffff::2:1 behind 2001:db8:0:ffff::1. */
+    memset( &xEndPoint, 0, sizeof( xEndPoint ) );
+    xEndPoint.bits.bIPv6 = pdTRUE_UNSIGNED;
+    xEndPoint.bits.bWantRA = pdTRUE_UNSIGNED;
+    pxDefaults->xIPAddress.ucBytes[ 0 ] = 0x20U;
+    pxDefaults->xIPAddress.ucBytes[ 1 ] = 0x01U;
+    pxDefaults->xIPAddress.ucBytes[ 2 ] = 0x0DU;
+    pxDefaults->xIPAddress.ucBytes[ 3 ] = 0xB8U;
+    pxDefaults->xIPAddress.ucBytes[ 6 ] = 0xFFU;
+    pxDefaults->xIPAddress.ucBytes[ 7 ] = 0xFFU;
+    memcpy( pxDefaults->xPrefix.ucBytes, pxDefaults->xIPAddress.ucBytes, 8U );
+    memcpy( pxDefaults->xGatewayAddress.ucBytes, pxDefaults->xIPAddress.ucBytes, 8U );
+    pxDefaults->xIPAddress.ucBytes[ 13 ] = 0x02U;
+    pxDefaults->xIPAddress.ucBytes[ 15 ] = 0x01U;
+    pxDefaults->xGatewayAddress.ucBytes[ 15 ] = 0x01U;
+    pxDefaults->uxPrefixLength = 64U;
+    memcpy( &( xEndPoint.ipv6_settings ), pxDefaults, sizeof( xEndPoint.ipv6_settings ) );
+    ( void ) xRALeaseApply( &xEndPoint );
+
+    memset( &xService, 0, sizeof( xService ) );
+    xService.pcName = "global";
+    xService.uxNeeds = netsvcNEEDS_IPv6_GLOBAL;
+    xService.fnStart = prvStart;
+    TEST_CHECK_EQUAL( pdPASS, xNetServicesRegister( &xService ) );
+
+    memset( &xRouter, 0, sizeof( xRouter ) );
+    eState = eTestSearch;
+    xAdvertisementDue = pdFALSE;
+    ulSolicitations = 0U;
+    ulProbes = 0U;
+    ulStarts = 0U;
+
+    vFakeKernelSetTickHook( prvTick );
+}
+/*-----------------------------------------------------------*/
+
+/* Run until the end-point is up, and let the lease task write the flash.
+ * Returns the time-to-ready that net_services.c recorded, in ms. */
+static uint32_t prvRunUntilUp( void )
+{
+    uint32_t ulReadyMs = 0U;
+    BaseType_t x;
+
+    while( ( eState != eTestUp ) && ( xTaskGetTickCount() < pdMS_TO_TICKS( 60000U ) ) )
+    {
+        vFakeKernelAdvance( 1U );
+    }
+
+    TEST_CHECK( eState == eTestUp );
+    TEST_CHECK_EQUAL( 1, ulStarts );
+
+    if( xHavePending[ dhcpleaseKIND_RA ] != pdFALSE )
+    {
+        prvWriteRecords();
+    }
+
+    for( x = 0; x < configNET_SERVICES_MAX_ENDPOINTS; x++ )
+    {
+        if( xReady[ x ].pxEndPoint == &xEndPoint )
+        {
+            ulReadyMs = ( uint32_t ) pdTICKS_TO_MS( xReady[ x ].xReadyAt );
+        }
+    }
+
+    TEST_CHECK( ulReadyMs != 0U );
+
+    return ulReadyMs;
+}
+/*-----------------------------------------------------------*/
+
+static void prvCheckAddress( uint8_t ucSubnet,
+                             uint8_t ucHost )
+{
+    const IPV6Parameters_t * pxSettings = &( xEndPoint.ipv6_settings );
+
+    TEST_CHECK_EQUAL( ucSubnet, pxSettings->xIPAddress.ucBytes[ 7 ] );
+    TEST_CHECK_EQUAL( ucSubnet, pxSettings->xPrefix.ucBytes[ 7 ] );
+    TEST_CHECK_EQUAL( 0x02U, pxSettings->xIPAddress.ucBytes[ 13 ] );
+    TEST_CHECK_EQUAL( ucHost, pxSettings->xIPAddress.ucBytes[ 15 ] );
+    TEST_CHECK_EQUAL( 64, pxSettings->uxPrefixLength );
+}
+/*-----------------------------------------------------------*/
+
+static void prvCheckStored( uint8_t ucSubnet )
+{
+    RALease_t xLease;
+
+    TEST_CHECK_EQUAL( pdPASS, xRALeaseLoad( &xLease ) );
+    TEST_CHECK_EQUAL( ucSubnet, xLease.ucPrefix[ 7 ] );
+    TEST_CHECK_EQUAL( 0x01U, xLease.ucGatewayIID[ 7 ] );
+    TEST_CHECK_EQUAL( 64, xLease.ulPrefixLength );
+}
+/*-----------------------------------------------------------*/
+
+static void test_router_answers( void )
+{
+    RALease_t xLease;
+
+    vFakeFlashReset();
+    prvBoot();
+    xRouter.xPresent = pdTRUE;
+    xRouter.ulDelayMs = 5U;
+    xRouter.ucSubnet = 7U;
+
+    /* One solicitation, the advertisement 5 ms later, one probe. */
+    TEST_CHECK_EQUAL( testLINK_UP_MS + 5U + ipconfigRA_IP_TEST_TIME_OUT_MSEC, prvRunUntilUp() );
+    TEST_CHECK_EQUAL( 1, ulSolicitations );
+    TEST_CHECK_EQUAL( ipconfigRA_IP_TEST_COUNT, ulProbes );
+    prvCheckAddress( 7U, 1U );
+    prvCheckStored( 7U );
+
+    /* The same prefix is not stored again after the next boot. */
+    prvBoot();
+    xRouter.xPresent = pdTRUE;
+    xRouter.ucSubnet = 7U;
+    ( void ) prvRunUntilUp();
+    TEST_CHECK_EQUAL( 1, pxFakeFlash()->ulPrograms );
+    TEST_CHECK_EQUAL( pdPASS, xRALeaseLoad( &xLease ) );
+}
+/*-----------------------------------------------------------*/
+
+static void test_no_router( void )
+{
+    const uint32_t ulExpected = testLINK_UP_MS +
+                                ( ipconfigRA_SEARCH_COUNT * ipconfigRA_SEARCH_TIME_OUT_MSEC ) +
+                                ( ipconfigRA_IP_TEST_COUNT * ipconfigRA_IP_TEST_TIME_OUT_MSEC );
+
+    /* A new board, the router is down: the hard-coded prefix, which is not
+     * stored, as it did not come from a router. */
+    vFakeFlashReset();
+    prvBoot();
+    TEST_CHECK_EQUAL( ulExpected, prvRunUntilUp() );
+    TEST_CHECK_EQUAL( ipconfigRA_SEARCH_COUNT, ulSolicitations );
+    prvCheckAddress( 0xFFU, 1U );
+    TEST_CHECK_EQUAL( 0, pxFakeFlash()->ulPrograms );
+
+    /* A board that learned a prefix before the reset uses it, on time. */
+    prvBoot();
+    xRouter.xPresent = pdTRUE;
+    xRouter.ucSubnet = 9U;
+    ( void ) prvRunUntilUp();
+
+    prvBoot();
+    TEST_CHECK_EQUAL( ulExpected, prvRunUntilUp() );
+    prvCheckAddress( 9U, 1U );
+    TEST_CHECK_EQUAL( 0xFEU, xEndPoint.ipv6_settings.xGatewayAddress.ucBytes[ 0 ] );
+    TEST_CHECK_EQUAL( 0x01U, xEndPoint.ipv6_settings.xGatewayAddress.ucBytes[ 15 ] );
+
+    /* Within 5 s of boot, against 3 x 10 s of search and 3 x 1.5 s of DAD
+     * with the defaults of the stack. */
+    TEST_CHECK( ulExpected <= 5000U );
+}
+/*-----------------------------------------------------------*/
+
+static void test_renumbered( void )
+{
+    vFakeFlashReset();
+    prvBoot();
+    xRouter.xPresent = pdTRUE;
+    xRouter.ucSubnet = 3U;
+    ( void ) prvRunUntilUp();
+    prvCheckStored( 3U );
+
+    /* The stored prefix is only a default, the router decides. */
+    prvBoot();
+    prvCheckAddress( 3U, 1U );
+    xRouter.xPresent = pdTRUE;
+    xRouter.ucSubnet = 4U;
+    ( void ) prvRunUntilUp();
+    prvCheckAddress( 4U, 1U );
+    prvCheckStored( 4U );
+
+    prvBoot();
+    ( void ) prvRunUntilUp();
+    prvCheckAddress( 4U, 1U );
+}
+/*-----------------------------------------------------------*/
+
+static void test_late_router( void )
+{
+    vFakeFlashReset();
+    prvBoot();
+
+    /* The router misses the first two solicitations, and answers the last. */
+    xRouter.xPresent = pdTRUE;
+    xRouter.ulUpAtMs = testLINK_UP_MS + ipconfigRA_SEARCH_TIME_OUT_MSEC + 500U;
+    xRouter.ulDelayMs = 5U;
+    xRouter.ucSubnet = 5U;
+
+    TEST_CHECK_EQUAL( testLINK_UP_MS + ( 2U * ipconfigRA_SEARCH_TIME_OUT_MSEC ) + 5U + ipconfigRA_IP_TEST_TIME_OUT_MSEC, prvRunUntilUp() );
+    TEST_CHECK_EQUAL( 3, ulSolicitations );
+    prvCheckAddress( 5U, 1U );
+    prvCheckStored( 5U );
+}
+/*-----------------------------------------------------------*/
+
+static void test_duplicate_address( void )
+{
+    vFakeFlashReset();
+    prvBoot();
+    xRouter.xPresent = pdTRUE;
+    xRouter.ulDelayMs = 5U;
+    xRouter.ucSubnet = 6U;
+    xRouter.ulDefends = 1U;
+
+    /* The first address is defended at once, the second one is probed. */
+    TEST_CHECK_EQUAL( testLINK_UP_MS + 5U + 1U + ipconfigRA_IP_TEST_TIME_OUT_MSEC, prvRunUntilUp() );
+    TEST_CHECK_EQUAL( 1U + ipconfigRA_IP_TEST_COUNT, ulProbes );
+    prvCheckAddress( 6U, 2U );
+
+    /* Only the prefix and the router are stored, not the address. */
+    prvBoot();
+    prvCheckAddress( 6U, 1U );
+}
+/*-----------------------------------------------------------*/
+
+int main( void )
+{
+    TEST_RUN( test_router_answers );
+    TEST_RUN( test_no_router );
+    TEST_RUN( test_renumbered );
+    TEST_RUN( test_late_router );
+    TEST_RUN( test_duplicate_address );
+
+    return 0;
+}
+/*-----------------------------------------------------------*/
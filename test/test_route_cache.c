@@ -0,0 +1,282 @@
+/* Standard includes. */
+#include <string.h>
+#include <time.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "FreeRTOS_IP.h"
+#include "FreeRTOS_Sockets.h"
+
+#include "route_cache.h"
+
+#include "fake_kernel.h"
+#include "test.h"
+
+/* Lookups per measurement of the benchmark. */
+#define testLOOKUPS         200000U
+
+/* Distinct destinations of the benchmark, fewer than the cache entries. */
+#define testDESTINATIONS    8U
+
+#define testMAX_END_POINTS  32U
+
+static NetworkEndPoint_t xEndPoints[ testMAX_END_POINTS ];
+static size_t uxEndPointCount;
+
+/*-----------------------------------------------------------*/
+
+/* The end-point list of the stack. */
+NetworkEndPoint_t * FreeRTOS_FirstEndPoint( const NetworkInterface_t * pxInterface )
+{
+    ( void ) pxInterface;
+
+    return ( uxEndPointCount > 0U ) ? &( xEndPoints[ 0 ] ) : NULL;
+}
+/*-----------------------------------------------------------*/
+
+NetworkEndPoint_t * FreeRTOS_NextEndPoint( const NetworkInterface_t * pxInterface,
+                                           NetworkEndPoint_t * pxEndPoint )
+{
+    ( void ) pxInterface;
+
+    return pxEndPoint->pxNext;
+}
+/*-----------------------------------------------------------*/
+
+static void prvAddIPv4( uint32_t ulAddress,
+                        uint32_t ulNetMask,
+                        uint32_t ulGateway )
+{
+    NetworkEndPoint_t * pxEndPoint = &( xEndPoints[ uxEndPointCount ] );
+
+    memset( pxEndPoint, 0, sizeof( *pxEndPoint ) );
+    pxEndPoint->ipv4_settings.ulIPAddress = FreeRTOS_htonl( ulAddress );
+    pxEndPoint->ipv4_settings.ulNetMask = FreeRTOS_htonl( ulNetMask );
+    pxEndPoint->ipv4_settings.ulGatewayAddress = FreeRTOS_htonl( ulGateway );
+    pxEndPoint->bits.bEndPointUp = pdTRUE_UNSIGNED;
+
+    if( uxEndPointCount > 0U )
+    {
+        xEndPoints[ uxEndPointCount - 1U ].pxNext = pxEndPoint;
+    }
+
+    uxEndPointCount++;
+}
+/*-----------------------------------------------------------*/
+
+static void prvAddIPv6( uint8_t ucFirst,
+                        uint8_t ucSecond,
+                        size_t uxPrefixLength,
+                        BaseType_t xGateway )
+{
+    NetworkEndPoint_t * pxEndPoint = &( xEndPoints[ uxEndPointCount ] );
+
+    memset( pxEndPoint, 0, sizeof( *pxEndPoint ) );
+    pxEndPoint->ipv6_settings.xIPAddress.ucBytes[ 0 ] = ucFirst;
+    pxEndPoint->ipv6_settings.xIPAddress.ucBytes[ 1 ] = ucSecond;
+    pxEndPoint->ipv6_settings.xIPAddress.ucBytes[ 15 ] = 1U;
+    pxEndPoint->ipv6_settings.uxPrefixLength = uxPrefixLength;
+
+    if( xGateway != pdFALSE )
+    {
+        pxEndPoint->ipv6_settings.xGatewayAddress.ucBytes[ 0 ] = 0xFEU;
+        pxEndPoint->ipv6_settings.xGatewayAddress.ucBytes[ 1 ] = 0x80U;
+        pxEndPoint->ipv6_settings.xGatewayAddress.ucBytes[ 15 ] = 0xFEU;
+    }
+
+    pxEndPoint->bits.bIPv6 = pdTRUE_UNSIGNED;
+    pxEndPoint->bits.bEndPointUp = pdTRUE_UNSIGNED;
+
+    if( uxEndPointCount > 0U )
+    {
+        xEndPoints[ uxEndPointCount - 1U ].pxNext = pxEndPoint;
+    }
+
+    uxEndPointCount++;
+}
+/*-----------------------------------------------------------*/
+
+/* uxCount end-points, the interesting ones last so that a walk goes through
+ * all of them: filler IPv4 networks 172.16.x.0/24, a link-local IPv6, the LAN
+ * 192.168.1.0/24 with the default gateway, and a smaller 192.168.1.128/25. */
+static void prvSetUp( size_t uxCount )
+{
+    size_t x;
+
+    vFakeKernelReset();
+    uxEndPointCount = 0U;
+
+    for( x = 0U; x < ( uxCount - 3U ); x++ )
+    {
+        prvAddIPv4( 0xAC100001UL | ( ( uint32_t ) x << 8 ), 0xFFFFFF00UL, 0U );
+    }
+
+    prvAddIPv6( 0xFEU, 0x80U, 10U, pdTRUE );
+    prvAddIPv4( 0xC0A80101UL, 0xFFFFFF00UL, 0xC0A801FEUL );
+    prvAddIPv4( 0xC0A80181UL, 0xFFFFFF80UL, 0U );
+
+    vRouteCacheInvalidate();
+}
+/*-----------------------------------------------------------*/
+
+static void prvIPv4( struct freertos_sockaddr * pxAddress,
+                     uint32_t ulAddress )
+{
+    memset( pxAddress, 0, sizeof( *pxAddress ) );
+    pxAddress->sin_family = FREERTOS_AF_INET4;
+    pxAddress->sin_address.ulIP_IPv4 = FreeRTOS_htonl( ulAddress );
+}
+/*-----------------------------------------------------------*/
+
+static uint64_t prvNanoseconds( void )
+{
+    struct timespec xNow;
+
+    clock_gettime( CLOCK_MONOTONIC, &xNow );
+
+    return ( ( uint64_t ) xNow.tv_sec * 1000000000ULL ) + ( uint64_t ) xNow.tv_nsec;
+}
+/*-----------------------------------------------------------*/
+
+static void test_longest_prefix( void )
+{
+    struct freertos_sockaddr xDestination;
+    Route_t xRoute;
+
+    prvSetUp( 5U );
+
+    /* On-link in the /25 and in the /24. */
+    prvIPv4( &xDestination, 0xC0A80190UL );
+    TEST_CHECK_EQUAL( pdPASS, xRouteCacheLookup( &xDestination, &xRoute ) );
+    TEST_CHECK( xRoute.pxEndPoint == &( xEndPoints[ 4 ] ) );
+    TEST_CHECK( xRoute.xOnLink != pdFALSE );
+
+    prvIPv4( &xDestination, 0xC0A80110UL );
+    TEST_CHECK_EQUAL( pdPASS, xRouteCacheLookup( &xDestination, &xRoute ) );
+    TEST_CHECK( xRoute.pxEndPoint == &( xEndPoints[ 3 ] ) );
+
+    /* Off-link goes to the gateway. */
+    prvIPv4( &xDestination, 0x08080808UL );
+    TEST_CHECK_EQUAL( pdPASS, xRouteCacheLookup( &xDestination, &xRoute ) );
+    TEST_CHECK( xRoute.pxEndPoint == &( xEndPoints[ 3 ] ) );
+    TEST_CHECK( xRoute.xOnLink == pdFALSE );
+    TEST_CHECK_EQUAL( FreeRTOS_htonl( 0xC0A801FEUL ), xRoute.xNextHop.ulIP_IPv4 );
+
+    /* Link-local IPv6. */
+    memset( &xDestination, 0, sizeof( xDestination ) );
+    xDestination.sin_family = FREERTOS_AF_INET6;
+    xDestination.sin_address.xIP_IPv6.ucBytes[ 0 ] = 0xFEU;
+    xDestination.sin_address.xIP_IPv6.ucBytes[ 1 ] = 0x80U;
+    xDestination.sin_address.xIP_IPv6.ucBytes[ 15 ] = 0x22U;
+    TEST_CHECK_EQUAL( pdPASS, xRouteCacheLookup( &xDestination, &xRoute ) );
+    TEST_CHECK( xRoute.pxEndPoint == &( xEndPoints[ 2 ] ) );
+    TEST_CHECK( xRoute.xOnLink != pdFALSE );
+}
+/*-----------------------------------------------------------*/
+
+static void test_no_route_and_invalidation( void )
+{
+    struct freertos_sockaddr xDestination;
+    Route_t xRoute;
+    RouteCacheStats_t xBefore;
+    RouteCacheStats_t xAfter;
+
+    prvSetUp( 5U );
+    prvIPv4( &xDestination, 0x08080808UL );
+
+    /* Without the gateway there is no route, and that is cached too. */
+    xEndPoints[ 3 ].bits.bEndPointUp = pdFALSE_UNSIGNED;
+    vRouteCacheInvalidate();
+    vRouteCacheGetStats( &xBefore );
+    TEST_CHECK_EQUAL( pdFAIL, xRouteCacheLookup( &xDestination, &xRoute ) );
+    TEST_CHECK_EQUAL( pdFAIL, xRouteCacheLookup( &xDestination, &xRoute ) );
+    vRouteCacheGetStats( &xAfter );
+    TEST_CHECK_EQUAL( 1, xAfter.ulMisses - xBefore.ulMisses );
+    TEST_CHECK_EQUAL( 1, xAfter.ulHits - xBefore.ulHits );
+
+    /* The end-point comes up: stale until invalidated. */
+    xEndPoints[ 3 ].bits.bEndPointUp = pdTRUE_UNSIGNED;
+    TEST_CHECK_EQUAL( pdFAIL, xRouteCacheLookup( &xDestination, &xRoute ) );
+    vRouteCacheInvalidate();
+    TEST_CHECK_EQUAL( pdPASS, xRouteCacheLookup( &xDestination, &xRoute ) );
+    TEST_CHECK( xRoute.pxEndPoint == &( xEndPoints[ 3 ] ) );
+}
+/*-----------------------------------------------------------*/
+
+/* Lookups of a few destinations, as the ping and log sender do, with and
+ * without the cache, for 3 to 32 end-points. */
+static void test_benchmark( void )
+{
+    static const size_t uxCounts[] = { 3U, 8U, 16U, 32U };
+    struct freertos_sockaddr xDestinations[ testDESTINATIONS ];
+    RouteCacheStats_t xBefore;
+    RouteCacheStats_t xAfter;
+    Route_t xRoute;
+    uint64_t ullStart;
+    uint64_t ullCachedNs;
+    uint64_t ullWalkNs;
+    uint32_t ulHitRate;
+    size_t x;
+    uint32_t ul;
+
+    for( x = 0U; x < testDESTINATIONS; x++ )
+    {
+        /* Some on-link, some through the gateway. */
+        prvIPv4( &( xDestinations[ x ] ), ( ( x & 1U ) != 0U ) ? ( 0xC0A80102UL + x ) : ( 0x08080800UL + x ) );
+    }
+
+    for( x = 0U; x < ( sizeof( uxCounts ) / sizeof( uxCounts[ 0 ] ) ); x++ )
+    {
+        prvSetUp( uxCounts[ x ] );
+        vRouteCacheGetStats( &xBefore );
+
+        ullStart = prvNanoseconds();
+
+        for( ul = 0U; ul < testLOOKUPS; ul++ )
+        {
+            TEST_CHECK_EQUAL( pdPASS, xRouteCacheLookup( &( xDestinations[ ul % testDESTINATIONS ] ), &xRoute ) );
+        }
+
+        ullCachedNs = prvNanoseconds() - ullStart;
+        vRouteCacheGetStats( &xAfter );
+
+        /* Colliding destinations evict each other, so this is not 100%. */
+        ulHitRate = ( uint32_t ) ( ( ( uint64_t ) ( xAfter.ulHits - xBefore.ulHits ) * 100U ) / testLOOKUPS );
+
+        ullStart = prvNanoseconds();
+
+        for( ul = 0U; ul < testLOOKUPS; ul++ )
+        {
+            vRouteCacheInvalidate();
+            TEST_CHECK_EQUAL( pdPASS, xRouteCacheLookup( &( xDestinations[ ul % testDESTINATIONS ] ), &xRoute ) );
+        }
+
+        ullWalkNs = prvNanoseconds() - ullStart;
+
+        printf( "  %2u end-points: cached %3u ns, walk %3u ns per lookup, %u%% hits\n",
+                ( unsigned ) uxCounts[ x ],
+                ( unsigned ) ( ullCachedNs / testLOOKUPS ),
+                ( unsigned ) ( ullWalkNs / testLOOKUPS ),
+                ( unsigned ) ulHitRate );
+
+        TEST_CHECK( ulHitRate >= 50U );
+
+        /* With 32 end-points the walk is far more work than the hash, so the
+         * order holds on any host, even a busy one. */
+        if( uxCounts[ x ] == 32U )
+        {
+            TEST_CHECK( ullCachedNs < ullWalkNs );
+        }
+    }
+}
+/*-----------------------------------------------------------*/
+
+int main( void )
+{
+    TEST_RUN( test_longest_prefix );
+    TEST_RUN( test_no_route_and_invalidation );
+    TEST_RUN( test_benchmark );
+
+    return 0;
+}
+/*-----------------------------------------------------------*/
@@ -0,0 +1,108 @@
+/* Standard includes. */
+#include <string.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "FreeRTOS_IP.h"
+#include "FreeRTOS_Sockets.h"
+
+#include "tcp_autotune.h"
+
+#include "fake_kernel.h"
+#include "fake_log.h"
+#include "sim_tcp.h"
+#include "test.h"
+
+#define testMSS    ipconfigTCP_MSS
+
+static struct freertos_sockaddr xRemoteA;
+static struct freertos_sockaddr xRemoteB;
+
+/*-----------------------------------------------------------*/
+
+static void prvSetUp( void )
+{
+    SimTCPConfig_t xConfig;
+
+    memset( &xConfig, 0, sizeof( xConfig ) );
+    xConfig.uxTxStreamSize = 8192U;
+    xConfig.ulPeerWindow = 8192U;
+
+    vFakeKernelReset();
+    vSimTCPInit( &xConfig );
+
+    memset( &xRemoteA, 0, sizeof( xRemoteA ) );
+    xRemoteA.sin_family = FREERTOS_AF_INET;
+    xRemoteA.sin_address.ulIP_IPv4 = FreeRTOS_htonl( 0xC0A80064UL );
+    memcpy( &xRemoteB, &xRemoteA, sizeof( xRemoteB ) );
+    xRemoteB.sin_address.ulIP_IPv4 = FreeRTOS_htonl( 0xC0A80065UL );
+}
+/*-----------------------------------------------------------*/
+
+static void test_budget_is_a_bound( void )
+{
+    TCPAutotune_t xLearn;
+    TCPAutotune_t xFirst;
+    TCPAutotune_t xSecond;
+    TCPAutotune_t xThird;
+    TCPAutotuneBudget_t xBudget;
+    Socket_t xSocket = xSimTCPSocket();
+
+    prvSetUp();
+
+    /* Learn a BDP of 10000 bytes for A: 10 ms RTT at 1 MB/s. */
+    TEST_CHECK_EQUAL( 0, xTCPAutotuneApply( &xLearn, xSocket, &xRemoteA ) );
+    TEST_CHECK_EQUAL( 4 * testMSS, xLearn.xWinProps.lRxBufSize );
+    vFakeKernelAdvance( pdMS_TO_TICKS( 10U ) );
+    vTCPAutotuneConnected( &xLearn );
+    vFakeKernelAdvance( pdMS_TO_TICKS( 100U ) );
+    vTCPAutotuneTransferred( &xLearn, 100000U );
+    vTCPAutotuneRelease( &xLearn );
+
+    vTCPAutotuneGetBudget( &xBudget );
+    TEST_CHECK_EQUAL( 0, xBudget.uxUsed );
+
+    /* Twice the BDP, in whole segments: 14 MSS for RX and for TX. */
+    TEST_CHECK_EQUAL( 0, xTCPAutotuneApply( &xFirst, xSocket, &xRemoteA ) );
+    TEST_CHECK_EQUAL( 14 * testMSS, xFirst.xWinProps.lRxBufSize );
+    TEST_CHECK_EQUAL( 14, xFirst.xWinProps.lTxWinSize );
+
+    /* Only 20 MSS are left of the 48. */
+    TEST_CHECK_EQUAL( 0, xTCPAutotuneApply( &xSecond, xSocket, &xRemoteA ) );
+    TEST_CHECK_EQUAL( 10 * testMSS, xSecond.xWinProps.lRxBufSize );
+
+    /* Nothing is left, not even the minimum. */
+    TEST_CHECK_EQUAL( -pdFREERTOS_ERRNO_ENOMEM, xTCPAutotuneApply( &xThird, xSocket, &xRemoteB ) );
+
+    vTCPAutotuneGetBudget( &xBudget );
+    TEST_CHECK_EQUAL( configTCP_AUTOTUNE_MEMORY_BUDGET, xBudget.uxUsed );
+    TEST_CHECK_EQUAL( configTCP_AUTOTUNE_MEMORY_BUDGET, xBudget.uxHighWater );
+    TEST_CHECK_EQUAL( 1, xBudget.ulShrunk );
+    TEST_CHECK_EQUAL( 1, xBudget.ulRefused );
+
+    /* Releasing a refused socket changes nothing. */
+    vTCPAutotuneRelease( &xThird );
+    vTCPAutotuneGetBudget( &xBudget );
+    TEST_CHECK_EQUAL( configTCP_AUTOTUNE_MEMORY_BUDGET, xBudget.uxUsed );
+
+    /* Room again once a socket is released. */
+    vTCPAutotuneRelease( &xSecond );
+    TEST_CHECK_EQUAL( 0, xTCPAutotuneApply( &xThird, xSocket, &xRemoteB ) );
+    TEST_CHECK_EQUAL( 4 * testMSS, xThird.xWinProps.lRxBufSize );
+
+    vTCPAutotuneReport();
+
+    vTCPAutotuneRelease( &xThird );
+    vTCPAutotuneRelease( &xFirst );
+    vTCPAutotuneGetBudget( &xBudget );
+    TEST_CHECK_EQUAL( 0, xBudget.uxUsed );
+}
+/*-----------------------------------------------------------*/
+
+int main( void )
+{
+    TEST_RUN( test_budget_is_a_bound );
+
+    return 0;
+}
+/*-----------------------------------------------------------*/
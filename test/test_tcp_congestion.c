@@ -0,0 +1,346 @@
+/* Standard includes. */
+#include <string.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "FreeRTOS_IP.h"
+#include "FreeRTOS_Sockets.h"
+
+#include "tcp_congestion.h"
+#include "tcp_sendfile.h"
+
+#include "fake_kernel.h"
+#include "sim_tcp.h"
+#include "test.h"
+
+#define testMSS    1460U
+
+static TCPTxQueue_t xQueue;
+static TCPCongestion_t xCC;
+static TCPTxRegion_t xRegion;
+static SimTCPConfig_t xConfig;
+
+/* The smallest cwnd seen while sending. */
+static uint32_t ulMinCwnd;
+
+/*-----------------------------------------------------------*/
+
+/* The pattern of the data depends on the offset only. */
+static uint8_t prvPattern( size_t uxOffset )
+{
+    return ( uint8_t ) ( ( uxOffset * 13U ) + ( uxOffset >> 9 ) );
+}
+/*-----------------------------------------------------------*/
+
+static void prvFill( TCPTxRegion_t * pxRegion,
+                     uint8_t * pucDestination,
+                     size_t uxOffset,
+                     size_t uxLength )
+{
+    size_t uxIndex;
+
+    ( void ) pxRegion;
+
+    for( uxIndex = 0U; uxIndex < uxLength; uxIndex++ )
+    {
+        pucDestination[ uxIndex ] = prvPattern( uxOffset + uxIndex );
+    }
+}
+/*-----------------------------------------------------------*/
+
+/* A bottleneck of one segment per tick (ms), so an RTT of 2 * ulDelay plus
+ * the time spent in its queue.  Tests may change xConfig before prvStart(). */
+static void prvConfigure( uint32_t ulDelay,
+                          uint32_t ulQueueLimit,
+                          uint32_t ulLossEvery )
+{
+    memset( &xConfig, 0, sizeof( xConfig ) );
+    xConfig.uxTxStreamSize = 64U * 1024U;
+    xConfig.ulMSS = testMSS;
+    xConfig.ulDelay = ulDelay;
+    xConfig.ulRate = testMSS;
+    xConfig.ulQueueLimit = ulQueueLimit;
+    xConfig.ulLossEvery = ulLossEvery;
+    xConfig.ulPeerWindow = 64U * 1024U;
+}
+/*-----------------------------------------------------------*/
+
+static void prvStart( const char * pcAlgorithm,
+                      size_t uxLength )
+{
+    vFakeKernelReset();
+    vSimTCPInit( &xConfig );
+
+    vTCPTxQueueInit( &xQueue, xSimTCPSocket() );
+    vTCPCongestionWatchInterface( pxSimTCPInterface() );
+    vTCPCongestionInit( &xCC, xSimTCPSocket(), NULL );
+    TEST_CHECK_EQUAL( pdPASS, xTCPCongestionSetAlgorithm( &xCC, pcAlgorithm ) );
+    vTCPTxQueueSetCongestion( &xQueue, &xCC );
+
+    memset( &xRegion, 0, sizeof( xRegion ) );
+    xRegion.uxLength = uxLength;
+    xRegion.fnFill = prvFill;
+    TEST_CHECK_EQUAL( pdPASS, xTCPTxQueueRegion( &xQueue, &xRegion ) );
+
+    ulMinCwnd = 0xFFFFFFFFUL;
+}
+/*-----------------------------------------------------------*/
+
+/* Send until the region is done, or until ulUntil bytes were acknowledged. */
+static BaseType_t prvRun( uint32_t ulUntil,
+                          TickType_t xLimit )
+{
+    BaseType_t xPending;
+    TickType_t xStart = xTaskGetTickCount();
+    TCPCongestionStats_t xStats;
+    SimTCPStats_t xSimStats;
+
+    do
+    {
+        xPending = xTCPTxQueueProcess( &xQueue, pdMS_TO_TICKS( 10U ) );
+
+        vTCPCongestionGetStats( &xCC, &xStats );
+
+        if( xStats.ulCwnd < ulMinCwnd )
+        {
+            ulMinCwnd = xStats.ulCwnd;
+        }
+
+        vSimTCPGetStats( &xSimStats );
+    } while( ( xPending > 0 ) && ( xSimStats.ulAcked < ulUntil ) &&
+             ( ( xTaskGetTickCount() - xStart ) < xLimit ) );
+
+    return xPending;
+}
+/*-----------------------------------------------------------*/
+
+static void prvCheckDelivered( size_t uxLength )
+{
+    SimTCPStats_t xStats;
+    const uint8_t * pucReceived = pucSimTCPReceived();
+    size_t uxIndex;
+
+    vSimTCPGetStats( &xStats );
+    TEST_CHECK_EQUAL( uxLength, xStats.ulDelivered );
+
+    for( uxIndex = 0U; uxIndex < uxLength; uxIndex++ )
+    {
+        TEST_CHECK_EQUAL( prvPattern( uxIndex ), pucReceived[ uxIndex ] );
+    }
+}
+/*-----------------------------------------------------------*/
+
+static void test_reno_growth( void )
+{
+    TCPCongestion_t xLocal;
+
+    /* Only the arithmetic, no connection. */
+    vFakeKernelReset();
+    memset( &xLocal, 0, sizeof( xLocal ) );
+    xLocal.ulMSS = testMSS;
+    xLocal.ulStreamQueued = 100U * testMSS;
+    xTCPCongestionReno.fnInit( &xLocal );
+    TEST_CHECK_EQUAL( 3U * testMSS, xLocal.ulCwnd );
+
+    /* Slow start: no more than 2 * MSS per ACK. */
+    xTCPCongestionReno.fnOnAck( &xLocal, 4U * testMSS, 0U );
+    TEST_CHECK_EQUAL( 5U * testMSS, xLocal.ulCwnd );
+
+    /* A loss with 10 segments in flight. */
+    xTCPCongestionReno.fnOnLoss( &xLocal, 10U * testMSS );
+    TEST_CHECK_EQUAL( 5U * testMSS, xLocal.ulSsthresh );
+    TEST_CHECK_EQUAL( 5U * testMSS, xLocal.ulCwnd );
+
+    /* Congestion avoidance: one MSS per window. */
+    xTCPCongestionReno.fnOnAck( &xLocal, 4U * testMSS, 0U );
+    TEST_CHECK_EQUAL( 5U * testMSS, xLocal.ulCwnd );
+    xTCPCongestionReno.fnOnAck( &xLocal, 1U * testMSS, 0U );
+    TEST_CHECK_EQUAL( 6U * testMSS, xLocal.ulCwnd );
+
+    /* Never below two segments. */
+    xTCPCongestionReno.fnOnLoss( &xLocal, testMSS );
+    TEST_CHECK_EQUAL( 2U * testMSS, xLocal.ulCwnd );
+}
+/*-----------------------------------------------------------*/
+
+static void test_reno_fast_recovery( void )
+{
+    const size_t uxLength = 2U * 1024U * 1024U;
+    TCPCongestionStats_t xStats;
+    SimTCPStats_t xSimStats;
+
+    /* A 40 ms RTT with one segment in 100 lost. */
+    prvConfigure( 20U, 0U, 100U );
+    prvStart( "reno", uxLength );
+
+    TEST_CHECK_EQUAL( 0, prvRun( 0xFFFFFFFFUL, 20000U ) );
+    prvCheckDelivered( uxLength );
+
+    vTCPCongestionGetStats( &xCC, &xStats );
+    vSimTCPGetStats( &xSimStats );
+
+    /* Every loss was repaired by a fast retransmit, and seen as such. */
+    TEST_CHECK( xSimStats.ulFastRetransmits > 0U );
+    TEST_CHECK_EQUAL( 0U, xSimStats.ulTimeouts );
+    TEST_CHECK_EQUAL( xSimStats.ulFastRetransmits, xStats.ulRecoveries );
+    TEST_CHECK_EQUAL( xSimStats.ulRetransmits, xStats.ulRetransmits );
+    TEST_CHECK_EQUAL( 0U, xStats.ulTimeouts );
+    TEST_CHECK( xStats.ulSsthresh < ( 64U * 1024U ) );
+
+    /* Halved, never back to slow start from one segment. */
+    TEST_CHECK( ulMinCwnd >= ( 2U * testMSS ) );
+    TEST_CHECK( xStats.ulSRTTMs >= 40U );
+}
+/*-----------------------------------------------------------*/
+
+static void test_fast_link( void )
+{
+    const size_t uxLength = 8U * 1024U * 1024U;
+    TCPCongestionStats_t xStats;
+    SimTCPStats_t xSimStats;
+
+    /* A 2 ms RTT and eight segments per tick: a whole window is acknowledged
+     * at once, one round trip after the previous one, without a loss. */
+    prvConfigure( 1U, 0U, 0U );
+    xConfig.ulRate = 8U * testMSS;
+    prvStart( "reno", uxLength );
+
+    TEST_CHECK_EQUAL( 0, prvRun( 0xFFFFFFFFUL, 20000U ) );
+    prvCheckDelivered( uxLength );
+
+    vTCPCongestionGetStats( &xCC, &xStats );
+    vSimTCPGetStats( &xSimStats );
+    TEST_CHECK_EQUAL( 0U, xSimStats.ulRetransmits );
+    TEST_CHECK_EQUAL( 0U, xStats.ulRetransmits );
+    TEST_CHECK_EQUAL( 0U, xStats.ulRecoveries );
+    TEST_CHECK_EQUAL( 0U, xStats.ulTimeouts );
+    TEST_CHECK_EQUAL( 0xFFFFFFFFUL, xStats.ulSsthresh );
+    TEST_CHECK( xStats.ulCwnd >= ( 16U * testMSS ) );
+
+    /* The same link with one segment in 200 lost: one recovery per loss. */
+    prvConfigure( 1U, 0U, 200U );
+    xConfig.ulRate = 8U * testMSS;
+    prvStart( "reno", uxLength );
+
+    TEST_CHECK_EQUAL( 0, prvRun( 0xFFFFFFFFUL, 20000U ) );
+    prvCheckDelivered( uxLength );
+
+    vTCPCongestionGetStats( &xCC, &xStats );
+    vSimTCPGetStats( &xSimStats );
+    TEST_CHECK( xSimStats.ulFastRetransmits > 0U );
+    TEST_CHECK_EQUAL( xSimStats.ulRetransmits, xStats.ulRetransmits );
+    TEST_CHECK_EQUAL( xSimStats.ulFastRetransmits + xSimStats.ulTimeouts, xStats.ulRecoveries + xStats.ulTimeouts );
+}
+/*-----------------------------------------------------------*/
+
+static void test_vegas_small_buffer( void )
+{
+    const size_t uxLength = 1024U * 1024U;
+    const uint32_t ulQueueLimit = 16U * testMSS;
+    SimTCPStats_t xSimStats;
+    TCPCongestionStats_t xStats;
+
+    /* Reno fills the bottleneck buffer until it overflows. */
+    prvConfigure( 10U, ulQueueLimit, 0U );
+    prvStart( "reno", uxLength );
+    TEST_CHECK_EQUAL( 0, prvRun( 0xFFFFFFFFUL, 20000U ) );
+    prvCheckDelivered( uxLength );
+    vSimTCPGetStats( &xSimStats );
+    TEST_CHECK( xSimStats.ulOverflows > 0U );
+
+    /* Vegas stops at a few segments in the queue. */
+    prvConfigure( 10U, ulQueueLimit, 0U );
+    prvStart( "vegas", uxLength );
+    TEST_CHECK_EQUAL( 0, prvRun( 0xFFFFFFFFUL, 20000U ) );
+    prvCheckDelivered( uxLength );
+    vSimTCPGetStats( &xSimStats );
+    vTCPCongestionGetStats( &xCC, &xStats );
+    TEST_CHECK_EQUAL( 0U, xSimStats.ulOverflows );
+    TEST_CHECK_EQUAL( 0U, xSimStats.ulRetransmits );
+    TEST_CHECK_EQUAL( 0U, xStats.ulRecoveries + xStats.ulTimeouts );
+}
+/*-----------------------------------------------------------*/
+
+static void test_timeout_loss( void )
+{
+    const size_t uxLength = 256U * 1024U;
+    TCPCongestionStats_t xStats;
+    TCPCongestionLosses_t xBefore;
+    TCPCongestionLosses_t xAfter;
+    SimTCPStats_t xSimStats;
+
+    /* A window of three segments can not produce three duplicate ACKs, so
+     * every loss waits for the time-out of the stack. */
+    prvConfigure( 10U, 0U, 20U );
+    xConfig.ulTxWindow = 3U;
+    xConfig.ulStackRTO = 500U;
+    prvStart( "reno", uxLength );
+    vTCPCongestionGetLosses( &xBefore );
+
+    TEST_CHECK_EQUAL( 0, prvRun( 0xFFFFFFFFUL, 60000U ) );
+    prvCheckDelivered( uxLength );
+
+    vTCPCongestionGetStats( &xCC, &xStats );
+    vSimTCPGetStats( &xSimStats );
+    TEST_CHECK_EQUAL( 0U, xSimStats.ulFastRetransmits );
+    TEST_CHECK( xSimStats.ulTimeouts > 0U );
+    TEST_CHECK_EQUAL( 0U, xStats.ulRecoveries );
+
+    /* The tap sees every retransmission, also of the last segment. */
+    TEST_CHECK_EQUAL( xSimStats.ulTimeouts, xStats.ulTimeouts );
+    TEST_CHECK_EQUAL( 0U, xStats.ulStalls );
+
+    /* The totals of all sockets. */
+    vTCPCongestionGetLosses( &xAfter );
+    TEST_CHECK_EQUAL( xStats.ulTimeouts, xAfter.ulTimeouts - xBefore.ulTimeouts );
+    TEST_CHECK_EQUAL( 0U, xAfter.ulRecoveries - xBefore.ulRecoveries );
+    TEST_CHECK( ulMinCwnd >= ( 2U * testMSS ) );
+}
+/*-----------------------------------------------------------*/
+
+static void test_zero_window( void )
+{
+    const size_t uxLength = 1024U * 1024U;
+    TCPCongestionStats_t xBefore;
+    TCPCongestionStats_t xAfter;
+    SimTCPStats_t xSimStats;
+
+    prvConfigure( 10U, 0U, 0U );
+    prvStart( "reno", uxLength );
+    TEST_CHECK_EQUAL( 1, prvRun( 200U * 1024U, 20000U ) );
+    vTCPCongestionGetStats( &xCC, &xBefore );
+
+    /* The peer stops reading for much longer than the RTO. */
+    vSimTCPSetPeerWindow( 0U );
+    TEST_CHECK_EQUAL( 1, prvRun( 0xFFFFFFFFUL, 3000U ) );
+    vSimTCPSetPeerWindow( 64U * 1024U );
+
+    TEST_CHECK_EQUAL( 0, prvRun( 0xFFFFFFFFUL, 20000U ) );
+    prvCheckDelivered( uxLength );
+
+    vTCPCongestionGetStats( &xCC, &xAfter );
+    vSimTCPGetStats( &xSimStats );
+    TEST_CHECK_EQUAL( 0U, xSimStats.ulRetransmits );
+
+    /* A stall, not a loss: the window is where it was. */
+    TEST_CHECK( xAfter.ulStalls >= 1U );
+    TEST_CHECK_EQUAL( 0U, xAfter.ulTimeouts );
+    TEST_CHECK_EQUAL( 0U, xAfter.ulRecoveries );
+    TEST_CHECK_EQUAL( xBefore.ulSsthresh, xAfter.ulSsthresh );
+    TEST_CHECK( xAfter.ulCwnd >= xBefore.ulCwnd );
+    TEST_CHECK( ulMinCwnd >= ( 2U * testMSS ) );
+}
+/*-----------------------------------------------------------*/
+
+int main( void )
+{
+    TEST_RUN( test_reno_growth );
+    TEST_RUN( test_reno_fast_recovery );
+    TEST_RUN( test_fast_link );
+    TEST_RUN( test_vegas_small_buffer );
+    TEST_RUN( test_timeout_loss );
+    TEST_RUN( test_zero_window );
+
+    return 0;
+}
+/*-----------------------------------------------------------*/
@@ -0,0 +1,98 @@
+/* Standard includes. */
+#include <string.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "tcp_isn.h"
+#include "entropy_pool.h"
+#include "uptime.h"
+
+#include "fake_kernel.h"
+#include "test.h"
+
+/* The key of the reference test vectors of SipHash: 00 01 02 .. 0f. */
+static uint8_t ucKey[ 16 ];
+static BaseType_t xSeeded;
+static uint32_t ulUptimeUs;
+
+/*-----------------------------------------------------------*/
+
+BaseType_t xEntropyPoolRandom( void * pvBuffer,
+                               size_t uxLength )
+{
+    if( xSeeded != pdFALSE )
+    {
+        memcpy( pvBuffer, ucKey, uxLength );
+    }
+
+    return xSeeded;
+}
+/*-----------------------------------------------------------*/
+
+uint32_t ulUptimeMicroseconds( void )
+{
+    return ulUptimeUs;
+}
+/*-----------------------------------------------------------*/
+
+static void prvSetUp( void )
+{
+    size_t x;
+
+    vFakeKernelReset();
+
+    for( x = 0U; x < sizeof( ucKey ); x++ )
+    {
+        ucKey[ x ] = ( uint8_t ) x;
+    }
+
+    xSeeded = pdTRUE;
+    ulUptimeUs = 0U;
+}
+/*-----------------------------------------------------------*/
+
+/* The message is the source address, the destination address and the two
+ * ports, as little endian words.  These arguments make it the bytes
+ * 00 01 02 .. 0b of the reference vector for a 12-byte message, whose
+ * SipHash-2-4 is 0x751e8fbc860ee5fb.  The ISN is its low 32 bits plus the
+ * microsecond clock. */
+static void test_siphash_known_answer( void )
+{
+    prvSetUp();
+    TEST_CHECK_EQUAL( pdPASS, xTCPISNInitialise() );
+
+    TEST_CHECK_EQUAL( 0x860EE5FBUL, ulTCPISNGenerate( 0x03020100UL, 0x0B0AU, 0x07060504UL, 0x0908U ) );
+
+    ulUptimeUs = 1000U;
+    TEST_CHECK_EQUAL( 0x860EE5FBUL + 1000UL, ulTCPISNGenerate( 0x03020100UL, 0x0B0AU, 0x07060504UL, 0x0908U ) );
+}
+/*-----------------------------------------------------------*/
+
+static void test_tuple_and_key( void )
+{
+    uint32_t ulFirst;
+
+    prvSetUp();
+    TEST_CHECK_EQUAL( pdPASS, xTCPISNInitialise() );
+
+    ulFirst = ulTCPISNGenerate( 0x03020100UL, 0x0B0AU, 0x07060504UL, 0x0908U );
+
+    /* Another port gives an unrelated ISN. */
+    TEST_CHECK( ulTCPISNGenerate( 0x03020100UL, 0x0B0BU, 0x07060504UL, 0x0908U ) != ulFirst );
+
+    /* The rekey timer reads a new key. */
+    ucKey[ 0 ] ^= 0x80U;
+    vFakeKernelAdvance( pdMS_TO_TICKS( configTCP_ISN_REKEY_PERIOD_MS ) );
+    TEST_CHECK( ulTCPISNGenerate( 0x03020100UL, 0x0B0AU, 0x07060504UL, 0x0908U ) != ulFirst );
+}
+/*-----------------------------------------------------------*/
+
+int main( void )
+{
+    TEST_RUN( test_siphash_known_answer );
+    TEST_RUN( test_tuple_and_key );
+
+    return 0;
+}
+/*-----------------------------------------------------------*/
@@ -0,0 +1,345 @@
+/* Standard includes. */
+#include <string.h>
+
+#include "FreeRTOS.h"
+#include "semphr.h"
+#include "FreeRTOS_IP.h"
+#include "FreeRTOS_Sockets.h"
+
+#include "tcp_rx_batch.h"
+
+#include "fake_kernel.h"
+#include "test.h"
+
+#define testMSS              1460U
+#define testSTREAM_SIZE      ( 24U * testMSS )
+#define testBUFFER_SIZE      ( 24U * testMSS )
+
+/* The receiving side of a connection: a stream that the test fills as the
+ * IP-task would, segment by segment, and the wake-up callback that the IP-task
+ * calls before it goes to sleep. */
+struct xSOCKET
+{
+    BaseType_t xConnected;
+    uint8_t ucStream[ testSTREAM_SIZE ];
+    size_t uxHead;
+    size_t uxTail;
+    uint32_t ulOffset;          /* Stream offset of the next byte to add. */
+    void ( * fnWakeUp )( Socket_t xSocket );
+    uint32_t ulWakeUpCalls;     /* Socket events, with or without a callback. */
+};
+
+static struct xSOCKET xSockets[ 2 ];
+static uint8_t ucBuffer[ testBUFFER_SIZE ];
+
+/*-----------------------------------------------------------*/
+
+static uint8_t prvPattern( uint32_t ulOffset,
+                           size_t uxSocket )
+{
+    return ( uint8_t ) ( ( ulOffset * 7U ) + ( ulOffset >> 8 ) + uxSocket );
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t FreeRTOS_setsockopt( Socket_t xSocket,
+                                int32_t lLevel,
+                                int32_t lOptionName,
+                                const void * pvOptionValue,
+                                size_t uxOptionLength )
+{
+    ( void ) lLevel;
+    ( void ) uxOptionLength;
+
+    /* As in FreeRTOS+TCP, the value is the function itself. */
+    if( lOptionName == FREERTOS_SO_WAKEUP_CALLBACK )
+    {
+        memcpy( &( xSocket->fnWakeUp ), &pvOptionValue, sizeof( void * ) );
+    }
+
+    return 0;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t FreeRTOS_rx_size( ConstSocket_t xSocket )
+{
+    return ( BaseType_t ) ( xSocket->uxHead - xSocket->uxTail );
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t FreeRTOS_issocketconnected( ConstSocket_t xSocket )
+{
+    return xSocket->xConnected;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t FreeRTOS_recv( Socket_t xSocket,
+                          void * pvBuffer,
+                          size_t uxBufferLength,
+                          BaseType_t xFlags )
+{
+    size_t uxLength = xSocket->uxHead - xSocket->uxTail;
+    BaseType_t xResult;
+
+    TEST_CHECK_EQUAL( FREERTOS_MSG_DONTWAIT, xFlags );
+
+    if( uxLength > uxBufferLength )
+    {
+        uxLength = uxBufferLength;
+    }
+
+    if( uxLength > 0U )
+    {
+        memcpy( pvBuffer, &( xSocket->ucStream[ xSocket->uxTail ] ), uxLength );
+        xSocket->uxTail += uxLength;
+
+        if( xSocket->uxTail == xSocket->uxHead )
+        {
+            xSocket->uxHead = 0U;
+            xSocket->uxTail = 0U;
+        }
+
+        xResult = ( BaseType_t ) uxLength;
+    }
+    else if( xSocket->xConnected == pdFALSE )
+    {
+        xResult = -pdFREERTOS_ERRNO_ENOTCONN;
+    }
+    else
+    {
+        xResult = -pdFREERTOS_ERRNO_EWOULDBLOCK;
+    }
+
+    return xResult;
+}
+/*-----------------------------------------------------------*/
+
+/* The IP-task stores a segment in the stream. */
+static void prvSegment( Socket_t xSocket,
+                        size_t uxLength )
+{
+    size_t uxIndex;
+
+    TEST_CHECK( ( xSocket->uxHead + uxLength ) <= testSTREAM_SIZE );
+
+    for( uxIndex = 0U; uxIndex < uxLength; uxIndex++ )
+    {
+        xSocket->ucStream[ xSocket->uxHead++ ] = prvPattern( xSocket->ulOffset++, ( size_t ) ( xSocket - xSockets ) );
+    }
+}
+/*-----------------------------------------------------------*/
+
+/* The IP-task goes to sleep, and tells the owner about the new data. */
+static void prvSleep( Socket_t xSocket )
+{
+    xSocket->ulWakeUpCalls++;
+
+    if( xSocket->fnWakeUp != NULL )
+    {
+        xSocket->fnWakeUp( xSocket );
+    }
+}
+/*-----------------------------------------------------------*/
+
+/* The reader takes all that is waiting, and checks it against the pattern. */
+static uint32_t prvRead( TCPRxBatch_t * pxBatch,
+                         uint32_t * pulOffset )
+{
+    BaseType_t xResult;
+    BaseType_t xIndex;
+    uint32_t ulTotal = 0U;
+    size_t uxSocket = ( size_t ) ( pxBatch->xSocket - xSockets );
+
+    do
+    {
+        xResult = xTCPRxBatchReceive( pxBatch, ucBuffer, sizeof( ucBuffer ) );
+
+        for( xIndex = 0; xIndex < xResult; xIndex++ )
+        {
+            TEST_CHECK_EQUAL( prvPattern( *pulOffset, uxSocket ), ucBuffer[ xIndex ] );
+            ( *pulOffset )++;
+        }
+
+        ulTotal += ( xResult > 0 ) ? ( uint32_t ) xResult : 0U;
+    } while( xResult > 0 );
+
+    return ulTotal;
+}
+/*-----------------------------------------------------------*/
+
+static void prvSetUp( void )
+{
+    vFakeKernelReset();
+    memset( xSockets, 0, sizeof( xSockets ) );
+    xSockets[ 0 ].xConnected = pdTRUE;
+    xSockets[ 1 ].xConnected = pdTRUE;
+}
+/*-----------------------------------------------------------*/
+
+static void test_trains( void )
+{
+    /* Trains of 1, 2, 3 and 4 segments, the last one short. */
+    static const size_t uxTrains[] = { 1U, 2U, 3U, 4U };
+    const size_t uxThreshold = 6U * testMSS;
+    SemaphoreHandle_t xWakeUp;
+    TCPRxBatch_t xBatch;
+    size_t uxTrain;
+    size_t uxSegment;
+    uint32_t ulRead = 0U;
+    uint32_t ulWakeUps = 0U;
+    uint32_t ulSent = 0U;
+    uint32_t ulWaiting;
+
+    prvSetUp();
+    xWakeUp = xSemaphoreCreateBinary();
+    TEST_CHECK_EQUAL( pdPASS, xTCPRxBatchInit( &xBatch, &( xSockets[ 0 ] ), xWakeUp, uxThreshold ) );
+    TEST_CHECK( xSockets[ 0 ].fnWakeUp != NULL );
+
+    for( uxTrain = 0U; uxTrain < 200U; uxTrain++ )
+    {
+        for( uxSegment = 0U; uxSegment < uxTrains[ uxTrain % 4U ]; uxSegment++ )
+        {
+            prvSegment( &( xSockets[ 0 ] ), ( uxSegment == 3U ) ? 100U : testMSS );
+            ulSent += ( uxSegment == 3U ) ? 100U : testMSS;
+        }
+
+        ulWaiting = ( uint32_t ) FreeRTOS_rx_size( &( xSockets[ 0 ] ) );
+        prvSleep( &( xSockets[ 0 ] ) );
+
+        /* The reader wakes only for a full batch, and then takes it all. */
+        if( xSemaphoreTake( xWakeUp, 0U ) == pdTRUE )
+        {
+            TEST_CHECK( ulWaiting >= uxThreshold );
+            ulWakeUps++;
+            TEST_CHECK_EQUAL( ulWaiting, prvRead( &xBatch, &ulRead ) );
+        }
+        else
+        {
+            TEST_CHECK( ulWaiting < uxThreshold );
+        }
+    }
+
+    /* The rest is taken when the reader's wait times out. */
+    TEST_CHECK_EQUAL( pdFALSE, xSemaphoreTake( xWakeUp, 100U ) );
+    ( void ) prvRead( &xBatch, &ulRead );
+    TEST_CHECK_EQUAL( ulSent, ulRead );
+
+    /* 200 deliveries of 2.3 segments on average, merged into batches of at
+     * least six segments. */
+    TEST_CHECK_EQUAL( 200U, xBatch.ulEvents );
+    TEST_CHECK_EQUAL( ulWakeUps, xBatch.ulWakeUps );
+    TEST_CHECK( xBatch.ulWakeUps <= ( ulSent / uxThreshold ) );
+    TEST_CHECK( ( xBatch.ulEvents / xBatch.ulWakeUps ) >= 2U );
+    TEST_CHECK_EQUAL( ulSent, xBatch.ulBytes );
+    TEST_CHECK( xBatch.ulReads >= xBatch.ulWakeUps );
+    TEST_CHECK( xBatch.ulReads <= ( xBatch.ulWakeUps + 1U ) );
+    TEST_CHECK( xBatch.ulLargestRead >= uxThreshold );
+
+    vTCPRxBatchDetach( &xBatch );
+    TEST_CHECK( xSockets[ 0 ].fnWakeUp == NULL );
+}
+/*-----------------------------------------------------------*/
+
+static void test_two_sockets( void )
+{
+    SemaphoreHandle_t xWakeUp;
+    TCPRxBatch_t xBatches[ 2 ];
+    uint32_t ulRead[ 2 ] = { 0U, 0U };
+    size_t uxRound;
+
+    /* One semaphore for both, each socket with its own threshold. */
+    prvSetUp();
+    xWakeUp = xSemaphoreCreateBinary();
+    TEST_CHECK_EQUAL( pdPASS, xTCPRxBatchInit( &( xBatches[ 0 ] ), &( xSockets[ 0 ] ), xWakeUp, 2U * testMSS ) );
+    TEST_CHECK_EQUAL( pdPASS, xTCPRxBatchInit( &( xBatches[ 1 ] ), &( xSockets[ 1 ] ), xWakeUp, 4U * testMSS ) );
+
+    for( uxRound = 0U; uxRound < 40U; uxRound++ )
+    {
+        /* One segment for each socket in the same run of the IP-task. */
+        prvSegment( &( xSockets[ 0 ] ), testMSS );
+        prvSegment( &( xSockets[ 1 ] ), testMSS );
+        prvSleep( &( xSockets[ 0 ] ) );
+        prvSleep( &( xSockets[ 1 ] ) );
+
+        if( xSemaphoreTake( xWakeUp, 0U ) == pdTRUE )
+        {
+            /* A shared wake-up: the reader looks at both. */
+            ( void ) prvRead( &( xBatches[ 0 ] ), &( ulRead[ 0 ] ) );
+            ( void ) prvRead( &( xBatches[ 1 ] ), &( ulRead[ 1 ] ) );
+        }
+    }
+
+    TEST_CHECK_EQUAL( 40U * testMSS, ulRead[ 0 ] );
+    TEST_CHECK_EQUAL( 20U, xBatches[ 0 ].ulWakeUps );
+    TEST_CHECK_EQUAL( 0U, xBatches[ 1 ].ulWakeUps );
+    TEST_CHECK_EQUAL( 40U, xBatches[ 1 ].ulEvents );
+    TEST_CHECK( ulRead[ 1 ] >= ( 38U * testMSS ) );
+
+    vTCPRxBatchDetach( &( xBatches[ 0 ] ) );
+    vTCPRxBatchDetach( &( xBatches[ 1 ] ) );
+}
+/*-----------------------------------------------------------*/
+
+static void test_closed( void )
+{
+    SemaphoreHandle_t xWakeUp;
+    TCPRxBatch_t xBatch;
+    uint32_t ulRead = 0U;
+
+    prvSetUp();
+    xWakeUp = xSemaphoreCreateBinary();
+    TEST_CHECK_EQUAL( pdPASS, xTCPRxBatchInit( &xBatch, &( xSockets[ 0 ] ), xWakeUp, 8U * testMSS ) );
+
+    /* Less than the threshold, then the peer closes: wake up for the rest. */
+    prvSegment( &( xSockets[ 0 ] ), 500U );
+    prvSleep( &( xSockets[ 0 ] ) );
+    TEST_CHECK_EQUAL( pdFALSE, xSemaphoreTake( xWakeUp, 0U ) );
+
+    xSockets[ 0 ].xConnected = pdFALSE;
+    prvSleep( &( xSockets[ 0 ] ) );
+    TEST_CHECK_EQUAL( pdTRUE, xSemaphoreTake( xWakeUp, 0U ) );
+    TEST_CHECK_EQUAL( 500U, prvRead( &xBatch, &ulRead ) );
+    TEST_CHECK_EQUAL( -pdFREERTOS_ERRNO_ENOTCONN, xTCPRxBatchReceive( &xBatch, ucBuffer, sizeof( ucBuffer ) ) );
+
+    vTCPRxBatchDetach( &xBatch );
+}
+/*-----------------------------------------------------------*/
+
+static void test_table( void )
+{
+    SemaphoreHandle_t xWakeUp;
+    TCPRxBatch_t xBatches[ configTCP_RX_BATCH_MAX_SOCKETS + 1U ];
+    size_t x;
+
+    prvSetUp();
+    xWakeUp = xSemaphoreCreateBinary();
+
+    for( x = 0U; x < configTCP_RX_BATCH_MAX_SOCKETS; x++ )
+    {
+        TEST_CHECK_EQUAL( pdPASS, xTCPRxBatchInit( &( xBatches[ x ] ), &( xSockets[ 0 ] ), xWakeUp, testMSS ) );
+    }
+
+    /* Full, until one is detached. */
+    TEST_CHECK_EQUAL( pdFAIL, xTCPRxBatchInit( &( xBatches[ x ] ), &( xSockets[ 1 ] ), xWakeUp, testMSS ) );
+    TEST_CHECK( xSockets[ 1 ].fnWakeUp == NULL );
+    vTCPRxBatchDetach( &( xBatches[ x ] ) );
+
+    vTCPRxBatchDetach( &( xBatches[ 0 ] ) );
+    TEST_CHECK_EQUAL( pdPASS, xTCPRxBatchInit( &( xBatches[ x ] ), &( xSockets[ 1 ] ), xWakeUp, testMSS ) );
+
+    for( x = 1U; x <= configTCP_RX_BATCH_MAX_SOCKETS; x++ )
+    {
+        vTCPRxBatchDetach( &( xBatches[ x ] ) );
+    }
+}
+/*-----------------------------------------------------------*/
+
+int main( void )
+{
+    TEST_RUN( test_trains );
+    TEST_RUN( test_two_sockets );
+    TEST_RUN( test_closed );
+    TEST_RUN( test_table );
+
+    return 0;
+}
+/*-----------------------------------------------------------*/
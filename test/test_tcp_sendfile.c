@@ -0,0 +1,427 @@
+/* Standard includes. */
+#include <string.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "FreeRTOS_IP.h"
+#include "FreeRTOS_Sockets.h"
+
+#include "tcp_sendfile.h"
+
+#include "fake_kernel.h"
+#include "sim_tcp.h"
+#include "test.h"
+
+#define testMAX_COMPLETIONS    64
+
+typedef struct xCOMPLETION
+{
+    TCPTxRegion_t * pxRegion;
+    BaseType_t xStatus;
+    uint32_t ulAcked;    /* Bytes acknowledged when the callback ran. */
+} Completion_t;
+
+static Completion_t xCompletions[ testMAX_COMPLETIONS ];
+static uint32_t ulCompletions;
+
+static TCPTxQueue_t xQueue;
+
+/* For test_requeue(). */
+static uint32_t ulRequeueLeft;
+
+static uint8_t ucData[ 64U * 1024U ];
+
+/*-----------------------------------------------------------*/
+
+static void prvSetUpLink( uint32_t ulRate,
+                          uint32_t ulDelay,
+                          size_t uxStreamSize,
+                          BaseType_t xNoFullSize )
+{
+    SimTCPConfig_t xConfig;
+    uint32_t ulIndex;
+
+    memset( &xConfig, 0, sizeof( xConfig ) );
+    xConfig.uxTxStreamSize = uxStreamSize;
+    xConfig.ulMSS = 1460U;
+    xConfig.ulDelay = ulDelay;
+    xConfig.ulRate = ulRate;
+    xConfig.ulPeerWindow = 16U * 1024U;
+    xConfig.xNoFullSize = xNoFullSize;
+
+    vFakeKernelReset();
+    vSimTCPInit( &xConfig );
+
+    memset( xCompletions, 0, sizeof( xCompletions ) );
+    ulCompletions = 0U;
+
+    for( ulIndex = 0U; ulIndex < sizeof( ucData ); ulIndex++ )
+    {
+        ucData[ ulIndex ] = ( uint8_t ) ( ( ulIndex * 7U ) ^ ( ulIndex >> 8 ) );
+    }
+
+    vTCPTxQueueInit( &xQueue, xSimTCPSocket() );
+}
+/*-----------------------------------------------------------*/
+
+static void prvSetUp( uint32_t ulRate,
+                      uint32_t ulDelay )
+{
+    prvSetUpLink( ulRate, ulDelay, 8192U, pdFALSE );
+}
+/*-----------------------------------------------------------*/
+
+static void prvCompleted( TCPTxRegion_t * pxRegion,
+                          BaseType_t xStatus )
+{
+    SimTCPStats_t xStats;
+
+    vSimTCPGetStats( &xStats );
+    TEST_CHECK( ulCompletions < testMAX_COMPLETIONS );
+    xCompletions[ ulCompletions ].pxRegion = pxRegion;
+    xCompletions[ ulCompletions ].xStatus = xStatus;
+    xCompletions[ ulCompletions ].ulAcked = xStats.ulAcked;
+    ulCompletions++;
+}
+/*-----------------------------------------------------------*/
+
+/* The pattern of produced regions depends on the offset only. */
+static uint8_t prvPattern( size_t uxOffset )
+{
+    return ( uint8_t ) ( ( uxOffset * 13U ) + ( uxOffset >> 9 ) );
+}
+/*-----------------------------------------------------------*/
+
+static void prvFill( TCPTxRegion_t * pxRegion,
+                     uint8_t * pucDestination,
+                     size_t uxOffset,
+                     size_t uxLength )
+{
+    size_t uxIndex;
+
+    ( void ) pxRegion;
+
+    for( uxIndex = 0U; uxIndex < uxLength; uxIndex++ )
+    {
+        pucDestination[ uxIndex ] = prvPattern( uxOffset + uxIndex );
+    }
+}
+/*-----------------------------------------------------------*/
+
+static void prvRequeue( TCPTxRegion_t * pxRegion,
+                        BaseType_t xStatus )
+{
+    prvCompleted( pxRegion, xStatus );
+
+    if( ( xStatus == pdPASS ) && ( ulRequeueLeft > 0U ) )
+    {
+        ulRequeueLeft--;
+        TEST_CHECK_EQUAL( pdPASS, xTCPTxQueueRegion( ( TCPTxQueue_t * ) pxRegion->pvContext, pxRegion ) );
+    }
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvRunUntilDone( TickType_t xLimit )
+{
+    BaseType_t xPending;
+    TickType_t xStart = xTaskGetTickCount();
+
+    do
+    {
+        xPending = xTCPTxQueueProcess( &xQueue, pdMS_TO_TICKS( 10U ) );
+    } while( ( xPending > 0 ) && ( ( xTaskGetTickCount() - xStart ) < xLimit ) );
+
+    return xPending;
+}
+/*-----------------------------------------------------------*/
+
+static void test_memory_regions( void )
+{
+    TCPTxRegion_t xRegions[ 3 ];
+    const size_t uxLengths[ 3 ] = { 3000U, 20000U, 1U };
+    size_t uxStart = 0U;
+    uint32_t ulIndex;
+    SimTCPStats_t xStats;
+
+    prvSetUp( 2000U, 5U );
+
+    memset( xRegions, 0, sizeof( xRegions ) );
+
+    for( ulIndex = 0U; ulIndex < 3U; ulIndex++ )
+    {
+        xRegions[ ulIndex ].pucData = &( ucData[ uxStart ] );
+        xRegions[ ulIndex ].uxLength = uxLengths[ ulIndex ];
+        xRegions[ ulIndex ].fnCallback = prvCompleted;
+        uxStart += uxLengths[ ulIndex ];
+        TEST_CHECK_EQUAL( pdPASS, xTCPTxQueueRegion( &xQueue, &( xRegions[ ulIndex ] ) ) );
+    }
+
+    TEST_CHECK_EQUAL( 0, prvRunUntilDone( 5000U ) );
+
+    /* In order, once each, and only after the peer acknowledged the last
+     * byte of the region. */
+    TEST_CHECK_EQUAL( 3, ulCompletions );
+    uxStart = 0U;
+
+    for( ulIndex = 0U; ulIndex < 3U; ulIndex++ )
+    {
+        uxStart += uxLengths[ ulIndex ];
+        TEST_CHECK( xCompletions[ ulIndex ].pxRegion == &( xRegions[ ulIndex ] ) );
+        TEST_CHECK_EQUAL( pdPASS, xCompletions[ ulIndex ].xStatus );
+        TEST_CHECK( xCompletions[ ulIndex ].ulAcked >= uxStart );
+    }
+
+    vSimTCPGetStats( &xStats );
+    TEST_CHECK_EQUAL( uxStart, xStats.ulDelivered );
+    TEST_CHECK( memcmp( pucSimTCPReceived(), ucData, uxStart ) == 0 );
+    TEST_CHECK_EQUAL( 3, xQueue.ulRegionsDone );
+
+    /* Only the very last segment is shorter than the MSS. */
+    TEST_CHECK_EQUAL( 1, xStats.ulPartialSegments );
+    TEST_CHECK( xSimTCPFullSize() == pdFALSE );
+
+    vTCPTxQueueAbort( &xQueue );
+    TEST_CHECK_EQUAL( 3, ulCompletions );
+}
+/*-----------------------------------------------------------*/
+
+static void test_produced_in_place( void )
+{
+    TCPTxRegion_t xRegion;
+    const size_t uxLength = 200000U;
+    const uint8_t * pucReceived;
+    size_t uxIndex;
+    SimTCPStats_t xStats;
+
+    prvSetUp( 3000U, 3U );
+
+    memset( &xRegion, 0, sizeof( xRegion ) );
+    xRegion.uxLength = uxLength;
+    xRegion.fnFill = prvFill;
+    xRegion.fnCallback = prvCompleted;
+    TEST_CHECK_EQUAL( pdPASS, xTCPTxQueueRegion( &xQueue, &xRegion ) );
+
+    TEST_CHECK_EQUAL( 0, prvRunUntilDone( 10000U ) );
+    TEST_CHECK_EQUAL( 1, ulCompletions );
+    TEST_CHECK_EQUAL( pdPASS, xCompletions[ 0 ].xStatus );
+
+    vSimTCPGetStats( &xStats );
+    TEST_CHECK_EQUAL( uxLength, xStats.ulDelivered );
+    pucReceived = pucSimTCPReceived();
+
+    for( uxIndex = 0U; uxIndex < uxLength; uxIndex++ )
+    {
+        TEST_CHECK_EQUAL( prvPattern( uxIndex ), pucReceived[ uxIndex ] );
+    }
+
+    /* Written in whole segments, never a write for a few bytes of space. */
+    TEST_CHECK( xStats.ulWrites <= xStats.ulSegments );
+    TEST_CHECK_EQUAL( 1, xStats.ulPartialSegments );
+
+    vTCPTxQueueAbort( &xQueue );
+}
+/*-----------------------------------------------------------*/
+
+/* Send 40 regions of 1000 bytes, the end of a region is never at the end of
+ * a segment. */
+static void prvSendSmallRegions( size_t uxStreamSize,
+                                 BaseType_t xNoFullSize,
+                                 SimTCPStats_t * pxStats,
+                                 TickType_t * pxTicks )
+{
+    static TCPTxRegion_t xRegions[ 40 ];
+    uint32_t ulIndex;
+
+    prvSetUpLink( 2U * 1460U, 5U, uxStreamSize, xNoFullSize );
+
+    memset( xRegions, 0, sizeof( xRegions ) );
+
+    for( ulIndex = 0U; ulIndex < 40U; ulIndex++ )
+    {
+        xRegions[ ulIndex ].pucData = &( ucData[ ulIndex * 1000U ] );
+        xRegions[ ulIndex ].uxLength = 1000U;
+        TEST_CHECK_EQUAL( pdPASS, xTCPTxQueueRegion( &xQueue, &( xRegions[ ulIndex ] ) ) );
+    }
+
+    TEST_CHECK_EQUAL( 0, prvRunUntilDone( 5000U ) );
+    *pxTicks = xTaskGetTickCount();
+    vSimTCPGetStats( pxStats );
+    TEST_CHECK_EQUAL( 40000U, pxStats->ulDelivered );
+    TEST_CHECK( memcmp( pucSimTCPReceived(), ucData, 40000U ) == 0 );
+
+    vTCPTxQueueAbort( &xQueue );
+}
+/*-----------------------------------------------------------*/
+
+static void prvReport( const char * pcName,
+                       const SimTCPStats_t * pxStats,
+                       TickType_t xTicks )
+{
+    printf( "%-18s %2u segments, %2u partial, %u ticks\n",
+            pcName,
+            ( unsigned ) pxStats->ulSegments,
+            ( unsigned ) pxStats->ulPartialSegments,
+            ( unsigned ) xTicks );
+}
+/*-----------------------------------------------------------*/
+
+static void test_full_size_trains( void )
+{
+    SimTCPStats_t xTrains;
+    SimTCPStats_t xPartial;
+    TickType_t xTrainTicks;
+    TickType_t xPartialTicks;
+
+    /* The same transfer, once with FREERTOS_SO_SET_FULL_SIZE, and once with
+     * a stack that sends whatever was written.  First with an 8 KB stream,
+     * which is the limit: the writer adds a region tail at a time. */
+    prvSendSmallRegions( 8192U, pdFALSE, &xTrains, &xTrainTicks );
+    prvSendSmallRegions( 8192U, pdTRUE, &xPartial, &xPartialTicks );
+    prvReport( "8 KB, full size", &xTrains, xTrainTicks );
+    prvReport( "8 KB, partial", &xPartial, xPartialTicks );
+
+    /* 28 segments is the least there can be for 40000 bytes. */
+    TEST_CHECK_EQUAL( 28, xTrains.ulSegments );
+    TEST_CHECK_EQUAL( 1, xTrains.ulPartialSegments );
+    TEST_CHECK( xPartial.ulPartialSegments >= 10U );
+    TEST_CHECK( xPartial.ulSegments >= ( xTrains.ulSegments + 5U ) );
+
+    /* A tail that waits in the stream is not in flight, which costs time
+     * while the stream is the limit. */
+    TEST_CHECK( xTrainTicks >= xPartialTicks );
+    TEST_CHECK( ( xTrainTicks * 4U ) <= ( xPartialTicks * 5U ) );
+
+    /* With a stream of ipconfigIPERF_TX_BUFSIZE the writer stays ahead of
+     * the stack, and there is nothing to hold back. */
+    prvSendSmallRegions( 24U * 1460U, pdFALSE, &xTrains, &xTrainTicks );
+    prvSendSmallRegions( 24U * 1460U, pdTRUE, &xPartial, &xPartialTicks );
+    prvReport( "35 KB, full size", &xTrains, xTrainTicks );
+    prvReport( "35 KB, partial", &xPartial, xPartialTicks );
+
+    TEST_CHECK_EQUAL( xPartial.ulSegments, xTrains.ulSegments );
+    TEST_CHECK_EQUAL( xPartialTicks, xTrainTicks );
+}
+/*-----------------------------------------------------------*/
+
+static void test_requeue( void )
+{
+    TCPTxRegion_t xRegions[ 2 ];
+    uint32_t ulIndex;
+    SimTCPStats_t xStats;
+
+    prvSetUp( 0U, 2U );
+
+    memset( xRegions, 0, sizeof( xRegions ) );
+    ulRequeueLeft = 8U;
+
+    for( ulIndex = 0U; ulIndex < 2U; ulIndex++ )
+    {
+        xRegions[ ulIndex ].uxLength = 4000U;
+        xRegions[ ulIndex ].fnCallback = prvRequeue;
+        xRegions[ ulIndex ].pvContext = &xQueue;
+        TEST_CHECK_EQUAL( pdPASS, xTCPTxQueueRegion( &xQueue, &( xRegions[ ulIndex ] ) ) );
+    }
+
+    TEST_CHECK_EQUAL( 0, prvRunUntilDone( 5000U ) );
+    TEST_CHECK_EQUAL( 10, ulCompletions );
+
+    /* The two buffers take turns. */
+    for( ulIndex = 0U; ulIndex < 10U; ulIndex++ )
+    {
+        TEST_CHECK( xCompletions[ ulIndex ].pxRegion == &( xRegions[ ulIndex % 2U ] ) );
+    }
+
+    vSimTCPGetStats( &xStats );
+    TEST_CHECK_EQUAL( 40000U, xStats.ulDelivered );
+
+    vTCPTxQueueAbort( &xQueue );
+}
+/*-----------------------------------------------------------*/
+
+static void test_abort( void )
+{
+    TCPTxRegion_t xRegions[ 3 ];
+    uint32_t ulIndex;
+
+    /* A slow link, so that nothing is acknowledged yet. */
+    prvSetUp( 100U, 50U );
+
+    memset( xRegions, 0, sizeof( xRegions ) );
+
+    for( ulIndex = 0U; ulIndex < 3U; ulIndex++ )
+    {
+        xRegions[ ulIndex ].pucData = ucData;
+        xRegions[ ulIndex ].uxLength = 5000U;
+        xRegions[ ulIndex ].fnCallback = prvCompleted;
+        TEST_CHECK_EQUAL( pdPASS, xTCPTxQueueRegion( &xQueue, &( xRegions[ ulIndex ] ) ) );
+    }
+
+    TEST_CHECK_EQUAL( 3, xTCPTxQueueProcess( &xQueue, 0U ) );
+    TEST_CHECK_EQUAL( 0, ulCompletions );
+
+    vTCPTxQueueAbort( &xQueue );
+
+    TEST_CHECK_EQUAL( 3, ulCompletions );
+
+    for( ulIndex = 0U; ulIndex < 3U; ulIndex++ )
+    {
+        TEST_CHECK( xCompletions[ ulIndex ].pxRegion == &( xRegions[ ulIndex ] ) );
+        TEST_CHECK_EQUAL( pdFAIL, xCompletions[ ulIndex ].xStatus );
+    }
+
+    TEST_CHECK_EQUAL( 3, xQueue.ulRegionsFailed );
+    TEST_CHECK( xQueue.xSocket == FREERTOS_INVALID_SOCKET );
+    TEST_CHECK( xSimTCPFullSize() == pdFALSE );
+}
+/*-----------------------------------------------------------*/
+
+static void test_disconnect( void )
+{
+    TCPTxRegion_t xRegion;
+
+    prvSetUp( 100U, 50U );
+
+    memset( &xRegion, 0, sizeof( xRegion ) );
+    xRegion.pucData = ucData;
+    xRegion.uxLength = sizeof( ucData );
+    xRegion.fnCallback = prvCompleted;
+    TEST_CHECK_EQUAL( pdPASS, xTCPTxQueueRegion( &xQueue, &xRegion ) );
+
+    TEST_CHECK_EQUAL( 1, xTCPTxQueueProcess( &xQueue, 0U ) );
+    vSimTCPDisconnect();
+
+    TEST_CHECK_EQUAL( -pdFREERTOS_ERRNO_ENOTCONN, xTCPTxQueueProcess( &xQueue, pdMS_TO_TICKS( 10U ) ) );
+    TEST_CHECK_EQUAL( 1, ulCompletions );
+    TEST_CHECK_EQUAL( pdFAIL, xCompletions[ 0 ].xStatus );
+}
+/*-----------------------------------------------------------*/
+
+static void test_invalid_region( void )
+{
+    TCPTxRegion_t xRegion;
+
+    prvSetUp( 0U, 1U );
+
+    memset( &xRegion, 0, sizeof( xRegion ) );
+    xRegion.pucData = ucData;
+    TEST_CHECK_EQUAL( pdFAIL, xTCPTxQueueRegion( &xQueue, &xRegion ) );
+    TEST_CHECK_EQUAL( pdFAIL, xTCPTxQueueRegion( &xQueue, NULL ) );
+    TEST_CHECK_EQUAL( 0, xTCPTxQueueProcess( &xQueue, 0U ) );
+
+    vTCPTxQueueAbort( &xQueue );
+}
+/*-----------------------------------------------------------*/
+
+int main( void )
+{
+    TEST_RUN( test_memory_regions );
+    TEST_RUN( test_produced_in_place );
+    TEST_RUN( test_full_size_trains );
+    TEST_RUN( test_requeue );
+    TEST_RUN( test_abort );
+    TEST_RUN( test_disconnect );
+    TEST_RUN( test_invalid_region );
+
+    return 0;
+}
+/*-----------------------------------------------------------*/
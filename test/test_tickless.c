@@ -0,0 +1,250 @@
+/* Included first, with its logMODULE, so that the static prvCompensate()
+ * and the statistics can be reached. */
+#include "tickless.c"
+
+/* Standard includes. */
+#include <string.h>
+
+#include "fake_hal.h"
+#include "fake_kernel.h"
+#include "test.h"
+
+/* An LSI of 31 kHz, 3 % below its nominal 32 kHz: 31 counts per tick. */
+#define testLSI_HZ           31000U
+#define testQ16              ( 31UL << 16 )
+#define testRELOAD           ( 64000000U / configTICK_RATE_HZ )
+
+/* How the sleep ends: after ulWakeAfter counts by another interrupt, or when
+ * 0, ulLateCounts after the compare match of LPTIM1. */
+static uint32_t ulWakeAfter;
+static uint32_t ulLateCounts;
+static uint32_t ulSleepCalls;
+static BaseType_t xSleptInStop;
+static uint32_t ulTraceCycles;
+
+static eSleepModeStatus eConfirm;
+
+/*-----------------------------------------------------------*/
+
+eSleepModeStatus eTaskConfirmSleepModeStatus( void )
+{
+    return eConfirm;
+}
+/*-----------------------------------------------------------*/
+
+void vTraceAddSleepCycles( uint32_t ulCycles )
+{
+    ulTraceCycles += ulCycles;
+}
+/*-----------------------------------------------------------*/
+
+static void prvSleep( BaseType_t xStop )
+{
+    ulSleepCalls++;
+    xSleptInStop = xStop;
+
+    if( ulWakeAfter != 0U )
+    {
+        LPTIM1->CNT = ( LPTIM1->CNT + ulWakeAfter ) & ticklessCOUNTER_MASK;
+        LPTIM1->ISR &= ~LPTIM_ISR_CMPM;
+    }
+    else
+    {
+        LPTIM1->CNT = ( LPTIM1->CMP + ulLateCounts ) & ticklessCOUNTER_MASK;
+        LPTIM1->ISR |= LPTIM_ISR_CMPM;
+    }
+}
+/*-----------------------------------------------------------*/
+
+/* At the start of a tick, with the LSI calibrated at exactly 31 counts. */
+static void prvSetUp( void )
+{
+    vFakeKernelReset();
+    vFakeHALSetSleepHook( prvSleep );
+
+    memset( &xStats, 0, sizeof( xStats ) );
+    xStats.ulCountsPerTickQ16 = testQ16;
+    xStopAllowed = pdFALSE;
+    eConfirm = eStandardSleep;
+    uwTick = 0U;
+
+    SysTick->LOAD = testRELOAD - 1U;
+    SysTick->VAL = testRELOAD - 1U;
+    SysTick->CTRL = SysTick_CTRL_ENABLE_Msk;
+    LPTIM1->ISR = LPTIM_ISR_CMPOK;
+    LPTIM1->CNT = 0U;
+
+    ulWakeAfter = 0U;
+    ulLateCounts = 0U;
+    ulSleepCalls = 0U;
+    xSleptInStop = pdFALSE;
+    ulTraceCycles = 0U;
+}
+/*-----------------------------------------------------------*/
+
+static void test_calibration( void )
+{
+    vFakeKernelReset();
+    vFakeHALSetClocks( testLSI_HZ, 1000U );
+    memset( &xStats, 0, sizeof( xStats ) );
+
+    /* The LSI does not start. */
+    RCC->CSR = 0U;
+    TEST_CHECK_EQUAL( pdFAIL, xTicklessInitialise() );
+
+    RCC->CSR = RCC_CSR_LSIRDY;
+    LPTIM1->ISR = LPTIM_ISR_ARROK;
+    TEST_CHECK_EQUAL( pdPASS, xTicklessInitialise() );
+
+    TEST_CHECK( llabs( ( long long ) xStats.ulCountsPerTickQ16 - ( long long ) testQ16 ) < ( long long ) ( testQ16 / 200U ) );
+    TEST_CHECK( ( LPTIM1->CR & LPTIM_CR_ENABLE ) != 0U );
+    TEST_CHECK( ( EXTI_D1->IMR2 & EXTI_IMR2_IM47 ) != 0U );
+    TEST_CHECK( ( EXTI_D1->IMR3 & EXTI_IMR3_IM86 ) != 0U );
+
+    vFakeHALSetClocks( testLSI_HZ, 0U );
+}
+/*-----------------------------------------------------------*/
+
+static void test_compensate( void )
+{
+    TickType_t xTicks;
+    uint32_t ulCount;
+
+    /* Woke at once: SysTick counts the whole tick. */
+    prvCompensate( 0U, testQ16, testRELOAD, 99U, &xTicks, &ulCount );
+    TEST_CHECK_EQUAL( 0U, xTicks );
+    TEST_CHECK_EQUAL( testRELOAD, ulCount );
+
+    /* Five and a half ticks. */
+    prvCompensate( ( 11ULL * testQ16 ) / 2U, testQ16, testRELOAD, 99U, &xTicks, &ulCount );
+    TEST_CHECK_EQUAL( 5U, xTicks );
+    TEST_CHECK_EQUAL( testRELOAD / 2U, ulCount );
+
+    /* Just before a tick: SysTick gets its shortest period. */
+    prvCompensate( testQ16 - 1U, testQ16, testRELOAD, 99U, &xTicks, &ulCount );
+    TEST_CHECK_EQUAL( 0U, xTicks );
+    TEST_CHECK_EQUAL( ticklessMIN_SYSTICK, ulCount );
+
+    /* Exactly the longest sleep, and past it. */
+    prvCompensate( 99ULL * testQ16, testQ16, testRELOAD, 99U, &xTicks, &ulCount );
+    TEST_CHECK_EQUAL( 99U, xTicks );
+    TEST_CHECK_EQUAL( testRELOAD, ulCount );
+
+    prvCompensate( 150ULL * testQ16, testQ16, testRELOAD, 99U, &xTicks, &ulCount );
+    TEST_CHECK_EQUAL( 99U, xTicks );
+    TEST_CHECK_EQUAL( ticklessMIN_SYSTICK, ulCount );
+}
+/*-----------------------------------------------------------*/
+
+/* The sleep starts 16 counts before the counter wraps.  100 ticks are 3100
+ * counts, less 3.1 for the budget of 100 us. */
+static void test_timer_wake_across_wrap( void )
+{
+    prvSetUp();
+    LPTIM1->CNT = 0xFFF0U;
+    ulLateCounts = 2U;
+
+    vPortSuppressTicksAndSleep( 100U );
+
+    TEST_CHECK_EQUAL( 1U, ulSleepCalls );
+    TEST_CHECK_EQUAL( ( 0xFFF0U + 3096U ) & ticklessCOUNTER_MASK, LPTIM1->CMP );
+
+    /* 3098 counts are 99.9 ticks. */
+    TEST_CHECK_EQUAL( 99U, xTaskGetTickCount() );
+    TEST_CHECK_EQUAL( 99U, uwTick );
+    TEST_CHECK_EQUAL( 99U, xStats.ulTicksSuppressed );
+    TEST_CHECK_EQUAL( 1U, xStats.ulSleeps );
+    TEST_CHECK_EQUAL( 64U, xStats.ulMaxLatencyUs );
+    TEST_CHECK_EQUAL( 0U, xStats.ulOverBudget );
+    TEST_CHECK_EQUAL( testRELOAD - 1U, SysTick->LOAD );
+    TEST_CHECK( ( SysTick->CTRL & SysTick_CTRL_ENABLE_Msk ) != 0U );
+
+    /* The trace is told of the 3098 counts, 99.94 ms at 64 MHz. */
+    TEST_CHECK_EQUAL( ( uint32_t ) ( ( 3098ULL * testRELOAD ) / 31U ), ulTraceCycles );
+
+    /* 10 counts late is over the budget, and past the due tick. */
+    ulLateCounts = 10U;
+    vPortSuppressTicksAndSleep( 100U );
+
+    TEST_CHECK_EQUAL( 198U, xTaskGetTickCount() );
+    TEST_CHECK_EQUAL( 322U, xStats.ulMaxLatencyUs );
+    TEST_CHECK_EQUAL( 1U, xStats.ulOverBudget );
+}
+/*-----------------------------------------------------------*/
+
+/* An Ethernet interrupt ends the sleep after 500 counts, 16.1 ticks. */
+static void test_early_wake( void )
+{
+    prvSetUp();
+    LPTIM1->CNT = 100U;
+    ulWakeAfter = 500U;
+
+    vPortSuppressTicksAndSleep( 100U );
+
+    TEST_CHECK_EQUAL( 16U, xTaskGetTickCount() );
+    TEST_CHECK_EQUAL( 0U, xStats.ulMaxLatencyUs );
+    TEST_CHECK_EQUAL( 0U, xStats.ulOverBudget );
+
+    /* Half way into a tick: 15.5 counts had passed, so 10 ticks are
+     * 310 - 15.5 - 3.1 counts away, and waking then makes 9.9 ticks. */
+    SysTick->VAL = ( testRELOAD / 2U ) - 1U;
+    ulWakeAfter = 0U;
+    ulLateCounts = 0U;
+
+    vPortSuppressTicksAndSleep( 10U );
+
+    TEST_CHECK_EQUAL( ( 100U + 500U + 291U ) & ticklessCOUNTER_MASK, LPTIM1->CNT );
+    TEST_CHECK_EQUAL( 16U + 9U, xTaskGetTickCount() );
+}
+/*-----------------------------------------------------------*/
+
+static void test_not_suppressed( void )
+{
+    prvSetUp();
+
+    /* 26 of the 31 counts of the tick have passed. */
+    SysTick->VAL = 10000U;
+    vPortSuppressTicksAndSleep( 1U );
+    TEST_CHECK_EQUAL( 1U, xStats.ulTooShort );
+
+    eConfirm = eAbortSleep;
+    SysTick->VAL = testRELOAD - 1U;
+    vPortSuppressTicksAndSleep( 100U );
+    TEST_CHECK_EQUAL( 1U, xStats.ulAborted );
+
+    TEST_CHECK_EQUAL( 0U, ulSleepCalls );
+    TEST_CHECK_EQUAL( 0U, xTaskGetTickCount() );
+    TEST_CHECK( ( SysTick->CTRL & SysTick_CTRL_ENABLE_Msk ) != 0U );
+}
+/*-----------------------------------------------------------*/
+
+/* Stop mode wakes 500 us, 15.5 counts, ahead. */
+static void test_stop_mode( void )
+{
+    prvSetUp();
+    vTicklessAllowStop( pdTRUE );
+
+    vPortSuppressTicksAndSleep( 100U );
+
+    TEST_CHECK( xSleptInStop != pdFALSE );
+    TEST_CHECK_EQUAL( 3084U, LPTIM1->CMP );
+    TEST_CHECK_EQUAL( 1U, xStats.ulStops );
+    TEST_CHECK_EQUAL( 0U, xStats.ulSleeps );
+    TEST_CHECK_EQUAL( 99U, xTaskGetTickCount() );
+
+    vTicklessAllowStop( pdFALSE );
+}
+/*-----------------------------------------------------------*/
+
+int main( void )
+{
+    TEST_RUN( test_calibration );
+    TEST_RUN( test_compensate );
+    TEST_RUN( test_timer_wake_across_wrap );
+    TEST_RUN( test_early_wake );
+    TEST_RUN( test_not_suppressed );
+    TEST_RUN( test_stop_mode );
+
+    return 0;
+}
+/*-----------------------------------------------------------*/
@@ -0,0 +1,358 @@
+/* Standard includes. */
+#include <setjmp.h>
+#include <string.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "FreeRTOS_IP.h"
+#include "FreeRTOS_Sockets.h"
+#include "FreeRTOS_DNS.h"
+
+#include "sntp.h"
+#include "wall_clock.h"
+#include "uptime.h"
+
+#include "fake_kernel.h"
+#include "test.h"
+
+/* A local stand-in of an NTP server.  Its clock is the uptime clock, running
+ * lServerPpm faster, plus llServerOffsetUs.  A request is answered at once,
+ * with a one-way delay of testDELAY_US in both directions. */
+#define testSERVER_IP        0x0A000001UL
+#define testDELAY_US         10000U
+#define testUNIX_EPOCH       2208988800ULL
+
+/* 2023-11-14, in microseconds since 1970. */
+#define testTRUE_START_US    ( 1700000000ULL * 1000000ULL )
+
+static uint64_t ullUptimeUs;
+static int64_t llServerOffsetUs;
+static int32_t lServerPpm;
+
+static uint8_t ucRequest[ 48 ];
+static BaseType_t xRequestPending;
+static uint32_t ulReplies;
+
+/* The SNTP task runs on the test thread, and is stopped by a jump out of
+ * FreeRTOS_sendto() once ulStopAfter requests were answered. */
+static TaskFunction_t fnSNTPTask;
+static uint32_t ulStopAfter;
+static jmp_buf xStop;
+
+/* While set, the tick hook checks that the wall clock never goes back. */
+static BaseType_t xCheckMonotonic;
+static uint64_t ullLastWall;
+
+/*-----------------------------------------------------------*/
+
+uint64_t ullUptimeMicroseconds( void )
+{
+    return ullUptimeUs;
+}
+/*-----------------------------------------------------------*/
+
+uint32_t ulUptimeMicroseconds( void )
+{
+    return ( uint32_t ) ullUptimeUs;
+}
+/*-----------------------------------------------------------*/
+
+static uint64_t prvServerTime( void )
+{
+    return ( uint64_t ) ( ( int64_t ) ullUptimeUs + ( ( ( int64_t ) ullUptimeUs * lServerPpm ) / 1000000 ) + llServerOffsetUs );
+}
+/*-----------------------------------------------------------*/
+
+static int64_t prvError( void )
+{
+    return ( int64_t ) ( ullWallClockMicroseconds() - prvServerTime() );
+}
+/*-----------------------------------------------------------*/
+
+static void prvTickHook( void )
+{
+    uint64_t ullWall;
+
+    ullUptimeUs += 1000U;
+
+    if( xCheckMonotonic != pdFALSE )
+    {
+        ullWall = ullWallClockMicroseconds();
+        TEST_CHECK( ullWall >= ullLastWall );
+        ullLastWall = ullWall;
+    }
+}
+/*-----------------------------------------------------------*/
+
+static void prvWriteTimestamp( uint8_t * pucTimestamp,
+                               uint64_t ullUnixUs )
+{
+    uint32_t ulSeconds = FreeRTOS_htonl( ( uint32_t ) ( ( ullUnixUs / 1000000U ) + testUNIX_EPOCH ) );
+    uint32_t ulFraction = FreeRTOS_htonl( ( uint32_t ) ( ( ( ullUnixUs % 1000000U ) << 32 ) / 1000000U ) );
+
+    memcpy( &( pucTimestamp[ 0 ] ), &ulSeconds, sizeof( ulSeconds ) );
+    memcpy( &( pucTimestamp[ 4 ] ), &ulFraction, sizeof( ulFraction ) );
+}
+/*-----------------------------------------------------------*/
+
+uint32_t FreeRTOS_gethostbyname( const char * pcHostName )
+{
+    ( void ) pcHostName;
+
+    return FreeRTOS_htonl( testSERVER_IP );
+}
+/*-----------------------------------------------------------*/
+
+Socket_t FreeRTOS_socket( BaseType_t xDomain,
+                          BaseType_t xType,
+                          BaseType_t xProtocol )
+{
+    ( void ) xDomain;
+    ( void ) xType;
+    ( void ) xProtocol;
+
+    xRequestPending = pdFALSE;
+
+    return ( Socket_t ) &xRequestPending;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t FreeRTOS_setsockopt( Socket_t xSocket,
+                                int32_t lLevel,
+                                int32_t lOptionName,
+                                const void * pvOptionValue,
+                                size_t uxOptionLength )
+{
+    ( void ) xSocket;
+    ( void ) lLevel;
+    ( void ) lOptionName;
+    ( void ) pvOptionValue;
+    ( void ) uxOptionLength;
+
+    return 0;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t FreeRTOS_bind( Socket_t xSocket,
+                          struct freertos_sockaddr const * pxAddress,
+                          uint32_t xAddressLength )
+{
+    ( void ) xSocket;
+    ( void ) pxAddress;
+    ( void ) xAddressLength;
+
+    return 0;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t FreeRTOS_closesocket( Socket_t xSocket )
+{
+    ( void ) xSocket;
+
+    return 1;
+}
+/*-----------------------------------------------------------*/
+
+int32_t FreeRTOS_sendto( Socket_t xSocket,
+                         const void * pvBuffer,
+                         size_t uxTotalDataLength,
+                         BaseType_t xFlags,
+                         const struct freertos_sockaddr * pxDestinationAddress,
+                         uint32_t xDestinationAddressLength )
+{
+    ( void ) xSocket;
+    ( void ) xFlags;
+    ( void ) xDestinationAddressLength;
+
+    if( ulReplies >= ulStopAfter )
+    {
+        longjmp( xStop, 1 );
+    }
+
+    TEST_CHECK_EQUAL( sizeof( ucRequest ), uxTotalDataLength );
+    TEST_CHECK_EQUAL( FreeRTOS_htonl( testSERVER_IP ), pxDestinationAddress->sin_address.ulIP_IPv4 );
+    TEST_CHECK_EQUAL( FreeRTOS_htons( 123U ), pxDestinationAddress->sin_port );
+
+    memcpy( ucRequest, pvBuffer, sizeof( ucRequest ) );
+    xRequestPending = pdTRUE;
+
+    return ( int32_t ) uxTotalDataLength;
+}
+/*-----------------------------------------------------------*/
+
+int32_t FreeRTOS_recvfrom( Socket_t xSocket,
+                           void * pvBuffer,
+                           size_t uxBufferLength,
+                           BaseType_t xFlags,
+                           struct freertos_sockaddr * pxSourceAddress,
+                           uint32_t * pxSourceAddressLength )
+{
+    uint8_t * pucReply = ( uint8_t * ) pvBuffer;
+    int32_t lReturn = -pdFREERTOS_ERRNO_EWOULDBLOCK;
+
+    ( void ) xSocket;
+    ( void ) xFlags;
+    ( void ) pxSourceAddressLength;
+
+    if( xRequestPending != pdFALSE )
+    {
+        xRequestPending = pdFALSE;
+        TEST_CHECK( uxBufferLength >= sizeof( ucRequest ) );
+
+        /* LI 0, version 4, mode 4 (server), stratum 2. */
+        memset( pucReply, 0, sizeof( ucRequest ) );
+        pucReply[ 0 ] = 0x24U;
+        pucReply[ 1 ] = 2U;
+        memcpy( &( pucReply[ 24 ] ), &( ucRequest[ 40 ] ), 8U );
+
+        ullUptimeUs += testDELAY_US;
+        prvWriteTimestamp( &( pucReply[ 32 ] ), prvServerTime() );
+        prvWriteTimestamp( &( pucReply[ 40 ] ), prvServerTime() );
+        ullUptimeUs += testDELAY_US;
+
+        memset( pxSourceAddress, 0, sizeof( *pxSourceAddress ) );
+        pxSourceAddress->sin_family = FREERTOS_AF_INET;
+        pxSourceAddress->sin_port = FreeRTOS_htons( 123U );
+        pxSourceAddress->sin_address.ulIP_IPv4 = FreeRTOS_htonl( testSERVER_IP );
+
+        ulReplies++;
+        lReturn = ( int32_t ) sizeof( ucRequest );
+    }
+
+    return lReturn;
+}
+/*-----------------------------------------------------------*/
+
+/* Let the SNTP task do ulPolls more polls. */
+static void prvRunSNTP( uint32_t ulPolls )
+{
+    ulStopAfter = ulReplies + ulPolls;
+    ullLastWall = ullWallClockMicroseconds();
+
+    if( setjmp( xStop ) == 0 )
+    {
+        fnSNTPTask( NULL );
+    }
+
+    TEST_CHECK_EQUAL( ulStopAfter, ulReplies );
+}
+/*-----------------------------------------------------------*/
+
+static void test_sntp_sets_clock( void )
+{
+    SNTPStatus_t xStatus;
+
+    vFakeKernelReset();
+    vFakeKernelSetTickHook( prvTickHook );
+    ullUptimeUs = 5000000U;
+    llServerOffsetUs = ( int64_t ) testTRUE_START_US;
+    lServerPpm = 0;
+
+    TEST_CHECK( xWallClockIsSet() == pdFALSE );
+    TEST_CHECK_EQUAL( pdPASS, xSNTPStart( 512U, tskIDLE_PRIORITY + 1U ) );
+    fnSNTPTask = pxFakeKernelLastTask();
+
+    prvRunSNTP( 1U );
+
+    TEST_CHECK( xWallClockIsSet() != pdFALSE );
+    TEST_CHECK( llabs( prvError() ) < 10 );
+
+    vSNTPGetStatus( &xStatus );
+    TEST_CHECK_EQUAL( 1U, xStatus.ulPolls );
+    TEST_CHECK_EQUAL( 0U, xStatus.ulFailures );
+    TEST_CHECK_EQUAL( 2U, xStatus.ucStratum );
+    TEST_CHECK( llabs( ( int64_t ) xStatus.ulLastDelayUs - ( 2 * testDELAY_US ) ) < 10 );
+}
+/*-----------------------------------------------------------*/
+
+/* The crystal of the board is 100 ppm slow.  The clock keeps close to the
+ * server while the poll interval grows, and keeps time without polls. */
+static void test_sntp_trains_drift( void )
+{
+    int64_t llBefore;
+
+    xCheckMonotonic = pdTRUE;
+    llServerOffsetUs -= ( ( int64_t ) ullUptimeUs * 100 ) / 1000000;
+    lServerPpm = 100;
+
+    prvRunSNTP( 12U );
+
+    /* Untrained, it would be 100 ms off by the time of the next poll. */
+    TEST_CHECK( llabs( prvError() ) < 10000 );
+
+    /* An hour without a correction, within 10 ppm. */
+    xCheckMonotonic = pdFALSE;
+    llBefore = prvError();
+    ullUptimeUs += 3600ULL * 1000000ULL;
+    TEST_CHECK( llabs( prvError() - llBefore ) < 36000 );
+}
+/*-----------------------------------------------------------*/
+
+/* The server goes back 400 ms: slewed in 80 s, never stepped back. */
+static void test_sntp_slews_backward( void )
+{
+    SNTPStatus_t xStatus;
+
+    xCheckMonotonic = pdTRUE;
+    llServerOffsetUs -= 400000;
+
+    prvRunSNTP( 1U );
+    vSNTPGetStatus( &xStatus );
+    TEST_CHECK( xStatus.llLastOffsetUs < -350000 );
+
+    /* Stopped at the next poll, 16 s into the slew of 80 s. */
+    TEST_CHECK( prvError() > 250000 );
+
+    vFakeKernelAdvance( pdMS_TO_TICKS( 80000U ) );
+    xCheckMonotonic = pdFALSE;
+
+    TEST_CHECK( llabs( prvError() ) < 10000 );
+}
+/*-----------------------------------------------------------*/
+
+static void test_set_by_hand_steps( void )
+{
+    uint64_t ullBefore = ullWallClockMicroseconds();
+
+    vWallClockCorrect( -10000000, pdFALSE );
+    TEST_CHECK( llabs( ( int64_t ) ( ullBefore - ullWallClockMicroseconds() ) - 10000000 ) < 10 );
+
+    vWallClockCorrect( 10000000, pdFALSE );
+    TEST_CHECK( llabs( ( int64_t ) ( ullWallClockMicroseconds() - ullBefore ) ) < 10 );
+}
+/*-----------------------------------------------------------*/
+
+/* At the largest frequency correction, 300 days without a correction. */
+static void test_long_run_without_correction( void )
+{
+    uint64_t ullElapsed = 300ULL * 86400ULL * 1000000ULL;
+    uint64_t ullStart;
+    int64_t llError;
+
+    ullUptimeUs += 20ULL * 1000000ULL;
+    vWallClockCorrect( 900000, pdTRUE );
+
+    /* Until the slew is done. */
+    ullUptimeUs += 200ULL * 1000000ULL;
+
+    ullStart = ullWallClockMicroseconds();
+    ullUptimeUs += ullElapsed;
+    llError = ( int64_t ) ( ullWallClockMicroseconds() - ullStart ) -
+              ( int64_t ) ( ullElapsed + ( ( ullElapsed / 1000000U ) * configWALL_CLOCK_MAX_DRIFT_PPM ) );
+
+    TEST_CHECK( llabs( llError ) < 1000 );
+}
+/*-----------------------------------------------------------*/
+
+int main( void )
+{
+    /* In this order: each test goes on with the clock of the one before. */
+    TEST_RUN( test_sntp_sets_clock );
+    TEST_RUN( test_sntp_trains_drift );
+    TEST_RUN( test_sntp_slews_backward );
+    TEST_RUN( test_set_by_hand_steps );
+    TEST_RUN( test_long_run_without_correction );
+
+    return 0;
+}
+/*-----------------------------------------------------------*/
@@ -0,0 +1,210 @@
+#!/usr/bin/env python3
+"""Decode the crash dump of Libraries/FreeRTOS-Plus-CLI/crash.h.
+
+The input is either a log that holds the "crash-dump" lines written by
+xCrashReport(), or a binary image of RAM_D3, for example from gdb:
+
+    dump binary memory ram_d3.bin 0x38000000 0x38004000
+
+    crash_dump.py boot.log
+    crash_dump.py ram_d3.bin --elf build/firmware.elf
+"""
+
+import argparse
+import re
+import struct
+import subprocess
+import sys
+import zlib
+
+MAGIC = 0x48535243
+VERSION = 3
+
+HEADER = struct.Struct("<IHHIIII8I3I5II16s48sIHHHHI")
+TASK = struct.Struct("<II16s")
+EVENT = struct.Struct("<IHHII")
+
+FLAG_FRAME = 0x01
+FLAG_NESTED = 0x02
+
+# The events of Libraries/FreeRTOS-Plus-CLI/trace_events.h.
+EVENTS = {
+    1: "switched in", 2: "task created", 3: "task deleted", 4: "queue receive block",
+    5: "queue send block", 6: "event group wait", 7: "event group wait end", 8: "delay",
+    16: "rx", 17: "tx", 18: "no network buffer", 19: "rx event lost", 20: "tx event lost",
+    32: "mark",
+}
+TASK_EVENTS = (1, 2, 3)
+
+REASONS = [
+    "none",
+    "hard fault",
+    "memory management fault",
+    "bus fault",
+    "usage fault",
+    "stack overflow",
+    "malloc failed",
+    "assert",
+    "Error_Handler",
+]
+
+CFSR_BITS = {
+    0: "IACCVIOL", 1: "DACCVIOL", 3: "MUNSTKERR", 4: "MSTKERR", 5: "MLSPERR", 7: "MMARVALID",
+    8: "IBUSERR", 9: "PRECISERR", 10: "IMPRECISERR", 11: "UNSTKERR", 12: "STKERR", 13: "LSPERR",
+    15: "BFARVALID", 16: "UNDEFINSTR", 17: "INVSTATE", 18: "INVPC", 19: "NOCP", 24: "UNALIGNED",
+    25: "DIVBYZERO",
+}
+
+HFSR_BITS = {1: "VECTTBL", 30: "FORCED", 31: "DEBUGEVT"}
+
+LOG_LINE = re.compile(r"crash-dump ([0-9a-f]{4}) ([0-9a-f]+)")
+
+
+def text(raw):
+    return raw.split(b"\0", 1)[0].decode("ascii", "replace")
+
+
+def bits(value, names):
+    return " ".join(name for bit, name in sorted(names.items()) if value & (1 << bit)) or "-"
+
+
+def from_log(data):
+    """Reassemble the dump from "crash-dump <offset> <hex>" lines.  The last
+    dump in the log wins."""
+    dump = bytearray()
+    for line in data.decode("ascii", "replace").splitlines():
+        match = LOG_LINE.search(line)
+        if match is None:
+            continue
+        offset = int(match.group(1), 16)
+        if offset == 0:
+            dump = bytearray()
+        if offset != len(dump):
+            raise ValueError("crash-dump line at offset %#x is missing" % len(dump))
+        dump += bytes.fromhex(match.group(2))
+    return bytes(dump)
+
+
+def find_dump(image):
+    for offset in range(0, len(image) - HEADER.size, 4):
+        if struct.unpack_from("<I", image, offset)[0] == MAGIC:
+            return image[offset:]
+    raise ValueError("no crash dump found")
+
+
+def parse(data):
+    fields = HEADER.unpack_from(data, 0)
+    (magic, version, size, reason, flags, count, tick) = fields[0:7]
+    frame = fields[7:15]
+    (exc_return, msp, psp, cfsr, hfsr, mmfar, bfar, afsr, current) = fields[15:24]
+    (current_name, message, line, max_tasks, ntasks, max_events, nevents, cpu_hz) = fields[24:32]
+
+    if magic != MAGIC:
+        raise ValueError("bad magic %#010x" % magic)
+    if version != VERSION:
+        raise ValueError("dump version %u, this parser reads %u" % (version, VERSION))
+    if size > len(data):
+        raise ValueError("dump of %u bytes, only %u present" % (size, len(data)))
+    crc = struct.unpack_from("<I", data, size - 4)[0]
+    if zlib.crc32(data[:size - 4]) != crc:
+        raise ValueError("CRC mismatch")
+
+    offset = HEADER.size
+    tasks = []
+    for i in range(max_tasks):
+        handle, stack_free, name = TASK.unpack_from(data, offset + i * TASK.size)
+        if i < ntasks:
+            tasks.append((handle, stack_free, text(name)))
+    offset += max_tasks * TASK.size
+    events = [EVENT.unpack_from(data, offset + i * EVENT.size) for i in range(nevents)]
+    events = [(cycles, event, arg1, arg2) for cycles, event, _, arg1, arg2 in events]
+
+    return {
+        "reason": REASONS[reason] if reason < len(REASONS) else "reason %u" % reason,
+        "flags": flags, "count": count, "tick": tick, "frame": frame,
+        "exc_return": exc_return, "msp": msp, "psp": psp,
+        "cfsr": cfsr, "hfsr": hfsr, "mmfar": mmfar, "bfar": bfar, "afsr": afsr,
+        "current": current, "current_name": text(current_name),
+        "text": text(message), "line": line, "tasks": tasks, "events": events,
+        "cpu_hz": cpu_hz,
+    }
+
+
+def symbolise(elf, address):
+    if elf is None:
+        return ""
+    try:
+        out = subprocess.run(["arm-none-eabi-addr2line", "-f", "-C", "-e", elf, "%#x" % (address & ~1)],
+                             capture_output=True, text=True, check=True).stdout.split("\n")
+    except (OSError, subprocess.CalledProcessError):
+        return ""
+    return "  %s %s" % (out[0], out[1])
+
+
+def report(dump, elf, cpu_hz):
+    cpu_hz = cpu_hz or dump["cpu_hz"]
+    frame = dump["frame"]
+    print("%s in task \"%s\" (%#010x) at tick %u, crash %u since power-on"
+          % (dump["reason"], dump["current_name"], dump["current"], dump["tick"], dump["count"]))
+    if dump["flags"] & FLAG_NESTED:
+        print("faulted again during the capture, the dump may be incomplete")
+    if dump["text"]:
+        print("at %s:%u" % (dump["text"], dump["line"]))
+
+    if dump["flags"] & FLAG_FRAME:
+        for name, value in zip(("r0", "r1", "r2", "r3", "r12"), frame[0:5]):
+            print("  %-4s %#010x" % (name, value))
+        print("  lr   %#010x%s" % (frame[5], symbolise(elf, frame[5])))
+        print("  pc   %#010x%s" % (frame[6], symbolise(elf, frame[6])))
+        print("  xpsr %#010x" % frame[7])
+        print("  exc_return %#010x (%s stack)" % (dump["exc_return"], "process" if dump["exc_return"] & 4 else "main"))
+    else:
+        print("  called from %#010x%s" % (frame[6], symbolise(elf, frame[6])))
+    print("  msp  %#010x  psp %#010x" % (dump["msp"], dump["psp"]))
+    print("  cfsr %#010x  %s" % (dump["cfsr"], bits(dump["cfsr"], CFSR_BITS)))
+    print("  hfsr %#010x  %s" % (dump["hfsr"], bits(dump["hfsr"], HFSR_BITS)))
+    if dump["cfsr"] & (1 << 7):
+        print("  mmfar %#010x" % dump["mmfar"])
+    if dump["cfsr"] & (1 << 15):
+        print("  bfar  %#010x" % dump["bfar"])
+
+    names = {}
+    print("\ntasks (free stack in words):")
+    for handle, stack_free, name in dump["tasks"]:
+        names[handle] = name
+        print("  %#010x %-16s %6u%s" % (handle, name, stack_free, "  <- low" if stack_free < 32 else ""))
+
+    if dump["events"]:
+        print("\nlast trace events, microseconds before the last one:")
+        last = dump["events"][-1][0]
+        for cycles, event, arg1, arg2 in dump["events"]:
+            before = ((last - cycles) & 0xFFFFFFFF) * 1e6 / cpu_hz
+            name = EVENTS.get(event, "event %u" % event)
+            if event in TASK_EVENTS:
+                print("  %12.1f  %-20s %s" % (before, name, names.get(arg1, "%#010x" % arg1)))
+            else:
+                print("  %12.1f  %-20s %#010x %#010x" % (before, name, arg1, arg2))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("input", help="log file or binary image of RAM_D3")
+    parser.add_argument("--elf", help="firmware, to resolve PC and LR with arm-none-eabi-addr2line")
+    parser.add_argument("--cpu-hz", type=float, help="CPU clock of the time stamps (default: as recorded in the dump)")
+    args = parser.parse_args()
+
+    with open(args.input, "rb") as f:
+        data = f.read()
+
+    try:
+        if b"crash-dump " in data:
+            dump = from_log(data)
+        else:
+            dump = find_dump(data)
+        report(parse(dump), args.elf, args.cpu_hz)
+    except (ValueError, struct.error) as e:
+        sys.exit("%s: %s" % (args.input, e))
+
+
+if __name__ == "__main__":
+    main()
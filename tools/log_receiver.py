@@ -0,0 +1,94 @@
+#!/usr/bin/env python3
+"""Receive the log that Libraries/FreeRTOS-Plus-CLI/logging/log_udp.h sends.
+
+Each datagram holds one or more RFC 5424 messages, one per line.  The
+messages are printed one per line, and gaps in their sequenceId are reported:
+
+    log_receiver.py --port 514
+    log_receiver.py --port 5514 --raw >> board.log
+
+Binding port 514 needs root; set configLOG_COLLECTOR_PORT to another port, or
+forward it, to run as a user.
+"""
+
+import argparse
+import re
+import socket
+import sys
+import time
+
+MESSAGE = re.compile(r"^<(\d+)>1 (\S+) (\S+) (\S+) \S+ \S+ "
+                     r"(?:\[meta sequenceId=\"(\d+)\"\]|-) ?(.*)$")
+
+SEVERITIES = ["emerg", "alert", "crit", "err", "warning", "notice", "info", "debug"]
+
+
+class Receiver:
+    def __init__(self, raw):
+        self.raw = raw
+        self.expected = {}    # Next sequenceId per sender.
+        self.messages = 0
+        self.datagrams = 0
+        self.missing = 0
+
+    def add_datagram(self, data, sender):
+        self.datagrams += 1
+        for line in data.decode("utf-8", "replace").split("\n"):
+            if line:
+                self.add_message(line, sender)
+
+    def add_message(self, line, sender):
+        self.messages += 1
+        match = MESSAGE.match(line)
+        if match is None or self.raw:
+            print(line, flush=True)
+            return
+
+        priority, stamp, host, _, sequence, text = match.groups()
+        if sequence is not None:
+            sequence = int(sequence)
+            expected = self.expected.get(sender)
+            if expected is not None and sequence != expected:
+                if sequence > expected:
+                    self.missing += sequence - expected
+                    print("--- %u messages missing from %s" % (sequence - expected, host), flush=True)
+                else:
+                    print("--- %s restarted" % host, flush=True)
+            self.expected[sender] = sequence + 1
+
+        severity = SEVERITIES[int(priority) & 7]
+        print("%s %s %-7s %s" % (stamp, host, severity, text), flush=True)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--port", type=int, default=514)
+    parser.add_argument("--seconds", type=float, default=0, help="stop after this time, default at Ctrl-C")
+    parser.add_argument("--raw", action="store_true", help="print the messages as received")
+    args = parser.parse_args()
+
+    try:
+        sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+        sock.bind(("", args.port))
+    except OSError as e:
+        sys.exit("port %u: %s" % (args.port, e))
+    sock.settimeout(0.5)
+
+    receiver = Receiver(args.raw)
+    end = time.monotonic() + args.seconds if args.seconds else None
+    try:
+        while end is None or time.monotonic() < end:
+            try:
+                data, sender = sock.recvfrom(2048)
+            except socket.timeout:
+                continue
+            receiver.add_datagram(data, sender[0])
+    except KeyboardInterrupt:
+        pass
+
+    print("%u messages in %u datagrams, %u missing"
+          % (receiver.messages, receiver.datagrams, receiver.missing), file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,239 @@
+#!/usr/bin/env python3
+"""Receive and convert the event trace of Libraries/FreeRTOS-Plus-CLI/trace.h.
+
+Record the datagrams that the board streams, then convert them into a
+Chrome JSON trace that ui.perfetto.dev opens:
+
+    trace_to_perfetto.py receive --port 5555 --seconds 10 capture.bin
+    trace_to_perfetto.py convert capture.bin trace.json
+
+The input of "convert" can also be a memory image of the ring, for example
+from gdb:
+
+    dump binary value ring.bin xTraceRing
+
+Context switches become slices on one track per task.  Event group waits,
+which include socket waits, become async slices on the track of the waiting
+task.  Frames received and sent are instants on a "network" track.
+"""
+
+import argparse
+import json
+import socket
+import struct
+import sys
+import time
+
+RING_MAGIC = 0x474E5254
+DATAGRAM_MAGIC = 0x45435254
+VERSION = 1
+
+DATAGRAM_EVENTS = 1
+DATAGRAM_NAMES = 2
+
+HEADER = struct.Struct("<IHHIIIHH")
+EVENT = struct.Struct("<IHHII")
+NAME = struct.Struct("<I16s")
+RING = struct.Struct("<IIII")
+
+TASK_SWITCHED_IN = 1
+TASK_CREATE = 2
+TASK_DELETE = 3
+QUEUE_RECEIVE_BLOCK = 4
+QUEUE_SEND_BLOCK = 5
+EVENT_GROUP_WAIT = 6
+EVENT_GROUP_WAIT_END = 7
+TASK_DELAY = 8
+NET_RX = 16
+NET_TX = 17
+NET_BUFFER_FAILURE = 18
+NET_RX_EVENT_LOST = 19
+NET_TX_EVENT_LOST = 20
+MARK = 32
+
+PID = 1
+NETWORK_TID = 0
+
+
+class Trace:
+    def __init__(self):
+        self.events = {}     # Sequence number to (cycles, event, arg1, arg2).
+        self.names = {}
+        self.cpu_hz = None
+        self.lost = 0
+
+    def add_datagram(self, data):
+        magic, version, kind, cpu_hz, sequence, lost, count, _ = HEADER.unpack_from(data, 0)
+        if magic != DATAGRAM_MAGIC or version != VERSION:
+            return
+        self.cpu_hz = cpu_hz
+        self.lost = max(self.lost, lost)
+        if kind == DATAGRAM_EVENTS:
+            for i in range(count):
+                cycles, event, _, arg1, arg2 = EVENT.unpack_from(data, HEADER.size + i * EVENT.size)
+                self.events[(sequence + i) & 0xFFFFFFFF] = (cycles, event, arg1, arg2)
+        elif kind == DATAGRAM_NAMES:
+            for i in range(count):
+                handle, name = NAME.unpack_from(data, HEADER.size + i * NAME.size)
+                self.names[handle] = name.split(b"\0", 1)[0].decode("ascii", "replace")
+
+    def add_ring(self, data, offset):
+        _, size, head, cpu_hz = RING.unpack_from(data, offset)
+        self.cpu_hz = cpu_hz
+        first = head - size if head > size else 0
+        for number in range(first, head):
+            slot = offset + RING.size + (number % size) * EVENT.size
+            cycles, event, sequence, arg1, arg2 = EVENT.unpack_from(data, slot)
+            if sequence == number & 0xFFFF:
+                self.events[number] = (cycles, event, arg1, arg2)
+
+
+def read_capture(path, trace):
+    with open(path, "rb") as f:
+        data = f.read()
+    if len(data) >= 6 and struct.unpack_from("<I", data, 2)[0] == DATAGRAM_MAGIC:
+        offset = 0
+        while offset + 2 <= len(data):
+            (length,) = struct.unpack_from("<H", data, offset)
+            trace.add_datagram(data[offset + 2:offset + 2 + length])
+            offset += 2 + length
+        return
+    for offset in range(0, len(data) - RING.size, 4):
+        if struct.unpack_from("<I", data, offset)[0] == RING_MAGIC:
+            trace.add_ring(data, offset)
+            return
+    raise ValueError("%s: neither a capture nor a trace ring" % path)
+
+
+def receive(args):
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    sock.bind(("", args.port))
+    sock.settimeout(0.5)
+    end = time.monotonic() + args.seconds if args.seconds else None
+    count = 0
+    with open(args.output, "wb") as f:
+        try:
+            while end is None or time.monotonic() < end:
+                try:
+                    data = sock.recv(2048)
+                except socket.timeout:
+                    continue
+                f.write(struct.pack("<H", len(data)) + data)
+                count += 1
+        except KeyboardInterrupt:
+            pass
+    print("%u datagrams" % count, file=sys.stderr)
+
+
+def convert(args):
+    trace = Trace()
+    for path in args.input:
+        read_capture(path, trace)
+    if not trace.events:
+        sys.exit("no events")
+
+    cpu_hz = args.cpu_hz or trace.cpu_hz
+    out = []
+    tasks = set()
+
+    def task_name(handle):
+        return trace.names.get(handle, "%#010x" % handle)
+
+    def instant(ts, tid, name, scope="t", **fields):
+        out.append({"ph": "i", "s": scope, "name": name, "pid": PID, "tid": tid, "ts": ts, "args": fields})
+
+    # Unwrap the 32-bit cycle counter in the order of the event numbers.  An
+    # interrupt can take a number before the event it interrupted was stamped,
+    # so small steps back are allowed.
+    numbers = sorted(trace.events)
+    gaps = sum(1 for a, b in zip(numbers, numbers[1:]) if b != a + 1)
+    previous = trace.events[numbers[0]][0]
+    now = 0
+    current = None
+    running_since = None
+    waits = {}
+
+    for number in numbers:
+        cycles, event, arg1, arg2 = trace.events[number]
+        delta = (cycles - previous) & 0xFFFFFFFF
+        if delta >= 0x80000000:
+            delta -= 0x100000000
+        now += delta
+        previous = cycles
+        ts = now * 1e6 / cpu_hz
+
+        if event == TASK_SWITCHED_IN:
+            if current is not None and running_since is not None:
+                out.append({"ph": "X", "name": task_name(current), "pid": PID, "tid": current,
+                            "ts": running_since, "dur": max(ts - running_since, 0)})
+            current = arg1
+            running_since = ts
+            tasks.add(arg1)
+        elif event == TASK_CREATE:
+            tasks.add(arg1)
+            instant(ts, arg1, "created", priority=arg2)
+        elif event == TASK_DELETE:
+            instant(ts, arg1, "deleted")
+        elif event in (QUEUE_RECEIVE_BLOCK, QUEUE_SEND_BLOCK) and current is not None:
+            instant(ts, current, "block on queue " + ("receive" if event == QUEUE_RECEIVE_BLOCK else "send"),
+                    queue="%#010x" % arg1)
+        elif event == EVENT_GROUP_WAIT and current is not None:
+            waits[current] = (arg1, number)
+            out.append({"ph": "b", "cat": "wait", "id": number, "name": "wait %#010x" % arg1,
+                        "pid": PID, "tid": current, "ts": ts, "args": {"bits": "%#x" % arg2}})
+        elif event == EVENT_GROUP_WAIT_END and current in waits:
+            group, ident = waits.pop(current)
+            out.append({"ph": "e", "cat": "wait", "id": ident, "name": "wait %#010x" % group,
+                        "pid": PID, "tid": current, "ts": ts, "args": {"timed_out": arg2}})
+        elif event == TASK_DELAY and current is not None:
+            instant(ts, current, "delay", ticks=arg1)
+        elif event == NET_RX:
+            instant(ts, NETWORK_TID, "rx")
+        elif event == NET_TX:
+            instant(ts, NETWORK_TID, "tx", length=arg1)
+        elif event == NET_BUFFER_FAILURE:
+            instant(ts, NETWORK_TID, "no network buffer", "g")
+        elif event == NET_RX_EVENT_LOST:
+            instant(ts, NETWORK_TID, "rx event lost", "g")
+        elif event == NET_TX_EVENT_LOST:
+            instant(ts, NETWORK_TID, "tx event lost", "g", event=arg1)
+        elif event == MARK:
+            instant(ts, current if current is not None else NETWORK_TID, "mark %u" % arg1, value=arg2)
+
+    out.append({"ph": "M", "name": "process_name", "pid": PID, "args": {"name": "STM32H7"}})
+    out.append({"ph": "M", "name": "thread_name", "pid": PID, "tid": NETWORK_TID, "args": {"name": "network"}})
+    for handle in tasks:
+        out.append({"ph": "M", "name": "thread_name", "pid": PID, "tid": handle, "args": {"name": task_name(handle)}})
+
+    with open(args.output, "w") as f:
+        json.dump({"traceEvents": out, "displayTimeUnit": "ns"}, f)
+
+    print("%u events, %u lost on the board, %u gaps in the capture, %.3f s"
+          % (len(numbers), trace.lost, gaps, now / cpu_hz), file=sys.stderr)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    commands = parser.add_subparsers(dest="command", required=True)
+
+    p = commands.add_parser("receive", help="record the datagrams of the board")
+    p.add_argument("--port", type=int, default=5555)
+    p.add_argument("--seconds", type=float, default=0, help="stop after this time, default at Ctrl-C")
+    p.add_argument("output")
+    p.set_defaults(func=receive)
+
+    p = commands.add_parser("convert", help="write a JSON trace for Perfetto")
+    p.add_argument("input", nargs="+", help="captures or ring images")
+    p.add_argument("output")
+    p.add_argument("--cpu-hz", type=float, help="override the clock in the trace")
+    p.set_defaults(func=convert)
+
+    args = parser.parse_args()
+    try:
+        args.func(args)
+    except (OSError, ValueError, struct.error) as e:
+        sys.exit(str(e))
+
+
+if __name__ == "__main__":
+    main()